@@ -33,7 +33,7 @@ ExternalProject_Add(
         CONFIGURE_COMMAND ""
         BUILD_IN_SOURCE 1
         BUILD_COMMAND $(MAKE)
-        INSTALL_COMMAND mkdir -p ${LZ4_INSTALL_DIR}/lib/ COMMAND cp ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/liblz4.a ${LZ4_INSTALL_DIR}/lib/ COMMAND cp -r ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/lz4.h ${LZ4_INSTALL_DIR}/ COMMAND cp -r ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/lz4hc.h ${LZ4_INSTALL_DIR}
+        INSTALL_COMMAND mkdir -p ${LZ4_INSTALL_DIR}/lib/ COMMAND cp ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/liblz4.a ${LZ4_INSTALL_DIR}/lib/ COMMAND mkdir -p ${LZ4_INSTALL_DIR}/include/ COMMAND cp -r ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/lz4.h ${LZ4_INSTALL_DIR}/include/ COMMAND cp -r ${LZ4_SOURCES_DIR}/src/extern_lz4/lib/lz4hc.h ${LZ4_INSTALL_DIR}/include/
 )
 
 ADD_LIBRARY(lz4 STATIC IMPORTED GLOBAL)
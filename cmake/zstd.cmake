@@ -33,7 +33,7 @@ ExternalProject_Add(
         CONFIGURE_COMMAND ""
         BUILD_IN_SOURCE 1
         BUILD_COMMAND $(MAKE)
-        INSTALL_COMMAND mkdir -p ${ZSTD_INSTALL_DIR}/lib/ COMMAND cp ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/libzstd.a ${ZSTD_INSTALL_DIR}/lib/ COMMAND cp -r ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/zstd.h ${ZSTD_INSTALL_DIR}/ COMMAND cp -r ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/zdict.h ${ZSTD_INSTALL_DIR}
+        INSTALL_COMMAND mkdir -p ${ZSTD_INSTALL_DIR}/lib/ COMMAND cp ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/libzstd.a ${ZSTD_INSTALL_DIR}/lib/ COMMAND mkdir -p ${ZSTD_INSTALL_DIR}/include/ COMMAND cp -r ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/zstd.h ${ZSTD_INSTALL_DIR}/include/ COMMAND cp -r ${ZSTD_SOURCES_DIR}/src/extern_zstd/lib/zdict.h ${ZSTD_INSTALL_DIR}/include/
 )
 
 ADD_LIBRARY(zstd STATIC IMPORTED GLOBAL)
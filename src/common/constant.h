@@ -124,6 +124,9 @@ class Constant {
 
   static const int kRocksdbBackgroundThreadNumDefault = 16;
   static const int kStatsDumpPeriodSecDefault = 600;
+  // memtable budget of WriteBufferManager, ratio of the shared block cache
+  static constexpr double kRocksdbWriteBufferRatioDefault = 0.25;
+  static constexpr int kRocksdbBlockCacheNumShardBitsDefault = 6;
 
   // scan config
   inline static const std::string kStoreScan = "store.scan";
@@ -199,12 +202,14 @@ class Constant {
   static const int32_t kRemoveWatchIntervalS = 60;
   static const int32_t kLeaseIntervalS = 60;
   static const int32_t kCompactionIntervalS = 300;
+  static const int32_t kBalanceScheduleIntervalS = 60;
   static const int32_t kScrubVectorIndexIntervalS = 60;
   static const int32_t kApproximateSizeMetricsCollectIntervalS = 50;
   static const int32_t kStoreMetricsCollectIntervalS = 30;
   static const int32_t kRegionMetricsCollectIntervalS = 300;
   static const int32_t kDefaultSplitCheckIntervalS = 120;
   static const int32_t kRaftSnapshotIntervalS = 120;
+  static const int32_t kRocksRangeGcIntervalS = 60;
 
   // raft snapshot
   inline static const std::string kRaftSnapshotRegionMetaFileName = "region_meta";
@@ -22,6 +22,7 @@
 
 #include "brpc/controller.h"
 #include "common/synchronization.h"
+#include "common/tracker.h"
 #include "proto/common.pb.h"
 #include "proto/store.pb.h"
 
@@ -124,6 +125,10 @@ class Context {
   WriteCbFunc WriteCb() { return write_cb_; }
   void SetWriteCb(WriteCbFunc write_cb) { write_cb_ = write_cb; }
 
+  // Only sampled request has tracker.
+  TrackerPtr Tracker() { return tracker_; }
+  void SetTracker(TrackerPtr tracker) { tracker_ = tracker; }
+
  private:
   // brpc framework free resource
   brpc::Controller* cntl_{nullptr};
@@ -154,6 +159,9 @@ class Context {
 
   // The request_id is set by the client, use this id to trace the request.
   int64_t request_id_{0};
+
+  // Trace the stage time of request.
+  TrackerPtr tracker_{nullptr};
 };
 
 using ContextPtr = std::shared_ptr<Context>;
@@ -0,0 +1,424 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/file_transfer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "brpc/controller.h"
+#include "butil/crc32c.h"
+#include "butil/fd_guard.h"
+#include "butil/time.h"
+#include "bvar/bvar.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "common/service_access.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "proto/error.pb.h"
+#include "proto/file_service.pb.h"
+
+namespace dingodb {
+
+DEFINE_int64(file_stream_chunk_size, 1024 * 1024, "file stream chunk size");
+DEFINE_int64(file_stream_max_chunk_size, 16 * 1024 * 1024, "file stream max chunk size of sender");
+DEFINE_int64(file_stream_max_buf_size, 64 * 1024 * 1024, "file stream max unacknowledged bytes of sender");
+DEFINE_int32(file_stream_idle_timeout_ms, 30000, "file stream idle timeout");
+DEFINE_int32(file_stream_write_timeout_ms, 30000, "file stream wait writable timeout");
+DEFINE_int32(file_stream_max_retry, 5, "file stream max retry times when transfer broken");
+DEFINE_int32(file_stream_parallel_num, 4, "file stream parallel download file num");
+
+static bvar::Adder<int64_t> g_file_stream_send_bytes("dingo_file_stream_send_bytes");
+static bvar::Adder<int64_t> g_file_stream_recv_bytes("dingo_file_stream_recv_bytes");
+static bvar::Adder<int64_t> g_file_stream_checksum_error("dingo_file_stream_checksum_error");
+static bvar::Adder<int64_t> g_file_stream_resume_count("dingo_file_stream_resume_count");
+
+void FileChunkHeader::EncodeTo(butil::IOBuf& buf) const {
+  char header[kEncodeSize];
+  memcpy(header, &offset, sizeof(offset));
+  memcpy(header + 8, &size, sizeof(size));
+  memcpy(header + 12, &checksum, sizeof(checksum));
+  header[16] = eof ? 1 : 0;
+
+  buf.append(header, kEncodeSize);
+}
+
+bool FileChunkHeader::DecodeFrom(butil::IOBuf& buf) {
+  if (buf.size() < kEncodeSize) {
+    return false;
+  }
+
+  char header[kEncodeSize];
+  buf.cutn(header, kEncodeSize);
+  memcpy(&offset, header, sizeof(offset));
+  memcpy(&size, header + 8, sizeof(size));
+  memcpy(&checksum, header + 12, sizeof(checksum));
+  eof = header[16] != 0;
+
+  return true;
+}
+
+uint32_t FileChunkHeader::Checksum(const butil::IOBuf& buf) {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < buf.backing_block_num(); ++i) {
+    auto block = buf.backing_block(i);
+    crc = butil::crc32c::Extend(crc, block.data(), block.size());
+  }
+
+  return crc;
+}
+
+// Sender close the stream only on idle timeout, normally receiver close it.
+class FileStreamSenderHandler : public brpc::StreamInputHandler {
+ public:
+  static FileStreamSenderHandler& GetInstance() {
+    static FileStreamSenderHandler instance;
+    return instance;
+  }
+
+  int on_received_messages(brpc::StreamId, butil::IOBuf* const[], size_t) override { return 0; }
+  void on_idle_timeout(brpc::StreamId id) override {
+    DINGO_LOG(WARNING) << fmt::format("[file.stream][stream({})] sender idle timeout, close stream.", id);
+    brpc::StreamClose(id);
+  }
+  void on_closed(brpc::StreamId) override {}
+};
+
+brpc::StreamOptions FileStreamSender::StreamOptions() {
+  brpc::StreamOptions options;
+  options.handler = &FileStreamSenderHandler::GetInstance();
+  options.max_buf_size = FLAGS_file_stream_max_buf_size;
+  options.idle_timeout_ms = FLAGS_file_stream_idle_timeout_ms;
+
+  return options;
+}
+
+static int WriteStream(brpc::StreamId stream_id, const butil::IOBuf& message) {
+  for (;;) {
+    int ret = brpc::StreamWrite(stream_id, message);
+    if (ret == 0) {
+      return 0;
+    }
+    if (ret != EAGAIN) {
+      return ret;
+    }
+
+    // Window is full, wait receiver consume.
+    timespec due_time = butil::milliseconds_from_now(FLAGS_file_stream_write_timeout_ms);
+    ret = brpc::StreamWait(stream_id, &due_time);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+}
+
+static void SendFile(brpc::StreamId stream_id, int raw_fd, const std::string& filepath, int64_t offset,
+                     int64_t chunk_size) {
+  int64_t start_time = butil::gettimeofday_ms();
+
+  butil::fd_guard fd(raw_fd);
+
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < offset) {
+    DINGO_LOG(ERROR) << fmt::format("[file.stream][stream({})] stat file {} failed or invalid offset {}", stream_id,
+                                    filepath, offset);
+    brpc::StreamClose(stream_id);
+    return;
+  }
+  const int64_t file_size = file_stat.st_size;
+
+  int64_t pos = offset;
+  for (;;) {
+    const int64_t read_size = std::min(chunk_size, file_size - pos);
+
+    butil::IOPortal data;
+    while (static_cast<int64_t>(data.size()) < read_size) {
+      ssize_t nread = data.pappend_from_file_descriptor(fd, pos + data.size(), read_size - data.size());
+      if (nread <= 0) {
+        DINGO_LOG(ERROR) << fmt::format("[file.stream][stream({})] read file {} offset {} failed, error: {}",
+                                        stream_id, filepath, pos + data.size(), berror());
+        brpc::StreamClose(stream_id);
+        return;
+      }
+    }
+
+    FileChunkHeader header;
+    header.offset = pos;
+    header.size = data.size();
+    header.checksum = FileChunkHeader::Checksum(data);
+    header.eof = (pos + read_size >= file_size);
+
+    butil::IOBuf message;
+    header.EncodeTo(message);
+    message.append(data);
+
+    int ret = WriteStream(stream_id, message);
+    if (ret != 0) {
+      DINGO_LOG(WARNING) << fmt::format("[file.stream][stream({})] write stream failed, file {} offset {} error: {}",
+                                        stream_id, filepath, pos, berror(ret));
+      brpc::StreamClose(stream_id);
+      return;
+    }
+
+    pos += read_size;
+    g_file_stream_send_bytes << read_size;
+
+    if (header.eof) {
+      break;
+    }
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[file.stream][stream({})] send file {} finish, offset({}-{}) elapsed time {}ms",
+                                 stream_id, filepath, offset, file_size, butil::gettimeofday_ms() - start_time);
+}
+
+bool FileStreamSender::AsyncSend(brpc::StreamId stream_id, const std::string& filepath, int64_t offset,
+                                 int64_t chunk_size) {
+  if (chunk_size <= 0) {
+    chunk_size = FLAGS_file_stream_chunk_size;
+  }
+
+  // Open file in advance, so the file content is still readable even if the snapshot is deleted.
+  int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    DINGO_LOG(ERROR) << fmt::format("[file.stream][stream({})] open file {} failed, error: {}", stream_id, filepath,
+                                    berror());
+    brpc::StreamClose(stream_id);
+    return false;
+  }
+
+  Bthread bth(&BTHREAD_ATTR_NORMAL);
+  bth.Run(
+      [stream_id, fd, filepath, offset, chunk_size]() { SendFile(stream_id, fd, filepath, offset, chunk_size); });
+
+  return true;
+}
+
+int FileStreamReceiver::on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (!status_.ok() || IsEof()) {
+      break;
+    }
+
+    if (HandleChunk(messages[i]) != 0) {
+      DINGO_LOG(ERROR) << fmt::format("[file.stream][stream({})] handle chunk failed, error: {}", id,
+                                      status_.error_str());
+      brpc::StreamClose(id);
+      return 0;
+    }
+
+    if (IsEof()) {
+      brpc::StreamClose(id);
+    }
+  }
+
+  return 0;
+}
+
+int FileStreamReceiver::HandleChunk(butil::IOBuf* message) {
+  FileChunkHeader header;
+  if (!header.DecodeFrom(*message)) {
+    status_ = butil::Status(pb::error::EFILE_STREAM, "Decode chunk header failed");
+    return -1;
+  }
+
+  int64_t offset = VerifiedOffset();
+  if (header.offset != offset || message->size() != header.size) {
+    status_ = butil::Status(pb::error::EFILE_STREAM, "Chunk not match, expect offset %ld actual offset %ld size %u/%lu",
+                            offset, header.offset, header.size, message->size());
+    return -1;
+  }
+
+  if (FileChunkHeader::Checksum(*message) != header.checksum) {
+    g_file_stream_checksum_error << 1;
+    status_ = butil::Status(pb::error::EFILE_CHECKSUM, "Chunk checksum not match, offset %ld", header.offset);
+    return -1;
+  }
+
+  while (!message->empty()) {
+    ssize_t nwrite = message->pcut_into_file_descriptor(fd_, offset);
+    if (nwrite < 0) {
+      status_ = butil::Status(pb::error::EINTERNAL, "Write file failed, offset %ld error: %s", offset, berror());
+      return -1;
+    }
+    offset += nwrite;
+  }
+
+  g_file_stream_recv_bytes << header.size;
+  verified_offset_.store(offset, std::memory_order_release);
+  if (header.eof) {
+    is_eof_.store(true, std::memory_order_release);
+  }
+
+  return 0;
+}
+
+void FileStreamReceiver::on_idle_timeout(brpc::StreamId id) {
+  DINGO_LOG(WARNING) << fmt::format("[file.stream][stream({})] receiver idle timeout, verified offset {}", id,
+                                    VerifiedOffset());
+  if (status_.ok()) {
+    status_ = butil::Status(pb::error::EFILE_STREAM, "Stream idle timeout");
+  }
+  brpc::StreamClose(id);
+}
+
+void FileStreamReceiver::on_closed(brpc::StreamId) { cond_.DecreaseSignal(); }
+
+butil::Status FileTransfer::DownloadFileOnce(const butil::EndPoint& endpoint, int64_t reader_id,
+                                             const std::string& filename, int fd, int64_t& offset) {
+  auto channel = ChannelPool::GetInstance().GetChannel(endpoint);
+  if (channel == nullptr) {
+    return butil::Status(pb::error::EINTERNAL, "Get channel failed, endpoint: %s",
+                         Helper::EndPointToStr(endpoint).c_str());
+  }
+
+  // Drop data after the last verified offset.
+  if (::ftruncate(fd, offset) != 0) {
+    return butil::Status(pb::error::EINTERNAL, "Truncate file %s failed, error: %s", filename.c_str(), berror());
+  }
+
+  FileStreamReceiver receiver(fd, offset);
+
+  brpc::Controller cntl;
+  cntl.set_timeout_ms(6000);
+
+  brpc::StreamOptions options;
+  options.handler = &receiver;
+  options.idle_timeout_ms = FLAGS_file_stream_idle_timeout_ms;
+  brpc::StreamId stream_id;
+  if (brpc::StreamCreate(&stream_id, cntl, &options) != 0) {
+    return butil::Status(pb::error::EFILE_STREAM, "Create stream failed");
+  }
+
+  pb::fileservice::GetFileStreamRequest request;
+  request.set_reader_id(reader_id);
+  request.set_filename(filename);
+  request.set_offset(offset);
+  request.set_chunk_size(FLAGS_file_stream_chunk_size);
+
+  pb::fileservice::GetFileStreamResponse response;
+  pb::fileservice::FileService_Stub stub(channel.get());
+  stub.GetFileStream(&cntl, &request, &response, nullptr);
+  if (cntl.Failed()) {
+    brpc::StreamClose(stream_id);
+    receiver.Wait();
+    // the peer of old version has no GetFileStream, caller should fall back to GetFile
+    if (cntl.ErrorCode() == brpc::ENOMETHOD) {
+      return butil::Status(pb::error::ENOT_SUPPORT, "Peer %s not support GetFileStream, error: %s",
+                           Helper::EndPointToStr(endpoint).c_str(), cntl.ErrorText().c_str());
+    }
+    return butil::Status(cntl.ErrorCode() == pb::error::EFILE_NOT_FOUND_READER ? pb::error::EFILE_NOT_FOUND_READER
+                                                                               : pb::error::EFILE_STREAM,
+                         "Send GetFileStream failed, endpoint %s error: %s", Helper::EndPointToStr(endpoint).c_str(),
+                         cntl.ErrorText().c_str());
+  }
+
+  receiver.Wait();
+  offset = receiver.VerifiedOffset();
+
+  if (!receiver.Status().ok()) {
+    return receiver.Status();
+  }
+  if (!receiver.IsEof()) {
+    return butil::Status(pb::error::EFILE_STREAM, "Stream closed before eof, offset %ld/%ld", offset,
+                         response.file_size());
+  }
+
+  return butil::Status();
+}
+
+butil::Status FileTransfer::DownloadFile(const butil::EndPoint& endpoint, int64_t reader_id,
+                                         const std::string& filename, const std::string& filepath) {
+  int64_t start_time = butil::gettimeofday_ms();
+
+  butil::fd_guard fd(::open(filepath.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644));
+  if (fd < 0) {
+    return butil::Status(pb::error::EINTERNAL, "Open file %s failed, error: %s", filepath.c_str(), berror());
+  }
+
+  int64_t offset = 0;
+  butil::Status status;
+  for (int retry = 0; retry <= FLAGS_file_stream_max_retry; ++retry) {
+    if (retry > 0) {
+      g_file_stream_resume_count << 1;
+      bthread_usleep(std::min(retry * 200, 2000) * 1000L);
+    }
+
+    status = DownloadFileOnce(endpoint, reader_id, filename, fd, offset);
+    if (status.ok()) {
+      if (::fsync(fd) != 0) {
+        return butil::Status(pb::error::EINTERNAL, "Sync file %s failed, error: %s", filepath.c_str(), berror());
+      }
+
+      DINGO_LOG(INFO) << fmt::format("[file.stream] download file {} finish, size {} retry {} elapsed time {}ms",
+                                     filepath, offset, retry, butil::gettimeofday_ms() - start_time);
+      return status;
+    }
+
+    if (status.error_code() == pb::error::EFILE_NOT_FOUND_READER || status.error_code() == pb::error::ENOT_SUPPORT) {
+      break;
+    }
+
+    DINGO_LOG(WARNING) << fmt::format("[file.stream] download file {} broken, resume from offset {} retry {} error: {}",
+                                      filepath, offset, retry, status.error_str());
+  }
+
+  return status;
+}
+
+butil::Status FileTransfer::DownloadFiles(const butil::EndPoint& endpoint, int64_t reader_id,
+                                          const std::vector<std::string>& filenames, const std::string& dirpath) {
+  BthreadCond cond;
+  bthread_mutex_t mutex;
+  bthread_mutex_init(&mutex, nullptr);
+  butil::Status result;
+  std::atomic<bool> is_failed{false};
+
+  for (const auto& filename : filenames) {
+    if (is_failed.load(std::memory_order_relaxed)) {
+      break;
+    }
+
+    cond.IncreaseWait(std::max(1, FLAGS_file_stream_parallel_num));
+
+    Bthread bth(&BTHREAD_ATTR_NORMAL);
+    bth.Run([&, filename]() {
+      auto status = DownloadFile(endpoint, reader_id, filename, fmt::format("{}/{}", dirpath, filename));
+      if (!status.ok()) {
+        BAIDU_SCOPED_LOCK(mutex);
+        if (result.ok()) {
+          result = status;
+        }
+        is_failed.store(true, std::memory_order_relaxed);
+      }
+
+      cond.DecreaseSignal();
+    });
+  }
+
+  cond.Wait();
+  bthread_mutex_destroy(&mutex);
+
+  return result;
+}
+
+}  // namespace dingodb
@@ -0,0 +1,108 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COMMON_FILE_TRANSFER_H_
+#define DINGODB_COMMON_FILE_TRANSFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "brpc/stream.h"
+#include "butil/endpoint.h"
+#include "butil/iobuf.h"
+#include "butil/status.h"
+#include "common/synchronization.h"
+#include "gflags/gflags.h"
+
+namespace dingodb {
+
+DECLARE_int64(file_stream_max_chunk_size);
+
+// Every stream message is one file chunk, format:
+// | offset(8 bytes) | size(4 bytes) | crc32c(4 bytes) | eof(1 byte) | data(size bytes) |
+struct FileChunkHeader {
+  static constexpr size_t kEncodeSize = 17;
+
+  int64_t offset{0};
+  uint32_t size{0};
+  uint32_t checksum{0};
+  bool eof{false};
+
+  void EncodeTo(butil::IOBuf& buf) const;
+  // Cut header from the front of buf.
+  bool DecodeFrom(butil::IOBuf& buf);
+
+  static uint32_t Checksum(const butil::IOBuf& buf);
+};
+
+// Push file chunks to stream at the server side.
+class FileStreamSender {
+ public:
+  // Accept stream options of sender.
+  static brpc::StreamOptions StreamOptions();
+
+  // Run in background, read file from offset and write to stream chunk by chunk.
+  // The stream is closed by receiver after it got the eof chunk.
+  static bool AsyncSend(brpc::StreamId stream_id, const std::string& filepath, int64_t offset, int64_t chunk_size);
+};
+
+// Receive file chunks from stream at the client side, every chunk is verified by checksum before written.
+class FileStreamReceiver : public brpc::StreamInputHandler {
+ public:
+  FileStreamReceiver(int fd, int64_t offset) : fd_(fd), verified_offset_(offset), cond_(1) {}
+  ~FileStreamReceiver() override = default;
+
+  int on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) override;
+  void on_idle_timeout(brpc::StreamId id) override;
+  void on_closed(brpc::StreamId id) override;
+
+  // Wait until stream closed.
+  void Wait() { cond_.Wait(); }
+
+  butil::Status Status() const { return status_; }
+  int64_t VerifiedOffset() const { return verified_offset_.load(std::memory_order_acquire); }
+  bool IsEof() const { return is_eof_.load(std::memory_order_acquire); }
+
+ private:
+  int HandleChunk(butil::IOBuf* message);
+
+  int fd_;
+  // Data before this offset has been verified and written to file.
+  std::atomic<int64_t> verified_offset_;
+  std::atomic<bool> is_eof_{false};
+  butil::Status status_;
+  BthreadCond cond_;
+};
+
+class FileTransfer {
+ public:
+  // Download one file by stream, when stream break resume from the last verified offset.
+  static butil::Status DownloadFile(const butil::EndPoint& endpoint, int64_t reader_id, const std::string& filename,
+                                    const std::string& filepath);
+
+  // Download multiple files of one reader in parallel.
+  static butil::Status DownloadFiles(const butil::EndPoint& endpoint, int64_t reader_id,
+                                     const std::vector<std::string>& filenames, const std::string& dirpath);
+
+ private:
+  static butil::Status DownloadFileOnce(const butil::EndPoint& endpoint, int64_t reader_id,
+                                        const std::string& filename, int fd, int64_t& offset);
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COMMON_FILE_TRANSFER_H_
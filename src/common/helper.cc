@@ -644,6 +644,12 @@ void Helper::SetPbMessageError(butil::Status status, google::protobuf::Message*
 }
 
 void Helper::SetPbMessageResponseInfo(google::protobuf::Message* message, int64_t elapsed_time_ns) {
+  pb::common::TimeInfo time_info;
+  time_info.set_total_rpc_time_ns(elapsed_time_ns);
+  SetPbMessageResponseInfo(message, time_info);
+}
+
+void Helper::SetPbMessageResponseInfo(google::protobuf::Message* message, const pb::common::TimeInfo& time_info) {
   if (BAIDU_UNLIKELY(message == nullptr)) {
     return;
   }
@@ -663,7 +669,7 @@ void Helper::SetPbMessageResponseInfo(google::protobuf::Message* message, int64_
   }
   pb::common::ResponseInfo* response_info =
       dynamic_cast<pb::common::ResponseInfo*>(reflection->MutableMessage(message, response_info_field));
-  response_info->mutable_time_info()->set_total_rpc_time_ns(elapsed_time_ns);
+  *response_info->mutable_time_info() = time_info;
 }
 
 std::string Helper::MessageToJsonString(const google::protobuf::Message& message) {
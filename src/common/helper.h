@@ -181,6 +181,7 @@ class Helper {
 
   static void SetPbMessageError(butil::Status status, google::protobuf::Message* message);
   static void SetPbMessageResponseInfo(google::protobuf::Message* message, int64_t elapsed_time_ns);
+  static void SetPbMessageResponseInfo(google::protobuf::Message* message, const pb::common::TimeInfo& time_info);
 
   template <typename T>
   static void SetPbMessageErrorLeader(const pb::node::NodeInfo& node_info, T* message) {
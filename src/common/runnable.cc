@@ -18,8 +18,10 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 #include "butil/compiler_specific.h"
+#include "butil/time.h"
 #include "client/coordinator_client_function.h"
 #include "common/helper.h"
 #include "common/logging.h"
@@ -43,6 +45,10 @@ int ExecuteRoutine(void* meta, bthread::TaskIterator<TaskRunnablePtr>& iter) {
       continue;
     }
 
+    if (worker != nullptr) {
+      worker->Nodify(Worker::EventType::kStartTask, *iter);
+    }
+
     int64_t start_time = Helper::TimestampMs();
     (*iter)->Run();
     DINGO_LOG(DEBUG) << fmt::format("[execqueue][type({})] run task elapsed time {}(ms).", (*iter)->Type(),
@@ -50,7 +56,7 @@ int ExecuteRoutine(void* meta, bthread::TaskIterator<TaskRunnablePtr>& iter) {
 
     if (worker != nullptr) {
       worker->DecPendingTaskCount();
-      worker->Nodify(Worker::EventType::kFinishTask);
+      worker->Nodify(Worker::EventType::kFinishTask, *iter);
     }
   }
 
@@ -95,6 +101,7 @@ bool Worker::Execute(TaskRunnablePtr task) {
     return false;
   }
 
+  task->SetEnqueueTimeUs(butil::cpuwide_time_us());
   if (bthread::execution_queue_execute(queue_id_, task) != 0) {
     DINGO_LOG(ERROR) << fmt::format("[execqueue][type({})] worker execution queue execute failed", task->Type());
     return false;
@@ -103,7 +110,7 @@ bool Worker::Execute(TaskRunnablePtr task) {
   IncPendingTaskCount();
   IncTotalTaskCount();
 
-  Nodify(EventType::kAddTask);
+  Nodify(EventType::kAddTask, task);
 
   return true;
 }
@@ -115,25 +122,56 @@ uint64_t Worker::PendingTaskCount() { return pending_task_count_.load(std::memor
 void Worker::IncPendingTaskCount() { pending_task_count_.fetch_add(1, std::memory_order_relaxed); }
 void Worker::DecPendingTaskCount() { pending_task_count_.fetch_sub(1, std::memory_order_relaxed); }
 
-void Worker::Nodify(EventType type) {
+void Worker::Nodify(EventType type, TaskRunnablePtr task) {
   if (notify_func_ != nullptr) {
-    notify_func_(type);
+    notify_func_(type, task);
   }
 }
 
-WorkerSet::WorkerSet(std::string name, uint32_t worker_num, int64_t max_pending_task_count)
+WorkerSet::WorkerSet(std::string name, uint32_t worker_num, int64_t max_pending_task_count, bool use_work_stealing)
     : name_(name),
       worker_num_(worker_num),
       max_pending_task_count_(max_pending_task_count),
       active_worker_id_(0),
+      use_work_stealing_(use_work_stealing),
       total_task_count_metrics_(fmt::format("dingo_{}_total_task_count", name)),
-      pending_task_count_metrics_(fmt::format("dingo_{}_pending_task_count", name)) {}
+      pending_task_count_metrics_(fmt::format("dingo_{}_pending_task_count", name)) {
+  bthread_mutex_init(&idle_mutex_, nullptr);
+  bthread_cond_init(&idle_cond_, nullptr);
+  bthread_mutex_init(&region_mutex_, nullptr);
+  bthread_mutex_init(&queue_wait_metrics_mutex_, nullptr);
+}
 
-WorkerSet::~WorkerSet() = default;
+WorkerSet::~WorkerSet() {
+  bthread_mutex_destroy(&queue_wait_metrics_mutex_);
+  bthread_mutex_destroy(&region_mutex_);
+  bthread_cond_destroy(&idle_cond_);
+  bthread_mutex_destroy(&idle_mutex_);
+}
 
 bool WorkerSet::Init() {
+  if (use_work_stealing_) {
+    for (int i = 0; i < worker_num_; ++i) {
+      task_deques_.push_back(std::make_unique<TaskDeque>());
+    }
+
+    for (int i = 0; i < worker_num_; ++i) {
+      auto* arg = new std::pair<WorkerSet*, uint32_t>(this, i);
+      bthread_t tid;
+      if (bthread_start_background(&tid, &BTHREAD_ATTR_NORMAL, StealingWorkerRoutine, arg) != 0) {
+        DINGO_LOG(ERROR) << fmt::format("[execqueue][{}] start work stealing worker failed", name_);
+        delete arg;
+        return false;
+      }
+      worker_bthreads_.push_back(tid);
+    }
+
+    return true;
+  }
+
   for (int i = 0; i < worker_num_; ++i) {
-    auto worker = Worker::New([this](Worker::EventType type) { WatchWorker(type); });
+    auto worker =
+        Worker::New([this](Worker::EventType type, TaskRunnablePtr task) { WatchWorker(type, std::move(task)); });
     if (!worker->Init()) {
       return false;
     }
@@ -144,19 +182,52 @@ bool WorkerSet::Init() {
 }
 
 void WorkerSet::Destroy() {
+  if (use_work_stealing_) {
+    is_stopped_.store(true);
+    bthread_mutex_lock(&idle_mutex_);
+    bthread_cond_broadcast(&idle_cond_);
+    bthread_mutex_unlock(&idle_mutex_);
+
+    for (auto tid : worker_bthreads_) {
+      bthread_join(tid, nullptr);
+    }
+    worker_bthreads_.clear();
+    return;
+  }
+
   for (const auto& worker : workers_) {
     worker->Destroy();
   }
 }
 
-bool WorkerSet::ExecuteRR(TaskRunnablePtr task) {
+bool WorkerSet::IsExceedPendingLimit() {
   if (BAIDU_UNLIKELY(max_pending_task_count_ > 0 &&
                      pending_task_count_.load(std::memory_order_relaxed) > max_pending_task_count_)) {
     DINGO_LOG(WARNING) << fmt::format("[execqueue] exceed max pending task limit, {}/{}",
                                       pending_task_count_.load(std::memory_order_relaxed), max_pending_task_count_);
+    return true;
+  }
+
+  return false;
+}
+
+bool WorkerSet::ExecuteRR(TaskRunnablePtr task) {
+  if (IsExceedPendingLimit()) {
     return false;
   }
 
+  if (use_work_stealing_) {
+    if (is_stopped_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    task->SetEnqueueTimeUs(butil::cpuwide_time_us());
+    IncPendingTaskCount();
+    IncTotalTaskCount();
+    PushTask(active_worker_id_.fetch_add(1) % worker_num_, task);
+    return true;
+  }
+
   auto ret = workers_[active_worker_id_.fetch_add(1) % worker_num_]->Execute(task);
   if (ret) {
     IncPendingTaskCount();
@@ -166,14 +237,57 @@ bool WorkerSet::ExecuteRR(TaskRunnablePtr task) {
   return ret;
 }
 
+// Run the inner task of region in work stealing mode.
+class RegionTask : public TaskRunnable {
+ public:
+  using Handler = std::function<void(void)>;
+  RegionTask(TaskRunnablePtr task, Handler handle) : task_(task), handle_(handle) {
+    SetEnqueueTimeUs(task->EnqueueTimeUs());
+  }
+  ~RegionTask() override = default;
+
+  std::string Type() override { return task_->Type(); }
+
+  void Run() override { handle_(); }
+
+ private:
+  TaskRunnablePtr task_;
+  Handler handle_;
+};
+
 bool WorkerSet::ExecuteHashByRegionId(int64_t region_id, TaskRunnablePtr task) {
-  if (BAIDU_UNLIKELY(max_pending_task_count_ > 0 &&
-                     pending_task_count_.load(std::memory_order_relaxed) > max_pending_task_count_)) {
-    DINGO_LOG(WARNING) << fmt::format("[execqueue] exceed max pending task limit, {}/{}",
-                                      pending_task_count_.load(std::memory_order_relaxed), max_pending_task_count_);
+  if (IsExceedPendingLimit()) {
     return false;
   }
 
+  if (use_work_stealing_) {
+    if (is_stopped_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    task->SetEnqueueTimeUs(butil::cpuwide_time_us());
+    IncPendingTaskCount();
+    IncTotalTaskCount();
+
+    bool need_schedule = false;
+    {
+      BAIDU_SCOPED_LOCK(region_mutex_);
+      auto it = region_tasks_.find(region_id);
+      if (it == region_tasks_.end()) {
+        region_tasks_.emplace(region_id, std::deque<TaskRunnablePtr>());
+        need_schedule = true;
+      } else {
+        it->second.push_back(task);
+      }
+    }
+
+    if (need_schedule) {
+      PushTask(region_id % worker_num_,
+               std::make_shared<RegionTask>(task, [this, region_id, task]() { RunRegionTask(region_id, task); }));
+    }
+    return true;
+  }
+
   auto ret = workers_[region_id % worker_num_]->Execute(task);
   if (ret) {
     IncPendingTaskCount();
@@ -183,12 +297,123 @@ bool WorkerSet::ExecuteHashByRegionId(int64_t region_id, TaskRunnablePtr task) {
   return ret;
 }
 
-void WorkerSet::WatchWorker(Worker::EventType type) {
-  if (type == Worker::EventType::kFinishTask) {
+void WorkerSet::RunRegionTask(int64_t region_id, TaskRunnablePtr task) {
+  task->Run();
+
+  TaskRunnablePtr next_task;
+  {
+    BAIDU_SCOPED_LOCK(region_mutex_);
+    auto it = region_tasks_.find(region_id);
+    if (it->second.empty()) {
+      region_tasks_.erase(it);
+      return;
+    }
+    next_task = it->second.front();
+    it->second.pop_front();
+  }
+
+  PushTask(region_id % worker_num_, std::make_shared<RegionTask>(next_task, [this, region_id, next_task]() {
+             RunRegionTask(region_id, next_task);
+           }));
+}
+
+void WorkerSet::PushTask(uint32_t worker_index, TaskRunnablePtr task) {
+  auto& task_deque = task_deques_[worker_index];
+  {
+    BAIDU_SCOPED_LOCK(task_deque->mutex);
+    task_deque->tasks.push_back(task);
+  }
+  queued_task_count_.fetch_add(1);
+
+  bthread_mutex_lock(&idle_mutex_);
+  bthread_cond_signal(&idle_cond_);
+  bthread_mutex_unlock(&idle_mutex_);
+}
+
+TaskRunnablePtr WorkerSet::PopOrStealTask(uint32_t worker_index) {
+  for (uint32_t i = 0; i < worker_num_; ++i) {
+    auto& task_deque = task_deques_[(worker_index + i) % worker_num_];
+    BAIDU_SCOPED_LOCK(task_deque->mutex);
+    if (task_deque->tasks.empty()) {
+      continue;
+    }
+
+    TaskRunnablePtr task;
+    if (i == 0) {
+      task = task_deque->tasks.front();
+      task_deque->tasks.pop_front();
+    } else {
+      // steal from the other end, so less contention with the owner
+      task = task_deque->tasks.back();
+      task_deque->tasks.pop_back();
+    }
+    queued_task_count_.fetch_sub(1);
+    return task;
+  }
+
+  return nullptr;
+}
+
+void* WorkerSet::StealingWorkerRoutine(void* arg) {
+  std::unique_ptr<std::pair<WorkerSet*, uint32_t>> param(static_cast<std::pair<WorkerSet*, uint32_t>*>(arg));
+  param->first->StealingWorkerRun(param->second);
+  return nullptr;
+}
+
+void WorkerSet::StealingWorkerRun(uint32_t worker_index) {
+  for (;;) {
+    auto task = PopOrStealTask(worker_index);
+    if (task == nullptr) {
+      bthread_mutex_lock(&idle_mutex_);
+      while (queued_task_count_.load() == 0 && !is_stopped_.load()) {
+        bthread_cond_wait(&idle_cond_, &idle_mutex_);
+      }
+      bthread_mutex_unlock(&idle_mutex_);
+
+      // run out queued tasks before stop
+      if (is_stopped_.load() && queued_task_count_.load() == 0) {
+        break;
+      }
+      continue;
+    }
+
+    RecordQueueWaitTime(task);
+
+    int64_t start_time = Helper::TimestampMs();
+    task->Run();
+    DINGO_LOG(DEBUG) << fmt::format("[execqueue][type({})] run task elapsed time {}(ms).", task->Type(),
+                                    Helper::TimestampMs() - start_time);
+
     DecPendingTaskCount();
   }
 }
 
+void WorkerSet::WatchWorker(Worker::EventType type, TaskRunnablePtr task) {
+  if (type == Worker::EventType::kStartTask) {
+    RecordQueueWaitTime(task);
+  } else if (type == Worker::EventType::kFinishTask) {
+    DecPendingTaskCount();
+  }
+}
+
+void WorkerSet::RecordQueueWaitTime(TaskRunnablePtr task) {
+  if (task == nullptr || task->EnqueueTimeUs() == 0) {
+    return;
+  }
+
+  int64_t wait_time_us = butil::cpuwide_time_us() - task->EnqueueTimeUs();
+  auto type = task->Type();
+
+  BAIDU_SCOPED_LOCK(queue_wait_metrics_mutex_);
+  auto it = queue_wait_metrics_.find(type);
+  if (it == queue_wait_metrics_.end()) {
+    it = queue_wait_metrics_
+             .emplace(type, std::make_unique<bvar::LatencyRecorder>(fmt::format("dingo_{}_{}_queue_wait", name_, type)))
+             .first;
+  }
+  *(it->second) << wait_time_us;
+}
+
 uint64_t WorkerSet::TotalTaskCount() { return total_task_count_metrics_.get_value(); }
 
 void WorkerSet::IncTotalTaskCount() { total_task_count_metrics_ << 1; }
@@ -17,11 +17,17 @@
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "bthread/bthread.h"
 #include "bthread/execution_queue.h"
+#include "bvar/latency_recorder.h"
 #include "common/failpoint.h"
 #include "common/synchronization.h"
 
@@ -35,6 +41,13 @@ class TaskRunnable {
   virtual std::string Type() = 0;
 
   virtual void Run() = 0;
+
+  // Time of the task put into queue, for queue wait time metrics.
+  int64_t EnqueueTimeUs() const { return enqueue_time_us_; }
+  void SetEnqueueTimeUs(int64_t enqueue_time_us) { enqueue_time_us_ = enqueue_time_us; }
+
+ private:
+  int64_t enqueue_time_us_{0};
 };
 
 using TaskRunnablePtr = std::shared_ptr<TaskRunnable>;
@@ -47,8 +60,9 @@ class Worker {
   enum class EventType {
     kAddTask = 0,
     kFinishTask = 1,
+    kStartTask = 2,
   };
-  using NotifyFuncer = std::function<void(EventType)>;
+  using NotifyFuncer = std::function<void(EventType, TaskRunnablePtr)>;
 
   Worker(NotifyFuncer notify_func) : is_available_(false), notify_func_(notify_func) {}
   ~Worker() = default;
@@ -68,7 +82,7 @@ class Worker {
   void IncPendingTaskCount();
   void DecPendingTaskCount();
 
-  void Nodify(EventType type);
+  void Nodify(EventType type, TaskRunnablePtr task);
 
  private:
   // Execution queue is available.
@@ -85,13 +99,20 @@ class Worker {
 
 using WorkerPtr = std::shared_ptr<Worker>;
 
+// Run task worker set.
+// Default mode, every worker has its own execution queue, read task is assigned round-robin,
+// write task is assigned by region id hash.
+// Work stealing mode, every worker has its own task deque, idle worker steals task from the others,
+// so a slow task does not block the tasks queued behind it. Write tasks of one region are still
+// run one by one in submit order, by a per region task queue on top of the shared workers.
 class WorkerSet {
  public:
-  WorkerSet(std::string name, uint32_t worker_num, int64_t max_pending_task_count);
+  WorkerSet(std::string name, uint32_t worker_num, int64_t max_pending_task_count, bool use_work_stealing = false);
   ~WorkerSet();
 
-  static std::shared_ptr<WorkerSet> New(std::string name, uint32_t worker_num, uint32_t max_pending_task_count) {
-    return std::make_shared<WorkerSet>(name, worker_num, max_pending_task_count);
+  static std::shared_ptr<WorkerSet> New(std::string name, uint32_t worker_num, uint32_t max_pending_task_count,
+                                        bool use_work_stealing = false) {
+    return std::make_shared<WorkerSet>(name, worker_num, max_pending_task_count, use_work_stealing);
   }
 
   bool Init();
@@ -100,7 +121,7 @@ class WorkerSet {
   bool ExecuteRR(TaskRunnablePtr task);
   bool ExecuteHashByRegionId(int64_t region_id, TaskRunnablePtr task);
 
-  void WatchWorker(Worker::EventType type);
+  void WatchWorker(Worker::EventType type, TaskRunnablePtr task);
 
   uint64_t TotalTaskCount();
   void IncTotalTaskCount();
@@ -109,7 +130,31 @@ class WorkerSet {
   void IncPendingTaskCount();
   void DecPendingTaskCount();
 
+  bool UseWorkStealing() const { return use_work_stealing_; }
+
  private:
+  // task deque of work stealing worker
+  struct TaskDeque {
+    TaskDeque() { bthread_mutex_init(&mutex, nullptr); }
+    ~TaskDeque() { bthread_mutex_destroy(&mutex); }
+
+    bthread_mutex_t mutex;
+    std::deque<TaskRunnablePtr> tasks;
+  };
+
+  bool IsExceedPendingLimit();
+
+  // Work stealing mode.
+  void PushTask(uint32_t worker_index, TaskRunnablePtr task);
+  // Pop task from own deque front, or steal from the back of other deque.
+  TaskRunnablePtr PopOrStealTask(uint32_t worker_index);
+  static void* StealingWorkerRoutine(void* arg);
+  void StealingWorkerRun(uint32_t worker_index);
+  // Run the task of region, then schedule the next task queued on the region.
+  void RunRegionTask(int64_t region_id, TaskRunnablePtr task);
+
+  void RecordQueueWaitTime(TaskRunnablePtr task);
+
   const std::string name_;
   int64_t max_pending_task_count_;
   uint32_t worker_num_;
@@ -118,9 +163,25 @@ class WorkerSet {
 
   std::atomic<int64_t> pending_task_count_{0};
 
+  // Work stealing mode.
+  bool use_work_stealing_;
+  std::vector<std::unique_ptr<TaskDeque>> task_deques_;
+  std::vector<bthread_t> worker_bthreads_;
+  // task count in all deques
+  std::atomic<int64_t> queued_task_count_{0};
+  std::atomic<bool> is_stopped_{false};
+  bthread_mutex_t idle_mutex_;
+  bthread_cond_t idle_cond_;
+  // region id -> waiting tasks, a region exists means one of its task is scheduled to workers
+  bthread_mutex_t region_mutex_;
+  std::unordered_map<int64_t, std::deque<TaskRunnablePtr>> region_tasks_;
+
   // Metrics
   bvar::Adder<uint64_t> total_task_count_metrics_;
   bvar::Adder<int64_t> pending_task_count_metrics_;
+  // task type -> queue wait time(us)
+  bthread_mutex_t queue_wait_metrics_mutex_;
+  std::map<std::string, std::unique_ptr<bvar::LatencyRecorder>> queue_wait_metrics_;
 };
 
 using WorkerSetPtr = std::shared_ptr<WorkerSet>;
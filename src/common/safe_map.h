@@ -15,10 +15,17 @@
 #ifndef DINGODB_COMMON_SAFE_MAP_H_
 #define DINGODB_COMMON_SAFE_MAP_H_
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -1084,6 +1091,307 @@ class DingoSafeStdMap {
   TypeSafeMap safe_map;
 };
 
+// Implement a sharded ThreadSafeMap with immutable values
+// The values are stored as std::shared_ptr<const T_VALUE>, GetPtr() hands out the reference without copying value,
+// and Put() only swaps the pointer, so readers never wait for a whole map copy like DoublyBufferedData.
+// Keys are spread to SHARD_NUM shards, every shard is protected by a shared_mutex.
+// MultiPut()/MultiErase() lock all involved shards at once, so the batch is published at one time.
+// The return values of member functions are the same as DingoSafeMap.
+template <typename T_KEY, typename T_VALUE, size_t SHARD_NUM = 64>
+class DingoSafeShardedMap {
+ public:
+  using TypeValuePtr = std::shared_ptr<const T_VALUE>;
+  using TypeRawMap = butil::FlatMap<T_KEY, T_VALUE>;
+  using TypeShardMap = butil::FlatMap<T_KEY, TypeValuePtr>;
+
+  DingoSafeShardedMap() {
+    for (auto &shard : shards_) {
+      shard.map.init(kDefaultShardCapacity);
+    }
+  }
+  DingoSafeShardedMap(const DingoSafeShardedMap &) = delete;
+  ~DingoSafeShardedMap() = default;
+
+  void Init(int64_t capacity) { Resize(capacity); }
+  void Resize(int64_t capacity) {
+    size_t shard_capacity = std::max(static_cast<size_t>(capacity) / SHARD_NUM + 1, kDefaultShardCapacity);
+    for (auto &shard : shards_) {
+      std::unique_lock lock(shard.mutex);
+      shard.map.resize(shard_capacity);
+    }
+  }
+
+  // GetPtr
+  // get value reference by key, return nullptr if not exists
+  TypeValuePtr GetPtr(const T_KEY &key) const {
+    const auto &shard = GetShard(key);
+    std::shared_lock lock(shard.mutex);
+    const auto *value_ptr = shard.map.seek(key);
+    return value_ptr != nullptr ? *value_ptr : nullptr;
+  }
+
+  // Get
+  // get value by key
+  int Get(const T_KEY &key, T_VALUE &value) const {
+    auto value_ptr = GetPtr(key);
+    if (value_ptr == nullptr) {
+      return -1;
+    }
+
+    value = *value_ptr;
+    return 1;
+  }
+
+  // Get
+  // get value by key
+  T_VALUE Get(const T_KEY &key) const {
+    auto value_ptr = GetPtr(key);
+    return value_ptr != nullptr ? *value_ptr : T_VALUE();
+  }
+
+  // MultiGetPtr
+  // multi-get value reference by key, the value is nullptr if not exists
+  int MultiGetPtr(const std::vector<T_KEY> &keys, std::vector<TypeValuePtr> &values) const {
+    values.reserve(values.size() + keys.size());
+    for (const auto &key : keys) {
+      values.push_back(GetPtr(key));
+    }
+
+    return 1;
+  }
+
+  // multi-get value by key
+  int MultiGet(const std::vector<T_KEY> &keys, std::vector<T_VALUE> &values, std::vector<bool> &exists) const {
+    for (const auto &key : keys) {
+      auto value_ptr = GetPtr(key);
+      values.push_back(value_ptr != nullptr ? *value_ptr : T_VALUE());
+      exists.push_back(value_ptr != nullptr);
+    }
+
+    return 1;
+  }
+
+  // GetAllKeys
+  // get all keys of the map
+  int GetAllKeys(std::vector<T_KEY> &keys) const {
+    ForEach([&keys](const T_KEY &key, const TypeValuePtr &) { keys.push_back(key); });
+    return keys.size();
+  }
+
+  // GetAllKeys
+  // get all keys of the map
+  int GetAllKeys(std::set<T_KEY> &keys, std::function<bool(T_VALUE)> filter = nullptr) const {
+    ForEach([&](const T_KEY &key, const TypeValuePtr &value) {
+      if (filter == nullptr || filter(*value)) {
+        keys.insert(key);
+      }
+    });
+    return keys.size();
+  }
+
+  // GetAllValues
+  // get all values of the map
+  int GetAllValues(std::vector<T_VALUE> &values, std::function<bool(T_VALUE)> filter = nullptr) const {
+    ForEach([&](const T_KEY &, const TypeValuePtr &value) {
+      if (filter == nullptr || filter(*value)) {
+        values.push_back(*value);
+      }
+    });
+    return values.size();
+  }
+
+  // GetAllKeyValues
+  // get all keys and values of the map
+  int GetAllKeyValues(std::map<T_KEY, T_VALUE> &key_value_map, std::function<bool(T_VALUE)> filter = nullptr) const {
+    ForEach([&](const T_KEY &key, const TypeValuePtr &value) {
+      if (filter == nullptr || filter(*value)) {
+        key_value_map.insert_or_assign(key, *value);
+      }
+    });
+    return key_value_map.size();
+  }
+
+  // GetRawMapCopy
+  // get a copy of all key-value pairs, replace the contents of out_map like DingoSafeMap
+  // the out_map is initialized if it is not
+  int GetRawMapCopy(TypeRawMap &out_map) const {
+    if (!out_map.initialized()) {
+      out_map.init(std::max(static_cast<size_t>(Size()), kDefaultShardCapacity));
+    } else {
+      out_map.clear();
+    }
+
+    ForEach([&out_map](const T_KEY &key, const TypeValuePtr &value) { out_map.insert(key, *value); });
+    return 1;
+  }
+
+  // Exists
+  // check if the key exists in the map
+  bool Exists(const T_KEY &key) const { return GetPtr(key) != nullptr; }
+
+  // Size
+  // return the record count of map
+  int64_t Size() const {
+    int64_t size = 0;
+    for (const auto &shard : shards_) {
+      std::shared_lock lock(shard.mutex);
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  // MemorySize
+  // return the memory size of map
+  int64_t MemorySize() const {
+    int64_t size = 0;
+    ForEach([&size](const T_KEY &, const TypeValuePtr &value) { size += value->ByteSizeLong(); });
+    return size;
+  }
+
+  // Put
+  // put key-value pair into map
+  int Put(const T_KEY &key, TypeValuePtr value) {
+    if (value == nullptr) {
+      return -1;
+    }
+
+    auto &shard = GetShard(key);
+    std::unique_lock lock(shard.mutex);
+    shard.map.insert(key, std::move(value));
+    return 1;
+  }
+
+  int Put(const T_KEY &key, const T_VALUE &value) { return Put(key, std::make_shared<const T_VALUE>(value)); }
+
+  // MultiPut
+  // put key-value pairs into map, all pairs are visible at the same time
+  int MultiPut(const std::vector<T_KEY> &key_list, const std::vector<TypeValuePtr> &value_list) {
+    if (key_list.size() != value_list.size() || key_list.empty()) {
+      return -1;
+    }
+
+    auto locks = LockShards(key_list);
+    for (size_t i = 0; i < key_list.size(); ++i) {
+      if (value_list[i] != nullptr) {
+        GetShard(key_list[i]).map.insert(key_list[i], value_list[i]);
+      }
+    }
+    return 1;
+  }
+
+  int MultiPut(const std::vector<T_KEY> &key_list, const std::vector<T_VALUE> &value_list) {
+    std::vector<TypeValuePtr> value_ptr_list;
+    value_ptr_list.reserve(value_list.size());
+    for (const auto &value : value_list) {
+      value_ptr_list.push_back(std::make_shared<const T_VALUE>(value));
+    }
+    return MultiPut(key_list, value_ptr_list);
+  }
+
+  // MultiErase
+  // erase multi keys, all keys are invisible at the same time
+  int MultiErase(const std::vector<T_KEY> &key_list) {
+    if (key_list.empty()) {
+      return -1;
+    }
+
+    auto locks = LockShards(key_list);
+    for (const auto &key : key_list) {
+      GetShard(key).map.erase(key);
+    }
+    return 1;
+  }
+
+  // PutIfExists
+  // put key-value pair into map if key exists
+  int PutIfExists(const T_KEY &key, const T_VALUE &value) {
+    auto &shard = GetShard(key);
+    std::unique_lock lock(shard.mutex);
+    auto *value_ptr = shard.map.seek(key);
+    if (value_ptr == nullptr) {
+      return -1;
+    }
+
+    *value_ptr = std::make_shared<const T_VALUE>(value);
+    return 1;
+  }
+
+  // PutIfAbsent
+  // put key-value pair into map if key not exists
+  int PutIfAbsent(const T_KEY &key, const T_VALUE &value) {
+    auto &shard = GetShard(key);
+    std::unique_lock lock(shard.mutex);
+    if (shard.map.seek(key) != nullptr) {
+      return -1;
+    }
+
+    shard.map.insert(key, std::make_shared<const T_VALUE>(value));
+    return 1;
+  }
+
+  // Erase
+  // erase key-value pair from map
+  int Erase(const T_KEY &key) {
+    auto &shard = GetShard(key);
+    std::unique_lock lock(shard.mutex);
+    shard.map.erase(key);
+    return 1;
+  }
+
+  // Clear
+  // erase all key-value pairs from map
+  int Clear() {
+    for (auto &shard : shards_) {
+      std::unique_lock lock(shard.mutex);
+      shard.map.clear();
+    }
+    return 1;
+  }
+
+ private:
+  static constexpr size_t kDefaultShardCapacity = 64;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    TypeShardMap map;
+  };
+
+  static size_t ShardIndex(const T_KEY &key) { return std::hash<T_KEY>()(key) % SHARD_NUM; }
+
+  Shard &GetShard(const T_KEY &key) { return shards_[ShardIndex(key)]; }
+  const Shard &GetShard(const T_KEY &key) const { return shards_[ShardIndex(key)]; }
+
+  // lock the shards of keys in index order to avoid dead lock
+  std::vector<std::unique_lock<std::shared_mutex>> LockShards(const std::vector<T_KEY> &key_list) {
+    std::bitset<SHARD_NUM> involved;
+    for (const auto &key : key_list) {
+      involved.set(ShardIndex(key));
+    }
+
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(involved.count());
+    for (size_t i = 0; i < SHARD_NUM; ++i) {
+      if (involved.test(i)) {
+        locks.emplace_back(shards_[i].mutex);
+      }
+    }
+    return locks;
+  }
+
+  // visit all key-value pairs shard by shard, the values are only referenced in the lock
+  template <typename Visitor>
+  void ForEach(Visitor &&visitor) const {
+    for (const auto &shard : shards_) {
+      std::shared_lock lock(shard.mutex);
+      for (const auto &it : shard.map) {
+        visitor(it.first, it.second);
+      }
+    }
+  }
+
+  std::array<Shard, SHARD_NUM> shards_;
+};
+
 }  // namespace dingodb
 
 #endif  // DINGODB_COMMON_SAFE_MAP_H_
\ No newline at end of file
@@ -129,6 +129,90 @@ class BthreadCond {
 
 using BthreadCondPtr = std::shared_ptr<BthreadCond>;
 
+// Reader-writer lock for bthread, the waiting bthread yields its worker instead of blocking the pthread.
+// Writer is preferred, new readers wait while a writer is waiting, so continuous readers can't starve the writer.
+class BthreadRWLock {
+ public:
+  BthreadRWLock() {
+    bthread_mutex_init(&mutex_, nullptr);
+    bthread_cond_init(&cond_, nullptr);
+  }
+  ~BthreadRWLock() {
+    bthread_cond_destroy(&cond_);
+    bthread_mutex_destroy(&mutex_);
+  }
+
+  BthreadRWLock(const BthreadRWLock&) = delete;
+  BthreadRWLock& operator=(const BthreadRWLock&) = delete;
+
+  void LockRead() {
+    bthread_mutex_lock(&mutex_);
+    while (is_writing_ || waiting_writer_count_ > 0) {
+      bthread_cond_wait(&cond_, &mutex_);
+    }
+    ++reader_count_;
+    bthread_mutex_unlock(&mutex_);
+  }
+
+  void UnlockRead() {
+    bthread_mutex_lock(&mutex_);
+    if (--reader_count_ == 0) {
+      bthread_cond_broadcast(&cond_);
+    }
+    bthread_mutex_unlock(&mutex_);
+  }
+
+  void LockWrite() {
+    bthread_mutex_lock(&mutex_);
+    ++waiting_writer_count_;
+    while (is_writing_ || reader_count_ > 0) {
+      bthread_cond_wait(&cond_, &mutex_);
+    }
+    --waiting_writer_count_;
+    is_writing_ = true;
+    bthread_mutex_unlock(&mutex_);
+  }
+
+  void UnlockWrite() {
+    bthread_mutex_lock(&mutex_);
+    is_writing_ = false;
+    bthread_cond_broadcast(&cond_);
+    bthread_mutex_unlock(&mutex_);
+  }
+
+  // RAII
+  class ReadGuard {
+   public:
+    explicit ReadGuard(BthreadRWLock& rw_lock) : rw_lock_(rw_lock) { rw_lock_.LockRead(); }
+    ~ReadGuard() { rw_lock_.UnlockRead(); }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+   private:
+    BthreadRWLock& rw_lock_;
+  };
+
+  class WriteGuard {
+   public:
+    explicit WriteGuard(BthreadRWLock& rw_lock) : rw_lock_(rw_lock) { rw_lock_.LockWrite(); }
+    ~WriteGuard() { rw_lock_.UnlockWrite(); }
+
+    WriteGuard(const WriteGuard&) = delete;
+    WriteGuard& operator=(const WriteGuard&) = delete;
+
+   private:
+    BthreadRWLock& rw_lock_;
+  };
+
+ private:
+  bthread_mutex_t mutex_;
+  bthread_cond_t cond_;
+  int reader_count_{0};
+  int waiting_writer_count_{0};
+  bool is_writing_{false};
+};
+
 // wrapper bthread functions for c++ style
 class Bthread {
  public:
@@ -0,0 +1,102 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/tracker.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/helper.h"
+#include "gflags/gflags.h"
+#include "metrics/dingo_bvar.h"
+
+namespace dingodb {
+
+DEFINE_int32(tracker_sample_interval, 100, "trace one of every interval requests, 0 means disable trace");
+DEFINE_bool(enable_tracker_response, false, "return stage time of traced request in response_info, for debug");
+
+static DingoMultiDimension<bvar::LatencyRecorder> g_tracker_stage_latency("dingo_tracker_stage_latency",
+                                                                          {"method", "stage"});
+
+Tracker::Tracker(const std::string& method_name, int64_t receive_time_ns)
+    : method_name_(method_name), receive_time_ns_(receive_time_ns) {}
+
+TrackerPtr Tracker::New(const std::string& method_name, int64_t receive_time_ns) {
+  if (FLAGS_tracker_sample_interval <= 0) {
+    return nullptr;
+  }
+
+  // per thread counter, avoid contention on sampling
+  thread_local uint64_t request_count = 0;
+  if (request_count++ % FLAGS_tracker_sample_interval != 0) {
+    return nullptr;
+  }
+
+  return std::make_shared<Tracker>(method_name, receive_time_ns);
+}
+
+int64_t Tracker::NowNs() { return Helper::TimestampNs(); }
+
+static void RecordStageTime(const std::string& method_name, const std::string& stage, int64_t time_ns) {
+  auto* latency = g_tracker_stage_latency.get_stats({method_name, stage});
+  if (latency != nullptr) {
+    // in us
+    *latency << time_ns / 1000;
+  }
+}
+
+void Tracker::Finish() {
+  finish_time_ns_ = NowNs();
+
+  if (run_time_ns_ == 0) {
+    return;
+  }
+  RecordStageTime(method_name_, "queue_wait", run_time_ns_ - receive_time_ns_);
+
+  if (raft_propose_time_ns_ == 0) {
+    RecordStageTime(method_name_, "prepare", finish_time_ns_ - run_time_ns_);
+    return;
+  }
+  RecordStageTime(method_name_, "prepare", raft_propose_time_ns_ - run_time_ns_);
+
+  if (raft_commit_time_ns_ == 0 || raft_apply_start_time_ns_ == 0 || raft_apply_end_time_ns_ == 0) {
+    return;
+  }
+  RecordStageTime(method_name_, "raft_commit", raft_commit_time_ns_ - raft_propose_time_ns_);
+  RecordStageTime(method_name_, "raft_apply_wait", raft_apply_start_time_ns_ - raft_commit_time_ns_);
+  RecordStageTime(method_name_, "raft_apply", raft_apply_end_time_ns_ - raft_apply_start_time_ns_);
+}
+
+void Tracker::FillTimeInfo(pb::common::TimeInfo& time_info) const {
+  if (run_time_ns_ == 0) {
+    return;
+  }
+  time_info.set_queue_wait_time_ns(run_time_ns_ - receive_time_ns_);
+
+  if (raft_propose_time_ns_ == 0) {
+    time_info.set_prepare_time_ns(finish_time_ns_ - run_time_ns_);
+    return;
+  }
+  time_info.set_prepare_time_ns(raft_propose_time_ns_ - run_time_ns_);
+
+  if (raft_commit_time_ns_ == 0 || raft_apply_start_time_ns_ == 0 || raft_apply_end_time_ns_ == 0) {
+    return;
+  }
+  time_info.set_raft_commit_time_ns(raft_commit_time_ns_ - raft_propose_time_ns_);
+  time_info.set_raft_apply_wait_time_ns(raft_apply_start_time_ns_ - raft_commit_time_ns_);
+  time_info.set_raft_apply_time_ns(raft_apply_end_time_ns_ - raft_apply_start_time_ns_);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,79 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COMMON_TRACKER_H_
+#define DINGODB_COMMON_TRACKER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "proto/common.pb.h"
+
+namespace dingodb {
+
+class Tracker;
+using TrackerPtr = std::shared_ptr<Tracker>;
+
+// Trace the stages of one request, from service received to response.
+// Only sampled requests have tracker, stage time is aggregated into latency recorder per method and stage.
+//   queue_wait: request received -> start to run in worker.
+//   prepare: start to run -> propose to raft, or -> response for request without raft.
+//   raft_commit: propose -> log entry reach state machine, include replication and log fsync.
+//   raft_apply_wait: log entry reach state machine -> start to apply, wait for the previous entries.
+//   raft_apply: apply in state machine, include engine write.
+class Tracker {
+ public:
+  explicit Tracker(const std::string& method_name, int64_t receive_time_ns);
+  ~Tracker() = default;
+
+  // Return tracker when the request is sampled, otherwise nullptr.
+  static TrackerPtr New(const std::string& method_name, int64_t receive_time_ns);
+
+  const std::string& MethodName() const { return method_name_; }
+
+  void SetRunTime() { run_time_ns_ = NowNs(); }
+  void SetRaftProposeTime() { raft_propose_time_ns_ = NowNs(); }
+  void SetRaftCommitTime(int64_t time_ns) { raft_commit_time_ns_ = time_ns; }
+  // one proposal may carry multiple requests, apply time covers all of them
+  void SetRaftApplyStartTime() {
+    if (raft_apply_start_time_ns_ == 0) {
+      raft_apply_start_time_ns_ = NowNs();
+    }
+  }
+  void SetRaftApplyEndTime() { raft_apply_end_time_ns_ = NowNs(); }
+
+  // Request finish, record the stage time to metrics.
+  void Finish();
+
+  // Fill the stage time, call after Finish.
+  void FillTimeInfo(pb::common::TimeInfo& time_info) const;
+
+  static int64_t NowNs();
+
+ private:
+  std::string method_name_;
+
+  int64_t receive_time_ns_{0};
+  int64_t run_time_ns_{0};
+  int64_t raft_propose_time_ns_{0};
+  int64_t raft_commit_time_ns_{0};
+  int64_t raft_apply_start_time_ns_{0};
+  int64_t raft_apply_end_time_ns_{0};
+  int64_t finish_time_ns_{0};
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COMMON_TRACKER_H_
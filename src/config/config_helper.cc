@@ -174,4 +174,27 @@ int ConfigHelper::GetRocksDBStatsDumpPeriodSec() {
   return (num <= 0) ? Constant::kStatsDumpPeriodSecDefault : num;
 }
 
+int64_t ConfigHelper::GetRocksDBBlockCacheSize() {
+  auto config = ConfigManager::GetInstance().GetRoleConfig();
+  if (config == nullptr) {
+    return 0;
+  }
+
+  int64_t size = config->GetInt64("store.block_cache_size");
+  return size > 0 ? size : 0;
+}
+
+double ConfigHelper::GetRocksDBWriteBufferRatio() {
+  auto config = ConfigManager::GetInstance().GetRoleConfig();
+  if (config == nullptr) {
+    return Constant::kRocksdbWriteBufferRatioDefault;
+  }
+
+  double ratio = config->GetDouble("store.write_buffer_ratio");
+  if (ratio <= 0 || ratio >= 1) {
+    return Constant::kRocksdbWriteBufferRatioDefault;
+  }
+  return ratio;
+}
+
 }  // namespace dingodb
\ No newline at end of file
@@ -39,6 +39,9 @@ class ConfigHelper {
 
   static int GetRocksDBBackgroundThreadNum();
   static int GetRocksDBStatsDumpPeriodSec();
+  // 0 means not configured
+  static int64_t GetRocksDBBlockCacheSize();
+  static double GetRocksDBWriteBufferRatio();
 };
 
 }  // namespace dingodb
@@ -14,6 +14,7 @@
 
 #include "coordinator/auto_increment_control.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <memory>
@@ -26,16 +27,24 @@
 #include "common/synchronization.h"
 #include "coordinator/coordinator_interaction.h"
 #include "engine/snapshot.h"
+#include "gflags/gflags.h"
 #include "proto/error.pb.h"
 #include "server/server.h"
 
 namespace dingodb {
 
+DEFINE_int64(auto_increment_segment_size, 10000,
+             "count of ids reserved by leader in one raft write for generating auto increment, 0 means disable");
+
 AutoIncrementControl::AutoIncrementControl() {
   // init bthread mutex
   bthread_mutex_init(&auto_increment_map_mutex_, nullptr);
+  bthread_mutex_init(&auto_increment_segments_mutex_, nullptr);
 
   CHECK_EQ(0, auto_increment_map_.init(256, 70));
+  CHECK_EQ(0, auto_increment_segments_.init(256, 70));
+
+  segment_generation_.store(0, butil::memory_order_release);
 
   leader_term_.store(-1, butil::memory_order_release);
 }
@@ -202,9 +211,7 @@ butil::Status AutoIncrementControl::GenerateAutoIncrement(int64_t table_id, uint
     return ret;
   }
 
-  if (count == 0 || count > kAutoIncrementGenerateCountMax || auto_increment_increment == 0 ||
-      auto_increment_increment > kAutoIncrementOffsetMax || auto_increment_offset == 0 ||
-      auto_increment_offset > kAutoIncrementOffsetMax) {
+  if (!IsValidGenerateParams(count, auto_increment_increment, auto_increment_offset)) {
     DINGO_LOG(WARNING) << "illegal parameters : " << table_id << " | " << count << " | " << auto_increment_increment
                        << " | " << auto_increment_offset;
     return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, "illegal parameters");
@@ -222,6 +229,100 @@ butil::Status AutoIncrementControl::GenerateAutoIncrement(int64_t table_id, uint
   return butil::Status::OK();
 }
 
+butil::Status AutoIncrementControl::GenerateAutoIncrementFromSegment(int64_t table_id, uint32_t count,
+                                                                     uint32_t auto_increment_increment,
+                                                                     uint32_t auto_increment_offset, int64_t& start_id,
+                                                                     int64_t& end_id) {
+  if (!IsValidGenerateParams(count, auto_increment_increment, auto_increment_offset)) {
+    DINGO_LOG(WARNING) << "illegal parameters : " << table_id << " | " << count << " | " << auto_increment_increment
+                       << " | " << auto_increment_offset;
+    return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, "illegal parameters");
+  }
+
+  // the ids of one generate span at most count * increment + increment, see GetGenerateEndId
+  int64_t span = static_cast<int64_t>(count) * auto_increment_increment + auto_increment_increment;
+  int64_t segment_size =
+      std::min(FLAGS_auto_increment_segment_size, static_cast<int64_t>(kAutoIncrementGenerateCountMax));
+  bool cacheable = segment_size > 0 && span <= segment_size;
+
+  BAIDU_SCOPED_LOCK(auto_increment_segments_mutex_);
+
+  int64_t term = leader_term_.load(butil::memory_order_acquire);
+  int64_t generation = segment_generation_.load(butil::memory_order_acquire);
+  auto* segment = auto_increment_segments_.seek(table_id);
+  if (segment != nullptr && (!cacheable || segment->term != term || segment->generation != generation)) {
+    // the rest of segment is dropped, ids after it are reserved, so the ids keep monotonic
+    auto_increment_segments_.erase(table_id);
+    segment = nullptr;
+  }
+
+  if (segment != nullptr) {
+    int64_t generate_end_id =
+        GetGenerateEndId(segment->next_id, count, auto_increment_increment, auto_increment_offset);
+    if (generate_end_id <= segment->end_id) {
+      start_id = segment->next_id;
+      end_id = generate_end_id;
+      segment->next_id = generate_end_id;
+      return butil::Status::OK();
+    }
+  }
+
+  if (!cacheable) {
+    return SyncGenerateAutoIncrement(table_id, count, auto_increment_increment, auto_increment_offset, start_id,
+                                     end_id);
+  }
+
+  int64_t segment_start_id = 0;
+  int64_t segment_end_id = 0;
+  auto ret = SyncGenerateAutoIncrement(table_id, segment_size, 1, 1, segment_start_id, segment_end_id);
+  if (!ret.ok()) {
+    return ret;
+  }
+
+  DINGO_LOG(INFO) << "reserve auto increment segment, table id: " << table_id << ", term: " << term << ", segment: ["
+                  << segment_start_id << ", " << segment_end_id << ")";
+
+  start_id = segment_start_id;
+  end_id = GetGenerateEndId(segment_start_id, count, auto_increment_increment, auto_increment_offset);
+  CHECK(end_id <= segment_end_id) << "generate end id exceed segment, " << end_id << " | " << segment_end_id;
+
+  auto_increment_segments_[table_id] = AutoIncrementSegment{end_id, segment_end_id, term, generation};
+  return butil::Status::OK();
+}
+
+butil::Status AutoIncrementControl::SyncGenerateAutoIncrement(int64_t table_id, uint32_t count,
+                                                              uint32_t auto_increment_increment,
+                                                              uint32_t auto_increment_offset, int64_t& start_id,
+                                                              int64_t& end_id) {
+  pb::coordinator_internal::MetaIncrement meta_increment;
+  auto ret =
+      GenerateAutoIncrement(table_id, count, auto_increment_increment, auto_increment_offset, meta_increment);
+  if (!ret.ok()) {
+    return ret;
+  }
+
+  // the generated range is set to response on leader apply
+  pb::meta::GenerateAutoIncrementResponse response;
+  std::shared_ptr<Context> const ctx = std::make_shared<Context>(nullptr, nullptr, &response);
+  ctx->SetRegionId(Constant::kAutoIncrementRegionId);
+
+  auto status = engine_->Write(ctx, WriteDataBuilder::BuildWrite(ctx->CfName(), meta_increment));
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << "SubmitMetaIncrement failed, errno=" << status.error_code() << " errmsg=" << status.error_str();
+    return status;
+  }
+
+  if (response.end_id() <= response.start_id()) {
+    DINGO_LOG(ERROR) << "generate auto increment failed, table id: " << table_id
+                     << ", response: " << response.ShortDebugString();
+    return butil::Status(pb::error::Errno::EINTERNAL, "generate auto increment failed");
+  }
+
+  start_id = response.start_id();
+  end_id = response.end_id();
+  return butil::Status::OK();
+}
+
 butil::Status AutoIncrementControl::DeleteAutoIncrement(int64_t table_id,
                                                         pb::coordinator_internal::MetaIncrement& meta_increment) {
   DINGO_LOG(INFO) << "table id" << table_id;
@@ -309,6 +410,7 @@ void AutoIncrementControl::ApplyMetaIncrement(pb::coordinator_internal::MetaIncr
       DINGO_LOG(INFO) << "create auto increment, table id: " << table_id
                       << ", start id: " << auto_increment.increment().start_id();
       auto_increment_map_[table_id] = auto_increment.increment().start_id();
+      segment_generation_.fetch_add(1, butil::memory_order_release);
     } else if (auto_increment.op_type() == pb::coordinator_internal::MetaIncrementOpType::UPDATE) {
       int64_t* start_id_ptr = auto_increment_map_.seek(table_id);
       if (start_id_ptr == nullptr) {
@@ -339,6 +441,7 @@ void AutoIncrementControl::ApplyMetaIncrement(pb::coordinator_internal::MetaIncr
                              << auto_increment.increment().source_start_id();
         }
         auto_increment_map_[table_id] = auto_increment.increment().start_id();
+        segment_generation_.fetch_add(1, butil::memory_order_release);
         DINGO_LOG(INFO) << "update auto increment, table id: " << table_id
                         << ", old start id: " << auto_increment.increment().source_start_id()
                         << ", start id: " << auto_increment.increment().start_id();
@@ -346,6 +449,7 @@ void AutoIncrementControl::ApplyMetaIncrement(pb::coordinator_internal::MetaIncr
     } else if (auto_increment.op_type() == pb::coordinator_internal::MetaIncrementOpType::DELETE) {
       DINGO_LOG(INFO) << "delete auto increment " << auto_increment.ShortDebugString();
       auto_increment_map_.erase(table_id);
+      segment_generation_.fetch_add(1, butil::memory_order_release);
     }
   }
 }
@@ -369,6 +473,13 @@ int64_t AutoIncrementControl::GetGenerateEndId(int64_t start_id, uint32_t count,
   return real_start_id + count * increment;
 }
 
+bool AutoIncrementControl::IsValidGenerateParams(uint32_t count, uint32_t auto_increment_increment,
+                                                 uint32_t auto_increment_offset) {
+  return count > 0 && count <= kAutoIncrementGenerateCountMax && auto_increment_increment > 0 &&
+         auto_increment_increment <= kAutoIncrementOffsetMax && auto_increment_offset > 0 &&
+         auto_increment_offset <= kAutoIncrementOffsetMax;
+}
+
 int64_t AutoIncrementControl::GetRealStartId(int64_t start_id, uint32_t auto_increment_increment,
                                              uint32_t auto_increment_offset) {
   int64_t remainder = start_id % auto_increment_increment;
@@ -453,6 +564,7 @@ bool AutoIncrementControl::LoadMetaFromSnapshotFile(pb::coordinator_internal::Me
     const auto& element = storage.elements(i);
     auto_increment_map_[element.table_id()] = element.start_id();
   }
+  segment_generation_.fetch_add(1, butil::memory_order_release);
 
   DINGO_LOG(INFO) << "AutoIncrementControl LoadMetaFromSnapshotFile success, elements_size=" << storage.elements_size();
 
@@ -69,6 +69,11 @@ class AutoIncrementControl : public MetaControl {
   butil::Status GenerateAutoIncrement(int64_t table_id, uint32_t count, uint32_t auto_increment_increment,
                                       uint32_t auto_increment_offset,
                                       pb::coordinator_internal::MetaIncrement &meta_increment);
+  // Generate ids from the leader local segment, a new segment is reserved by one raft write when the segment is
+  // exhausted. A new leader always reserves after the persisted start id, so ids keep monotonic across leader change.
+  // out: [start_id, end_id) like GenerateAutoIncrement
+  butil::Status GenerateAutoIncrementFromSegment(int64_t table_id, uint32_t count, uint32_t auto_increment_increment,
+                                                 uint32_t auto_increment_offset, int64_t &start_id, int64_t &end_id);
   butil::Status DeleteAutoIncrement(int64_t table_id, pb::coordinator_internal::MetaIncrement &meta_increment);
 
   // Get raft leader's server location
@@ -116,10 +121,28 @@ class AutoIncrementControl : public MetaControl {
  private:
   static int64_t GetGenerateEndId(int64_t start_id, uint32_t count, uint32_t increment, uint32_t offset);
   static int64_t GetRealStartId(int64_t start_id, uint32_t auto_increment_increment, uint32_t auto_increment_offset);
+  static bool IsValidGenerateParams(uint32_t count, uint32_t auto_increment_increment, uint32_t auto_increment_offset);
+
+  // reserve ids by raft, out: [start_id, end_id)
+  butil::Status SyncGenerateAutoIncrement(int64_t table_id, uint32_t count, uint32_t auto_increment_increment,
+                                          uint32_t auto_increment_offset, int64_t &start_id, int64_t &end_id);
 
   butil::FlatMap<int64_t, int64_t> auto_increment_map_;
   bthread_mutex_t auto_increment_map_mutex_;
 
+  // ids in [next_id, end_id) are reserved by leader of term
+  struct AutoIncrementSegment {
+    int64_t next_id;
+    int64_t end_id;
+    int64_t term;
+    int64_t generation;
+  };
+  butil::FlatMap<int64_t, AutoIncrementSegment> auto_increment_segments_;
+  // held across the raft write of reserving segment, never lock it in raft apply
+  bthread_mutex_t auto_increment_segments_mutex_;
+  // increased when auto increment is created, updated or deleted not by generate, the segments before are invalid
+  butil::atomic<int64_t> segment_generation_;
+
   // node is leader or not
   butil::atomic<int64_t> leader_term_;
 
@@ -0,0 +1,466 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coordinator/balance_scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+
+namespace dingodb {
+
+DEFINE_int64(balance_max_operations_per_round, 4, "max balance operations of one schedule round");
+DEFINE_int64(balance_max_operations_per_store, 2, "max balance operations of one store in one schedule round");
+DEFINE_int64(balance_region_cooldown_s, 600, "region will not be balanced again in cooldown seconds");
+DEFINE_int64(balance_store_cooldown_s, 60, "store will not be source or target of change peer in cooldown seconds");
+DEFINE_double(balance_tolerance, 0.05, "stores are balanced when the gap of normalized score is not more than this");
+DEFINE_double(balance_cpu_weight, 0.2, "weight of cpu usage in leader score");
+DEFINE_double(balance_disk_weight, 0.5, "weight of disk usage in region score");
+DEFINE_double(balance_max_capacity_ratio, 0.8, "store with higher disk usage ratio can not be target of change peer");
+
+void BalanceSnapshotBuilder::AddStore(const pb::common::Store& store,
+                                      const pb::common::StoreOwnMetrics* store_own_metrics) {
+  if (store.store_type() != pb::common::StoreType::NODE_TYPE_STORE &&
+      store.store_type() != pb::common::StoreType::NODE_TYPE_INDEX) {
+    return;
+  }
+
+  BalanceStore balance_store;
+  balance_store.store_id = store.id();
+  balance_store.is_normal = store.state() == pb::common::StoreState::STORE_NORMAL &&
+                            store.in_state() == pb::common::StoreInState::STORE_IN;
+  if (store_own_metrics != nullptr) {
+    balance_store.total_capacity = store_own_metrics->system_total_capacity();
+    balance_store.free_capacity = store_own_metrics->system_free_capacity();
+    balance_store.cpu_usage = store_own_metrics->process_used_cpu();
+  } else {
+    balance_store.is_normal = false;
+  }
+
+  store_types_[store.id()] = store.store_type();
+  snapshots_[store.store_type()].stores.push_back(balance_store);
+}
+
+void BalanceSnapshotBuilder::AddRegion(const pb::coordinator_internal::RegionInternal& region,
+                                       const pb::common::RegionMetrics* region_metrics, bool has_task_list) {
+  if (region.definition().peers_size() == 0) {
+    return;
+  }
+  auto type_it = store_types_.find(region.definition().peers(0).store_id());
+  if (type_it == store_types_.end()) {
+    return;
+  }
+
+  // the load of store includes the regions which can't be scheduled
+  bool is_schedulable = region.state() == pb::common::RegionState::REGION_NORMAL && !has_task_list;
+  std::vector<int64_t> store_ids;
+  for (const auto& peer : region.definition().peers()) {
+    auto peer_type_it = store_types_.find(peer.store_id());
+    if (peer.role() != pb::common::PeerRole::VOTER || peer_type_it == store_types_.end() ||
+        peer_type_it->second != type_it->second) {
+      is_schedulable = false;
+    }
+    if (peer_type_it != store_types_.end()) {
+      ++region_counts_[peer.store_id()];
+    }
+    store_ids.push_back(peer.store_id());
+  }
+
+  if (region_metrics == nullptr || region_metrics->leader_store_id() == 0) {
+    return;
+  }
+  if (store_types_.find(region_metrics->leader_store_id()) != store_types_.end()) {
+    ++leader_counts_[region_metrics->leader_store_id()];
+  }
+
+  BalanceRegion balance_region;
+  balance_region.region_id = region.id();
+  balance_region.leader_store_id = region_metrics->leader_store_id();
+  balance_region.region_size = region_metrics->region_size();
+  balance_region.is_schedulable =
+      is_schedulable &&
+      region_metrics->region_status().heartbeat_status() == pb::common::RegionHeartbeatState::REGION_ONLINE &&
+      region_metrics->region_status().raft_status() == pb::common::RegionRaftStatus::REGION_RAFT_HEALTHY;
+  balance_region.store_ids = std::move(store_ids);
+
+  snapshots_[type_it->second].regions.push_back(std::move(balance_region));
+}
+
+std::map<pb::common::StoreType, BalanceSnapshot> BalanceSnapshotBuilder::Build() {
+  for (auto& [store_type, snapshot] : snapshots_) {
+    for (auto& store : snapshot.stores) {
+      auto leader_it = leader_counts_.find(store.store_id);
+      store.leader_count = leader_it != leader_counts_.end() ? leader_it->second : 0;
+      auto region_it = region_counts_.find(store.store_id);
+      store.region_count = region_it != region_counts_.end() ? region_it->second : 0;
+    }
+  }
+
+  return std::move(snapshots_);
+}
+
+std::string BalanceOperation::ToString() const {
+  std::string peers;
+  for (auto store_id : new_store_ids) {
+    peers += peers.empty() ? std::to_string(store_id) : "," + std::to_string(store_id);
+  }
+  return fmt::format("{} region({}) {}({}->{}) new_peers({})", policy, region_id,
+                     type == kTransferLeader ? "transfer_leader" : "change_peer", source_store_id, target_store_id,
+                     peers);
+}
+
+BalanceOptions BalanceOptions::FromFlags() {
+  BalanceOptions options;
+  options.max_operations_per_round = FLAGS_balance_max_operations_per_round;
+  options.max_operations_per_store = FLAGS_balance_max_operations_per_store;
+  options.region_cooldown_ms = FLAGS_balance_region_cooldown_s * 1000;
+  options.store_cooldown_ms = FLAGS_balance_store_cooldown_s * 1000;
+  options.tolerance = FLAGS_balance_tolerance;
+  options.cpu_weight = FLAGS_balance_cpu_weight;
+  options.disk_weight = FLAGS_balance_disk_weight;
+  options.max_capacity_ratio = FLAGS_balance_max_capacity_ratio;
+  return options;
+}
+
+BalanceContext::BalanceContext(BalanceSnapshot snapshot, const BalanceOptions& options, int64_t now_ms,
+                               const std::map<int64_t, int64_t>& region_schedule_times,
+                               const std::map<int64_t, int64_t>& store_schedule_times)
+    : snapshot_(std::move(snapshot)),
+      options_(options),
+      now_ms_(now_ms),
+      region_schedule_times_(region_schedule_times),
+      store_schedule_times_(store_schedule_times) {
+  for (size_t i = 0; i < snapshot_.stores.size(); ++i) {
+    store_index_[snapshot_.stores[i].store_id] = i;
+  }
+}
+
+BalanceStore* BalanceContext::GetStore(int64_t store_id) {
+  auto it = store_index_.find(store_id);
+  return it != store_index_.end() ? &snapshot_.stores[it->second] : nullptr;
+}
+
+bool BalanceContext::IsFull() const {
+  return static_cast<int64_t>(operations_.size()) >= options_.max_operations_per_round;
+}
+
+bool BalanceContext::AllowRegion(const BalanceRegion& region) const {
+  if (!region.is_schedulable || round_regions_.count(region.region_id) > 0) {
+    return false;
+  }
+
+  auto it = region_schedule_times_.find(region.region_id);
+  return it == region_schedule_times_.end() || it->second + options_.region_cooldown_ms <= now_ms_;
+}
+
+bool BalanceContext::AllowStore(int64_t store_id, bool is_change_peer) const {
+  auto count_it = round_store_operation_counts_.find(store_id);
+  if (count_it != round_store_operation_counts_.end() && count_it->second >= options_.max_operations_per_store) {
+    return false;
+  }
+
+  if (is_change_peer) {
+    auto it = store_schedule_times_.find(store_id);
+    if (it != store_schedule_times_.end() && it->second + options_.store_cooldown_ms > now_ms_) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void BalanceContext::AddOperation(BalanceRegion& region, BalanceOperation operation) {
+  auto* source_store = GetStore(operation.source_store_id);
+  auto* target_store = GetStore(operation.target_store_id);
+  if (operation.type == BalanceOperation::kTransferLeader) {
+    source_store->leader_count--;
+    target_store->leader_count++;
+    region.leader_store_id = operation.target_store_id;
+  } else {
+    source_store->region_count--;
+    target_store->region_count++;
+    source_store->free_capacity += region.region_size;
+    target_store->free_capacity -= region.region_size;
+    region.store_ids = operation.new_store_ids;
+  }
+
+  round_store_operation_counts_[operation.source_store_id]++;
+  round_store_operation_counts_[operation.target_store_id]++;
+  round_regions_[region.region_id] = true;
+  operations_.push_back(std::move(operation));
+}
+
+static double Ratio(double value, double avg) { return avg > 0 ? value / avg : 0; }
+
+static double UsedRatio(int64_t total_capacity, int64_t free_capacity) {
+  return total_capacity > 0 ? 1.0 - static_cast<double>(free_capacity) / total_capacity : 0;
+}
+
+void LeaderBalancePolicy::Schedule(BalanceContext& ctx) {
+  auto& snapshot = ctx.Snapshot();
+  const auto& options = ctx.Options();
+
+  double total_leader_count = 0;
+  double total_cpu_usage = 0;
+  int64_t normal_store_count = 0;
+  for (const auto& store : snapshot.stores) {
+    if (store.is_normal) {
+      total_leader_count += store.leader_count;
+      total_cpu_usage += store.cpu_usage;
+      ++normal_store_count;
+    }
+  }
+  if (normal_store_count < 2 || total_leader_count == 0) {
+    return;
+  }
+  double avg_leader_count = total_leader_count / normal_store_count;
+  double avg_cpu_usage = total_cpu_usage / normal_store_count;
+
+  auto score = [&](const BalanceStore& store, int64_t leader_delta) {
+    return Ratio(store.leader_count + leader_delta, avg_leader_count) +
+           options.cpu_weight * Ratio(store.cpu_usage, avg_cpu_usage);
+  };
+
+  std::map<int64_t, std::vector<BalanceRegion*>> leader_regions;
+  for (auto& region : snapshot.regions) {
+    leader_regions[region.leader_store_id].push_back(&region);
+  }
+
+  while (!ctx.IsFull()) {
+    // try sources from the highest score, stop when no source has a move which reduce the imbalance
+    std::vector<BalanceStore*> sources;
+    for (auto& store : snapshot.stores) {
+      if (store.is_normal && store.leader_count > 0 && ctx.AllowStore(store.store_id, false)) {
+        sources.push_back(&store);
+      }
+    }
+    std::sort(sources.begin(), sources.end(),
+              [&](const BalanceStore* lhs, const BalanceStore* rhs) { return score(*lhs, 0) > score(*rhs, 0); });
+
+    bool scheduled = false;
+    for (auto* source : sources) {
+      double source_score = score(*source, 0);
+
+      BalanceRegion* best_region = nullptr;
+      BalanceStore* best_target = nullptr;
+      double best_target_score = 0;
+      for (auto* region : leader_regions[source->store_id]) {
+        if (region->leader_store_id != source->store_id || !ctx.AllowRegion(*region)) {
+          continue;
+        }
+        for (auto store_id : region->store_ids) {
+          auto* target = ctx.GetStore(store_id);
+          if (target == nullptr || target == source || !target->is_normal || !ctx.AllowStore(store_id, false)) {
+            continue;
+          }
+          double target_score = score(*target, 0);
+          if (best_target == nullptr || target_score < best_target_score) {
+            best_region = region;
+            best_target = target;
+            best_target_score = target_score;
+          }
+        }
+      }
+
+      // the move must reduce the gap, otherwise leaders will move back and forth
+      if (best_target == nullptr || source_score - best_target_score <= options.tolerance ||
+          score(*best_target, 1) >= source_score) {
+        continue;
+      }
+
+      BalanceOperation operation;
+      operation.type = BalanceOperation::kTransferLeader;
+      operation.region_id = best_region->region_id;
+      operation.source_store_id = source->store_id;
+      operation.target_store_id = best_target->store_id;
+      operation.policy = Name();
+      ctx.AddOperation(*best_region, std::move(operation));
+      scheduled = true;
+      break;
+    }
+
+    if (!scheduled) {
+      break;
+    }
+  }
+}
+
+void RegionBalancePolicy::Schedule(BalanceContext& ctx) {
+  auto& snapshot = ctx.Snapshot();
+  const auto& options = ctx.Options();
+
+  double total_region_count = 0;
+  double total_used_ratio = 0;
+  int64_t normal_store_count = 0;
+  for (const auto& store : snapshot.stores) {
+    if (store.is_normal) {
+      total_region_count += store.region_count;
+      total_used_ratio += UsedRatio(store.total_capacity, store.free_capacity);
+      ++normal_store_count;
+    }
+  }
+  if (normal_store_count < 2 || total_region_count == 0) {
+    return;
+  }
+  double avg_region_count = total_region_count / normal_store_count;
+  double avg_used_ratio = total_used_ratio / normal_store_count;
+
+  auto score = [&](const BalanceStore& store, int64_t region_delta, int64_t size_delta) {
+    double used_ratio = UsedRatio(store.total_capacity, store.free_capacity - size_delta);
+    return Ratio(store.region_count + region_delta, avg_region_count) +
+           options.disk_weight * Ratio(used_ratio, avg_used_ratio);
+  };
+
+  std::map<int64_t, std::vector<BalanceRegion*>> store_regions;
+  for (auto& region : snapshot.regions) {
+    for (auto store_id : region.store_ids) {
+      store_regions[store_id].push_back(&region);
+    }
+  }
+
+  while (!ctx.IsFull()) {
+    std::vector<BalanceStore*> sources;
+    std::vector<BalanceStore*> targets;
+    for (auto& store : snapshot.stores) {
+      if (store.is_normal && ctx.AllowStore(store.store_id, true)) {
+        sources.push_back(&store);
+        targets.push_back(&store);
+      }
+    }
+    std::sort(sources.begin(), sources.end(),
+              [&](const BalanceStore* lhs, const BalanceStore* rhs) { return score(*lhs, 0, 0) > score(*rhs, 0, 0); });
+    std::sort(targets.begin(), targets.end(),
+              [&](const BalanceStore* lhs, const BalanceStore* rhs) { return score(*lhs, 0, 0) < score(*rhs, 0, 0); });
+
+    bool scheduled = false;
+    for (auto* source : sources) {
+      double source_score = score(*source, 0, 0);
+      for (auto* region : store_regions[source->store_id]) {
+        // the leader is moved by leader balance, only move follower peer here
+        if (region->leader_store_id == source->store_id || !ctx.AllowRegion(*region) ||
+            std::find(region->store_ids.begin(), region->store_ids.end(), source->store_id) ==
+                region->store_ids.end()) {
+          continue;
+        }
+
+        for (auto* target : targets) {
+          if (target == source || score(*target, 0, 0) + options.tolerance >= source_score) {
+            break;
+          }
+          if (std::find(region->store_ids.begin(), region->store_ids.end(), target->store_id) !=
+                  region->store_ids.end() ||
+              UsedRatio(target->total_capacity, target->free_capacity - region->region_size) >
+                  options.max_capacity_ratio ||
+              score(*target, 1, region->region_size) >= source_score) {
+            continue;
+          }
+
+          BalanceOperation operation;
+          operation.type = BalanceOperation::kChangePeer;
+          operation.region_id = region->region_id;
+          operation.source_store_id = source->store_id;
+          operation.target_store_id = target->store_id;
+          for (auto store_id : region->store_ids) {
+            operation.new_store_ids.push_back(store_id == source->store_id ? target->store_id : store_id);
+          }
+          operation.policy = Name();
+          ctx.AddOperation(*region, std::move(operation));
+          scheduled = true;
+          break;
+        }
+
+        if (scheduled) {
+          break;
+        }
+      }
+
+      if (scheduled) {
+        break;
+      }
+    }
+
+    if (!scheduled) {
+      break;
+    }
+  }
+}
+
+BalanceScheduler::BalanceScheduler() {
+  policies_.push_back(std::make_shared<LeaderBalancePolicy>());
+  policies_.push_back(std::make_shared<RegionBalancePolicy>());
+}
+
+void BalanceScheduler::AddPolicy(BalancePolicyPtr policy) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  policies_.push_back(policy);
+}
+
+void BalanceScheduler::ClearPolicy() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  policies_.clear();
+}
+
+std::vector<BalanceOperation> BalanceScheduler::Schedule(const BalanceSnapshot& snapshot,
+                                                         const BalanceOptions& options, int64_t now_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // drop the expired cooldown
+  for (auto it = region_schedule_times_.begin(); it != region_schedule_times_.end();) {
+    it = it->second + options.region_cooldown_ms <= now_ms ? region_schedule_times_.erase(it) : std::next(it);
+  }
+  for (auto it = store_schedule_times_.begin(); it != store_schedule_times_.end();) {
+    it = it->second + options.store_cooldown_ms <= now_ms ? store_schedule_times_.erase(it) : std::next(it);
+  }
+
+  BalanceContext ctx(snapshot, options, now_ms, region_schedule_times_, store_schedule_times_);
+  for (const auto& policy : policies_) {
+    if (ctx.IsFull()) {
+      break;
+    }
+    policy->Schedule(ctx);
+  }
+
+  const auto& operations = ctx.Operations();
+  for (const auto& operation : operations) {
+    region_schedule_times_[operation.region_id] = now_ms;
+    if (operation.type == BalanceOperation::kChangePeer) {
+      store_schedule_times_[operation.source_store_id] = now_ms;
+      store_schedule_times_[operation.target_store_id] = now_ms;
+    }
+    DINGO_LOG(INFO) << fmt::format("[balance] schedule {}", operation.ToString());
+  }
+
+  return operations;
+}
+
+void BalanceScheduler::CancelOperation(const BalanceOperation& operation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  region_schedule_times_.erase(operation.region_id);
+  if (operation.type == BalanceOperation::kChangePeer) {
+    store_schedule_times_.erase(operation.source_store_id);
+    store_schedule_times_.erase(operation.target_store_id);
+  }
+}
+
+}  // namespace dingodb
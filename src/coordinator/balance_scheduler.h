@@ -0,0 +1,208 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COORDINATOR_BALANCE_SCHEDULER_H_
+#define DINGODB_COORDINATOR_BALANCE_SCHEDULER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "proto/common.pb.h"
+#include "proto/coordinator_internal.pb.h"
+
+namespace dingodb {
+
+// Load of one store, filled by coordinator from store_map and store metrics.
+struct BalanceStore {
+  int64_t store_id{0};
+  // store is normal and online, only normal store can be source or target of balance operation
+  bool is_normal{true};
+  int64_t leader_count{0};
+  int64_t region_count{0};
+  int64_t total_capacity{0};
+  int64_t free_capacity{0};
+  // process_used_cpu of store, the load of leaders
+  int64_t cpu_usage{0};
+};
+
+struct BalanceRegion {
+  int64_t region_id{0};
+  int64_t leader_store_id{0};
+  std::vector<int64_t> store_ids;
+  int64_t region_size{0};
+  // region is normal, healthy and has no running task list
+  bool is_schedulable{true};
+};
+
+// The cluster state which balance scheduler works on, stores and regions of one store type.
+struct BalanceSnapshot {
+  std::vector<BalanceStore> stores;
+  std::vector<BalanceRegion> regions;
+};
+
+// Build the snapshots of each store type from coordinator state. The leader_count and region_count of stores are
+// counted from all regions, including the regions which can't be scheduled.
+class BalanceSnapshotBuilder {
+ public:
+  // store_own_metrics is nullptr when store has not reported metrics yet, e.g. coordinator leader just changed.
+  void AddStore(const pb::common::Store& store, const pb::common::StoreOwnMetrics* store_own_metrics);
+  // Stores must be added before regions. region_metrics is nullptr when region has not reported metrics yet.
+  void AddRegion(const pb::coordinator_internal::RegionInternal& region,
+                 const pb::common::RegionMetrics* region_metrics, bool has_task_list);
+
+  std::map<pb::common::StoreType, BalanceSnapshot> Build();
+
+ private:
+  std::map<int64_t, pb::common::StoreType> store_types_;
+  std::map<pb::common::StoreType, BalanceSnapshot> snapshots_;
+  // store_id -> count
+  std::map<int64_t, int64_t> leader_counts_;
+  std::map<int64_t, int64_t> region_counts_;
+};
+
+struct BalanceOperation {
+  enum Type {
+    kTransferLeader = 0,
+    kChangePeer = 1,
+  };
+
+  Type type{kTransferLeader};
+  int64_t region_id{0};
+  int64_t source_store_id{0};
+  int64_t target_store_id{0};
+  // peers after change peer
+  std::vector<int64_t> new_store_ids;
+  std::string policy;
+
+  std::string ToString() const;
+};
+
+struct BalanceOptions {
+  // limit of operations of one schedule round and of one store in one round
+  int64_t max_operations_per_round{4};
+  int64_t max_operations_per_store{2};
+  // a region is not scheduled again in cooldown, it gives the task list time to finish and the metrics to refresh
+  int64_t region_cooldown_ms{600 * 1000};
+  // a store is not source or target of change peer again in cooldown, change peer need copy data by snapshot
+  int64_t store_cooldown_ms{60 * 1000};
+  // scores are normalized by average, store is balanced when the score gap is not more than tolerance
+  double tolerance{0.05};
+  // weight of cpu in leader score and weight of disk usage in region score
+  double cpu_weight{0.2};
+  double disk_weight{0.5};
+  // store whose disk usage is higher than this ratio can not be target of change peer
+  double max_capacity_ratio{0.8};
+
+  static BalanceOptions FromFlags();
+};
+
+class BalanceContext;
+
+// A policy balances one dimension of cluster, it proposes operations to context until context is full.
+class BalancePolicy {
+ public:
+  virtual ~BalancePolicy() = default;
+
+  virtual std::string Name() = 0;
+  virtual void Schedule(BalanceContext& ctx) = 0;
+};
+
+using BalancePolicyPtr = std::shared_ptr<BalancePolicy>;
+
+// Move leaders from the stores with high leader score to its peers with low leader score.
+// leader score = leader_count / avg_leader_count + cpu_weight * cpu_usage / avg_cpu_usage
+class LeaderBalancePolicy : public BalancePolicy {
+ public:
+  std::string Name() override { return "leader"; }
+  void Schedule(BalanceContext& ctx) override;
+};
+
+// Move follower peers from the stores with high region score to the stores with low region score.
+// region score = region_count / avg_region_count + disk_weight * used_ratio / avg_used_ratio
+class RegionBalancePolicy : public BalancePolicy {
+ public:
+  std::string Name() override { return "region"; }
+  void Schedule(BalanceContext& ctx) override;
+};
+
+// State of one schedule round, policies apply the proposed operations to the snapshot, so the later proposals
+// see the effect of the earlier ones. It also enforces the rate limit and cooldown.
+class BalanceContext {
+ public:
+  BalanceContext(BalanceSnapshot snapshot, const BalanceOptions& options, int64_t now_ms,
+                 const std::map<int64_t, int64_t>& region_schedule_times,
+                 const std::map<int64_t, int64_t>& store_schedule_times);
+
+  BalanceSnapshot& Snapshot() { return snapshot_; }
+  const BalanceOptions& Options() const { return options_; }
+  BalanceStore* GetStore(int64_t store_id);
+
+  bool IsFull() const;
+  bool AllowRegion(const BalanceRegion& region) const;
+  bool AllowStore(int64_t store_id, bool is_change_peer) const;
+
+  // record the operation and apply it to snapshot
+  void AddOperation(BalanceRegion& region, BalanceOperation operation);
+
+  const std::vector<BalanceOperation>& Operations() const { return operations_; }
+
+ private:
+  BalanceSnapshot snapshot_;
+  const BalanceOptions& options_;
+  int64_t now_ms_;
+  std::map<int64_t, size_t> store_index_;
+
+  const std::map<int64_t, int64_t>& region_schedule_times_;
+  const std::map<int64_t, int64_t>& store_schedule_times_;
+
+  std::map<int64_t, int64_t> round_store_operation_counts_;
+  std::map<int64_t, bool> round_regions_;
+  std::vector<BalanceOperation> operations_;
+};
+
+// Balance scheduler runs policies in order on the cluster snapshot, and remember the scheduled regions and stores
+// across rounds for cooldown. It only proposes operations, coordinator turns them into task lists.
+class BalanceScheduler {
+ public:
+  BalanceScheduler();
+  ~BalanceScheduler() = default;
+
+  BalanceScheduler(const BalanceScheduler&) = delete;
+  BalanceScheduler& operator=(const BalanceScheduler&) = delete;
+
+  void AddPolicy(BalancePolicyPtr policy);
+  void ClearPolicy();
+
+  std::vector<BalanceOperation> Schedule(const BalanceSnapshot& snapshot, const BalanceOptions& options,
+                                         int64_t now_ms);
+
+  // operation is not executed, e.g. task list conflict, so region and stores are released from cooldown
+  void CancelOperation(const BalanceOperation& operation);
+
+ private:
+  std::mutex mutex_;
+  std::vector<BalancePolicyPtr> policies_;
+
+  // region_id/store_id -> last schedule time in ms
+  std::map<int64_t, int64_t> region_schedule_times_;
+  std::map<int64_t, int64_t> store_schedule_times_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COORDINATOR_BALANCE_SCHEDULER_H_
@@ -62,11 +62,11 @@ CoordinatorControl::CoordinatorControl(std::shared_ptr<MetaReader> meta_reader,
   schema_meta_ =
       new MetaMemMapFlat<pb::coordinator_internal::SchemaInternal>(&schema_map_, kPrefixSchema, raw_engine_of_meta);
   region_meta_ =
-      new MetaMemMapFlat<pb::coordinator_internal::RegionInternal>(&region_map_, kPrefixRegion, raw_engine_of_meta);
+      new MetaMemMapSharded<pb::coordinator_internal::RegionInternal>(&region_map_, kPrefixRegion, raw_engine_of_meta);
   deleted_region_meta_ =
       new MetaDiskMap<pb::coordinator_internal::RegionInternal>(kPrefixDeletedRegion, raw_engine_of_meta);
   region_metrics_meta_ =
-      new MetaMemMapFlat<pb::common::RegionMetrics>(&region_metrics_map_, kPrefixRegionMetrics, raw_engine_of_meta);
+      new MetaMemMapSharded<pb::common::RegionMetrics>(&region_metrics_map_, kPrefixRegionMetrics, raw_engine_of_meta);
   table_meta_ =
       new MetaMemMapFlat<pb::coordinator_internal::TableInternal>(&table_map_, kPrefixTable, raw_engine_of_meta);
   deleted_table_meta_ =
@@ -28,6 +28,7 @@
 #include "butil/status.h"
 #include "common/meta_control.h"
 #include "common/safe_map.h"
+#include "coordinator/balance_scheduler.h"
 #include "coordinator/coordinator_meta_storage.h"
 #include "engine/engine.h"
 #include "engine/snapshot.h"
@@ -576,6 +577,9 @@ class CoordinatorControl : public MetaControl {
   void UpdateRegionState();
   void UpdateClusterReadOnly();
 
+  // balance leaders and regions between stores by load, generate transfer leader and change peer task lists
+  void BalanceSchedule();
+
   // get schemas
   butil::Status GetSchemas(int64_t schema_id, std::vector<pb::meta::Schema> &schemas);
 
@@ -646,9 +650,17 @@ class CoordinatorControl : public MetaControl {
   butil::Status GetIndexMetrics(int64_t schema_id, int64_t index_id, pb::meta::IndexMetricsWithId &index_metrics);
 
   // update store metrics with new metrics
+  // out: acked_region_metrics_version, the region metrics version accepted, 0 means delta region metrics is rejected
   // return new epoch
   int64_t UpdateStoreMetrics(const pb::common::StoreMetrics &store_metrics,
-                             pb::coordinator_internal::MetaIncrement &meta_increment);
+                             pb::coordinator_internal::MetaIncrement &meta_increment,
+                             int64_t &acked_region_metrics_version);
+
+  // merge delta region metrics into store_region_metrics_map_, only the changed regions and the regions need to
+  // refresh timestamp are used to update region_map
+  int64_t UpdateStoreDeltaMetrics(const pb::common::StoreMetrics &store_metrics,
+                                  pb::coordinator_internal::MetaIncrement &meta_increment,
+                                  int64_t &acked_region_metrics_version);
 
   // drop table
   // in: schema_id
@@ -864,13 +876,13 @@ class CoordinatorControl : public MetaControl {
   DingoSafeMap<std::string, int64_t> schema_name_map_safe_temp_;
 
   // 5.regions
-  DingoSafeMap<int64_t, pb::coordinator_internal::RegionInternal> region_map_;
-  MetaMemMapFlat<pb::coordinator_internal::RegionInternal> *region_meta_;
+  DingoSafeShardedMap<int64_t, pb::coordinator_internal::RegionInternal> region_map_;
+  MetaMemMapSharded<pb::coordinator_internal::RegionInternal> *region_meta_;
   // 5.1 deleted_regions
   MetaDiskMap<pb::coordinator_internal::RegionInternal> *deleted_region_meta_;
   // 5.2 region_metrics, this map does not need to be persisted
-  DingoSafeMap<int64_t, pb::common::RegionMetrics> region_metrics_map_;
-  MetaMemMapFlat<pb::common::RegionMetrics> *region_metrics_meta_;
+  DingoSafeShardedMap<int64_t, pb::common::RegionMetrics> region_metrics_map_;
+  MetaMemMapSharded<pb::common::RegionMetrics> *region_metrics_meta_;
   // 5.3 range->region map
   DingoSafeStdMap<std::string, pb::coordinator_internal::RegionInternal> range_region_map_;
 
@@ -886,6 +898,8 @@ class CoordinatorControl : public MetaControl {
 
   // 7.store_metrics
   std::map<int64_t, pb::common::StoreMetrics> store_region_metrics_map_;
+  // store_id -> accepted region metrics version, base of the next delta region metrics
+  std::map<int64_t, int64_t> store_region_metrics_version_map_;
   bthread_mutex_t store_region_metrics_map_mutex_;
   std::map<int64_t, StoreMetricsSlim> store_metrics_map_;
   bthread_mutex_t store_metrics_map_mutex_;
@@ -931,6 +945,9 @@ class CoordinatorControl : public MetaControl {
   // root schema write to raft
   bool root_schema_writed_to_raft_;
 
+  // balance scheduler, only for leader use, is out of state machine
+  BalanceScheduler balance_scheduler_;
+
   // Read meta data from persistence storage.
   std::shared_ptr<MetaReader> meta_reader_;
   // Write meta data to persistence storage.
@@ -19,7 +19,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -33,6 +35,7 @@
 #include "common/constant.h"
 #include "common/helper.h"
 #include "common/logging.h"
+#include "coordinator/balance_scheduler.h"
 #include "coordinator/coordinator_control.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
@@ -77,6 +80,8 @@ DEFINE_int32(max_send_region_cmd_per_store, 100, "max send region cmd per store"
 
 DEFINE_int64(max_region_count, 40000, "max region of dingo");
 
+DEFINE_bool(enable_balance_scheduler, false, "balance leaders and regions between stores automatically");
+
 // TODO: add epoch logic
 void CoordinatorControl::GetCoordinatorMap(int64_t cluster_id, int64_t& epoch, pb::common::Location& leader_location,
                                            std::vector<pb::common::Location>& locations) {
@@ -3116,6 +3121,89 @@ butil::Status CoordinatorControl::TransferLeaderRegionWithTaskList(
   return butil::Status::OK();
 }
 
+void CoordinatorControl::BalanceSchedule() {
+  if (!FLAGS_enable_balance_scheduler) {
+    return;
+  }
+
+  // regions with running task list are not schedulable
+  std::set<int64_t> task_list_region_ids;
+  {
+    butil::FlatMap<int64_t, pb::coordinator::TaskList> task_list_map_temp;
+    task_list_map_temp.init(1000);
+    if (task_list_map_.GetRawMapCopy(task_list_map_temp) < 0) {
+      DINGO_LOG(ERROR) << "[balance] task_list_map_.GetRawMapCopy failed";
+      return;
+    }
+    for (const auto& task_list : task_list_map_temp) {
+      for (const auto& task : task_list.second.tasks()) {
+        for (const auto& store_operation : task.store_operations()) {
+          for (const auto& region_cmd : store_operation.region_cmds()) {
+            task_list_region_ids.insert(region_cmd.region_id());
+          }
+        }
+      }
+    }
+  }
+
+  std::map<int64_t, StoreMetricsSlim> store_metrics_map;
+  {
+    BAIDU_SCOPED_LOCK(store_metrics_map_mutex_);
+    store_metrics_map = store_metrics_map_;
+  }
+
+  // stores of different type do not share region, balance them separately
+  BalanceSnapshotBuilder builder;
+  pb::common::StoreMap store_map;
+  GetStoreMap(store_map);
+  for (const auto& store : store_map.stores()) {
+    auto it = store_metrics_map.find(store.id());
+    builder.AddStore(store, it != store_metrics_map.end() ? &it->second.store_own_metrics : nullptr);
+  }
+
+  butil::FlatMap<int64_t, pb::coordinator_internal::RegionInternal> region_map_temp;
+  if (region_map_.GetRawMapCopy(region_map_temp) < 0) {
+    DINGO_LOG(ERROR) << "[balance] region_map_.GetRawMapCopy failed";
+    return;
+  }
+
+  for (const auto& it : region_map_temp) {
+    auto region_metrics = region_metrics_map_.GetPtr(it.first);
+    builder.AddRegion(it.second, region_metrics.get(),
+                      task_list_region_ids.find(it.first) != task_list_region_ids.end());
+  }
+  auto snapshots = builder.Build();
+
+  auto options = BalanceOptions::FromFlags();
+  pb::coordinator_internal::MetaIncrement meta_increment;
+  for (const auto& [store_type, snapshot] : snapshots) {
+    auto operations = balance_scheduler_.Schedule(snapshot, options, butil::gettimeofday_ms());
+    for (auto& operation : operations) {
+      butil::Status status;
+      if (operation.type == BalanceOperation::kTransferLeader) {
+        status = ValidateTaskListConflict(operation.region_id, operation.region_id);
+        if (status.ok()) {
+          status = TransferLeaderRegionWithTaskList(operation.region_id, operation.target_store_id, meta_increment);
+        }
+      } else {
+        status = ChangePeerRegionWithTaskList(operation.region_id, operation.new_store_ids, meta_increment);
+      }
+
+      if (!status.ok()) {
+        DINGO_LOG(WARNING) << fmt::format("[balance] {} failed, error: {}", operation.ToString(), status.error_str());
+        balance_scheduler_.CancelOperation(operation);
+      }
+    }
+  }
+
+  if (meta_increment.ByteSizeLong() > 0) {
+    auto status = SubmitMetaIncrementSync(meta_increment);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("[balance] submit meta increment failed, error: {}", status.error_str());
+    }
+  }
+}
+
 butil::Status CoordinatorControl::ValidateTaskListConflict(int64_t region_id, int64_t second_region_id) {
   // check task_list conflict
   butil::FlatMap<int64_t, pb::coordinator::TaskList> task_list_map_temp;
@@ -3888,16 +3976,21 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
                     << store_metrics.region_metrics_map_size();
   }
 
+  // region metrics of this heartbeat are published to region_metrics_map_ by one MultiPut
+  std::vector<int64_t> region_ids_to_update;
+  std::vector<std::shared_ptr<const pb::common::RegionMetrics>> region_metrics_list_to_update;
+
   // update region_map
   for (const auto& it : store_metrics.region_metrics_map()) {
     const auto& region_metrics = it.second;
 
-    pb::coordinator_internal::RegionInternal region_to_update;
-    auto ret = region_map_.Get(region_metrics.id(), region_to_update);
-    if (ret < 0) {
+    // reference the region in region_map_ without copy
+    auto region_ptr = region_map_.GetPtr(region_metrics.id());
+    if (region_ptr == nullptr) {
       DINGO_LOG(ERROR) << "region_to_update is not found in region_map_, region_id = " << region_metrics.id();
       continue;
     }
+    const auto& region_to_update = *region_ptr;
 
     // when region leader change or region state change, we need to update
     // region_map_ or when region last_update_timestamp is too old, we
@@ -3908,19 +4001,20 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
     bool region_metrics_is_not_leader = false;
     bool leader_has_old_epoch = false;
 
-    pb::common::RegionMetrics region_metrics_to_update;
-    auto ret1 = region_metrics_map_.Get(region_metrics.id(), region_metrics_to_update);
-    if (ret1 < 0) {
-      region_metrics_to_update = region_metrics;
-      *(region_metrics_to_update.mutable_region_status()) = GenRegionStatus(region_metrics);
-      region_metrics_map_.Put(region_metrics.id(), region_metrics_to_update);
+    auto old_region_metrics = region_metrics_map_.GetPtr(region_metrics.id());
+    if (old_region_metrics == nullptr) {
+      auto first_region_metrics = std::make_shared<pb::common::RegionMetrics>(region_metrics);
+      *(first_region_metrics->mutable_region_status()) = GenRegionStatus(region_metrics);
+      old_region_metrics = first_region_metrics;
+      region_ids_to_update.push_back(region_metrics.id());
+      region_metrics_list_to_update.push_back(old_region_metrics);
 
       DINGO_LOG(INFO) << "region_metrics_to_update is first time put into region_metrics_map_, region_id = "
                       << region_metrics.id() << ", from store_id: " << store_metrics.id();
     }
 
     // this will update to RegionMetrics
-    pb::common::RegionStatus region_status_to_update = region_metrics_to_update.region_status();
+    pb::common::RegionStatus region_status_to_update = old_region_metrics->region_status();
     region_status_to_update.set_last_update_timestamp(butil::gettimeofday_ms());
 
     // this will update to RegionInternal
@@ -3981,17 +4075,17 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
     }
 
     if (!region_metrics_is_not_leader) {
-      if (region_metrics_to_update.leader_store_id() != store_metrics.id()) {
+      if (old_region_metrics->leader_store_id() != store_metrics.id()) {
         DINGO_LOG(INFO) << "region leader change region_id = " << region_metrics.id()
-                        << " old leader_store_id = " << region_metrics_to_update.leader_store_id()
+                        << " old leader_store_id = " << old_region_metrics->leader_store_id()
                         << " new leader_store_id = " << store_metrics.id();
         need_update_region_metrics = true;
       }
     }
 
-    if (region_metrics_to_update.store_region_state() != region_metrics.store_region_state()) {
+    if (old_region_metrics->store_region_state() != region_metrics.store_region_state()) {
       DINGO_LOG(INFO) << "region state change region_id = " << region_metrics.id()
-                      << " old state = " << region_metrics_to_update.store_region_state()
+                      << " old state = " << old_region_metrics->store_region_state()
                       << " new state = " << region_metrics.store_region_state();
       need_update_region_metrics = true;
     }
@@ -4014,12 +4108,12 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
     // region's state to DELETED, there is no need to update the region's
     // state in region_map, after timeout, we will trigger purge_request
     // to store to purge this region's meta
-    if (region_metrics_to_update.mutable_region_status()->last_update_timestamp() + FLAGS_region_update_timeout * 1000 <
+    if (old_region_metrics->region_status().last_update_timestamp() + FLAGS_region_update_timeout * 1000 <
             butil::gettimeofday_ms() &&
         region_to_update.state() != pb::common::RegionState::REGION_DELETED) {
       DINGO_LOG(DEBUG) << "region last_update_timestamp too old region_id = " << region_metrics.id()
                        << " last_update_timestamp = "
-                       << region_metrics_to_update.region_status().last_update_timestamp()
+                       << old_region_metrics->region_status().last_update_timestamp()
                        << " now = " << butil::gettimeofday_ms();
       need_update_region_metrics = true;
     }
@@ -4060,7 +4154,7 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
 
     if (!(need_update_region_state || need_update_region_definition || need_update_region_metrics)) {
       DINGO_LOG(DEBUG) << "region no need to update region_id = " << region_metrics.id() << " last_update_timestamp = "
-                       << region_metrics_to_update.region_status().last_update_timestamp()
+                       << old_region_metrics->region_status().last_update_timestamp()
                        << " now = " << butil::gettimeofday_ms();
       continue;
     }
@@ -4088,20 +4182,21 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
     }
 
     if (need_update_region_metrics) {
-      region_metrics_to_update = region_metrics;
+      auto region_metrics_to_update = std::make_shared<pb::common::RegionMetrics>(region_metrics);
 
       if (!region_metrics_is_not_leader) {
-        region_metrics_to_update.set_leader_store_id(store_metrics.id());
+        region_metrics_to_update->set_leader_store_id(store_metrics.id());
         region_status_to_update = GenRegionStatus(region_metrics);
       }
 
-      *(region_metrics_to_update.mutable_region_status()) = region_status_to_update;
+      *(region_metrics_to_update->mutable_region_status()) = region_status_to_update;
 
-      region_metrics_map_.Put(region_metrics.id(), region_metrics_to_update);
+      region_ids_to_update.push_back(region_metrics.id());
+      region_metrics_list_to_update.push_back(region_metrics_to_update);
 
       DINGO_LOG(DEBUG) << "UpdateRegionMapAndStoreOperation region_metrics_map_ update region_id = "
                        << region_metrics.id() << " last_update_timestamp = "
-                       << region_metrics_to_update.region_status().last_update_timestamp()
+                       << region_metrics_to_update->region_status().last_update_timestamp()
                        << " now = " << butil::gettimeofday_ms();
     }
 
@@ -4111,12 +4206,18 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
                                                         region_metrics.region_size());
     }
   }
+
+  if (!region_ids_to_update.empty()) {
+    region_metrics_map_.MultiPut(region_ids_to_update, region_metrics_list_to_update);
+  }
 }
 
 int64_t CoordinatorControl::UpdateStoreMetrics(const pb::common::StoreMetrics& store_metrics,
-                                               pb::coordinator_internal::MetaIncrement& meta_increment) {
+                                               pb::coordinator_internal::MetaIncrement& meta_increment,
+                                               int64_t& acked_region_metrics_version) {
   //   int64_t store_map_epoch =
   //   GetPresentId(pb::coordinator_internal::IdEpochType::EPOCH_STORE);
+  acked_region_metrics_version = 0;
   if (store_metrics.id() <= 0) {
     DINGO_LOG(ERROR) << "ERROR: UpdateStoreMetrics store_metrics.id() <= "
                         "0, store_metrics.id() = "
@@ -4124,9 +4225,20 @@ int64_t CoordinatorControl::UpdateStoreMetrics(const pb::common::StoreMetrics& s
     return -1;
   }
 
+  if (store_metrics.is_delta_region_metrics()) {
+    return UpdateStoreDeltaMetrics(store_metrics, meta_increment, acked_region_metrics_version);
+  }
+
   if (store_metrics.region_metrics_map_size() <= 0) {
     DINGO_LOG(DEBUG) << "UpdateStoreMetrics store_metrics.region_metrics_map_size() <= 0, store_id="
                      << store_metrics.id() << ", do not update StoreMetrics";
+    // store without region still need a base for delta region metrics
+    if (!store_metrics.is_partial_region_metrics() && store_metrics.region_metrics_version() > 0) {
+      BAIDU_SCOPED_LOCK(store_region_metrics_map_mutex_);
+      store_region_metrics_map_.insert_or_assign(store_metrics.id(), store_metrics);
+      store_region_metrics_version_map_[store_metrics.id()] = store_metrics.region_metrics_version();
+      acked_region_metrics_version = store_metrics.region_metrics_version();
+    }
     return 0;
   }
 
@@ -4153,6 +4265,12 @@ int64_t CoordinatorControl::UpdateStoreMetrics(const pb::common::StoreMetrics& s
       }
     } else {
       store_region_metrics_map_.insert_or_assign(store_metrics.id(), store_metrics);
+
+      // full region metrics is the new base of delta region metrics
+      if (store_metrics.region_metrics_version() > 0) {
+        store_region_metrics_version_map_[store_metrics.id()] = store_metrics.region_metrics_version();
+        acked_region_metrics_version = store_metrics.region_metrics_version();
+      }
     }
   }
 
@@ -4169,6 +4287,88 @@ int64_t CoordinatorControl::UpdateStoreMetrics(const pb::common::StoreMetrics& s
   return 0;
 }
 
+int64_t CoordinatorControl::UpdateStoreDeltaMetrics(const pb::common::StoreMetrics& store_metrics,
+                                                    pb::coordinator_internal::MetaIncrement& meta_increment,
+                                                    int64_t& acked_region_metrics_version) {
+  // the regions to process by UpdateRegionMapAndStoreOperation, include the changed regions and the unchanged
+  // regions whose region metrics in region_metrics_map_ is too old, unchanged regions are not reported by delta
+  // heartbeat, so refresh them from the merged region metrics of store.
+  pb::common::StoreMetrics store_metrics_to_process;
+  store_metrics_to_process.set_id(store_metrics.id());
+  *store_metrics_to_process.mutable_store_own_metrics() = store_metrics.store_own_metrics();
+  store_metrics_to_process.set_is_update_epoch_version(store_metrics.is_update_epoch_version());
+  auto* region_metrics_map_to_process = store_metrics_to_process.mutable_region_metrics_map();
+
+  int64_t region_num = 0;
+  {
+    BAIDU_SCOPED_LOCK(store_region_metrics_map_mutex_);
+    auto version_it = store_region_metrics_version_map_.find(store_metrics.id());
+    auto it = store_region_metrics_map_.find(store_metrics.id());
+    if (version_it == store_region_metrics_version_map_.end() || it == store_region_metrics_map_.end() ||
+        version_it->second != store_metrics.base_region_metrics_version()) {
+      DINGO_LOG(WARNING) << fmt::format(
+          "[heartbeat.delta][store({})] base version({}) not match coordinator version({}), need full region metrics",
+          store_metrics.id(), store_metrics.base_region_metrics_version(),
+          version_it == store_region_metrics_version_map_.end() ? 0 : version_it->second);
+      return 0;
+    }
+
+    auto& merged_store_metrics = it->second;
+    *merged_store_metrics.mutable_store_own_metrics() = store_metrics.store_own_metrics();
+    auto* merged_region_metrics_map = merged_store_metrics.mutable_region_metrics_map();
+    for (auto region_id : store_metrics.deleted_region_ids()) {
+      merged_region_metrics_map->erase(region_id);
+    }
+    for (const auto& [region_id, region_metrics] : store_metrics.region_metrics_map()) {
+      (*merged_region_metrics_map)[region_id] = region_metrics;
+    }
+
+    auto now = butil::gettimeofday_ms();
+    for (const auto& [region_id, region_metrics] : *merged_region_metrics_map) {
+      if (store_metrics.region_metrics_map().count(region_id) > 0) {
+        (*region_metrics_map_to_process)[region_id] = region_metrics;
+        continue;
+      }
+
+      auto old_region_metrics = region_metrics_map_.GetPtr(region_id);
+      if (old_region_metrics == nullptr ||
+          old_region_metrics->region_status().last_update_timestamp() + FLAGS_region_update_timeout * 1000 < now) {
+        (*region_metrics_map_to_process)[region_id] = region_metrics;
+      }
+    }
+
+    region_num = merged_region_metrics_map->size();
+    version_it->second = store_metrics.region_metrics_version();
+    acked_region_metrics_version = store_metrics.region_metrics_version();
+  }
+
+  {
+    BAIDU_SCOPED_LOCK(store_metrics_map_mutex_);
+    StoreMetricsSlim store_metrics_slim;
+    store_metrics_slim.store_id = store_metrics.id();
+    store_metrics_slim.store_own_metrics = store_metrics.store_own_metrics();
+    store_metrics_slim.region_num = region_num;
+
+    store_metrics_map_.insert_or_assign(store_metrics.id(), std::move(store_metrics_slim));
+  }
+
+  // mbvar store
+  coordinator_bvar_metrics_store_.UpdateStoreBvar(store_metrics.id(),
+                                                  store_metrics.store_own_metrics().system_total_capacity(),
+                                                  store_metrics.store_own_metrics().system_free_capacity());
+
+  DINGO_LOG(INFO) << fmt::format(
+      "[heartbeat.delta][store({})] version({}) changed region({}) deleted region({}) refresh region({}) total({})",
+      store_metrics.id(), store_metrics.region_metrics_version(), store_metrics.region_metrics_map_size(),
+      store_metrics.deleted_region_ids_size(), region_metrics_map_to_process->size(), region_num);
+
+  if (!region_metrics_map_to_process->empty()) {
+    UpdateRegionMapAndStoreOperation(store_metrics_to_process, meta_increment);
+  }
+
+  return 0;
+}
+
 void CoordinatorControl::GetMemoryInfo(pb::coordinator::CoordinatorMemoryInfo& memory_info) {
   // compute size
   memory_info.set_id_epoch_safe_map_temp_count(id_epoch_map_safe_temp_.Size());
@@ -642,6 +642,33 @@ class MetaDiskMap {
     return butil::Status::OK();
   }
 
+  // Scan elements in id range [start_id, end_id), if end_id is empty scan to the end, at most limit elements.
+  butil::Status ScanElements(const std::string &start_id, const std::string &end_id, int64_t limit,
+                             std::vector<T> &elements) {
+    IteratorOptions options;
+    options.lower_bound = GenKey(start_id);
+    options.upper_bound = end_id.empty() ? internal_prefix + "~" : GenKey(end_id);
+
+    auto iter = raw_engine_->Reader()->NewIterator(Constant::kStoreMetaCF, options);
+    if (iter == nullptr) {
+      DINGO_LOG(ERROR) << fmt::format("Meta new iterator failed, prefix: {}", internal_prefix);
+      return butil::Status(pb::error::EINTERNAL, "Meta new iterator failed");
+    }
+
+    for (iter->Seek(options.lower_bound); iter->Valid() && static_cast<int64_t>(elements.size()) < limit;
+         iter->Next()) {
+      T element;
+      if (!element.ParsePartialFromString(std::string(iter->Value()))) {
+        DINGO_LOG(ERROR) << fmt::format("Meta parse value failed, key: {}", iter->Key());
+        return butil::Status(pb::error::EINTERNAL, "Meta parse value failed");
+      }
+
+      elements.push_back(element);
+    }
+
+    return butil::Status::OK();
+  }
+
   MetaDiskMap(const MetaDiskMap &) = delete;
   const MetaDiskMap &operator=(const MetaDiskMap &) = delete;
 
@@ -651,11 +678,12 @@ class MetaDiskMap {
 
 // MetaMemMapFlat is a template class for meta storage
 // This is for read/write meta data from/to RocksDB storage
-template <typename T>
+// T_MAP is the memory map of elements, DingoSafeMap or DingoSafeShardedMap
+template <typename T, typename T_MAP = DingoSafeMap<int64_t, T>>
 class MetaMemMapFlat {
  public:
   const std::string internal_prefix;
-  MetaMemMapFlat(DingoSafeMap<int64_t, T> *elements, const std::string &prefix, std::shared_ptr<RawEngine> raw_engine)
+  MetaMemMapFlat(T_MAP *elements, const std::string &prefix, std::shared_ptr<RawEngine> raw_engine)
       : internal_prefix(std::string("METAFLT") + prefix), raw_engine_(raw_engine), elements_(elements){};
   ~MetaMemMapFlat() = default;
 
@@ -904,9 +932,13 @@ class MetaMemMapFlat {
 
  private:
   std::shared_ptr<RawEngine> raw_engine_;
-  DingoSafeMap<int64_t, T> *elements_;
+  T_MAP *elements_;
 };
 
+// MetaMemMapSharded is MetaMemMapFlat with sharded memory map, for the big and frequently updated maps
+template <typename T>
+using MetaMemMapSharded = MetaMemMapFlat<T, DingoSafeShardedMap<int64_t, T>>;
+
 // MetaMemMapStd is a template class for meta storage
 // This is for read/write meta data from/to RocksDB storage
 template <typename T>
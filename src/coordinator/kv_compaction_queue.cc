@@ -0,0 +1,96 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coordinator/kv_compaction_queue.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+
+namespace dingodb {
+
+bool KvCompactionQueue::Add(int64_t revision, const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = latest_revisions_.find(key);
+  if (it != latest_revisions_.end()) {
+    // The entry in queue_ keeps the older revision, it is moved to the latest revision when popped.
+    if (revision > it->second) {
+      it->second = revision;
+    }
+    return true;
+  }
+
+  if (max_size_ > 0 && static_cast<int64_t>(latest_revisions_.size()) >= max_size_) {
+    if (!need_full_scan_.load(std::memory_order_relaxed)) {
+      DINGO_LOG(WARNING) << fmt::format("[kv.compaction] queue is overflow, size({}), will do full scan",
+                                        latest_revisions_.size());
+    }
+    need_full_scan_.store(true, std::memory_order_release);
+    return false;
+  }
+
+  latest_revisions_.emplace(key, revision);
+  queue_.emplace(revision, key);
+
+  return true;
+}
+
+void KvCompactionQueue::Pop(int64_t compact_revision, size_t limit, std::vector<std::string>& keys) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  while (!queue_.empty() && keys.size() < limit) {
+    auto it = queue_.begin();
+    if (it->first >= compact_revision) {
+      break;
+    }
+
+    auto node = queue_.extract(it);
+    auto& key = node.value().second;
+
+    auto latest_it = latest_revisions_.find(key);
+    if (latest_it != latest_revisions_.end() && latest_it->second >= compact_revision) {
+      // Key got newer garbage which can't be compacted now, keep it with the latest revision.
+      node.value().first = latest_it->second;
+      keys.push_back(key);
+      queue_.insert(std::move(node));
+      continue;
+    }
+
+    if (latest_it != latest_revisions_.end()) {
+      latest_revisions_.erase(latest_it);
+    }
+    keys.push_back(std::move(key));
+  }
+}
+
+int64_t KvCompactionQueue::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return latest_revisions_.size();
+}
+
+void KvCompactionQueue::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  queue_.clear();
+  latest_revisions_.clear();
+  need_full_scan_.store(true, std::memory_order_release);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,75 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COORDINATOR_KV_COMPACTION_QUEUE_H_
+#define DINGODB_COORDINATOR_KV_COMPACTION_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dingodb {
+
+// Keys which have old revisions to be compacted, ordered by the revision which made the old revisions garbage.
+// A key is eligible for compaction when its revision is less than the compact revision, so compaction cost is
+// proportional to the garbage instead of the total key count.
+// The queue is out of state machine, it is filled by raft apply and rebuilt by full scan after restart or snapshot
+// install, or after the queue is overflow.
+class KvCompactionQueue {
+ public:
+  explicit KvCompactionQueue(int64_t max_size) : max_size_(max_size) {}
+  ~KvCompactionQueue() = default;
+
+  KvCompactionQueue(const KvCompactionQueue&) = delete;
+  KvCompactionQueue& operator=(const KvCompactionQueue&) = delete;
+
+  // Add key with the main revision which made its old revisions garbage.
+  // If key already exists, only the latest revision is kept.
+  // Return false if queue is overflow, then a full scan is needed.
+  bool Add(int64_t revision, const std::string& key);
+
+  // Pop at most limit keys whose revision is less than compact_revision, in revision order.
+  // If key got new revision not less than compact_revision, it stays in queue with the new revision.
+  void Pop(int64_t compact_revision, size_t limit, std::vector<std::string>& keys);
+
+  int64_t Size();
+  int64_t MaxSize() const { return max_size_; }
+
+  // Drop all keys, a full scan is needed after clear.
+  void Clear();
+
+  bool NeedFullScan() const { return need_full_scan_.load(std::memory_order_acquire); }
+  void SetNeedFullScan(bool need_full_scan) { need_full_scan_.store(need_full_scan, std::memory_order_release); }
+
+ private:
+  int64_t max_size_;
+
+  std::mutex mutex_;
+  // min-heap of (revision, key)
+  std::set<std::pair<int64_t, std::string>> queue_;
+  // key -> latest revision
+  std::unordered_map<std::string, int64_t> latest_revisions_;
+
+  // the keys before process start are unknown, so full scan is needed at first
+  std::atomic<bool> need_full_scan_{true};
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COORDINATOR_KV_COMPACTION_QUEUE_H_
@@ -34,6 +34,7 @@
 #include "coordinator/coordinator_control.h"
 #include "coordinator/coordinator_meta_storage.h"
 #include "coordinator/coordinator_prefix.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/coordinator_internal.pb.h"
 #include "proto/meta.pb.h"
@@ -41,12 +42,24 @@
 
 namespace dingodb {
 
+DECLARE_int64(version_watch_event_ring_size);
+DECLARE_int64(compaction_queue_max_size);
+
 KvControl::KvControl(std::shared_ptr<MetaReader> meta_reader, std::shared_ptr<MetaWriter> meta_writer,
                      std::shared_ptr<RawEngine> raw_engine_of_meta)
-    : meta_reader_(meta_reader), meta_writer_(meta_writer), leader_term_(-1), raw_engine_of_meta_(raw_engine_of_meta) {
+    : compaction_queue_(FLAGS_compaction_queue_max_size),
+      watch_event_ring_(FLAGS_version_watch_event_ring_size),
+      watch_stream_handler_(this),
+      meta_reader_(meta_reader),
+      meta_writer_(meta_writer),
+      leader_term_(-1),
+      raw_engine_of_meta_(raw_engine_of_meta) {
   // init bthread mutex
   bthread_mutex_init(&lease_to_key_map_temp_mutex_, nullptr);
   bthread_mutex_init(&one_time_watch_map_mutex_, nullptr);
+  bthread_mutex_init(&stream_watchers_mutex_, nullptr);
+  bthread_mutex_init(&dispatcher_mutex_, nullptr);
+  bthread_cond_init(&dispatcher_cond_, nullptr);
   leader_term_.store(-1, butil::memory_order_release);
 
   // the data structure below will write to raft
@@ -68,6 +81,24 @@ KvControl::KvControl(std::shared_ptr<MetaReader> meta_reader, std::shared_ptr<Me
 }
 
 KvControl::~KvControl() {
+  // stop stream watch dispatcher
+  if (is_dispatcher_started_.load()) {
+    {
+      BAIDU_SCOPED_LOCK(dispatcher_mutex_);
+      is_dispatcher_stop_.store(true);
+      bthread_cond_signal(&dispatcher_cond_);
+    }
+    bthread_join(dispatcher_tid_, nullptr);
+
+    // catch up bthreads exit after dispatcher stop
+    while (catch_up_watcher_count_.load() > 0) {
+      bthread_usleep(1000);
+    }
+  }
+  bthread_cond_destroy(&dispatcher_cond_);
+  bthread_mutex_destroy(&dispatcher_mutex_);
+  bthread_mutex_destroy(&stream_watchers_mutex_);
+
   delete id_epoch_meta_;
   delete kv_lease_meta_;
   delete kv_index_meta_;
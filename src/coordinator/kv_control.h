@@ -25,12 +25,15 @@
 #include <string>
 #include <vector>
 
+#include "brpc/stream.h"
 #include "bthread/types.h"
 #include "butil/containers/flat_map.h"
 #include "butil/status.h"
 #include "common/meta_control.h"
 #include "common/safe_map.h"
 #include "coordinator/coordinator_meta_storage.h"
+#include "coordinator/kv_compaction_queue.h"
+#include "coordinator/kv_event_ring.h"
 #include "engine/engine.h"
 #include "engine/snapshot.h"
 #include "google/protobuf/stubs/callback.h"
@@ -125,6 +128,52 @@ class DeferDone {
   int64_t create_time_;
 };
 
+// Long-lived watcher over brpc stream, events are pushed to stream in revision order.
+struct KvStreamWatcher {
+  uint64_t watch_id{0};
+  brpc::StreamId stream_id{brpc::INVALID_STREAM_ID};
+
+  // watch range [key, range_end), range_end is empty means only watch key, "\0" means all keys >= key.
+  std::string key;
+  std::string range_end;
+
+  bool no_put_event{false};
+  bool no_delete_event{false};
+  bool need_prev_kv{false};
+  bool progress_notify{false};
+
+  // The revision of next event to send, only accessed by dispatcher, or by catch up bthread when is_catching_up.
+  KvEventRevision next_revision;
+  // Storage has no revision from it, need not catch up again when ring is empty, accessed like next_revision.
+  KvEventRevision storage_end_revision{-1, 0};
+  int64_t last_send_time_ms{0};
+
+  // Stream is writable after the rpc response is sent.
+  std::atomic<bool> is_ready{false};
+  std::atomic<bool> is_closed{false};
+  // Watcher fell behind the ring is catching up from storage in its own bthread, dispatcher skip it.
+  std::atomic<bool> is_catching_up{false};
+
+  bool IsMatch(const pb::version::Event &event) const;
+};
+using KvStreamWatcherPtr = std::shared_ptr<KvStreamWatcher>;
+
+class KvControl;
+
+// Remove stream watcher when client close the stream.
+class KvWatchStreamHandler : public brpc::StreamInputHandler {
+ public:
+  explicit KvWatchStreamHandler(KvControl *kv_control) : kv_control_(kv_control) {}
+  ~KvWatchStreamHandler() override = default;
+
+  int on_received_messages(brpc::StreamId id, butil::IOBuf *const messages[], size_t size) override;
+  void on_idle_timeout(brpc::StreamId id) override;
+  void on_closed(brpc::StreamId id) override;
+
+ private:
+  KvControl *kv_control_;
+};
+
 struct KvLeaseWithKeys {
   pb::coordinator_internal::LeaseInternal lease;
   std::set<std::string> keys;
@@ -221,7 +270,7 @@ class KvControl : public MetaControl {
   // lease timeout/revoke task
   void LeaseTask();
 
-  // lease timeout/revoke task
+  // compact the old revisions of keys in compaction queue, in bounded batches
   void CompactionTask();
 
   // lease
@@ -338,7 +387,26 @@ class KvControl : public MetaControl {
   butil::Status TriggerOneWatch(const std::string &key, pb::version::Event::EventType event_type,
                                 pb::version::Kv &new_kv, pb::version::Kv &prev_kv);
 
+  // streaming watch functions for api
+  // the stream is accepted by this function, events are pushed to the stream until it is closed or canceled
+  // if start_revision is compacted, return EWATCH_REVISION_COMPACTED and compact_revision
+  butil::Status StreamWatch(const pb::version::WatchCreateRequest &create_request, brpc::Controller *cntl,
+                            uint64_t &watch_id, int64_t &start_revision, int64_t &compact_revision);
+  // start push events after the response of StreamWatch is sent
+  void StartStreamWatch(uint64_t watch_id);
+  butil::Status CancelStreamWatch(uint64_t watch_id);
+  void RemoveStreamWatch(brpc::StreamId stream_id);
+  void CloseAllStreamWatch();
+
+  // append event to ring and wake up dispatcher, called by raft fsm
+  void AppendWatchEvent(const pb::coordinator_internal::RevisionInternal &op_revision,
+                        pb::version::Event::EventType event_type, const pb::version::Kv &new_kv,
+                        const pb::version::Kv &prev_kv);
+  void ClearWatchEvent();
+
  private:
+  friend class KvControlWatchTest;
+
   // ids_epochs_temp (out of state machine, only for leader use)
   DingoSafeIdEpochMap id_epoch_map_safe_temp_;
 
@@ -361,6 +429,10 @@ class KvControl : public MetaControl {
   // 16.version kv multi revision
   MetaDiskMap<pb::coordinator_internal::KvRevInternal> *kv_rev_meta_;
 
+  // keys which have old revisions to compact, this queue is out of state machine
+  KvCompactionQueue compaction_queue_;
+  void BuildCompactionQueue();
+
   // one time watch map
   // this map on work on leader, is out of state machine
   std::map<std::string, std::map<uint64_t, KvWatchNode>> one_time_watch_map_;
@@ -369,6 +441,46 @@ class KvControl : public MetaControl {
   std::atomic<uint64_t> one_time_watch_closure_seq_{1000};  // used to generate unique closure id
   DingoSafeStdMap<uint64_t, bool> one_time_watch_closure_status_map_;
 
+  // streaming watch
+  // dispatch events of ring to all stream watchers
+  butil::Status AddStreamWatcher(KvStreamWatcherPtr watcher, int64_t request_watch_id);
+  butil::Status CheckStreamWatchRevision(int64_t revision, int64_t &compact_revision);
+  void StartStreamWatchDispatcher();
+  void StreamWatchDispatchLoop();
+  void DispatchStreamWatch(bool is_timeout);
+  bool DispatchStreamWatcher(KvStreamWatcherPtr watcher, bool is_timeout);
+  // catch up the watcher which fell behind the ring, every lagging watcher has its own bthread
+  void StartCatchUpStreamWatcher(KvStreamWatcherPtr watcher);
+  void CatchUpStreamWatcher(KvStreamWatcherPtr watcher);
+  butil::Status ReadCatchUpEvents(KvStreamWatcherPtr watcher, size_t limit, std::vector<pb::version::Event> &events,
+                                  KvEventRevision &next_revision, int64_t &compact_revision);
+  // return 0 if sent, EAGAIN if stream is full, otherwise the stream is closed
+  int SendStreamWatchEvents(KvStreamWatcherPtr watcher, std::vector<pb::version::Event> &events,
+                            const KvEventRevision &next_revision);
+  void SendStreamWatchCompacted(KvStreamWatcherPtr watcher, int64_t compact_revision);
+  // only keep events in ring when there is stream watcher
+  bool NeedAppendWatchEvent();
+  butil::Status ReadWatchEventsFromStorage(const KvEventRevision &revision, const KvEventRevision *end_revision,
+                                           const KvEventRing::FilterFunc &filter, size_t limit,
+                                           std::vector<pb::version::Event> &events, KvEventRevision &next_revision);
+
+  // latest events, this ring is out of state machine
+  KvEventRing watch_event_ring_;
+  KvWatchStreamHandler watch_stream_handler_;
+  std::map<uint64_t, KvStreamWatcherPtr> stream_watchers_;
+  bthread_mutex_t stream_watchers_mutex_;
+  std::atomic<uint64_t> stream_watch_id_seq_{1};
+  std::atomic<int64_t> stream_watcher_count_{0};
+  std::atomic<int64_t> catch_up_watcher_count_{0};
+
+  // dispatcher is started when the first stream watcher is created
+  std::atomic<bool> is_dispatcher_started_{false};
+  std::atomic<bool> is_dispatcher_stop_{false};
+  bthread_t dispatcher_tid_{0};
+  bthread_mutex_t dispatcher_mutex_;
+  bthread_cond_t dispatcher_cond_;
+  uint64_t dispatcher_notify_seq_{0};
+
   // Read meta data from persistence storage.
   std::shared_ptr<MetaReader> meta_reader_;
   // Write meta data to persistence storage.
@@ -107,6 +107,9 @@ void KvControl::OnLeaderStop() {
     one_time_watch_closure_map_.clear();
   }
 
+  // close stream watch, client will re-watch on new leader
+  CloseAllStreamWatch();
+
   DINGO_LOG(INFO) << "OnLeaderStop finished";
 }
 
@@ -176,6 +179,11 @@ bool KvControl::LoadMetaToSnapshotFile(std::shared_ptr<Snapshot> snapshot,
 bool KvControl::LoadMetaFromSnapshotFile(pb::coordinator_internal::MetaSnapshotFile& meta_snapshot_file) {
   DINGO_LOG(INFO) << "Coordinator start to LoadMetaFromSnapshotFile";
 
+  // events between the ring and snapshot are lost, watchers catch up from storage
+  ClearWatchEvent();
+  // keys to compact are unknown after snapshot install, rebuild by full scan
+  compaction_queue_.Clear();
+
   std::vector<pb::common::KeyValue> kvs;
 
   // 0.id_epoch map
@@ -26,6 +26,7 @@
 #include <utility>
 #include <vector>
 
+#include "bthread/bthread.h"
 #include "butil/status.h"
 #include "common/helper.h"
 #include "common/logging.h"
@@ -43,8 +44,25 @@ DEFINE_int64(max_kv_key_size, 4096, "max kv put count");
 DEFINE_int64(max_kv_value_size, 8192, "max kv put count");
 DEFINE_int64(compaction_retention_rev_count, 1000, "max revision count retention for compaction");
 DEFINE_bool(auto_compaction, false, "auto compaction on/off");
+DEFINE_int64(compaction_batch_size, 50, "max key count of one compaction raft proposal");
+DEFINE_int64(compaction_max_keys_per_round, 10000, "max key count compacted in one compaction task round");
+DEFINE_int64(compaction_batch_interval_ms, 10, "sleep interval between compaction batches");
+DEFINE_int64(compaction_queue_max_size, 1000000, "max key count of compaction queue, full scan when overflow");
 DEFINE_int64(version_kv_max_count, 100000, "max kv count for version kv");
 
+// The kv_index has revisions which can be removed by compaction, e.g. history generations, non-latest revisions
+// of the latest generation, or the latest generation is a tombstone.
+static bool IsKvIndexCompactable(const pb::coordinator_internal::KvIndexInternal &kv_index) {
+  if (kv_index.generations_size() > 1) {
+    return true;
+  }
+  if (kv_index.generations_size() == 1) {
+    const auto &generation = kv_index.generations(0);
+    return !generation.has_create_revision() || generation.revisions_size() > 1;
+  }
+  return false;
+}
+
 std::string KvControl::RevisionToString(const pb::coordinator_internal::RevisionInternal &revision) {
   Buf buf(17);
   buf.WriteLong(revision.main());
@@ -662,10 +680,18 @@ butil::Status KvControl::KvPutApply(const std::string &key,
   }
   DINGO_LOG(INFO) << "KvPutApply PutRawKvIndex success, key: " << key << ", kv_index: " << kv_index.ShortDebugString();
 
+  if (IsKvIndexCompactable(kv_index)) {
+    compaction_queue_.Add(op_revision.main(), key);
+  }
+
   // trigger watch
-  if (!one_time_watch_map_.empty()) {
-    DINGO_LOG(INFO) << "KvPutApply one_time_watch_map_ is not empty, will trigger watch, key: " << key
-                    << ", watch size: " << one_time_watch_map_.size();
+  bool need_one_time_watch = !one_time_watch_map_.empty();
+  bool need_stream_watch = NeedAppendWatchEvent();
+  if (need_one_time_watch || need_stream_watch) {
+    if (need_one_time_watch) {
+      DINGO_LOG(INFO) << "KvPutApply one_time_watch_map_ is not empty, will trigger watch, key: " << key
+                      << ", watch size: " << one_time_watch_map_.size();
+    }
 
     if (prev_kv.create_revision() > 0) {
       prev_kv.set_lease(kv_rev_last.kv().lease());
@@ -679,7 +705,13 @@ butil::Status KvControl::KvPutApply(const std::string &key,
     new_kv.mutable_kv()->set_key(key);
     new_kv.mutable_kv()->set_value(kv_rev.kv().value());
 
-    TriggerOneWatch(key, pb::version::Event::EventType::Event_EventType_PUT, new_kv, prev_kv);
+    if (need_stream_watch) {
+      AppendWatchEvent(op_revision, pb::version::Event::EventType::Event_EventType_PUT, new_kv, prev_kv);
+    }
+
+    if (need_one_time_watch) {
+      TriggerOneWatch(key, pb::version::Event::EventType::Event_EventType_PUT, new_kv, prev_kv);
+    }
   }
 
   DINGO_LOG(INFO) << "KvPutApply success after trigger watch, key: " << key
@@ -790,10 +822,18 @@ butil::Status KvControl::KvDeleteApply(const std::string &key,
 
   DINGO_LOG(INFO) << "KvDeleteApply success, key: " << key << ", revision: " << op_revision.ShortDebugString();
 
+  if (IsKvIndexCompactable(kv_index)) {
+    compaction_queue_.Add(op_revision.main(), key);
+  }
+
   // trigger watch
-  if (!one_time_watch_map_.empty()) {
-    DINGO_LOG(INFO) << "KvDeleteApply one_time_watch_map_ is not empty, will trigger watch, key: " << key
-                    << ", watch size: " << one_time_watch_map_.size();
+  bool need_one_time_watch = !one_time_watch_map_.empty();
+  bool need_stream_watch = NeedAppendWatchEvent();
+  if (need_one_time_watch || need_stream_watch) {
+    if (need_one_time_watch) {
+      DINGO_LOG(INFO) << "KvDeleteApply one_time_watch_map_ is not empty, will trigger watch, key: " << key
+                      << ", watch size: " << one_time_watch_map_.size();
+    }
 
     if (prev_kv.create_revision() > 0) {
       prev_kv.set_lease(kv_rev_last.kv().lease());
@@ -807,7 +847,13 @@ butil::Status KvControl::KvDeleteApply(const std::string &key,
     new_kv.mutable_kv()->set_key(key);
     new_kv.mutable_kv()->set_value(kv_rev.kv().value());
 
-    TriggerOneWatch(key, pb::version::Event::EventType::Event_EventType_DELETE, new_kv, prev_kv);
+    if (need_stream_watch) {
+      AppendWatchEvent(op_revision, pb::version::Event::EventType::Event_EventType_DELETE, new_kv, prev_kv);
+    }
+
+    if (need_one_time_watch) {
+      TriggerOneWatch(key, pb::version::Event::EventType::Event_EventType_DELETE, new_kv, prev_kv);
+    }
   }
 
   DINGO_LOG(INFO) << "KvDeleteApply success after trigger watch, key: " << key
@@ -816,6 +862,31 @@ butil::Status KvControl::KvDeleteApply(const std::string &key,
   return butil::Status::OK();
 }
 
+void KvControl::BuildCompactionQueue() {
+  // reset flag before scan, so the overflow during scan can be detected
+  compaction_queue_.SetNeedFullScan(false);
+
+  std::vector<std::string> keys;
+  std::vector<pb::coordinator_internal::KvIndexInternal> kv_indexes;
+  auto ret = kv_index_map_.GetAllKeyValues(keys, kv_indexes, [](pb::coordinator_internal::KvIndexInternal kv_index) {
+    return IsKvIndexCompactable(kv_index);
+  });
+  if (ret < 0) {
+    DINGO_LOG(ERROR) << "kv_index_map_ GetAllKeyValues failed";
+    compaction_queue_.SetNeedFullScan(true);
+    return;
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!compaction_queue_.Add(kv_indexes[i].mod_revision().main(), keys[i])) {
+      break;
+    }
+  }
+
+  DINGO_LOG(INFO) << "build compaction queue finished, compactable keys_count=" << keys.size()
+                  << ", queue_size=" << compaction_queue_.Size();
+}
+
 void KvControl::CompactionTask() {
   DINGO_LOG(INFO) << "compaction task start";
 
@@ -824,14 +895,6 @@ void KvControl::CompactionTask() {
     return;
   }
 
-  // get all keys in kv_index_map_
-  std::vector<std::string> keys;
-  auto ret = kv_index_map_.GetAllKeys(keys);
-  if (ret < 0) {
-    DINGO_LOG(ERROR) << "kv_index_map_ GetAllKeys failed";
-    return;
-  }
-
   // build revision struct
   pb::coordinator_internal::RevisionInternal compact_revision;
 
@@ -846,33 +909,44 @@ void KvControl::CompactionTask() {
 
   compact_revision.set_sub(0);
 
-  // do compaction for each key
-  std::vector<std::string> keys_to_compact;
-  for (const auto &key : keys) {
-    if (keys_to_compact.size() < 50) {
-      keys_to_compact.push_back(key);
-    } else {
-      auto ret = KvCompact(keys_to_compact, compact_revision);
-      if (!ret.ok()) {
-        DINGO_LOG(ERROR) << "KvCompact failed, error: " << ret.error_str() << ", keys size: " << keys_to_compact.size();
-        for (const auto &key : keys_to_compact) {
-          DINGO_LOG(ERROR) << "KvCompact failed, key: " << key;
-        }
-      }
-      keys_to_compact.clear();
-    }
+  // the keys to compact are unknown after restart, snapshot install or queue overflow
+  if (compaction_queue_.NeedFullScan()) {
+    BuildCompactionQueue();
   }
-  if (!keys_to_compact.empty()) {
+
+  // only compact the keys whose garbage revisions are older than compact_revision, in bounded batches
+  int64_t batch_size = std::max(FLAGS_compaction_batch_size, static_cast<int64_t>(1));
+  int64_t compacted_count = 0;
+  while (compacted_count < FLAGS_compaction_max_keys_per_round) {
+    std::vector<std::string> keys_to_compact;
+    compaction_queue_.Pop(compact_revision.main(),
+                          std::min(batch_size, FLAGS_compaction_max_keys_per_round - compacted_count),
+                          keys_to_compact);
+    if (keys_to_compact.empty()) {
+      break;
+    }
+
     auto ret = KvCompact(keys_to_compact, compact_revision);
     if (!ret.ok()) {
       DINGO_LOG(ERROR) << "KvCompact failed, error: " << ret.error_str() << ", keys size: " << keys_to_compact.size();
       for (const auto &key : keys_to_compact) {
         DINGO_LOG(ERROR) << "KvCompact failed, key: " << key;
+        // retry in next round
+        compaction_queue_.Add(compact_revision.main() - 1, key);
       }
+      break;
+    }
+
+    compacted_count += keys_to_compact.size();
+
+    // rate limit, avoid cpu and raft traffic spike
+    if (FLAGS_compaction_batch_interval_ms > 0) {
+      bthread_usleep(FLAGS_compaction_batch_interval_ms * 1000);
     }
   }
 
-  DINGO_LOG(INFO) << "compaction task end, keys_count=" << keys.size();
+  DINGO_LOG(INFO) << "compaction task end, keys_count=" << compacted_count
+                  << ", queue_size=" << compaction_queue_.Size();
 }
 
 static void Done(std::atomic<bool> *done) { done->store(true, std::memory_order_release); }
@@ -891,6 +965,10 @@ butil::Status KvControl::KvCompact(const std::vector<std::string> &keys,
 
   pb::coordinator_internal::MetaIncrement meta_increment;
 
+  // stream watcher from the compacted revision would miss events
+  UpdatePresentId(pb::coordinator_internal::IdEpochType::ID_KV_COMPACT_REVISION, compact_revision.main(),
+                  meta_increment);
+
   for (auto key : keys) {
     auto *kv_index_increment = meta_increment.add_kv_indexes();
     kv_index_increment->set_id(key);
@@ -26,12 +26,18 @@
 #include <vector>
 
 #include "brpc/closure_guard.h"
+#include "brpc/stream.h"
+#include "bthread/bthread.h"
 #include "bthread/mutex.h"
+#include "butil/iobuf.h"
 #include "butil/scoped_lock.h"
 #include "butil/status.h"
 #include "butil/time.h"
+#include "common/helper.h"
 #include "common/logging.h"
 #include "coordinator/kv_control.h"
+#include "coordinator/kv_event_ring.h"
+#include "fmt/core.h"
 #include "gflags/gflags.h"
 #include "proto/coordinator_internal.pb.h"
 #include "proto/version.pb.h"
@@ -39,6 +45,12 @@
 namespace dingodb {
 
 DEFINE_int64(version_watch_max_count, 50000, "max count of version watch");
+DEFINE_int64(version_watch_event_ring_size, 100000, "max event count of watch event ring, 0 means disable ring");
+DEFINE_int64(version_watch_stream_batch_size, 128, "max event count of one stream watch message");
+DEFINE_int64(version_watch_stream_catch_up_batch_size, 1024, "max revision count of one catch up read from storage");
+DEFINE_int64(version_watch_stream_dispatch_interval_ms, 1000,
+             "interval of retry blocked stream watcher and send progress notify");
+DEFINE_int64(version_watch_stream_max_buf_size, 8 * 1024 * 1024, "max unconsumed buffer size of one watch stream");
 
 void WatchCancelCallback(KvControl* kv_control, uint64_t closure_id) {
   kv_control->CancelOneTimeWatchClosure(closure_id);
@@ -358,4 +370,542 @@ butil::Status KvControl::TriggerOneWatch(const std::string& key, pb::version::Ev
   return butil::Status::OK();
 }
 
+bool KvStreamWatcher::IsMatch(const pb::version::Event& event) const {
+  if (no_put_event && event.type() == pb::version::Event::EventType::Event_EventType_PUT) {
+    return false;
+  }
+  if (no_delete_event && event.type() == pb::version::Event::EventType::Event_EventType_DELETE) {
+    return false;
+  }
+
+  const auto& event_key = event.kv().kv().key();
+  if (range_end.empty()) {
+    return event_key == key;
+  }
+  if (range_end == std::string(1, '\0')) {
+    return event_key >= key;
+  }
+  return event_key >= key && event_key < range_end;
+}
+
+int KvWatchStreamHandler::on_received_messages(brpc::StreamId id, butil::IOBuf* const[], size_t size) {
+  DINGO_LOG(WARNING) << fmt::format("[kv.watch][stream_id({})] ignore {} messages from client.", id, size);
+  return 0;
+}
+
+void KvWatchStreamHandler::on_idle_timeout(brpc::StreamId id) {
+  DINGO_LOG(INFO) << fmt::format("[kv.watch][stream_id({})] stream idle timeout.", id);
+}
+
+void KvWatchStreamHandler::on_closed(brpc::StreamId id) { kv_control_->RemoveStreamWatch(id); }
+
+butil::Status KvControl::StreamWatch(const pb::version::WatchCreateRequest& create_request, brpc::Controller* cntl,
+                                     uint64_t& watch_id, int64_t& start_revision, int64_t& compact_revision) {
+  if (stream_watcher_count_.load(std::memory_order_relaxed) >= FLAGS_version_watch_max_count) {
+    return butil::Status(pb::error::Errno::EWATCH_COUNT_EXCEEDS_LIMIT,
+                         "StreamWatch, stream watcher count > FLAGS_version_watch_max_count");
+  }
+
+  auto watcher = std::make_shared<KvStreamWatcher>();
+  watcher->key = create_request.key();
+  watcher->range_end = create_request.range_end();
+  watcher->need_prev_kv = create_request.need_prev_kv();
+  watcher->progress_notify = create_request.progress_notify();
+  for (const auto& filter : create_request.filters()) {
+    if (filter == pb::version::EventFilterType::NOPUT) {
+      watcher->no_put_event = true;
+    } else if (filter == pb::version::EventFilterType::NODELETE) {
+      watcher->no_delete_event = true;
+    }
+  }
+
+  start_revision = create_request.start_revision();
+  if (start_revision <= 0) {
+    start_revision = GetPresentId(pb::coordinator_internal::IdEpochType::ID_NEXT_REVISION);
+  }
+  auto status = CheckStreamWatchRevision(start_revision, compact_revision);
+  if (!status.ok()) {
+    return status;
+  }
+  watcher->next_revision = KvEventRevision{start_revision, 0};
+
+  brpc::StreamOptions options;
+  options.handler = &watch_stream_handler_;
+  options.max_buf_size = FLAGS_version_watch_stream_max_buf_size;
+  if (brpc::StreamAccept(&watcher->stream_id, *cntl, &options) != 0) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "StreamWatch, accept stream failed");
+  }
+
+  status = AddStreamWatcher(watcher, create_request.watch_id());
+  if (!status.ok()) {
+    brpc::StreamClose(watcher->stream_id);
+    return status;
+  }
+  watch_id = watcher->watch_id;
+
+  DINGO_LOG(INFO) << fmt::format(
+      "[kv.watch][watch_id({})][stream_id({})] add stream watcher, key: {}, range_end: {}, start_revision: {}",
+      watch_id, watcher->stream_id, Helper::StringToHex(watcher->key), Helper::StringToHex(watcher->range_end),
+      start_revision);
+
+  StartStreamWatchDispatcher();
+
+  return butil::Status::OK();
+}
+
+butil::Status KvControl::AddStreamWatcher(KvStreamWatcherPtr watcher, int64_t request_watch_id) {
+  BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+  if (request_watch_id > 0) {
+    watcher->watch_id = request_watch_id;
+    if (stream_watchers_.find(watcher->watch_id) != stream_watchers_.end()) {
+      return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS,
+                           fmt::format("StreamWatch, watch_id {} already exists", watcher->watch_id));
+    }
+  } else {
+    do {
+      watcher->watch_id = stream_watch_id_seq_.fetch_add(1, std::memory_order_relaxed);
+    } while (stream_watchers_.find(watcher->watch_id) != stream_watchers_.end());
+  }
+
+  stream_watchers_.insert_or_assign(watcher->watch_id, watcher);
+  stream_watcher_count_.store(stream_watchers_.size(), std::memory_order_relaxed);
+
+  return butil::Status::OK();
+}
+
+// The revisions before compact revision may be removed, watcher from them would miss events.
+butil::Status KvControl::CheckStreamWatchRevision(int64_t revision, int64_t& compact_revision) {
+  compact_revision = GetPresentId(pb::coordinator_internal::IdEpochType::ID_KV_COMPACT_REVISION);
+  if (revision < compact_revision) {
+    return butil::Status(pb::error::Errno::EWATCH_REVISION_COMPACTED,
+                         fmt::format("watch revision {} is compacted, compact revision {}", revision,
+                                     compact_revision));
+  }
+
+  return butil::Status::OK();
+}
+
+void KvControl::StartStreamWatchDispatcher() {
+  // start dispatcher at the first stream watcher
+  if (is_dispatcher_started_.exchange(true)) {
+    return;
+  }
+
+  int ret = bthread_start_background(
+      &dispatcher_tid_, nullptr,
+      [](void* arg) -> void* {
+        static_cast<KvControl*>(arg)->StreamWatchDispatchLoop();
+        return nullptr;
+      },
+      this);
+  if (ret != 0) {
+    is_dispatcher_started_.store(false);
+    DINGO_LOG(ERROR) << "[kv.watch] start stream watch dispatcher failed, ret: " << ret;
+  }
+}
+
+void KvControl::StartStreamWatch(uint64_t watch_id) {
+  {
+    BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+    auto it = stream_watchers_.find(watch_id);
+    if (it == stream_watchers_.end()) {
+      return;
+    }
+    it->second->is_ready.store(true);
+  }
+
+  // catch up events from start_revision
+  BAIDU_SCOPED_LOCK(dispatcher_mutex_);
+  ++dispatcher_notify_seq_;
+  bthread_cond_signal(&dispatcher_cond_);
+}
+
+butil::Status KvControl::CancelStreamWatch(uint64_t watch_id) {
+  KvStreamWatcherPtr watcher;
+  {
+    BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+    auto it = stream_watchers_.find(watch_id);
+    if (it == stream_watchers_.end()) {
+      return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS,
+                           fmt::format("CancelStreamWatch, watch_id {} not found", watch_id));
+    }
+    watcher = it->second;
+  }
+
+  // watcher is removed at on_closed
+  watcher->is_closed.store(true);
+  brpc::StreamClose(watcher->stream_id);
+
+  return butil::Status::OK();
+}
+
+void KvControl::RemoveStreamWatch(brpc::StreamId stream_id) {
+  BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+  for (auto it = stream_watchers_.begin(); it != stream_watchers_.end(); ++it) {
+    if (it->second->stream_id == stream_id) {
+      DINGO_LOG(INFO) << fmt::format("[kv.watch][watch_id({})][stream_id({})] remove stream watcher.", it->first,
+                                     stream_id);
+      it->second->is_closed.store(true);
+      stream_watchers_.erase(it);
+      break;
+    }
+  }
+
+  stream_watcher_count_.store(stream_watchers_.size(), std::memory_order_relaxed);
+}
+
+void KvControl::CloseAllStreamWatch() {
+  std::vector<KvStreamWatcherPtr> watchers;
+  {
+    BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+    for (auto& [_, watcher] : stream_watchers_) {
+      watchers.push_back(watcher);
+    }
+  }
+
+  // client should re-watch from the last revision on new leader
+  for (auto& watcher : watchers) {
+    watcher->is_closed.store(true);
+    brpc::StreamClose(watcher->stream_id);
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[kv.watch] close all stream watcher, count: {}", watchers.size());
+}
+
+// Events are skipped when there is no stream watcher, the ring is cleared at the first skipped event,
+// so the ring is always continuous and the new watcher catch up the skipped events from storage.
+bool KvControl::NeedAppendWatchEvent() {
+  if (watch_event_ring_.Capacity() <= 0) {
+    return false;
+  }
+
+  if (stream_watcher_count_.load(std::memory_order_relaxed) > 0) {
+    return true;
+  }
+
+  if (watch_event_ring_.Size() > 0) {
+    watch_event_ring_.Clear();
+  }
+
+  return false;
+}
+
+void KvControl::AppendWatchEvent(const pb::coordinator_internal::RevisionInternal& op_revision,
+                                 pb::version::Event::EventType event_type, const pb::version::Kv& new_kv,
+                                 const pb::version::Kv& prev_kv) {
+  if (watch_event_ring_.Capacity() <= 0) {
+    return;
+  }
+
+  pb::version::Event event;
+  event.set_type(event_type);
+  *event.mutable_kv() = new_kv;
+  if (prev_kv.create_revision() > 0) {
+    *event.mutable_prev_kv() = prev_kv;
+  }
+  watch_event_ring_.Append(KvEventRevision{op_revision.main(), op_revision.sub()}, event);
+
+  if (is_dispatcher_started_.load()) {
+    BAIDU_SCOPED_LOCK(dispatcher_mutex_);
+    ++dispatcher_notify_seq_;
+    bthread_cond_signal(&dispatcher_cond_);
+  }
+}
+
+void KvControl::ClearWatchEvent() { watch_event_ring_.Clear(); }
+
+void KvControl::StreamWatchDispatchLoop() {
+  DINGO_LOG(INFO) << "[kv.watch] stream watch dispatcher start.";
+
+  uint64_t last_notify_seq = 0;
+  while (!is_dispatcher_stop_.load()) {
+    bool is_timeout = false;
+    {
+      BAIDU_SCOPED_LOCK(dispatcher_mutex_);
+      if (last_notify_seq == dispatcher_notify_seq_ && !is_dispatcher_stop_.load()) {
+        timespec abstime = butil::milliseconds_from_now(FLAGS_version_watch_stream_dispatch_interval_ms);
+        is_timeout = bthread_cond_timedwait(&dispatcher_cond_, &dispatcher_mutex_, &abstime) == ETIMEDOUT;
+      }
+      last_notify_seq = dispatcher_notify_seq_;
+    }
+
+    DispatchStreamWatch(is_timeout);
+  }
+
+  DINGO_LOG(INFO) << "[kv.watch] stream watch dispatcher stop.";
+}
+
+void KvControl::DispatchStreamWatch(bool is_timeout) {
+  std::vector<KvStreamWatcherPtr> watchers;
+  {
+    BAIDU_SCOPED_LOCK(stream_watchers_mutex_);
+    watchers.reserve(stream_watchers_.size());
+    for (auto& [_, watcher] : stream_watchers_) {
+      if (watcher->is_ready.load() && !watcher->is_catching_up.load()) {
+        watchers.push_back(watcher);
+      }
+    }
+  }
+
+  for (auto& watcher : watchers) {
+    // send until watcher catch up the latest event or stream is blocked
+    while (!watcher->is_closed.load() && DispatchStreamWatcher(watcher, is_timeout)) {
+    }
+  }
+}
+
+// Return true if there are more events to send.
+bool KvControl::DispatchStreamWatcher(KvStreamWatcherPtr watcher, bool is_timeout) {
+  auto filter = [&watcher](const pb::version::Event& event) -> bool { return watcher->IsMatch(event); };
+  size_t limit = std::max(static_cast<int64_t>(1), FLAGS_version_watch_stream_batch_size);
+
+  std::vector<pb::version::Event> events;
+  KvEventRevision next_revision = watcher->next_revision;
+  if (!watch_event_ring_.Read(watcher->next_revision, filter, limit, events, next_revision)) {
+    // watcher fell behind the ring, or ring is empty and the watched revisions maybe in storage,
+    // reading storage is slow, so catch up in its own bthread and not block other watchers.
+    if (watcher->next_revision != watcher->storage_end_revision) {
+      StartCatchUpStreamWatcher(watcher);
+      return false;
+    }
+  }
+
+  if (events.empty()) {
+    watcher->next_revision = next_revision;
+
+    // tell the client progress of the watch
+    if (is_timeout && watcher->progress_notify &&
+        Helper::TimestampMs() - watcher->last_send_time_ms >= FLAGS_version_watch_stream_dispatch_interval_ms) {
+      SendStreamWatchEvents(watcher, events, next_revision);
+    }
+
+    return false;
+  }
+
+  bool has_more = events.size() >= limit;
+  return SendStreamWatchEvents(watcher, events, next_revision) == 0 && has_more;
+}
+
+void KvControl::StartCatchUpStreamWatcher(KvStreamWatcherPtr watcher) {
+  if (watcher->is_catching_up.exchange(true)) {
+    return;
+  }
+
+  struct CatchUpArg {
+    KvControl* kv_control;
+    KvStreamWatcherPtr watcher;
+  };
+
+  catch_up_watcher_count_.fetch_add(1);
+  auto* arg = new CatchUpArg{this, watcher};
+  bthread_t tid;
+  int ret = bthread_start_background(
+      &tid, nullptr,
+      [](void* arg) -> void* {
+        std::unique_ptr<CatchUpArg> catch_up_arg(static_cast<CatchUpArg*>(arg));
+        catch_up_arg->kv_control->CatchUpStreamWatcher(catch_up_arg->watcher);
+        catch_up_arg->kv_control->catch_up_watcher_count_.fetch_sub(1);
+        return nullptr;
+      },
+      arg);
+  if (ret != 0) {
+    DINGO_LOG(ERROR) << fmt::format("[kv.watch][watch_id({})] start catch up bthread failed, ret: {}",
+                                    watcher->watch_id, ret);
+    delete arg;
+    catch_up_watcher_count_.fetch_sub(1);
+    watcher->is_catching_up.store(false);
+  }
+}
+
+void KvControl::CatchUpStreamWatcher(KvStreamWatcherPtr watcher) {
+  DINGO_LOG(INFO) << fmt::format("[kv.watch][watch_id({})] catch up from revision({}.{})", watcher->watch_id,
+                                 watcher->next_revision.main, watcher->next_revision.sub);
+
+  size_t limit = std::max(static_cast<int64_t>(1), FLAGS_version_watch_stream_batch_size);
+  bool is_caught_up = false;
+  while (!watcher->is_closed.load() && !is_dispatcher_stop_.load()) {
+    std::vector<pb::version::Event> events;
+    KvEventRevision next_revision;
+    int64_t compact_revision = 0;
+    auto status = ReadCatchUpEvents(watcher, limit, events, next_revision, compact_revision);
+    if (status.error_code() == pb::error::Errno::EWATCH_REVISION_COMPACTED) {
+      SendStreamWatchCompacted(watcher, compact_revision);
+      break;
+    } else if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("[kv.watch][watch_id({})] catch up from storage failed, error: {}",
+                                      watcher->watch_id, status.error_str());
+      break;
+    }
+
+    // no progress means storage has no more revisions, wait the next events come to ring
+    if (next_revision == watcher->next_revision) {
+      watcher->storage_end_revision = next_revision;
+      break;
+    }
+
+    if (events.empty()) {
+      watcher->next_revision = next_revision;
+    } else if (SendStreamWatchEvents(watcher, events, next_revision) != 0) {
+      // client is slow or stream is closed, dispatcher retry at next round
+      break;
+    }
+
+    KvEventRevision begin_revision;
+    if (watch_event_ring_.Begin(begin_revision) && begin_revision <= watcher->next_revision) {
+      is_caught_up = true;
+      break;
+    }
+  }
+
+  watcher->is_catching_up.store(false);
+
+  DINGO_LOG(INFO) << fmt::format("[kv.watch][watch_id({})] catch up finish at revision({}.{}), caught_up: {}",
+                                 watcher->watch_id, watcher->next_revision.main, watcher->next_revision.sub,
+                                 is_caught_up);
+
+  // let dispatcher continue from the ring
+  if (is_caught_up) {
+    BAIDU_SCOPED_LOCK(dispatcher_mutex_);
+    ++dispatcher_notify_seq_;
+    bthread_cond_signal(&dispatcher_cond_);
+  }
+}
+
+// Read events from storage until the oldest event of ring.
+butil::Status KvControl::ReadCatchUpEvents(KvStreamWatcherPtr watcher, size_t limit,
+                                           std::vector<pb::version::Event>& events, KvEventRevision& next_revision,
+                                           int64_t& compact_revision) {
+  auto status = CheckStreamWatchRevision(watcher->next_revision.main, compact_revision);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto filter = [&watcher](const pb::version::Event& event) -> bool { return watcher->IsMatch(event); };
+  KvEventRevision begin_revision;
+  bool has_begin = watch_event_ring_.Begin(begin_revision);
+  if (has_begin && begin_revision <= watcher->next_revision) {
+    next_revision = watcher->next_revision;
+    return butil::Status::OK();
+  }
+
+  return ReadWatchEventsFromStorage(watcher->next_revision, has_begin ? &begin_revision : nullptr, filter, limit,
+                                    events, next_revision);
+}
+
+int KvControl::SendStreamWatchEvents(KvStreamWatcherPtr watcher, std::vector<pb::version::Event>& events,
+                                     const KvEventRevision& next_revision) {
+  pb::version::WatchResponse response;
+  response.set_watch_id(watcher->watch_id);
+  response.mutable_header()->set_revision(next_revision.main - 1);
+  for (auto& event : events) {
+    if (!watcher->need_prev_kv) {
+      event.clear_prev_kv();
+    }
+    response.add_events()->Swap(&event);
+  }
+
+  butil::IOBuf buf;
+  butil::IOBufAsZeroCopyOutputStream wrapper(&buf);
+  response.SerializeToZeroCopyStream(&wrapper);
+
+  int ret = brpc::StreamWrite(watcher->stream_id, buf);
+  if (ret == EAGAIN) {
+    // client is slow, keep revision and retry at next round
+    DINGO_LOG(DEBUG) << fmt::format("[kv.watch][watch_id({})] stream is full, retry later.", watcher->watch_id);
+    return ret;
+  } else if (ret != 0) {
+    DINGO_LOG(WARNING) << fmt::format("[kv.watch][watch_id({})] write stream failed, ret: {}, close stream.",
+                                      watcher->watch_id, ret);
+    watcher->is_closed.store(true);
+    brpc::StreamClose(watcher->stream_id);
+    return ret;
+  }
+
+  watcher->next_revision = next_revision;
+  watcher->last_send_time_ms = Helper::TimestampMs();
+
+  return 0;
+}
+
+// Watcher can't catch up the compacted revisions, tell client and cancel the watcher.
+void KvControl::SendStreamWatchCompacted(KvStreamWatcherPtr watcher, int64_t compact_revision) {
+  DINGO_LOG(WARNING) << fmt::format("[kv.watch][watch_id({})] revision({}) is compacted, compact_revision: {}",
+                                    watcher->watch_id, watcher->next_revision.main, compact_revision);
+
+  pb::version::WatchResponse response;
+  response.set_watch_id(watcher->watch_id);
+  response.set_canceled(true);
+  response.set_compact_revision(compact_revision);
+  response.set_cancel_reason("watch revision is compacted");
+  response.mutable_error()->set_errcode(pb::error::Errno::EWATCH_REVISION_COMPACTED);
+  response.mutable_error()->set_errmsg(fmt::format("watch revision {} is compacted, compact revision {}",
+                                                   watcher->next_revision.main, compact_revision));
+
+  butil::IOBuf buf;
+  butil::IOBufAsZeroCopyOutputStream wrapper(&buf);
+  response.SerializeToZeroCopyStream(&wrapper);
+  brpc::StreamWrite(watcher->stream_id, buf);
+
+  watcher->is_closed.store(true);
+  brpc::StreamClose(watcher->stream_id);
+}
+
+butil::Status KvControl::ReadWatchEventsFromStorage(const KvEventRevision& revision,
+                                                    const KvEventRevision* end_revision,
+                                                    const KvEventRing::FilterFunc& filter, size_t limit,
+                                                    std::vector<pb::version::Event>& events,
+                                                    KvEventRevision& next_revision) {
+  pb::coordinator_internal::RevisionInternal start;
+  start.set_main(revision.main);
+  start.set_sub(revision.sub);
+
+  std::string end_id;
+  if (end_revision != nullptr) {
+    pb::coordinator_internal::RevisionInternal end;
+    end.set_main(end_revision->main);
+    end.set_sub(end_revision->sub);
+    end_id = RevisionToString(end);
+  }
+
+  int64_t batch_size = std::max(static_cast<int64_t>(1), FLAGS_version_watch_stream_catch_up_batch_size);
+  std::vector<pb::coordinator_internal::KvRevInternal> kv_revs;
+  auto status = kv_rev_meta_->ScanElements(RevisionToString(start), end_id, batch_size, kv_revs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  next_revision = revision;
+  for (const auto& kv_rev : kv_revs) {
+    if (events.size() >= limit) {
+      break;
+    }
+
+    const auto& kv = kv_rev.kv();
+    pb::version::Event event;
+    event.set_type(kv.is_deleted() ? pb::version::Event::EventType::Event_EventType_DELETE
+                                   : pb::version::Event::EventType::Event_EventType_PUT);
+    auto* event_kv = event.mutable_kv();
+    event_kv->mutable_kv()->set_key(kv.id());
+    event_kv->mutable_kv()->set_value(kv.value());
+    event_kv->set_create_revision(kv.create_revision().main());
+    event_kv->set_mod_revision(kv.mod_revision().main());
+    event_kv->set_version(kv.version());
+    event_kv->set_lease(kv.lease());
+
+    if (filter == nullptr || filter(event)) {
+      events.push_back(std::move(event));
+    }
+
+    auto rev = StringToRevision(kv_rev.id());
+    next_revision = KvEventRevision{rev.main(), rev.sub()}.Next();
+  }
+
+  // scanned all revisions before end, continue from the ring
+  if (end_revision != nullptr && static_cast<int64_t>(kv_revs.size()) < batch_size && events.size() < limit) {
+    next_revision = *end_revision;
+  }
+
+  return butil::Status::OK();
+}
+
 }  // namespace dingodb
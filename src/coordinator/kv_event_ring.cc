@@ -0,0 +1,89 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coordinator/kv_event_ring.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+
+namespace dingodb {
+
+void KvEventRing::Append(const KvEventRevision& revision, const pb::version::Event& event) {
+  if (capacity_ <= 0) {
+    return;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+
+  // Raft log may be replayed, skip the events already in ring.
+  if (!entries_.empty() && revision <= entries_.back().revision) {
+    DINGO_LOG(DEBUG) << fmt::format("[kv.event_ring] skip stale event revision({}.{}) back({}.{})", revision.main,
+                                    revision.sub, entries_.back().revision.main, entries_.back().revision.sub);
+    return;
+  }
+
+  entries_.push_back(Entry{revision, event});
+  while (static_cast<int64_t>(entries_.size()) > capacity_) {
+    entries_.pop_front();
+  }
+}
+
+bool KvEventRing::Read(const KvEventRevision& revision, const FilterFunc& filter, size_t limit,
+                       std::vector<pb::version::Event>& events, KvEventRevision& next_revision) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+
+  if (entries_.empty() || revision < entries_.front().revision) {
+    return false;
+  }
+
+  next_revision = revision;
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), revision,
+                             [](const Entry& entry, const KvEventRevision& value) { return entry.revision < value; });
+  for (; it != entries_.end() && events.size() < limit; ++it) {
+    if (filter == nullptr || filter(it->event)) {
+      events.push_back(it->event);
+    }
+    next_revision = it->revision.Next();
+  }
+
+  return true;
+}
+
+bool KvEventRing::Begin(KvEventRevision& revision) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  if (entries_.empty()) {
+    return false;
+  }
+
+  revision = entries_.front().revision;
+  return true;
+}
+
+int64_t KvEventRing::Size() {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void KvEventRing::Clear() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  entries_.clear();
+}
+
+}  // namespace dingodb
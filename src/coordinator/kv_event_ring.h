@@ -0,0 +1,84 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COORDINATOR_KV_EVENT_RING_H_
+#define DINGODB_COORDINATOR_KV_EVENT_RING_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <vector>
+
+#include "proto/version.pb.h"
+
+namespace dingodb {
+
+// Revision of one kv event, main is the revision of the raft log, sub is the index of kv in the log.
+struct KvEventRevision {
+  int64_t main{0};
+  int64_t sub{0};
+
+  KvEventRevision Next() const { return {main, sub + 1}; }
+
+  bool operator<(const KvEventRevision& rhs) const { return main < rhs.main || (main == rhs.main && sub < rhs.sub); }
+  bool operator==(const KvEventRevision& rhs) const { return main == rhs.main && sub == rhs.sub; }
+  bool operator!=(const KvEventRevision& rhs) const { return !(*this == rhs); }
+  bool operator<=(const KvEventRevision& rhs) const { return !(rhs < *this); }
+};
+
+// Bounded in-memory ring of the latest kv events, ordered by revision.
+// Streaming watchers read events from the ring, the watcher which is older than the ring catch up from storage.
+class KvEventRing {
+ public:
+  using FilterFunc = std::function<bool(const pb::version::Event&)>;
+
+  explicit KvEventRing(int64_t capacity) : capacity_(capacity) {}
+  ~KvEventRing() = default;
+
+  KvEventRing(const KvEventRing&) = delete;
+  KvEventRing& operator=(const KvEventRing&) = delete;
+
+  // Revision must be increasing, otherwise the event is ignored.
+  void Append(const KvEventRevision& revision, const pb::version::Event& event);
+
+  // Read events from revision(inclusive) which pass the filter, at most limit events.
+  // next_revision is where the next read continue.
+  // Return false if ring is empty or revision is older than the ring, events before Begin() must read from storage.
+  bool Read(const KvEventRevision& revision, const FilterFunc& filter, size_t limit,
+            std::vector<pb::version::Event>& events, KvEventRevision& next_revision);
+
+  // Oldest revision in the ring, return false if ring is empty.
+  bool Begin(KvEventRevision& revision);
+
+  int64_t Size();
+  int64_t Capacity() const { return capacity_; }
+
+  void Clear();
+
+ private:
+  struct Entry {
+    KvEventRevision revision;
+    pb::version::Event event;
+  };
+
+  int64_t capacity_;
+
+  std::shared_mutex mutex_;
+  std::deque<Entry> entries_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COORDINATOR_KV_EVENT_RING_H_
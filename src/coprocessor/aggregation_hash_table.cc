@@ -0,0 +1,179 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coprocessor/aggregation_hash_table.h"
+
+#include <algorithm>
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/logging.h"
+
+namespace dingodb {
+
+static const size_t kArenaBlockSize = 64 * 1024;
+static const size_t kArenaAlignment = alignof(std::max_align_t);
+static const size_t kInitBucketCount = 64;
+static const int64_t kEmptyBucket = -1;
+
+AggregationHashTable::AggregationHashTable(const std::vector<BaseSchema::Type>& slot_types,
+                                           const std::vector<bool>& slot_init_has_values)
+    : slot_types_(slot_types), slot_init_has_values_(slot_init_has_values) {
+  buckets_.resize(kInitBucketCount, kEmptyBucket);
+}
+
+char* AggregationHashTable::Allocate(size_t size) {
+  size = (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+  if (size > block_remain_size_) {
+    // big allocation has its own block, keep using current block
+    if (size > kArenaBlockSize / 4) {
+      blocks_.emplace_back(new char[size]);
+      arena_size_ += size;
+      return blocks_.back().get();
+    }
+
+    blocks_.emplace_back(new char[kArenaBlockSize]);
+    arena_size_ += kArenaBlockSize;
+    block_ptr_ = blocks_.back().get();
+    block_remain_size_ = kArenaBlockSize;
+  }
+
+  char* ptr = block_ptr_;
+  block_ptr_ += size;
+  block_remain_size_ -= size;
+  return ptr;
+}
+
+void AggregationHashTable::Rehash(size_t bucket_count) {
+  buckets_.assign(bucket_count, kEmptyBucket);
+  size_t mask = bucket_count - 1;
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    size_t pos = group_hashes_[i] & mask;
+    while (buckets_[pos] != kEmptyBucket) {
+      pos = (pos + 1) & mask;
+    }
+    buckets_[pos] = i;
+  }
+}
+
+AggregationHashTable::Group* AggregationHashTable::FindOrInsert(const std::string& key) {
+  size_t hash = std::hash<std::string_view>{}(key);
+  size_t mask = buckets_.size() - 1;
+  size_t pos = hash & mask;
+  while (buckets_[pos] != kEmptyBucket) {
+    auto& group = groups_[buckets_[pos]];
+    if (group_hashes_[buckets_[pos]] == hash && group.key == key) {
+      return &group;
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  // new group, keep load factor under 0.5
+  Group group;
+  char* key_data = key.empty() ? nullptr : Allocate(key.size());
+  if (key_data != nullptr) {
+    memcpy(key_data, key.data(), key.size());
+  }
+  group.key = std::string_view(key_data, key.size());
+
+  size_t slots_size = sizeof(AggregationSlot) * slot_types_.size();
+  group.slots = slots_size == 0 ? nullptr : reinterpret_cast<AggregationSlot*>(Allocate(slots_size));
+  if (group.slots != nullptr) {
+    memset(static_cast<void*>(group.slots), 0, slots_size);
+  }
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    group.slots[i].has_value = slot_init_has_values_[i];
+  }
+
+  groups_.push_back(group);
+  group_hashes_.push_back(hash);
+  if (groups_.size() * 2 > buckets_.size()) {
+    Rehash(buckets_.size() * 2);
+  } else {
+    buckets_[pos] = groups_.size() - 1;
+  }
+
+  return &groups_.back();
+}
+
+void AggregationHashTable::SetString(AggregationSlot* slot, std::string_view value) {
+  // the old value is left in arena, it is released with the table
+  char* data = value.empty() ? nullptr : Allocate(value.size());
+  if (data != nullptr) {
+    memcpy(data, value.data(), value.size());
+  }
+  slot->string_value.data = data;
+  slot->string_value.size = value.size();
+}
+
+void AggregationHashTable::GetRecord(const Group& group, std::vector<std::any>& record) const {
+  record.reserve(slot_types_.size());
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    const auto& slot = group.slots[i];
+    switch (slot_types_[i]) {
+      case BaseSchema::Type::kBool:
+        record.emplace_back(slot.has_value ? std::optional<bool>(slot.bool_value) : std::optional<bool>());
+        break;
+      case BaseSchema::Type::kInteger:
+        record.emplace_back(slot.has_value ? std::optional<int32_t>(slot.int_value) : std::optional<int32_t>());
+        break;
+      case BaseSchema::Type::kFloat:
+        record.emplace_back(slot.has_value ? std::optional<float>(slot.float_value) : std::optional<float>());
+        break;
+      case BaseSchema::Type::kLong:
+        record.emplace_back(slot.has_value ? std::optional<int64_t>(slot.long_value) : std::optional<int64_t>());
+        break;
+      case BaseSchema::Type::kDouble:
+        record.emplace_back(slot.has_value ? std::optional<double>(slot.double_value) : std::optional<double>());
+        break;
+      case BaseSchema::Type::kString:
+        if (slot.has_value) {
+          record.emplace_back(
+              std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>(GetString(slot))));
+        } else {
+          record.emplace_back(std::optional<std::shared_ptr<std::string>>());
+        }
+        break;
+      default:
+        DINGO_LOG(ERROR) << "unsupported aggregation slot type: " << BaseSchema::GetTypeString(slot_types_[i]);
+        record.emplace_back(std::any());
+        break;
+    }
+  }
+}
+
+std::vector<const AggregationHashTable::Group*> AggregationHashTable::GetSortedGroups() const {
+  std::vector<const Group*> sorted_groups;
+  sorted_groups.reserve(groups_.size());
+  for (const auto& group : groups_) {
+    sorted_groups.push_back(&group);
+  }
+  std::sort(sorted_groups.begin(), sorted_groups.end(),
+            [](const Group* lhs, const Group* rhs) { return lhs->key < rhs->key; });
+  return sorted_groups;
+}
+
+int64_t AggregationHashTable::MemoryUsage() const {
+  return arena_size_ + groups_.capacity() * (sizeof(Group) + sizeof(size_t)) + buckets_.capacity() * sizeof(int64_t);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,108 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COPROCESSOR_AGGREGATION_HASH_TABLE_H_  // NOLINT
+#define DINGODB_COPROCESSOR_AGGREGATION_HASH_TABLE_H_
+
+#include <serial/schema/base_schema.h>
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dingodb {
+
+// Typed accumulator of one aggregation operator, the type is decided by the result schema.
+struct AggregationSlot {
+  struct StringValue {
+    const char* data;
+    size_t size;
+  };
+
+  union {
+    bool bool_value;
+    int32_t int_value;
+    int64_t long_value;
+    float float_value;
+    double double_value;
+    StringValue string_value;
+  };
+  bool has_value;
+};
+
+// Open addressing hash table from group by key to accumulators.
+// Keys, accumulators and string values are allocated in arena, so a group costs no heap allocation,
+// and the memory usage is known for the memory limit of aggregation.
+class AggregationHashTable {
+ public:
+  struct Group {
+    std::string_view key;
+    AggregationSlot* slots;
+  };
+
+  // slot_types is the result type of every accumulator.
+  // slot_init_has_values is whether the accumulator has initial zero value, such as COUNT and SUM0.
+  AggregationHashTable(const std::vector<BaseSchema::Type>& slot_types, const std::vector<bool>& slot_init_has_values);
+  ~AggregationHashTable() = default;
+
+  AggregationHashTable(const AggregationHashTable& rhs) = delete;
+  AggregationHashTable& operator=(const AggregationHashTable& rhs) = delete;
+  AggregationHashTable(AggregationHashTable&& rhs) = delete;
+  AggregationHashTable& operator=(AggregationHashTable&& rhs) = delete;
+
+  // Find group of key, if not exist insert a new group with initial accumulators.
+  Group* FindOrInsert(const std::string& key);
+
+  // Copy value into arena and set it to string accumulator.
+  void SetString(AggregationSlot* slot, std::string_view value);
+  static std::string_view GetString(const AggregationSlot& slot) {
+    return std::string_view(slot.string_value.data, slot.string_value.size);
+  }
+
+  // Convert accumulators of group to record, every column is std::optional<T> same as the decoded record.
+  void GetRecord(const Group& group, std::vector<std::any>& record) const;
+
+  // Groups ordered by key.
+  std::vector<const Group*> GetSortedGroups() const;
+
+  size_t Size() const { return groups_.size(); }
+  int64_t MemoryUsage() const;
+
+ private:
+  char* Allocate(size_t size);
+  void Rehash(size_t bucket_count);
+
+  std::vector<BaseSchema::Type> slot_types_;
+  std::vector<bool> slot_init_has_values_;
+
+  // arena
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t block_remain_size_{0};
+  char* block_ptr_{nullptr};
+  int64_t arena_size_{0};
+
+  // groups in insert order
+  std::vector<Group> groups_;
+  std::vector<size_t> group_hashes_;
+  // index of groups_, linear probing
+  std::vector<int64_t> buckets_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COPROCESSOR_AGGREGATION_HASH_TABLE_H_  // NOLINT
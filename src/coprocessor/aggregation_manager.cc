@@ -19,18 +19,40 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
 #include "common/logging.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/store.pb.h"
 
 namespace dingodb {
 
+DEFINE_int64(coprocessor_aggregation_max_memory_size, 64 * 1024 * 1024,
+             "max memory size of group by aggregation, partial aggregation is flushed when exceed");
+
+// typed accumulator value of slot
+template <typename T>
+static T& SlotValue(AggregationSlot* slot) {
+  if constexpr (std::is_same_v<bool, T>) {
+    return slot->bool_value;
+  } else if constexpr (std::is_same_v<int32_t, T>) {
+    return slot->int_value;
+  } else if constexpr (std::is_same_v<int64_t, T>) {
+    return slot->long_value;
+  } else if constexpr (std::is_same_v<float, T>) {
+    return slot->float_value;
+  } else {
+    static_assert(std::is_same_v<double, T>, "SlotValue : unsupported type");
+    return slot->double_value;
+  }
+}
+
 template <typename PARAM, typename RESULT>
 struct SUM {
-  bool operator()(const std::any& param, std::any* result) {
+  bool operator()(const std::any& param, AggregationSlot* slot, AggregationHashTable* /*table*/) {
     static_assert(
         !(std::is_same_v<std::string, PARAM> || std::is_same_v<std::string, RESULT> ||
           std::is_same_v<std::shared_ptr<std::string>, PARAM> || std::is_same_v<std::shared_ptr<std::string>, RESULT>),
@@ -38,16 +60,16 @@ struct SUM {
 
     try {
       const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        result_value = param_value;
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
+      if (!param_value.has_value()) {
         return true;
+      }
+
+      RESULT& result_value = SlotValue<RESULT>(slot);
+      if (!slot->has_value) {
+        result_value = param_value.value();
+        slot->has_value = true;
       } else {
-        result_value.value() += param_value.value();
+        result_value += param_value.value();
       }
     } catch (const std::exception& my_exception) {
       DINGO_LOG(ERROR) << fmt::format("SUM<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
@@ -61,19 +83,19 @@ struct SUM {
 
 template <typename PARAM, typename RESULT>
 struct COUNT {
-  bool operator()(const std::any& param, std::any* result) {
+  bool operator()(const std::any& param, AggregationSlot* slot, AggregationHashTable* /*table*/) {
     try {
       const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
+      if (!param_value.has_value()) {
+        return true;
+      }
 
-      if (param_value.has_value() && !result_value.has_value()) {
+      RESULT& result_value = SlotValue<RESULT>(slot);
+      if (!slot->has_value) {
         result_value = 1;
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
+        slot->has_value = true;
       } else {
-        result_value.value() += 1;
+        result_value += 1;
       }
     } catch (const std::exception& my_exception) {
       DINGO_LOG(ERROR) << fmt::format("COUNT<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
@@ -87,74 +109,49 @@ struct COUNT {
 
 template <typename PARAM, typename RESULT>
 struct COUNTWITHNULL {
-  bool operator()([[maybe_unused]] const std::any& param, std::any* result) {
-    try {
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (!result_value.has_value()) {
-        result_value = 1;
-      } else {
-        result_value.value() += 1;
-      }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("COUNTWITHNULL<{},{}> exception : {}", typeid(PARAM).name(),
-                                      typeid(RESULT).name(), my_exception.what());
-      return false;
+  bool operator()([[maybe_unused]] const std::any& param, AggregationSlot* slot, AggregationHashTable* /*table*/) {
+    RESULT& result_value = SlotValue<RESULT>(slot);
+    if (!slot->has_value) {
+      result_value = 1;
+      slot->has_value = true;
+    } else {
+      result_value += 1;
     }
 
     return true;
   }
 };
 
-template <typename PARAM, typename RESULT>
-struct MAX {
-  bool operator()(const std::any& param, std::any* result) {
+// MAX and MIN share the same logic, IS_MAX selects the compare direction.
+template <typename PARAM, typename RESULT, bool IS_MAX>
+struct MAXMIN {
+  static_assert(std::is_same_v<PARAM, RESULT>, "MAX/MIN : param type must be same as result type");
+
+  bool operator()(const std::any& param, AggregationSlot* slot, AggregationHashTable* table) {
     try {
       const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value = *(param_value.value());
-
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value.value() = std::make_shared<std::string>(param_value);
+      if (!param_value.has_value()) {
+        return true;
+      }
 
-        } else {
-          result_value = param_value;
+      if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM>) {
+        std::string_view value(*(param_value.value()));
+        if (!slot->has_value || (IS_MAX ? AggregationHashTable::GetString(*slot) < value
+                                        : AggregationHashTable::GetString(*slot) > value)) {
+          table->SetString(slot, value);
+          slot->has_value = true;
         }
-
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
       } else {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (result_value.value() < *(param_value.value())) {
-            result_value = *(param_value.value());
-          }
-        } else if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) < *(param_value.value())) {
-            result_value = param_value;
-          }
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) < param_value.value()) {
-            *(result_value.value()) = param_value;
-          }
-        } else {
-          if (result_value.value() < param_value.value()) {
-            result_value = param_value;
-          }
+        RESULT& result_value = SlotValue<RESULT>(slot);
+        if (!slot->has_value ||
+            (IS_MAX ? result_value < param_value.value() : result_value > param_value.value())) {
+          result_value = param_value.value();
+          slot->has_value = true;
         }
       }
     } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("MAX<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
+      DINGO_LOG(ERROR) << fmt::format("{}<{},{}> exception : {}", IS_MAX ? "MAX" : "MIN", typeid(PARAM).name(),
+                                      typeid(RESULT).name(), my_exception.what());
       return false;
     }
 
@@ -163,60 +160,10 @@ struct MAX {
 };
 
 template <typename PARAM, typename RESULT>
-struct MIN {
-  bool operator()(const std::any& param, std::any* result) {
-    try {
-      const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value = *(param_value.value());
+using MAX = MAXMIN<PARAM, RESULT, true>;
 
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value.value() = std::make_shared<std::string>(param_value);
-
-        } else {
-          result_value = param_value;
-        }
-
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
-      } else {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (result_value.value() > *(param_value.value())) {
-            result_value = *(param_value.value());
-          }
-        } else if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) > *(param_value.value())) {
-            result_value = param_value;
-          }
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) > param_value.value()) {
-            *(result_value.value()) = param_value;
-          }
-        } else {
-          if (result_value.value() > param_value.value()) {
-            result_value = param_value;
-          }
-        }
-      }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("MIN<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
-      return false;
-    }
-
-    return true;
-  }
-};
+template <typename PARAM, typename RESULT>
+using MIN = MAXMIN<PARAM, RESULT, false>;
 
 AggregationManager::AggregationManager() = default;
 AggregationManager::~AggregationManager() { Close(); }
@@ -232,6 +179,24 @@ butil::Status AggregationManager::Open(
 
   size_t start_aggregation_operators_index = result_serial_schemas->size() - aggregation_operators.size();
 
+  // accumulator type is the result type, COUNT and SUM0 start from zero
+  slot_types_.clear();
+  slot_init_has_values_.clear();
+  for (size_t j = 0; j < aggregation_operators.size(); j++) {
+    auto type = (*result_serial_schemas)[j + start_aggregation_operators_index]->GetType();
+    if (type != BaseSchema::Type::kBool && type != BaseSchema::Type::kInteger && type != BaseSchema::Type::kFloat &&
+        type != BaseSchema::Type::kLong && type != BaseSchema::Type::kDouble && type != BaseSchema::Type::kString) {
+      std::string error_message = fmt::format("unsupported serial_schema1 type: {}", static_cast<int>(type));
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+
+    auto oper = aggregation_operators[j].oper();
+    slot_types_.push_back(type);
+    slot_init_has_values_.push_back(pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper ||
+                                    pb::store::SUM0 == oper);
+  }
+
   size_t i = 0;
   aggregation_functions_.reserve(aggregation_operators.size());
   for (const auto& aggregation_operator : aggregation_operators) {
@@ -319,38 +284,45 @@ butil::Status AggregationManager::Open(
 
 butil::Status AggregationManager::Execute(const std::string& group_by_key,
                                           const std::vector<std::any>& group_by_operator_record) {
-  butil::Status status;
-  std::shared_ptr<Aggregation> aggregation;
-
   if (!aggregations_) {
-    using MapType = std::map<std::string, std::shared_ptr<Aggregation>>;
-    aggregations_ = std::make_shared<MapType>();
+    aggregations_ = std::make_shared<AggregationHashTable>(slot_types_, slot_init_has_values_);
   }
 
-  const auto& iter = aggregations_->find(group_by_key);
-  if (iter == aggregations_->end()) {
-    const auto& [iter_new, _] = aggregations_->emplace(group_by_key, std::make_shared<Aggregation>());
-    aggregation = iter_new->second;
-
-    status = aggregation->Open(result_serial_schemas_->size() - group_by_operator_serial_schemas_->size(),
-                               result_serial_schemas_, aggregation_operators_);
-    if (!status.ok()) {
-      DINGO_LOG(ERROR) << fmt::format("Aggregation::Open failed");
-      return status;
-    }
-  } else {
-    aggregation = iter->second;
+  if (group_by_operator_record.size() > aggregation_functions_.size()) {
+    std::string error_message = fmt::format("group_by_operator_record size : {} exceed aggregation_functions size : {}",
+                                            group_by_operator_record.size(), aggregation_functions_.size());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
   }
 
-  status = aggregation->Execute(aggregation_functions_, group_by_operator_record);
-  if (!status.ok()) {
-    DINGO_LOG(ERROR) << fmt::format("Aggregation::Execute failed");
-    return status;
+  auto* group = aggregations_->FindOrInsert(group_by_key);
+  for (size_t i = 0; i < group_by_operator_record.size(); i++) {
+    bool ret = aggregation_functions_[i](group_by_operator_record[i], &group->slots[i], aggregations_.get());
+    if (!ret) {
+      std::string error_message = fmt::format("Execute failed index :  {}", i);
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
   }
 
   return butil::Status();
 }
 
+bool AggregationManager::IsExceedMemoryLimit() const {
+  return FLAGS_coprocessor_aggregation_max_memory_size > 0 &&
+         MemoryUsage() > FLAGS_coprocessor_aggregation_max_memory_size;
+}
+
+int64_t AggregationManager::MemoryUsage() const { return aggregations_ ? aggregations_->MemoryUsage() : 0; }
+
+size_t AggregationManager::GroupCount() const { return aggregations_ ? aggregations_->Size() : 0; }
+
+void AggregationManager::Clear() {
+  if (aggregations_) {
+    aggregations_.reset();
+  }
+}
+
 void AggregationManager::Close() {
   if (group_by_operator_serial_schemas_) {
     group_by_operator_serial_schemas_.reset();
@@ -363,6 +335,8 @@ void AggregationManager::Close() {
   }
 
   aggregation_functions_.clear();
+  slot_types_.clear();
+  slot_init_has_values_.clear();
 
   if (aggregations_) {
     aggregations_.reset();
@@ -371,10 +345,9 @@ void AggregationManager::Close() {
 
 std::shared_ptr<AggregationIterator> AggregationManager::CreateIterator() {
   if (!aggregations_) {
-    using MapType = std::map<std::string, std::shared_ptr<Aggregation>>;
-    aggregations_ = std::make_shared<MapType>();
+    aggregations_ = std::make_shared<AggregationHashTable>(slot_types_, slot_init_has_values_);
   }
-  DINGO_LOG(DEBUG) << "aggregations  size : " << aggregations_->size();
+  DINGO_LOG(DEBUG) << "aggregations  size : " << aggregations_->Size();
   return std::make_shared<AggregationIterator>(aggregations_);
 }
 
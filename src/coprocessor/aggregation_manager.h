@@ -18,35 +18,52 @@
 #include <serial/schema/base_schema.h>
 
 #include <any>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "butil/status.h"
-#include "coprocessor/aggregation.h"
+#include "coprocessor/aggregation_hash_table.h"
 #include "proto/store.pb.h"
 
 namespace dingodb {
 
+// Iterate groups of aggregation hash table in key order.
 class AggregationIterator {
  public:
-  explicit AggregationIterator(const std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>>& aggregations)
-      : aggregations_(aggregations) {
-    iter_ = aggregations_->begin();
+  explicit AggregationIterator(const std::shared_ptr<AggregationHashTable>& aggregations)
+      : aggregations_(aggregations), groups_(aggregations->GetSortedGroups()) {
+    Load();
   }
 
   ~AggregationIterator() { aggregations_.reset(); }
 
-  bool HasNext() { return (iter_ != aggregations_->end()); }
-  void Next() { ++iter_; }
-  const std::string& GetKey() const { return iter_->first; }
-  const std::shared_ptr<std::vector<std::any>>& GetValue() const { return iter_->second->GetResult(); }
+  bool HasNext() { return (index_ < groups_.size()); }
+  void Next() {
+    ++index_;
+    Load();
+  }
+  const std::string& GetKey() const { return key_; }
+  const std::shared_ptr<std::vector<std::any>>& GetValue() const { return value_; }
 
  private:
-  std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>> aggregations_;
-  std::map<std::string, std::shared_ptr<Aggregation>>::iterator iter_;
+  void Load() {
+    if (index_ >= groups_.size()) {
+      return;
+    }
+    key_ = groups_[index_]->key;
+    value_ = std::make_shared<std::vector<std::any>>();
+    aggregations_->GetRecord(*groups_[index_], *value_);
+  }
+
+  std::shared_ptr<AggregationHashTable> aggregations_;
+  std::vector<const AggregationHashTable::Group*> groups_;
+  size_t index_{0};
+  std::string key_;
+  std::shared_ptr<std::vector<std::any>> value_;
 };
 
 class AggregationManager {
@@ -67,6 +84,14 @@ class AggregationManager {
 
   std::shared_ptr<AggregationIterator> CreateIterator();
 
+  // Memory of groups exceed the limit, the partial aggregation should be flushed.
+  bool IsExceedMemoryLimit() const;
+  int64_t MemoryUsage() const;
+  size_t GroupCount() const;
+
+  // Drop all groups and start a new aggregation, the iterator created before is still valid.
+  void Clear();
+
   void Close();
 
  private:
@@ -79,8 +104,11 @@ class AggregationManager {
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_operator_serial_schemas_;
   ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> result_serial_schemas_;
-  std::vector<std::function<bool(const std::any&, std::any*)>> aggregation_functions_;
-  std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>> aggregations_;
+  std::vector<std::function<bool(const std::any&, AggregationSlot*, AggregationHashTable*)>> aggregation_functions_;
+  // result type and initial state of accumulator
+  std::vector<BaseSchema::Type> slot_types_;
+  std::vector<bool> slot_init_has_values_;
+  std::shared_ptr<AggregationHashTable> aggregations_;
 };
 
 }  // namespace dingodb
@@ -26,16 +26,17 @@
 #include "common/logging.h"
 #include "coprocessor/utils.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/error.pb.h"
 #include "proto/store.pb.h"
 #include "serial/record_decoder.h"
 #include "serial/record_encoder.h"
-
-// Must be after proto, otherwise it will cause naming collision. such as TYPE_STRING
-#include "libexpr/src/runner.h"
+#include "serial/record_view_decoder.h"
 
 namespace dingodb {
 
+DEFINE_int64(coprocessor_execute_batch_size, 256, "count of records decoded and filtered in one batch");
+
 Coprocessor::Coprocessor() : enable_expression_(true), end_of_group_by_(true) {}
 Coprocessor::~Coprocessor() { Close(); }
 
@@ -122,6 +123,11 @@ butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
     DINGO_LOG(DEBUG) << "select column index:" << index;
   }
 
+  // the layout of selection columns is resolved once, shared by all records
+  original_record_decoder_ =
+      std::make_unique<RecordViewDecoder>(coprocessor_.schema_version(), original_serial_schemas_,
+                                          coprocessor_.original_schema().common_id(), selection_column_indexes_);
+
   // selection_serial_schemas_ = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
   // Utils::CreateSerialSchema(original_serial_schemas_, coprocessor_.selection_columns(), &selection_serial_schemas_);
   // Utils::CreateSelectionSchema(original_serial_schemas_sorted_, selection_column_indexes_,
@@ -167,14 +173,29 @@ butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
     return status;
   }
 
+  result_column_indexes_.clear();
+  for (const auto& schema : *result_serial_schemas_sorted_) {
+    if (schema && schema->GetIndex() >= 0 && schema->GetIndex() < selection_column_indexes_.size()) {
+      result_column_indexes_.push_back(schema->GetIndex());
+    }
+  }
+
   status = CompareSerialSchema(coprocessor_);
   if (!status.ok()) {
     DINGO_LOG(ERROR) << fmt::format("CompareSerialSchema failed");
     return status;
   }
-  enable_expression_ = !coprocessor_.expression().empty();
 
-  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open enable_expression_ : {}", enable_expression_);
+  status = expression_filter_.Open(coprocessor_.expression());
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("ExpressionFilter::Open failed");
+    return status;
+  }
+  // the always true expression is skipped
+  enable_expression_ = !expression_filter_.IsAlwaysTrue();
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open enable_expression_ : {} always_false : {}", enable_expression_,
+                                  expression_filter_.IsAlwaysFalse());
 
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open Leave");
 
@@ -194,36 +215,129 @@ butil::Status Coprocessor::Execute(IteratorPtr iter, bool key_only, size_t max_f
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Execute Enter");
   ScanFilter scan_filter = ScanFilter(key_only, max_fetch_cnt, max_bytes_rpc);
   butil::Status status;
-  while (iter->Valid()) {
-    pb::common::KeyValue kv;
-    *kv.mutable_key() = iter->Key();
-    *kv.mutable_value() = iter->Value();
-    bool has_result_kv = false;
-    pb::common::KeyValue result_key_value;
-    DINGO_LOG(DEBUG) << fmt::format("Coprocessor::DoExecute Call");
-    status = DoExecute(kv, &has_result_kv, &result_key_value);
-    if (!status.ok()) {
-      DINGO_LOG(ERROR) << fmt::format("Coprocessor::Execute failed");
-      return status;
-    }
 
-    if (!has_result_kv) {
+  // no record can pass the filter, skip decode and selection
+  if (enable_expression_ && expression_filter_.IsAlwaysFalse()) {
+    while (iter->Valid()) {
       iter->Next();
-      continue;
     }
+    return GetKeyValueFromAggregation(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+  }
 
-    if (key_only) {
-      result_key_value.set_value("");
+  size_t batch_size = std::max(FLAGS_coprocessor_execute_batch_size, static_cast<int64_t>(1));
+  std::vector<pb::common::KeyValue> batch_kvs;
+  std::vector<bool> selected;
+  batch_kvs.reserve(batch_size);
+
+  bool is_flush = false;
+  do {
+    // emit the partial aggregation flushed for memory limit, then continue scan with a new aggregation
+    if (aggregation_iterator_ && iter->Valid()) {
+      status = GetKeyValueFromAggregation(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+      if (!status.ok() || aggregation_iterator_->HasNext()) {
+        return status;
+      }
+      aggregation_iterator_.reset();
+      aggregation_manager_->Clear();
+      if (!kvs->empty()) {
+        return status;
+      }
     }
 
-    kvs->emplace_back(result_key_value);
+    is_flush = false;
+    while (iter->Valid() && !is_flush) {
+      batch_kvs.clear();
+      while (iter->Valid() && batch_kvs.size() < batch_size) {
+        auto& kv = batch_kvs.emplace_back();
+        *kv.mutable_key() = iter->Key();
+        *kv.mutable_value() = iter->Value();
+        iter->Next();
+      }
 
-    if (scan_filter.UptoLimit(result_key_value)) {
-      iter->Next();
-      return butil::Status();
+      // decode a batch of records, the views point into batch_kvs
+      size_t batch_count = batch_kvs.size();
+      if (batch_views_.size() < batch_count) {
+        batch_views_.resize(batch_count);
+        batch_key_strings_.resize(batch_count);
+      }
+      for (size_t i = 0; i < batch_count; ++i) {
+        status = DoDecode(batch_kvs[i], &batch_views_[i], &batch_key_strings_[i]);
+        if (!status.ok()) {
+          DINGO_LOG(ERROR) << fmt::format("Coprocessor::Execute failed");
+          return status;
+        }
+      }
+
+      if (enable_expression_) {
+        // the expression is evaluated on std::any tuples, the columns it uses are not known here, so the whole
+        // selection is materialized into the reused records
+        if (batch_records_.size() != batch_count) {
+          batch_records_.resize(batch_count);
+        }
+        for (size_t i = 0; i < batch_count; ++i) {
+          auto& record = batch_records_[i];
+          record.resize(batch_views_[i].size());
+          for (size_t j = 0; j < record.size(); ++j) {
+            original_record_decoder_->AssignAny(batch_views_[i][j], selection_column_indexes_[j], record[j]);
+          }
+        }
+
+        status = expression_filter_.Filter(batch_records_, selected);
+        if (!status.ok()) {
+          DINGO_LOG(ERROR) << fmt::format("Coprocessor::Execute failed");
+          return status;
+        }
+      } else {
+        selected.assign(batch_count, true);
+      }
+
+      for (size_t i = 0; i < batch_count; ++i) {
+        // discard this key value
+        if (!selected[i]) {
+          continue;
+        }
+
+        bool has_result_kv = false;
+        pb::common::KeyValue result_key_value;
+        DINGO_LOG(DEBUG) << fmt::format("Coprocessor::DoExecute Call");
+        status = DoExecute(batch_views_[i], enable_expression_ ? &batch_records_[i] : nullptr, &has_result_kv,
+                           &result_key_value);
+        if (!status.ok()) {
+          DINGO_LOG(ERROR) << fmt::format("Coprocessor::Execute failed");
+          return status;
+        }
+
+        if (!has_result_kv) {
+          // too many groups, flush the partial aggregation, the client merges partial aggregations
+          if (end_of_group_by_ && aggregation_manager_ && aggregation_manager_->IsExceedMemoryLimit()) {
+            DINGO_LOG(INFO) << fmt::format("Coprocessor::Execute flush partial aggregation, groups : {} memory : {}",
+                                           aggregation_manager_->GroupCount(), aggregation_manager_->MemoryUsage());
+            if (i + 1 < batch_kvs.size()) {
+              iter->Seek(batch_kvs[i + 1].key());
+            }
+            aggregation_iterator_ = aggregation_manager_->CreateIterator();
+            is_flush = true;
+            break;
+          }
+          continue;
+        }
+
+        if (key_only) {
+          result_key_value.set_value("");
+        }
+
+        kvs->emplace_back(result_key_value);
+
+        if (scan_filter.UptoLimit(result_key_value)) {
+          // the records after this one are read ahead, move iterator back to the next record for next scan
+          if (i + 1 < batch_kvs.size()) {
+            iter->Seek(batch_kvs[i + 1].key());
+          }
+          return butil::Status();
+        }
+      }
     }
-    iter->Next();
-  }
+  } while (is_flush);
 
   status = GetKeyValueFromAggregation(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
 
@@ -231,31 +345,13 @@ butil::Status Coprocessor::Execute(IteratorPtr iter, bool key_only, size_t max_f
 
   return status;
 }
-butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_result_kv,
-                                     pb::common::KeyValue* result_kv) {
-  butil::Status status;
-
-  RecordDecoder original_record_decoder(coprocessor_.schema_version(), original_serial_schemas_,
-                                        coprocessor_.original_schema().common_id());
-
-  std::vector<std::any> original_record;
-
-  // if (original_column_indexes_.empty()) {
-  //   GetOriginalColumnIndexes();
-  // }
-  // if(selection_column_indexes_.empty()) {
-  //   GetSelectionColumnIndexes();
-  // }
-
-  // for (const auto& index : selection_column_indexes_) {
-  //   // Use the index variable here
-  //   DINGO_LOG_DEBUG << "selection column index:" << index;
-  // }
 
+butil::Status Coprocessor::DoDecode(const pb::common::KeyValue& kv, std::vector<RecordViewDecoder::ColumnView>* views,
+                                    std::vector<std::string>* key_strings) {
   int ret = 0;
   try {
     // decode some column. not decode all
-    ret = original_record_decoder.Decode(kv, selection_column_indexes_, original_record);
+    ret = original_record_decoder_->Decode(kv.key(), kv.value(), *views, *key_strings);
   } catch (const std::exception& my_exception) {
     std::string error_message = fmt::format("serial::Decode failed exception : {}", my_exception.what());
     DINGO_LOG(ERROR) << error_message;
@@ -268,49 +364,16 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
     return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
   }
 
-  //  std::vector<std::any> selection_record;
-  //  selection_record.reserve(coprocessor_.selection_columns().size());
-  //  size_t i = 0;
-  //  for (auto index : coprocessor_.selection_columns()) {
-  //    std::any column = Utils::CloneColumn(original_record[index], (*selection_serial_schemas_sorted_)[i]->GetType());
-  //    if (!column.has_value()) {
-  //      std::string error_message = fmt::format(
-  //          "CloneColumn failed original_record index : {} selection_serial_schemas_sorted_ i : {} "
-  //          "selection_serial_schemas_sorted_ "
-  //          "type : {}",
-  //          index, i, static_cast<int>((*selection_serial_schemas_sorted_)[i]->GetType()));
-  //      DINGO_LOG(ERROR) << error_message;
-  //      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-  //    }
-  //    selection_record.emplace_back(std::move(column));
-  //    i++;
-  //  }
-
-  bool is_key_value_reserve = true;
-  if (enable_expression_) {
-    expr::Runner runner;
-
-    try {
-      runner.Decode(reinterpret_cast<const expr::Byte*>(coprocessor_.expression().c_str()),
-                    coprocessor_.expression().length());
-      runner.BindTuple(reinterpret_cast<const expr::Tuple*>(&original_record));
-      runner.Run();
-      expr::Wrap<bool> ok = runner.GetResult<bool>();
-      is_key_value_reserve = ok.has_value() && ok.value();
-    } catch (const std::exception& my_exception) {
-      std::string error_message = fmt::format("expr::Runner Decode or Run failed. exception : {}", my_exception.what());
-      DINGO_LOG(ERROR) << error_message;
-      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-    }
-  }
+  return butil::Status();
+}
 
-  // discard this key value
-  if (!is_key_value_reserve) {
-    return butil::Status();
-  }
+butil::Status Coprocessor::DoExecute(const std::vector<RecordViewDecoder::ColumnView>& views,
+                                     const std::vector<std::any>* selection_record, bool* has_result_kv,
+                                     pb::common::KeyValue* result_kv) {
+  butil::Status status;
 
   if (end_of_group_by_) {  // group by
-    status = DoExecuteForAggregation(original_record);
+    status = DoExecuteForAggregation(views);
     if (!status.ok()) {
       std::string error_message = fmt::format("Coprocessor::DoExecuteForAggregation failed");
       DINGO_LOG(ERROR) << error_message;
@@ -320,7 +383,7 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
     *has_result_kv = false;
 
   } else {  // selection
-    status = DoExecuteForSelection(original_record, has_result_kv, result_kv);
+    status = DoExecuteForSelection(views, selection_record, has_result_kv, result_kv);
     if (!status.ok()) {
       std::string error_message = fmt::format("Coprocessor::DoExecuteForSelection failed");
       DINGO_LOG(ERROR) << error_message;
@@ -331,31 +394,28 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
   return butil::Status();
 }
 
-butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>& selection_record) {
+butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<RecordViewDecoder::ColumnView>& views) {
   butil::Status status;
-  // group by
-  std::vector<std::any> group_by_key_record;
-  std::vector<std::any> group_by_operator_record;
-
-  group_by_key_record.reserve(coprocessor_.group_by_columns_size());
-  group_by_operator_record.reserve(coprocessor_.aggregation_operators_size());
+  // group by, the key and operator columns are read from views, both records are reused for every row because
+  // EncodeKey and the aggregation functions copy the values
+  group_by_key_record_.resize(coprocessor_.group_by_columns_size());
+  group_by_operator_record_.resize(coprocessor_.aggregation_operators_size());
 
   {
     size_t i = 0;
     for (auto index : coprocessor_.group_by_columns()) {
-      std::any column = Utils::CloneColumn(selection_record[index], (*group_by_key_serial_schemas_)[i]->GetType());
-      if (!column.has_value()) {
+      BaseSchema::Type type = (*group_by_key_serial_schemas_)[i]->GetType();
+      if (views[index].type != type) {
         std::string error_message = fmt::format(
-            "CloneColumn failed selection_record index : {} group_by_key_serial_schemas_ i : {} "
+            "column type mismatch selection_record index : {} group_by_key_serial_schemas_ i : {} "
             "group_by_key_serial_schemas_ type : {}",
-            index, i, static_cast<int>((*group_by_key_serial_schemas_)[i]->GetType()));
+            index, i, static_cast<int>(type));
         DINGO_LOG(ERROR) << error_message;
         return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
       }
+      original_record_decoder_->AssignAny(views[index], selection_column_indexes_[index], group_by_key_record_[i]);
       // debug
-      Utils::DebugColumn(column, (*group_by_key_serial_schemas_)[i]->GetType(), "key");
-
-      group_by_key_record.emplace_back(std::move(column));
+      Utils::DebugColumn(group_by_key_record_[i], type, "key");
       i++;
     }
   }
@@ -367,19 +427,19 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
           (aggregation.index_of_column() < 0 || aggregation.index_of_column() >= selection_column_indexes_.size())
               ? 0
               : aggregation.index_of_column();
-      std::any column =
-          Utils::CloneColumn(selection_record[index_of_column], (*group_by_operator_serial_schemas_)[i]->GetType());
-      if (!column.has_value()) {
+      BaseSchema::Type type = (*group_by_operator_serial_schemas_)[i]->GetType();
+      if (views[index_of_column].type != type) {
         std::string error_message = fmt::format(
-            "CloneColumn failed selection_record index_of_column : {}  group_by_operator_serial_schemas_ i : {}  "
+            "column type mismatch selection_record index_of_column : {}  group_by_operator_serial_schemas_ i : {}  "
             "group_by_operator_serial_schemas_ type : {}",
-            index_of_column, i, static_cast<int>((*group_by_operator_serial_schemas_)[i]->GetType()));
+            index_of_column, i, static_cast<int>(type));
         DINGO_LOG(ERROR) << error_message;
         return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
       }
+      original_record_decoder_->AssignAny(views[index_of_column], selection_column_indexes_[index_of_column],
+                                          group_by_operator_record_[i]);
       // debug
-      Utils::DebugColumn(column, (*group_by_operator_serial_schemas_)[i]->GetType(), "aggregation_operators");
-      group_by_operator_record.emplace_back(std::move(column));
+      Utils::DebugColumn(group_by_operator_record_[i], type, "aggregation_operators");
       i++;
     }
   }
@@ -391,7 +451,7 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
     int ret = 0;
     try {
       // group_by_key_record [0,1,2,3,4,5,6] sort, for group_by_key_serial_schemas_ in vector index no schema index
-      ret = group_by_key_encoder.EncodeKey(group_by_key_record, group_by_key);
+      ret = group_by_key_encoder.EncodeKey(group_by_key_record_, group_by_key);
     } catch (const std::exception& my_exception) {
       std::string error_message = fmt::format("serial::EncodeKey failed exception : {}", my_exception.what());
       DINGO_LOG(ERROR) << error_message;
@@ -416,7 +476,7 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
     }
   }
 
-  status = aggregation_manager_->Execute(group_by_key, group_by_operator_record);
+  status = aggregation_manager_->Execute(group_by_key, group_by_operator_record_);
   if (!status.ok()) {
     DINGO_LOG(ERROR) << fmt::format("AggregationManager::Execute failed");
     return status;
@@ -424,16 +484,26 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
   return butil::Status();
 }
 
-butil::Status Coprocessor::DoExecuteForSelection(const std::vector<std::any>& selection_record, bool* has_result_kv,
+butil::Status Coprocessor::DoExecuteForSelection(const std::vector<RecordViewDecoder::ColumnView>& views,
+                                                 const std::vector<std::any>* selection_record, bool* has_result_kv,
                                                  pb::common::KeyValue* result_kv) {
   butil::Status status;
+  if (selection_record == nullptr) {
+    // only the columns written to result are materialized
+    selection_record_.resize(views.size());
+    for (int index : result_column_indexes_) {
+      original_record_decoder_->AssignAny(views[index], selection_column_indexes_[index], selection_record_[index]);
+    }
+    selection_record = &selection_record_;
+  }
+
   // selection
   RecordEncoder result_record_encoder(coprocessor_.schema_version(), result_serial_schemas_sorted_,
                                       coprocessor_.result_schema().common_id());
   pb::common::KeyValue result_key_value;
   int ret = 0;
   try {
-    ret = result_record_encoder.Encode(selection_record, result_key_value);
+    ret = result_record_encoder.Encode(*selection_record, result_key_value);
   } catch (const std::exception& my_exception) {
     std::string error_message = fmt::format("serial::Encode failed exception : {}", my_exception.what());
     DINGO_LOG(ERROR) << error_message;
@@ -584,6 +654,7 @@ void Coprocessor::Close() {
   }
 
   enable_expression_ = false;
+  expression_filter_.Close();
   end_of_group_by_ = false;
 
   if (aggregation_manager_) {
@@ -596,6 +667,8 @@ void Coprocessor::Close() {
 
   original_column_indexes_.clear();
   selection_column_indexes_.clear();
+  result_column_indexes_.clear();
+  original_record_decoder_.reset();
 
   if (original_serial_schemas_sorted_) {
     original_serial_schemas_sorted_.reset();
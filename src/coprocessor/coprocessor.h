@@ -24,9 +24,11 @@
 
 #include "butil/status.h"
 #include "coprocessor/aggregation_manager.h"
+#include "coprocessor/expression_filter.h"
 #include "engine/iterator.h"
 #include "proto/store.pb.h"
 #include "scan/scan_filter.h"
+#include "serial/record_view_decoder.h"
 
 namespace dingodb {
 
@@ -47,11 +49,18 @@ class Coprocessor {
   void Close();
 
  private:
-  butil::Status DoExecute(const pb::common::KeyValue& kv, bool* has_result_kv, pb::common::KeyValue* result_kv);
+  butil::Status DoDecode(const pb::common::KeyValue& kv, std::vector<RecordViewDecoder::ColumnView>* views,
+                         std::vector<std::string>* key_strings);
 
-  butil::Status DoExecuteForAggregation(const std::vector<std::any>& selection_record);
+  // selection_record is the record materialized for the expression filter, nullptr if there is no filter.
+  butil::Status DoExecute(const std::vector<RecordViewDecoder::ColumnView>& views,
+                          const std::vector<std::any>* selection_record, bool* has_result_kv,
+                          pb::common::KeyValue* result_kv);
 
-  butil::Status DoExecuteForSelection(const std::vector<std::any>& selection_record, bool* has_result_kv,
+  butil::Status DoExecuteForAggregation(const std::vector<RecordViewDecoder::ColumnView>& views);
+
+  butil::Status DoExecuteForSelection(const std::vector<RecordViewDecoder::ColumnView>& views,
+                                      const std::vector<std::any>* selection_record, bool* has_result_kv,
                                       pb::common::KeyValue* result_kv);
   butil::Status GetKeyValueFromAggregation(bool key_only, size_t max_fetch_cnt, int64_t max_bytes_rpc,
                                            std::vector<pb::common::KeyValue>* kvs);
@@ -74,11 +83,24 @@ class Coprocessor {
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_serial_schemas_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> result_serial_schemas_;
   bool enable_expression_;
+  // decoded once in Open, evaluated for every batch of records
+  ExpressionFilter expression_filter_;
   bool end_of_group_by_;
   std::shared_ptr<AggregationManager> aggregation_manager_;
   std::shared_ptr<AggregationIterator> aggregation_iterator_;
   std::vector<int> original_column_indexes_;
   std::vector<int> selection_column_indexes_;
+  // the selection columns written to result, only they are materialized when there is no filter
+  std::vector<int> result_column_indexes_;
+  std::unique_ptr<RecordViewDecoder> original_record_decoder_;
+
+  // reused for every batch, the string columns are overwritten in place
+  std::vector<std::vector<RecordViewDecoder::ColumnView>> batch_views_;
+  std::vector<std::vector<std::string>> batch_key_strings_;
+  std::vector<std::vector<std::any>> batch_records_;
+  std::vector<std::any> selection_record_;
+  std::vector<std::any> group_by_key_record_;
+  std::vector<std::any> group_by_operator_record_;
 
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> original_serial_schemas_sorted_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> selection_serial_schemas_sorted_;
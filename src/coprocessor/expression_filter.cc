@@ -0,0 +1,119 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coprocessor/expression_filter.h"
+
+#include <any>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "proto/error.pb.h"
+
+// Must be after proto, otherwise it will cause naming collision. such as TYPE_STRING
+#include "libexpr/src/runner.h"
+
+namespace dingodb {
+
+ExpressionFilter::ExpressionFilter() : constant_result_(ConstantResult::kTrue) {}
+ExpressionFilter::~ExpressionFilter() { Close(); }
+
+butil::Status ExpressionFilter::Open(const std::string& expression) {
+  Close();
+
+  if (expression.empty()) {
+    constant_result_ = ConstantResult::kTrue;
+    return butil::Status();
+  }
+
+  runner_ = std::make_unique<expr::Runner>();
+  try {
+    runner_->Decode(reinterpret_cast<const expr::Byte*>(expression.c_str()), expression.length());
+  } catch (const std::exception& my_exception) {
+    std::string error_message = fmt::format("expr::Runner Decode failed. exception : {}", my_exception.what());
+    DINGO_LOG(ERROR) << error_message;
+    runner_.reset();
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+
+  constant_result_ = ConstantResult::kNone;
+
+  // A column reference takes an operator byte and an index, so the one byte expression is a constant(true, false or
+  // null), evaluate it once here.
+  if (expression.length() == 1) {
+    bool is_reserve = false;
+    std::vector<std::any> empty_record;
+    auto status = Run(empty_record, is_reserve);
+    if (!status.ok()) {
+      return status;
+    }
+    constant_result_ = is_reserve ? ConstantResult::kTrue : ConstantResult::kFalse;
+    DINGO_LOG(DEBUG) << fmt::format("ExpressionFilter::Open fold constant expression : {}", is_reserve);
+  }
+
+  return butil::Status();
+}
+
+void ExpressionFilter::Close() {
+  runner_.reset();
+  constant_result_ = ConstantResult::kTrue;
+}
+
+butil::Status ExpressionFilter::Filter(const std::vector<std::any>& record, bool& is_reserve) {
+  if (constant_result_ != ConstantResult::kNone) {
+    is_reserve = (constant_result_ == ConstantResult::kTrue);
+    return butil::Status();
+  }
+
+  return Run(record, is_reserve);
+}
+
+butil::Status ExpressionFilter::Filter(const std::vector<std::vector<std::any>>& records, std::vector<bool>& selected) {
+  if (constant_result_ != ConstantResult::kNone) {
+    selected.assign(records.size(), constant_result_ == ConstantResult::kTrue);
+    return butil::Status();
+  }
+
+  selected.resize(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    bool is_reserve = false;
+    auto status = Run(records[i], is_reserve);
+    if (!status.ok()) {
+      return status;
+    }
+    selected[i] = is_reserve;
+  }
+
+  return butil::Status();
+}
+
+butil::Status ExpressionFilter::Run(const std::vector<std::any>& record, bool& is_reserve) {
+  try {
+    runner_->BindTuple(reinterpret_cast<const expr::Tuple*>(&record));
+    runner_->Run();
+    expr::Wrap<bool> ok = runner_->GetResult<bool>();
+    is_reserve = ok.has_value() && ok.value();
+  } catch (const std::exception& my_exception) {
+    std::string error_message = fmt::format("expr::Runner Run failed. exception : {}", my_exception.what());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+
+  return butil::Status();
+}
+
+}  // namespace dingodb
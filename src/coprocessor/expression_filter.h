@@ -0,0 +1,71 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COPROCESSOR_EXPRESSION_FILTER_H_  // NOLINT
+#define DINGODB_COPROCESSOR_EXPRESSION_FILTER_H_
+
+#include <any>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "butil/status.h"
+
+namespace dingodb {
+
+namespace expr {
+class Runner;
+}  // namespace expr
+
+// Filter expression of coprocessor, the expression is decoded once and evaluated for every record.
+// The expression which has no column reference is folded to a constant, the caller can skip evaluation.
+class ExpressionFilter {
+ public:
+  ExpressionFilter();
+  ~ExpressionFilter();
+
+  ExpressionFilter(const ExpressionFilter& rhs) = delete;
+  ExpressionFilter& operator=(const ExpressionFilter& rhs) = delete;
+  ExpressionFilter(ExpressionFilter&& rhs) = delete;
+  ExpressionFilter& operator=(ExpressionFilter&& rhs) = delete;
+
+  // Decode the expression, empty expression means always true.
+  butil::Status Open(const std::string& expression);
+  void Close();
+
+  bool IsAlwaysTrue() const { return constant_result_ == ConstantResult::kTrue; }
+  bool IsAlwaysFalse() const { return constant_result_ == ConstantResult::kFalse; }
+
+  // Evaluate one record, null result is treated as false.
+  butil::Status Filter(const std::vector<std::any>& record, bool& is_reserve);
+
+  // Evaluate a batch of records, selected[i] is the result of records[i].
+  butil::Status Filter(const std::vector<std::vector<std::any>>& records, std::vector<bool>& selected);
+
+ private:
+  enum class ConstantResult {
+    kNone = 0,
+    kTrue = 1,
+    kFalse = 2,
+  };
+
+  butil::Status Run(const std::vector<std::any>& record, bool& is_reserve);
+
+  std::unique_ptr<expr::Runner> runner_;
+  ConstantResult constant_result_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COPROCESSOR_EXPRESSION_FILTER_H_  // NOLINT
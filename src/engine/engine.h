@@ -183,11 +183,13 @@ class Engine : public std::enable_shared_from_this<Engine> {
                                       int64_t txn_size, bool try_one_pc, int64_t max_commit_ts,
                                       const std::vector<int64_t>& pessimistic_checks,
                                       const std::map<int64_t, int64_t>& for_update_ts_checks,
-                                      const std::map<int64_t, std::string>& lock_extra_datas) = 0;
+                                      const std::map<int64_t, std::string>& lock_extra_datas, bool use_async_commit,
+                                      const std::vector<std::string>& secondaries) = 0;
     virtual butil::Status TxnCommit(std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
                                     const std::vector<std::string>& keys) = 0;
     virtual butil::Status TxnCheckTxnStatus(std::shared_ptr<Context> ctx, const std::string& primary_key,
-                                            int64_t lock_ts, int64_t caller_start_ts, int64_t current_ts) = 0;
+                                            int64_t lock_ts, int64_t caller_start_ts, int64_t current_ts,
+                                            bool rollback_if_not_exist) = 0;
     virtual butil::Status TxnResolveLock(std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
                                          const std::vector<std::string>& keys) = 0;
     virtual butil::Status TxnBatchRollback(std::shared_ptr<Context> ctx, int64_t start_ts,
@@ -16,6 +16,8 @@
 
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -27,6 +29,8 @@
 #include "butil/compiler_specific.h"
 #include "butil/endpoint.h"
 #include "butil/status.h"
+#include "bvar/latency_recorder.h"
+#include "bvar/status.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "common/role.h"
@@ -39,6 +43,7 @@
 #include "engine/write_data.h"
 #include "event/store_state_machine_event.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "meta/store_meta_manager.h"
 #include "proto/common.pb.h"
 #include "proto/coordinator_internal.pb.h"
@@ -54,6 +59,14 @@
 
 namespace dingodb {
 
+DEFINE_int32(raft_recover_concurrency, 8, "concurrency of recovering raft nodes at startup");
+
+// startup phase timings of recovering raft nodes
+static bvar::Status<int64_t> g_raft_recover_prepare_time_ms("dingo_raft_recover_prepare_time_ms", 0);
+static bvar::Status<int64_t> g_raft_recover_add_node_time_ms("dingo_raft_recover_add_node_time_ms", 0);
+static bvar::Status<int64_t> g_raft_recover_node_num("dingo_raft_recover_node_num", 0);
+static bvar::LatencyRecorder g_raft_recover_node_latency("dingo_raft_recover_node");
+
 RaftStoreEngine::RaftStoreEngine(std::shared_ptr<RawEngine> rocks_engine, std::shared_ptr<RawEngine> bdb_engine)
     : raw_rocks_engine(rocks_engine),
       raw_bdb_engine(bdb_engine),
@@ -95,8 +108,19 @@ static bool IsCompleteRaftNode(int64_t region_id, const std::string& raft_path,
   return true;
 }
 
+// The smaller value is recovered earlier.
+static int RecoverPriority(store::RegionPtr region) {
+  if (region->State() == pb::common::StoreRegionState::NORMAL) {
+    // the last leader probably is elected again, and clients send requests to it first
+    return region->LeaderId() == Server::GetInstance().Id() ? 0 : 1;
+  } else if (region->State() == pb::common::StoreRegionState::TOMBSTONE) {
+    return 3;
+  }
+  return 2;
+}
+
 // Recover raft node from region meta data.
-// Invoke when server starting.
+// Raft nodes are recovered in parallel, the recover order is decided by priority.
 bool RaftStoreEngine::Recover() {
   auto store_region_meta = GET_STORE_REGION_META;
   auto store_raft_meta = Server::GetInstance().GetStoreMetaManager()->GetStoreRaftMeta();
@@ -104,8 +128,23 @@ bool RaftStoreEngine::Recover() {
   auto config = ConfigManager::GetInstance().GetRoleConfig();
   auto regions = store_region_meta->GetAllRegion();
 
-  int count = 0;
-  auto ctx = std::make_shared<Context>();
+  struct RecoverItem {
+    store::RegionPtr region;
+    AddNodeParameter parameter;
+    int priority;
+  };
+
+  struct Parameter {
+    RaftStoreEngine* engine;
+    std::vector<RecoverItem> items;
+    std::atomic<int> offset;
+  };
+
+  int64_t start_time = Helper::TimestampMs();
+  auto param = std::make_shared<Parameter>();
+  param->engine = this;
+  param->offset = 0;
+
   auto listener_factory = std::make_shared<StoreSmEventListenerFactory>();
   for (auto& region : regions) {
     if (region->State() == pb::common::StoreRegionState::NORMAL ||
@@ -151,22 +190,58 @@ bool RaftStoreEngine::Recover() {
         parameter.is_restart = false;
       }
 
-      AddNode(region, parameter);
+      param->items.push_back({region, parameter, RecoverPriority(region)});
+    }
+  }
+
+  std::stable_sort(param->items.begin(), param->items.end(),
+                   [](const RecoverItem& a, const RecoverItem& b) { return a.priority < b.priority; });
+  g_raft_recover_prepare_time_ms.set_value(Helper::TimestampMs() - start_time);
+
+  auto task = [](void* arg) -> void* {
+    if (arg == nullptr) {
+      return nullptr;
+    }
+    auto* param = static_cast<Parameter*>(arg);
+
+    for (;;) {
+      int offset = param->offset.fetch_add(1, std::memory_order_relaxed);
+      if (offset >= param->items.size()) {
+        break;
+      }
+
+      auto& item = param->items[offset];
+      auto region = item.region;
+      int64_t start_time = Helper::TimestampNs();
+      param->engine->AddNode(region, item.parameter);
       if (region->NeedBootstrapDoSnapshot()) {
         DINGO_LOG(INFO) << fmt::format("[raft.engine][region({})] need do snapshot.", region->Id());
-        auto node = GetNode(region->Id());
+        auto node = param->engine->GetNode(region->Id());
         if (node != nullptr) {
           auto ctx = std::make_shared<Context>();
           ctx->SetRegionId(region->Id());
           node->Snapshot(ctx, true);
         }
       }
-
-      ++count;
+      g_raft_recover_node_latency << (Helper::TimestampNs() - start_time) / 1000;
     }
+
+    return nullptr;
+  };
+
+  int64_t add_node_start_time = Helper::TimestampMs();
+  int concurrency = std::min(std::max(FLAGS_raft_recover_concurrency, 1), static_cast<int>(param->items.size()));
+  if (concurrency > 0 && !Helper::ParallelRunTask(task, param.get(), concurrency)) {
+    DINGO_LOG(ERROR) << "[raft.engine][region(*)] recover raft node failed, create bthread failed.";
+    return false;
   }
+  g_raft_recover_add_node_time_ms.set_value(Helper::TimestampMs() - add_node_start_time);
+  g_raft_recover_node_num.set_value(param->items.size());
 
-  DINGO_LOG(INFO) << fmt::format("[raft.engine][region(*)] recover Raft node num({}).", count);
+  DINGO_LOG(INFO) << fmt::format(
+      "[raft.engine][region(*)] recover Raft node num({}) concurrency({}) prepare({}ms) add node({}ms).",
+      param->items.size(), concurrency, g_raft_recover_prepare_time_ms.get_value(),
+      g_raft_recover_add_node_time_ms.get_value());
 
   return true;
 }
@@ -555,10 +630,11 @@ butil::Status RaftStoreEngine::TxnWriter::TxnPrewrite(
     std::shared_ptr<Context> ctx, const std::vector<pb::store::Mutation>& mutations, const std::string& primary_lock,
     int64_t start_ts, int64_t lock_ttl, int64_t txn_size, bool try_one_pc, int64_t max_commit_ts,
     const std::vector<int64_t>& pessimistic_checks, const std::map<int64_t, int64_t>& for_update_ts_checks,
-    const std::map<int64_t, std::string>& lock_extra_datas) {
+    const std::map<int64_t, std::string>& lock_extra_datas, bool use_async_commit,
+    const std::vector<std::string>& secondaries) {
   return TxnEngineHelper::Prewrite(txn_writer_raw_engine_, raft_engine_, ctx, mutations, primary_lock, start_ts,
                                    lock_ttl, txn_size, try_one_pc, max_commit_ts, pessimistic_checks,
-                                   for_update_ts_checks, lock_extra_datas);
+                                   for_update_ts_checks, lock_extra_datas, use_async_commit, secondaries);
 }
 
 butil::Status RaftStoreEngine::TxnWriter::TxnCommit(std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
@@ -568,9 +644,10 @@ butil::Status RaftStoreEngine::TxnWriter::TxnCommit(std::shared_ptr<Context> ctx
 
 butil::Status RaftStoreEngine::TxnWriter::TxnCheckTxnStatus(std::shared_ptr<Context> ctx,
                                                             const std::string& primary_key, int64_t lock_ts,
-                                                            int64_t caller_start_ts, int64_t current_ts) {
+                                                            int64_t caller_start_ts, int64_t current_ts,
+                                                            bool rollback_if_not_exist) {
   return TxnEngineHelper::CheckTxnStatus(txn_writer_raw_engine_, raft_engine_, ctx, primary_key, lock_ts,
-                                         caller_start_ts, current_ts);
+                                         caller_start_ts, current_ts, rollback_if_not_exist);
 }
 
 butil::Status RaftStoreEngine::TxnWriter::TxnResolveLock(std::shared_ptr<Context> ctx, int64_t start_ts,
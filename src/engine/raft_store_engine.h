@@ -202,11 +202,12 @@ class RaftStoreEngine : public Engine, public RaftControlAble {
                               const std::string& primary_lock, int64_t start_ts, int64_t lock_ttl, int64_t txn_size,
                               bool try_one_pc, int64_t max_commit_ts, const std::vector<int64_t>& pessimistic_checks,
                               const std::map<int64_t, int64_t>& for_update_ts_checks,
-                              const std::map<int64_t, std::string>& lock_extra_datas) override;
+                              const std::map<int64_t, std::string>& lock_extra_datas, bool use_async_commit,
+                              const std::vector<std::string>& secondaries) override;
     butil::Status TxnCommit(std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
                             const std::vector<std::string>& keys) override;
     butil::Status TxnCheckTxnStatus(std::shared_ptr<Context> ctx, const std::string& primary_key, int64_t lock_ts,
-                                    int64_t caller_start_ts, int64_t current_ts) override;
+                                    int64_t caller_start_ts, int64_t current_ts, bool rollback_if_not_exist) override;
     butil::Status TxnResolveLock(std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
                                  const std::vector<std::string>& keys) override;
     butil::Status TxnBatchRollback(std::shared_ptr<Context> ctx, int64_t start_ts,
@@ -116,6 +116,14 @@ class RawEngine : public std::enable_shared_from_this<RawEngine> {
   virtual void Flush(const std::string& cf_name) = 0;
   virtual butil::Status Compact(const std::string& cf_name) = 0;
 
+  // Drop the files inside the range which is going to be deleted, call before KvDeleteRange.
+  virtual butil::Status DeleteFilesInRange(const std::vector<std::string>& /*cf_names*/,
+                                           const pb::common::Range& /*range*/) {
+    return butil::Status();
+  }
+  // Reclaim the space of the deleted range in background, e.g. the data of destroyed region.
+  virtual void GcRange(const std::vector<std::string>& /*cf_names*/, const pb::common::Range& /*range*/) {}
+
  protected:
   RawEngine() = default;
 };
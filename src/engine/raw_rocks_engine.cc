@@ -42,6 +42,7 @@
 #include "config/config_helper.h"
 #include "engine/raw_engine.h"
 #include "engine/snapshot.h"
+#include "engine/txn_gc_compaction_filter.h"
 #include "fmt/core.h"
 #include "google/protobuf/message_lite.h"
 #include "proto/common.pb.h"
@@ -756,20 +757,20 @@ bool CastValue(std::string value, std::string& dst_value) {
 }
 
 // set cf config
-static rocksdb::ColumnFamilyOptions GenRcoksDBColumnFamilyOptions(rocks::ColumnFamilyPtr column_family) {
+static rocksdb::ColumnFamilyOptions GenRcoksDBColumnFamilyOptions(
+    rocks::ColumnFamilyPtr column_family, rocks::MemoryGovernorPtr memory_governor,
+    rocks::TxnWriteCompactionFilterFactoryPtr txn_write_compaction_filter_factory) {
   rocksdb::ColumnFamilyOptions family_options;
   rocksdb::BlockBasedTableOptions table_options;
 
   // block_size
   CastValue(column_family->GetConfItem(Constant::kBlockSize), table_options.block_size);
 
-  // block_cache
-  {
-    size_t option_value = 0;
-    CastValue(column_family->GetConfItem(Constant::kBlockCache), option_value);
-
-    table_options.block_cache = rocksdb::NewLRUCache(option_value);  // LRUcache
-  }
+  // block_cache, shared by all column families
+  table_options.block_cache = memory_governor->GetBlockCache(column_family->Name());
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.cache_index_and_filter_blocks_with_high_priority = true;
+  table_options.pin_l0_filter_and_index_blocks_in_cache = true;
 
   // arena_block_size
   CastValue(column_family->GetConfItem(Constant::kArenaBlockSize), family_options.arena_block_size);
@@ -818,21 +819,45 @@ static rocksdb::ColumnFamilyOptions GenRcoksDBColumnFamilyOptions(rocks::ColumnF
   rocksdb::TableFactory* table_factory = NewBlockBasedTableFactory(table_options);
   family_options.table_factory.reset(table_factory);
 
+  // mvcc gc of txn
+  if (column_family->Name() == Constant::kTxnWriteCF) {
+    family_options.compaction_filter_factory = txn_write_compaction_filter_factory;
+  }
+
   return family_options;
 }
 
-static rocksdb::DB* InitDB(const std::string& db_path, rocks::ColumnFamilyMap& column_families) {
+// The block cache capacity is store.block_cache_size, if not configured it is the sum of block_cache of column
+// families, which is the memory used by the separate caches before.
+static rocks::MemoryGovernorPtr NewMemoryGovernor(rocks::ColumnFamilyMap& column_families) {
+  size_t capacity = ConfigHelper::GetRocksDBBlockCacheSize();
+  if (capacity == 0) {
+    for (auto [_, column_family] : column_families) {
+      size_t block_cache = 0;
+      CastValue(column_family->GetConfItem(Constant::kBlockCache), block_cache);
+      capacity += block_cache;
+    }
+  }
+
+  return rocks::MemoryGovernor::New(capacity, ConfigHelper::GetRocksDBWriteBufferRatio());
+}
+
+static rocksdb::DB* InitDB(const std::string& db_path, rocks::ColumnFamilyMap& column_families,
+                           rocks::MemoryGovernorPtr memory_governor,
+                           rocks::TxnWriteCompactionFilterFactoryPtr txn_write_compaction_filter_factory) {
   // Cast ColumnFamily to rocksdb::ColumnFamilyOptions
   std::vector<rocksdb::ColumnFamilyDescriptor> column_family_descs;
   for (auto [cf_name, column_family] : column_families) {
     column_family->Dump();
-    rocksdb::ColumnFamilyOptions family_options = GenRcoksDBColumnFamilyOptions(column_family);
+    rocksdb::ColumnFamilyOptions family_options =
+        GenRcoksDBColumnFamilyOptions(column_family, memory_governor, txn_write_compaction_filter_factory);
     column_family_descs.push_back(rocksdb::ColumnFamilyDescriptor(cf_name, family_options));
   }
 
   rocksdb::DBOptions db_options;
   db_options.create_if_missing = true;
   db_options.create_missing_column_families = true;
+  db_options.write_buffer_manager = memory_governor->GetWriteBufferManager();
   db_options.max_background_jobs = ConfigHelper::GetRocksDBBackgroundThreadNum();
   db_options.max_subcompactions = db_options.max_background_jobs / 4 * 3;
   db_options.stats_dump_period_sec = ConfigHelper::GetRocksDBStatsDumpPeriodSec();
@@ -876,13 +901,22 @@ bool RawRocksEngine::Init(std::shared_ptr<Config> config, const std::vector<std:
   auto column_families = GenColumnFamilyByDefaultConfig(cf_names);
   SetColumnFamilyCustomConfig(config, column_families);
 
-  rocksdb::DB* db = InitDB(db_path_, column_families);
+  auto memory_governor = NewMemoryGovernor(column_families);
+  auto txn_write_compaction_filter_factory = std::make_shared<rocks::TxnWriteCompactionFilterFactory>();
+  rocksdb::DB* db = InitDB(db_path_, column_families, memory_governor, txn_write_compaction_filter_factory);
   if (db == nullptr) {
     DINGO_LOG(ERROR) << fmt::format("[rocksdb] open failed, path: {}", db_path_);
     return false;
   }
+  auto data_cf_it = column_families.find(Constant::kTxnDataCF);
+  if (data_cf_it != column_families.end()) {
+    txn_write_compaction_filter_factory->SetDB(db, data_cf_it->second->GetHandle());
+  }
+  memory_governor_ = memory_governor;
+  txn_write_compaction_filter_factory_ = txn_write_compaction_filter_factory;
   column_families_ = column_families;
   db_.reset(db);
+  range_gc_ = rocks::RangeGc::New(db);
 
   reader_ = std::make_shared<rocks::Reader>(GetSelfPtr());
   writer_ = std::make_shared<rocks::Writer>(GetSelfPtr());
@@ -1091,11 +1125,50 @@ butil::Status RawRocksEngine::Compact(const std::string& cf_name) {
   return butil::Status();
 }
 
+butil::Status RawRocksEngine::DeleteFilesInRange(const std::vector<std::string>& cf_names,
+                                                 const pb::common::Range& range) {
+  if (range_gc_ == nullptr) {
+    return butil::Status();
+  }
+
+  for (const auto& cf_name : cf_names) {
+    if (!range_gc_->DeleteFilesInRange(cf_name, GetColumnFamily(cf_name)->GetHandle(), range.start_key(),
+                                       range.end_key())) {
+      return butil::Status(pb::error::EINTERNAL, "Delete files in range failed, column family %s", cf_name.c_str());
+    }
+  }
+
+  return butil::Status();
+}
+
+void RawRocksEngine::GcRange(const std::vector<std::string>& cf_names, const pb::common::Range& range) {
+  if (range_gc_ == nullptr) {
+    return;
+  }
+
+  for (const auto& cf_name : cf_names) {
+    range_gc_->AddRange(cf_name, GetColumnFamily(cf_name)->GetHandle(), range.start_key(), range.end_key());
+  }
+}
+
+void RawRocksEngine::RunRangeGc() {
+  if (range_gc_ != nullptr) {
+    range_gc_->Run();
+  }
+}
+
 void RawRocksEngine::Destroy() { rocksdb::DestroyDB(db_path_, rocksdb::Options()); }
 
 void RawRocksEngine::Close() {
+  if (range_gc_ != nullptr) {
+    range_gc_->Stop();
+  }
+
   if (db_) {
     CancelAllBackgroundWork(db_.get(), true);
+    if (txn_write_compaction_filter_factory_ != nullptr) {
+      txn_write_compaction_filter_factory_->SetDB(nullptr, nullptr);
+    }
 
     std::vector<rocksdb::ColumnFamilyHandle*> column_family_handles;
     for (auto& [_, column_family] : column_families_) {
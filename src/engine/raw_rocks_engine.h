@@ -27,6 +27,9 @@
 #include "config/config.h"
 #include "engine/iterator.h"
 #include "engine/raw_engine.h"
+#include "engine/rocks_memory_governor.h"
+#include "engine/rocks_range_gc.h"
+#include "engine/txn_gc_compaction_filter.h"
 #include "engine/snapshot.h"
 #include "proto/common.pb.h"
 #include "proto/store_internal.pb.h"
@@ -285,6 +288,12 @@ class RawRocksEngine : public RawEngine {
   void Flush(const std::string& cf_name) override;
   butil::Status Compact(const std::string& cf_name) override;
 
+  butil::Status DeleteFilesInRange(const std::vector<std::string>& cf_names, const pb::common::Range& range) override;
+  void GcRange(const std::vector<std::string>& cf_names, const pb::common::Range& range) override;
+  // Gc the deleted ranges, called by crontab.
+  void RunRangeGc();
+  rocks::RangeGcPtr GetRangeGc() { return range_gc_; }
+
   std::vector<int64_t> GetApproximateSizes(const std::string& cf_name, std::vector<pb::common::Range>& ranges) override;
 
  private:
@@ -299,8 +308,14 @@ class RawRocksEngine : public RawEngine {
   std::vector<rocks::ColumnFamilyPtr> GetColumnFamilies(const std::vector<std::string>& cf_names);
 
   std::string db_path_;
+  // shared block cache and memtable budget, released after db
+  rocks::MemoryGovernorPtr memory_governor_;
+  // drop garbage versions of txn write column family
+  rocks::TxnWriteCompactionFilterFactoryPtr txn_write_compaction_filter_factory_;
   std::shared_ptr<rocksdb::DB> db_;
   rocks::ColumnFamilyMap column_families_;
+  // drop files and compact the deleted ranges
+  rocks::RangeGcPtr range_gc_;
 
   RawEngine::ReaderPtr reader_;
   RawEngine::WriterPtr writer_;
@@ -0,0 +1,94 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/rocks_memory_governor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "common/constant.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "metrics/store_bvar_metrics.h"
+
+namespace dingodb {
+
+DEFINE_bool(rocksdb_block_cache_use_clock, true, "use hyper clock cache as block cache, otherwise use lru cache");
+DEFINE_int64(rocksdb_block_cache_estimated_entry_charge, 64 * 1024, "estimated charge of block cache entry");
+DEFINE_double(rocksdb_block_cache_high_pri_pool_ratio, 0.2, "lru cache capacity ratio for index and filter blocks");
+
+namespace rocks {
+
+ColumnFamilyBlockCache::ColumnFamilyBlockCache(std::shared_ptr<rocksdb::Cache> target, const std::string& cf_name)
+    : rocksdb::CacheWrapper(std::move(target)),
+      hit_counter_(StoreBvarMetrics::GetInstance().GetBlockCacheHitCounter(cf_name)),
+      miss_counter_(StoreBvarMetrics::GetInstance().GetBlockCacheMissCounter(cf_name)) {
+  StoreBvarMetrics::GetInstance().ExposeBlockCacheHitRate(cf_name);
+}
+
+rocksdb::Cache::Handle* ColumnFamilyBlockCache::Lookup(const rocksdb::Slice& key, const CacheItemHelper* helper,
+                                                       CreateContext* create_context, Priority priority,
+                                                       rocksdb::Statistics* stats) {
+  auto* handle = target_->Lookup(key, helper, create_context, priority, stats);
+  auto* counter = handle != nullptr ? hit_counter_ : miss_counter_;
+  if (counter != nullptr) {
+    *counter << 1;
+  }
+  return handle;
+}
+
+MemoryGovernor::MemoryGovernor(size_t capacity, double write_buffer_ratio) : capacity_(capacity) {
+  if (FLAGS_rocksdb_block_cache_use_clock) {
+    rocksdb::HyperClockCacheOptions cache_options(capacity, FLAGS_rocksdb_block_cache_estimated_entry_charge,
+                                                  Constant::kRocksdbBlockCacheNumShardBitsDefault);
+    block_cache_ = cache_options.MakeSharedCache();
+  } else {
+    rocksdb::LRUCacheOptions cache_options(capacity, Constant::kRocksdbBlockCacheNumShardBitsDefault, false,
+                                           FLAGS_rocksdb_block_cache_high_pri_pool_ratio);
+    block_cache_ = cache_options.MakeSharedCache();
+  }
+
+  // memtables are charged to block cache, flush is triggered when memtables exceed the budget
+  size_t write_buffer_size = static_cast<size_t>(static_cast<double>(capacity) * write_buffer_ratio);
+  write_buffer_manager_ = std::make_shared<rocksdb::WriteBufferManager>(write_buffer_size, block_cache_, false);
+
+  DINGO_LOG(INFO) << fmt::format("[rocksdb] memory governor capacity({}) write_buffer_size({}) cache({})", capacity,
+                                 write_buffer_size, block_cache_->Name());
+}
+
+std::shared_ptr<rocksdb::Cache> MemoryGovernor::GetBlockCache(const std::string& cf_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = cf_block_caches_.find(cf_name);
+  if (it != cf_block_caches_.end()) {
+    return it->second;
+  }
+
+  auto cf_block_cache = std::make_shared<ColumnFamilyBlockCache>(block_cache_, cf_name);
+  cf_block_caches_[cf_name] = cf_block_cache;
+  return cf_block_cache;
+}
+
+size_t MemoryGovernor::GetBlockCacheUsage() const { return block_cache_->GetUsage(); }
+
+size_t MemoryGovernor::GetMemTableUsage() const { return write_buffer_manager_->memory_usage(); }
+
+}  // namespace rocks
+
+}  // namespace dingodb
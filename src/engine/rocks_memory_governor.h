@@ -0,0 +1,90 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_ROCKS_MEMORY_GOVERNOR_H_  // NOLINT
+#define DINGODB_ENGINE_ROCKS_MEMORY_GOVERNOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "bvar/reducer.h"
+#include "rocksdb/advanced_cache.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/write_buffer_manager.h"
+
+namespace dingodb {
+
+namespace rocks {
+
+// Block cache of one column family, it forwards to the shared cache and counts hit and miss of the column family.
+class ColumnFamilyBlockCache : public rocksdb::CacheWrapper {
+ public:
+  ColumnFamilyBlockCache(std::shared_ptr<rocksdb::Cache> target, const std::string& cf_name);
+  ~ColumnFamilyBlockCache() override = default;
+
+  Handle* Lookup(const rocksdb::Slice& key, const CacheItemHelper* helper, CreateContext* create_context,
+                 Priority priority, rocksdb::Statistics* stats) override;
+
+ private:
+  bvar::Adder<int64_t>* hit_counter_;
+  bvar::Adder<int64_t>* miss_counter_;
+};
+
+// Store-wide memory budget of rocksdb. All column families share one sharded block cache, and the memtables are
+// charged to the same cache by WriteBufferManager, so memory can shift between hot and cold column families and the
+// total is bounded by the capacity.
+class MemoryGovernor {
+ public:
+  // write_buffer_ratio is the part of capacity can be used by memtables.
+  MemoryGovernor(size_t capacity, double write_buffer_ratio);
+  ~MemoryGovernor() = default;
+
+  MemoryGovernor(const MemoryGovernor& rhs) = delete;
+  MemoryGovernor& operator=(const MemoryGovernor& rhs) = delete;
+  MemoryGovernor(MemoryGovernor&& rhs) = delete;
+  MemoryGovernor& operator=(MemoryGovernor&& rhs) = delete;
+
+  static std::shared_ptr<MemoryGovernor> New(size_t capacity, double write_buffer_ratio) {
+    return std::make_shared<MemoryGovernor>(capacity, write_buffer_ratio);
+  }
+
+  // Block cache of column family, backed by the shared cache.
+  std::shared_ptr<rocksdb::Cache> GetBlockCache(const std::string& cf_name);
+  std::shared_ptr<rocksdb::WriteBufferManager> GetWriteBufferManager() const { return write_buffer_manager_; }
+
+  size_t GetCapacity() const { return capacity_; }
+  // include the memtables charged to cache
+  size_t GetBlockCacheUsage() const;
+  size_t GetMemTableUsage() const;
+
+ private:
+  size_t capacity_;
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager_;
+
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<rocksdb::Cache>> cf_block_caches_;
+};
+
+using MemoryGovernorPtr = std::shared_ptr<MemoryGovernor>;
+
+}  // namespace rocks
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_ROCKS_MEMORY_GOVERNOR_H_  // NOLINT
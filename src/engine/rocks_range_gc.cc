@@ -0,0 +1,199 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/rocks_range_gc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "rocksdb/convenience.h"
+#include "rocksdb/options.h"
+
+namespace dingodb {
+
+DEFINE_bool(enable_rocks_range_gc, true, "enable drop files and compact the deleted range of destroyed region");
+DEFINE_int64(rocks_range_gc_delay_s, 60, "delay time of gc deleted range, wait the snapshot and iterator finish");
+DEFINE_int32(rocks_range_gc_max_range_per_run, 8, "max range count of one gc round");
+
+namespace rocks {
+
+RangeGc::RangeGc(rocksdb::DB* db)
+    : db_(db),
+      pending_count_metrics_("dingo_rocks_range_gc_pending_count"),
+      finish_count_metrics_("dingo_rocks_range_gc_finish_count"),
+      fail_count_metrics_("dingo_rocks_range_gc_fail_count"),
+      gc_latency_("dingo_rocks_range_gc_latency") {
+  bthread_mutex_init(&mutex_, nullptr);
+}
+
+RangeGc::~RangeGc() { bthread_mutex_destroy(&mutex_); }
+
+bool RangeGc::DeleteFilesInRange(const std::string& cf_name, rocksdb::ColumnFamilyHandle* handle,
+                                 const std::string& start_key, const std::string& end_key) {
+  if (!FLAGS_enable_rocks_range_gc || start_key >= end_key) {
+    return true;
+  }
+
+  rocksdb::Slice start(start_key);
+  rocksdb::Slice end(end_key);
+  auto status = rocksdb::DeleteFilesInRange(db_, handle, &start, &end, false);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("[rocksdb.range_gc] delete files in range failed, cf({}) range[{}, {}) error: {}",
+                                    cf_name, Helper::StringToHex(start_key), Helper::StringToHex(end_key),
+                                    status.ToString());
+    return false;
+  }
+
+  drop_files_count_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void RangeGc::AddRange(const std::string& cf_name, rocksdb::ColumnFamilyHandle* handle, const std::string& start_key,
+                       const std::string& end_key) {
+  if (start_key >= end_key) {
+    return;
+  }
+
+  Task task{cf_name, handle, start_key, end_key, Helper::TimestampMs()};
+
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  for (auto it = tasks_.begin(); it != tasks_.end();) {
+    if (it->cf_name == cf_name && it->start_key <= task.end_key && task.start_key <= it->end_key) {
+      task.start_key = std::min(task.start_key, it->start_key);
+      task.end_key = std::max(task.end_key, it->end_key);
+      it = tasks_.erase(it);
+      pending_count_metrics_ << -1;
+    } else {
+      ++it;
+    }
+  }
+
+  DINGO_LOG(DEBUG) << fmt::format("[rocksdb.range_gc] add range cf({}) range[{}, {})", cf_name,
+                                  Helper::StringToHex(task.start_key), Helper::StringToHex(task.end_key));
+
+  tasks_.push_back(std::move(task));
+  pending_count_metrics_ << 1;
+}
+
+std::vector<RangeGc::Task> RangeGc::TakeExpiredTasks() {
+  std::vector<Task> expired_tasks;
+  int64_t now_ms = Helper::TimestampMs();
+
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  for (auto it = tasks_.begin(); it != tasks_.end();) {
+    if (static_cast<int32_t>(expired_tasks.size()) >= FLAGS_rocks_range_gc_max_range_per_run) {
+      break;
+    }
+
+    if (it->delete_time_ms + FLAGS_rocks_range_gc_delay_s * 1000 <= now_ms) {
+      expired_tasks.push_back(std::move(*it));
+      it = tasks_.erase(it);
+      pending_count_metrics_ << -1;
+    } else {
+      ++it;
+    }
+  }
+
+  return expired_tasks;
+}
+
+void RangeGc::Run() {
+  if (!FLAGS_enable_rocks_range_gc) {
+    return;
+  }
+  // the previous round is not finished
+  if (running_.exchange(true)) {
+    return;
+  }
+  if (canceled_.load()) {
+    running_.store(false);
+    return;
+  }
+
+  auto tasks = TakeExpiredTasks();
+  for (const auto& task : tasks) {
+    if (canceled_.load()) {
+      break;
+    }
+
+    int64_t start_time = Helper::TimestampMs();
+    if (GcRange(task)) {
+      finish_count_.fetch_add(1, std::memory_order_relaxed);
+      finish_count_metrics_ << 1;
+    } else {
+      fail_count_metrics_ << 1;
+    }
+    gc_latency_ << Helper::TimestampMs() - start_time;
+  }
+
+  running_.store(false);
+}
+
+void RangeGc::Stop() {
+  canceled_.store(true);
+  while (running_.load()) {
+    bthread_usleep(10 * 1000);
+  }
+
+  BAIDU_SCOPED_LOCK(mutex_);
+  pending_count_metrics_ << -static_cast<int64_t>(tasks_.size());
+  tasks_.clear();
+}
+
+int64_t RangeGc::PendingCount() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return tasks_.size();
+}
+
+bool RangeGc::GcRange(const Task& task) {
+  rocksdb::Slice start_key(task.start_key);
+  rocksdb::Slice end_key(task.end_key);
+
+  // Compact the left files to clean up the tombstones, wait instead of stall the foreground writes.
+  rocksdb::CompactRangeOptions options;
+  options.exclusive_manual_compaction = false;
+  options.allow_write_stall = false;
+  options.max_subcompactions = 1;
+  options.canceled = &canceled_;
+  auto status = db_->CompactRange(options, task.handle, &start_key, &end_key);
+  if (!status.ok()) {
+    if (canceled_.load()) {
+      return false;
+    }
+    DINGO_LOG(ERROR) << fmt::format("[rocksdb.range_gc] compact range failed, cf({}) range[{}, {}) error: {}",
+                                    task.cf_name, Helper::StringToHex(task.start_key),
+                                    Helper::StringToHex(task.end_key), status.ToString());
+    return false;
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[rocksdb.range_gc] gc range finish, cf({}) range[{}, {})", task.cf_name,
+                                 Helper::StringToHex(task.start_key), Helper::StringToHex(task.end_key));
+
+  return true;
+}
+
+}  // namespace rocks
+
+}  // namespace dingodb
@@ -0,0 +1,107 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_ROCKS_RANGE_GC_H_  // NOLINT
+#define DINGODB_ENGINE_ROCKS_RANGE_GC_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "bvar/latency_recorder.h"
+#include "bvar/reducer.h"
+#include "rocksdb/db.h"
+
+namespace dingodb {
+
+namespace rocks {
+
+// Reclaim the space of deleted ranges, e.g. the data of region destroyed after split/merge/migration.
+// DeleteRange only leaves range tombstones, which slow down the iterators of neighbouring regions until compaction.
+// The sst files inside the range are dropped by DeleteFilesInRange before writing the tombstone, the gc then compacts
+// just the range at low priority to clean up the tombstone and the keys of the partly overlapping files.
+class RangeGc {
+ public:
+  RangeGc(rocksdb::DB* db);
+  ~RangeGc();
+
+  RangeGc(const RangeGc& rhs) = delete;
+  RangeGc& operator=(const RangeGc& rhs) = delete;
+  RangeGc(RangeGc&& rhs) = delete;
+  RangeGc& operator=(RangeGc&& rhs) = delete;
+
+  static std::shared_ptr<RangeGc> New(rocksdb::DB* db) { return std::make_shared<RangeGc>(db); }
+
+  // Drop the sst files inside [start_key, end_key), must be called before writing the range tombstone, otherwise the
+  // file holding the tombstone may be dropped and the keys of partly overlapping files come back.
+  bool DeleteFilesInRange(const std::string& cf_name, rocksdb::ColumnFamilyHandle* handle,
+                          const std::string& start_key, const std::string& end_key);
+
+  // Add deleted range [start_key, end_key), merge with the overlapping or adjacent pending range of column family.
+  void AddRange(const std::string& cf_name, rocksdb::ColumnFamilyHandle* handle, const std::string& start_key,
+                const std::string& end_key);
+
+  // Gc the pending ranges which delete time exceed rocks_range_gc_delay_s, called by crontab.
+  void Run();
+
+  // Cancel the running compaction and wait it finish, drop the pending ranges, call before close db.
+  void Stop();
+
+  int64_t PendingCount();
+  int64_t FinishCount() const { return finish_count_.load(std::memory_order_relaxed); }
+  int64_t DropFilesCount() const { return drop_files_count_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Task {
+    std::string cf_name;
+    rocksdb::ColumnFamilyHandle* handle;
+    std::string start_key;
+    std::string end_key;
+    // the latest delete time of range
+    int64_t delete_time_ms;
+  };
+
+  std::vector<Task> TakeExpiredTasks();
+  bool GcRange(const Task& task);
+
+  rocksdb::DB* db_;
+
+  bthread_mutex_t mutex_;
+  // the pending ranges are not overlapping in one column family
+  std::list<Task> tasks_;
+
+  std::atomic<bool> running_{false};
+  std::atomic<bool> canceled_{false};
+
+  std::atomic<int64_t> finish_count_{0};
+  std::atomic<int64_t> drop_files_count_{0};
+
+  // progress of gc
+  bvar::Adder<int64_t> pending_count_metrics_;
+  bvar::Adder<int64_t> finish_count_metrics_;
+  bvar::Adder<int64_t> fail_count_metrics_;
+  bvar::LatencyRecorder gc_latency_;
+};
+
+using RangeGcPtr = std::shared_ptr<RangeGc>;
+
+}  // namespace rocks
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_ROCKS_RANGE_GC_H_  // NOLINT
@@ -607,7 +607,8 @@ butil::Status Storage::TxnPrewrite(std::shared_ptr<Context> ctx, const std::vect
                                    int64_t txn_size, bool try_one_pc, int64_t max_commit_ts,
                                    const std::vector<int64_t>& pessimistic_checks,
                                    const std::map<int64_t, int64_t>& for_update_ts_checks,
-                                   const std::map<int64_t, std::string>& lock_extra_datas) {
+                                   const std::map<int64_t, std::string>& lock_extra_datas, bool use_async_commit,
+                                   const std::vector<std::string>& secondaries) {
   auto status = ValidateLeader(ctx->RegionId());
   if (!status.ok()) {
     return status;
@@ -615,7 +616,8 @@ butil::Status Storage::TxnPrewrite(std::shared_ptr<Context> ctx, const std::vect
 
   DINGO_LOG(INFO) << "TxnPrewrite mutations size : " << mutations.size() << " primary_lock : " << primary_lock
                   << " start_ts : " << start_ts << " lock_ttl : " << lock_ttl << " txn_size : " << txn_size
-                  << " try_one_pc : " << try_one_pc << " max_commit_ts : " << max_commit_ts;
+                  << " try_one_pc : " << try_one_pc << " max_commit_ts : " << max_commit_ts
+                  << " use_async_commit : " << use_async_commit << " secondaries size : " << secondaries.size();
 
   auto writer = engine_->NewTxnWriter(ctx->RawEngineType());
   if (writer == nullptr) {
@@ -623,7 +625,8 @@ butil::Status Storage::TxnPrewrite(std::shared_ptr<Context> ctx, const std::vect
     return butil::Status(pb::error::EENGINE_NOT_FOUND, "writer is nullptr");
   }
   status = writer->TxnPrewrite(ctx, mutations, primary_lock, start_ts, lock_ttl, txn_size, try_one_pc, max_commit_ts,
-                               pessimistic_checks, for_update_ts_checks, lock_extra_datas);
+                               pessimistic_checks, for_update_ts_checks, lock_extra_datas, use_async_commit,
+                               secondaries);
   if (!status.ok()) {
     return status;
   }
@@ -655,21 +658,22 @@ butil::Status Storage::TxnCommit(std::shared_ptr<Context> ctx, int64_t start_ts,
 }
 
 butil::Status Storage::TxnCheckTxnStatus(std::shared_ptr<Context> ctx, const std::string& primary_key, int64_t lock_ts,
-                                         int64_t caller_start_ts, int64_t current_ts) {
+                                         int64_t caller_start_ts, int64_t current_ts, bool rollback_if_not_exist) {
   auto status = ValidateLeader(ctx->RegionId());
   if (!status.ok()) {
     return status;
   }
 
   DINGO_LOG(INFO) << "TxnCheckTxnStatus primary_key : " << primary_key << " lock_ts : " << lock_ts
-                  << " caller_start_ts : " << caller_start_ts << " current_ts : " << current_ts;
+                  << " caller_start_ts : " << caller_start_ts << " current_ts : " << current_ts
+                  << " rollback_if_not_exist : " << rollback_if_not_exist;
 
   auto writer = engine_->NewTxnWriter(ctx->RawEngineType());
   if (writer == nullptr) {
     DINGO_LOG(ERROR) << fmt::format("writer is nullptr, region_id : {}", ctx->RegionId());
     return butil::Status(pb::error::EENGINE_NOT_FOUND, "writer is nullptr");
   }
-  status = writer->TxnCheckTxnStatus(ctx, primary_key, lock_ts, caller_start_ts, current_ts);
+  status = writer->TxnCheckTxnStatus(ctx, primary_key, lock_ts, caller_start_ts, current_ts, rollback_if_not_exist);
   if (!status.ok()) {
     return status;
   }
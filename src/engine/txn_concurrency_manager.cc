@@ -0,0 +1,267 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/txn_concurrency_manager.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+
+namespace dingodb {
+
+DEFINE_int64(txn_memory_lock_wait_timeout_ms, 500,
+             "max wait time of read meets the memory lock of 1PC/async commit prewrite, return the lock on timeout");
+DEFINE_int64(txn_memory_lock_wait_interval_us, 1000, "check interval of read waiting the memory lock");
+
+TxnConcurrencyManager& TxnConcurrencyManager::GetInstance() {
+  static TxnConcurrencyManager instance;
+  return instance;
+}
+
+TxnConcurrencyManager::TxnConcurrencyManager()
+    : memory_lock_count_metrics_("dingo_txn_memory_lock_count"),
+      read_wait_count_metrics_("dingo_txn_memory_lock_read_wait_count"),
+      read_wait_timeout_count_metrics_("dingo_txn_memory_lock_read_wait_timeout_count"),
+      read_wait_latency_("dingo_txn_memory_lock_read_wait_latency") {
+  bthread_mutex_init(&mutex_, nullptr);
+}
+
+TxnConcurrencyManager::~TxnConcurrencyManager() { bthread_mutex_destroy(&mutex_); }
+
+void TxnConcurrencyManager::UpdateMaxTs(int64_t ts) {
+  int64_t max_ts = max_ts_.load();
+  while (ts > max_ts && !max_ts_.compare_exchange_weak(max_ts, ts)) {
+  }
+}
+
+void TxnConcurrencyManager::OnLeaderStart(int64_t region_id, int64_t term) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  max_ts_sync_states_[region_id] = MaxTsSyncState{term, false};
+  // the logs of previous terms are applied before leader start
+  UnlockDeferredKeysWithoutMutex(region_id);
+}
+
+void TxnConcurrencyManager::OnLeaderStop(int64_t region_id) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  max_ts_sync_states_.erase(region_id);
+  // the reads are served by the new leader
+  UnlockDeferredKeysWithoutMutex(region_id);
+}
+
+bool TxnConcurrencyManager::SyncMaxTs(int64_t region_id, int64_t term, int64_t tso) {
+  UpdateMaxTs(tso);
+
+  BAIDU_SCOPED_LOCK(mutex_);
+  auto it = max_ts_sync_states_.find(region_id);
+  if (it == max_ts_sync_states_.end() || it->second.term != term) {
+    return false;
+  }
+  it->second.is_synced = true;
+
+  return true;
+}
+
+bool TxnConcurrencyManager::IsMaxTsSyncing(int64_t region_id, int64_t term) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  auto it = max_ts_sync_states_.find(region_id);
+  return it != max_ts_sync_states_.end() && it->second.term == term && !it->second.is_synced;
+}
+
+bool TxnConcurrencyManager::IsMaxTsSynced(int64_t region_id) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  auto it = max_ts_sync_states_.find(region_id);
+  return it != max_ts_sync_states_.end() && it->second.is_synced;
+}
+
+bool TxnConcurrencyManager::LockKeys(const std::vector<pb::store::LockInfo>& lock_infos) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  for (const auto& lock_info : lock_infos) {
+    auto it = memory_locks_.find(lock_info.key());
+    if (it != memory_locks_.end() && it->second.lock_ts() != lock_info.lock_ts()) {
+      DINGO_LOG(INFO) << fmt::format("[txn.concurrency] key {} is locked in memory by start_ts {}, start_ts: {}",
+                                     Helper::StringToHex(lock_info.key()), it->second.lock_ts(), lock_info.lock_ts());
+      return false;
+    }
+  }
+
+  for (const auto& lock_info : lock_infos) {
+    if (memory_locks_.insert_or_assign(lock_info.key(), lock_info).second) {
+      memory_lock_count_metrics_ << 1;
+    }
+  }
+  memory_lock_count_.store(memory_locks_.size());
+
+  return true;
+}
+
+void TxnConcurrencyManager::UnlockKeys(const std::vector<pb::store::LockInfo>& lock_infos) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  UnlockKeysWithoutMutex(lock_infos);
+}
+
+void TxnConcurrencyManager::DeferUnlockKeys(int64_t region_id, int64_t start_ts,
+                                            const std::vector<pb::store::LockInfo>& lock_infos) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  if (max_ts_sync_states_.find(region_id) == max_ts_sync_states_.end()) {
+    UnlockKeysWithoutMutex(lock_infos);
+    return;
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[txn.concurrency][region({})] defer unlock keys, start_ts: {} keys_size: {}",
+                                 region_id, start_ts, lock_infos.size());
+
+  auto& txn_locks = deferred_locks_[region_id];
+  if (txn_locks.insert_or_assign(start_ts, lock_infos).second) {
+    deferred_txn_count_.fetch_add(1);
+  }
+}
+
+void TxnConcurrencyManager::OnTxnApplied(int64_t region_id, int64_t start_ts) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  auto region_it = deferred_locks_.find(region_id);
+  if (region_it == deferred_locks_.end()) {
+    return;
+  }
+  auto it = region_it->second.find(start_ts);
+  if (it == region_it->second.end()) {
+    return;
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[txn.concurrency][region({})] unlock deferred keys on applied, start_ts: {}",
+                                 region_id, start_ts);
+
+  UnlockKeysWithoutMutex(it->second);
+  region_it->second.erase(it);
+  deferred_txn_count_.fetch_sub(1);
+  if (region_it->second.empty()) {
+    deferred_locks_.erase(region_it);
+  }
+}
+
+void TxnConcurrencyManager::UnlockDeferredKeysWithoutMutex(int64_t region_id) {
+  auto region_it = deferred_locks_.find(region_id);
+  if (region_it == deferred_locks_.end()) {
+    return;
+  }
+
+  for (const auto& [start_ts, lock_infos] : region_it->second) {
+    DINGO_LOG(INFO) << fmt::format("[txn.concurrency][region({})] unlock deferred keys on leader change, start_ts: {}",
+                                   region_id, start_ts);
+    UnlockKeysWithoutMutex(lock_infos);
+  }
+  deferred_txn_count_.fetch_sub(region_it->second.size());
+  deferred_locks_.erase(region_it);
+}
+
+void TxnConcurrencyManager::UnlockKeysWithoutMutex(const std::vector<pb::store::LockInfo>& lock_infos) {
+  for (const auto& lock_info : lock_infos) {
+    auto it = memory_locks_.find(lock_info.key());
+    if (it != memory_locks_.end() && it->second.lock_ts() == lock_info.lock_ts()) {
+      memory_locks_.erase(it);
+      memory_lock_count_metrics_ << -1;
+    }
+  }
+  memory_lock_count_.store(memory_locks_.size());
+}
+
+bool TxnConcurrencyManager::FindBlockingLock(const std::vector<std::string>& keys, int64_t read_ts,
+                                             pb::store::LockInfo& lock_info) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  for (const auto& key : keys) {
+    auto it = memory_locks_.find(key);
+    if (it != memory_locks_.end() && it->second.lock_ts() <= read_ts) {
+      lock_info = it->second;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool TxnConcurrencyManager::FindBlockingLock(const std::string& start_key, const std::string& end_key,
+                                             int64_t read_ts, pb::store::LockInfo& lock_info) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  for (auto it = memory_locks_.lower_bound(start_key); it != memory_locks_.end() && it->first < end_key; ++it) {
+    if (it->second.lock_ts() <= read_ts) {
+      lock_info = it->second;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool TxnConcurrencyManager::WaitKeysUnlocked(const std::vector<std::string>& keys, int64_t read_ts,
+                                             pb::store::LockInfo& lock_info) {
+  if (memory_lock_count_.load() == 0 || !FindBlockingLock(keys, read_ts, lock_info)) {
+    return true;
+  }
+
+  read_wait_count_metrics_ << 1;
+  int64_t start_time_ms = Helper::TimestampMs();
+  while (Helper::TimestampMs() - start_time_ms < FLAGS_txn_memory_lock_wait_timeout_ms) {
+    bthread_usleep(FLAGS_txn_memory_lock_wait_interval_us);
+    if (!FindBlockingLock(keys, read_ts, lock_info)) {
+      read_wait_latency_ << Helper::TimestampMs() - start_time_ms;
+      return true;
+    }
+  }
+
+  read_wait_timeout_count_metrics_ << 1;
+  DINGO_LOG(INFO) << fmt::format("[txn.concurrency] wait memory lock timeout, read_ts: {} lock_info: {}", read_ts,
+                                 lock_info.ShortDebugString());
+
+  return false;
+}
+
+bool TxnConcurrencyManager::WaitRangeUnlocked(const std::string& start_key, const std::string& end_key,
+                                              int64_t read_ts, pb::store::LockInfo& lock_info) {
+  if (memory_lock_count_.load() == 0 || !FindBlockingLock(start_key, end_key, read_ts, lock_info)) {
+    return true;
+  }
+
+  read_wait_count_metrics_ << 1;
+  int64_t start_time_ms = Helper::TimestampMs();
+  while (Helper::TimestampMs() - start_time_ms < FLAGS_txn_memory_lock_wait_timeout_ms) {
+    bthread_usleep(FLAGS_txn_memory_lock_wait_interval_us);
+    if (!FindBlockingLock(start_key, end_key, read_ts, lock_info)) {
+      read_wait_latency_ << Helper::TimestampMs() - start_time_ms;
+      return true;
+    }
+  }
+
+  read_wait_timeout_count_metrics_ << 1;
+  DINGO_LOG(INFO) << fmt::format(
+      "[txn.concurrency] wait memory lock timeout, read_ts: {} range: [{}, {}) lock_info: {}", read_ts,
+      Helper::StringToHex(start_key), Helper::StringToHex(end_key), lock_info.ShortDebugString());
+
+  return false;
+}
+
+int64_t TxnConcurrencyManager::MemoryLockCount() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return memory_locks_.size();
+}
+
+}  // namespace dingodb
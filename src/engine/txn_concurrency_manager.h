@@ -0,0 +1,126 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_TXN_CONCURRENCY_MANAGER_H_  // NOLINT
+#define DINGODB_ENGINE_TXN_CONCURRENCY_MANAGER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "bvar/latency_recorder.h"
+#include "bvar/reducer.h"
+#include "gflags/gflags.h"
+#include "proto/store.pb.h"
+
+namespace dingodb {
+
+DECLARE_int64(txn_memory_lock_wait_timeout_ms);
+
+// Keep the commit_ts of 1PC and async commit transaction calculated by store greater than the start_ts of every read
+// which may miss the transaction.
+// Readers push max_ts forward before checking the locks, the prewrite locks the keys in memory before calculating
+// commit_ts = max_ts + 1, and unlocks them after the locks or the writes are applied, so the reader either sees the
+// lock or reads with a start_ts less than the commit_ts.
+// max_ts only covers the reads served by this store, the reads served by the previous leader are covered by a TSO
+// fetched after the region becomes leader here. 1PC and async commit of the region fall back to 2PC until then.
+// A proposal with uncertain result may still be applied later, its keys are kept locked until it is applied or the
+// leader of region changes.
+class TxnConcurrencyManager {
+ public:
+  static TxnConcurrencyManager& GetInstance();
+
+  TxnConcurrencyManager(const TxnConcurrencyManager& rhs) = delete;
+  TxnConcurrencyManager& operator=(const TxnConcurrencyManager& rhs) = delete;
+  TxnConcurrencyManager(TxnConcurrencyManager&& rhs) = delete;
+  TxnConcurrencyManager& operator=(TxnConcurrencyManager&& rhs) = delete;
+
+  // The max start_ts of reads served by this store.
+  void UpdateMaxTs(int64_t ts);
+  int64_t MaxTs() const { return max_ts_.load(); }
+
+  // The region becomes leader in term, max_ts is not synced until SyncMaxTs of the term.
+  void OnLeaderStart(int64_t region_id, int64_t term);
+  void OnLeaderStop(int64_t region_id);
+  // Push max_ts forward to tso which is fetched after the region becomes leader in term.
+  // Return false if the region is not leader in term any more.
+  bool SyncMaxTs(int64_t region_id, int64_t term, int64_t tso);
+  // Return true if the region is leader in term and max_ts is not synced yet.
+  bool IsMaxTsSyncing(int64_t region_id, int64_t term);
+  bool IsMaxTsSynced(int64_t region_id);
+
+  // Lock the keys of lock_infos in memory, return false if any key is locked by other transaction.
+  bool LockKeys(const std::vector<pb::store::LockInfo>& lock_infos);
+  void UnlockKeys(const std::vector<pb::store::LockInfo>& lock_infos);
+  // The result of the proposal with the keys locked is uncertain, e.g. raft log commit failed on leader change, the
+  // new leader may still commit it. Keep the keys locked until the transaction start_ts is applied in the region, or
+  // unlock them now if the region is not leader any more.
+  void DeferUnlockKeys(int64_t region_id, int64_t start_ts, const std::vector<pb::store::LockInfo>& lock_infos);
+  // The locks or writes of transaction start_ts are applied in the region, unlock the deferred keys of it.
+  void OnTxnApplied(int64_t region_id, int64_t start_ts);
+  bool HasDeferredLocks() const { return deferred_txn_count_.load() > 0; }
+
+  // Wait the memory locks of keys which lock_ts <= read_ts released, at most txn_memory_lock_wait_timeout_ms.
+  // Return false on timeout, lock_info is the memory lock which blocks the read.
+  bool WaitKeysUnlocked(const std::vector<std::string>& keys, int64_t read_ts, pb::store::LockInfo& lock_info);
+  // Same as WaitKeysUnlocked, for keys in range [start_key, end_key).
+  bool WaitRangeUnlocked(const std::string& start_key, const std::string& end_key, int64_t read_ts,
+                         pb::store::LockInfo& lock_info);
+
+  int64_t MemoryLockCount();
+
+ private:
+  TxnConcurrencyManager();
+  ~TxnConcurrencyManager();
+
+  // Return true if some key blocks the read, lock_info is the first one.
+  bool FindBlockingLock(const std::vector<std::string>& keys, int64_t read_ts, pb::store::LockInfo& lock_info);
+  bool FindBlockingLock(const std::string& start_key, const std::string& end_key, int64_t read_ts,
+                        pb::store::LockInfo& lock_info);
+
+  // Caller must hold mutex_.
+  void UnlockKeysWithoutMutex(const std::vector<pb::store::LockInfo>& lock_infos);
+  void UnlockDeferredKeysWithoutMutex(int64_t region_id);
+
+  std::atomic<int64_t> max_ts_{0};
+
+  struct MaxTsSyncState {
+    int64_t term{0};
+    bool is_synced{false};
+  };
+
+  bthread_mutex_t mutex_;
+  // key -> memory lock
+  std::map<std::string, pb::store::LockInfo> memory_locks_;
+  // region_id -> max_ts sync state of the leader term, the region which is not leader is absent
+  std::map<int64_t, MaxTsSyncState> max_ts_sync_states_;
+  // region_id -> start_ts -> memory locks of the proposal with uncertain result
+  std::map<int64_t, std::map<int64_t, std::vector<pb::store::LockInfo>>> deferred_locks_;
+  // apply skips the mutex in the common case that no lock is deferred
+  std::atomic<int64_t> deferred_txn_count_{0};
+  // read skips the mutex in the common case that no key is locked
+  std::atomic<int64_t> memory_lock_count_{0};
+
+  bvar::Adder<int64_t> memory_lock_count_metrics_;
+  bvar::Adder<int64_t> read_wait_count_metrics_;
+  bvar::Adder<int64_t> read_wait_timeout_count_metrics_;
+  bvar::LatencyRecorder read_wait_latency_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_TXN_CONCURRENCY_MANAGER_H_  // NOLINT
@@ -14,6 +14,7 @@
 
 #include "engine/txn_engine_helper.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -23,10 +24,14 @@
 #include <vector>
 
 #include "butil/compiler_specific.h"
+#include "bthread/bthread.h"
 #include "butil/status.h"
 #include "common/constant.h"
 #include "common/helper.h"
 #include "common/logging.h"
+#include "common/synchronization.h"
+#include "engine/txn_concurrency_manager.h"
+#include "engine/txn_gc_compaction_filter.h"
 #include "proto/common.pb.h"
 #include "proto/raft.pb.h"
 #include "proto/store.pb.h"
@@ -46,6 +51,8 @@ DEFINE_int64(max_commit_count, 1024, "max commit count");
 DEFINE_int64(max_rollback_count, 1024, "max rollback count");
 DEFINE_int64(max_resolve_count, 1024, "max rollback count");
 DEFINE_int64(max_pessimistic_count, 1024, "max pessimistic count");
+DEFINE_int64(txn_gc_max_delete_count_per_batch, 1024, "max delete count of write column family per gc batch");
+DEFINE_int64(txn_gc_batch_interval_us, 10000, "sleep interval between gc batches to limit the gc rate");
 
 butil::Status TxnIterator::Init() {
   snapshot_ = raw_engine_->GetSnapshot();
@@ -397,6 +404,13 @@ bool TxnEngineHelper::CheckLockConflict(const pb::store::LockInfo &lock_info, pb
                                         int64_t start_ts, pb::store::TxnResultInfo &txn_result_info) {
   if (lock_info.lock_ts() > 0) {
     if (isolation_level == pb::store::IsolationLevel::SnapshotIsolation) {
+      // the commit_ts of async commit transaction is not less than min_commit_ts, it's invisible to start_ts
+      if (lock_info.use_async_commit() && lock_info.min_commit_ts() > start_ts) {
+        DINGO_LOG(INFO) << "[txn]CheckLockConflict SI async commit lock min_commit_ts > start_ts, it's ok, lock_info: "
+                        << lock_info.ShortDebugString() << ", start_ts: " << start_ts;
+        return false;
+      }
+
       // for pessimistic, check for_update_ts
       if (lock_info.for_update_ts() > 0) {
         if (lock_info.for_update_ts() < start_ts) {
@@ -602,6 +616,18 @@ butil::Status TxnEngineHelper::BatchGet(RawEnginePtr engine, const pb::store::Is
     return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, "txn_result_info is not empty");
   }
 
+  // 1PC and async commit calculate commit_ts by max_ts, push it forward before checking the locks
+  if (isolation_level == pb::store::SnapshotIsolation) {
+    auto &concurrency_manager = TxnConcurrencyManager::GetInstance();
+    concurrency_manager.UpdateMaxTs(start_ts);
+
+    pb::store::LockInfo memory_lock;
+    if (!concurrency_manager.WaitKeysUnlocked(keys, start_ts, memory_lock)) {
+      *txn_result_info.mutable_locked() = memory_lock;
+      return butil::Status::OK();
+    }
+  }
+
   auto reader = engine->Reader();
 
   int64_t response_memory_size = 0;
@@ -762,6 +788,18 @@ butil::Status TxnEngineHelper::Scan(RawEnginePtr raw_engine, const pb::store::Is
     return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, "has_more or end_key is not empty");
   }
 
+  // 1PC and async commit calculate commit_ts by max_ts, push it forward before checking the locks
+  if (isolation_level == pb::store::SnapshotIsolation) {
+    auto &concurrency_manager = TxnConcurrencyManager::GetInstance();
+    concurrency_manager.UpdateMaxTs(start_ts);
+
+    pb::store::LockInfo memory_lock;
+    if (!concurrency_manager.WaitRangeUnlocked(range.start_key(), range.end_key(), start_ts, memory_lock)) {
+      *txn_result_info.mutable_locked() = memory_lock;
+      return butil::Status::OK();
+    }
+  }
+
   TxnIterator txn_iter(raw_engine, range, start_ts, isolation_level);
   auto ret = txn_iter.Init();
   if (!ret.ok()) {
@@ -1284,14 +1322,16 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
                                         int64_t txn_size, bool try_one_pc, int64_t max_commit_ts,
                                         const std::vector<int64_t> &pessimistic_checks,
                                         const std::map<int64_t, int64_t> &for_update_ts_checks,
-                                        const std::map<int64_t, std::string> &lock_extra_datas) {
+                                        const std::map<int64_t, std::string> &lock_extra_datas,
+                                        bool use_async_commit, const std::vector<std::string> &secondaries) {
   DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite, start_ts: {}", ctx->RegionId(), start_ts)
                   << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString()
                   << ", mutations_size: " << mutations.size() << ", primary_lock: " << Helper::StringToHex(primary_lock)
                   << ", lock_ttl: " << lock_ttl << ", txn_size: " << txn_size << ", try_one_pc: " << try_one_pc
                   << ", max_commit_ts: " << max_commit_ts << ", pessimistic_checks_size: " << pessimistic_checks.size()
                   << ", for_update_ts_checks_size: " << for_update_ts_checks.size()
-                  << ", lock_extra_datas_size: " << lock_extra_datas.size();
+                  << ", lock_extra_datas_size: " << lock_extra_datas.size()
+                  << ", use_async_commit: " << use_async_commit << ", secondaries_size: " << secondaries.size();
 
   if (BAIDU_UNLIKELY(mutations.size() > FLAGS_max_prewrite_count)) {
     DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Prewrite, start_ts: {}", ctx->RegionId(), start_ts)
@@ -1327,6 +1367,12 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
 
   std::vector<pb::common::KeyValue> kv_puts_data;
   std::vector<pb::common::KeyValue> kv_puts_lock;
+  // the lock_info of kv_puts_lock, for 1PC and async commit
+  std::vector<pb::store::LockInfo> lock_infos;
+  // for repeated async commit prewrite, the min_commit_ts of the existing locks
+  int64_t prev_min_commit_ts = 0;
+  // the transaction has locks prewritten before in this region, can't commit it with 1PC
+  bool has_prev_lock = false;
   std::vector<std::string> kv_dels_lock;  // for PutIfAbsent on pessimistic lock, if key is exists, no put will be
                                           // done, need to delete the lock in prewrite
 
@@ -1384,6 +1430,11 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
                           << " is locked by same start_ts, this is a repeated prewrite, skip it, lock_info: "
                           << prev_lock_info.ShortDebugString();
 
+          has_prev_lock = true;
+          if (prev_lock_info.use_async_commit()) {
+            prev_min_commit_ts = std::max(prev_min_commit_ts, prev_lock_info.min_commit_ts());
+          }
+
           // go to next key
           continue;
         } else {
@@ -1417,6 +1468,11 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
                 << fmt::format("[txn][region({})] Prewrite, start_ts: {}", region->Id(), start_ts)
                 << ", pessimistic prewrite meet optimistic lock, this is a repeated prewrite, skip it, key: "
                 << Helper::StringToHex(mutation.key()) << ", lock_info: " << prev_lock_info.ShortDebugString();
+
+            has_prev_lock = true;
+            if (prev_lock_info.use_async_commit()) {
+              prev_min_commit_ts = std::max(prev_min_commit_ts, prev_lock_info.min_commit_ts());
+            }
             continue;
           }
 
@@ -1507,6 +1563,15 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
                     << ", key: " << Helper::StringToHex(mutation.key()) << ", start_ts: " << start_ts
                     << ", commit_ts: " << commit_ts << ", write_info: " << write_info.ShortDebugString();
 
+    // this is a repeated 1PC prewrite, the transaction is committed already
+    if (try_one_pc && commit_ts > 0 && write_info.start_ts() == start_ts) {
+      DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite", region->Id())
+                      << ", key: " << Helper::StringToHex(mutation.key())
+                      << " is committed by 1PC, start_ts: " << start_ts << ", commit_ts: " << commit_ts;
+      response->set_one_pc_commit_ts(commit_ts);
+      continue;
+    }
+
     if (commit_ts >= start_ts) {
       if (!need_check_pessimistic_lock) {
         DINGO_LOG(INFO) << "Optimistic Prewrite find this transaction is committed after start_ts,return "
@@ -1581,6 +1646,7 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
         kv.set_value(lock_info.SerializeAsString());
 
         kv_puts_lock.push_back(kv);
+        lock_infos.push_back(lock_info);
       }
     } else if (mutation.op() == pb::store::Op::PutIfAbsent) {
       DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite", region->Id())
@@ -1613,6 +1679,7 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
           kv.set_value(lock_info.SerializeAsString());
 
           kv_puts_lock.push_back(kv);
+          lock_infos.push_back(lock_info);
         }
         continue;
 
@@ -1653,6 +1720,7 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
           kv.set_value(lock_info.SerializeAsString());
 
           kv_puts_lock.push_back(kv);
+          lock_infos.push_back(lock_info);
         }
       }
     } else if (mutation.op() == pb::store::Op::Delete) {
@@ -1678,6 +1746,7 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
         kv.set_value(lock_info.SerializeAsString());
 
         kv_puts_lock.push_back(kv);
+        lock_infos.push_back(lock_info);
       }
     } else {
       DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Prewrite,", region->Id())
@@ -1693,9 +1762,82 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
                     << ", kv_puts_data_size: " << kv_puts_data.size() << ", kv_puts_lock_size: " << kv_puts_lock.size()
                     << ", start_ts: " << start_ts << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString()
                     << ", mutations_size: " << mutations.size();
+    response->set_min_commit_ts(prev_min_commit_ts);
     return butil::Status::OK();
   }
 
+  // 1PC and async commit, the commit_ts is calculated by store
+  if ((try_one_pc || use_async_commit) && response->txn_result_size() == 0) {
+    bool is_vector_index_region = region->Type() == pb::common::INDEX_REGION &&
+                                  region->Definition().index_parameter().has_vector_index_parameter();
+    bool use_one_pc = try_one_pc && !has_prev_lock && !is_vector_index_region;
+
+    // the keys is locked in memory until the locks or writes are applied, the read which start_ts >= commit_ts will
+    // wait for it
+    auto &concurrency_manager = TxnConcurrencyManager::GetInstance();
+    if ((use_one_pc || use_async_commit) && !concurrency_manager.IsMaxTsSynced(region->Id())) {
+      // max_ts may miss the reads served by the previous leader
+      DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite, start_ts: {}", region->Id(), start_ts)
+                      << ", max_ts is not synced from tso, fallback to 2PC";
+    } else if ((use_one_pc || use_async_commit) && concurrency_manager.LockKeys(lock_infos)) {
+      butil::Status write_status;
+      // raft log commit failed after proposed, e.g. leader changed, the new leader may still commit it, keep the keys
+      // locked until it is applied or the leader changes
+      ON_SCOPE_EXIT([&]() {
+        if (write_status.error_code() == pb::error::ERAFT_COMMITLOG) {
+          concurrency_manager.DeferUnlockKeys(region->Id(), start_ts, lock_infos);
+        } else {
+          concurrency_manager.UnlockKeys(lock_infos);
+        }
+      });
+
+      int64_t commit_ts = std::max(std::max(concurrency_manager.MaxTs(), start_ts), prev_min_commit_ts - 1);
+      for (const auto &lock_info : lock_infos) {
+        commit_ts = std::max(commit_ts, lock_info.for_update_ts());
+      }
+      commit_ts += 1;
+
+      if (max_commit_ts > 0 && commit_ts > max_commit_ts) {
+        DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite, start_ts: {}", region->Id(), start_ts)
+                        << ", commit_ts: " << commit_ts << " > max_commit_ts: " << max_commit_ts
+                        << ", fallback to 2PC";
+      } else if (use_one_pc) {
+        write_status = OnePcCommit(raft_engine, ctx, region, lock_infos, kv_puts_data, start_ts, commit_ts);
+        return write_status;
+      } else {
+        for (size_t i = 0; i < lock_infos.size(); ++i) {
+          auto &lock_info = lock_infos[i];
+          lock_info.set_use_async_commit(true);
+          lock_info.set_min_commit_ts(commit_ts);
+          if (lock_info.key() == primary_lock) {
+            for (const auto &secondary : secondaries) {
+              lock_info.add_secondaries(secondary);
+            }
+          }
+          kv_puts_lock[i].set_value(lock_info.SerializeAsString());
+        }
+        response->set_min_commit_ts(commit_ts);
+
+        DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite, start_ts: {}", region->Id(), start_ts)
+                        << ", async commit, min_commit_ts: " << commit_ts << ", locks_size: " << lock_infos.size();
+
+        write_status = WritePrewrite(raft_engine, ctx, kv_puts_data, kv_puts_lock);
+        return write_status;
+      }
+    }
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite", region->Id())
+                  << ", kv_puts_data_size: " << kv_puts_data.size() << ", kv_puts_lock_size: " << kv_puts_lock.size()
+                  << ", start_ts: " << start_ts << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString()
+                  << ", mutations_size: " << mutations.size();
+
+  return WritePrewrite(raft_engine, ctx, kv_puts_data, kv_puts_lock);
+}
+
+butil::Status TxnEngineHelper::WritePrewrite(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                             const std::vector<pb::common::KeyValue> &kv_puts_data,
+                                             const std::vector<pb::common::KeyValue> &kv_puts_lock) {
   // after all mutations is processed, write into raft engine
   pb::raft::TxnRaftRequest txn_raft_request;
   auto *cf_put_delete = txn_raft_request.mutable_multi_cf_put_and_delete();
@@ -1703,7 +1845,7 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
   if (!kv_puts_data.empty()) {
     auto *data_puts = cf_put_delete->add_puts_with_cf();
     data_puts->set_cf_name(Constant::kTxnDataCF);
-    for (auto &kv_put : kv_puts_data) {
+    for (const auto &kv_put : kv_puts_data) {
       auto *kv = data_puts->add_kvs();
       kv->set_key(kv_put.key());
       kv->set_value(kv_put.value());
@@ -1713,21 +1855,74 @@ butil::Status TxnEngineHelper::Prewrite(RawEnginePtr raw_engine, std::shared_ptr
   if (!kv_puts_lock.empty()) {
     auto *lock_puts = cf_put_delete->add_puts_with_cf();
     lock_puts->set_cf_name(Constant::kTxnLockCF);
-    for (auto &kv_put : kv_puts_lock) {
+    for (const auto &kv_put : kv_puts_lock) {
       auto *kv = lock_puts->add_kvs();
       kv->set_key(kv_put.key());
       kv->set_value(kv_put.value());
     }
   }
 
-  DINGO_LOG(INFO) << fmt::format("[txn][region({})] Prewrite", region->Id())
-                  << ", kv_puts_data_size: " << kv_puts_data.size() << ", kv_puts_lock_size: " << kv_puts_lock.size()
-                  << ", start_ts: " << start_ts << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString()
-                  << ", mutations_size: " << mutations.size();
-
   return raft_engine->Write(ctx, WriteDataBuilder::BuildWrite(txn_raft_request));
 }
 
+butil::Status TxnEngineHelper::OnePcCommit(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                           store::RegionPtr region, const std::vector<pb::store::LockInfo> &lock_infos,
+                                           const std::vector<pb::common::KeyValue> &kv_puts_data, int64_t start_ts,
+                                           int64_t commit_ts) {
+  DINGO_LOG(INFO) << fmt::format("[txn][region({})] OnePcCommit, start_ts: {} commit_ts: {}", region->Id(), start_ts,
+                                 commit_ts)
+                  << ", lock_infos_size: " << lock_infos.size() << ", kv_puts_data_size: " << kv_puts_data.size();
+
+  // the data and the writes are written together, the locks are never written, delete the pessimistic locks
+  pb::raft::TxnRaftRequest txn_raft_request;
+  auto *cf_put_delete = txn_raft_request.mutable_multi_cf_put_and_delete();
+
+  if (!kv_puts_data.empty()) {
+    auto *data_puts = cf_put_delete->add_puts_with_cf();
+    data_puts->set_cf_name(Constant::kTxnDataCF);
+    for (const auto &kv_put : kv_puts_data) {
+      auto *kv = data_puts->add_kvs();
+      kv->set_key(kv_put.key());
+      kv->set_value(kv_put.value());
+    }
+  }
+
+  pb::raft::PutsWithCf *write_puts = nullptr;
+  auto *lock_dels = cf_put_delete->add_deletes_with_cf();
+  lock_dels->set_cf_name(Constant::kTxnLockCF);
+  for (const auto &lock_info : lock_infos) {
+    lock_dels->add_keys(Helper::EncodeTxnKey(lock_info.key(), Constant::kLockVer));
+
+    // same as commit, PutIfAbsent with existing key writes nothing
+    if (lock_info.lock_type() == pb::store::Op::PutIfAbsent) {
+      continue;
+    }
+
+    pb::store::WriteInfo write_info;
+    write_info.set_start_ts(start_ts);
+    write_info.set_op(lock_info.lock_type());
+    if (!lock_info.short_value().empty()) {
+      write_info.set_short_value(lock_info.short_value());
+    }
+
+    if (write_puts == nullptr) {
+      write_puts = cf_put_delete->add_puts_with_cf();
+      write_puts->set_cf_name(Constant::kTxnWriteCF);
+    }
+    auto *kv = write_puts->add_kvs();
+    kv->set_key(Helper::EncodeTxnKey(lock_info.key(), commit_ts));
+    kv->set_value(write_info.SerializeAsString());
+  }
+
+  auto *response = dynamic_cast<pb::store::TxnPrewriteResponse *>(ctx->Response());
+  auto status = raft_engine->Write(ctx, WriteDataBuilder::BuildWrite(txn_raft_request));
+  if (status.ok() && response != nullptr) {
+    response->set_one_pc_commit_ts(commit_ts);
+  }
+
+  return status;
+}
+
 butil::Status TxnEngineHelper::Commit(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine,
                                       std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
                                       const std::vector<std::string> &keys) {
@@ -2042,10 +2237,12 @@ butil::Status TxnEngineHelper::DoTxnCommit(RawEnginePtr raw_engine, std::shared_
 
 butil::Status TxnEngineHelper::CheckTxnStatus(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine,
                                               std::shared_ptr<Context> ctx, const std::string &primary_key,
-                                              int64_t lock_ts, int64_t caller_start_ts, int64_t current_ts) {
+                                              int64_t lock_ts, int64_t caller_start_ts, int64_t current_ts,
+                                              bool rollback_if_not_exist) {
   DINGO_LOG(INFO) << fmt::format("[txn][region({})] CheckTxnStatus, primary_key: {}", ctx->RegionId(), primary_key)
                   << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString() << ", lock_ts: " << lock_ts
-                  << ", caller_start_ts: " << caller_start_ts << ", current_ts: " << current_ts;
+                  << ", caller_start_ts: " << caller_start_ts << ", current_ts: " << current_ts
+                  << ", rollback_if_not_exist: " << rollback_if_not_exist;
 
   // we need to do if primay_key is in this region'range in service before apply to raft state machine
   // use reader to get if the lock is exists, if lock is exists, check if the lock is expired its ttl, if expired do
@@ -2124,6 +2321,19 @@ butil::Status TxnEngineHelper::CheckTxnStatus(RawEnginePtr raw_engine, std::shar
       return butil::Status::OK();
     }
 
+    // the async commit transaction may be committed already, it's decided by the status of all secondary locks, so
+    // the primary lock can't be rollbacked alone, return lock_info to let executor resolve the whole transaction
+    if (lock_info.use_async_commit()) {
+      DINGO_LOG(INFO) << "async commit lock is expired, return lock_info, lock_info: " << lock_info.ShortDebugString()
+                      << ", current_ms: " << current_ms;
+
+      response->set_lock_ttl(lock_info.lock_ttl());
+      response->set_commit_ts(0);
+      response->set_action(::dingodb::pb::store::Action::NoAction);
+      *response->mutable_lock_info() = lock_info;
+      return butil::Status::OK();
+    }
+
     DINGO_LOG(INFO) << "lock is expired, do rollback, lock_info: " << lock_info.ShortDebugString()
                     << ", current_ms: " << current_ms;
 
@@ -2176,6 +2386,38 @@ butil::Status TxnEngineHelper::CheckTxnStatus(RawEnginePtr raw_engine, std::shar
                        << ", lock_ts: " << lock_ts << ", status: " << ret2.error_str();
     }
 
+    if (commit_ts == 0 && rollback_if_not_exist) {
+      // the lock is not prewritten yet, write a rollback record to prevent the late prewrite, the lock of key may be
+      // held by other transaction, so only the rollback record is written
+      pb::store::WriteInfo rollback_info;
+      rollback_info.set_start_ts(lock_ts);
+      rollback_info.set_op(::dingodb::pb::store::Op::Rollback);
+
+      pb::raft::TxnRaftRequest txn_raft_request;
+      auto *write_puts = txn_raft_request.mutable_multi_cf_put_and_delete()->add_puts_with_cf();
+      write_puts->set_cf_name(Constant::kTxnWriteCF);
+      auto *kv = write_puts->add_kvs();
+      kv->set_key(Helper::EncodeTxnKey(primary_key, lock_ts));
+      kv->set_value(rollback_info.SerializeAsString());
+
+      auto ret3 = raft_engine->Write(ctx, WriteDataBuilder::BuildWrite(txn_raft_request));
+      if (!ret3.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("[txn][region({})] CheckTxnStatus,", region->Id())
+                         << ", write rollback failed, primary_key: " << Helper::StringToHex(primary_key)
+                         << ", lock_ts: " << lock_ts << ", status: " << ret3.error_str();
+        return ret3;
+      }
+
+      DINGO_LOG(INFO) << fmt::format("[txn][region({})] CheckTxnStatus,", region->Id())
+                      << ", lock not exist, write rollback, primary_key: " << Helper::StringToHex(primary_key)
+                      << ", lock_ts: " << lock_ts;
+
+      response->set_lock_ttl(0);
+      response->set_commit_ts(0);
+      response->set_action(::dingodb::pb::store::Action::LockNotExistRollback);
+      return butil::Status::OK();
+    }
+
     if (commit_ts == 0) {
       // it seems there is a lock previously exists, but it is not committed, and there is no rollback, there must
       // be some error, return TxnNotFound
@@ -2416,7 +2658,7 @@ butil::Status TxnEngineHelper::ResolveLock(RawEnginePtr raw_engine, std::shared_
     return butil::Status(pb::error::Errno::EREGION_NOT_FOUND, "region is not found");
   }
 
-  if (commit_ts <= start_ts) {
+  if (commit_ts > 0 && commit_ts <= start_ts) {
     DINGO_LOG(ERROR) << fmt::format("[txn][region({})] ResolveLock", region->Id())
                      << ", commit_ts <= start_ts, region_id: " << ctx->RegionId() << ", start_ts: " << start_ts
                      << ", commit_ts: " << commit_ts;
@@ -2681,14 +2923,14 @@ butil::Status TxnEngineHelper::DeleteRange(RawEnginePtr /*raw_engine*/, std::sha
   return raft_engine->Write(ctx, WriteDataBuilder::BuildWrite(txn_raft_request));
 }
 
-butil::Status TxnEngineHelper::Gc(RawEnginePtr /*raw_engine*/, std::shared_ptr<Engine> raft_engine,
+butil::Status TxnEngineHelper::Gc(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine,
                                   std::shared_ptr<Context> ctx, int64_t safe_point_ts) {
   DINGO_LOG(INFO) << fmt::format("[txn][region({})] Gc, safe_point_ts: {}", ctx->RegionId(), safe_point_ts)
                   << ", region_epoch: " << ctx->RegionEpoch().ShortDebugString();
 
   auto region = Server::GetInstance().GetRegion(ctx->RegionId());
   if (region == nullptr) {
-    DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc", region->Id())
+    DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc", ctx->RegionId())
                      << ", region is not found, region_id: " << ctx->RegionId();
     return butil::Status(pb::error::Errno::EREGION_NOT_FOUND, "region is not found");
   }
@@ -2699,38 +2941,115 @@ butil::Status TxnEngineHelper::Gc(RawEnginePtr /*raw_engine*/, std::shared_ptr<E
                      << ", response is nullptr";
     return butil::Status(pb::error::Errno::EINTERNAL, "response is nullptr");
   }
-  auto *error = response->mutable_error();
 
-  std::vector<std::string> kv_deletes_lock;
+  // the compaction filter of write column family drops garbage versions in background
+  TxnGcSafePoint::GetInstance().Update(safe_point_ts);
+
+  auto reader = raw_engine->Reader();
+  if (reader == nullptr) {
+    DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc, get reader failed", region->Id());
+    return butil::Status(pb::error::Errno::EINTERNAL, "get reader failed");
+  }
+
+  IteratorOptions write_iter_options;
+  write_iter_options.lower_bound = Helper::EncodeTxnKey(region->Range().start_key(), Constant::kMaxVer);
+  write_iter_options.upper_bound = Helper::EncodeTxnKey(region->Range().end_key(), Constant::kMaxVer);
+  auto write_iter = reader->NewIterator(Constant::kTxnWriteCF, write_iter_options);
+  if (write_iter == nullptr) {
+    DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc, new write iterator failed", region->Id());
+    return butil::Status(pb::error::Errno::EINTERNAL, "new iterator failed");
+  }
+
+  // The foreground gc sees all records of a key, so the newest Delete older than safe point is dropped too.
+  TxnGcVersionChecker checker(safe_point_ts, true);
+
   std::vector<std::string> kv_deletes_data;
   std::vector<std::string> kv_deletes_write;
+  std::string last_user_key;
+  int64_t scan_count = 0;
+  int64_t delete_count = 0;
+  int64_t start_time = Helper::TimestampMs();
+
+  for (write_iter->SeekToFirst(); write_iter->Valid(); write_iter->Next()) {
+    std::string user_key;
+    int64_t commit_ts = 0;
+    auto ret = Helper::DecodeTxnKey(write_iter->Key(), user_key, commit_ts);
+    if (!ret.ok()) {
+      DINGO_LOG(FATAL) << fmt::format("[txn][region({})] Gc, decode txn key failed, key: {}", region->Id(),
+                                      Helper::StringToHex(write_iter->Key()));
+    }
+    ++scan_count;
 
-  // TODO: scan data to be delete and add items to kv_deletes_*
+    // Flush at key boundary, so the records of one key are deleted atomically, otherwise an older Put may be
+    // visible again after the newest Delete is deleted.
+    if (user_key != last_user_key &&
+        static_cast<int64_t>(kv_deletes_write.size()) >= FLAGS_txn_gc_max_delete_count_per_batch) {
+      ret = GcDeleteBatch(raft_engine, ctx, kv_deletes_write, kv_deletes_data);
+      if (!ret.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc, write deletes failed, error: {}", region->Id(),
+                                        ret.error_str());
+        return ret;
+      }
+      delete_count += kv_deletes_write.size();
+      kv_deletes_write.clear();
+      kv_deletes_data.clear();
 
-  // after all mutations is processed, write into raft engine
+      if (FLAGS_txn_gc_batch_interval_us > 0) {
+        bthread_usleep(FLAGS_txn_gc_batch_interval_us);
+      }
+    }
+    last_user_key.swap(user_key);
+
+    pb::store::WriteInfo write_info;
+    if (!write_info.ParseFromArray(write_iter->Value().data(), write_iter->Value().size())) {
+      DINGO_LOG(FATAL) << fmt::format("[txn][region({})] Gc, parse write info failed, key: {}", region->Id(),
+                                      Helper::StringToHex(write_iter->Key()));
+    }
+
+    if (!checker.IsGarbage(last_user_key, commit_ts, write_info)) {
+      continue;
+    }
+
+    kv_deletes_write.emplace_back(write_iter->Key());
+    if (write_info.op() == pb::store::Op::Put && write_info.short_value().empty()) {
+      kv_deletes_data.push_back(Helper::EncodeTxnKey(last_user_key, write_info.start_ts()));
+    }
+  }
+
+  if (!kv_deletes_write.empty()) {
+    auto ret = GcDeleteBatch(raft_engine, ctx, kv_deletes_write, kv_deletes_data);
+    if (!ret.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("[txn][region({})] Gc, write deletes failed, error: {}", region->Id(),
+                                      ret.error_str());
+      return ret;
+    }
+    delete_count += kv_deletes_write.size();
+  }
+
+  DINGO_LOG(INFO) << fmt::format(
+      "[txn][region({})] Gc finish, safe_point_ts: {} scan_count: {} delete_count: {} elapsed time: {}ms",
+      region->Id(), safe_point_ts, scan_count, delete_count, Helper::TimestampMs() - start_time);
+
+  return butil::Status::OK();
+}
+
+butil::Status TxnEngineHelper::GcDeleteBatch(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                             const std::vector<std::string> &kv_deletes_write,
+                                             const std::vector<std::string> &kv_deletes_data) {
   pb::raft::TxnRaftRequest txn_raft_request;
   auto *cf_put_delete = txn_raft_request.mutable_multi_cf_put_and_delete();
 
   auto *write_dels = cf_put_delete->add_deletes_with_cf();
   write_dels->set_cf_name(Constant::kTxnWriteCF);
-  for (auto &key_del : kv_deletes_write) {
+  for (const auto &key_del : kv_deletes_write) {
     write_dels->add_keys(key_del);
   }
-  auto *lock_dels = cf_put_delete->add_deletes_with_cf();
-  lock_dels->set_cf_name(Constant::kTxnLockCF);
-  for (auto &key_del : kv_deletes_lock) {
-    lock_dels->add_keys(key_del);
-  }
   auto *data_dels = cf_put_delete->add_deletes_with_cf();
   data_dels->set_cf_name(Constant::kTxnDataCF);
-  for (auto &key_del : kv_deletes_data) {
+  for (const auto &key_del : kv_deletes_data) {
     data_dels->add_keys(key_del);
   }
 
-  if (txn_raft_request.ByteSizeLong() == 0) {
-    return butil::Status::OK();
-  }
-
   return raft_engine->Write(ctx, WriteDataBuilder::BuildWrite(txn_raft_request));
 }
 
@@ -106,6 +106,16 @@ class TxnEngineHelper {
                                    const std::vector<pb::store::LockInfo> &lock_infos, int64_t start_ts,
                                    int64_t commit_ts);
 
+  static butil::Status WritePrewrite(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                     const std::vector<pb::common::KeyValue> &kv_puts_data,
+                                     const std::vector<pb::common::KeyValue> &kv_puts_lock);
+
+  // Commit the prewrite of single region transaction directly, write the data and the writes instead of the locks.
+  static butil::Status OnePcCommit(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                   store::RegionPtr region, const std::vector<pb::store::LockInfo> &lock_infos,
+                                   const std::vector<pb::common::KeyValue> &kv_puts_data, int64_t start_ts,
+                                   int64_t commit_ts);
+
   static butil::Status DoRollback(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine,
                                   std::shared_ptr<Context> ctx, std::vector<std::string> &keys_to_rollback_with_data,
                                   std::vector<std::string> &keys_to_rollback_without_data, int64_t start_ts);
@@ -124,7 +134,8 @@ class TxnEngineHelper {
                                 const std::string &primary_lock, int64_t start_ts, int64_t lock_ttl, int64_t txn_size,
                                 bool try_one_pc, int64_t max_commit_ts, const std::vector<int64_t> &pessimistic_checks,
                                 const std::map<int64_t, int64_t> &for_update_ts_checks,
-                                const std::map<int64_t, std::string> &lock_extra_datas);
+                                const std::map<int64_t, std::string> &lock_extra_datas, bool use_async_commit,
+                                const std::vector<std::string> &secondaries);
 
   static butil::Status Commit(RawEnginePtr raw_engine, std::shared_ptr<Engine> engine, std::shared_ptr<Context> ctx,
                               int64_t start_ts, int64_t commit_ts, const std::vector<std::string> &keys);
@@ -135,7 +146,7 @@ class TxnEngineHelper {
 
   static butil::Status CheckTxnStatus(RawEnginePtr raw_engine, std::shared_ptr<Engine> engine,
                                       std::shared_ptr<Context> ctx, const std::string &primary_key, int64_t lock_ts,
-                                      int64_t caller_start_ts, int64_t current_ts);
+                                      int64_t caller_start_ts, int64_t current_ts, bool rollback_if_not_exist);
 
   static butil::Status ResolveLock(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine,
                                    std::shared_ptr<Context> ctx, int64_t start_ts, int64_t commit_ts,
@@ -151,6 +162,9 @@ class TxnEngineHelper {
 
   static butil::Status Gc(RawEnginePtr raw_engine, std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
                           int64_t safe_point_ts);
+  static butil::Status GcDeleteBatch(std::shared_ptr<Engine> raft_engine, std::shared_ptr<Context> ctx,
+                                     const std::vector<std::string> &kv_deletes_write,
+                                     const std::vector<std::string> &kv_deletes_data);
 };
 
 }  // namespace dingodb
@@ -0,0 +1,158 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/txn_gc_compaction_filter.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "bvar/reducer.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+
+namespace dingodb {
+
+DEFINE_bool(txn_gc_enable_compaction_filter, true, "drop the garbage versions of txn by compaction filter");
+DEFINE_int64(txn_gc_compaction_data_delete_batch_size, 1024, "batch size of deleting data of dropped versions");
+
+static bvar::Adder<int64_t> g_txn_gc_compaction_filtered_count("dingo_txn_gc_compaction_filtered_count");
+static bvar::Adder<int64_t> g_txn_gc_compaction_data_delete_count("dingo_txn_gc_compaction_data_delete_count");
+
+TxnGcSafePoint& TxnGcSafePoint::GetInstance() {
+  static TxnGcSafePoint instance;
+  return instance;
+}
+
+void TxnGcSafePoint::Update(int64_t safe_point) {
+  int64_t old_safe_point = safe_point_.load(std::memory_order_relaxed);
+  while (safe_point > old_safe_point &&
+         !safe_point_.compare_exchange_weak(old_safe_point, safe_point, std::memory_order_relaxed)) {
+  }
+}
+
+int64_t TxnGcSafePoint::Get() const {
+  return gc_stop_.load(std::memory_order_relaxed) ? 0 : safe_point_.load(std::memory_order_relaxed);
+}
+
+bool TxnGcVersionChecker::IsGarbage(std::string_view key, int64_t commit_ts, const pb::store::WriteInfo& write_info) {
+  if (key != current_key_) {
+    current_key_.assign(key.data(), key.size());
+    found_latest_version_ = false;
+  }
+
+  if (commit_ts > safe_point_) {
+    return false;
+  }
+
+  if (found_latest_version_) {
+    return true;
+  }
+
+  switch (write_info.op()) {
+    case pb::store::Op::Put:
+    case pb::store::Op::PutIfAbsent:
+      found_latest_version_ = true;
+      return false;
+    case pb::store::Op::Delete:
+      found_latest_version_ = true;
+      return drop_latest_delete_;
+    default:
+      // Rollback and Lock records are not versions of data
+      return true;
+  }
+}
+
+namespace rocks {
+
+TxnWriteCompactionFilter::TxnWriteCompactionFilter(int64_t safe_point, rocksdb::DB* db,
+                                                   rocksdb::ColumnFamilyHandle* data_cf_handle)
+    : db_(db), data_cf_handle_(data_cf_handle), checker_(safe_point, false) {}
+
+TxnWriteCompactionFilter::~TxnWriteCompactionFilter() {
+  FlushDataDeletes();
+  g_txn_gc_compaction_filtered_count << filtered_count_;
+}
+
+bool TxnWriteCompactionFilter::Filter(int /*level*/, const rocksdb::Slice& key, const rocksdb::Slice& existing_value,
+                                      std::string* /*new_value*/, bool* /*value_changed*/) const {
+  std::string user_key;
+  int64_t commit_ts = 0;
+  auto status = Helper::DecodeTxnKey(std::string_view(key.data(), key.size()), user_key, commit_ts);
+  if (!status.ok()) {
+    return false;
+  }
+
+  pb::store::WriteInfo write_info;
+  if (!write_info.ParseFromArray(existing_value.data(), existing_value.size())) {
+    DINGO_LOG(WARNING) << fmt::format("[txn.gc] parse write info failed, key: {}", Helper::StringToHex(key.ToString()));
+    return false;
+  }
+
+  if (!checker_.IsGarbage(user_key, commit_ts, write_info)) {
+    return false;
+  }
+
+  // the value of Put is in data column family if it is not short value
+  if (write_info.op() == pb::store::Op::Put && write_info.short_value().empty() && data_cf_handle_ != nullptr) {
+    data_deletes_.Delete(data_cf_handle_, Helper::EncodeTxnKey(user_key, write_info.start_ts()));
+    if (data_deletes_.Count() >= FLAGS_txn_gc_compaction_data_delete_batch_size) {
+      FlushDataDeletes();
+    }
+  }
+
+  ++filtered_count_;
+  return true;
+}
+
+void TxnWriteCompactionFilter::FlushDataDeletes() const {
+  if (db_ == nullptr || data_deletes_.Count() == 0) {
+    return;
+  }
+
+  // Not wait for write stall, the compaction may be the one which resolves the stall.
+  // The data left is deleted by foreground gc.
+  rocksdb::WriteOptions write_options;
+  write_options.no_slowdown = true;
+  auto status = db_->Write(write_options, &data_deletes_);
+  if (!status.ok()) {
+    DINGO_LOG(WARNING) << fmt::format("[txn.gc] delete data of dropped versions failed, count: {} error: {}",
+                                      data_deletes_.Count(), status.ToString());
+  } else {
+    g_txn_gc_compaction_data_delete_count << data_deletes_.Count();
+  }
+  data_deletes_.Clear();
+}
+
+std::unique_ptr<rocksdb::CompactionFilter> TxnWriteCompactionFilterFactory::CreateCompactionFilter(
+    const rocksdb::CompactionFilter::Context& /*context*/) {
+  int64_t safe_point = TxnGcSafePoint::GetInstance().Get();
+  if (!FLAGS_txn_gc_enable_compaction_filter || safe_point <= 0) {
+    return nullptr;
+  }
+
+  return std::make_unique<TxnWriteCompactionFilter>(safe_point, db_.load(), data_cf_handle_.load());
+}
+
+void TxnWriteCompactionFilterFactory::SetDB(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* data_cf_handle) {
+  data_cf_handle_.store(data_cf_handle);
+  db_.store(db);
+}
+
+}  // namespace rocks
+
+}  // namespace dingodb
@@ -0,0 +1,125 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_TXN_GC_COMPACTION_FILTER_H_  // NOLINT
+#define DINGODB_ENGINE_TXN_GC_COMPACTION_FILTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "proto/store.pb.h"
+#include "rocksdb/compaction_filter.h"
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+
+namespace dingodb {
+
+// Store-wide gc safe point, it is pulled from coordinator by store heartbeat and pushed by TxnGc request.
+// Versions which are invisible to all reads at or after the safe point can be dropped.
+class TxnGcSafePoint {
+ public:
+  static TxnGcSafePoint& GetInstance();
+
+  // safe point never moves backward
+  void Update(int64_t safe_point);
+  void SetGcStop(bool gc_stop) { gc_stop_.store(gc_stop, std::memory_order_relaxed); }
+
+  // Return 0 if gc is stopped, then nothing is dropped.
+  int64_t Get() const;
+
+ private:
+  std::atomic<int64_t> safe_point_{0};
+  std::atomic<bool> gc_stop_{false};
+};
+
+// Decide which records of write column family are garbage at the safe point. Records of one key must be checked from
+// the newest to the oldest, it is the order of write column family, since the commit ts is encoded with negation.
+// For each key, the newest Put/Delete record whose commit_ts <= safe point is the version seen by reads at the safe
+// point, it is kept and all older records are garbage. Rollback and Lock records older than the safe point are garbage.
+class TxnGcVersionChecker {
+ public:
+  // If drop_latest_delete is true, the newest Delete record which is older than the safe point is garbage too,
+  // it is only safe when all records of the key are checked.
+  TxnGcVersionChecker(int64_t safe_point, bool drop_latest_delete)
+      : safe_point_(safe_point), drop_latest_delete_(drop_latest_delete) {}
+
+  bool IsGarbage(std::string_view key, int64_t commit_ts, const pb::store::WriteInfo& write_info);
+
+ private:
+  int64_t safe_point_;
+  bool drop_latest_delete_;
+
+  std::string current_key_;
+  // the newest Put/Delete record which is older than safe point is found
+  bool found_latest_version_{false};
+};
+
+namespace rocks {
+
+// Compaction filter of txn write column family, it drops the garbage records of TxnGcVersionChecker.
+// A compaction only sees part of the records of a key, so the newest Delete record is kept, otherwise an older Put in
+// the lower level becomes visible again, the foreground gc removes it.
+// The data of dropped Put records is deleted from data column family after compaction.
+class TxnWriteCompactionFilter : public rocksdb::CompactionFilter {
+ public:
+  TxnWriteCompactionFilter(int64_t safe_point, rocksdb::DB* db, rocksdb::ColumnFamilyHandle* data_cf_handle);
+  ~TxnWriteCompactionFilter() override;
+
+  const char* Name() const override { return "TxnWriteCompactionFilter"; }
+
+  bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value, std::string* new_value,
+              bool* value_changed) const override;
+
+  int64_t FilteredCount() const { return filtered_count_; }
+
+ private:
+  void FlushDataDeletes() const;
+
+  rocksdb::DB* db_;
+  rocksdb::ColumnFamilyHandle* data_cf_handle_;
+
+  // one filter is used by one (sub)compaction, the records are filtered in order
+  mutable TxnGcVersionChecker checker_;
+  mutable rocksdb::WriteBatch data_deletes_;
+  mutable int64_t filtered_count_{0};
+};
+
+class TxnWriteCompactionFilterFactory : public rocksdb::CompactionFilterFactory {
+ public:
+  TxnWriteCompactionFilterFactory() = default;
+  ~TxnWriteCompactionFilterFactory() override = default;
+
+  const char* Name() const override { return "TxnWriteCompactionFilterFactory"; }
+
+  std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
+      const rocksdb::CompactionFilter::Context& context) override;
+
+  // The db is opened after column family options are built, set it after open and reset it before close.
+  void SetDB(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* data_cf_handle);
+
+ private:
+  std::atomic<rocksdb::DB*> db_{nullptr};
+  std::atomic<rocksdb::ColumnFamilyHandle*> data_cf_handle_{nullptr};
+};
+
+using TxnWriteCompactionFilterFactoryPtr = std::shared_ptr<TxnWriteCompactionFilterFactory>;
+
+}  // namespace rocks
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_TXN_GC_COMPACTION_FILTER_H_  // NOLINT
@@ -0,0 +1,252 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/txn_lock_wait_manager.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "butil/time.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+
+namespace dingodb {
+
+DEFINE_int64(txn_pessimistic_lock_wait_timeout_ms, 1000,
+             "max wait time of pessimistic lock conflict in leader, 0 means return the conflict to client immediately");
+
+TxnLockWaitManager& TxnLockWaitManager::GetInstance() {
+  static TxnLockWaitManager instance;
+  return instance;
+}
+
+TxnLockWaitManager::TxnLockWaitManager()
+    : waiter_count_metrics_("dingo_txn_lock_wait_waiter_count"),
+      deadlock_count_metrics_("dingo_txn_lock_wait_deadlock_count"),
+      timeout_count_metrics_("dingo_txn_lock_wait_timeout_count"),
+      wait_latency_("dingo_txn_lock_wait_latency") {
+  bthread_mutex_init(&mutex_, nullptr);
+}
+
+TxnLockWaitManager::~TxnLockWaitManager() { bthread_mutex_destroy(&mutex_); }
+
+std::atomic<int64_t>& TxnLockWaitManager::ReleaseSeq(int64_t region_id, const std::string& key) {
+  size_t hash = std::hash<std::string>{}(key) ^ (std::hash<int64_t>{}(region_id) * 0x9e3779b97f4a7c15ULL);
+  return release_seqs_[hash % kReleaseSeqSlotNum];
+}
+
+int64_t TxnLockWaitManager::GetReleaseSeq(int64_t region_id, const std::string& key) {
+  return ReleaseSeq(region_id, key).load();
+}
+
+TxnLockWaitManager::WaitResult TxnLockWaitManager::Wait(int64_t region_id, const std::string& key, int64_t start_ts,
+                                                        int64_t lock_ts, int64_t release_seq, int64_t timeout_ms,
+                                                        WakeFunc wake_func, std::vector<int64_t>& wait_chain) {
+  auto waiter = std::make_shared<Waiter>();
+  waiter->id = waiter_id_generator_.fetch_add(1) + 1;
+  waiter->region_id = region_id;
+  waiter->key = key;
+  waiter->start_ts = start_ts;
+  waiter->lock_ts = lock_ts;
+  waiter->start_time_ms = Helper::TimestampMs();
+  waiter->wake_func = std::move(wake_func);
+
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    // the release is after the lock is read, there is no WakeUp for this waiter any more
+    if (ReleaseSeq(region_id, key).load() != release_seq) {
+      DINGO_LOG(DEBUG) << fmt::format("[txn.lock_wait][region({})] lock released before wait, start_ts: {} key: {}",
+                                      region_id, start_ts, Helper::StringToHex(key));
+      return WaitResult::kReleased;
+    }
+
+    std::vector<int64_t> path;
+    if (IsWaitingForUnlocked(lock_ts, start_ts, path)) {
+      wait_chain.clear();
+      wait_chain.push_back(start_ts);
+      wait_chain.insert(wait_chain.end(), path.begin(), path.end());
+      deadlock_count_metrics_ << 1;
+
+      DINGO_LOG(WARNING) << fmt::format("[txn.lock_wait][region({})] deadlock, start_ts: {} lock_ts: {} key: {}",
+                                        region_id, start_ts, lock_ts, Helper::StringToHex(key));
+      return WaitResult::kDeadlock;
+    }
+
+    waiters_[waiter->id] = waiter;
+    key_waiters_[region_id][key].push_back(waiter->id);
+    ++wait_for_graph_[start_ts][lock_ts];
+
+    // the timer holds waiter id only, waiter is found again under the lock
+    bthread_timer_add(&waiter->timer_id, butil::milliseconds_from_now(timeout_ms), &TxnLockWaitManager::OnTimeout,
+                      reinterpret_cast<void*>(waiter->id));
+  }
+
+  waiter_count_metrics_ << 1;
+
+  DINGO_LOG(DEBUG) << fmt::format("[txn.lock_wait][region({})] wait lock, start_ts: {} lock_ts: {} key: {} timeout: {}",
+                                  region_id, start_ts, lock_ts, Helper::StringToHex(key), timeout_ms);
+
+  return WaitResult::kWaiting;
+}
+
+void TxnLockWaitManager::WakeUp(int64_t region_id, const std::string& key) {
+  WaiterPtr waiter;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    // bumped under the lock, the concurrent Wait either sees the new sequence or its waiter is found here
+    ReleaseSeq(region_id, key).fetch_add(1);
+
+    auto region_it = key_waiters_.find(region_id);
+    if (region_it == key_waiters_.end()) {
+      return;
+    }
+    auto key_it = region_it->second.find(key);
+    if (key_it == region_it->second.end() || key_it->second.empty()) {
+      return;
+    }
+
+    waiter = RemoveWaiterUnlocked(key_it->second.front());
+  }
+
+  if (waiter == nullptr) {
+    return;
+  }
+
+  // the timer is running when fail to delete, it will not find the waiter
+  bthread_timer_del(waiter->timer_id);
+
+  DINGO_LOG(DEBUG) << fmt::format("[txn.lock_wait][region({})] wake up waiter, start_ts: {} lock_ts: {} key: {}",
+                                  region_id, waiter->start_ts, waiter->lock_ts, Helper::StringToHex(key));
+
+  waiter->wake_func(false);
+}
+
+void TxnLockWaitManager::OnTimeout(void* arg) {
+  auto& self = GetInstance();
+  int64_t waiter_id = reinterpret_cast<int64_t>(arg);
+
+  WaiterPtr waiter;
+  {
+    BAIDU_SCOPED_LOCK(self.mutex_);
+    waiter = self.RemoveWaiterUnlocked(waiter_id);
+  }
+
+  if (waiter == nullptr) {
+    return;
+  }
+
+  self.timeout_count_metrics_ << 1;
+
+  DINGO_LOG(INFO) << fmt::format("[txn.lock_wait][region({})] wait lock timeout, start_ts: {} lock_ts: {} key: {}",
+                                 waiter->region_id, waiter->start_ts, waiter->lock_ts,
+                                 Helper::StringToHex(waiter->key));
+
+  waiter->wake_func(true);
+}
+
+int64_t TxnLockWaitManager::WaiterCount() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return waiters_.size();
+}
+
+bool TxnLockWaitManager::IsWaitingForUnlocked(int64_t lock_ts, int64_t start_ts, std::vector<int64_t>& path) {
+  using EdgeIter = std::map<int64_t, int32_t>::const_iterator;
+
+  auto graph_it = wait_for_graph_.find(lock_ts);
+  if (graph_it == wait_for_graph_.end()) {
+    return false;
+  }
+
+  // dfs on the wait-for graph, path is the txns of stack
+  std::set<int64_t> visited{lock_ts};
+  std::vector<std::pair<EdgeIter, EdgeIter>> stack;
+  stack.emplace_back(graph_it->second.begin(), graph_it->second.end());
+  path.push_back(lock_ts);
+
+  while (!stack.empty()) {
+    auto& edges = stack.back();
+    if (edges.first == edges.second) {
+      stack.pop_back();
+      path.pop_back();
+      continue;
+    }
+
+    int64_t next_ts = (edges.first++)->first;
+    if (next_ts == start_ts) {
+      return true;
+    }
+    if (!visited.insert(next_ts).second) {
+      continue;
+    }
+
+    auto next_it = wait_for_graph_.find(next_ts);
+    if (next_it != wait_for_graph_.end()) {
+      stack.emplace_back(next_it->second.begin(), next_it->second.end());
+      path.push_back(next_ts);
+    }
+  }
+
+  return false;
+}
+
+TxnLockWaitManager::WaiterPtr TxnLockWaitManager::RemoveWaiterUnlocked(int64_t waiter_id) {
+  auto it = waiters_.find(waiter_id);
+  if (it == waiters_.end()) {
+    return nullptr;
+  }
+  auto waiter = it->second;
+  waiters_.erase(it);
+
+  auto region_it = key_waiters_.find(waiter->region_id);
+  if (region_it != key_waiters_.end()) {
+    auto key_it = region_it->second.find(waiter->key);
+    if (key_it != region_it->second.end()) {
+      auto& waiter_ids = key_it->second;
+      waiter_ids.erase(std::remove(waiter_ids.begin(), waiter_ids.end(), waiter_id), waiter_ids.end());
+      if (waiter_ids.empty()) {
+        region_it->second.erase(key_it);
+      }
+    }
+    if (region_it->second.empty()) {
+      key_waiters_.erase(region_it);
+    }
+  }
+
+  auto graph_it = wait_for_graph_.find(waiter->start_ts);
+  if (graph_it != wait_for_graph_.end()) {
+    auto edge_it = graph_it->second.find(waiter->lock_ts);
+    if (edge_it != graph_it->second.end() && --edge_it->second <= 0) {
+      graph_it->second.erase(edge_it);
+    }
+    if (graph_it->second.empty()) {
+      wait_for_graph_.erase(graph_it);
+    }
+  }
+
+  waiter_count_metrics_ << -1;
+  wait_latency_ << Helper::TimestampMs() - waiter->start_time_ms;
+
+  return waiter;
+}
+
+}  // namespace dingodb
@@ -0,0 +1,124 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_TXN_LOCK_WAIT_MANAGER_H_  // NOLINT
+#define DINGODB_ENGINE_TXN_LOCK_WAIT_MANAGER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "bthread/unstable.h"
+#include "bvar/latency_recorder.h"
+#include "bvar/reducer.h"
+#include "gflags/gflags.h"
+
+namespace dingodb {
+
+DECLARE_int64(txn_pessimistic_lock_wait_timeout_ms);
+
+// Wait queue of pessimistic lock conflict in leader.
+// The conflicting pessimistic lock request parks on the locked key instead of returning the conflict to client, and
+// the waiters of key are woken in FIFO order when the lock is released by commit/rollback apply, or on timeout.
+// Waiting for the lock adds the edge waiter -> lock holder to the wait-for graph of store, the request which makes a
+// cycle is rejected as deadlock.
+// The lock may be released between reading it and waiting for it, every release bumps the release sequence of key,
+// the request reads the sequence before reading the lock and retries at once if it moved when it starts waiting.
+class TxnLockWaitManager {
+ public:
+  static TxnLockWaitManager& GetInstance();
+
+  TxnLockWaitManager(const TxnLockWaitManager& rhs) = delete;
+  TxnLockWaitManager& operator=(const TxnLockWaitManager& rhs) = delete;
+  TxnLockWaitManager(TxnLockWaitManager&& rhs) = delete;
+  TxnLockWaitManager& operator=(TxnLockWaitManager&& rhs) = delete;
+
+  // is_timeout is false when the lock is released, wake_func is called out of lock.
+  using WakeFunc = std::function<void(bool is_timeout)>;
+
+  enum class WaitResult {
+    kWaiting = 0,
+    // waiting makes deadlock, wait_chain is the txns in the cycle, begin with start_ts
+    kDeadlock = 1,
+    // the lock is released after release_seq is read, retry the lock now
+    kReleased = 2,
+  };
+
+  // Read before reading the lock of key, and pass it to Wait.
+  int64_t GetReleaseSeq(int64_t region_id, const std::string& key);
+
+  // Txn start_ts waits for the lock of key which is held by txn lock_ts, at most timeout_ms.
+  WaitResult Wait(int64_t region_id, const std::string& key, int64_t start_ts, int64_t lock_ts, int64_t release_seq,
+                  int64_t timeout_ms, WakeFunc wake_func, std::vector<int64_t>& wait_chain);
+
+  // The lock of key is released, wake up the first waiter. The woken waiter calls it again if it doesn't take the
+  // lock, so the next waiter is not left waiting for the released lock.
+  void WakeUp(int64_t region_id, const std::string& key);
+
+  int64_t WaiterCount();
+
+ private:
+  TxnLockWaitManager();
+  ~TxnLockWaitManager();
+
+  struct Waiter {
+    int64_t id;
+    int64_t region_id;
+    std::string key;
+    int64_t start_ts;
+    int64_t lock_ts;
+    int64_t start_time_ms;
+    bthread_timer_t timer_id;
+    WakeFunc wake_func;
+  };
+  using WaiterPtr = std::shared_ptr<Waiter>;
+
+  static void OnTimeout(void* arg);
+
+  // Whether lock_ts waits for start_ts directly or indirectly, path is the txns from lock_ts to the one waits for
+  // start_ts.
+  bool IsWaitingForUnlocked(int64_t lock_ts, int64_t start_ts, std::vector<int64_t>& path);
+  WaiterPtr RemoveWaiterUnlocked(int64_t waiter_id);
+
+  std::atomic<int64_t>& ReleaseSeq(int64_t region_id, const std::string& key);
+
+  bthread_mutex_t mutex_;
+  std::atomic<int64_t> waiter_id_generator_{0};
+  // waiter_id -> waiter
+  std::map<int64_t, WaiterPtr> waiters_;
+  // region_id -> key -> waiter_ids in FIFO order
+  std::map<int64_t, std::map<std::string, std::deque<int64_t>>> key_waiters_;
+  // wait-for graph, start_ts -> lock_ts -> waiter count
+  std::map<int64_t, std::map<int64_t, int32_t>> wait_for_graph_;
+
+  // release sequences of keys hashed into fixed slots, keys sharing a slot only cause extra retries
+  static constexpr size_t kReleaseSeqSlotNum = 4096;
+  std::array<std::atomic<int64_t>, kReleaseSeqSlotNum> release_seqs_{};
+
+  bvar::Adder<int64_t> waiter_count_metrics_;
+  bvar::Adder<int64_t> deadlock_count_metrics_;
+  bvar::Adder<int64_t> timeout_count_metrics_;
+  bvar::LatencyRecorder wait_latency_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_TXN_LOCK_WAIT_MANAGER_H_  // NOLINT
@@ -42,6 +42,12 @@ int SmApplyEventListener::OnEvent(std::shared_ptr<Event> event) {
   auto* done = dynamic_cast<BaseClosure*>(the_event->done);
   auto ctx = done ? done->GetCtx() : nullptr;
   for (const auto& req : the_event->raft_cmd->requests()) {
+    auto tracker = ctx ? ctx->Tracker() : nullptr;
+    if (tracker) {
+      tracker->SetRaftCommitTime(the_event->commit_time_ns);
+      tracker->SetRaftApplyStartTime();
+    }
+
     auto handler = handler_collection_->GetHandler(static_cast<HandlerType>(req.cmd_type()));
     if (handler) {
       handler->Handle(ctx, the_event->region, the_event->engine, req, the_event->region_metrics, the_event->term_id,
@@ -49,6 +55,10 @@ int SmApplyEventListener::OnEvent(std::shared_ptr<Event> event) {
     } else {
       DINGO_LOG(ERROR) << "Unknown raft cmd type " << req.cmd_type();
     }
+
+    if (tracker) {
+      tracker->SetRaftApplyEndTime();
+    }
   }
 
   return 0;
@@ -38,6 +38,8 @@ struct SmApplyEvent : public Event {
   std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd;
   int64_t term_id;
   int64_t log_id;
+  // time of log entry reach state machine, in ns
+  int64_t commit_time_ns{0};
 };
 
 class SmApplyEventListener : public EventListener {
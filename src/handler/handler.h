@@ -60,6 +60,10 @@ enum class HandlerType {
   kVectorIndexLeaderStop = 2001,
   kVectorIndexFollowerStart = 2002,
   kVectorIndexFollowerStop = 2003,
+
+  // Txn
+  kTxnLeaderStart = 3000,
+  kTxnLeaderStop = 3001,
 };
 
 class Handler {
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -27,7 +28,9 @@
 #include "common/helper.h"
 #include "common/logging.h"
 #include "engine/iterator.h"
+#include "engine/txn_concurrency_manager.h"
 #include "engine/txn_engine_helper.h"
+#include "engine/txn_lock_wait_manager.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
 #include "handler/raft_apply_handler.h"
@@ -127,6 +130,43 @@ void TxnHandler::HandleMultiCfPutAndDeleteRequest(std::shared_ptr<Context> ctx,
                      << ", write failed, request: " << request.ShortDebugString();
   }
 
+  // the locks are released by commit/rollback, wake up the pessimistic lock waiters
+  auto lock_deletes_it = kv_deletes_with_cf.find(Constant::kTxnLockCF);
+  if (lock_deletes_it != kv_deletes_with_cf.end()) {
+    for (const auto &lock_key : lock_deletes_it->second) {
+      std::string key;
+      int64_t ts = 0;
+      if (Helper::DecodeTxnKey(lock_key, key, ts).ok()) {
+        TxnLockWaitManager::GetInstance().WakeUp(region->Id(), key);
+      }
+    }
+  }
+
+  // the prewrite of 1PC/async commit with uncertain result is applied, unlock its memory locks
+  auto &concurrency_manager = TxnConcurrencyManager::GetInstance();
+  if (concurrency_manager.HasDeferredLocks()) {
+    std::set<int64_t> start_ts_set;
+    for (const auto &puts : request.puts_with_cf()) {
+      for (const auto &kv : puts.kvs()) {
+        if (puts.cf_name() == Constant::kTxnLockCF) {
+          pb::store::LockInfo lock_info;
+          if (lock_info.ParseFromString(kv.value())) {
+            start_ts_set.insert(lock_info.lock_ts());
+          }
+        } else if (puts.cf_name() == Constant::kTxnWriteCF) {
+          pb::store::WriteInfo write_info;
+          if (write_info.ParseFromString(kv.value())) {
+            start_ts_set.insert(write_info.start_ts());
+          }
+        }
+      }
+    }
+
+    for (auto start_ts : start_ts_set) {
+      concurrency_manager.OnTxnApplied(region->Id(), start_ts);
+    }
+  }
+
   // check if need to commit to vector index
   const auto &vector_add = request.vector_add();
   if (vector_add.vectors_size() > 0) {
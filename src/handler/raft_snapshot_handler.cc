@@ -14,10 +14,13 @@
 
 #include "handler/raft_snapshot_handler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -42,6 +45,9 @@
 namespace dingodb {
 
 DEFINE_string(raft_snapshot_policy, "dingo", "raft snapshot policy, checkpoint or scan");
+DEFINE_int64(raft_snapshot_sub_range_size, 64 * 1024 * 1024, "scan snapshot split region into sub range by this size");
+DEFINE_int32(raft_snapshot_max_sub_range_num, 16, "scan snapshot max sub range num of one column family");
+DEFINE_int32(raft_snapshot_concurrency, 8, "scan snapshot concurrency of generating sst file");
 
 struct SaveRaftSnapshotArg {
   store::RegionPtr region;
@@ -53,7 +59,43 @@ struct SaveRaftSnapshotArg {
   int64_t log_index;
 };
 
+// Split range into sub ranges by bisecting key space, the sub ranges are written to sst file in parallel.
+std::vector<pb::common::Range> RaftSnapshot::SplitSnapshotRange(const pb::common::Range& range,
+                                                                int64_t sub_range_num) {
+  std::vector<pb::common::Range> sub_ranges = {range};
+  while (sub_ranges.size() < sub_range_num) {
+    std::vector<pb::common::Range> tmp_sub_ranges;
+    for (const auto& sub_range : sub_ranges) {
+      std::string middle_key = Helper::CalculateMiddleKey(sub_range.start_key(), sub_range.end_key());
+      if (middle_key <= sub_range.start_key() || middle_key >= sub_range.end_key()) {
+        tmp_sub_ranges.push_back(sub_range);
+        continue;
+      }
+
+      pb::common::Range left_range;
+      left_range.set_start_key(sub_range.start_key());
+      left_range.set_end_key(middle_key);
+      tmp_sub_ranges.push_back(left_range);
+
+      pb::common::Range right_range;
+      right_range.set_start_key(middle_key);
+      right_range.set_end_key(sub_range.end_key());
+      tmp_sub_ranges.push_back(right_range);
+    }
+
+    // can't split any more
+    if (tmp_sub_ranges.size() == sub_ranges.size()) {
+      break;
+    }
+    sub_ranges.swap(tmp_sub_ranges);
+  }
+
+  return sub_ranges;
+}
+
 // Scan region, generate sst snapshot file
+// Every column family of region is split into sub ranges, each sub range is written to a sst file by bthread.
+// The sst files of the same column family are not overlapped, follower ingest them directly.
 butil::Status RaftSnapshot::GenSnapshotFileByScan(const std::string& checkpoint_path, store::RegionPtr region,
                                                   std::vector<pb::store_internal::SstFileInfo>& sst_files) {
   if (!std::filesystem::create_directories(checkpoint_path)) {
@@ -63,36 +105,98 @@ butil::Status RaftSnapshot::GenSnapshotFileByScan(const std::string& checkpoint_
   }
   auto raw_engine = std::dynamic_pointer_cast<RawRocksEngine>(engine_);
   auto range = region->Range();
-  // Build Iterator
-  IteratorOptions options;
-  options.upper_bound = range.end_key();
 
-  auto iter = raw_engine->Reader()->NewIterator(Constant::kStoreDataCF, engine_snapshot_, options);
-  iter->Seek(range.start_key());
+  struct Parameter {
+    std::shared_ptr<RawRocksEngine> raw_engine;
+    std::shared_ptr<Snapshot> engine_snapshot;
+    std::vector<pb::store_internal::SstFileInfo> sst_files;
+    std::atomic<int> offset;
+    std::vector<butil::Status> results;
+  };
+
+  auto param = std::make_shared<Parameter>();
+  param->raw_engine = raw_engine;
+  param->engine_snapshot = engine_snapshot_;
+  param->offset = 0;
+
+  for (const auto& cf_name : Helper::GetColumnFamilyNames(range.start_key())) {
+    std::vector<pb::common::Range> ranges = {range};
+    int64_t size = raw_engine->GetApproximateSizes(cf_name, ranges)[0];
+    int64_t sub_range_size = std::max(FLAGS_raft_snapshot_sub_range_size, int64_t{1});
+    int64_t sub_range_num =
+        std::clamp<int64_t>(size / sub_range_size + 1, 1, std::max(FLAGS_raft_snapshot_max_sub_range_num, 1));
+
+    auto sub_ranges = SplitSnapshotRange(range, sub_range_num);
+    for (int i = 0; i < sub_ranges.size(); ++i) {
+      std::string sst_name = fmt::format("{}_{}.sst", cf_name, i);
+
+      pb::store_internal::SstFileInfo sst_file;
+      sst_file.set_level(0);
+      sst_file.set_name(sst_name);
+      sst_file.set_path(checkpoint_path + "/" + sst_name);
+      sst_file.set_start_key(sub_ranges[i].start_key());
+      sst_file.set_end_key(sub_ranges[i].end_key());
+      sst_file.set_cf_name(cf_name);
+      param->sst_files.push_back(sst_file);
+    }
 
-  // Build sst name and path
-  std::string sst_name = std::to_string(region->Id()) + ".sst";
-  const std::string sst_path = checkpoint_path + "/" + sst_name;
+    DINGO_LOG(INFO) << fmt::format("[raft.snapshot][region({})] cf({}) approximate size({}) sub range num({})",
+                                   region->Id(), cf_name, size, sub_ranges.size());
+  }
+  param->results.resize(param->sst_files.size());
 
-  auto status = RawRocksEngine::NewSstFileWriter()->SaveFile(iter, sst_path);
-  if (!status.ok()) {
-    if (status.error_code() != pb::error::ENO_ENTRIES) {
-      DINGO_LOG(ERROR) << fmt::format("[raft.snapshot][region({})] save file failed, path: {} error: {} {}",
-                                      region->Id(), sst_path, status.error_code(), status.error_str());
+  auto task = [](void* arg) -> void* {
+    auto* param = static_cast<Parameter*>(arg);
+
+    for (;;) {
+      int offset = param->offset.fetch_add(1, std::memory_order_relaxed);
+      if (offset >= param->sst_files.size()) {
+        break;
+      }
+
+      const auto& sst_file = param->sst_files[offset];
+      IteratorOptions options;
+      options.lower_bound = sst_file.start_key();
+      options.upper_bound = sst_file.end_key();
+      auto iter = param->raw_engine->Reader()->NewIterator(sst_file.cf_name(), param->engine_snapshot, options);
+      iter->Seek(sst_file.start_key());
+
+      param->results[offset] = RawRocksEngine::NewSstFileWriter()->SaveFile(iter, sst_file.path());
     }
-    return status;
+
+    return nullptr;
+  };
+
+  int64_t start_time = Helper::TimestampMs();
+  int concurrency = std::min(static_cast<int>(param->sst_files.size()), std::max(FLAGS_raft_snapshot_concurrency, 1));
+  if (!Helper::ParallelRunTask(task, param.get(), concurrency)) {
+    return butil::Status(pb::error::EINTERNAL, "Create bthread failed.");
   }
 
-  // Set sst file info
-  pb::store_internal::SstFileInfo sst_file;
-  sst_file.set_level(0);
-  sst_file.set_name(sst_name);
-  sst_file.set_path(sst_path);
-  sst_file.set_start_key(range.start_key());
-  sst_file.set_end_key(range.end_key());
+  int64_t total_size = 0;
+  for (int i = 0; i < param->sst_files.size(); ++i) {
+    const auto& sst_file = param->sst_files[i];
+    const auto& status = param->results[i];
+    if (!status.ok()) {
+      // empty sub range has no sst file
+      if (status.error_code() == pb::error::ENO_ENTRIES) {
+        continue;
+      }
+      DINGO_LOG(ERROR) << fmt::format("[raft.snapshot][region({})] save file failed, path: {} error: {} {}",
+                                      region->Id(), sst_file.path(), status.error_code(), status.error_str());
+      return status;
+    }
+
+    total_size += Helper::GetFileSize(sst_file.path());
+    DINGO_LOG(INFO) << "sst file info: " << sst_file.ShortDebugString();
+    sst_files.push_back(sst_file);
+  }
 
-  DINGO_LOG(INFO) << "sst file info: " << sst_file.ShortDebugString();
-  sst_files.push_back(sst_file);
+  DINGO_LOG(INFO) << fmt::format(
+      "[raft.snapshot][region({})] gen snapshot file by scan finish, file count({}/{}) size({}) concurrency({}) "
+      "elapsed time({}ms)",
+      region->Id(), sst_files.size(), param->sst_files.size(), total_size, concurrency,
+      Helper::TimestampMs() - start_time);
 
   return butil::Status();
 }
@@ -360,18 +464,7 @@ bool RaftSnapshot::LoadSnapshot(braft::SnapshotReader* reader, store::RegionPtr
       sst_files.push_back(merge_file_path);
     }
   } else {  // The snapshot is generated by use scan.
-    DINGO_LOG(ERROR) << fmt::format(
-        "[raft.snapshot][region({})] snapshot not include CURRENT file, snapshot by scan is not support now",
-        region->Id());
-    return false;
-
-    for (auto& file : files) {
-      if (file == Constant::kRaftSnapshotRegionMetaFileName) {
-        continue;
-      }
-      std::string filepath = reader->get_path() + "/" + file;
-      sst_files.push_back(filepath);
-    }
+    return LoadSnapshotByScan(reader, region, files);
   }
 
   FAIL_POINT("load_snapshot_suspend");
@@ -413,6 +506,51 @@ bool RaftSnapshot::LoadSnapshot(braft::SnapshotReader* reader, store::RegionPtr
   return true;
 }
 
+// Load snapshot generated by scan, the sst files are ingested directly without re-encoding.
+bool RaftSnapshot::LoadSnapshotByScan(braft::SnapshotReader* reader, store::RegionPtr region,
+                                      const std::vector<std::string>& files) {
+  int64_t start_time = Helper::TimestampMs();
+
+  // group sst files by column family, the sst files of a column family are not overlapped
+  std::map<std::string, std::vector<std::string>> cf_sst_files;
+  for (const auto& file : files) {
+    if (file == Constant::kRaftSnapshotRegionMetaFileName) {
+      continue;
+    }
+
+    braft::LocalFileMeta file_meta;
+    pb::store_internal::SstFileInfo sst_file;
+    if (reader->get_file_meta(file, &file_meta) != 0 || !sst_file.ParseFromString(file_meta.user_meta()) ||
+        sst_file.cf_name().empty()) {
+      DINGO_LOG(ERROR) << fmt::format("[raft.snapshot][region({})] parse sst file meta failed, file: {}", region->Id(),
+                                      file);
+      return false;
+    }
+
+    cf_sst_files[sst_file.cf_name()].push_back(reader->get_path() + "/" + file);
+  }
+
+  FAIL_POINT("load_snapshot_suspend");
+
+  auto raw_engine = std::dynamic_pointer_cast<RawRocksEngine>(engine_);
+  for (const auto& [cf_name, sst_files] : cf_sst_files) {
+    auto status = raw_engine->IngestExternalFile(cf_name, sst_files);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("[raft.snapshot][region({})] ingest sst file failed, cf_name: {} error: {} {}",
+                                      region->Id(), cf_name, status.error_code(), status.error_str());
+      return false;
+    }
+
+    DINGO_LOG(INFO) << fmt::format("[raft.snapshot][region({})] successfully ingest sst file, cf_name: {} count: {}",
+                                   region->Id(), cf_name, sst_files.size());
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[raft.snapshot][region({})] load snapshot success, elapsed time({}ms)", region->Id(),
+                                 Helper::TimestampMs() - start_time);
+
+  return true;
+}
+
 bool RaftSnapshot::LoadSnapshotDingo(braft::SnapshotReader* reader, store::RegionPtr region) {
   DINGO_LOG(INFO) << fmt::format("[raft.snapshot][region({})] load snapshot...", region->Id());
   std::vector<std::string> files;
@@ -16,6 +16,8 @@
 #define DINGODB_RAFT_SNAPSHOT_H_
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include "braft/snapshot.h"
 #include "butil/status.h"
@@ -58,9 +60,14 @@ class RaftSnapshot {
 
   bool LoadSnapshot(braft::SnapshotReader* reader, store::RegionPtr region);
   bool LoadSnapshotDingo(braft::SnapshotReader* reader, store::RegionPtr region);
+  bool LoadSnapshotByScan(braft::SnapshotReader* reader, store::RegionPtr region,
+                          const std::vector<std::string>& files);
 
   butil::Status HandleRaftSnapshotRegionMeta(braft::SnapshotReader* reader, store::RegionPtr region);
 
+  // Bisect range until there are at least sub_range_num sub ranges, or the range can't be split any more.
+  static std::vector<pb::common::Range> SplitSnapshotRange(const pb::common::Range& range, int64_t sub_range_num);
+
  private:
   std::shared_ptr<RawEngine> engine_;
   std::shared_ptr<Snapshot> engine_snapshot_;
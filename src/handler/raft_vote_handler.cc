@@ -14,16 +14,26 @@
 
 #include "handler/raft_vote_handler.h"
 
+#include <cstdint>
+#include <memory>
+
+#include "bthread/bthread.h"
 #include "common/role.h"
+#include "coordinator/tso_control.h"
+#include "engine/txn_concurrency_manager.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "meta/store_meta_manager.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
+#include "proto/meta.pb.h"
 #include "server/server.h"
 #include "vector/vector_index_snapshot_manager.h"
 
 namespace dingodb {
 
+DEFINE_int64(txn_max_ts_sync_retry_interval_ms, 1000, "retry interval of syncing max_ts from tso when being leader");
+
 int VectorIndexLeaderStartHandler::Handle(store::RegionPtr region, int64_t) {
   if (region == nullptr) {
     return 0;
@@ -90,8 +100,83 @@ int VectorIndexFollowerStopHandler::Handle(store::RegionPtr /*region*/, const br
   return 0;
 }
 
+static butil::Status GenTso(int64_t& tso) {
+  pb::meta::TsoRequest request;
+  pb::meta::TsoResponse response;
+  request.set_op_type(pb::meta::TsoOpType::OP_GEN_TSO);
+  request.set_count(1);
+
+  auto status = Server::GetInstance().GetCoordinatorInteractionMeta()->SendRequest("TsoService", request, response);
+  if (!status.ok()) {
+    return status;
+  }
+
+  tso = (response.start_timestamp().physical() << kLogicalBits) + response.start_timestamp().logical();
+  return butil::Status::OK();
+}
+
+struct SyncMaxTsArg {
+  int64_t region_id;
+  int64_t term;
+};
+
+// The previous leader may serve reads which start_ts is greater than max_ts of this store, a tso fetched now is
+// greater than all of them. Retry until synced, or the region is not leader in term any more.
+static void* SyncMaxTs(void* arg) {
+  std::unique_ptr<SyncMaxTsArg> sync_arg(static_cast<SyncMaxTsArg*>(arg));
+  auto& concurrency_manager = TxnConcurrencyManager::GetInstance();
+
+  while (concurrency_manager.IsMaxTsSyncing(sync_arg->region_id, sync_arg->term)) {
+    int64_t tso = 0;
+    auto status = GenTso(tso);
+    if (status.ok()) {
+      if (concurrency_manager.SyncMaxTs(sync_arg->region_id, sync_arg->term, tso)) {
+        DINGO_LOG(INFO) << fmt::format("[raft.handle][region({})] sync max_ts from tso {}, term: {}",
+                                       sync_arg->region_id, tso, sync_arg->term);
+      }
+      break;
+    }
+
+    DINGO_LOG(WARNING) << fmt::format("[raft.handle][region({})] sync max_ts from tso failed, term: {} error: {} {}",
+                                      sync_arg->region_id, sync_arg->term, status.error_code(), status.error_str());
+    bthread_usleep(FLAGS_txn_max_ts_sync_retry_interval_ms * 1000);
+  }
+
+  return nullptr;
+}
+
+int TxnLeaderStartHandler::Handle(store::RegionPtr region, int64_t term_id) {
+  if (region == nullptr) {
+    return 0;
+  }
+
+  // 1PC and async commit fall back to 2PC until max_ts is synced
+  TxnConcurrencyManager::GetInstance().OnLeaderStart(region->Id(), term_id);
+
+  auto* arg = new SyncMaxTsArg{region->Id(), term_id};
+  bthread_t tid;
+  if (bthread_start_background(&tid, &BTHREAD_ATTR_NORMAL, SyncMaxTs, arg) != 0) {
+    delete arg;
+    DINGO_LOG(ERROR) << fmt::format("[raft.handle][region({})] start sync max_ts bthread failed.", region->Id());
+    return -1;
+  }
+
+  return 0;
+}
+
+int TxnLeaderStopHandler::Handle(store::RegionPtr region, butil::Status) {
+  if (region == nullptr) {
+    return 0;
+  }
+
+  TxnConcurrencyManager::GetInstance().OnLeaderStop(region->Id());
+
+  return 0;
+}
+
 std::shared_ptr<HandlerCollection> LeaderStartHandlerFactory::Build() {
   auto handler_collection = std::make_shared<HandlerCollection>();
+  handler_collection->Register(std::make_shared<TxnLeaderStartHandler>());
   if (GetRole() == pb::common::INDEX) {
     handler_collection->Register(std::make_shared<VectorIndexLeaderStartHandler>());
   }
@@ -101,6 +186,7 @@ std::shared_ptr<HandlerCollection> LeaderStartHandlerFactory::Build() {
 
 std::shared_ptr<HandlerCollection> LeaderStopHandlerFactory::Build() {
   auto handler_collection = std::make_shared<HandlerCollection>();
+  handler_collection->Register(std::make_shared<TxnLeaderStopHandler>());
   if (GetRole() == pb::common::INDEX) {
     handler_collection->Register(std::make_shared<VectorIndexLeaderStopHandler>());
   }
@@ -47,6 +47,20 @@ class VectorIndexFollowerStopHandler : public BaseHandler {
   int Handle(store::RegionPtr region, const braft::LeaderChangeContext &ctx) override;
 };
 
+// TxnLeaderStart, sync max_ts from TSO
+class TxnLeaderStartHandler : public BaseHandler {
+ public:
+  HandlerType GetType() override { return HandlerType::kTxnLeaderStart; }
+  int Handle(store::RegionPtr region, int64_t term_id) override;
+};
+
+// TxnLeaderStop
+class TxnLeaderStopHandler : public BaseHandler {
+ public:
+  HandlerType GetType() override { return HandlerType::kTxnLeaderStop; }
+  int Handle(store::RegionPtr region, butil::Status status) override;
+};
+
 // Leader start handler collection
 class LeaderStartHandlerFactory : public HandlerFactory {
  public:
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -30,6 +31,7 @@
 #include "braft/util.h"
 #include "brpc/reloadable_flags.h"  //
 #include "butil/atomicops.h"
+#include "butil/crc32c.h"
 #include "butil/errno.h"
 #include "butil/fd_utility.h"              // butil::make_close_on_exec
 #include "butil/file_util.h"               // butil::CreateDirectory
@@ -42,11 +44,19 @@
 #include "common/logging.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
+#include "lz4.h"
 #include "proto/store_internal.pb.h"
+#include "zstd.h"
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define DINGO_ARM_CRC32C 1
+#endif
 
 #define SEGMENT_OPEN_PATTERN "log_inprogress_%020" PRId64
 #define SEGMENT_CLOSED_PATTERN "log_%020" PRId64 "_%020" PRId64
 #define SEGMENT_META_FILE "log_meta"
+#define SEGMENT_INDEX_PATTERN "log_index_%020" PRId64 "_%020" PRId64
 
 namespace dingodb {
 
@@ -58,6 +68,17 @@ static const bool kTraceAppendEntryLatency = false;
 static bvar::LatencyRecorder g_segment_log_open_segment_latency("segment_log_open_segment");
 static bvar::LatencyRecorder g_segment_log_append_entry_latency("segment_log_append_entry");
 static bvar::LatencyRecorder g_segment_log_sync_segment_latency("segment_log_sync_segment");
+// bytes of entry data before and after compression, the ratio of them is the compression ratio
+static bvar::Adder<int64_t> g_segment_log_append_data_bytes("segment_log_append_data_bytes");
+static bvar::Adder<int64_t> g_segment_log_write_data_bytes("segment_log_write_data_bytes");
+static bvar::LatencyRecorder g_segment_log_load_segments_latency("segment_log_load_segments");
+static bvar::Adder<int64_t> g_segment_log_load_by_index_count("segment_log_load_by_index_count");
+static bvar::Adder<int64_t> g_segment_log_load_by_scan_count("segment_log_load_by_scan_count");
+
+DEFINE_string(raft_log_compression, "none", "compression type of raft log entry data, none/lz4/zstd");
+DEFINE_int32(raft_log_compression_min_size, 4096, "raft log entry data smaller than it is not compressed");
+DEFINE_int32(raft_log_zstd_compression_level, 1, "zstd compression level of raft log entry data");
+DEFINE_bool(raft_log_enable_segment_index, true, "persist entry index of closed segment for loading it without scan");
 
 int FtruncateUninterrupted(int fd, off_t length) {
   int rc = 0;
@@ -72,6 +93,14 @@ enum class CheckSumType {
   kCrc32 = 1,
 };
 
+// Compression type is recorded in every entry header, so segments can mix compressed and uncompressed entries,
+// and the entries written by old version have 0 (kNone) in the reserved field.
+enum class CompressionType {
+  kNone = 0,
+  kLz4 = 1,
+  kZstd = 2,
+};
+
 enum class SyncPolicy {
   kImmediately = 0,
   kByBytes = 1,
@@ -81,37 +110,102 @@ static const SyncPolicy kSegmentLogSyncPolicy = SyncPolicy::kImmediately;
 
 // Format of Header, all fields are in network order
 // | -------------------- term (64bits) -------------------------  |
-// | entry-type (8bits) | checksum_type (8bits) | reserved(16bits) |
+// | entry-type (8bits) | checksum_type (8bits) | compress_type (8bits) | reserved(8bits) |
 // | ------------------ data len (32bits) -----------------------  |
 // | data_checksum (32bits) | header checksum (32bits)             |
+// data len and data checksum are of the stored data, if the data is compressed, the format of stored data is
+// | uncompressed data len (32bits) | compressed data |
 
 const static size_t kEntryHeaderSize = 24;
 
+// Format of segment index file, all fields are in network order
+// | magic (32bits) | version (32bits) | segment file size (64bits) | entry count (64bits) | conf count (64bits) |
+// | offset (64bits) | term (64bits) | ... one for each entry
+// | configuration entry index (64bits) | ... one for each configuration entry
+// | checksum (32bits) |
+
+const static uint32_t kSegmentIndexMagic = 0x44534958;
+const static uint32_t kSegmentIndexVersion = 1;
+const static size_t kSegmentIndexHeaderSize = 32;
+
 struct Segment::EntryHeader {
   int64_t term;
   int type;
   int checksum_type;
+  int compress_type;
   uint32_t data_len;
   uint32_t data_checksum;
 };
 
 std::string ToString(const Segment::EntryHeader& h) {
-  return fmt::format("(term={}, type={}, data_len={}, checksum_type={}, data_checksum={})", h.term, h.type, h.data_len,
-                     h.checksum_type, h.data_checksum);
+  return fmt::format("(term={}, type={}, data_len={}, checksum_type={}, compress_type={}, data_checksum={})", h.term,
+                     h.type, h.data_len, h.checksum_type, h.compress_type, h.data_checksum);
 }
 
 std::ostream& operator<<(std::ostream& os, const Segment::EntryHeader& h) {
   os << "{term=" << h.term << ", type=" << h.type << ", data_len=" << h.data_len
-     << ", checksum_type=" << h.checksum_type << ", data_checksum=" << h.data_checksum << '}';
+     << ", checksum_type=" << h.checksum_type << ", compress_type=" << h.compress_type
+     << ", data_checksum=" << h.data_checksum << '}';
   return os;
 }
 
+// butil::crc32c only accelerates by sse4.2, on armv8 use the crc32c instructions.
+// Both compute the standard crc32c, so the checksum of entries is the same on all platforms.
+#ifdef DINGO_ARM_CRC32C
+static uint32_t ArmCrc32cExtend(uint32_t crc, const char* data, size_t len) {
+  crc = ~crc;
+  while (len >= 8) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    crc = __crc32cd(crc, value);
+    data += 8;
+    len -= 8;
+  }
+  while (len > 0) {
+    crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+    ++data;
+    --len;
+  }
+  return ~crc;
+}
+#endif
+
+static bool IsFastCrc32cSupported() {
+#ifdef DINGO_ARM_CRC32C
+  return true;
+#else
+  return butil::crc32c::IsFastCrc32Supported();
+#endif
+}
+
+static uint32_t Crc32c(const char* data, size_t len) {
+#ifdef DINGO_ARM_CRC32C
+  return ArmCrc32cExtend(0, data, len);
+#else
+  return braft::crc32(data, len);
+#endif
+}
+
+static uint32_t Crc32c(const butil::IOBuf& data) {
+#ifdef DINGO_ARM_CRC32C
+  uint32_t crc = 0;
+  const size_t block_num = data.backing_block_num();
+  for (size_t i = 0; i < block_num; ++i) {
+    auto block = data.backing_block(i);
+    crc = ArmCrc32cExtend(crc, block.data(), block.size());
+  }
+  return crc;
+#else
+  return braft::crc32(data);
+#endif
+}
+
 inline bool VerifyChecksum(int checksum_type, const char* data, size_t len, uint32_t value) {
   switch (static_cast<CheckSumType>(checksum_type)) {
     case CheckSumType::kMurmurhash32:
       return (value == braft::murmurhash32(data, len));
     case CheckSumType::kCrc32:
-      return (value == braft::crc32(data, len));
+      return (value == Crc32c(data, len));
     default:
       DINGO_LOG(ERROR) << "Unknown checksum_type=" << checksum_type;
       return false;
@@ -123,7 +217,7 @@ inline bool VerifyChecksum(int checksum_type, const butil::IOBuf& data, uint32_t
     case CheckSumType::kMurmurhash32:
       return (value == braft::murmurhash32(data));
     case CheckSumType::kCrc32:
-      return (value == braft::crc32(data));
+      return (value == Crc32c(data));
     default:
       DINGO_LOG(ERROR) << "Unknown checksum_type=" << checksum_type;
       return false;
@@ -135,7 +229,7 @@ inline uint32_t GetChecksum(int checksum_type, const char* data, size_t len) {
     case CheckSumType::kMurmurhash32:
       return braft::murmurhash32(data, len);
     case CheckSumType::kCrc32:
-      return braft::crc32(data, len);
+      return Crc32c(data, len);
     default:
       CHECK(false) << "Unknown checksum_type=" << checksum_type;
       abort();
@@ -148,7 +242,7 @@ inline uint32_t GetChecksum(int checksum_type, const butil::IOBuf& data) {
     case CheckSumType::kMurmurhash32:
       return braft::murmurhash32(data);
     case CheckSumType::kCrc32:
-      return braft::crc32(data);
+      return Crc32c(data);
     default:
       CHECK(false) << "Unknown checksum_type=" << checksum_type;
       abort();
@@ -156,6 +250,99 @@ inline uint32_t GetChecksum(int checksum_type, const butil::IOBuf& data) {
   }
 }
 
+static CompressionType GetCompressionType() {
+  const std::string& compression = FLAGS_raft_log_compression;
+  if (compression == "lz4") {
+    return CompressionType::kLz4;
+  } else if (compression == "zstd") {
+    return CompressionType::kZstd;
+  }
+  return CompressionType::kNone;
+}
+
+static std::string CompressionTypeName(int compress_type) {
+  switch (static_cast<CompressionType>(compress_type)) {
+    case CompressionType::kNone:
+      return "none";
+    case CompressionType::kLz4:
+      return "lz4";
+    case CompressionType::kZstd:
+      return "zstd";
+    default:
+      return "unknown";
+  }
+}
+
+// Compress data, return false if compress failed or the compressed data is not smaller,
+// then the data is stored uncompressed.
+static bool CompressData(CompressionType compress_type, const butil::IOBuf& data, butil::IOBuf& out) {
+  const std::string src = data.to_string();
+  std::string dst;
+  size_t compressed_size = 0;
+  switch (compress_type) {
+    case CompressionType::kLz4: {
+      dst.resize(sizeof(uint32_t) + LZ4_compressBound(src.size()));
+      const int size = LZ4_compress_default(src.data(), dst.data() + sizeof(uint32_t), src.size(),
+                                            dst.size() - sizeof(uint32_t));
+      if (size <= 0) {
+        return false;
+      }
+      compressed_size = size;
+    } break;
+    case CompressionType::kZstd: {
+      dst.resize(sizeof(uint32_t) + ZSTD_compressBound(src.size()));
+      const size_t size = ZSTD_compress(dst.data() + sizeof(uint32_t), dst.size() - sizeof(uint32_t), src.data(),
+                                        src.size(), FLAGS_raft_log_zstd_compression_level);
+      if (ZSTD_isError(size)) {
+        return false;
+      }
+      compressed_size = size;
+    } break;
+    default:
+      return false;
+  }
+
+  if (sizeof(uint32_t) + compressed_size >= src.size()) {
+    return false;
+  }
+
+  RawPacker(dst.data()).pack32(static_cast<uint32_t>(src.size()));
+  out.append(dst.data(), sizeof(uint32_t) + compressed_size);
+  return true;
+}
+
+static bool DecompressData(int compress_type, const butil::IOBuf& data, butil::IOBuf& out) {
+  if (data.length() < sizeof(uint32_t)) {
+    return false;
+  }
+  const std::string src = data.to_string();
+  uint32_t uncompressed_size = 0;
+  RawUnpacker(src.data()).unpack32(uncompressed_size);
+  const char* compressed_data = src.data() + sizeof(uint32_t);
+  const size_t compressed_size = src.size() - sizeof(uint32_t);
+
+  std::string dst(uncompressed_size, '\0');
+  switch (static_cast<CompressionType>(compress_type)) {
+    case CompressionType::kLz4: {
+      const int size = LZ4_decompress_safe(compressed_data, dst.data(), compressed_size, dst.size());
+      if (size < 0 || static_cast<uint32_t>(size) != uncompressed_size) {
+        return false;
+      }
+    } break;
+    case CompressionType::kZstd: {
+      const size_t size = ZSTD_decompress(dst.data(), dst.size(), compressed_data, compressed_size);
+      if (ZSTD_isError(size) || size != uncompressed_size) {
+        return false;
+      }
+    } break;
+    default:
+      return false;
+  }
+
+  out.append(dst);
+  return true;
+}
+
 int Segment::Create() {
   if (!is_open_) {
     CHECK(false) << fmt::format("[raft.log][region({}).index({}_{})] create on a closed segment, path: {}", region_id_,
@@ -198,6 +385,7 @@ int Segment::LoadEntry(off_t offset, EntryHeader* head, butil::IOBuf* data, size
   tmp.term = term;
   tmp.type = meta_field >> 24;
   tmp.checksum_type = (meta_field << 8) >> 24;
+  tmp.compress_type = (meta_field << 16) >> 24;
   tmp.data_len = data_len;
   tmp.data_checksum = data_checksum;
   if (!VerifyChecksum(tmp.checksum_type, p, kEntryHeaderSize - 4, header_checksum)) {
@@ -285,8 +473,24 @@ int Segment::Load(braft::ConfigurationManager* configuration_manager) {
     return -1;
   }
 
-  // load entry index
   int64_t file_size = st_buf.st_size;
+
+  // load entry index from index file, fallback to scan segment file if index file is missing or invalid
+  if (!is_open_ && FLAGS_raft_log_enable_segment_index) {
+    ret = LoadIndex(file_size, configuration_manager);
+    if (ret == 0) {
+      ::lseek(fd_, file_size, SEEK_SET);
+      bytes_ = file_size;
+      g_segment_log_load_by_index_count << 1;
+      return 0;
+    } else if (ret < 0) {
+      return ret;
+    }
+    ret = 0;
+  }
+
+  // load entry index
+  g_segment_log_load_by_scan_count << 1;
   int64_t entry_off = 0;
   int64_t actual_last_index = first_index_ - 1;
   for (int64_t i = first_index_; entry_off < file_size; i++) {
@@ -308,26 +512,15 @@ int Segment::Load(braft::ConfigurationManager* configuration_manager) {
       break;
     }
     if (header.type == braft::ENTRY_TYPE_CONFIGURATION) {
-      butil::IOBuf data;
-      // Header will be parsed again but it's fine as configuration
-      // changing is rare
-      if (LoadEntry(entry_off, nullptr, &data, skip_len) != 0) {
+      const int rc = LoadConfiguration(i, entry_off, skip_len, configuration_manager);
+      if (rc > 0) {
         break;
       }
-      scoped_refptr<braft::LogEntry> entry = new braft::LogEntry();
-      entry->id.index = i;
-      entry->id.term = header.term;
-      butil::Status status = parse_configuration_meta(data, entry);
-      if (status.ok()) {
-        braft::ConfigurationEntry conf_entry(*entry);
-        configuration_manager->add(conf_entry);
-      } else {
-        DINGO_LOG(ERROR) << fmt::format(
-            "[raft.log][region({}).index({}_{})] parse configuration meta failed, path: {} entry_off:{}", region_id_,
-            FirstIndex(), LastIndex(), path_, entry_off);
-        ret = -1;
+      if (rc < 0) {
+        ret = rc;
         break;
       }
+      configuration_indexes_.push_back(i);
     }
     offset_and_term_.push_back(std::make_pair(entry_off, header.term));
     ++actual_last_index;
@@ -370,9 +563,178 @@ int Segment::Load(braft::ConfigurationManager* configuration_manager) {
   ::lseek(fd_, entry_off, SEEK_SET);
 
   bytes_ = entry_off;
+
+  // the closed segment written by old version has no index file
+  if (ret == 0 && !is_open_ && FLAGS_raft_log_enable_segment_index) {
+    SaveIndex();
+  }
   return ret;
 }
 
+int Segment::LoadConfiguration(int64_t index, int64_t offset, int64_t size,
+                               braft::ConfigurationManager* configuration_manager) const {
+  EntryHeader header;
+  butil::IOBuf data;
+  // Header will be parsed again but it's fine as configuration
+  // changing is rare
+  if (LoadEntry(offset, &header, &data, size) != 0) {
+    return 1;
+  }
+  scoped_refptr<braft::LogEntry> entry = new braft::LogEntry();
+  entry->id.index = index;
+  entry->id.term = header.term;
+  butil::Status status = parse_configuration_meta(data, entry);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format(
+        "[raft.log][region({}).index({}_{})] parse configuration meta failed, path: {} entry_off:{}", region_id_,
+        FirstIndex(), LastIndex(), path_, offset);
+    return -1;
+  }
+
+  braft::ConfigurationEntry conf_entry(*entry);
+  configuration_manager->add(conf_entry);
+  return 0;
+}
+
+std::string Segment::IndexPath() const {
+  std::string path(path_);
+  butil::string_appendf(&path, "/" SEGMENT_INDEX_PATTERN, first_index_, last_index_.load());
+  return path;
+}
+
+int Segment::SaveIndex() {
+  std::string content;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+    content.resize(kSegmentIndexHeaderSize + offset_and_term_.size() * 16 + configuration_indexes_.size() * 8 + 4);
+    RawPacker packer(content.data());
+    packer.pack32(kSegmentIndexMagic)
+        .pack32(kSegmentIndexVersion)
+        .pack64(bytes_)
+        .pack64(offset_and_term_.size())
+        .pack64(configuration_indexes_.size());
+    for (const auto& offset_and_term : offset_and_term_) {
+      packer.pack64(offset_and_term.first).pack64(offset_and_term.second);
+    }
+    for (auto index : configuration_indexes_) {
+      packer.pack64(index);
+    }
+  }
+  RawPacker(content.data() + content.size() - 4).pack32(braft::murmurhash32(content.data(), content.size() - 4));
+
+  // index file is not synced, the broken index file is found by checksum and discarded when loading
+  std::string path = IndexPath();
+  std::string tmp_path = path + ".tmp";
+  if (butil::WriteFile(butil::FilePath(tmp_path), content.data(), content.size()) !=
+      static_cast<int>(content.size())) {
+    DINGO_LOG(WARNING) << fmt::format("[raft.log][region({}).index({}_{})] write index file failed, path: {} error: {}",
+                                      region_id_, FirstIndex(), LastIndex(), tmp_path, berror());
+    ::unlink(tmp_path.c_str());
+    return -1;
+  }
+  if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    DINGO_LOG(WARNING) << fmt::format(
+        "[raft.log][region({}).index({}_{})] rename index file failed, path: {} error: {}", region_id_,
+        FirstIndex(), LastIndex(), path, berror());
+    ::unlink(tmp_path.c_str());
+    return -1;
+  }
+
+  return 0;
+}
+
+// Return 0 if loaded, 1 if the index file is missing or invalid, -1 if loading configuration entry failed.
+int Segment::LoadIndex(int64_t file_size, braft::ConfigurationManager* configuration_manager) {
+  std::string path = IndexPath();
+  std::string content;
+  if (!butil::ReadFileToString(butil::FilePath(path), &content)) {
+    return 1;
+  }
+
+  if (content.size() < kSegmentIndexHeaderSize + 4) {
+    DINGO_LOG(WARNING) << fmt::format("[raft.log][region({}).index({}_{})] index file is too short, path: {}",
+                                      region_id_, FirstIndex(), LastIndex(), path);
+    return 1;
+  }
+  uint32_t checksum = 0;
+  RawUnpacker(content.data() + content.size() - 4).unpack32(checksum);
+  if (checksum != braft::murmurhash32(content.data(), content.size() - 4)) {
+    DINGO_LOG(WARNING) << fmt::format("[raft.log][region({}).index({}_{})] index file checksum mismatch, path: {}",
+                                      region_id_, FirstIndex(), LastIndex(), path);
+    return 1;
+  }
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint64_t index_file_size = 0;
+  uint64_t entry_count = 0;
+  uint64_t configuration_count = 0;
+  RawUnpacker unpacker(content.data());
+  unpacker.unpack32(magic).unpack32(version).unpack64(index_file_size).unpack64(entry_count).unpack64(
+      configuration_count);
+  const int64_t last_index = last_index_.load(butil::memory_order_relaxed);
+  if (magic != kSegmentIndexMagic || version != kSegmentIndexVersion ||
+      static_cast<int64_t>(index_file_size) != file_size ||
+      static_cast<int64_t>(entry_count) != last_index - first_index_ + 1 ||
+      content.size() != kSegmentIndexHeaderSize + entry_count * 16 + configuration_count * 8 + 4) {
+    DINGO_LOG(WARNING) << fmt::format(
+        "[raft.log][region({}).index({}_{})] index file not match segment, file_size: {}/{} entry_count: {} path: {}",
+        region_id_, FirstIndex(), LastIndex(), index_file_size, file_size, entry_count, path);
+    return 1;
+  }
+
+  std::vector<std::pair<int64_t, int64_t>> offset_and_term;
+  offset_and_term.reserve(entry_count);
+  for (uint64_t i = 0; i < entry_count; ++i) {
+    uint64_t offset = 0;
+    uint64_t term = 0;
+    unpacker.unpack64(offset).unpack64(term);
+    if (static_cast<int64_t>(offset) >= file_size ||
+        (!offset_and_term.empty() && static_cast<int64_t>(offset) <= offset_and_term.back().first)) {
+      DINGO_LOG(WARNING) << fmt::format("[raft.log][region({}).index({}_{})] index file has invalid offset, path: {}",
+                                        region_id_, FirstIndex(), LastIndex(), path);
+      return 1;
+    }
+    offset_and_term.push_back(std::make_pair(offset, term));
+  }
+
+  std::vector<int64_t> configuration_indexes;
+  configuration_indexes.reserve(configuration_count);
+  for (uint64_t i = 0; i < configuration_count; ++i) {
+    uint64_t index = 0;
+    unpacker.unpack64(index);
+    if (static_cast<int64_t>(index) < first_index_ || static_cast<int64_t>(index) > last_index) {
+      DINGO_LOG(WARNING) << fmt::format("[raft.log][region({}).index({}_{})] index file has invalid conf, path: {}",
+                                        region_id_, FirstIndex(), LastIndex(), path);
+      return 1;
+    }
+    configuration_indexes.push_back(index);
+  }
+
+  for (auto index : configuration_indexes) {
+    const int64_t offset = offset_and_term[index - first_index_].first;
+    const int64_t next_offset =
+        index == last_index ? file_size : offset_and_term[index - first_index_ + 1].first;
+    if (LoadConfiguration(index, offset, next_offset - offset, configuration_manager) != 0) {
+      return -1;
+    }
+  }
+
+  BAIDU_SCOPED_LOCK(mutex_);
+  offset_and_term_.swap(offset_and_term);
+  configuration_indexes_.swap(configuration_indexes);
+  return 0;
+}
+
+void Segment::UnlinkIndex() const {
+  std::string path = IndexPath();
+  if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+    DINGO_LOG(WARNING) << fmt::format(
+        "[raft.log][region({}).index({}_{})] unlink index file failed, path: {} error: {}", region_id_,
+        FirstIndex(), LastIndex(), path, berror());
+  }
+}
+
 int Segment::Append(const braft::LogEntry* entry) {
   if (BAIDU_UNLIKELY(!entry || !is_open_)) {
     return EINVAL;
@@ -383,10 +745,19 @@ int Segment::Append(const braft::LogEntry* entry) {
   }
 
   butil::IOBuf data;
+  CompressionType compress_type = CompressionType::kNone;
   switch (entry->type) {
-    case braft::ENTRY_TYPE_DATA:
-      data.append(entry->data);
-      break;
+    case braft::ENTRY_TYPE_DATA: {
+      compress_type = GetCompressionType();
+      if (compress_type == CompressionType::kNone ||
+          entry->data.length() < static_cast<size_t>(FLAGS_raft_log_compression_min_size) ||
+          !CompressData(compress_type, entry->data, data)) {
+        compress_type = CompressionType::kNone;
+        data.append(entry->data);
+      }
+      g_segment_log_append_data_bytes << entry->data.length();
+      g_segment_log_write_data_bytes << data.length();
+    } break;
     case braft::ENTRY_TYPE_NO_OP:
       break;
     case braft::ENTRY_TYPE_CONFIGURATION: {
@@ -405,7 +776,8 @@ int Segment::Append(const braft::LogEntry* entry) {
   }
   CHECK_LE(data.length(), 1ul << 56ul);
   char header_buf[kEntryHeaderSize];
-  const uint32_t meta_field = (entry->type << 24) | (checksum_type_ << 16);
+  const uint32_t meta_field =
+      (entry->type << 24) | (checksum_type_ << 16) | (static_cast<uint32_t>(compress_type) << 8);
   RawPacker packer(header_buf);
   packer.pack64(entry->id.term)
       .pack32(meta_field)
@@ -432,6 +804,9 @@ int Segment::Append(const braft::LogEntry* entry) {
   }
   BAIDU_SCOPED_LOCK(mutex_);
   offset_and_term_.push_back(std::make_pair(bytes_, entry->id.term));
+  if (entry->type == braft::ENTRY_TYPE_CONFIGURATION) {
+    configuration_indexes_.push_back(entry->id.index);
+  }
   last_index_.fetch_add(1, butil::memory_order_relaxed);
   bytes_ += to_write;
   unsynced_bytes_ += to_write;
@@ -475,7 +850,14 @@ braft::LogEntry* Segment::Get(int64_t index) const {
     entry->AddRef();
     switch (header.type) {
       case braft::ENTRY_TYPE_DATA:
-        entry->data.swap(data);
+        if (header.compress_type == static_cast<int>(CompressionType::kNone)) {
+          entry->data.swap(data);
+        } else if (!DecompressData(header.compress_type, data, entry->data)) {
+          DINGO_LOG(ERROR) << fmt::format(
+              "[raft.log][region({}).index({}_{})] decompress entry failed, index: {} header: {} path: {}", region_id_,
+              FirstIndex(), LastIndex(), index, ToString(header), path_);
+          ok = false;
+        }
         break;
       case braft::ENTRY_TYPE_NO_OP:
         CHECK(data.empty()) << fmt::format("[raft.log][region({}).index({}_{})] data of NO_OP must be empty",
@@ -545,6 +927,8 @@ int Segment::Close(bool will_sync) {
       DINGO_LOG(ERROR) << fmt::format(
           "[raft.log][region({}).index({}_{})] rename failed, old_path: {} new_path: {} error: {}", region_id_,
           FirstIndex(), LastIndex(), old_path, new_path, berror());
+    } else if (FLAGS_raft_log_enable_segment_index) {
+      SaveIndex();
     }
 
     return rc;
@@ -592,6 +976,10 @@ int Segment::Unlink() {
       break;
     }
 
+    if (!is_open_) {
+      UnlinkIndex();
+    }
+
     // start bthread to unlink
     // TODO unlink follow control
     std::string* file_path = new std::string(tmp_path);
@@ -624,6 +1012,9 @@ int Segment::Truncate(int64_t last_index_kept) {
   // Truncate on a full segment need to rename back to inprogess segment again,
   // because the node may crash before truncate.
   if (!is_open_) {
+    // the index file is stale after truncate
+    UnlinkIndex();
+
     std::string old_path(path_);
     butil::string_appendf(&old_path, "/" SEGMENT_CLOSED_PATTERN, first_index_, last_index_.load());
 
@@ -657,6 +1048,9 @@ int Segment::Truncate(int64_t last_index_kept) {
   lck.lock();
   // update memory var
   offset_and_term_.resize(first_truncate_in_offset);
+  configuration_indexes_.erase(
+      std::upper_bound(configuration_indexes_.begin(), configuration_indexes_.end(), last_index_kept),
+      configuration_indexes_.end());
   last_index_.store(last_index_kept, butil::memory_order_relaxed);
   bytes_ = truncate_size;
   return ret;
@@ -694,7 +1088,7 @@ int SegmentLogStorage::Init(braft::ConfigurationManager* configuration_manager)
     return -1;
   }
 
-  if (butil::crc32c::IsFastCrc32Supported()) {
+  if (IsFastCrc32cSupported()) {
     checksum_type_ = static_cast<int>(CheckSumType::kCrc32);
     DINGO_LOG(INFO) << fmt::format("[raft.log][region({})] use crc32c as the checksum type of appending entries",
                                    region_id_);
@@ -703,6 +1097,8 @@ int SegmentLogStorage::Init(braft::ConfigurationManager* configuration_manager)
     DINGO_LOG(INFO) << fmt::format("[raft.log][region({})] use murmurhash32 as the checksum type of appending entries",
                                    region_id_);
   }
+  DINGO_LOG(INFO) << fmt::format("[raft.log][region({})] use {} as the compression type of appending entries",
+                                 region_id_, CompressionTypeName(static_cast<int>(GetCompressionType())));
 
   int ret = 0;
   bool is_empty = false;
@@ -1134,6 +1530,7 @@ int SegmentLogStorage::ListSegments(bool is_empty) {
   }
 
   // restore segment meta
+  std::vector<std::pair<int64_t, int64_t>> index_files;
   while (dir_reader.Next()) {
     // unlink unneed segments and unfinished unlinked segments
     if ((is_empty && 0 == strncmp(dir_reader.name(), "log_", strlen("log_"))) ||
@@ -1152,6 +1549,12 @@ int SegmentLogStorage::ListSegments(bool is_empty) {
     int match = 0;
     int64_t first_index = 0;
     int64_t last_index = 0;
+    match = sscanf(dir_reader.name(), SEGMENT_INDEX_PATTERN, &first_index, &last_index);
+    if (match == 2) {
+      index_files.push_back(std::make_pair(first_index, last_index));
+      continue;
+    }
+
     match = sscanf(dir_reader.name(), SEGMENT_CLOSED_PATTERN, &first_index, &last_index);
     if (match == 2) {
       DINGO_LOG(INFO) << fmt::format("[raft.log][region({}).index({}_{})] restore closed segment, path: {}", region_id_,
@@ -1175,6 +1578,16 @@ int SegmentLogStorage::ListSegments(bool is_empty) {
     }
   }
 
+  // unlink index files whose segment is gone, e.g. crash when unlinking segment
+  for (const auto& index_file : index_files) {
+    auto it = segments_.find(index_file.first);
+    if (it == segments_.end() || it->second->LastIndex() != index_file.second) {
+      std::string index_path(path_);
+      butil::string_appendf(&index_path, "/" SEGMENT_INDEX_PATTERN, index_file.first, index_file.second);
+      ::unlink(index_path.c_str());
+    }
+  }
+
   // check segment
   int64_t last_log_index = -1;
   int64_t min_first_log_index = GetMinFirstLogIndex();
@@ -1224,6 +1637,8 @@ int SegmentLogStorage::ListSegments(bool is_empty) {
 
 int SegmentLogStorage::LoadSegments(braft::ConfigurationManager* configuration_manager) {
   int ret = 0;
+  butil::Timer timer;
+  timer.start();
 
   // closed segments
   SegmentMap::iterator it;
@@ -1262,6 +1677,9 @@ int SegmentLogStorage::LoadSegments(braft::ConfigurationManager* configuration_m
   if (last_log_index_ == 0) {
     last_log_index_ = first_log_index_ - 1;
   }
+
+  timer.stop();
+  g_segment_log_load_segments_latency << timer.u_elapsed();
   return 0;
 }
 
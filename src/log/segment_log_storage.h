@@ -120,9 +120,18 @@ class BAIDU_CACHELINE_ALIGNMENT Segment {
   };
 
   int LoadEntry(off_t offset, EntryHeader* head, butil::IOBuf* data, size_t size_hint) const;
+  int LoadConfiguration(int64_t index, int64_t offset, int64_t size,
+                        braft::ConfigurationManager* configuration_manager) const;
   int GetMeta(int64_t index, LogMeta* meta) const;
   int TruncateMetaAndGetLast(int64_t last);
 
+  // The entry index of closed segment is persisted to index file,
+  // so loading closed segment needn't scan all entries of the segment file.
+  std::string IndexPath() const;
+  int SaveIndex();
+  int LoadIndex(int64_t file_size, braft::ConfigurationManager* configuration_manager);
+  void UnlinkIndex() const;
+
   int64_t region_id_;
 
   std::string path_;
@@ -136,6 +145,8 @@ class BAIDU_CACHELINE_ALIGNMENT Segment {
   butil::atomic<int64_t> last_index_;
   int checksum_type_;
   std::vector<std::pair<int64_t /*offset*/, int64_t /*term*/>> offset_and_term_;
+  // index of configuration entries, for restoring configuration manager from index file
+  std::vector<int64_t> configuration_indexes_;
 };
 
 // LogStorage use segmented append-only file, all data in disk, all index in memory.
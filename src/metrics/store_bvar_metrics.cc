@@ -12,6 +12,11 @@
 
 #include "metrics/store_bvar_metrics.h"
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
 namespace dingodb {
 
 StoreBvarMetrics& StoreBvarMetrics::GetInstance() {
@@ -19,4 +24,28 @@ StoreBvarMetrics& StoreBvarMetrics::GetInstance() {
   return store_bvar_metrics;
 }
 
+double StoreBvarMetrics::GetBlockCacheHitRate(void* arg) {
+  auto* hit_rate = static_cast<BlockCacheHitRate*>(arg);
+  int64_t hit_count = hit_rate->hit_count->get_value();
+  int64_t total_count = hit_count + hit_rate->miss_count->get_value();
+  return total_count == 0 ? 0.0 : static_cast<double>(hit_count) / total_count;
+}
+
+void StoreBvarMetrics::ExposeBlockCacheHitRate(const std::string& cf_name) {
+  std::lock_guard<std::mutex> lock(block_cache_hit_rates_mutex_);
+  if (block_cache_hit_rates_.find(cf_name) != block_cache_hit_rates_.end()) {
+    return;
+  }
+
+  auto hit_rate = std::make_unique<BlockCacheHitRate>();
+  hit_rate->hit_count = GetBlockCacheHitCounter(cf_name);
+  hit_rate->miss_count = GetBlockCacheMissCounter(cf_name);
+  if (hit_rate->hit_count == nullptr || hit_rate->miss_count == nullptr) {
+    return;
+  }
+  hit_rate->hit_rate = std::make_unique<bvar::PassiveStatus<double>>(
+      "dingo_metrics_store_block_cache_hit_rate_" + cf_name, GetBlockCacheHitRate, hit_rate.get());
+  block_cache_hit_rates_[cf_name] = std::move(hit_rate);
+}
+
 }  // namespace dingodb
\ No newline at end of file
@@ -15,6 +15,9 @@
 #ifndef DINGODB_STORE_BVAR_METRICS_H_
 #define DINGODB_STORE_BVAR_METRICS_H_
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "bvar/bvar.h"
@@ -32,7 +35,9 @@ class StoreBvarMetrics {
       : leader_switch_time_("dingo_metrics_store_raft_leader_switch_time", {"region"}),
         leader_switch_count_("dingo_metrics_store_raft_leader_switch_count", {"region"}),
         commit_count_per_second_("dingo_metrics_store_raft_commit_count_per_second", {"region"}),
-        apply_count_per_second_("dingo_metrics_store_raft_apply_count_per_second", {"region"}) {}
+        apply_count_per_second_("dingo_metrics_store_raft_apply_count_per_second", {"region"}),
+        block_cache_hit_count_("dingo_metrics_store_block_cache_hit_count", {"cf"}),
+        block_cache_miss_count_("dingo_metrics_store_block_cache_miss_count", {"cf"}) {}
   ~StoreBvarMetrics() = default;
 
   StoreBvarMetrics(const StoreBvarMetrics&) = delete;
@@ -83,11 +88,36 @@ class StoreBvarMetrics {
     }
   }
 
+  // The counters are kept by the block cache of column family, so lookup does not search the multi dimension.
+  bvar::Adder<int64_t>* GetBlockCacheHitCounter(const std::string& cf_name) {
+    return block_cache_hit_count_.get_stats({cf_name});
+  }
+
+  bvar::Adder<int64_t>* GetBlockCacheMissCounter(const std::string& cf_name) {
+    return block_cache_miss_count_.get_stats({cf_name});
+  }
+
+  // Expose dingo_metrics_store_block_cache_hit_rate_{cf_name}, computed from hit and miss count when it is read.
+  void ExposeBlockCacheHitRate(const std::string& cf_name);
+
  private:
+  struct BlockCacheHitRate {
+    bvar::Adder<int64_t>* hit_count;
+    bvar::Adder<int64_t>* miss_count;
+    std::unique_ptr<bvar::PassiveStatus<double>> hit_rate;
+  };
+
+  static double GetBlockCacheHitRate(void* arg);
+
   bvar::MultiDimension<bvar::Status<int64_t>> leader_switch_time_;
   bvar::MultiDimension<bvar::Status<int64_t>> leader_switch_count_;
   bvar::MultiDimension<bvar::PerSecondEx<bvar::Adder<int64_t>>> commit_count_per_second_;
   bvar::MultiDimension<bvar::PerSecondEx<bvar::Adder<int64_t>>> apply_count_per_second_;
+
+  bvar::MultiDimension<bvar::Adder<int64_t>> block_cache_hit_count_;
+  bvar::MultiDimension<bvar::Adder<int64_t>> block_cache_miss_count_;
+  std::mutex block_cache_hit_rates_mutex_;
+  std::map<std::string, std::unique_ptr<BlockCacheHitRate>> block_cache_hit_rates_;
 };
 
 }  // namespace dingodb
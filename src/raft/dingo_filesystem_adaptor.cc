@@ -14,6 +14,7 @@
 
 #include "raft/dingo_filesystem_adaptor.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -36,6 +37,8 @@
 namespace dingodb {
 
 DEFINE_int64(snapshot_timeout_min, 10, "snapshot_timeout_min : 10min");
+DEFINE_int32(raft_snapshot_sst_write_pending_num, 16,
+             "max pending data of snapshot install not written to sst file, write blocks when exceed");
 DECLARE_string(raft_snapshot_policy);
 
 bool inline IsSnapshotMetaFile(const std::string& path) {
@@ -358,11 +361,50 @@ int SstWriterAdaptor::Open() {
                      << ", region_id: " << region_id_;
     return -1;
   }
+
+  bthread::ExecutionQueueOptions options;
+  options.bthread_attr = BTHREAD_ATTR_NORMAL;
+  if (bthread::execution_queue_start(&write_queue_id_, &options, WriteRoutine, this) != 0) {
+    DINGO_LOG(ERROR) << "start sst write queue failed, path: " << path << ", region_id: " << region_id_;
+    return -1;
+  }
+  write_queue_started_ = true;
+
   closed_ = false;
   DINGO_LOG(WARNING) << "sst writer open, path: " << path << ", region_id: " << region_id_;
   return 0;
 }
 
+int SstWriterAdaptor::WriteRoutine(void* meta, bthread::TaskIterator<butil::IOBuf>& iter) {
+  auto* adaptor = static_cast<SstWriterAdaptor*>(meta);
+  for (; iter; ++iter) {
+    // skip the remaining data after fail, the file is abandoned
+    if (!adaptor->write_failed_.load(std::memory_order_relaxed) && adaptor->IobufToSst(*iter) < 0) {
+      DINGO_LOG(ERROR) << "write sst file path: " << adaptor->path_ << " failed, received invalid data, data len: "
+                       << iter->size() << ", region_id: " << adaptor->region_id_;
+      adaptor->write_failed_.store(true, std::memory_order_relaxed);
+    }
+    adaptor->pending_cond_.DecreaseSignal();
+  }
+
+  return 0;
+}
+
+void SstWriterAdaptor::StopWriteQueue() {
+  if (!write_queue_started_) {
+    return;
+  }
+  write_queue_started_ = false;
+
+  if (bthread::execution_queue_stop(write_queue_id_) != 0) {
+    DINGO_LOG(ERROR) << "stop sst write queue failed, path: " << path_ << ", region_id: " << region_id_;
+    return;
+  }
+  if (bthread::execution_queue_join(write_queue_id_) != 0) {
+    DINGO_LOG(ERROR) << "join sst write queue failed, path: " << path_ << ", region_id: " << region_id_;
+  }
+}
+
 ssize_t SstWriterAdaptor::write(const butil::IOBuf& data, off_t offset) {
   (void)offset;
   std::string path = path_;
@@ -379,17 +421,25 @@ ssize_t SstWriterAdaptor::write(const butil::IOBuf& data, off_t offset) {
   if (data.empty()) {
     DINGO_LOG(WARNING) << "write sst file path: " << path << " failed, data len = 0, region_id: " << region_id_;
   }
-  auto ret = IobufToSst(data);
-  if (ret < 0) {
-    DINGO_LOG(ERROR) << "write sst file path: " << path << " failed, received invalid data, data len: " << data.size()
-                     << ", region_id: " << region_id_;
+  if (write_failed_.load(std::memory_order_relaxed)) {
+    DINGO_LOG(ERROR) << "write sst file path: " << path << " failed, previous data is invalid, data len: "
+                     << data.size() << ", region_id: " << region_id_;
+    return -1;
+  }
+
+  // limit the memory of data not written yet
+  pending_cond_.IncreaseWait(std::max(FLAGS_raft_snapshot_sst_write_pending_num, 1));
+  if (bthread::execution_queue_execute(write_queue_id_, data) != 0) {
+    pending_cond_.DecreaseSignal();
+    DINGO_LOG(ERROR) << "write sst file path: " << path << " failed, execute sst write queue failed, data len: "
+                     << data.size() << ", region_id: " << region_id_;
     return -1;
   }
   data_size_ += data.size();
 
   DINGO_LOG(WARNING) << "sst write, region_id: " << region_id_ << ", path: " << path << ", offset: " << offset
-                     << ", data.size: " << data.size() << ", file_size: " << writer_->FileSize()
-                     << ", total_count: " << count_ << ", all_size: " << data_size_;
+                     << ", data.size: " << data.size() << ", pending_count: " << pending_cond_.Count()
+                     << ", all_size: " << data_size_;
 
   return data.size();
 }
@@ -405,6 +455,13 @@ bool SstWriterAdaptor::close() {
 
 bool SstWriterAdaptor::FinishSst() {
   std::string path = path_;
+  // wait the pending data written
+  StopWriteQueue();
+  if (write_failed_.load(std::memory_order_relaxed)) {
+    DINGO_LOG(ERROR) << "finish sst file path: " << path << " failed, write data failed, region_id: " << region_id_;
+    return false;
+  }
+
   if (count_ > 0) {
     DINGO_LOG(WARNING) << "writer_ finished, path: " << path << ", region_id: " << region_id_
                        << ", file_size: " << writer_->FileSize() << ", total_count: " << count_
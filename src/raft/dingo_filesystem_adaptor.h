@@ -19,13 +19,16 @@
 #include <braft/raft.h>
 #include <braft/util.h>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "common/constant.h"
+#include "bthread/execution_queue.h"
 #include "common/context.h"
+#include "common/synchronization.h"
 #include "config/config.h"
 #include "engine/raw_engine.h"
 #include "meta/store_meta_manager.h"
@@ -209,6 +212,8 @@ class DingoMetaReaderAdaptor : public braft::FileAdaptor {
 
 // SstWriterAdaptor is used to write sst file on follower when doing snapshot install to follower
 // the data to write is from raft snapshot executor's remote file copier
+// the received data is written to sst file by a background execution queue, so building sst file is overlapped with
+// fetching the next data from leader, close() waits the pending data.
 class SstWriterAdaptor : public braft::FileAdaptor {
   friend class DingoFileSystemAdaptor;
 
@@ -234,6 +239,9 @@ class SstWriterAdaptor : public braft::FileAdaptor {
  private:
   bool FinishSst();
   int IobufToSst(butil::IOBuf data);
+  static int WriteRoutine(void* meta, bthread::TaskIterator<butil::IOBuf>& iter);
+  void StopWriteQueue();
+
   int64_t region_id_;
   store::RegionPtr region_ptr_;
   std::string path_;
@@ -241,6 +249,12 @@ class SstWriterAdaptor : public braft::FileAdaptor {
   size_t data_size_ = 0;
   bool closed_ = true;
   std::unique_ptr<SstFileWriter> writer_;
+
+  bthread::ExecutionQueueId<butil::IOBuf> write_queue_id_ = {0};
+  bool write_queue_started_ = false;
+  // count of data not written to sst file yet
+  BthreadCond pending_cond_;
+  std::atomic<bool> write_failed_{false};
 };
 
 // PosixFileAdaptor is used to write meta file on leader when doing snapshot install to follower
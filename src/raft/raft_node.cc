@@ -20,6 +20,7 @@
 #include <string>
 #include <utility>
 
+#include "braft/snapshot_throttle.h"
 #include "bthread/bthread.h"
 #include "butil/memory/ref_counted.h"
 #include "butil/status.h"
@@ -38,9 +39,24 @@
 #include "server/server.h"
 
 DEFINE_int32(node_destroy_wait_time_ms, 3000, "wait time on node destroy");
+DEFINE_int64(raft_snapshot_throttle_throughput_bytes, 128 * 1024 * 1024,
+             "throughput of snapshot install shared by all raft node of store, 0 means no limit");
+DEFINE_int64(raft_snapshot_throttle_check_cycle, 10, "check cycle of snapshot throttle in one second");
 
 namespace dingodb {
 
+// Snapshot throttle shared by all raft node, limit the disk read and write of snapshot install,
+// so that snapshot transfer does not starve foreground io.
+static scoped_refptr<braft::SnapshotThrottle>* GetSnapshotThrottle() {
+  if (FLAGS_raft_snapshot_throttle_throughput_bytes <= 0) {
+    return nullptr;
+  }
+
+  static scoped_refptr<braft::SnapshotThrottle> snapshot_throttle(new braft::ThroughputSnapshotThrottle(
+      FLAGS_raft_snapshot_throttle_throughput_bytes, FLAGS_raft_snapshot_throttle_check_cycle));
+  return &snapshot_throttle;
+}
+
 RaftNode::RaftNode(int64_t node_id, const std::string& raft_group_name, braft::PeerId peer_id,
                    std::shared_ptr<BaseStateMachine> fsm, std::shared_ptr<SegmentLogStorage> log_storage)
     : node_id_(node_id),
@@ -85,6 +101,7 @@ int RaftNode::Init(store::RegionPtr region, const std::string& init_conf, const
   if (region != nullptr) {
     region->snapshot_adaptor = new DingoFileSystemAdaptor(region->Id());
     node_options.snapshot_file_system_adaptor = &region->snapshot_adaptor;
+    node_options.snapshot_throttle = GetSnapshotThrottle();
   }
 
   if (node_->init(node_options) != 0) {
@@ -127,6 +144,11 @@ butil::Status RaftNode::Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb:
   if (!IsLeader()) {
     return butil::Status(pb::error::ERAFT_NOTLEADER, GetLeaderId().to_string());
   }
+
+  if (ctx != nullptr && ctx->Tracker() != nullptr) {
+    ctx->Tracker()->SetRaftProposeTime();
+  }
+
   butil::IOBuf data;
   butil::IOBufAsZeroCopyOutputStream wrapper(&data);
   raft_cmd->SerializeToZeroCopyStream(&wrapper);
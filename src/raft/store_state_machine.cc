@@ -76,6 +76,9 @@ int StoreStateMachine::DispatchEvent(dingodb::EventType event_type, std::shared_
 }
 
 void StoreStateMachine::on_apply(braft::Iterator& iter) {
+  // log entries are committed when reach state machine, for request tracker
+  int64_t commit_time_ns = Helper::TimestampNs();
+
   BAIDU_SCOPED_LOCK(apply_mutex_);
 
   for (; iter.valid(); iter.next()) {
@@ -150,6 +153,7 @@ void StoreStateMachine::on_apply(braft::Iterator& iter) {
       event->region_metrics = region_metrics_;
       event->term_id = iter.term();
       event->log_id = iter.index();
+      event->commit_time_ns = commit_time_ns;
 
       DispatchEvent(EventType::kSmApply, event);
     }
@@ -0,0 +1,170 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sdk/auto_increment_manager.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "glog/logging.h"
+#include "proto/meta.pb.h"
+#include "sdk/param_config.h"
+
+namespace dingodb {
+namespace sdk {
+
+AutoIncrementer::AutoIncrementer(std::shared_ptr<CoordinatorProxy> coordinator_proxy, int64_t table_id)
+    : coordinator_proxy_(std::move(coordinator_proxy)), table_id_(table_id), next_id_(0), refilling_(false) {}
+
+AutoIncrementer::~AutoIncrementer() {
+  if (refill_thread_.joinable()) {
+    refill_thread_.join();
+  }
+}
+
+Status AutoIncrementer::GetNextIds(int64_t count, std::vector<int64_t>& ids) {
+  if (count <= 0) {
+    return Status::InvalidArgument("count must greater than 0, check params");
+  }
+
+  std::vector<int64_t> tmp_ids;
+  tmp_ids.reserve(count);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (static_cast<int64_t>(tmp_ids.size()) < count) {
+    if (id_ranges_.empty()) {
+      StartRefillUnlocked(std::max(kAutoIncrementCacheCount, count - static_cast<int64_t>(tmp_ids.size())));
+      cond_.wait(lock, [&]() { return !refilling_; });
+      if (id_ranges_.empty()) {
+        DINGO_LOG(WARNING) << fmt::format("table:{} fetch auto increment fail, status:{}", table_id_,
+                                          refill_status_.ToString());
+        return refill_status_.IsOK() ? Status::Incomplete("fetch auto increment return no id") : refill_status_;
+      }
+      continue;
+    }
+
+    auto& range = id_ranges_.front();
+    int64_t take_count = std::min(count - static_cast<int64_t>(tmp_ids.size()), range.second - range.first);
+    for (int64_t i = 0; i < take_count; ++i) {
+      tmp_ids.push_back(range.first + i);
+    }
+    range.first += take_count;
+    next_id_ = range.first;
+    if (range.first >= range.second) {
+      id_ranges_.pop_front();
+    }
+  }
+
+  if (CachedCountUnlocked() < kAutoIncrementLowWaterMark) {
+    StartRefillUnlocked(kAutoIncrementCacheCount);
+  }
+
+  ids = std::move(tmp_ids);
+  return Status::OK();
+}
+
+int64_t AutoIncrementer::CachedCountUnlocked() const {
+  int64_t cached_count = 0;
+  for (const auto& range : id_ranges_) {
+    cached_count += range.second - range.first;
+  }
+  return cached_count;
+}
+
+void AutoIncrementer::StartRefillUnlocked(int64_t count) {
+  if (refilling_) {
+    return;
+  }
+
+  // the last refill thread is finished, it does not touch mutex_ after refilling_ is reset
+  if (refill_thread_.joinable()) {
+    refill_thread_.join();
+  }
+
+  refilling_ = true;
+  refill_status_ = Status::OK();
+  refill_thread_ = std::thread(&AutoIncrementer::RefillRun, this, std::min(count, kAutoIncrementMaxFetchCount));
+}
+
+void AutoIncrementer::RefillRun(int64_t count) {
+  int64_t start_id = 0;
+  int64_t end_id = 0;
+  Status ret = FetchIdRange(count, start_id, end_id);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (ret.IsOK()) {
+      // ranges from coordinator are increasing, the check only protects monotonicity of returned ids
+      int64_t tail_id = id_ranges_.empty() ? next_id_ : id_ranges_.back().second;
+      start_id = std::max(start_id, tail_id);
+      if (start_id < end_id) {
+        id_ranges_.emplace_back(start_id, end_id);
+      } else {
+        DINGO_LOG(WARNING) << fmt::format("table:{} drop stale auto increment range [{},{}), tail_id:{}", table_id_,
+                                          start_id, end_id, tail_id);
+      }
+    }
+
+    refill_status_ = ret;
+    refilling_ = false;
+  }
+  cond_.notify_all();
+}
+
+Status AutoIncrementer::FetchIdRange(int64_t count, int64_t& start_id, int64_t& end_id) {
+  pb::meta::GenerateAutoIncrementRequest request;
+  pb::meta::GenerateAutoIncrementResponse response;
+  auto* table_id = request.mutable_table_id();
+  table_id->set_entity_type(pb::meta::EntityType::ENTITY_TYPE_TABLE);
+  table_id->set_entity_id(table_id_);
+  request.set_count(count);
+  request.set_auto_increment_increment(1);
+  request.set_auto_increment_offset(1);
+
+  Status ret = coordinator_proxy_->GenerateAutoIncrement(request, response);
+  if (!ret.IsOK()) {
+    DINGO_LOG(WARNING) << fmt::format("table:{} generate auto increment fail, status:{}", table_id_, ret.ToString());
+    return ret;
+  }
+
+  start_id = response.start_id();
+  end_id = response.end_id();
+  return Status::OK();
+}
+
+AutoIncrementerManager::AutoIncrementerManager(std::shared_ptr<CoordinatorProxy> coordinator_proxy)
+    : coordinator_proxy_(std::move(coordinator_proxy)) {}
+
+std::shared_ptr<AutoIncrementer> AutoIncrementerManager::GetOrCreate(int64_t table_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = auto_incrementers_.find(table_id);
+  if (iter != auto_incrementers_.end()) {
+    return iter->second;
+  }
+
+  auto auto_incrementer = std::make_shared<AutoIncrementer>(coordinator_proxy_, table_id);
+  auto_incrementers_.emplace(table_id, auto_incrementer);
+  return auto_incrementer;
+}
+
+void AutoIncrementerManager::Remove(int64_t table_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto_incrementers_.erase(table_id);
+}
+
+}  // namespace sdk
+}  // namespace dingodb
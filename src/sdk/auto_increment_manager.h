@@ -0,0 +1,95 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_SDK_AUTO_INCREMENT_MANAGER_H_
+#define DINGODB_SDK_AUTO_INCREMENT_MANAGER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sdk/coordinator_proxy.h"
+#include "sdk/status.h"
+
+namespace dingodb {
+namespace sdk {
+
+// Local cache of auto increment ids of one table.
+// Ids are fetched from coordinator in ranges, and refilled in background when cached ids are below low water mark,
+// so most of GetNextIds is served from memory. Ids returned are strictly increasing.
+class AutoIncrementer {
+ public:
+  AutoIncrementer(const AutoIncrementer&) = delete;
+  const AutoIncrementer& operator=(const AutoIncrementer&) = delete;
+
+  AutoIncrementer(std::shared_ptr<CoordinatorProxy> coordinator_proxy, int64_t table_id);
+
+  ~AutoIncrementer();
+
+  Status GetNextIds(int64_t count, std::vector<int64_t>& ids);
+
+ private:
+  int64_t CachedCountUnlocked() const;
+
+  // start background refill if there is no refill in flight, must hold mutex_
+  void StartRefillUnlocked(int64_t count);
+
+  void RefillRun(int64_t count);
+
+  Status FetchIdRange(int64_t count, int64_t& start_id, int64_t& end_id);
+
+  std::shared_ptr<CoordinatorProxy> coordinator_proxy_;
+  const int64_t table_id_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // cached ids in [start, end), in increasing order
+  std::deque<std::pair<int64_t, int64_t>> id_ranges_;
+  // ids less than this are returned or dropped
+  int64_t next_id_;
+  bool refilling_;
+  Status refill_status_;
+  std::thread refill_thread_;
+};
+
+class AutoIncrementerManager {
+ public:
+  AutoIncrementerManager(const AutoIncrementerManager&) = delete;
+  const AutoIncrementerManager& operator=(const AutoIncrementerManager&) = delete;
+
+  explicit AutoIncrementerManager(std::shared_ptr<CoordinatorProxy> coordinator_proxy);
+
+  ~AutoIncrementerManager() = default;
+
+  std::shared_ptr<AutoIncrementer> GetOrCreate(int64_t table_id);
+
+  // drop the cached ids, e.g. the table is dropped or auto increment is updated
+  void Remove(int64_t table_id);
+
+ private:
+  std::shared_ptr<CoordinatorProxy> coordinator_proxy_;
+
+  std::mutex mutex_;
+  std::map<int64_t, std::shared_ptr<AutoIncrementer>> auto_incrementers_;
+};
+
+}  // namespace sdk
+}  // namespace dingodb
+#endif  // DINGODB_SDK_AUTO_INCREMENT_MANAGER_H_
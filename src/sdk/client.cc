@@ -142,6 +142,10 @@ Status Client::IsCreateRegionInProgress(int64_t region_id, bool& out_create_in_p
 
 Status Client::DropRegion(int64_t region_id) { return data_->stub->GetAdminTool()->DropRegion(region_id); }
 
+Status Client::GetAutoIncrementIds(int64_t table_id, int64_t count, std::vector<int64_t>& ids) {
+  return data_->stub->GetAutoIncrementerManager()->GetOrCreate(table_id)->GetNextIds(count, ids);
+}
+
 RawKV::RawKV(RawKVImpl* impl) : impl_(impl) {}
 
 RawKV::~RawKV() { impl_.reset(nullptr); }
@@ -191,6 +195,11 @@ Status RawKV::Scan(const std::string& start_key, const std::string& end_key, uin
   return impl_->Scan(start_key, end_key, limit, kvs);
 }
 
+Status RawKV::NewScanner(const std::string& start_key, const std::string& end_key, const ScanOptions& options,
+                         std::unique_ptr<RangeScanner>& scanner) {
+  return impl_->NewScanner(start_key, end_key, options, scanner);
+}
+
 Transaction::Transaction(TxnImpl* impl) : impl_(impl) {}
 
 Transaction::~Transaction() { impl_.reset(nullptr); }
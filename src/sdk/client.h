@@ -62,6 +62,10 @@ class Client : public std::enable_shared_from_this<Client> {
 
   Status DropRegion(int64_t region_id);
 
+  // Get count auto increment ids of table, ids are increasing in one client.
+  // Ids are cached in client and fetched from coordinator in batch, so ids may be not continuous.
+  Status GetAutoIncrementIds(int64_t table_id, int64_t count, std::vector<int64_t>& ids);
+
  private:
   friend class RawKV;
   friend class TestBase;
@@ -85,6 +89,37 @@ struct KeyOpState {
   bool state;
 };
 
+struct ScanOptions {
+  // max count of regions scanned concurrently
+  int64_t concurrency{4};
+  // max count of batches prefetched for each region while the caller consumes the current one
+  int64_t prefetch_batch_count{2};
+  // true: kvs are returned in key order
+  // false: kvs are returned as soon as any region fetched them, use for export
+  bool ordered{true};
+};
+
+/// @brief Streaming scanner over a key range which may span many regions,
+/// region scans run in background and their batches are prefetched.
+class RangeScanner {
+ public:
+  RangeScanner(const RangeScanner&) = delete;
+  const RangeScanner& operator=(const RangeScanner&) = delete;
+
+  RangeScanner() = default;
+
+  virtual ~RangeScanner() = default;
+
+  virtual Status Open() = 0;
+
+  virtual void Close() = 0;
+
+  // kvs is empty and HasMore is false when the scan is finished
+  virtual Status NextBatch(std::vector<KVPair>& kvs) = 0;
+
+  virtual bool HasMore() const = 0;
+};
+
 class RawKV : public std::enable_shared_from_this<RawKV> {
  public:
   RawKV(const RawKV&) = delete;
@@ -127,6 +162,10 @@ class RawKV : public std::enable_shared_from_this<RawKV> {
   // limit: 0 means no limit, will scan all key in [start_key, end_key)
   Status Scan(const std::string& start_key, const std::string& end_key, uint64_t limit, std::vector<KVPair>& kvs);
 
+  // scan key in [start_key, end_key) with concurrent region scans, the scanner is opened on success
+  Status NewScanner(const std::string& start_key, const std::string& end_key, const ScanOptions& options,
+                    std::unique_ptr<RangeScanner>& scanner);
+
  private:
   friend class Client;
 
@@ -145,6 +184,10 @@ struct TransactionOptions {
   TransactionKind kind;
   TransactionIsolation isolation;
   uint32_t keep_alive_ms;
+  // commit the transaction which involves only one region in the prewrite, no commit rpc is needed
+  bool try_one_pc{false};
+  // the small transaction is committed once all keys are prewritten, the locks are committed in background
+  bool use_async_commit{false};
 };
 
 class Transaction : public std::enable_shared_from_this<Transaction> {
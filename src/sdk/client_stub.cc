@@ -50,6 +50,8 @@ Status ClientStub::Open(std::string naming_service_url) {
 
   txn_lock_resolver_.reset(new TxnLockResolver(*(this)));
 
+  auto_increment_manager_.reset(new AutoIncrementerManager(coordinator_proxy_));
+
   return Status::OK();
 }
 
@@ -20,6 +20,7 @@
 
 #include "glog/logging.h"
 #include "sdk/admin_tool.h"
+#include "sdk/auto_increment_manager.h"
 #include "sdk/coordinator_proxy.h"
 #include "sdk/meta_cache.h"
 #include "sdk/region_scanner.h"
@@ -67,6 +68,11 @@ class ClientStub {
     return txn_lock_resolver_;
   }
 
+  virtual std::shared_ptr<AutoIncrementerManager> GetAutoIncrementerManager() const {
+    DCHECK_NOTNULL(auto_increment_manager_.get());
+    return auto_increment_manager_;
+  }
+
  private:
   std::shared_ptr<CoordinatorProxy> coordinator_proxy_;
   std::shared_ptr<MetaCache> meta_cache_;
@@ -74,6 +80,7 @@ class ClientStub {
   std::shared_ptr<RegionScannerFactory> region_scanner_factory_;
   std::shared_ptr<AdminTool> admin_tool_;
   std::shared_ptr<TxnLockResolver> txn_lock_resolver_;
+  std::shared_ptr<AutoIncrementerManager> auto_increment_manager_;
 };
 
 }  // namespace sdk
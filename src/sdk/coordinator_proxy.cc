@@ -128,6 +128,17 @@ Status CoordinatorProxy::TsoService(const pb::meta::TsoRequest& request, pb::met
   return Status::OK();
 }
 
+Status CoordinatorProxy::GenerateAutoIncrement(const pb::meta::GenerateAutoIncrementRequest& request,
+                                               pb::meta::GenerateAutoIncrementResponse& response) {
+  butil::Status rpc_status = coordinator_interaction_meta_->SendRequest("GenerateAutoIncrement", request, response);
+  if (!rpc_status.ok()) {
+    std::string msg = fmt::format("Fail generate auto increment {}", rpc_status.error_cstr());
+    DINGO_LOG(INFO) << msg << ", request:" << request.DebugString() << ", response:" << response.DebugString();
+    return Status::RemoteError(rpc_status.error_code(), msg);
+  }
+  return Status::OK();
+}
+
 }  // namespace sdk
 
 }  // namespace dingodb
\ No newline at end of file
@@ -53,6 +53,9 @@ class CoordinatorProxy {
   // Meta Service
   virtual Status TsoService(const pb::meta::TsoRequest& request, pb::meta::TsoResponse& response);
 
+  virtual Status GenerateAutoIncrement(const pb::meta::GenerateAutoIncrementRequest& request,
+                                       pb::meta::GenerateAutoIncrementResponse& response);
+
  private:
   std::shared_ptr<dingodb::CoordinatorInteraction> coordinator_interaction_;
   std::shared_ptr<dingodb::CoordinatorInteraction> coordinator_interaction_meta_;
@@ -38,8 +38,22 @@ const int64_t kMaxScanBatchSize = 100;
 
 const int64_t kPrefetchRegionCount = 3;
 
+// start: use for auto increment id cache
+// count of ids fetched from coordinator in one request
+const int64_t kAutoIncrementCacheCount = 1000;
+
+// max count of ids fetched in one request, it is limited by coordinator
+const int64_t kAutoIncrementMaxFetchCount = 100000;
+
+// refill the cache in background when cached ids are less than this
+const int64_t kAutoIncrementLowWaterMark = 300;
+// end: use for auto increment id cache
+
 const int64_t kCoordinatorInteractionMaxRetry = 3;
 
 const int64_t kTxnOpMaxRetry = 2;
 
+// max key count of transaction committed by async commit, the primary lock records all the keys
+const int64_t kTxnAsyncCommitMaxKeys = 256;
+
 #endif  // DINGODB_SDK_PARAM_CONFIG_H_
\ No newline at end of file
@@ -0,0 +1,263 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sdk/range_scanner.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "glog/logging.h"
+#include "sdk/meta_cache.h"
+
+namespace dingodb {
+namespace sdk {
+
+ParallelRangeScanner::ParallelRangeScanner(const ClientStub& stub, std::string start_key, std::string end_key,
+                                           const ScanOptions& options)
+    : stub_(stub),
+      start_key_(std::move(start_key)),
+      end_key_(std::move(end_key)),
+      options_(options),
+      no_more_region_(false),
+      opened_(false),
+      stopped_(false),
+      has_more_(false) {}
+
+ParallelRangeScanner::~ParallelRangeScanner() { Close(); }
+
+Status ParallelRangeScanner::Open() {
+  CHECK(!opened_);
+  if (start_key_.empty() || end_key_.empty()) {
+    return Status::InvalidArgument("start_key and end_key must not empty, check params");
+  }
+
+  if (start_key_ >= end_key_) {
+    return Status::InvalidArgument("end_key must greater than start_key, check params");
+  }
+
+  if (options_.concurrency <= 0 || options_.prefetch_batch_count <= 0) {
+    return Status::InvalidArgument("concurrency and prefetch_batch_count must greater than 0, check params");
+  }
+
+  {
+    // precheck: return not found if no region in [start, end_key)
+    std::shared_ptr<Region> region;
+    Status ret = stub_.GetMetaCache()->LookupRegionBetweenRange(start_key_, end_key_, region);
+    if (!ret.IsOK()) {
+      DINGO_LOG(WARNING) << fmt::format("lookup region fail between [{},{}), status:{}", start_key_, end_key_,
+                                        ret.ToString());
+      return ret;
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  next_start_ = start_key_;
+  opened_ = true;
+  has_more_ = true;
+  Status ret = FillStreamsUnlocked();
+  if (!ret.IsOK()) {
+    status_ = ret;
+    lock.unlock();
+    Close();
+  }
+
+  return ret;
+}
+
+void ParallelRangeScanner::Close() {
+  std::list<std::unique_ptr<RegionStream>> streams;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!opened_) {
+      return;
+    }
+    stopped_ = true;
+    has_more_ = false;
+    opened_ = false;
+    streams.swap(streams_);
+  }
+  cond_.notify_all();
+
+  for (auto& stream : streams) {
+    if (stream->thread.joinable()) {
+      stream->thread.join();
+    }
+  }
+}
+
+bool ParallelRangeScanner::HasMore() const { return has_more_; }
+
+Status ParallelRangeScanner::FillStreamsUnlocked() {
+  auto meta_cache = stub_.GetMetaCache();
+
+  while (!no_more_region_ && static_cast<int64_t>(streams_.size()) < options_.concurrency) {
+    std::shared_ptr<Region> region;
+    Status ret = meta_cache->LookupRegionBetweenRange(next_start_, end_key_, region);
+    if (ret.IsNotFound()) {
+      DINGO_LOG(INFO) << fmt::format("region not found between [{},{}), start_key:{} status:{}", next_start_, end_key_,
+                                     start_key_, ret.ToString());
+      no_more_region_ = true;
+      break;
+    }
+
+    if (!ret.IsOK()) {
+      DINGO_LOG(WARNING) << fmt::format("region look fail between [{},{}), start_key:{} status:{}", next_start_,
+                                        end_key_, start_key_, ret.ToString());
+      return ret;
+    }
+
+    // only scan the part of region in [start_key_, end_key_)
+    auto scan_start_key = std::max(start_key_, region->Range().start_key());
+    auto scan_end_key = std::min(end_key_, region->Range().end_key());
+
+    auto stream = std::make_unique<RegionStream>();
+    stream->region = region;
+    CHECK(stub_.GetRegionScannerFactory()
+              ->NewRegionScannerWithRange(stub_, region, scan_start_key, scan_end_key, stream->scanner)
+              .IsOK());
+
+    next_start_ = region->Range().end_key();
+    if (next_start_ >= end_key_) {
+      no_more_region_ = true;
+    }
+
+    DINGO_LOG(INFO) << fmt::format("region:{} scan start, scan range:({}-{}) region range:({}-{})", region->RegionId(),
+                                   scan_start_key, scan_end_key, region->Range().start_key(),
+                                   region->Range().end_key());
+
+    stream->thread = std::thread(&ParallelRangeScanner::StreamRun, this, stream.get());
+    streams_.push_back(std::move(stream));
+  }
+
+  return Status::OK();
+}
+
+void ParallelRangeScanner::StreamRun(RegionStream* stream) {
+  Status ret = stream->scanner->Open();
+  if (!ret.IsOK()) {
+    DINGO_LOG(WARNING) << fmt::format("region scanner open fail, region:{}, status:{}", stream->region->RegionId(),
+                                      ret.ToString());
+  }
+
+  while (ret.IsOK()) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [&]() {
+        return stopped_ || static_cast<int64_t>(stream->batches.size()) < options_.prefetch_batch_count;
+      });
+      if (stopped_) {
+        break;
+      }
+    }
+
+    if (!stream->scanner->HasMore()) {
+      break;
+    }
+
+    std::vector<KVPair> kvs;
+    ret = stream->scanner->NextBatch(kvs);
+    if (!ret.IsOK()) {
+      DINGO_LOG(WARNING) << fmt::format("region scanner NextBatch fail, region:{}, status:{}",
+                                        stream->region->RegionId(), ret.ToString());
+      break;
+    }
+
+    if (kvs.empty()) {
+      continue;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stream->batches.push_back(std::move(kvs));
+    }
+    cond_.notify_all();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stream->status = ret;
+    stream->finished = true;
+  }
+  cond_.notify_all();
+}
+
+void ParallelRangeScanner::RemoveStreamUnlocked(std::list<std::unique_ptr<RegionStream>>::iterator iter) {
+  CHECK((*iter)->finished);
+  // the thread does not touch mutex_ after it is finished, so join with mutex_ held is safe
+  (*iter)->thread.join();
+  DINGO_LOG(INFO) << fmt::format("region:{} scan finished", (*iter)->region->RegionId());
+  streams_.erase(iter);
+}
+
+Status ParallelRangeScanner::NextBatch(std::vector<KVPair>& kvs) {
+  kvs.clear();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  CHECK(opened_);
+
+  while (true) {
+    if (!status_.IsOK()) {
+      return status_;
+    }
+
+    if (streams_.empty()) {
+      has_more_ = false;
+      return Status::OK();
+    }
+
+    auto iter = streams_.begin();
+    if (options_.ordered) {
+      cond_.wait(lock, [&]() { return !(*iter)->batches.empty() || (*iter)->finished; });
+    } else {
+      auto ready = [&]() {
+        return std::find_if(streams_.begin(), streams_.end(), [](const std::unique_ptr<RegionStream>& stream) {
+          return !stream->batches.empty() || stream->finished;
+        });
+      };
+      cond_.wait(lock, [&]() { return ready() != streams_.end(); });
+      iter = ready();
+    }
+
+    auto& stream = *iter;
+    if (!stream->batches.empty()) {
+      kvs = std::move(stream->batches.front());
+      stream->batches.pop_front();
+      lock.unlock();
+      // wake the stream to prefetch next batch
+      cond_.notify_all();
+      return Status::OK();
+    }
+
+    if (!stream->status.IsOK()) {
+      status_ = stream->status;
+      has_more_ = false;
+      return status_;
+    }
+
+    RemoveStreamUnlocked(iter);
+
+    Status ret = FillStreamsUnlocked();
+    if (!ret.IsOK()) {
+      status_ = ret;
+      has_more_ = false;
+      return status_;
+    }
+  }
+}
+
+}  // namespace sdk
+}  // namespace dingodb
@@ -0,0 +1,93 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_SDK_RANGE_SCANNER_H_
+#define DINGODB_SDK_RANGE_SCANNER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sdk/client.h"
+#include "sdk/client_stub.h"
+#include "sdk/region.h"
+#include "sdk/region_scanner.h"
+#include "sdk/status.h"
+
+namespace dingodb {
+namespace sdk {
+
+// Scan [start_key, end_key) with at most options.concurrency region scans in flight.
+// Each region scan runs in its own thread and prefetches up to options.prefetch_batch_count batches,
+// the caller consumes batches in region order when options.ordered, otherwise whichever region has one ready.
+class ParallelRangeScanner final : public RangeScanner {
+ public:
+  ParallelRangeScanner(const ClientStub& stub, std::string start_key, std::string end_key, const ScanOptions& options);
+
+  ~ParallelRangeScanner() override;
+
+  Status Open() override;
+
+  void Close() override;
+
+  Status NextBatch(std::vector<KVPair>& kvs) override;
+
+  bool HasMore() const override;
+
+ private:
+  struct RegionStream {
+    std::shared_ptr<Region> region;
+    std::unique_ptr<RegionScanner> scanner;
+    std::deque<std::vector<KVPair>> batches;
+    bool finished{false};
+    Status status;
+    std::thread thread;
+  };
+
+  void StreamRun(RegionStream* stream);
+
+  // start region streams until concurrency is reached or no region left, must hold mutex_
+  Status FillStreamsUnlocked();
+
+  // join the finished stream and remove it, must hold mutex_
+  void RemoveStreamUnlocked(std::list<std::unique_ptr<RegionStream>>::iterator iter);
+
+  const ClientStub& stub_;
+  const std::string start_key_;
+  const std::string end_key_;
+  const ScanOptions options_;
+
+  std::mutex mutex_;
+  // notified when a stream produce a batch or finish, and when the caller take a batch or close
+  std::condition_variable cond_;
+  // in region key order
+  std::list<std::unique_ptr<RegionStream>> streams_;
+  // start key of the next region to scan
+  std::string next_start_;
+  bool no_more_region_;
+  bool opened_;
+  bool stopped_;
+  bool has_more_;
+  Status status_;
+};
+
+}  // namespace sdk
+}  // namespace dingodb
+#endif  // DINGODB_SDK_RANGE_SCANNER_H_
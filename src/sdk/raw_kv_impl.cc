@@ -28,6 +28,7 @@
 #include "sdk/client.h"
 #include "sdk/common.h"
 #include "sdk/meta_cache.h"
+#include "sdk/range_scanner.h"
 #include "sdk/region_scanner.h"
 #include "sdk/status.h"
 #include "sdk/store_rpc.h"
@@ -824,5 +825,19 @@ Status RawKV::RawKVImpl::Scan(const std::string& start_key, const std::string& e
   return Status::OK();
 }
 
+Status RawKV::RawKVImpl::NewScanner(const std::string& start_key, const std::string& end_key,
+                                    const ScanOptions& options, std::unique_ptr<RangeScanner>& scanner) {
+  auto tmp = std::make_unique<ParallelRangeScanner>(stub_, start_key, end_key, options);
+  Status ret = tmp->Open();
+  if (!ret.IsOK()) {
+    DINGO_LOG(WARNING) << fmt::format("open range scanner fail between [{},{}), status:{}", start_key, end_key,
+                                      ret.ToString());
+    return ret;
+  }
+
+  scanner = std::move(tmp);
+  return Status::OK();
+}
+
 }  // namespace sdk
 }  // namespace dingodb
\ No newline at end of file
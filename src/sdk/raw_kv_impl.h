@@ -65,6 +65,9 @@ class RawKV::RawKVImpl {
   // TODO: maybe enable concurrent
   Status Scan(const std::string& start_key, const std::string& end_key,  uint64_t limit, std::vector<KVPair>& kvs);
 
+  Status NewScanner(const std::string& start_key, const std::string& end_key, const ScanOptions& options,
+                    std::unique_ptr<RangeScanner>& scanner);
+
  private:
   struct SubBatchState {
     Rpc* rpc;
@@ -62,6 +62,11 @@ class RegionScannerFactory {
 
   virtual Status NewRegionScanner(const ClientStub& stub, std::shared_ptr<Region> region,
                                   std::unique_ptr<RegionScanner>& scanner) = 0;
+
+  // scan [start_key, end_key) of region, the range must be in the region range
+  virtual Status NewRegionScannerWithRange(const ClientStub& stub, std::shared_ptr<Region> region,
+                                           std::string start_key, std::string end_key,
+                                           std::unique_ptr<RegionScanner>& scanner) = 0;
 };
 
 }  // namespace sdk
@@ -112,15 +112,17 @@ Status RegionScannerImpl::NextBatch(std::vector<KVPair>& kvs) {
   StoreRpcController controller(stub, rpc, region);
   Status ret = controller.Call();
   if (ret.IsOK()) {
-    const auto* response = rpc.Response();
+    auto* response = rpc.MutableResponse();
     std::vector<KVPair> tmp_kvs;
     if (response->kvs_size() == 0) {
       // scan to region end_key
       has_more_ = false;
     } else {
-      for (const auto& kv : response->kvs()) {
+      // the response is dropped after this, move kvs out of it instead of copy
+      tmp_kvs.reserve(response->kvs_size());
+      for (auto& kv : *response->mutable_kvs()) {
         if (kv.key() < end_key_) {
-          tmp_kvs.push_back({kv.key(), kv.value()});
+          tmp_kvs.push_back({std::move(*kv.mutable_key()), std::move(*kv.mutable_value())});
         } else {
           has_more_ = false;
         }
@@ -162,5 +164,15 @@ Status RegionScannerFactoryImpl::NewRegionScanner(const ClientStub& stub, std::s
   return Status::OK();
 }
 
+Status RegionScannerFactoryImpl::NewRegionScannerWithRange(const ClientStub& stub, std::shared_ptr<Region> region,
+                                                           std::string start_key, std::string end_key,
+                                                           std::unique_ptr<RegionScanner>& scanner) {
+  std::unique_ptr<RegionScanner> tmp(
+      new RegionScannerImpl(stub, std::move(region), std::move(start_key), std::move(end_key)));
+  scanner = std::move(tmp);
+
+  return Status::OK();
+}
+
 }  // namespace sdk
 }  // namespace dingodb
\ No newline at end of file
@@ -78,6 +78,9 @@ class RegionScannerFactoryImpl final : public RegionScannerFactory {
 
   Status NewRegionScanner(const ClientStub& stub, std::shared_ptr<Region> region,
                           std::unique_ptr<RegionScanner>& scanner) override;
+
+  Status NewRegionScannerWithRange(const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key,
+                                   std::string end_key, std::unique_ptr<RegionScanner>& scanner) override;
 };
 
 }  // namespace sdk
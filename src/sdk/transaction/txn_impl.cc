@@ -14,6 +14,7 @@
 
 #include "sdk/transaction/txn_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <thread>
@@ -39,6 +40,8 @@ namespace sdk {
 Transaction::TxnImpl::TxnImpl(const ClientStub& stub, const TransactionOptions& options)
     : stub_(stub), options_(options), state_(kInit), buffer_(new TxnBuffer()) {}
 
+Transaction::TxnImpl::~TxnImpl() { WaitAsyncCommit(); }
+
 Status Transaction::TxnImpl::Begin() {
   pb::meta::TsoTimestamp tso;
   Status ret = stub_.GetAdminTool()->GetCurrentTsoTimeStamp(tso);
@@ -461,26 +464,15 @@ void Transaction::TxnImpl::ProcessTxnPrewriteSubTask(TxnSubTask* sub_task) {
   sub_task->status = ret;
 }
 
-// TODO: process AlreadyExist if mutaion is PutIfAbsent
-Status Transaction::TxnImpl::PreCommit() {
-  state_ = kPreCommitting;
-
-  if (buffer_->IsEmpty()) {
-    state_ = kPreCommitted;
-    return Status::OK();
-  }
-
-  DINGO_RETURN_NOT_OK(PreCommitPrimaryKey());
-
-  // TODO: start heartbeat
-
+Status Transaction::TxnImpl::PrepareTxnPrewriteRpcs(bool skip_primary, std::vector<TxnSubTask>& sub_tasks,
+                                                    std::vector<std::unique_ptr<TxnPrewriteRpc>>& rpcs) {
   auto meta_cache = stub_.GetMetaCache();
   std::unordered_map<int64_t, std::shared_ptr<Region>> region_id_to_region;
   std::unordered_map<int64_t, std::vector<TxnMutation>> region_mutations;
 
   std::string pk = buffer_->GetPrimaryKey();
   for (const auto& mutaion_entry : buffer_->Mutations()) {
-    if (mutaion_entry.first == pk) {
+    if (skip_primary && mutaion_entry.first == pk) {
       continue;
     }
 
@@ -498,9 +490,6 @@ Status Transaction::TxnImpl::PreCommit() {
     region_mutations[tmp->RegionId()].push_back(mutaion_entry.second);
   }
 
-  std::vector<TxnSubTask> sub_tasks;
-  std::vector<std::unique_ptr<TxnPrewriteRpc>> rpcs;
-
   for (const auto& mutation_entry : region_mutations) {
     auto region_id = mutation_entry.first;
     auto iter = region_id_to_region.find(region_id);
@@ -520,6 +509,14 @@ Status Transaction::TxnImpl::PreCommit() {
   DCHECK_EQ(rpcs.size(), region_mutations.size());
   DCHECK_EQ(rpcs.size(), sub_tasks.size());
 
+  return Status::OK();
+}
+
+Status Transaction::TxnImpl::ProcessTxnPrewriteSubTasks(std::vector<TxnSubTask>& sub_tasks) {
+  if (sub_tasks.empty()) {
+    return Status::OK();
+  }
+
   std::vector<std::thread> thread_pool;
   for (auto i = 1; i < sub_tasks.size(); i++) {
     thread_pool.emplace_back(&Transaction::TxnImpl::ProcessTxnPrewriteSubTask, this, &sub_tasks[i]);
@@ -543,6 +540,93 @@ Status Transaction::TxnImpl::PreCommit() {
     }
   }
 
+  return result;
+}
+
+Status Transaction::TxnImpl::PreCommitOnePcOrAsync(std::vector<TxnSubTask>& sub_tasks,
+                                                   const std::vector<std::unique_ptr<TxnPrewriteRpc>>& rpcs) {
+  DINGO_RETURN_NOT_OK(ProcessTxnPrewriteSubTasks(sub_tasks));
+
+  int64_t one_pc_commit_ts = 0;
+  int64_t min_commit_ts = 0;
+  bool is_all_async = true;
+  for (const auto& rpc : rpcs) {
+    const auto* response = rpc->Response();
+    one_pc_commit_ts = std::max(one_pc_commit_ts, response->one_pc_commit_ts());
+    min_commit_ts = std::max(min_commit_ts, response->min_commit_ts());
+    if (!rpc->Request()->use_async_commit() || response->min_commit_ts() == 0) {
+      is_all_async = false;
+    }
+  }
+
+  // the store may fall back to 2PC, e.g. commit_ts exceeds max_commit_ts, then commit the transaction as usual
+  min_commit_ts_ = min_commit_ts;
+  if (one_pc_commit_ts > 0) {
+    is_one_pc_ = true;
+    commit_ts_ = one_pc_commit_ts;
+  } else if (is_all_async) {
+    is_async_commit_ = true;
+    commit_ts_ = min_commit_ts;
+  }
+
+  DINGO_LOG(DEBUG) << "precommit txn start_ts:" << start_ts_ << " is_one_pc:" << is_one_pc_
+                   << " is_async_commit:" << is_async_commit_ << " commit_ts:" << commit_ts_
+                   << " min_commit_ts:" << min_commit_ts_;
+
+  state_ = kPreCommitted;
+  return Status::OK();
+}
+
+// TODO: process AlreadyExist if mutaion is PutIfAbsent
+Status Transaction::TxnImpl::PreCommit() {
+  state_ = kPreCommitting;
+
+  if (buffer_->IsEmpty()) {
+    state_ = kPreCommitted;
+    return Status::OK();
+  }
+
+  if (options_.try_one_pc || options_.use_async_commit) {
+    std::vector<TxnSubTask> sub_tasks;
+    std::vector<std::unique_ptr<TxnPrewriteRpc>> rpcs;
+    DINGO_RETURN_NOT_OK(PrepareTxnPrewriteRpcs(false, sub_tasks, rpcs));
+
+    // the transaction involves only one region, commit it in the prewrite
+    if (options_.try_one_pc && rpcs.size() == 1) {
+      rpcs[0]->MutableRequest()->set_try_one_pc(true);
+      return PreCommitOnePcOrAsync(sub_tasks, rpcs);
+    }
+
+    // the primary lock records all the secondary keys, so only small transaction use async commit
+    if (options_.use_async_commit && buffer_->MutationsSize() <= kTxnAsyncCommitMaxKeys) {
+      std::string pk = buffer_->GetPrimaryKey();
+      for (auto& rpc : rpcs) {
+        auto* request = rpc->MutableRequest();
+        request->set_use_async_commit(true);
+
+        bool has_primary = std::any_of(request->mutations().begin(), request->mutations().end(),
+                                       [&pk](const pb::store::Mutation& mutation) { return mutation.key() == pk; });
+        if (has_primary) {
+          for (const auto& mutaion_entry : buffer_->Mutations()) {
+            if (mutaion_entry.first != pk) {
+              request->add_secondaries(mutaion_entry.first);
+            }
+          }
+        }
+      }
+      return PreCommitOnePcOrAsync(sub_tasks, rpcs);
+    }
+  }
+
+  DINGO_RETURN_NOT_OK(PreCommitPrimaryKey());
+
+  // TODO: start heartbeat
+
+  std::vector<TxnSubTask> sub_tasks;
+  std::vector<std::unique_ptr<TxnPrewriteRpc>> rpcs;
+  DINGO_RETURN_NOT_OK(PrepareTxnPrewriteRpcs(true, sub_tasks, rpcs));
+
+  Status result = ProcessTxnPrewriteSubTasks(sub_tasks);
   if (result.ok()) {
     state_ = kPreCommitted;
   }
@@ -629,6 +713,81 @@ void Transaction::TxnImpl::ProcessTxnCommitSubTask(TxnSubTask* sub_task) {
   sub_task->status = ret;
 }
 
+void Transaction::TxnImpl::CommitSecondaryKeys() {
+  auto meta_cache = stub_.GetMetaCache();
+  std::unordered_map<int64_t, std::shared_ptr<Region>> region_id_to_region;
+  std::unordered_map<int64_t, std::vector<std::string>> region_commit_keys;
+
+  std::string pk = buffer_->GetPrimaryKey();
+  for (const auto& mutaion_entry : buffer_->Mutations()) {
+    if (mutaion_entry.first == pk) {
+      continue;
+    }
+
+    std::shared_ptr<Region> tmp;
+    Status got = meta_cache->LookupRegionByKey(mutaion_entry.first, tmp);
+    if (!got.IsOK()) {
+      continue;
+    }
+
+    auto iter = region_id_to_region.find(tmp->RegionId());
+    if (iter == region_id_to_region.end()) {
+      region_id_to_region.emplace(std::make_pair(tmp->RegionId(), tmp));
+    }
+
+    region_commit_keys[tmp->RegionId()].push_back(mutaion_entry.second.key);
+  }
+
+  std::vector<TxnSubTask> sub_tasks;
+  std::vector<std::unique_ptr<TxnCommitRpc>> rpcs;
+  for (const auto& entry : region_commit_keys) {
+    auto region_id = entry.first;
+    auto iter = region_id_to_region.find(region_id);
+    CHECK(iter != region_id_to_region.end());
+    auto region = iter->second;
+
+    std::unique_ptr<TxnCommitRpc> rpc = PrepareTxnCommitRpc(region);
+    for (const auto& key : entry.second) {
+      auto* fill = rpc->MutableRequest()->add_keys();
+      *fill = key;
+    }
+    sub_tasks.emplace_back(rpc.get(), region);
+    rpcs.push_back(std::move(rpc));
+  }
+
+  DCHECK_EQ(rpcs.size(), region_commit_keys.size());
+  DCHECK_EQ(rpcs.size(), sub_tasks.size());
+
+  if (sub_tasks.empty()) {
+    return;
+  }
+
+  std::vector<std::thread> thread_pool;
+  for (auto i = 1; i < sub_tasks.size(); i++) {
+    thread_pool.emplace_back(&Transaction::TxnImpl::ProcessTxnCommitSubTask, this, &sub_tasks[i]);
+  }
+
+  ProcessTxnCommitSubTask(sub_tasks.data());
+
+  for (auto& thread : thread_pool) {
+    thread.join();
+  }
+
+  for (auto& state : sub_tasks) {
+    // ignore
+    if (!state.status.IsOK()) {
+      DINGO_LOG(INFO) << "Fail txn_commit_sub_task but ignore, rpc: " << state.rpc->Method()
+                      << " send to region: " << state.region->RegionId() << " status: " << state.status.ToString();
+    }
+  }
+}
+
+void Transaction::TxnImpl::WaitAsyncCommit() {
+  if (async_commit_thread_.joinable()) {
+    async_commit_thread_.join();
+  }
+}
+
 Status Transaction::TxnImpl::Commit() {
   if (state_ != kPreCommitted) {
     return Status::IllegalState(fmt::format("forbid commit, txn state is:{}, expect:{}", TransactionState2Str(state_),
@@ -640,12 +799,34 @@ Status Transaction::TxnImpl::Commit() {
     return Status::OK();
   }
 
+  // the writes of 1PC are committed in prewrite
+  if (is_one_pc_) {
+    state_ = kCommitted;
+    return Status::OK();
+  }
+
+  // the transaction is committed once all keys are prewritten, the locks are committed with the known commit_ts in
+  // background, the lock resolver gets the same commit_ts if meets the lock
+  if (is_async_commit_) {
+    state_ = kCommitted;
+    async_commit_thread_ = std::thread([this]() {
+      Status ret = CommitPrimaryKey();
+      if (!ret.ok()) {
+        DINGO_LOG(INFO) << "Fail async commit primary key but ignore, start_ts:" << start_ts_
+                        << " commit_ts:" << commit_ts_ << " status:" << ret.ToString();
+      }
+      CommitSecondaryKeys();
+    });
+    return Status::OK();
+  }
+
   state_ = kCommitting;
 
   pb::meta::TsoTimestamp tso;
   DINGO_RETURN_NOT_OK(stub_.GetAdminTool()->GetCurrentTsoTimeStamp(tso));
   commit_tso_ = tso;
-  commit_ts_ = Tso2Timestamp(commit_tso_);
+  // the locks may be prewritten with async commit, but the store falls back to 2PC in some regions
+  commit_ts_ = std::max(Tso2Timestamp(commit_tso_), min_commit_ts_);
   CHECK(commit_ts_ > start_ts_) << "commit_ts:" << commit_ts_ << " must greater than start_ts:" << start_ts_
                                 << ", commit_tso:" << commit_tso_.DebugString()
                                 << ", start_tso:" << start_tso_.DebugString();
@@ -660,71 +841,8 @@ Status Transaction::TxnImpl::Commit() {
   } else {
     state_ = kCommitted;
 
-    {
-      // we commit primary key is success, and then we try best to commit other keys, if fail we ignore
-      auto meta_cache = stub_.GetMetaCache();
-      std::unordered_map<int64_t, std::shared_ptr<Region>> region_id_to_region;
-      std::unordered_map<int64_t, std::vector<std::string>> region_commit_keys;
-
-      std::string pk = buffer_->GetPrimaryKey();
-      for (const auto& mutaion_entry : buffer_->Mutations()) {
-        if (mutaion_entry.first == pk) {
-          continue;
-        }
-
-        std::shared_ptr<Region> tmp;
-        Status got = meta_cache->LookupRegionByKey(mutaion_entry.first, tmp);
-        if (!got.IsOK()) {
-          continue;
-        }
-
-        auto iter = region_id_to_region.find(tmp->RegionId());
-        if (iter == region_id_to_region.end()) {
-          region_id_to_region.emplace(std::make_pair(tmp->RegionId(), tmp));
-        }
-
-        region_commit_keys[tmp->RegionId()].push_back(mutaion_entry.second.key);
-      }
-
-      std::vector<TxnSubTask> sub_tasks;
-      std::vector<std::unique_ptr<TxnCommitRpc>> rpcs;
-      for (const auto& entry : region_commit_keys) {
-        auto region_id = entry.first;
-        auto iter = region_id_to_region.find(region_id);
-        CHECK(iter != region_id_to_region.end());
-        auto region = iter->second;
-
-        std::unique_ptr<TxnCommitRpc> rpc = PrepareTxnCommitRpc(region);
-        for (const auto& key : entry.second) {
-          auto* fill = rpc->MutableRequest()->add_keys();
-          *fill = key;
-        }
-        sub_tasks.emplace_back(rpc.get(), region);
-        rpcs.push_back(std::move(rpc));
-      }
-
-      DCHECK_EQ(rpcs.size(), region_commit_keys.size());
-      DCHECK_EQ(rpcs.size(), sub_tasks.size());
-
-      std::vector<std::thread> thread_pool;
-      for (auto i = 1; i < sub_tasks.size(); i++) {
-        thread_pool.emplace_back(&Transaction::TxnImpl::ProcessTxnCommitSubTask, this, &sub_tasks[i]);
-      }
-
-      ProcessTxnCommitSubTask(sub_tasks.data());
-
-      for (auto& thread : thread_pool) {
-        thread.join();
-      }
-
-      for (auto& state : sub_tasks) {
-        // ignore
-        if (!state.status.IsOK()) {
-          DINGO_LOG(INFO) << "Fail txn_commit_sub_task but ignore, rpc: " << state.rpc->Method()
-                          << " send to region: " << state.region->RegionId() << " status: " << state.status.ToString();
-        }
-      }
-    }
+    // we commit primary key is success, and then we try best to commit other keys, if fail we ignore
+    CommitSecondaryKeys();
   }
 
   return ret;
@@ -781,6 +899,12 @@ Status Transaction::TxnImpl::Rollback() {
     return Status::IllegalState(fmt::format("forbid rollback, txn state is:{}", TransactionState2Str(state_)));
   }
 
+  // 1PC and async commit transaction is committed once prewrite finished
+  if (is_one_pc_ || is_async_commit_) {
+    return Status::IllegalState(fmt::format("forbid rollback, txn is committed by {}, txn state is:{}",
+                                            is_one_pc_ ? "1PC" : "async commit", TransactionState2Str(state_)));
+  }
+
   state_ = kRollbacking;
   {
     // rollback primary key
@@ -17,6 +17,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "proto/meta.pb.h"
 #include "proto/store.pb.h"
@@ -72,7 +74,7 @@ class Transaction::TxnImpl {
 
   explicit TxnImpl(const ClientStub& stub, const TransactionOptions& options);
 
-  ~TxnImpl() = default;
+  ~TxnImpl();
 
   Status Begin();
 
@@ -103,6 +105,9 @@ class Transaction::TxnImpl {
   int64_t TEST_GetCommitTs() { return commit_ts_; }                      // NOLINT
   int64_t TEST_MutationsSize() { return buffer_->MutationsSize(); }      // NOLINT
   std::string TEST_GetPrimaryKey() { return buffer_->GetPrimaryKey(); }  // NOLINT
+  bool TEST_IsOnePc() { return is_one_pc_; }                             // NOLINT
+  bool TEST_IsAsyncCommit() { return is_async_commit_; }                 // NOLINT
+  void TEST_WaitAsyncCommit() { WaitAsyncCommit(); }                     // NOLINT
 
  private:
   struct TxnSubTask {
@@ -129,11 +134,21 @@ class Transaction::TxnImpl {
   Status TryResolveTxnPrewriteLockConflict(const pb::store::TxnPrewriteResponse* response) const;
   Status PreCommitPrimaryKey();
   void ProcessTxnPrewriteSubTask(TxnSubTask* sub_task);
+  // prewrite rpc of every region, the primary key is skipped if skip_primary
+  Status PrepareTxnPrewriteRpcs(bool skip_primary, std::vector<TxnSubTask>& sub_tasks,
+                                std::vector<std::unique_ptr<TxnPrewriteRpc>>& rpcs);
+  Status ProcessTxnPrewriteSubTasks(std::vector<TxnSubTask>& sub_tasks);
+  // 1PC and async commit, all the keys include primary key are prewritten together
+  Status PreCommitOnePcOrAsync(std::vector<TxnSubTask>& sub_tasks,
+                               const std::vector<std::unique_ptr<TxnPrewriteRpc>>& rpcs);
 
   std::unique_ptr<TxnCommitRpc> PrepareTxnCommitRpc(const std::shared_ptr<Region>& region) const;
   Status ProcessTxnCommitResponse(const pb::store::TxnCommitResponse* response, bool is_primary) const;
   Status CommitPrimaryKey();
   void ProcessTxnCommitSubTask(TxnSubTask* sub_task);
+  // try best to commit the secondary keys, the failure is ignored
+  void CommitSecondaryKeys();
+  void WaitAsyncCommit();
 
   // txn rollback
   std::unique_ptr<TxnBatchRollbackRpc> PrepareTxnBatchRollbackRpc(const std::shared_ptr<Region>& region) const;
@@ -158,6 +173,14 @@ class Transaction::TxnImpl {
 
   pb::meta::TsoTimestamp commit_tso_;
   int64_t commit_ts_;
+
+  // the transaction is committed by 1PC in prewrite
+  bool is_one_pc_{false};
+  // the transaction is committed by async commit once prewrite finished, commit_ts_ is decided by min_commit_ts_
+  bool is_async_commit_{false};
+  // the max min_commit_ts of prewrite responses, commit_ts must not be less than it
+  int64_t min_commit_ts_{0};
+  std::thread async_commit_thread_;
 };
 
 }  // namespace sdk
@@ -14,6 +14,7 @@
 
 #include "sdk/transaction/txn_lock_resolver.h"
 
+#include <algorithm>
 #include <cstdint>
 
 #include "common/logging.h"
@@ -48,6 +49,10 @@ Status TxnLockResolver::ResolveLock(const pb::store::LockInfo& lock_info, int64_
   }
 
   if (txn_status.IsLocked()) {
+    // the primary lock of async commit transaction is expired, resolve the transaction by all its locks
+    if (txn_status.lock_info.use_async_commit()) {
+      return ResolveAsyncCommitLock(txn_status.lock_info, caller_start_ts);
+    }
     return Status::TxnLockConflict(ret.ToString());
   }
 
@@ -72,11 +77,82 @@ Status TxnLockResolver::ResolveLock(const pb::store::LockInfo& lock_info, int64_
   return Status::OK();
 }
 
+Status TxnLockResolver::ResolveAsyncCommitLock(const pb::store::LockInfo& primary_lock, int64_t caller_start_ts) {
+  DINGO_LOG(INFO) << "resolve async commit txn:" << primary_lock.lock_ts()
+                  << " primary_key:" << primary_lock.primary_lock()
+                  << " secondaries_size:" << primary_lock.secondaries_size();
+
+  int64_t commit_ts = primary_lock.min_commit_ts();
+  for (const auto& key : primary_lock.secondaries()) {
+    TxnStatus txn_status;
+    DINGO_RETURN_NOT_OK(CheckSecondaryLock(primary_lock.lock_ts(), key, caller_start_ts, txn_status));
+
+    if (txn_status.IsCommitted()) {
+      // some key is committed, the whole transaction is committed with the same commit_ts
+      commit_ts = txn_status.commit_ts;
+      break;
+    }
+
+    if (txn_status.IsRollbacked() || !txn_status.lock_info.use_async_commit()) {
+      // some key is not prewritten with async commit, the transaction can't be committed without the primary key
+      commit_ts = 0;
+      break;
+    }
+
+    commit_ts = std::max(commit_ts, txn_status.lock_info.min_commit_ts());
+  }
+
+  // resolve primary key first, the secondary keys of rolled back transaction are resolved again by the later reads
+  Status ret = ResolveLockKey(primary_lock.lock_ts(), primary_lock.primary_lock(), commit_ts);
+  if (!ret.IsOK()) {
+    DINGO_LOG(WARNING) << "resolve async commit txn:" << primary_lock.lock_ts()
+                       << " primary_key:" << primary_lock.primary_lock() << " commit_ts:" << commit_ts
+                       << " fail, status:" << ret.ToString();
+    return ret;
+  }
+
+  for (const auto& key : primary_lock.secondaries()) {
+    ret = ResolveLockKey(primary_lock.lock_ts(), key, commit_ts);
+    if (!ret.IsOK()) {
+      DINGO_LOG(WARNING) << "resolve async commit txn:" << primary_lock.lock_ts() << " key:" << key
+                         << " commit_ts:" << commit_ts << " fail, status:" << ret.ToString();
+      return ret;
+    }
+  }
+
+  return Status::OK();
+}
+
 // TODO: use txn status cache
 Status TxnLockResolver::CheckTxnStatus(int64_t txn_start_ts, const std::string& txn_primary_key,
                                        int64_t caller_start_ts, TxnStatus& txn_status) {
+  pb::store::TxnCheckTxnStatusResponse response;
+  DINGO_RETURN_NOT_OK(SendTxnCheckTxnStatus(txn_start_ts, txn_primary_key, caller_start_ts, false, response));
+
+  return ProcessTxnCheckStatusResponse(response, txn_status);
+}
+
+Status TxnLockResolver::CheckSecondaryLock(int64_t txn_start_ts, const std::string& key, int64_t caller_start_ts,
+                                           TxnStatus& txn_status) {
+  pb::store::TxnCheckTxnStatusResponse response;
+  DINGO_RETURN_NOT_OK(SendTxnCheckTxnStatus(txn_start_ts, key, caller_start_ts, true, response));
+
+  // the secondary lock is exist
+  if (response.has_txn_result() && response.txn_result().has_primary_mismatch()) {
+    const auto& lock_info = response.txn_result().primary_mismatch().lock_info();
+    txn_status = TxnStatus(lock_info.lock_ttl(), 0);
+    txn_status.lock_info = lock_info;
+    return Status::OK();
+  }
+
+  return ProcessTxnCheckStatusResponse(response, txn_status);
+}
+
+Status TxnLockResolver::SendTxnCheckTxnStatus(int64_t txn_start_ts, const std::string& key, int64_t caller_start_ts,
+                                              bool rollback_if_not_exist,
+                                              pb::store::TxnCheckTxnStatusResponse& response) {
   std::shared_ptr<Region> region;
-  DINGO_RETURN_NOT_OK(stub_.GetMetaCache()->LookupRegionByKey(txn_primary_key, region));
+  DINGO_RETURN_NOT_OK(stub_.GetMetaCache()->LookupRegionByKey(key, region));
 
   int64_t current_ts;
   DINGO_RETURN_NOT_OK(stub_.GetAdminTool()->GetCurrentTimeStamp(current_ts));
@@ -86,16 +162,17 @@ Status TxnLockResolver::CheckTxnStatus(int64_t txn_start_ts, const std::string&
   // NOTE: use randome isolation is ok?
   FillRpcContext(*rpc.MutableRequest()->mutable_context(), region->RegionId(), region->Epoch(),
                  pb::store::IsolationLevel::SnapshotIsolation);
-  rpc.MutableRequest()->set_primary_key(txn_primary_key);
+  rpc.MutableRequest()->set_primary_key(key);
   rpc.MutableRequest()->set_lock_ts(txn_start_ts);
   rpc.MutableRequest()->set_caller_start_ts(caller_start_ts);
   rpc.MutableRequest()->set_current_ts(current_ts);
+  rpc.MutableRequest()->set_rollback_if_not_exist(rollback_if_not_exist);
 
   StoreRpcController controller(stub_, rpc, region);
   DINGO_RETURN_NOT_OK(controller.Call());
 
-  const auto& response = *rpc.Response();
-  return ProcessTxnCheckStatusResponse(response, txn_status);
+  response = *rpc.Response();
+  return Status::OK();
 }
 
 Status TxnLockResolver::ProcessTxnCheckStatusResponse(const pb::store::TxnCheckTxnStatusResponse& response,
@@ -116,6 +193,9 @@ Status TxnLockResolver::ProcessTxnCheckStatusResponse(const pb::store::TxnCheckT
   }
 
   txn_status = TxnStatus(response.lock_ttl(), response.commit_ts());
+  if (response.has_lock_info()) {
+    txn_status.lock_info = response.lock_info();
+  }
   return Status::OK();
 }
 
@@ -28,6 +28,9 @@ class ClientStub;
 struct TxnStatus {
   int64_t lock_ttl;
   int64_t commit_ts;
+  // the lock of checked key, only set when the lock needs resolve by caller, e.g. the expired primary lock or the
+  // secondary lock of async commit transaction
+  pb::store::LockInfo lock_info;
 
   explicit TxnStatus() : lock_ttl(-1), commit_ts(-1) {}
 
@@ -53,6 +56,18 @@ class TxnLockResolver {
  private:
   Status CheckTxnStatus(int64_t txn_start_ts, const std::string& txn_primary_key, int64_t caller_start_ts, TxnStatus& txn_status);
 
+  // the secondary lock is not exist and the transaction is not committed, a rollback is written to prevent the late
+  // prewrite
+  Status CheckSecondaryLock(int64_t txn_start_ts, const std::string& key, int64_t caller_start_ts,
+                            TxnStatus& txn_status);
+
+  Status SendTxnCheckTxnStatus(int64_t txn_start_ts, const std::string& key, int64_t caller_start_ts,
+                               bool rollback_if_not_exist, pb::store::TxnCheckTxnStatusResponse& response);
+
+  // The async commit transaction is committed if all keys are prewritten with async commit, the commit_ts is the max
+  // min_commit_ts of the locks, otherwise it is rolled back.
+  Status ResolveAsyncCommitLock(const pb::store::LockInfo& primary_lock, int64_t caller_start_ts);
+
   static Status ProcessTxnCheckStatusResponse(const pb::store::TxnCheckTxnStatusResponse& response,
                                               TxnStatus& txn_status);
 
@@ -0,0 +1,500 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "record_view_decoder.h"
+
+#include <algorithm>
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buf.h"
+#include "common/logging.h"
+#include "schema/boolean_list_schema.h"
+#include "schema/double_list_schema.h"
+#include "schema/float_list_schema.h"
+#include "schema/integer_list_schema.h"
+#include "schema/long_list_schema.h"
+#include "schema/string_list_schema.h"
+#include "utils.h"
+
+namespace dingodb {
+
+static const uint8_t kNullTag = 0;
+// namespace(1) + common_id(8)
+static const size_t kKeyPrefixLength = 9;
+// codec version is the last byte of the 4 bytes tag
+static const size_t kKeyReverseTagLength = 4;
+static const size_t kValueSchemaVersionLength = 4;
+
+// Same byte order as Buf::ReadInt and Buf::ReadLong.
+static inline uint32_t ReadUint32(const char* data, bool le) {
+  const auto* p = reinterpret_cast<const uint8_t*>(data);
+  if (le) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+  }
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint64_t ReadUint64(const char* data, bool le) {
+  uint64_t first = ReadUint32(data, le);
+  uint64_t second = ReadUint32(data + 4, le);
+  return le ? ((first << 32) | second) : ((second << 32) | first);
+}
+
+// Same as Buf::ReverseReadInt, last is the position of the first read byte.
+static inline uint32_t ReverseReadUint32(const char* last, bool le) { return ReadUint32(last - 3, !le); }
+
+static bool IsVariableLength(BaseSchema::Type type) {
+  return type == BaseSchema::kString || type == BaseSchema::kBoolList || type == BaseSchema::kIntegerList ||
+         type == BaseSchema::kFloatList || type == BaseSchema::kLongList || type == BaseSchema::kDoubleList ||
+         type == BaseSchema::kStringList;
+}
+
+// Same as DecodeKey/DecodeValue of the fixed length schemas, data is after the null tag.
+static void DecodeFixed(BaseSchema::Type type, const char* data, bool is_key, bool le,
+                        RecordViewDecoder::ColumnView& view) {
+  // key flips the sign bit to keep the order of bytes, it is the first byte written
+  const uint32_t int_sign_mask = le ? 0x80000000U : 0x80U;
+  const uint64_t long_sign_mask = le ? 0x8000000000000000ULL : 0x80ULL;
+  bool is_positive = static_cast<uint8_t>(data[0]) >= 0x80;
+
+  switch (type) {
+    case BaseSchema::kBool:
+      view.bool_value = data[0] != 0;
+      break;
+    case BaseSchema::kInteger: {
+      uint32_t bits = ReadUint32(data, le);
+      view.int_value = static_cast<int32_t>(is_key ? bits ^ int_sign_mask : bits);
+      break;
+    }
+    case BaseSchema::kLong: {
+      uint64_t bits = ReadUint64(data, le);
+      view.long_value = static_cast<int64_t>(is_key ? bits ^ long_sign_mask : bits);
+      break;
+    }
+    case BaseSchema::kFloat: {
+      uint32_t bits = ReadUint32(data, le);
+      if (is_key) {
+        bits = is_positive ? bits ^ int_sign_mask : ~bits;
+      }
+      memcpy(&view.float_value, &bits, sizeof(bits));
+      break;
+    }
+    case BaseSchema::kDouble: {
+      uint64_t bits = ReadUint64(data, le);
+      if (is_key) {
+        bits = is_positive ? bits ^ long_sign_mask : ~bits;
+      }
+      memcpy(&view.double_value, &bits, sizeof(bits));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Same as DingoSchema<std::optional<std::shared_ptr<std::string>>>::DecodeKey, the string is split into groups of
+// 8 bytes and 1 marker byte, the last marker is 255 minus the padding zeros of the last group.
+static bool UnescapeKeyString(const char* data, int length, std::string& output) {
+  output.clear();
+  int group_num = length / 9;
+  if (group_num == 0) {
+    return length == 0;
+  }
+
+  int remainder_zero = 255 - static_cast<uint8_t>(data[length - 1]);
+  int ori_length = group_num * 8 - remainder_zero;
+  if (ori_length < 0) {
+    return false;
+  }
+
+  output.reserve(ori_length);
+  for (int i = 0; i < group_num && static_cast<int>(output.size()) < ori_length; ++i) {
+    output.append(data + i * 9, std::min(8, ori_length - static_cast<int>(output.size())));
+  }
+  return true;
+}
+
+template <typename T>
+static std::optional<std::shared_ptr<std::vector<T>>> DecodeListValue(const std::shared_ptr<BaseSchema>& schema,
+                                                                       std::string_view encoded, bool le) {
+  auto dingo_schema = std::dynamic_pointer_cast<DingoSchema<std::optional<std::shared_ptr<std::vector<T>>>>>(schema);
+  Buf buf(std::string(encoded), le);
+  return dingo_schema->DecodeValue(&buf);
+}
+
+RecordViewDecoder::RecordViewDecoder(int schema_version,
+                                     std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas,
+                                     long common_id, const std::vector<int>& column_indexes) {
+  this->le_ = IsLE();
+  Init(schema_version, schemas, common_id, column_indexes);
+}
+
+RecordViewDecoder::RecordViewDecoder(int schema_version,
+                                     std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas,
+                                     long common_id, const std::vector<int>& column_indexes, bool le) {
+  this->le_ = le;
+  Init(schema_version, schemas, common_id, column_indexes);
+}
+
+void RecordViewDecoder::Init(int schema_version, std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas,
+                             long common_id, const std::vector<int>& column_indexes) {
+  this->schema_version_ = schema_version;
+  FormatSchema(schemas, this->le_);
+  this->schemas_ = schemas;
+  this->common_id_ = common_id;
+  this->column_indexes_ = column_indexes;
+
+  views_.resize(column_indexes.size());
+  key_strings_.resize(column_indexes.size());
+
+  std::vector<std::vector<int>> column_slots(schemas->size());
+  for (int i = 0; i < column_indexes.size(); ++i) {
+    int column_index = column_indexes[i];
+    if (column_index < 0 || column_index >= schemas->size() || schemas->at(column_index) == nullptr) {
+      DINGO_LOG(ERROR) << "RecordViewDecoder invalid column index: " << column_index;
+      continue;
+    }
+    column_slots[column_index].push_back(i);
+  }
+
+  BuildSteps(*schemas, column_slots, true, key_steps_);
+  BuildSteps(*schemas, column_slots, false, value_steps_);
+}
+
+void RecordViewDecoder::BuildSteps(const std::vector<std::shared_ptr<BaseSchema>>& schemas,
+                                   const std::vector<std::vector<int>>& column_slots, bool is_key,
+                                   std::vector<Step>& steps) {
+  steps.clear();
+
+  // the columns after the last projected column are never visited
+  int last_projected = -1;
+  for (int i = 0; i < schemas.size(); ++i) {
+    if (schemas[i] != nullptr && schemas[i]->IsKey() == is_key && !column_slots[i].empty()) {
+      last_projected = i;
+    }
+  }
+
+  int skip_length = 0;
+  for (int i = 0; i <= last_projected; ++i) {
+    const auto& schema = schemas[i];
+    if (schema == nullptr || schema->IsKey() != is_key) {
+      continue;
+    }
+
+    bool is_variable_length = IsVariableLength(schema->GetType());
+    if (column_slots[i].empty() && !is_variable_length) {
+      skip_length += schema->GetLength();
+      continue;
+    }
+
+    Step step;
+    step.skip_length = skip_length;
+    step.schema = schema;
+    step.type = schema->GetType();
+    step.allow_null = schema->AllowNull();
+    step.length = is_variable_length ? -1 : schema->GetLength();
+    step.slots = column_slots[i];
+    steps.push_back(std::move(step));
+    skip_length = 0;
+  }
+}
+
+int RecordViewDecoder::DecodeKey(std::string_view key, std::vector<ColumnView>& views,
+                                 std::vector<std::string>& key_strings) {
+  if (key.size() < kKeyPrefixLength + kKeyReverseTagLength) {
+    return -1;
+  }
+  // skip name space
+  if (static_cast<int64_t>(ReadUint64(key.data() + 1, le_)) != common_id_) {
+    //"Wrong Common Id"
+    return -1;
+  }
+  if (static_cast<uint8_t>(key.back()) > codec_version_) {
+    //"Wrong Codec Version"
+    return -1;
+  }
+
+  size_t pos = kKeyPrefixLength;
+  // the length of key strings are written reversely from the end of key
+  size_t reverse_end = key.size() - kKeyReverseTagLength;
+  for (const auto& step : key_steps_) {
+    pos += step.skip_length;
+
+    if (step.length >= 0) {
+      if (pos + step.length > reverse_end) {
+        return -1;
+      }
+      if (!step.slots.empty()) {
+        ColumnView view;
+        view.type = step.type;
+        view.is_null = step.allow_null && static_cast<uint8_t>(key[pos]) == kNullTag;
+        if (!view.is_null) {
+          DecodeFixed(step.type, key.data() + pos + (step.allow_null ? 1 : 0), true, le_, view);
+        }
+        for (int slot : step.slots) {
+          views[slot] = view;
+        }
+      }
+      pos += step.length;
+      continue;
+    }
+
+    if (step.type != BaseSchema::kString) {
+      // list is not supported in key
+      return -1;
+    }
+
+    bool is_null = false;
+    if (step.allow_null) {
+      if (pos >= reverse_end) {
+        return -1;
+      }
+      is_null = static_cast<uint8_t>(key[pos++]) == kNullTag;
+    }
+    if (reverse_end < pos + 4) {
+      return -1;
+    }
+    int32_t length = static_cast<int32_t>(ReverseReadUint32(key.data() + reverse_end - 1, le_));
+    reverse_end -= 4;
+
+    ColumnView view;
+    view.type = step.type;
+    view.is_null = is_null;
+    if (!is_null) {
+      if (length < 0 || pos + length > reverse_end) {
+        return -1;
+      }
+      if (!step.slots.empty()) {
+        auto& key_string = key_strings[step.slots[0]];
+        if (!UnescapeKeyString(key.data() + pos, length, key_string)) {
+          return -1;
+        }
+        view.string_value = key_string;
+      }
+      pos += length;
+    }
+    for (int slot : step.slots) {
+      views[slot] = view;
+    }
+  }
+
+  return 0;
+}
+
+int RecordViewDecoder::DecodeValue(std::string_view value, std::vector<ColumnView>& views) {
+  if (value.size() < kValueSchemaVersionLength) {
+    return -1;
+  }
+  if (static_cast<int32_t>(ReadUint32(value.data(), le_)) > schema_version_) {
+    //"Wrong Schema Version"
+    return -1;
+  }
+
+  size_t pos = kValueSchemaVersionLength;
+  for (const auto& step : value_steps_) {
+    pos += step.skip_length;
+
+    ColumnView view;
+    view.type = step.type;
+    view.is_null = true;
+
+    // the column is added after the record is written
+    if (pos >= value.size()) {
+      for (int slot : step.slots) {
+        views[slot] = view;
+      }
+      continue;
+    }
+
+    size_t begin = pos;
+    if (step.allow_null) {
+      view.is_null = static_cast<uint8_t>(value[pos++]) == kNullTag;
+    } else {
+      view.is_null = false;
+    }
+
+    if (step.length >= 0) {
+      if (begin + step.length > value.size()) {
+        return -1;
+      }
+      if (!view.is_null && !step.slots.empty()) {
+        DecodeFixed(step.type, value.data() + pos, false, le_, view);
+      }
+      pos = begin + step.length;
+    } else if (!view.is_null) {
+      // null string or list has only the null tag
+      if (pos + 4 > value.size()) {
+        return -1;
+      }
+      int32_t count = static_cast<int32_t>(ReadUint32(value.data() + pos, le_));
+      pos += 4;
+      if (count < 0) {
+        return -1;
+      }
+
+      size_t payload_length = 0;
+      switch (step.type) {
+        case BaseSchema::kString:
+        case BaseSchema::kBoolList:
+          payload_length = count;
+          break;
+        case BaseSchema::kIntegerList:
+        case BaseSchema::kFloatList:
+          payload_length = static_cast<size_t>(count) * 4;
+          break;
+        case BaseSchema::kLongList:
+        case BaseSchema::kDoubleList:
+          payload_length = static_cast<size_t>(count) * 8;
+          break;
+        case BaseSchema::kStringList:
+          for (int32_t i = 0; i < count; ++i) {
+            if (pos + payload_length + 4 > value.size()) {
+              return -1;
+            }
+            int32_t str_len = static_cast<int32_t>(ReadUint32(value.data() + pos + payload_length, le_));
+            if (str_len < 0) {
+              return -1;
+            }
+            payload_length += 4 + str_len;
+          }
+          break;
+        default:
+          return -1;
+      }
+
+      if (pos + payload_length > value.size()) {
+        return -1;
+      }
+      if (step.type == BaseSchema::kString) {
+        view.string_value = std::string_view(value.data() + pos, payload_length);
+      } else {
+        view.string_value = std::string_view(value.data() + begin, pos + payload_length - begin);
+      }
+      pos += payload_length;
+    }
+
+    for (int slot : step.slots) {
+      views[slot] = view;
+    }
+  }
+
+  return 0;
+}
+
+int RecordViewDecoder::Decode(std::string_view key, std::string_view value, std::vector<ColumnView>& views) {
+  return Decode(key, value, views, key_strings_);
+}
+
+int RecordViewDecoder::Decode(std::string_view key, std::string_view value, std::vector<ColumnView>& views,
+                              std::vector<std::string>& key_strings) {
+  views.resize(column_indexes_.size());
+  key_strings.resize(column_indexes_.size());
+  if (DecodeKey(key, views, key_strings) < 0) {
+    return -1;
+  }
+  return DecodeValue(value, views);
+}
+
+int RecordViewDecoder::Decode(std::string_view key, std::string_view value, std::vector<std::any>& record) {
+  int ret = Decode(key, value, views_);
+  if (ret < 0) {
+    return ret;
+  }
+
+  record.resize(column_indexes_.size());
+  for (int i = 0; i < views_.size(); ++i) {
+    ToAny(views_[i], column_indexes_[i], record[i]);
+  }
+  return 0;
+}
+
+int RecordViewDecoder::Decode(const pb::common::KeyValue& key_value, std::vector<std::any>& record) {
+  return Decode(key_value.key(), key_value.value(), record);
+}
+
+void RecordViewDecoder::ToAny(const ColumnView& view, int column_index, std::any& value) const {
+  switch (view.type) {
+    case BaseSchema::kBool:
+      value = view.is_null ? std::optional<bool>() : std::optional<bool>(view.bool_value);
+      break;
+    case BaseSchema::kInteger:
+      value = view.is_null ? std::optional<int32_t>() : std::optional<int32_t>(view.int_value);
+      break;
+    case BaseSchema::kFloat:
+      value = view.is_null ? std::optional<float>() : std::optional<float>(view.float_value);
+      break;
+    case BaseSchema::kLong:
+      value = view.is_null ? std::optional<int64_t>() : std::optional<int64_t>(view.long_value);
+      break;
+    case BaseSchema::kDouble:
+      value = view.is_null ? std::optional<double>() : std::optional<double>(view.double_value);
+      break;
+    case BaseSchema::kString:
+      if (view.is_null) {
+        value = std::optional<std::shared_ptr<std::string>>();
+      } else {
+        value = std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>(view.string_value));
+      }
+      break;
+    case BaseSchema::kBoolList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<bool>>>()
+                           : DecodeListValue<bool>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    case BaseSchema::kIntegerList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<int32_t>>>()
+                           : DecodeListValue<int32_t>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    case BaseSchema::kFloatList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<float>>>()
+                           : DecodeListValue<float>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    case BaseSchema::kLongList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<int64_t>>>()
+                           : DecodeListValue<int64_t>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    case BaseSchema::kDoubleList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<double>>>()
+                           : DecodeListValue<double>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    case BaseSchema::kStringList:
+      value = view.is_null ? std::optional<std::shared_ptr<std::vector<std::string>>>()
+                           : DecodeListValue<std::string>(schemas_->at(column_index), view.string_value, le_);
+      break;
+    default:
+      value = std::any();
+      break;
+  }
+}
+
+void RecordViewDecoder::AssignAny(const ColumnView& view, int column_index, std::any& value) const {
+  if (view.type == BaseSchema::kString && !view.is_null) {
+    auto* str = std::any_cast<std::optional<std::shared_ptr<std::string>>>(&value);
+    if (str != nullptr && str->has_value() && str->value() != nullptr && str->value().use_count() == 1) {
+      str->value()->assign(view.string_value.data(), view.string_value.size());
+      return;
+    }
+  }
+  ToAny(view, column_index, value);
+}
+
+}  // namespace dingodb
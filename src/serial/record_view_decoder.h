@@ -0,0 +1,112 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGO_SERIAL_RECORD_VIEW_DECODER_H_
+#define DINGO_SERIAL_RECORD_VIEW_DECODER_H_
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "proto/common.pb.h"
+#include "schema/base_schema.h"
+
+namespace dingodb {
+
+// Decode the projected columns of a record directly from key and value, without copying them into Buf.
+// The layout of the schemas is resolved once at construction: the skipped fixed length columns between two
+// projected columns are folded into one offset, so only the projected and the skipped variable length columns are
+// visited for every record.
+class RecordViewDecoder {
+ public:
+  // Typed view of one column.
+  struct ColumnView {
+    BaseSchema::Type type;
+    bool is_null;
+    union {
+      bool bool_value;
+      int32_t int_value;
+      float float_value;
+      int64_t long_value;
+      double double_value;
+    };
+    // kString: the bytes of the string, points into value, or into the decoder for the key column because the key
+    // string is escaped. List types: the encoded column, decoded by schema when converted to std::any.
+    std::string_view string_value;
+  };
+
+  // column_indexes is the position of the projected columns in schemas, same as RecordDecoder::Decode.
+  RecordViewDecoder(int schema_version, std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas,
+                    long common_id, const std::vector<int>& column_indexes);
+  RecordViewDecoder(int schema_version, std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas,
+                    long common_id, const std::vector<int>& column_indexes, bool le);
+
+  // views[i] is the column of column_indexes[i], the views are valid until the next Decode and while key and value
+  // are alive. Return -1 if the record is not of the schemas or is corrupted.
+  int Decode(std::string_view key, std::string_view value, std::vector<ColumnView>& views /*output*/);
+  // Same as above, the unescaped key strings are kept in key_strings, so the views of a batch of records decoded with
+  // different key_strings are valid at the same time.
+  int Decode(std::string_view key, std::string_view value, std::vector<ColumnView>& views /*output*/,
+             std::vector<std::string>& key_strings);
+
+  // Same output as RecordDecoder::Decode with column_indexes, every column is std::optional<T>.
+  int Decode(std::string_view key, std::string_view value, std::vector<std::any>& record /*output*/);
+  int Decode(const pb::common::KeyValue& key_value, std::vector<std::any>& record /*output*/);
+
+  void ToAny(const ColumnView& view, int column_index, std::any& value /*output*/) const;
+  // Same as ToAny, but the string held by value is overwritten instead of allocating a new one when no one else
+  // shares it, for the records which are reused for every row.
+  void AssignAny(const ColumnView& view, int column_index, std::any& value /*output*/) const;
+
+ private:
+  struct Step {
+    // fixed length of the skipped columns before this column
+    int skip_length;
+    std::shared_ptr<BaseSchema> schema;
+    BaseSchema::Type type;
+    bool allow_null;
+    // length with null tag, -1 means variable length
+    int length;
+    // position in views, empty means the column is skipped
+    std::vector<int> slots;
+  };
+
+  void Init(int schema_version, std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas, long common_id,
+            const std::vector<int>& column_indexes);
+  static void BuildSteps(const std::vector<std::shared_ptr<BaseSchema>>& schemas,
+                         const std::vector<std::vector<int>>& column_slots, bool is_key, std::vector<Step>& steps);
+
+  int DecodeKey(std::string_view key, std::vector<ColumnView>& views, std::vector<std::string>& key_strings);
+  int DecodeValue(std::string_view value, std::vector<ColumnView>& views);
+
+  int codec_version_ = 1;
+  int schema_version_;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas_;
+  long common_id_;
+  bool le_;
+
+  std::vector<int> column_indexes_;
+  std::vector<Step> key_steps_;
+  std::vector<Step> value_steps_;
+  // unescaped key strings of the projected columns, reused for every record
+  std::vector<std::string> key_strings_;
+  std::vector<ColumnView> views_;
+};
+
+}  // namespace dingodb
+
+#endif
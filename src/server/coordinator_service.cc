@@ -612,7 +612,13 @@ void DoStoreHeartbeat(google::protobuf::RpcController * /*controller*/,
 
   // update store metrics
   if (request->has_store_metrics()) {
-    coordinator_control->UpdateStoreMetrics(request->store_metrics(), meta_increment);
+    int64_t acked_region_metrics_version = 0;
+    coordinator_control->UpdateStoreMetrics(request->store_metrics(), meta_increment, acked_region_metrics_version);
+    if (acked_region_metrics_version > 0) {
+      response->set_acked_region_metrics_version(acked_region_metrics_version);
+    } else if (request->store_metrics().is_delta_region_metrics()) {
+      response->set_need_full_region_metrics(true);
+    }
 
     // update is_read_only
     auto is_read_only_from_store = request->store_metrics().store_own_metrics().is_ready_only();
@@ -621,6 +627,13 @@ void DoStoreHeartbeat(google::protobuf::RpcController * /*controller*/,
     }
   }
 
+  // response gc safe point
+  int64_t gc_safe_point = 0;
+  bool gc_stop = false;
+  coordinator_control->GetGCSafePoint(gc_safe_point, gc_stop);
+  response->set_gc_safe_point(gc_safe_point);
+  response->set_gc_stop(gc_stop);
+
   // response cluster state
   auto is_read_only = Server::GetInstance().IsReadOnly();
   if (is_read_only || FLAGS_force_cluster_read_only) {
@@ -14,9 +14,12 @@
 
 #include "server/file_service.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
+#include "common/file_transfer.h"
+#include "common/helper.h"
 #include "fmt/core.h"
 #include "server/service_helper.h"
 
@@ -64,6 +67,55 @@ void FileServiceImpl::GetFile(google::protobuf::RpcController* controller,
   cntl->response_attachment().swap(buf);
 }
 
+void FileServiceImpl::GetFileStream(google::protobuf::RpcController* controller,
+                                    const pb::fileservice::GetFileStreamRequest* request,
+                                    pb::fileservice::GetFileStreamResponse* response,
+                                    google::protobuf::Closure* done) {
+  auto* svr_done = new NoContextServiceClosure(__func__, done, request, response);
+  brpc::Controller* cntl = (brpc::Controller*)controller;
+  brpc::ClosureGuard done_guard(svr_done);
+
+  DINGO_LOG(INFO) << fmt::format("Send file stream to {} request {}", butil::endpoint2str(cntl->remote_side()).c_str(),
+                                 request->ShortDebugString());
+
+  auto reader = FileServiceReaderManager::GetInstance().GetReader(request->reader_id());
+  if (reader == nullptr) {
+    cntl->SetFailed(pb::error::EFILE_NOT_FOUND_READER, "Not found reader %lu", request->reader_id());
+    return;
+  }
+
+  std::string filepath = fmt::format("{}/{}", reader->Path(), request->filename());
+  int64_t file_size = Helper::GetFileSize(filepath);
+  if (file_size < 0 || request->offset() < 0 || request->offset() > file_size) {
+    cntl->SetFailed(pb::error::EILLEGAL_PARAMTETERS, "Invalid request %s file size %ld",
+                    request->ShortDebugString().c_str(), file_size);
+    return;
+  }
+
+  // the chunk is read into memory at once, and its size is uint32 in chunk header
+  if (request->chunk_size() <= 0) {
+    cntl->SetFailed(pb::error::EILLEGAL_PARAMTETERS, "Invalid chunk size %ld", request->chunk_size());
+    return;
+  }
+  int64_t chunk_size = std::min(request->chunk_size(), FLAGS_file_stream_max_chunk_size);
+
+  brpc::StreamId stream_id;
+  auto options = FileStreamSender::StreamOptions();
+  if (brpc::StreamAccept(&stream_id, *cntl, &options) != 0) {
+    cntl->SetFailed(pb::error::EFILE_STREAM, "Accept stream failed");
+    return;
+  }
+
+  response->set_file_size(file_size);
+
+  int64_t offset = request->offset();
+
+  // Stream is available after response sent.
+  done_guard.release()->Run();
+
+  FileStreamSender::AsyncSend(stream_id, filepath, offset, chunk_size);
+}
+
 void FileServiceImpl::CleanFileReader(google::protobuf::RpcController* controller,
                                       const pb::fileservice::CleanFileReaderRequest* request,
                                       pb::fileservice::CleanFileReaderResponse* response,
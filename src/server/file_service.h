@@ -38,6 +38,9 @@ class FileServiceImpl : public pb::fileservice::FileService {
   void GetFile(google::protobuf::RpcController* controller, const pb::fileservice::GetFileRequest* request,
                pb::fileservice::GetFileResponse* response, google::protobuf::Closure* done) override;
 
+  void GetFileStream(google::protobuf::RpcController* controller, const pb::fileservice::GetFileStreamRequest* request,
+                     pb::fileservice::GetFileStreamResponse* response, google::protobuf::Closure* done) override;
+
   void CleanFileReader(google::protobuf::RpcController* controller,
                        const pb::fileservice::CleanFileReaderRequest* request,
                        pb::fileservice::CleanFileReaderResponse* response, google::protobuf::Closure* done) override;
@@ -14,10 +14,13 @@
 
 #include "server/index_service.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <set>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "butil/status.h"
@@ -28,6 +31,7 @@
 #include "common/synchronization.h"
 #include "common/version.h"
 #include "engine/storage.h"
+#include "engine/txn_lock_wait_manager.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
 #include "meta/store_meta_manager.h"
@@ -39,6 +43,7 @@
 #include "server/server.h"
 #include "server/service_helper.h"
 #include "vector/codec.h"
+#include "vector/vector_index_utils.h"
 
 using dingodb::pb::error::Errno;
 
@@ -49,6 +54,8 @@ DEFINE_int64(vector_max_request_size, 8388608, "vector max batch count in one re
 DEFINE_bool(enable_async_vector_search, true, "enable async vector search");
 DEFINE_bool(enable_async_vector_count, true, "enable async vector count");
 DEFINE_bool(enable_async_vector_operation, true, "enable async vector operation");
+DEFINE_int32(vector_multi_region_search_max_region_count, 256, "max region count in one multi region search request");
+DEFINE_int32(vector_multi_region_search_parallel_num, 16, "parallel region num of multi region search");
 
 static void IndexRpcDone(BthreadCond* cond) { cond->DecreaseSignal(); }
 
@@ -292,6 +299,217 @@ void IndexServiceImpl::VectorSearch(google::protobuf::RpcController* controller,
   }
 }
 
+static butil::Status ValidateVectorMultiRegionSearchRequest(
+    const pb::index::VectorMultiRegionSearchRequest* request) {
+  if (request->index_id() <= 0) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param index_id is error");
+  }
+
+  if (request->contexts().empty()) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param contexts is empty");
+  }
+
+  if (request->contexts_size() > FLAGS_vector_multi_region_search_max_region_count) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS,
+                         fmt::format("Param contexts size {} is exceed max region count {}", request->contexts_size(),
+                                     FLAGS_vector_multi_region_search_max_region_count));
+  }
+
+  std::set<int64_t> region_ids;
+  for (const auto& context : request->contexts()) {
+    if (context.region_id() == 0) {
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param region_id is error");
+    }
+    if (!region_ids.insert(context.region_id()).second) {
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS,
+                           fmt::format("Param region_id {} is duplicated", context.region_id()));
+    }
+  }
+
+  if (request->parameter().top_n() < 0) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param top_n is error");
+  }
+
+  if (request->parameter().top_n() > FLAGS_vector_max_batch_count) {
+    return butil::Status(pb::error::EVECTOR_EXCEED_MAX_BATCH_COUNT,
+                         fmt::format("Param top_n {} is exceed max batch count {}", request->parameter().top_n(),
+                                     FLAGS_vector_max_batch_count));
+  }
+
+  // Same as VectorSearch, limit the size of merged response.
+  if (request->parameter().top_n() * request->vector_with_ids_size() > FLAGS_vector_max_batch_count * 10) {
+    return butil::Status(pb::error::EVECTOR_EXCEED_MAX_BATCH_COUNT,
+                         fmt::format("Param top_n {} is exceed max batch count {}", request->parameter().top_n(),
+                                     FLAGS_vector_max_batch_count));
+  }
+
+  if (request->vector_with_ids().empty()) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param vector_with_ids is empty");
+  }
+
+  // Query by vector id only hit one region, use VectorSearch instead.
+  for (const auto& vector_with_id : request->vector_with_ids()) {
+    if (vector_with_id.id() > 0) {
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "Param vector_with_ids not support query by vector id");
+    }
+  }
+
+  return butil::Status();
+}
+
+static butil::Status ValidateVectorSearchRegion(StoragePtr storage, const pb::store::Context& context,
+                                                store::RegionPtr region, int64_t index_id) {
+  if (region == nullptr) {
+    return butil::Status(
+        pb::error::EREGION_NOT_FOUND,
+        fmt::format("Not found region {} at server {}", context.region_id(), Server::GetInstance().Id()));
+  }
+
+  auto status = ServiceHelper::ValidateRegionEpoch(context.region_epoch(), region);
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (region->Definition().index_id() != index_id) {
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS,
+                         fmt::format("Region {} not belong to index {}", region->Id(), index_id));
+  }
+
+  status = storage->ValidateLeader(region->Id());
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (!region->VectorIndexWrapper()->IsReady()) {
+    if (region->VectorIndexWrapper()->IsBuildError()) {
+      return butil::Status(pb::error::EVECTOR_INDEX_BUILD_ERROR,
+                           fmt::format("Vector index {} build error, please wait for recover.", region->Id()));
+    }
+    return butil::Status(pb::error::EVECTOR_INDEX_NOT_READY,
+                         fmt::format("Vector index {} not ready, please retry.", region->Id()));
+  }
+
+  return ServiceHelper::ValidateIndexRegion(region, {});
+}
+
+static butil::Status VectorSearchRegion(StoragePtr storage, const pb::index::VectorMultiRegionSearchRequest* request,
+                                        store::RegionPtr region,
+                                        std::vector<pb::index::VectorWithDistanceResult>& vector_results) {
+  auto ctx = std::make_shared<Engine::VectorReader::Context>();
+  ctx->partition_id = region->PartitionId();
+  ctx->region_id = region->Id();
+  ctx->vector_index = region->VectorIndexWrapper();
+  ctx->region_range = region->Range();
+  ctx->parameter = request->parameter();
+  ctx->raw_engine_type = region->GetRawEngineType();
+  for (const auto& vector : request->vector_with_ids()) {
+    ctx->vector_with_ids.push_back(vector);
+  }
+
+  return storage->VectorBatchSearch(ctx, vector_results);
+}
+
+void DoVectorMultiRegionSearch(StoragePtr storage, google::protobuf::RpcController* controller,
+                               const pb::index::VectorMultiRegionSearchRequest* request,
+                               pb::index::VectorMultiRegionSearchResponse* response, google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+
+  butil::Status status = ValidateVectorMultiRegionSearchRequest(request);
+  if (!status.ok()) {
+    ServiceHelper::SetError(response->mutable_error(), status.error_code(), status.error_str());
+    return;
+  }
+
+  struct RegionSearchResult {
+    store::RegionPtr region;
+    butil::Status status;
+    std::vector<pb::index::VectorWithDistanceResult> vector_results;
+  };
+
+  // All regions must belong to the index of request, others are rejected as region error.
+  int64_t index_id = request->index_id();
+  std::vector<RegionSearchResult> region_results(request->contexts_size());
+  for (int i = 0; i < request->contexts_size(); ++i) {
+    region_results[i].region = Server::GetInstance().GetRegion(request->contexts(i).region_id());
+  }
+
+  // Search regions concurrently, every region write its own result slot.
+  BthreadCond cond;
+  for (int i = 0; i < request->contexts_size(); ++i) {
+    cond.IncreaseWait(std::max(1, FLAGS_vector_multi_region_search_parallel_num));
+
+    Bthread bth(&BTHREAD_ATTR_NORMAL);
+    bth.Run([&, i]() {
+      auto& region_result = region_results[i];
+      region_result.status = ValidateVectorSearchRegion(storage, request->contexts(i), region_result.region, index_id);
+      if (region_result.status.ok()) {
+        region_result.status = VectorSearchRegion(storage, request, region_result.region, region_result.vector_results);
+      }
+
+      cond.DecreaseSignal();
+    });
+  }
+  cond.Wait();
+
+  int success_count = 0;
+  for (int i = 0; i < request->contexts_size(); ++i) {
+    auto& region_result = region_results[i];
+    if (region_result.status.ok()) {
+      ++success_count;
+      continue;
+    }
+
+    auto* region_error = response->add_region_errors();
+    region_error->set_region_id(request->contexts(i).region_id());
+    ServiceHelper::SetError(region_error->mutable_error(), region_result.status.error_code(),
+                            region_result.status.error_str());
+    if (region_result.region != nullptr) {
+      ServiceHelper::GetStoreRegionInfo(region_result.region, region_error->mutable_error());
+    }
+  }
+
+  if (success_count == 0) {
+    *response->mutable_error() = response->region_errors(0).error();
+    return;
+  }
+
+  // Merge every query result of all regions, keep global topk by ascending distance.
+  std::vector<std::vector<pb::index::VectorWithDistanceResult>> success_results;
+  for (auto& region_result : region_results) {
+    if (region_result.status.ok()) {
+      success_results.push_back(std::move(region_result.vector_results));
+    }
+  }
+
+  std::vector<pb::index::VectorWithDistanceResult> merged_results;
+  VectorIndexUtils::MergeSearchResult(success_results, request->vector_with_ids_size(), request->parameter().top_n(),
+                                      merged_results);
+  for (auto& merged_result : merged_results) {
+    response->add_batch_results()->Swap(&merged_result);
+  }
+}
+
+void IndexServiceImpl::VectorMultiRegionSearch(google::protobuf::RpcController* controller,
+                                               const pb::index::VectorMultiRegionSearchRequest* request,
+                                               pb::index::VectorMultiRegionSearchResponse* response,
+                                               google::protobuf::Closure* done) {
+  auto* svr_done = new ServiceClosure(__func__, done, request, response);
+
+  if (!FLAGS_enable_async_vector_search) {
+    return DoVectorMultiRegionSearch(storage_, controller, request, response, svr_done);
+  }
+
+  // Run in queue.
+  StoragePtr storage = storage_;
+  auto task = std::make_shared<ServiceTask>(
+      [=]() { DoVectorMultiRegionSearch(storage, controller, request, response, svr_done); });
+  bool ret = read_worker_set_->ExecuteRR(task);
+  if (!ret) {
+    brpc::ClosureGuard done_guard(svr_done);
+    ServiceHelper::SetError(response->mutable_error(), pb::error::EREQUEST_FULL, "Commit execute queue failed");
+  }
+}
+
 static butil::Status ValidateVectorAddRequest(StoragePtr storage, const pb::index::VectorAddRequest* request,
                                               store::RegionPtr region) {
   auto status = ServiceHelper::ValidateRegionEpoch(request->context().region_epoch(), region);
@@ -356,7 +574,8 @@ static butil::Status ValidateVectorAddRequest(StoragePtr storage, const pb::inde
         vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_FLAT ||
         vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_BRUTEFORCE ||
         vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_FLAT ||
-        vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_PQ) {
+        vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_PQ ||
+        vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_DISKANN) {
       if (vector.vector().float_values().size() != dimension) {
         return butil::Status(
             pb::error::EILLEGAL_PARAMTETERS,
@@ -406,6 +625,7 @@ void DoVectorAdd(StoragePtr storage, google::protobuf::RpcController* controller
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -502,6 +722,7 @@ void DoVectorDelete(StoragePtr storage, google::protobuf::RpcController* control
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1096,6 +1317,7 @@ void DoTxnGetVector(StoragePtr storage, google::protobuf::RpcController* control
   }
 
   auto ctx = std::make_shared<Context>();
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1213,6 +1435,7 @@ void DoTxnScanVector(StoragePtr storage, google::protobuf::RpcController* contro
   }
 
   auto ctx = std::make_shared<Context>();
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1281,7 +1504,8 @@ butil::Status ValidateTxnPessimisticLockRequest(const dingodb::pb::store::TxnPes
 void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* controller,
                           const dingodb::pb::store::TxnPessimisticLockRequest* request,
                           dingodb::pb::store::TxnPessimisticLockResponse* response, google::protobuf::Closure* done,
-                          bool is_sync);
+                          WorkerSetPtr worker_set, int64_t wait_deadline_ms, bool is_sync,
+                          const std::string& woken_key);
 
 void IndexServiceImpl::TxnPessimisticLock(google::protobuf::RpcController* controller,
                                           const pb::store::TxnPessimisticLockRequest* request,
@@ -1291,8 +1515,11 @@ void IndexServiceImpl::TxnPessimisticLock(google::protobuf::RpcController* contr
 
   // Run in queue.
   StoragePtr storage = storage_;
-  auto task = std::make_shared<ServiceTask>(
-      [=]() { DoTxnPessimisticLock(storage, controller, request, response, svr_done, true); });
+  WorkerSetPtr worker_set = write_worker_set_;
+  int64_t wait_deadline_ms = Helper::TimestampMs() + FLAGS_txn_pessimistic_lock_wait_timeout_ms;
+  auto task = std::make_shared<ServiceTask>([=]() {
+    DoTxnPessimisticLock(storage, controller, request, response, svr_done, worker_set, wait_deadline_ms, true, "");
+  });
   bool ret = write_worker_set_->ExecuteHashByRegionId(request->context().region_id(), task);
   if (!ret) {
     brpc::ClosureGuard done_guard(svr_done);
@@ -1426,7 +1653,8 @@ static butil::Status ValidateTxnPrewriteRequest(StoragePtr storage, const pb::st
           vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_FLAT ||
           vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_BRUTEFORCE ||
           vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_FLAT ||
-          vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_PQ) {
+          vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_IVF_PQ ||
+          vector_index_wrapper->Type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_DISKANN) {
         if (vector.vector().float_values().size() != dimension) {
           return butil::Status(
               pb::error::EILLEGAL_PARAMTETERS,
@@ -1481,6 +1709,7 @@ void DoTxnPrewriteVector(StoragePtr storage, google::protobuf::RpcController* co
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1513,10 +1742,14 @@ void DoTxnPrewriteVector(StoragePtr storage, google::protobuf::RpcController* co
   for (const auto& pessimistic_check : request->pessimistic_checks()) {
     pessimistic_checks.push_back(pessimistic_check);
   }
+
+  std::vector<std::string> secondaries(request->secondaries().begin(), request->secondaries().end());
+
   std::vector<pb::common::KeyValue> kvs;
   status = storage->TxnPrewrite(ctx, mutations, request->primary_lock(), request->start_ts(), request->lock_ttl(),
                                 request->txn_size(), request->try_one_pc(), request->max_commit_ts(),
-                                pessimistic_checks, for_update_ts_checks, lock_extra_datas);
+                                pessimistic_checks, for_update_ts_checks, lock_extra_datas, request->use_async_commit(),
+                                secondaries);
 
   if (!status.ok()) {
     ServiceHelper::SetError(response->mutable_error(), status.error_code(), status.error_str());
@@ -1856,6 +2089,7 @@ void DoTxnBatchGetVector(StoragePtr storage, google::protobuf::RpcController* co
   }
 
   auto ctx = std::make_shared<Context>();
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(request->context().region_id());
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
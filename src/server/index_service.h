@@ -34,6 +34,10 @@ class IndexServiceImpl : public pb::index::IndexService {
                         pb::index::VectorBatchQueryResponse* response, google::protobuf::Closure* done) override;
   void VectorSearch(google::protobuf::RpcController* controller, const pb::index::VectorSearchRequest* request,
                     pb::index::VectorSearchResponse* response, google::protobuf::Closure* done) override;
+  void VectorMultiRegionSearch(google::protobuf::RpcController* controller,
+                               const pb::index::VectorMultiRegionSearchRequest* request,
+                               pb::index::VectorMultiRegionSearchResponse* response,
+                               google::protobuf::Closure* done) override;
   void VectorGetBorderId(google::protobuf::RpcController* controller,
                          const pb::index::VectorGetBorderIdRequest* request,
                          pb::index::VectorGetBorderIdResponse* response, google::protobuf::Closure* done) override;
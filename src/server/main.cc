@@ -78,6 +78,8 @@ DEFINE_int32(read_worker_num, 10, "read service worker num");
 DEFINE_int32(write_worker_num, 10, "write service worker num");
 DEFINE_int64(read_worker_max_pending_num, 0, "read service worker num");
 DEFINE_int64(write_worker_max_pending_num, 0, "write service worker num");
+DEFINE_bool(use_work_stealing_worker, false,
+            "read/write service worker use work stealing, write tasks of one region keep submit order");
 
 DEFINE_int32(coordinator_service_worker_num, 10, "service worker num");
 DEFINE_int64(coordinator_service_worker_max_pending_num, 0, "service worker num");
@@ -936,7 +938,8 @@ int main(int argc, char *argv[]) {
     }
 
     dingodb::WorkerSetPtr read_worker_set =
-        dingodb::WorkerSet::New("ReadWorkerSet", FLAGS_read_worker_num, FLAGS_read_worker_max_pending_num);
+        dingodb::WorkerSet::New("ReadWorkerSet", FLAGS_read_worker_num, FLAGS_read_worker_max_pending_num,
+                                FLAGS_use_work_stealing_worker);
     if (!read_worker_set->Init()) {
       DINGO_LOG(ERROR) << "Init ReadWorkerSet failed!";
       return -1;
@@ -944,7 +947,8 @@ int main(int argc, char *argv[]) {
     store_service.SetReadWorkSet(read_worker_set);
 
     dingodb::WorkerSetPtr write_worker_set =
-        dingodb::WorkerSet::New("WriteWorkerSet", FLAGS_write_worker_num, FLAGS_write_worker_max_pending_num);
+        dingodb::WorkerSet::New("WriteWorkerSet", FLAGS_write_worker_num, FLAGS_write_worker_max_pending_num,
+                                FLAGS_use_work_stealing_worker);
     if (!write_worker_set->Init()) {
       DINGO_LOG(ERROR) << "Init WriteWorkerSet failed!";
       return -1;
@@ -955,6 +959,10 @@ int main(int argc, char *argv[]) {
       DINGO_LOG(ERROR) << "InitCoordinatorInteraction failed!";
       return -1;
     }
+    if (!dingo_server.InitCoordinatorInteractionForMeta()) {
+      DINGO_LOG(ERROR) << "InitCoordinatorInteractionForMeta failed!";
+      return -1;
+    }
     if (!dingo_server.ValiateCoordinator()) {
       DINGO_LOG(ERROR) << "ValiateCoordinator failed!";
       return -1;
@@ -1031,7 +1039,8 @@ int main(int argc, char *argv[]) {
     }
 
     dingodb::WorkerSetPtr read_worker_set =
-        dingodb::WorkerSet::New("ReadWorkerSet", FLAGS_read_worker_num, FLAGS_read_worker_max_pending_num);
+        dingodb::WorkerSet::New("ReadWorkerSet", FLAGS_read_worker_num, FLAGS_read_worker_max_pending_num,
+                                FLAGS_use_work_stealing_worker);
     if (!read_worker_set->Init()) {
       DINGO_LOG(ERROR) << "Init ReadWorkerSet failed!";
       return -1;
@@ -1040,7 +1049,8 @@ int main(int argc, char *argv[]) {
     util_service.SetReadWorkSet(read_worker_set);
 
     dingodb::WorkerSetPtr write_worker_set =
-        dingodb::WorkerSet::New("WriteWorkerSet", FLAGS_write_worker_num, FLAGS_write_worker_max_pending_num);
+        dingodb::WorkerSet::New("WriteWorkerSet", FLAGS_write_worker_num, FLAGS_write_worker_max_pending_num,
+                                FLAGS_use_work_stealing_worker);
     if (!write_worker_set->Init()) {
       DINGO_LOG(ERROR) << "Init WriteWorkerSet failed!";
       return -1;
@@ -1051,6 +1061,10 @@ int main(int argc, char *argv[]) {
       DINGO_LOG(ERROR) << "InitCoordinatorInteraction failed!";
       return -1;
     }
+    if (!dingo_server.InitCoordinatorInteractionForMeta()) {
+      DINGO_LOG(ERROR) << "InitCoordinatorInteractionForMeta failed!";
+      return -1;
+    }
     if (!dingo_server.ValiateCoordinator()) {
       DINGO_LOG(ERROR) << "ValiateCoordinator failed!";
       return -1;
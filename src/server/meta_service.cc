@@ -40,6 +40,7 @@ namespace dingodb {
 DECLARE_int64(max_hnsw_memory_size_of_region);
 DECLARE_int32(max_hnsw_nlinks_of_region);
 DECLARE_int64(max_partition_num_of_table);
+DECLARE_int64(auto_increment_segment_size);
 
 DEFINE_int32(max_check_region_state_count, 600, "max check region state count");
 DEFINE_int32(max_table_definition_count_in_create_tables, 100, "max table definition count in create tables");
@@ -844,6 +845,28 @@ void DoGenerateAutoIncrement(google::protobuf::RpcController *controller,
   DINGO_LOG(INFO) << request->ShortDebugString();
 
   int64_t table_id = request->table_id().entity_id();
+  if (FLAGS_auto_increment_segment_size > 0) {
+    int64_t start_id = 0;
+    int64_t end_id = 0;
+    auto ret = auto_increment_control->GenerateAutoIncrementFromSegment(
+        table_id, request->count(), request->auto_increment_increment(), request->auto_increment_offset(), start_id,
+        end_id);
+    if (!ret.ok()) {
+      DINGO_LOG(ERROR) << "generate auto increment from segment failed, " << ret << " | "
+                       << request->ShortDebugString();
+      ServiceHelper::SetError(response->mutable_error(), ret.error_code(), ret.error_str());
+
+      if (ret.error_code() == pb::error::Errno::ERAFT_NOTLEADER) {
+        auto_increment_control->RedirectResponse(response);
+      }
+      return;
+    }
+
+    response->set_start_id(start_id);
+    response->set_end_id(end_id);
+    return;
+  }
+
   pb::coordinator_internal::MetaIncrement meta_increment;
   auto ret =
       auto_increment_control->GenerateAutoIncrement(table_id, request->count(), request->auto_increment_increment(),
@@ -345,6 +345,18 @@ bool Server::InitCoordinatorInteractionForAutoIncrement() {
   }
 }
 
+bool Server::InitCoordinatorInteractionForMeta() {
+  coordinator_interaction_meta_ = std::make_shared<CoordinatorInteraction>();
+
+  if (!FLAGS_coor_url.empty()) {
+    return coordinator_interaction_meta_->InitByNameService(FLAGS_coor_url,
+                                                            pb::common::CoordinatorServiceType::ServiceTypeMeta);
+  } else {
+    DINGO_LOG(ERROR) << "FLAGS_coor_url is empty";
+    return false;
+  }
+}
+
 bool Server::InitLogStorageManager() {
   log_storage_ = std::make_shared<LogStorageManager>();
   return true;
@@ -518,6 +530,15 @@ bool Server::InitCrontabManager() {
       [](void*) { Heartbeat::TriggerCompactionTask(nullptr); },
   });
 
+  // Add balance schedule crontab
+  crontab_configs_.push_back({
+      "BALANCE_SCHEDULE",
+      {pb::common::COORDINATOR},
+      GetInterval(config, "coordinator.balance_schedule_interval_s", Constant::kBalanceScheduleIntervalS) * 1000,
+      false,
+      [](void*) { Heartbeat::TriggerBalanceSchedule(nullptr); },
+  });
+
   // Add scrub vector index crontab
   crontab_configs_.push_back({
       "SCRUB_VECTOR_INDEX",
@@ -527,6 +548,21 @@ bool Server::InitCrontabManager() {
       [](void*) { Heartbeat::TriggerScrubVectorIndex(nullptr); },
   });
 
+  // Add rocksdb range gc crontab
+  crontab_configs_.push_back({
+      "ROCKS_RANGE_GC",
+      {pb::common::STORE, pb::common::INDEX},
+      GetInterval(config, "store.range_gc_interval_s", Constant::kRocksRangeGcIntervalS) * 1000,
+      true,
+      [](void*) {
+        auto raw_engine = std::dynamic_pointer_cast<RawRocksEngine>(
+            Server::GetInstance().GetRawEngine(pb::common::RawEngine::RAW_ENG_ROCKSDB));
+        if (raw_engine != nullptr) {
+          raw_engine->RunRangeGc();
+        }
+      },
+  });
+
   auto raft_store_engine = GetRaftStoreEngine();
   if (raft_store_engine != nullptr) {
     // Add raft snapshot controller crontab
@@ -681,6 +717,11 @@ std::shared_ptr<CoordinatorInteraction> Server::GetCoordinatorInteractionIncr()
   return coordinator_interaction_incr_;
 }
 
+std::shared_ptr<CoordinatorInteraction> Server::GetCoordinatorInteractionMeta() {
+  assert(coordinator_interaction_meta_ != nullptr);
+  return coordinator_interaction_meta_;
+}
+
 std::shared_ptr<Engine> Server::GetEngine() {
   assert(raft_engine_ != nullptr);
   return raft_engine_;
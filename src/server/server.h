@@ -70,6 +70,7 @@ class Server {
   // Init coordinator interaction
   bool InitCoordinatorInteraction();
   bool InitCoordinatorInteractionForAutoIncrement();
+  bool InitCoordinatorInteractionForMeta();
 
   // Init log Storage manager.
   bool InitLogStorageManager();
@@ -128,6 +129,7 @@ class Server {
 
   std::shared_ptr<CoordinatorInteraction> GetCoordinatorInteraction();
   std::shared_ptr<CoordinatorInteraction> GetCoordinatorInteractionIncr();
+  std::shared_ptr<CoordinatorInteraction> GetCoordinatorInteractionMeta();
 
   std::shared_ptr<Engine> GetEngine();
   std::shared_ptr<RawEngine> GetRawEngine(pb::common::RawEngine type);
@@ -212,6 +214,7 @@ class Server {
   // coordinator interaction
   std::shared_ptr<CoordinatorInteraction> coordinator_interaction_;
   std::shared_ptr<CoordinatorInteraction> coordinator_interaction_incr_;
+  std::shared_ptr<CoordinatorInteraction> coordinator_interaction_meta_;
 
   // All store engine, include MemEngine/RaftStoreEngine/RocksEngine
   std::shared_ptr<Engine> raft_engine_;
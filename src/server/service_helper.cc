@@ -216,4 +216,28 @@ butil::Status ServiceHelper::ValidateClusterReadOnly() {
   return butil::Status();
 }
 
+void ServiceHelper::BindTracker(std::shared_ptr<Context> ctx, google::protobuf::Closure* done) {
+  auto* track_closure = dynamic_cast<TrackClosure*>(done);
+  if (track_closure == nullptr || track_closure->Tracker() == nullptr) {
+    return;
+  }
+
+  track_closure->Tracker()->SetRunTime();
+  ctx->SetTracker(track_closure->Tracker());
+}
+
+void TrackClosure::FinishTrack(google::protobuf::Message* response, int64_t elapsed_time_ns) {
+  pb::common::TimeInfo time_info;
+  time_info.set_total_rpc_time_ns(elapsed_time_ns);
+
+  if (tracker_ != nullptr) {
+    tracker_->Finish();
+    if (FLAGS_enable_tracker_response) {
+      tracker_->FillTimeInfo(time_info);
+    }
+  }
+
+  Helper::SetPbMessageResponseInfo(response, time_info);
+}
+
 }  // namespace dingodb
\ No newline at end of file
@@ -18,12 +18,16 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include "butil/compiler_specific.h"
 #include "butil/endpoint.h"
 #include "common/constant.h"
+#include "common/context.h"
 #include "common/helper.h"
 #include "common/logging.h"
+#include "common/tracker.h"
 #include "fmt/core.h"
 #include "meta/store_meta_manager.h"
 #include "proto/error.pb.h"
@@ -34,6 +38,7 @@ namespace dingodb {
 
 DECLARE_int64(service_helper_store_min_log_elapse);
 DECLARE_int64(service_helper_coordinator_min_log_elapse);
+DECLARE_bool(enable_tracker_response);
 
 class ServiceHelper {
  public:
@@ -55,6 +60,9 @@ class ServiceHelper {
   static butil::Status ValidateRegion(store::RegionPtr region, const std::vector<std::string_view>& keys);
   static butil::Status ValidateIndexRegion(store::RegionPtr region, const std::vector<int64_t>& vector_ids);
   static butil::Status ValidateClusterReadOnly();
+
+  // Bind the tracker of service closure to ctx, the request starts to run.
+  static void BindTracker(std::shared_ptr<Context> ctx, google::protobuf::Closure* done);
 };
 
 template <typename T>
@@ -109,12 +117,39 @@ class ServiceTask : public TaskRunnable {
   Handler handle_;
 };
 
+// Service closure with the tracker of request, only sampled request has tracker.
+class TrackClosure : public google::protobuf::Closure {
+ public:
+  TrackClosure(const std::string& method_name, int64_t start_time_ns)
+      : tracker_(Tracker::New(method_name, start_time_ns)) {}
+  ~TrackClosure() override = default;
+
+  TrackerPtr Tracker() { return tracker_; }
+
+ protected:
+  // Finish tracker and set response info of response.
+  void FinishTrack(google::protobuf::Message* response, int64_t elapsed_time_ns);
+
+  TrackerPtr tracker_;
+};
+
+// Whether the request carry a single region context, i.e. has context() method.
+template <typename T, typename = void>
+struct HasRegionContext : std::false_type {};
+
+template <typename T>
+struct HasRegionContext<T, std::void_t<decltype(std::declval<const T&>().context())>> : std::true_type {};
+
 // Wrapper brpc service closure for log.
 template <typename T, typename U>
-class ServiceClosure : public google::protobuf::Closure {
+class ServiceClosure : public TrackClosure {
  public:
   ServiceClosure(const std::string& method_name, google::protobuf::Closure* done, const T* request, U* response)
-      : method_name_(method_name), done_(done), request_(request), response_(response) {
+      : TrackClosure(method_name, Helper::TimestampNs()),
+        method_name_(method_name),
+        done_(done),
+        request_(request),
+        response_(response) {
     start_time_ = Helper::TimestampNs();
     DINGO_LOG(DEBUG) << fmt::format("[service.{}] Receive request: {}", method_name_,
                                     request_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength));
@@ -141,46 +176,16 @@ void ServiceClosure<T, U>::Run() {
 
   if (response_->error().errcode() != 0) {
     // Set leader redirect info(pb.Error.leader_location).
-    if (response_->error().errcode() == pb::error::ERAFT_NOTLEADER) {
-      ServiceHelper::RedirectLeader(response_->error().errmsg(), response_);
-      response_->mutable_error()->set_errmsg(fmt::format("Not leader({}) on region {}, please redirect leader({}).",
-                                                         Server::GetInstance().ServerAddr(),
-                                                         request_->context().region_id(), response_->error().errmsg()));
-    }
-
-    DINGO_LOG(ERROR) << fmt::format(
-        "[service.{}][request_id({})][elapsed(ns)({})] Request failed, response: {} request: {}", method_name_,
-        request_->request_info().request_id(), elapsed_time,
-        response_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength),
-        request_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength));
-  } else {
-    if (BAIDU_UNLIKELY(elapsed_time >= FLAGS_service_helper_store_min_log_elapse)) {
-      DINGO_LOG(INFO) << fmt::format(
-          "[service.{}][request_id({})][elapsed(ns)({})] Request finish, response: {} request: {}", method_name_,
-          request_->request_info().request_id(), elapsed_time,
-          response_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength),
-          request_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength));
-    } else {
-      DINGO_LOG(DEBUG) << fmt::format(
-          "[service.{}][request_id({})][elapsed(ns)({})] Request finish, response: {} request: {}", method_name_,
-          request_->request_info().request_id(), elapsed_time,
-          response_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength),
-          request_->ShortDebugString().substr(0, Constant::kLogPrintMaxLength));
+    // Request without region context(e.g. VectorCalcDistance, VectorMultiRegionSearch) never redirect leader.
+    if constexpr (HasRegionContext<T>::value) {
+      if (response_->error().errcode() == pb::error::ERAFT_NOTLEADER) {
+        ServiceHelper::RedirectLeader(response_->error().errmsg(), response_);
+        response_->mutable_error()->set_errmsg(
+            fmt::format("Not leader({}) on region {}, please redirect leader({}).", Server::GetInstance().ServerAddr(),
+                        request_->context().region_id(), response_->error().errmsg()));
+      }
     }
-  }
-
-  Helper::SetPbMessageResponseInfo(response_, elapsed_time);
-}
 
-template <>
-inline void ServiceClosure<pb::index::VectorCalcDistanceRequest, pb::index::VectorCalcDistanceResponse>::Run() {
-  std::unique_ptr<ServiceClosure<pb::index::VectorCalcDistanceRequest, pb::index::VectorCalcDistanceResponse>>
-      self_guard(this);
-  brpc::ClosureGuard done_guard(done_);
-
-  uint64_t elapsed_time = Helper::TimestampNs() - start_time_;
-
-  if (response_->error().errcode() != 0) {
     DINGO_LOG(ERROR) << fmt::format(
         "[service.{}][request_id({})][elapsed(ns)({})] Request failed, response: {} request: {}", method_name_,
         request_->request_info().request_id(), elapsed_time,
@@ -202,7 +207,7 @@ inline void ServiceClosure<pb::index::VectorCalcDistanceRequest, pb::index::Vect
     }
   }
 
-  Helper::SetPbMessageResponseInfo(response_, elapsed_time);
+  FinishTrack(response_, elapsed_time);
 }
 
 // Wrapper brpc service closure for log.
@@ -14,8 +14,10 @@
 
 #include "server/store_service.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -28,6 +30,7 @@
 #include "common/logging.h"
 #include "common/synchronization.h"
 #include "common/version.h"
+#include "engine/txn_lock_wait_manager.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
 #include "meta/store_meta_manager.h"
@@ -90,6 +93,7 @@ void DoKvGet(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -178,6 +182,7 @@ void DoKvBatchGet(StoragePtr storage, google::protobuf::RpcController* controlle
   }
 
   auto ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -265,6 +270,7 @@ void DoKvPut(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -349,6 +355,7 @@ void DoKvBatchPut(StoragePtr storage, google::protobuf::RpcController* controlle
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -432,6 +439,7 @@ void DoKvPutIfAbsent(StoragePtr storage, google::protobuf::RpcController* contro
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -523,6 +531,7 @@ void DoKvBatchPutIfAbsent(StoragePtr storage, google::protobuf::RpcController* c
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -613,6 +622,7 @@ void DoKvBatchDelete(StoragePtr storage, google::protobuf::RpcController* contro
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -699,6 +709,7 @@ void DoKvDeleteRange(StoragePtr storage, google::protobuf::RpcController* contro
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -774,6 +785,7 @@ void DoKvCompareAndSet(StoragePtr storage, google::protobuf::RpcController* cont
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -862,6 +874,7 @@ void DoKvBatchCompareAndSet(StoragePtr storage, google::protobuf::RpcController*
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -956,6 +969,7 @@ void DoKvScanBegin(StoragePtr storage, google::protobuf::RpcController* controll
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1043,6 +1057,7 @@ void DoKvScanContinue(StoragePtr storage, google::protobuf::RpcController* contr
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1121,6 +1136,7 @@ void DoKvScanRelease(StoragePtr storage, google::protobuf::RpcController* contro
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1198,6 +1214,7 @@ void DoTxnGet(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>();
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1287,6 +1304,7 @@ void DoTxnScan(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>();
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1396,11 +1414,118 @@ static butil::Status ValidateTxnPessimisticLockRequest(const dingodb::pb::store:
 void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* controller,
                           const dingodb::pb::store::TxnPessimisticLockRequest* request,
                           dingodb::pb::store::TxnPessimisticLockResponse* response, google::protobuf::Closure* done,
-                          bool is_sync) {
+                          WorkerSetPtr worker_set, int64_t wait_deadline_ms, bool is_sync,
+                          const std::string& woken_key);
+
+// Only wait for the locks of other txns, the write conflict and self lock are returned to client.
+static bool IsPessimisticLockWaitable(const dingodb::pb::store::TxnPessimisticLockRequest* request,
+                                      dingodb::pb::store::TxnPessimisticLockResponse* response,
+                                      int64_t wait_deadline_ms) {
+  if (response->txn_result().empty() || wait_deadline_ms <= Helper::TimestampMs()) {
+    return false;
+  }
+
+  for (const auto& txn_result : response->txn_result()) {
+    if (!txn_result.has_locked() || txn_result.locked().lock_ts() == static_cast<int64_t>(request->start_ts())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Park the pessimistic lock request on the first conflict key, retry it in write worker when the lock is released, or
+// reply the lock conflict on timeout. Return false when waiting makes deadlock, the request should be replied.
+// release_seqs are the release sequences of mutation keys read before the locks.
+static bool WaitPessimisticLock(StoragePtr storage, google::protobuf::RpcController* controller,
+                                const dingodb::pb::store::TxnPessimisticLockRequest* request,
+                                dingodb::pb::store::TxnPessimisticLockResponse* response,
+                                google::protobuf::Closure* done, WorkerSetPtr worker_set, int64_t wait_deadline_ms,
+                                const std::map<std::string, int64_t>& release_seqs) {
+  int64_t region_id = request->context().region_id();
+  // response is owned by the waker once waiting, copy the lock
+  auto lock_info = response->txn_result(0).locked();
+
+  // no need to wait for the expired lock, client will resolve it
+  int64_t deadline_ms = wait_deadline_ms;
+  if (lock_info.lock_ttl() > 0) {
+    deadline_ms = std::min(deadline_ms, lock_info.lock_ttl());
+  }
+  int64_t timeout_ms = deadline_ms - Helper::TimestampMs();
+  if (timeout_ms <= 0) {
+    return false;
+  }
+
+  auto retry_func = [=](const std::string& woken_key) {
+    response->clear_txn_result();
+    auto task = std::make_shared<ServiceTask>([=]() {
+      DoTxnPessimisticLock(storage, controller, request, response, done, worker_set, wait_deadline_ms, true,
+                           woken_key);
+    });
+    if (!worker_set->ExecuteHashByRegionId(region_id, task)) {
+      brpc::ClosureGuard done_guard(done);
+      ServiceHelper::SetError(response->mutable_error(), pb::error::EREQUEST_FULL, "Commit execute queue failed");
+      if (!woken_key.empty()) {
+        TxnLockWaitManager::GetInstance().WakeUp(region_id, woken_key);
+      }
+    }
+  };
+
+  auto wake_func = [=](bool is_timeout) {
+    if (is_timeout) {
+      done->Run();
+      return;
+    }
+    retry_func(lock_info.key());
+  };
+
+  // the lock key is one of mutations, read it now only in case it is not
+  auto seq_it = release_seqs.find(lock_info.key());
+  int64_t release_seq = seq_it != release_seqs.end()
+                            ? seq_it->second
+                            : TxnLockWaitManager::GetInstance().GetReleaseSeq(region_id, lock_info.key());
+
+  std::vector<int64_t> wait_chain;
+  auto result = TxnLockWaitManager::GetInstance().Wait(region_id, lock_info.key(), request->start_ts(),
+                                                       lock_info.lock_ts(), release_seq, timeout_ms, wake_func,
+                                                       wait_chain);
+  if (result == TxnLockWaitManager::WaitResult::kReleased) {
+    retry_func("");
+    return true;
+  }
+
+  bool ret = result == TxnLockWaitManager::WaitResult::kWaiting;
+  if (!ret) {
+    response->clear_txn_result();
+    auto* deadlock = response->add_txn_result()->mutable_deadlock();
+    deadlock->set_lock_ts(lock_info.lock_ts());
+    deadlock->set_lock_key(lock_info.key());
+    for (auto start_ts : wait_chain) {
+      deadlock->add_wait_chain(start_ts);
+    }
+  }
+
+  return ret;
+}
+
+void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* controller,
+                          const dingodb::pb::store::TxnPessimisticLockRequest* request,
+                          dingodb::pb::store::TxnPessimisticLockResponse* response, google::protobuf::Closure* done,
+                          WorkerSetPtr worker_set, int64_t wait_deadline_ms, bool is_sync,
+                          const std::string& woken_key) {
   brpc::Controller* cntl = (brpc::Controller*)controller;
   brpc::ClosureGuard done_guard(done);
 
   int64_t region_id = request->context().region_id();
+
+  // This retry is woken by the release of woken_key. If it doesn't take the lock, and it doesn't wait for the key
+  // again, wake up the next waiter of key.
+  bool is_locked = false;
+  std::string waiting_key;
+  DEFER(if (!woken_key.empty() && !is_locked && waiting_key != woken_key) {
+    TxnLockWaitManager::GetInstance().WakeUp(region_id, woken_key);
+  });
+
   auto region = Server::GetInstance().GetRegion(region_id);
   if (region == nullptr) {
     ServiceHelper::SetError(response->mutable_error(), pb::error::EREGION_NOT_FOUND,
@@ -1416,6 +1541,7 @@ void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* c
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1428,6 +1554,14 @@ void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* c
     mutations.emplace_back(mutation);
   }
 
+  // read before the locks, a lock released after this is seen by WaitPessimisticLock
+  std::map<std::string, int64_t> release_seqs;
+  if (is_sync && worker_set != nullptr) {
+    for (const auto& mutation : mutations) {
+      release_seqs[mutation.key()] = TxnLockWaitManager::GetInstance().GetReleaseSeq(region_id, mutation.key());
+    }
+  }
+
   std::vector<pb::common::KeyValue> kvs;
   status = storage->TxnPessimisticLock(ctx, mutations, request->primary_lock(), request->start_ts(),
                                        request->lock_ttl(), request->for_update_ts());
@@ -1435,6 +1569,18 @@ void DoTxnPessimisticLock(StoragePtr storage, google::protobuf::RpcController* c
     ServiceHelper::SetError(response->mutable_error(), status.error_code(), status.error_str());
 
     if (!is_sync) done->Run();
+  } else if (is_sync && worker_set != nullptr && IsPessimisticLockWaitable(request, response, wait_deadline_ms)) {
+    // the request is replied by the waker after waiting
+    std::string lock_key = response->txn_result(0).locked().key();
+    auto* wait_done = done_guard.release();
+    if (WaitPessimisticLock(storage, controller, request, response, wait_done, worker_set, wait_deadline_ms,
+                            release_seqs)) {
+      waiting_key = lock_key;
+    } else {
+      wait_done->Run();
+    }
+  } else {
+    is_locked = !response->has_error() && response->txn_result().empty();
   }
 }
 
@@ -1446,8 +1592,11 @@ void StoreServiceImpl::TxnPessimisticLock(google::protobuf::RpcController* contr
 
   // Run in queue.
   StoragePtr storage = storage_;
-  auto task = std::make_shared<ServiceTask>(
-      [=]() { DoTxnPessimisticLock(storage, controller, request, response, svr_done, true); });
+  WorkerSetPtr worker_set = write_worker_set_;
+  int64_t wait_deadline_ms = Helper::TimestampMs() + FLAGS_txn_pessimistic_lock_wait_timeout_ms;
+  auto task = std::make_shared<ServiceTask>([=]() {
+    DoTxnPessimisticLock(storage, controller, request, response, svr_done, worker_set, wait_deadline_ms, true, "");
+  });
   bool ret = write_worker_set_->ExecuteHashByRegionId(request->context().region_id(), task);
   if (!ret) {
     brpc::ClosureGuard done_guard(svr_done);
@@ -1522,6 +1671,7 @@ void DoTxnPessimisticRollback(StoragePtr storage, google::protobuf::RpcControlle
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1629,6 +1779,7 @@ void DoTxnPrewrite(StoragePtr storage, google::protobuf::RpcController* controll
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1656,10 +1807,14 @@ void DoTxnPrewrite(StoragePtr storage, google::protobuf::RpcController* controll
   for (const auto& pessimistic_check : request->pessimistic_checks()) {
     pessimistic_checks.push_back(pessimistic_check);
   }
+
+  std::vector<std::string> secondaries(request->secondaries().begin(), request->secondaries().end());
+
   std::vector<pb::common::KeyValue> kvs;
   status = storage->TxnPrewrite(ctx, mutations, request->primary_lock(), request->start_ts(), request->lock_ttl(),
                                 request->txn_size(), request->try_one_pc(), request->max_commit_ts(),
-                                pessimistic_checks, for_update_ts_checks, lock_extra_datas);
+                                pessimistic_checks, for_update_ts_checks, lock_extra_datas, request->use_async_commit(),
+                                secondaries);
   if (!status.ok()) {
     ServiceHelper::SetError(response->mutable_error(), status.error_code(), status.error_str());
 
@@ -1745,6 +1900,7 @@ void DoTxnCommit(StoragePtr storage, google::protobuf::RpcController* controller
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1845,6 +2001,7 @@ void DoTxnCheckTxnStatus(StoragePtr storage, google::protobuf::RpcController* co
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -1853,7 +2010,7 @@ void DoTxnCheckTxnStatus(StoragePtr storage, google::protobuf::RpcController* co
   ctx->SetRawEngineType(region->GetRawEngineType());
 
   status = storage->TxnCheckTxnStatus(ctx, request->primary_key(), request->lock_ts(), request->caller_start_ts(),
-                                      request->current_ts());
+                                      request->current_ts(), request->rollback_if_not_exist());
   if (!status.ok()) {
     ServiceHelper::SetError(response->mutable_error(), status.error_code(), status.error_str());
 
@@ -1939,6 +2096,7 @@ void DoTxnResolveLock(StoragePtr storage, google::protobuf::RpcController* contr
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2030,6 +2188,7 @@ void DoTxnBatchGet(StoragePtr storage, google::protobuf::RpcController* controll
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2134,6 +2293,7 @@ void DoTxnBatchRollback(StoragePtr storage, google::protobuf::RpcController* con
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2238,6 +2398,7 @@ void DoTxnScanLock(StoragePtr storage, google::protobuf::RpcController* controll
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2335,6 +2496,7 @@ void DoTxnHeartBeat(StoragePtr storage, google::protobuf::RpcController* control
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2408,6 +2570,7 @@ void DoTxnGc(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2492,6 +2655,7 @@ void DoTxnDeleteRange(StoragePtr storage, google::protobuf::RpcController* contr
   }
 
   auto ctx = std::make_shared<Context>(cntl, is_sync ? nullptr : done_guard.release(), request, response);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
@@ -2576,6 +2740,7 @@ void DoTxnDump(StoragePtr storage, google::protobuf::RpcController* controller,
   }
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ServiceHelper::BindTracker(ctx, done);
   ctx->SetRegionId(region_id);
   ctx->SetRequestId(request->request_info().request_id());
   ctx->SetCfName(Constant::kStoreDataCF);
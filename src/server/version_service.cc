@@ -663,6 +663,50 @@ void DoKvCompaction(google::protobuf::RpcController* /*controller*/, const pb::v
   DINGO_LOG(INFO) << "Compaction success: key=" << request->key() << ", end_key=" << request->range_end();
 }
 
+// Streaming watch, client must create a stream on the controller, events are pushed to the stream.
+static void DoStreamWatch(google::protobuf::RpcController* controller, const pb::version::WatchRequest* request,
+                          pb::version::WatchResponse* response, google::protobuf::Closure* done,
+                          std::shared_ptr<KvControl> kv_control) {
+  brpc::ClosureGuard done_guard(done);
+
+  const auto& create_req = request->create_request();
+  if (create_req.key().empty()) {
+    response->mutable_error()->set_errcode(pb::error::Errno::EILLEGAL_PARAMTETERS);
+    response->mutable_error()->set_errmsg("key is empty");
+    return;
+  }
+
+  auto* cntl = static_cast<brpc::Controller*>(controller);
+  if (!cntl->has_remote_stream()) {
+    response->mutable_error()->set_errcode(pb::error::Errno::EILLEGAL_PARAMTETERS);
+    response->mutable_error()->set_errmsg("stream is not created");
+    return;
+  }
+
+  uint64_t watch_id = 0;
+  int64_t start_revision = 0;
+  int64_t compact_revision = 0;
+  auto ret = kv_control->StreamWatch(create_req, cntl, watch_id, start_revision, compact_revision);
+  if (!ret.ok()) {
+    response->mutable_error()->set_errcode(static_cast<pb::error::Errno>(ret.error_code()));
+    response->mutable_error()->set_errmsg(ret.error_str());
+    if (ret.error_code() == pb::error::Errno::EWATCH_REVISION_COMPACTED) {
+      response->set_compact_revision(compact_revision);
+      response->set_canceled(true);
+      response->set_cancel_reason("watch revision is compacted");
+    }
+    return;
+  }
+
+  response->set_watch_id(watch_id);
+  response->set_created(true);
+  response->mutable_header()->set_revision(start_revision - 1);
+
+  // stream is connected after response is sent
+  done_guard.release()->Run();
+  kv_control->StartStreamWatch(watch_id);
+}
+
 void DoWatch(google::protobuf::RpcController* controller, const pb::version::WatchRequest* request,
              pb::version::WatchResponse* response, google::protobuf::Closure* done,
              std::shared_ptr<KvControl> kv_control, std::shared_ptr<Engine> /*raft_engine*/) {
@@ -678,9 +722,25 @@ void DoWatch(google::protobuf::RpcController* controller, const pb::version::Wat
 
   DINGO_LOG(INFO) << "Receive Watch Request: " << request->ShortDebugString();
 
+  if (request->has_create_request()) {
+    return DoStreamWatch(controller, request, response, done_guard.release(), kv_control);
+  }
+
+  if (request->has_cancel_request()) {
+    auto ret = kv_control->CancelStreamWatch(request->cancel_request().watch_id());
+    if (!ret.ok()) {
+      response->mutable_error()->set_errcode(static_cast<pb::error::Errno>(ret.error_code()));
+      response->mutable_error()->set_errmsg(ret.error_str());
+      return;
+    }
+    response->set_watch_id(request->cancel_request().watch_id());
+    response->set_canceled(true);
+    return;
+  }
+
   if (!request->has_one_time_request()) {
     response->mutable_error()->set_errcode(pb::error::Errno::EILLEGAL_PARAMTETERS);
-    response->mutable_error()->set_errmsg("only one_time_request is supported now");
+    response->mutable_error()->set_errmsg("only one_time_request, create_request and cancel_request are supported now");
     return;
   }
 
@@ -1061,13 +1121,13 @@ void VersionServiceProtoImpl::Watch(google::protobuf::RpcController* controller,
     return RedirectResponse(response);
   }
 
-  if (!request->has_one_time_request()) {
+  if (!request->has_one_time_request() && !request->has_create_request() && !request->has_cancel_request()) {
     response->mutable_error()->set_errcode(pb::error::Errno::EILLEGAL_PARAMTETERS);
-    response->mutable_error()->set_errmsg("only one_time_request is supported now");
+    response->mutable_error()->set_errmsg("only one_time_request, create_request and cancel_request are supported now");
     return;
   }
 
-  if (request->one_time_request().key().empty()) {
+  if (request->has_one_time_request() && request->one_time_request().key().empty()) {
     response->mutable_error()->set_errcode(pb::error::Errno::EILLEGAL_PARAMTETERS);
     response->mutable_error()->set_errmsg("key is empty");
     return;
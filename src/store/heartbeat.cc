@@ -22,7 +22,9 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <functional>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "butil/compiler_specific.h"
@@ -31,8 +33,11 @@
 #include "common/helper.h"
 #include "common/logging.h"
 #include "coordinator/coordinator_control.h"
+#include "engine/txn_gc_compaction_filter.h"
 #include "fmt/core.h"
 #include "gflags/gflags.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "proto/common.pb.h"
 #include "proto/coordinator.pb.h"
 #include "proto/coordinator_internal.pb.h"
@@ -55,7 +60,142 @@ DEFINE_int64(store_heartbeat_report_region_multiple, 10,
              "store heartbeat report region multiple, this defines how many times of heartbeat will report "
              "region_metrics once to coordinator");
 
+DEFINE_bool(store_heartbeat_enable_delta_region_metrics, true,
+            "store heartbeat only report the region_metrics changed since the version acknowledged by coordinator");
+DEFINE_int64(store_heartbeat_full_region_metrics_multiple, 10,
+             "when delta region_metrics is enabled, this defines how many times of region_metrics report will send "
+             "full region_metrics once to coordinator");
+
 int64_t HeartbeatTask::heartbeat_counter = 0;
+int64_t HeartbeatTask::region_report_counter = 0;
+
+RegionMetricsDeltaTracker& RegionMetricsDeltaTracker::GetInstance() {
+  static RegionMetricsDeltaTracker instance;
+  return instance;
+}
+
+// Keep the highest 4 significant bits, so the small change of size and count is not treated as changed.
+static int64_t Bucket(int64_t value) {
+  if (value <= 0) {
+    return value;
+  }
+  int shift = std::max(0, 64 - __builtin_clzll(static_cast<uint64_t>(value)) - 4);
+  return (value >> shift) << shift;
+}
+
+uint64_t RegionMetricsDeltaTracker::Digest(const pb::common::RegionMetrics& region_metrics) {
+  // only the stable fields are hashed, the raft indexes and rpc timestamps change in every heartbeat,
+  // the coordinator get them by the periodic full region_metrics.
+  pb::common::RegionMetrics stable_metrics;
+  stable_metrics.set_id(region_metrics.id());
+  stable_metrics.set_leader_store_id(region_metrics.leader_store_id());
+  stable_metrics.set_store_region_state(region_metrics.store_region_state());
+  *stable_metrics.mutable_region_definition() = region_metrics.region_definition();
+  *stable_metrics.mutable_vector_index_status() = region_metrics.vector_index_status();
+  *stable_metrics.mutable_region_status() = region_metrics.region_status();
+  stable_metrics.set_snapshot_epoch_version(region_metrics.snapshot_epoch_version());
+  stable_metrics.set_row_count(Bucket(region_metrics.row_count()));
+  stable_metrics.set_region_size(Bucket(region_metrics.region_size()));
+
+  const auto& braft_status = region_metrics.braft_status();
+  auto* stable_braft_status = stable_metrics.mutable_braft_status();
+  stable_braft_status->set_raft_state(braft_status.raft_state());
+  stable_braft_status->set_peer_id(braft_status.peer_id());
+  stable_braft_status->set_leader_peer_id(braft_status.leader_peer_id());
+  stable_braft_status->set_readonly(braft_status.readonly());
+  stable_braft_status->set_term(braft_status.term());
+  for (const auto& [peer_id, peer_status] : braft_status.stable_followers()) {
+    auto& stable_peer_status = (*stable_braft_status->mutable_stable_followers())[peer_id];
+    stable_peer_status.set_valid(peer_status.valid());
+    stable_peer_status.set_installing_snapshot(peer_status.installing_snapshot());
+  }
+  for (const auto& [peer_id, peer_status] : braft_status.unstable_followers()) {
+    auto& stable_peer_status = (*stable_braft_status->mutable_unstable_followers())[peer_id];
+    stable_peer_status.set_valid(peer_status.valid());
+    stable_peer_status.set_installing_snapshot(peer_status.installing_snapshot());
+  }
+
+  const auto& vector_index_metrics = region_metrics.vector_index_metrics();
+  auto* stable_vector_index_metrics = stable_metrics.mutable_vector_index_metrics();
+  stable_vector_index_metrics->set_vector_index_type(vector_index_metrics.vector_index_type());
+  stable_vector_index_metrics->set_current_count(Bucket(vector_index_metrics.current_count()));
+  stable_vector_index_metrics->set_deleted_count(Bucket(vector_index_metrics.deleted_count()));
+  stable_vector_index_metrics->set_memory_bytes(Bucket(vector_index_metrics.memory_bytes()));
+
+  std::string buf;
+  {
+    google::protobuf::io::StringOutputStream output_stream(&buf);
+    google::protobuf::io::CodedOutputStream coded_stream(&output_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    stable_metrics.SerializeToCodedStream(&coded_stream);
+  }
+
+  return std::hash<std::string>{}(buf);
+}
+
+void RegionMetricsDeltaTracker::Prepare(bool force_full, const std::vector<int64_t>& skipped_region_ids,
+                                        pb::common::StoreMetrics& store_metrics) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  int64_t version = ++next_version_;
+  std::map<int64_t, uint64_t> digests;
+  for (const auto& [region_id, region_metrics] : store_metrics.region_metrics_map()) {
+    digests[region_id] = Digest(region_metrics);
+  }
+  // the skipped regions keep the acknowledged digest, so they are neither changed nor deleted
+  for (auto region_id : skipped_region_ids) {
+    auto it = acked_digests_.find(region_id);
+    if (it != acked_digests_.end() && digests.find(region_id) == digests.end()) {
+      digests[region_id] = it->second;
+    }
+  }
+
+  store_metrics.set_region_metrics_version(version);
+  if (force_full || need_full_ || acked_version_ == 0) {
+    store_metrics.set_is_delta_region_metrics(false);
+  } else {
+    store_metrics.set_is_delta_region_metrics(true);
+    store_metrics.set_base_region_metrics_version(acked_version_);
+
+    auto* mut_region_metrics_map = store_metrics.mutable_region_metrics_map();
+    for (const auto& [region_id, digest] : digests) {
+      auto it = acked_digests_.find(region_id);
+      if (it != acked_digests_.end() && it->second == digest) {
+        mut_region_metrics_map->erase(region_id);
+      }
+    }
+    for (const auto& [region_id, _] : acked_digests_) {
+      if (digests.find(region_id) == digests.end()) {
+        store_metrics.add_deleted_region_ids(region_id);
+      }
+    }
+  }
+
+  pending_version_ = version;
+  pending_digests_.swap(digests);
+}
+
+void RegionMetricsDeltaTracker::Acknowledge(int64_t acked_version, bool need_full) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  if (need_full) {
+    need_full_ = true;
+    return;
+  }
+
+  // only the last prepared version can become the base, the older response is out of date
+  if (acked_version > 0 && acked_version == pending_version_) {
+    acked_version_ = acked_version;
+    acked_digests_.swap(pending_digests_);
+    pending_digests_.clear();
+    need_full_ = false;
+  }
+}
+
+int64_t RegionMetricsDeltaTracker::AckedVersion() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return acked_version_;
+}
 
 void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> coordinator_interaction,
                                        std::vector<int64_t> region_ids, bool is_update_epoch_version) {
@@ -77,6 +217,7 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
   // only partial heartbeat or heartbeat_counter % FLAGS_store_heartbeat_report_region_multiple == 0 will report
   // region_metrics, this is for reduce heartbeat size and cpu usage.
   bool need_report_region_metrics = false;
+  bool is_delta_tracked = false;
   if (region_ids.empty()) {
     heartbeat_counter++;
     if (heartbeat_counter % FLAGS_store_heartbeat_report_region_multiple == 0) {
@@ -100,6 +241,7 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
     auto* mut_region_metrics_map = mut_store_metrics->mutable_region_metrics_map();
     auto region_metrics = metrics_manager->GetStoreRegionMetrics();
     std::vector<store::RegionPtr> region_metas;
+    std::vector<int64_t> skipped_region_ids;
     if (region_ids.empty()) {
       region_metas = store_meta_manager->GetStoreRegionMeta()->GetAllRegion();
     } else {
@@ -117,6 +259,7 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
           inner_region.state() == pb::common::StoreRegionState::MERGING) {
         DINGO_LOG(WARNING) << fmt::format("[heartbeat.store][region({})] region state({}) not suit heartbeat.",
                                           inner_region.id(), pb::common::StoreRegionState_Name(inner_region.state()));
+        skipped_region_ids.push_back(inner_region.id());
         continue;
       }
 
@@ -164,9 +307,18 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
       mut_region_metrics_map->insert({inner_region.id(), tmp_region_metrics});
     }
 
-    DINGO_LOG(INFO) << fmt::format("[heartbeat.store] request region count({}) size({}) elapsed time({} ms)",
-                                   mut_region_metrics_map->size(), request.ByteSizeLong(),
-                                   Helper::TimestampMs() - start_time);
+    // full heartbeat only carry the regions changed since the version acknowledged by coordinator.
+    if (region_ids.empty() && FLAGS_store_heartbeat_enable_delta_region_metrics) {
+      region_report_counter++;
+      bool force_full = region_report_counter % FLAGS_store_heartbeat_full_region_metrics_multiple == 0;
+      RegionMetricsDeltaTracker::GetInstance().Prepare(force_full, skipped_region_ids, *mut_store_metrics);
+      is_delta_tracked = true;
+    }
+
+    DINGO_LOG(INFO) << fmt::format(
+        "[heartbeat.store] request region count({}) delta({}) deleted({}) size({}) elapsed time({} ms)",
+        mut_region_metrics_map->size(), mut_store_metrics->is_delta_region_metrics(),
+        mut_store_metrics->deleted_region_ids_size(), request.ByteSizeLong(), Helper::TimestampMs() - start_time);
   }
 
   start_time = Helper::TimestampMs();
@@ -181,6 +333,16 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
   DINGO_LOG(INFO) << fmt::format("[heartbeat.store] response size({}) elapsed time({} ms)", response.ByteSizeLong(),
                                  Helper::TimestampMs() - start_time);
 
+  if (is_delta_tracked && (!response.has_error() || response.error().errcode() == pb::error::OK)) {
+    RegionMetricsDeltaTracker::GetInstance().Acknowledge(response.acked_region_metrics_version(),
+                                                         response.need_full_region_metrics());
+  }
+
+  if (!response.has_error() || response.error().errcode() == pb::error::OK) {
+    TxnGcSafePoint::GetInstance().SetGcStop(response.gc_stop());
+    TxnGcSafePoint::GetInstance().Update(response.gc_safe_point());
+  }
+
   HeartbeatTask::HandleStoreHeartbeatResponse(store_meta_manager, response);
 }
 
@@ -439,6 +601,24 @@ void CalculateTableMetricsTask::CalculateTableMetrics(std::shared_ptr<Coordinato
   coordinator_control->CalculateIndexMetrics();
 }
 
+// this is for coordinator
+static std::atomic<bool> g_coordinator_balance_schedule_running(false);
+void BalanceScheduleTask::BalanceSchedule(std::shared_ptr<CoordinatorControl> coordinator_control) {
+  if (!coordinator_control->IsLeader()) {
+    return;
+  }
+  DINGO_LOG(DEBUG) << "BalanceSchedule... this is leader";
+
+  if (g_coordinator_balance_schedule_running.load(std::memory_order_relaxed)) {
+    DINGO_LOG(INFO) << "BalanceSchedule... g_coordinator_balance_schedule_running is true, return";
+    return;
+  }
+
+  AtomicGuard guard(g_coordinator_balance_schedule_running);
+
+  coordinator_control->BalanceSchedule();
+}
+
 // this is for coordinator
 static std::atomic<bool> g_coordinator_lease_running(false);
 void LeaseTask::ExecLeaseTask(std::shared_ptr<KvControl> kv_control) {
@@ -546,6 +726,12 @@ void Heartbeat::TriggerCompactionTask(void*) {
   Server::GetInstance().GetHeartbeat()->Execute(task);
 }
 
+void Heartbeat::TriggerBalanceSchedule(void*) {
+  // Free at ExecuteRoutine()
+  auto task = std::make_shared<BalanceScheduleTask>(Server::GetInstance().GetCoordinatorControl());
+  Server::GetInstance().GetHeartbeat()->Execute(task);
+}
+
 void Heartbeat::TriggerScrubVectorIndex(void*) {
   // Free at ExecuteRoutine()
   auto task = std::make_shared<VectorIndexScrubTask>();
@@ -17,9 +17,12 @@
 
 #include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "brpc/channel.h"
+#include "bthread/mutex.h"
 #include "common/logging.h"
 #include "common/runnable.h"
 #include "coordinator/coordinator_control.h"
@@ -32,6 +35,44 @@
 
 namespace dingodb {
 
+// Track the region metrics acknowledged by coordinator, so the store heartbeat only carry the regions changed since
+// the acknowledged version. Every heartbeat has a new version, the delta is based on the last acknowledged version,
+// and full region metrics is sent when there is no acknowledged version or coordinator reject the delta.
+class RegionMetricsDeltaTracker {
+ public:
+  RegionMetricsDeltaTracker() { bthread_mutex_init(&mutex_, nullptr); }
+  ~RegionMetricsDeltaTracker() { bthread_mutex_destroy(&mutex_); }
+
+  RegionMetricsDeltaTracker(const RegionMetricsDeltaTracker&) = delete;
+  RegionMetricsDeltaTracker& operator=(const RegionMetricsDeltaTracker&) = delete;
+
+  static RegionMetricsDeltaTracker& GetInstance();
+
+  // store_metrics contain all region metrics of store, remove the unchanged region metrics when delta is allowed.
+  // skipped_region_ids are the regions not reported this time(e.g. splitting), they are treated as unchanged.
+  void Prepare(bool force_full, const std::vector<int64_t>& skipped_region_ids,
+               pb::common::StoreMetrics& store_metrics);
+
+  // handle the heartbeat response of the prepared store_metrics.
+  void Acknowledge(int64_t acked_version, bool need_full);
+
+  int64_t AckedVersion();
+
+ private:
+  // digest of the stable fields, a region is reported when its digest changed.
+  static uint64_t Digest(const pb::common::RegionMetrics& region_metrics);
+
+  bthread_mutex_t mutex_;
+  int64_t next_version_{0};
+  bool need_full_{true};
+
+  int64_t acked_version_{0};
+  std::map<int64_t, uint64_t> acked_digests_;
+
+  int64_t pending_version_{0};
+  std::map<int64_t, uint64_t> pending_digests_;
+};
+
 class HeartbeatTask : public TaskRunnable {
  public:
   HeartbeatTask(std::shared_ptr<CoordinatorInteraction> coordinator_interaction)
@@ -53,6 +94,8 @@ class HeartbeatTask : public TaskRunnable {
                                            const pb::coordinator::StoreHeartbeatResponse& response);
 
   static int64_t heartbeat_counter;
+  // count of the full heartbeat which report region_metrics
+  static int64_t region_report_counter;
 
  private:
   bool is_update_epoch_version_;
@@ -167,6 +210,24 @@ class CalculateTableMetricsTask : public TaskRunnable {
   std::shared_ptr<CoordinatorControl> coordinator_control_;
 };
 
+class BalanceScheduleTask : public TaskRunnable {
+ public:
+  BalanceScheduleTask(std::shared_ptr<CoordinatorControl> coordinator_control)
+      : coordinator_control_(coordinator_control) {}
+  ~BalanceScheduleTask() override = default;
+
+  std::string Type() override { return "BALANCE_SCHEDULE"; }
+
+  void Run() override {
+    DINGO_LOG(DEBUG) << "start process BalanceSchedule";
+    BalanceSchedule(coordinator_control_);
+  }
+
+ private:
+  static void BalanceSchedule(std::shared_ptr<CoordinatorControl> coordinator_control);
+  std::shared_ptr<CoordinatorControl> coordinator_control_;
+};
+
 class LeaseTask : public TaskRunnable {
  public:
   LeaseTask(std::shared_ptr<KvControl> kv_control) : kv_control_(kv_control) {}
@@ -234,6 +295,7 @@ class Heartbeat {
   static void TriggerScrubVectorIndex(void*);
   static void TriggerLeaseTask(void*);
   static void TriggerCompactionTask(void*);
+  static void TriggerBalanceSchedule(void*);
 
  private:
   bool Execute(TaskRunnablePtr task);
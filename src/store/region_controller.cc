@@ -250,11 +250,22 @@ butil::Status DeleteRegionTask::DeleteRegion(std::shared_ptr<Context> ctx, int64
   // Delete data
   DINGO_LOG(DEBUG) << fmt::format("[control.region][region({})] delete region, delete data", region_id);
   if (!Helper::InvalidRange(region->Range())) {
+    auto cf_names = Helper::GetColumnFamilyNames(region->Range().start_key());
+    // Drop the files inside the range before writing the tombstone, the tombstone covers the left files.
+    status = region_raw_engine->DeleteFilesInRange(cf_names, region->Range());
+    if (!status.ok()) {
+      DINGO_LOG(WARNING) << fmt::format("[control.region][region({})] delete region files failed, error: {}.",
+                                        region_id, Helper::PrintStatus(status));
+    }
+
     auto writer = region_raw_engine->Writer();
-    status = writer->KvDeleteRange(Helper::GetColumnFamilyNames(region->Range().start_key()), region->Range());
+    status = writer->KvDeleteRange(cf_names, region->Range());
     if (!status.ok()) {
       DINGO_LOG(ERROR) << fmt::format("[control.region][region({})] delete region data failled, error: {}.", region_id,
                                       Helper::PrintStatus(status));
+    } else {
+      // Reclaim the space and clean up the range tombstones in background.
+      region_raw_engine->GcRange(cf_names, region->Range());
     }
   }
 
@@ -945,6 +945,8 @@ butil::Status VectorIndexWrapper::SetVectorIndexFilter(
     } else {
       // do nothing
     }
+  } else if (vector_index->VectorIndexType() == pb::common::VECTOR_INDEX_TYPE_DISKANN) {
+    filters.push_back(std::make_shared<VectorIndex::RangeFilterFunctor>(min_vector_id, max_vector_id));
   }
 
   return butil::Status::OK();
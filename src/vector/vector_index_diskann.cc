@@ -0,0 +1,1087 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vector/vector_index_diskann.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "butil/status.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "faiss/impl/AuxIndexStructures.h"
+#include "faiss/impl/ProductQuantizer.h"
+#include "faiss/utils/distances.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "proto/common.pb.h"
+#include "proto/error.pb.h"
+#include "proto/index.pb.h"
+#include "vector/vector_index_utils.h"
+
+namespace dingodb {
+
+DEFINE_string(diskann_data_path, "./data/diskann", "local path of diskann full precision vectors");
+DEFINE_int64(diskann_pq_train_count, 10000, "diskann train pq when vector count reach this, at least 256");
+DEFINE_int32(diskann_pq_sub_dimension, 4, "diskann pq sub vector dimension");
+DEFINE_double(diskann_alpha, 1.2, "diskann graph prune alpha, larger keeps more long edges");
+DEFINE_int32(diskann_build_search_list_size, 100, "diskann search list size when insert vector");
+DEFINE_int32(diskann_search_list_size, 100, "diskann default search list size");
+DEFINE_int32(diskann_beam_width, 4, "diskann default beam width, full vectors read in one batch");
+DEFINE_int64(diskann_need_save_count, 10000, "diskann need save count");
+
+static constexpr uint32_t kInvalidSlot = std::numeric_limits<uint32_t>::max();
+static constexpr uint32_t kDiskAnnFileMagic = 0x4e4e4144;  // "DANN"
+static constexpr uint32_t kDiskAnnFileVersion = 1;
+static constexpr uint32_t kPqNbits = 8;
+// slots per batch when copy vectors between index file and vector file
+static constexpr uint32_t kCopyBatchSlots = 1024;
+
+static std::atomic<int64_t> vector_file_seq{0};
+
+static butil::Status PreadFull(int fd, char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t n = pread(fd, buf, size, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return butil::Status(pb::error::Errno::EINTERNAL, fmt::format("pread fail, error: {}", strerror(errno)));
+    }
+    if (n == 0) {
+      return butil::Status(pb::error::Errno::EINTERNAL, fmt::format("pread reach end of file, offset: {}", offset));
+    }
+    buf += n;
+    size -= n;
+    offset += n;
+  }
+  return butil::Status::OK();
+}
+
+static butil::Status PwriteFull(int fd, const char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t n = pwrite(fd, buf, size, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return butil::Status(pb::error::Errno::EINTERNAL, fmt::format("pwrite fail, error: {}", strerror(errno)));
+    }
+    buf += n;
+    size -= n;
+    offset += n;
+  }
+  return butil::Status::OK();
+}
+
+DiskAnnVectorFile::DiskAnnVectorFile(std::string path, uint32_t dimension)
+    : path_(std::move(path)), dimension_(dimension), fd_(-1) {}
+
+DiskAnnVectorFile::~DiskAnnVectorFile() {
+  if (fd_ >= 0) {
+    close(fd_);
+    unlink(path_.c_str());
+  }
+}
+
+butil::Status DiskAnnVectorFile::Open() {
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    std::string s = fmt::format("open diskann vector file fail, path: {} error: {}", path_, strerror(errno));
+    DINGO_LOG(ERROR) << s;
+    return butil::Status(pb::error::Errno::EINTERNAL, s);
+  }
+  return butil::Status::OK();
+}
+
+butil::Status DiskAnnVectorFile::Write(uint32_t slot, const float* vectors, uint32_t count) {
+  size_t record_size = dimension_ * sizeof(float);
+  return PwriteFull(fd_, reinterpret_cast<const char*>(vectors), record_size * count,
+                    static_cast<off_t>(record_size) * slot);
+}
+
+butil::Status DiskAnnVectorFile::BatchRead(const std::vector<uint32_t>& slots, std::vector<float>& vectors) const {
+  vectors.resize(slots.size() * dimension_);
+  if (slots.empty()) {
+    return butil::Status::OK();
+  }
+
+  std::vector<uint32_t> order(slots.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) { return slots[lhs] < slots[rhs]; });
+
+  // merge adjacent records into runs of [begin, end) in order
+  std::vector<std::pair<size_t, size_t>> runs;
+  size_t begin = 0;
+  for (size_t i = 1; i <= order.size(); ++i) {
+    if (i == order.size() || slots[order[i]] > slots[order[i - 1]] + 1) {
+      runs.emplace_back(begin, i);
+      begin = i;
+    }
+  }
+
+  size_t record_size = dimension_ * sizeof(float);
+  for (const auto& [run_begin, run_end] : runs) {
+    uint32_t first_slot = slots[order[run_begin]];
+    uint32_t last_slot = slots[order[run_end - 1]];
+    posix_fadvise(fd_, static_cast<off_t>(record_size) * first_slot, record_size * (last_slot - first_slot + 1),
+                  POSIX_FADV_WILLNEED);
+  }
+
+  std::vector<float> buf;
+  for (const auto& [run_begin, run_end] : runs) {
+    uint32_t first_slot = slots[order[run_begin]];
+    uint32_t last_slot = slots[order[run_end - 1]];
+    buf.resize(static_cast<size_t>(last_slot - first_slot + 1) * dimension_);
+    auto status = PreadFull(fd_, reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(float),
+                            static_cast<off_t>(record_size) * first_slot);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("read diskann vector file fail, path: {} slot: [{}, {}] error: {}", path_,
+                                      first_slot, last_slot, status.error_str());
+      return status;
+    }
+
+    for (size_t i = run_begin; i < run_end; ++i) {
+      uint32_t pos = order[i];
+      memcpy(vectors.data() + static_cast<size_t>(pos) * dimension_,
+             buf.data() + static_cast<size_t>(slots[pos] - first_slot) * dimension_, record_size);
+    }
+  }
+
+  return butil::Status::OK();
+}
+
+VectorIndexDiskAnn::VectorIndexDiskAnn(int64_t id, const pb::common::VectorIndexParameter& vector_index_parameter,
+                                       const pb::common::RegionEpoch& epoch, const pb::common::Range& range)
+    : VectorIndex(id, vector_index_parameter, epoch, range),
+      entry_slot_(kInvalidSlot),
+      deleted_count_(0),
+      pq_trained_(false) {
+  bthread_mutex_init(&write_mutex_, nullptr);
+
+  const auto& diskann_parameter = vector_index_parameter.diskann_parameter();
+  metric_type_ = diskann_parameter.metric_type();
+  dimension_ = diskann_parameter.dimension();
+  max_degree_ = diskann_parameter.num_neighbors() > 0 ? diskann_parameter.num_neighbors() : 64;
+
+  normalize_ = false;
+  if (pb::common::MetricType::METRIC_TYPE_COSINE == metric_type_) {
+    normalize_ = true;
+  } else if (pb::common::MetricType::METRIC_TYPE_L2 != metric_type_ &&
+             pb::common::MetricType::METRIC_TYPE_INNER_PRODUCT != metric_type_) {
+    DINGO_LOG(WARNING) << fmt::format("DiskAnn : not support metric type : {} use L2 default",
+                                      static_cast<int>(metric_type_));
+    metric_type_ = pb::common::MetricType::METRIC_TYPE_L2;
+  }
+
+  std::string path = fmt::format("{}/{}_{}_{}.vec", FLAGS_diskann_data_path, id, Helper::TimestampMs(),
+                                 vector_file_seq.fetch_add(1));
+  vector_file_ = std::make_unique<DiskAnnVectorFile>(path, dimension_);
+}
+
+VectorIndexDiskAnn::~VectorIndexDiskAnn() { bthread_mutex_destroy(&write_mutex_); }
+
+butil::Status VectorIndexDiskAnn::Init() {
+  auto status = Helper::CreateDirectories(FLAGS_diskann_data_path);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("create diskann data path fail, path: {} error: {}", FLAGS_diskann_data_path,
+                                    status.error_str());
+    return status;
+  }
+
+  // vector files left by the last process are never used, the index is loaded from the saved file or rebuilt,
+  // so clean them before the first vector file of this process is created
+  static std::once_flag clean_flag;
+  std::call_once(clean_flag, []() {
+    for (const auto& filename : Helper::TraverseDirectory(FLAGS_diskann_data_path, true)) {
+      if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".vec") == 0) {
+        std::string path = fmt::format("{}/{}", FLAGS_diskann_data_path, filename);
+        DINGO_LOG(INFO) << fmt::format("remove stale diskann vector file, path: {}", path);
+        Helper::RemoveFileOrDirectory(path);
+      }
+    }
+  });
+
+  return vector_file_->Open();
+}
+
+float VectorIndexDiskAnn::Distance(const float* x, const float* y) const {
+  if (metric_type_ == pb::common::MetricType::METRIC_TYPE_L2) {
+    return faiss::fvec_L2sqr(x, y, dimension_);
+  }
+  return -faiss::fvec_inner_product(x, y, dimension_);
+}
+
+float VectorIndexDiskAnn::ToFaissDistance(float distance) const {
+  return metric_type_ == pb::common::MetricType::METRIC_TYPE_L2 ? distance : -distance;
+}
+
+bool VectorIndexDiskAnn::CheckFilters(uint32_t slot, const std::vector<std::shared_ptr<FilterFunctor>>& filters) const {
+  int64_t vector_id = slot_ids_[slot];
+  if (vector_id < 0) {
+    return false;
+  }
+
+  for (const auto& filter : filters) {
+    if (!filter->Check(vector_id)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+butil::Status VectorIndexDiskAnn::Add(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  return AddOrUpsert(vector_with_ids);
+}
+
+butil::Status VectorIndexDiskAnn::Upsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  return AddOrUpsert(vector_with_ids);
+}
+
+butil::Status VectorIndexDiskAnn::AddOrUpsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  if (vector_with_ids.empty()) {
+    return butil::Status::OK();
+  }
+
+  const auto& [vectors, status] = VectorIndexUtils::CheckAndCopyVectorData(vector_with_ids, dimension_, normalize_);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << status.error_cstr();
+    return status;
+  }
+
+  BAIDU_SCOPED_LOCK(write_mutex_);
+  for (size_t i = 0; i < vector_with_ids.size(); ++i) {
+    int64_t vector_id = vector_with_ids[i].id();
+    {
+      BthreadRWLock::WriteGuard guard(rw_lock_);
+      DeleteUnlocked(vector_id);
+    }
+
+    auto ret = InsertUnlocked(vector_id, vectors.get() + i * dimension_);
+    if (!ret.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("[vector_index.diskann][id({})] insert vector({}) fail, error: {}", Id(),
+                                      vector_id, ret.error_str());
+      return ret;
+    }
+  }
+
+  if (!pq_trained_ && static_cast<int64_t>(id_to_slot_.size()) >= std::max(FLAGS_diskann_pq_train_count, 256L)) {
+    auto ret = TrainPqUnlocked();
+    if (!ret.ok()) {
+      // search still works by full vectors, retry on next write
+      DINGO_LOG(WARNING) << fmt::format("[vector_index.diskann][id({})] train pq fail, error: {}", Id(),
+                                        ret.error_str());
+    }
+  }
+
+  return butil::Status::OK();
+}
+
+bool VectorIndexDiskAnn::DeleteUnlocked(int64_t vector_id) {
+  auto it = id_to_slot_.find(vector_id);
+  if (it == id_to_slot_.end()) {
+    return false;
+  }
+
+  slot_ids_[it->second] = -1;
+  id_to_slot_.erase(it);
+  ++deleted_count_;
+  return true;
+}
+
+butil::Status VectorIndexDiskAnn::InsertUnlocked(int64_t vector_id, const float* vector) {
+  // the slot is not reachable by searches until it is linked into graph
+  uint32_t slot = slot_ids_.size();
+  auto status = vector_file_->Write(slot, vector, 1);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::vector<uint8_t> pq_code;
+  if (pq_trained_) {
+    pq_code.resize(pq_->code_size);
+    pq_->compute_code(vector, pq_code.data());
+  }
+
+  {
+    BthreadRWLock::WriteGuard guard(rw_lock_);
+    slot_ids_.push_back(vector_id);
+    graph_.emplace_back();
+    id_to_slot_[vector_id] = slot;
+    pq_codes_.insert(pq_codes_.end(), pq_code.begin(), pq_code.end());
+
+    if (entry_slot_ == kInvalidSlot) {
+      entry_slot_ = slot;
+      return butil::Status::OK();
+    }
+  }
+
+  // the new slot has no in edge yet, so it is never expanded here
+  std::vector<Neighbor> expanded;
+  std::unordered_map<uint32_t, std::vector<float>> expanded_vectors;
+  status = BeamSearchUnlocked(vector, FLAGS_diskann_build_search_list_size, FLAGS_diskann_beam_width, expanded,
+                              &expanded_vectors);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::vector<uint32_t> neighbors;
+  RobustPruneUnlocked(slot, expanded, expanded_vectors, neighbors);
+
+  std::vector<std::vector<uint32_t>> back_neighbors(neighbors.size());
+  for (size_t i = 0; i < neighbors.size(); ++i) {
+    status = BackEdgeNeighborsUnlocked(neighbors[i], slot, back_neighbors[i]);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  BthreadRWLock::WriteGuard guard(rw_lock_);
+  for (size_t i = 0; i < neighbors.size(); ++i) {
+    graph_[neighbors[i]].swap(back_neighbors[i]);
+  }
+  graph_[slot].swap(neighbors);
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::BackEdgeNeighborsUnlocked(uint32_t neighbor, uint32_t slot,
+                                                            std::vector<uint32_t>& out_neighbors) {
+  out_neighbors = graph_[neighbor];
+  if (std::find(out_neighbors.begin(), out_neighbors.end(), slot) != out_neighbors.end()) {
+    return butil::Status::OK();
+  }
+
+  if (out_neighbors.size() < max_degree_) {
+    out_neighbors.push_back(slot);
+    return butil::Status::OK();
+  }
+
+  std::vector<uint32_t> slots = out_neighbors;
+  slots.push_back(slot);
+  slots.push_back(neighbor);
+  std::vector<float> buf;
+  auto status = vector_file_->BatchRead(slots, buf);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::unordered_map<uint32_t, std::vector<float>> vectors;
+  for (size_t i = 0; i < slots.size(); ++i) {
+    vectors[slots[i]].assign(buf.data() + i * dimension_, buf.data() + (i + 1) * dimension_);
+  }
+
+  const auto& neighbor_vector = vectors[neighbor];
+  std::vector<Neighbor> candidates;
+  candidates.reserve(slots.size() - 1);
+  for (size_t i = 0; i + 1 < slots.size(); ++i) {
+    candidates.emplace_back(Distance(neighbor_vector.data(), vectors[slots[i]].data()), slots[i]);
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  RobustPruneUnlocked(neighbor, candidates, vectors, out_neighbors);
+  return butil::Status::OK();
+}
+
+void VectorIndexDiskAnn::RobustPruneUnlocked(uint32_t slot, const std::vector<Neighbor>& candidates,
+                                             const std::unordered_map<uint32_t, std::vector<float>>& vectors,
+                                             std::vector<uint32_t>& neighbors) {
+  neighbors.clear();
+  // alpha scales positive l2 distance only, ip distance is negative so prune it with alpha 1
+  float alpha = metric_type_ == pb::common::MetricType::METRIC_TYPE_L2 ? FLAGS_diskann_alpha : 1.0F;
+
+  std::vector<bool> pruned(candidates.size(), false);
+  for (size_t i = 0; i < candidates.size() && neighbors.size() < max_degree_; ++i) {
+    if (pruned[i] || candidates[i].second == slot) {
+      continue;
+    }
+    neighbors.push_back(candidates[i].second);
+
+    // drop candidates closer to the chosen neighbor than to slot, they are reachable through it
+    const float* chosen = vectors.at(candidates[i].second).data();
+    for (size_t j = i + 1; j < candidates.size(); ++j) {
+      if (!pruned[j] && alpha * Distance(chosen, vectors.at(candidates[j].second).data()) <= candidates[j].first) {
+        pruned[j] = true;
+      }
+    }
+  }
+}
+
+butil::Status VectorIndexDiskAnn::ApproxDistancesUnlocked(const float* query, const PqQuery& pq_query,
+                                                          const std::vector<uint32_t>& slots,
+                                                          std::vector<float>& distances) {
+  distances.resize(slots.size());
+  if (pq_trained_) {
+    size_t code_size = pq_->code_size;
+    size_t ksub = pq_->ksub;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      const uint8_t* code = pq_codes_.data() + static_cast<size_t>(slots[i]) * code_size;
+      float distance = 0;
+      for (size_t m = 0; m < pq_->M; ++m) {
+        distance += pq_query.distance_table[m * ksub + code[m]];
+      }
+      distances[i] = metric_type_ == pb::common::MetricType::METRIC_TYPE_L2 ? distance : -distance;
+    }
+    return butil::Status::OK();
+  }
+
+  std::vector<float> vectors;
+  auto status = vector_file_->BatchRead(slots, vectors);
+  if (!status.ok()) {
+    return status;
+  }
+  for (size_t i = 0; i < slots.size(); ++i) {
+    distances[i] = Distance(query, vectors.data() + i * dimension_);
+  }
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::BeamSearchUnlocked(
+    const float* query, uint32_t search_list_size, uint32_t beam_width, std::vector<Neighbor>& expanded,
+    std::unordered_map<uint32_t, std::vector<float>>* expanded_vectors) {
+  expanded.clear();
+  if (entry_slot_ == kInvalidSlot) {
+    return butil::Status::OK();
+  }
+  search_list_size = std::max(search_list_size, 1U);
+  beam_width = std::max(beam_width, 1U);
+
+  PqQuery pq_query;
+  if (pq_trained_) {
+    pq_query.distance_table.resize(pq_->M * pq_->ksub);
+    if (metric_type_ == pb::common::MetricType::METRIC_TYPE_L2) {
+      pq_->compute_distance_table(query, pq_query.distance_table.data());
+    } else {
+      pq_->compute_inner_prod_table(query, pq_query.distance_table.data());
+    }
+  }
+
+  struct Candidate {
+    float distance;
+    uint32_t slot;
+    bool expanded;
+  };
+  // sorted by approx distance, at most search_list_size
+  std::vector<Candidate> candidates;
+  std::unordered_set<uint32_t> visited;
+
+  std::vector<uint32_t> batch{entry_slot_};
+  std::vector<float> distances;
+  auto status = ApproxDistancesUnlocked(query, pq_query, batch, distances);
+  if (!status.ok()) {
+    return status;
+  }
+  visited.insert(entry_slot_);
+  candidates.push_back({distances[0], entry_slot_, false});
+
+  std::vector<float> batch_vectors;
+  std::vector<uint32_t> new_slots;
+  while (true) {
+    batch.clear();
+    for (auto& candidate : candidates) {
+      if (!candidate.expanded) {
+        candidate.expanded = true;
+        batch.push_back(candidate.slot);
+        if (batch.size() >= beam_width) {
+          break;
+        }
+      }
+    }
+    if (batch.empty()) {
+      break;
+    }
+
+    // full vectors of the beam in one batch, rerank by exact distance
+    status = vector_file_->BatchRead(batch, batch_vectors);
+    if (!status.ok()) {
+      return status;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const float* vector = batch_vectors.data() + i * dimension_;
+      expanded.emplace_back(Distance(query, vector), batch[i]);
+      if (expanded_vectors != nullptr) {
+        (*expanded_vectors)[batch[i]].assign(vector, vector + dimension_);
+      }
+    }
+
+    // the exact distance is known now, use it to steer the walk instead of the PQ distance
+    for (auto& candidate : candidates) {
+      if (candidate.expanded) {
+        auto it = std::find_if(expanded.end() - batch.size(), expanded.end(),
+                               [&](const Neighbor& neighbor) { return neighbor.second == candidate.slot; });
+        if (it != expanded.end()) {
+          candidate.distance = it->first;
+        }
+      }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate& lhs, const Candidate& rhs) { return lhs.distance < rhs.distance; });
+
+    new_slots.clear();
+    for (auto slot : batch) {
+      for (auto neighbor : graph_[slot]) {
+        if (visited.insert(neighbor).second) {
+          new_slots.push_back(neighbor);
+        }
+      }
+    }
+    if (new_slots.empty()) {
+      continue;
+    }
+
+    status = ApproxDistancesUnlocked(query, pq_query, new_slots, distances);
+    if (!status.ok()) {
+      return status;
+    }
+    for (size_t i = 0; i < new_slots.size(); ++i) {
+      if (candidates.size() >= search_list_size && distances[i] >= candidates.back().distance) {
+        continue;
+      }
+      auto pos =
+          std::upper_bound(candidates.begin(), candidates.end(), distances[i],
+                           [](float distance, const Candidate& candidate) { return distance < candidate.distance; });
+      candidates.insert(pos, {distances[i], new_slots[i], false});
+      if (candidates.size() > search_list_size) {
+        candidates.pop_back();
+      }
+    }
+  }
+
+  std::sort(expanded.begin(), expanded.end());
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::TrainPqUnlocked() {
+  uint32_t sub_dimension = std::max(FLAGS_diskann_pq_sub_dimension, 1);
+  uint32_t m = std::max(dimension_ / sub_dimension, 1U);
+  while (dimension_ % m != 0) {
+    --m;
+  }
+
+  // sample live vectors evenly
+  std::vector<uint32_t> train_slots;
+  int64_t train_count = std::max(FLAGS_diskann_pq_train_count, 256L);
+  int64_t step = std::max(static_cast<int64_t>(id_to_slot_.size()) / train_count, 1L);
+  int64_t live_pos = 0;
+  for (uint32_t slot = 0; slot < slot_ids_.size(); ++slot) {
+    if (slot_ids_[slot] >= 0 && (live_pos++) % step == 0) {
+      train_slots.push_back(slot);
+    }
+  }
+
+  std::vector<float> train_datas;
+  auto status = vector_file_->BatchRead(train_slots, train_datas);
+  if (!status.ok()) {
+    return status;
+  }
+
+  auto pq = std::make_unique<faiss::ProductQuantizer>(dimension_, m, kPqNbits);
+  std::vector<uint8_t> pq_codes(slot_ids_.size() * pq->code_size);
+  // use std::thread to call faiss functions
+  std::thread([&]() {
+    try {
+      pq->train(train_slots.size(), train_datas.data());
+
+      std::vector<uint32_t> slots;
+      std::vector<float> vectors;
+      for (uint32_t start = 0; start < slot_ids_.size() && status.ok(); start += kCopyBatchSlots) {
+        slots.clear();
+        for (uint32_t slot = start; slot < slot_ids_.size() && slot < start + kCopyBatchSlots; ++slot) {
+          slots.push_back(slot);
+        }
+        status = vector_file_->BatchRead(slots, vectors);
+        if (status.ok()) {
+          pq->compute_codes(vectors.data(), pq_codes.data() + static_cast<size_t>(start) * pq->code_size,
+                            slots.size());
+        }
+      }
+    } catch (std::exception& e) {
+      status = butil::Status(pb::error::Errno::EINTERNAL, fmt::format("train pq exception: {}", e.what()));
+    }
+  }).join();
+  if (!status.ok()) {
+    return status;
+  }
+
+  // start from the vector nearest to the mean, it is closer to most vectors than the first inserted one
+  std::vector<float> mean(dimension_, 0.0F);
+  for (size_t i = 0; i < train_slots.size(); ++i) {
+    for (uint32_t d = 0; d < dimension_; ++d) {
+      mean[d] += train_datas[i * dimension_ + d] / train_slots.size();
+    }
+  }
+  uint32_t entry_slot = entry_slot_;
+  float min_distance = std::numeric_limits<float>::max();
+  for (size_t i = 0; i < train_slots.size(); ++i) {
+    float distance = faiss::fvec_L2sqr(mean.data(), train_datas.data() + i * dimension_, dimension_);
+    if (distance < min_distance) {
+      min_distance = distance;
+      entry_slot = train_slots[i];
+    }
+  }
+
+  BthreadRWLock::WriteGuard guard(rw_lock_);
+  entry_slot_ = entry_slot;
+  pq_ = std::move(pq);
+  pq_codes_.swap(pq_codes);
+  pq_trained_ = true;
+
+  DINGO_LOG(INFO) << fmt::format("[vector_index.diskann][id({})] train pq success, m: {} train_count: {} count: {}",
+                                 Id(), m, train_slots.size(), slot_ids_.size());
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::Delete(const std::vector<int64_t>& delete_ids) {
+  if (delete_ids.empty()) {
+    return butil::Status::OK();
+  }
+
+  BAIDU_SCOPED_LOCK(write_mutex_);
+  BthreadRWLock::WriteGuard guard(rw_lock_);
+  for (auto vector_id : delete_ids) {
+    DeleteUnlocked(vector_id);
+  }
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::SearchUnlocked(const float* query, uint32_t topk, uint32_t search_list_size,
+                                                 uint32_t beam_width,
+                                                 const std::vector<std::shared_ptr<FilterFunctor>>& filters,
+                                                 std::vector<Neighbor>& results) {
+  results.clear();
+
+  std::vector<Neighbor> expanded;
+  auto status = BeamSearchUnlocked(query, std::max(search_list_size, topk), beam_width, expanded, nullptr);
+  if (!status.ok()) {
+    return status;
+  }
+
+  for (const auto& neighbor : expanded) {
+    if (results.size() >= topk) {
+      break;
+    }
+    if (CheckFilters(neighbor.second, filters)) {
+      results.push_back(neighbor);
+    }
+  }
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::Search(std::vector<pb::common::VectorWithId> vector_with_ids, uint32_t topk,
+                                         std::vector<std::shared_ptr<FilterFunctor>> filters, bool,
+                                         const pb::common::VectorSearchParameter& parameter,
+                                         std::vector<pb::index::VectorWithDistanceResult>& results) {
+  if (vector_with_ids.empty()) {
+    DINGO_LOG(WARNING) << "vector_with_ids is empty";
+    return butil::Status::OK();
+  }
+
+  if (topk == 0) {
+    DINGO_LOG(WARNING) << "topk is invalid";
+    return butil::Status::OK();
+  }
+
+  uint32_t search_list_size = FLAGS_diskann_search_list_size;
+  uint32_t beam_width = FLAGS_diskann_beam_width;
+  if (parameter.has_diskann()) {
+    if (parameter.diskann().search_list_size() > 0) {
+      search_list_size = parameter.diskann().search_list_size();
+    }
+    if (parameter.diskann().beam_width() > 0) {
+      beam_width = parameter.diskann().beam_width();
+    }
+  }
+
+  const auto& [vectors, status] = VectorIndexUtils::CheckAndCopyVectorData(vector_with_ids, dimension_, normalize_);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << status.error_cstr();
+    return status;
+  }
+
+  std::vector<faiss::Index::distance_t> distances(topk * vector_with_ids.size(), 0.0F);
+  std::vector<faiss::idx_t> labels(topk * vector_with_ids.size(), -1);
+
+  {
+    BthreadRWLock::ReadGuard guard(rw_lock_);
+    std::vector<Neighbor> neighbors;
+    for (size_t row = 0; row < vector_with_ids.size(); ++row) {
+      auto ret = SearchUnlocked(vectors.get() + row * dimension_, topk, search_list_size, beam_width, filters,
+                                neighbors);
+      if (!ret.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("[vector_index.diskann][id({})] search fail, error: {}", Id(),
+                                        ret.error_str());
+        return ret;
+      }
+
+      for (size_t i = 0; i < neighbors.size(); ++i) {
+        labels[row * topk + i] = slot_ids_[neighbors[i].second];
+        distances[row * topk + i] = ToFaissDistance(neighbors[i].first);
+      }
+    }
+  }
+
+  VectorIndexUtils::FillSearchResult(vector_with_ids, topk, distances, labels, metric_type_, dimension_, results);
+
+  DINGO_LOG(DEBUG) << "result.size() = " << results.size();
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::RangeSearch(std::vector<pb::common::VectorWithId> vector_with_ids, float radius,
+                                              std::vector<std::shared_ptr<VectorIndex::FilterFunctor>> filters,
+                                              bool /*reconstruct*/, const pb::common::VectorSearchParameter& parameter,
+                                              std::vector<pb::index::VectorWithDistanceResult>& results) {
+  if (vector_with_ids.empty()) {
+    DINGO_LOG(WARNING) << "vector_with_ids is empty";
+    return butil::Status::OK();
+  }
+
+  uint32_t search_list_size = FLAGS_diskann_search_list_size;
+  uint32_t beam_width = FLAGS_diskann_beam_width;
+  if (parameter.has_diskann()) {
+    if (parameter.diskann().search_list_size() > 0) {
+      search_list_size = parameter.diskann().search_list_size();
+    }
+    if (parameter.diskann().beam_width() > 0) {
+      beam_width = parameter.diskann().beam_width();
+    }
+  }
+
+  const auto& [vectors, status] = VectorIndexUtils::CheckAndCopyVectorData(vector_with_ids, dimension_, normalize_);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << status.error_cstr();
+    return status;
+  }
+
+  // same as faiss, l2 distance less than radius, or ip greater than 1 - radius
+  float max_distance = radius;
+  if (metric_type_ != pb::common::MetricType::METRIC_TYPE_L2) {
+    max_distance = -(1.0F - radius);
+  }
+
+  std::vector<std::vector<Neighbor>> matches(vector_with_ids.size());
+  {
+    BthreadRWLock::ReadGuard guard(rw_lock_);
+    std::vector<Neighbor> expanded;
+    for (size_t row = 0; row < vector_with_ids.size(); ++row) {
+      auto ret = BeamSearchUnlocked(vectors.get() + row * dimension_, search_list_size, beam_width, expanded, nullptr);
+      if (!ret.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("[vector_index.diskann][id({})] range search fail, error: {}", Id(),
+                                        ret.error_str());
+        return ret;
+      }
+
+      for (const auto& neighbor : expanded) {
+        if (neighbor.first >= max_distance) {
+          break;
+        }
+        if (CheckFilters(neighbor.second, filters)) {
+          matches[row].push_back(neighbor);
+        }
+      }
+    }
+
+    std::unique_ptr<faiss::RangeSearchResult> range_search_result =
+        std::make_unique<faiss::RangeSearchResult>(vector_with_ids.size());
+    for (size_t row = 0; row < matches.size(); ++row) {
+      range_search_result->lims[row] = matches[row].size();
+    }
+    range_search_result->do_allocation();
+    for (size_t row = 0; row < matches.size(); ++row) {
+      size_t offset = range_search_result->lims[row];
+      for (size_t i = 0; i < matches[row].size(); ++i) {
+        range_search_result->labels[offset + i] = slot_ids_[matches[row][i].second];
+        range_search_result->distances[offset + i] = ToFaissDistance(matches[row][i].first);
+      }
+    }
+
+    VectorIndexUtils::FillRangeSearchResult(range_search_result, metric_type_, dimension_, results);
+  }
+
+  DINGO_LOG(DEBUG) << "result.size() = " << results.size();
+
+  return butil::Status::OK();
+}
+
+void VectorIndexDiskAnn::LockWrite() { bthread_mutex_lock(&write_mutex_); }
+
+void VectorIndexDiskAnn::UnlockWrite() { bthread_mutex_unlock(&write_mutex_); }
+
+bool VectorIndexDiskAnn::SupportSave() { return true; }
+
+template <typename T>
+static void WriteValue(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool ReadValue(std::ifstream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+butil::Status VectorIndexDiskAnn::Save(const std::string& path) {
+  // Warning : read me first !!!!
+  // Currently, the save function is executed in the fork child process.
+  // When calling glog,
+  // the child process will hang.
+  // Remove glog temporarily.
+  if (BAIDU_UNLIKELY(path.empty())) {
+    std::string s = fmt::format("path empty. not support");
+    return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, s);
+  }
+
+  // The outside has been locked. Remove the locking operation here.
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    return butil::Status(pb::error::Errno::EINTERNAL,
+                         fmt::format("VectorIndexDiskAnn::Save open fail. path : {}", path));
+  }
+
+  // header
+  WriteValue(out, kDiskAnnFileMagic);
+  WriteValue(out, kDiskAnnFileVersion);
+  WriteValue(out, dimension_);
+  WriteValue(out, static_cast<int32_t>(metric_type_));
+  WriteValue(out, max_degree_);
+  WriteValue(out, static_cast<uint32_t>(slot_ids_.size()));
+  WriteValue(out, entry_slot_);
+  WriteValue(out, deleted_count_);
+
+  // pq
+  WriteValue(out, static_cast<uint8_t>(pq_trained_ ? 1 : 0));
+  if (pq_trained_) {
+    WriteValue(out, static_cast<uint32_t>(pq_->M));
+    WriteValue(out, static_cast<uint32_t>(pq_->nbits));
+    out.write(reinterpret_cast<const char*>(pq_->centroids.data()), pq_->centroids.size() * sizeof(float));
+    out.write(reinterpret_cast<const char*>(pq_codes_.data()), pq_codes_.size());
+  }
+
+  // graph
+  for (uint32_t slot = 0; slot < slot_ids_.size(); ++slot) {
+    WriteValue(out, slot_ids_[slot]);
+    WriteValue(out, static_cast<uint32_t>(graph_[slot].size()));
+    out.write(reinterpret_cast<const char*>(graph_[slot].data()), graph_[slot].size() * sizeof(uint32_t));
+  }
+
+  // full vectors
+  std::vector<uint32_t> slots;
+  std::vector<float> vectors;
+  for (uint32_t start = 0; start < slot_ids_.size(); start += kCopyBatchSlots) {
+    slots.clear();
+    for (uint32_t slot = start; slot < slot_ids_.size() && slot < start + kCopyBatchSlots; ++slot) {
+      slots.push_back(slot);
+    }
+    auto status = vector_file_->BatchRead(slots, vectors);
+    if (!status.ok()) {
+      return status;
+    }
+    out.write(reinterpret_cast<const char*>(vectors.data()), vectors.size() * sizeof(float));
+  }
+
+  out.flush();
+  if (!out.good()) {
+    return butil::Status(pb::error::Errno::EINTERNAL,
+                         fmt::format("VectorIndexDiskAnn::Save write fail. path : {}", path));
+  }
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::Load(const std::string& path) {
+  if (BAIDU_UNLIKELY(path.empty())) {
+    std::string s = fmt::format("path empty. not support");
+    DINGO_LOG(ERROR) << s;
+    return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, s);
+  }
+
+  auto load_error = [&path](const std::string& reason) {
+    std::string s = fmt::format("VectorIndexDiskAnn::Load {}. path : {}", reason, path);
+    DINGO_LOG(ERROR) << s;
+    return butil::Status(pb::error::Errno::EINTERNAL, s);
+  };
+
+  // The outside has been locked. Remove the locking operation here.
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    return load_error("open fail");
+  }
+
+  uint32_t magic = 0, version = 0, dimension = 0, max_degree = 0, slot_count = 0, entry_slot = 0;
+  int32_t metric_type = 0;
+  int64_t deleted_count = 0;
+  uint8_t pq_trained = 0;
+  if (!ReadValue(in, magic) || !ReadValue(in, version) || !ReadValue(in, dimension) || !ReadValue(in, metric_type) ||
+      !ReadValue(in, max_degree) || !ReadValue(in, slot_count) || !ReadValue(in, entry_slot) ||
+      !ReadValue(in, deleted_count) || !ReadValue(in, pq_trained)) {
+    return load_error("read header fail");
+  }
+  if (magic != kDiskAnnFileMagic || version != kDiskAnnFileVersion) {
+    return load_error(fmt::format("not diskann file, magic : {} version : {}", magic, version));
+  }
+  if (dimension != dimension_ || metric_type != static_cast<int32_t>(metric_type_)) {
+    return load_error(fmt::format("dimension : {} metric type : {} != local dimension : {} metric type : {}",
+                                  dimension, metric_type, dimension_, static_cast<int>(metric_type_)));
+  }
+
+  std::unique_ptr<faiss::ProductQuantizer> pq;
+  std::vector<uint8_t> pq_codes;
+  if (pq_trained != 0) {
+    uint32_t m = 0, nbits = 0;
+    if (!ReadValue(in, m) || !ReadValue(in, nbits) || m == 0 || dimension_ % m != 0 || nbits != kPqNbits) {
+      return load_error("read pq fail");
+    }
+    pq = std::make_unique<faiss::ProductQuantizer>(dimension_, m, nbits);
+    pq_codes.resize(static_cast<size_t>(slot_count) * pq->code_size);
+    if (!in.read(reinterpret_cast<char*>(pq->centroids.data()), pq->centroids.size() * sizeof(float)) ||
+        !in.read(reinterpret_cast<char*>(pq_codes.data()), pq_codes.size())) {
+      return load_error("read pq fail");
+    }
+  }
+
+  std::vector<int64_t> slot_ids(slot_count);
+  std::vector<std::vector<uint32_t>> graph(slot_count);
+  std::unordered_map<int64_t, uint32_t> id_to_slot;
+  for (uint32_t slot = 0; slot < slot_count; ++slot) {
+    uint32_t degree = 0;
+    if (!ReadValue(in, slot_ids[slot]) || !ReadValue(in, degree) || degree > max_degree) {
+      return load_error("read graph fail");
+    }
+    graph[slot].resize(degree);
+    if (!in.read(reinterpret_cast<char*>(graph[slot].data()), degree * sizeof(uint32_t))) {
+      return load_error("read graph fail");
+    }
+    for (auto neighbor : graph[slot]) {
+      if (neighbor >= slot_count) {
+        return load_error(fmt::format("neighbor {} of slot {} out of range", neighbor, slot));
+      }
+    }
+    if (slot_ids[slot] >= 0) {
+      id_to_slot[slot_ids[slot]] = slot;
+    }
+  }
+  if (slot_count > 0 && entry_slot >= slot_count) {
+    return load_error(fmt::format("entry slot {} out of range", entry_slot));
+  }
+
+  std::vector<float> vectors;
+  for (uint32_t start = 0; start < slot_count; start += kCopyBatchSlots) {
+    uint32_t count = std::min(kCopyBatchSlots, slot_count - start);
+    vectors.resize(static_cast<size_t>(count) * dimension_);
+    if (!in.read(reinterpret_cast<char*>(vectors.data()), vectors.size() * sizeof(float))) {
+      return load_error("read vectors fail");
+    }
+    auto status = vector_file_->Write(start, vectors.data(), count);
+    if (!status.ok()) {
+      return load_error(fmt::format("write vector file fail, {}", status.error_str()));
+    }
+  }
+
+  BthreadRWLock::WriteGuard guard(rw_lock_);
+  slot_ids_.swap(slot_ids);
+  graph_.swap(graph);
+  id_to_slot_.swap(id_to_slot);
+  entry_slot_ = slot_count > 0 ? entry_slot : kInvalidSlot;
+  deleted_count_ = deleted_count;
+  max_degree_ = std::max(max_degree_, max_degree);
+  pq_ = std::move(pq);
+  pq_codes_.swap(pq_codes);
+  pq_trained_ = pq_trained != 0;
+
+  DINGO_LOG(INFO) << fmt::format("VectorIndexDiskAnn::Load success. path : {} count : {} deleted : {}", path,
+                                 id_to_slot_.size(), deleted_count_);
+
+  return butil::Status::OK();
+}
+
+int32_t VectorIndexDiskAnn::GetDimension() { return this->dimension_; }
+
+pb::common::MetricType VectorIndexDiskAnn::GetMetricType() { return this->metric_type_; }
+
+butil::Status VectorIndexDiskAnn::GetCount(int64_t& count) {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  count = id_to_slot_.size();
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::GetDeletedCount(int64_t& deleted_count) {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  deleted_count = deleted_count_;
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexDiskAnn::GetMemorySize(int64_t& memory_size) {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  // full vectors are on disk, only graph, pq and id map are in memory
+  int64_t edge_count = 0;
+  for (const auto& neighbors : graph_) {
+    edge_count += neighbors.capacity();
+  }
+  memory_size = edge_count * sizeof(uint32_t) + graph_.size() * sizeof(std::vector<uint32_t>) +
+                slot_ids_.size() * sizeof(int64_t) + id_to_slot_.size() * (sizeof(int64_t) + sizeof(uint32_t)) * 2 +
+                pq_codes_.size();
+  if (pq_trained_) {
+    memory_size += pq_->centroids.size() * sizeof(float);
+  }
+  return butil::Status::OK();
+}
+
+bool VectorIndexDiskAnn::IsExceedsMaxElements() { return false; }
+
+bool VectorIndexDiskAnn::IsPqTrained() {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  return pq_trained_;
+}
+
+bool VectorIndexDiskAnn::NeedToRebuild() {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  int64_t element_count = slot_ids_.size();
+  if (element_count == 0 || deleted_count_ == 0) {
+    return false;
+  }
+
+  // deleted slots still cost graph memory and search hops
+  return deleted_count_ > element_count / 2;
+}
+
+bool VectorIndexDiskAnn::NeedToSave(int64_t last_save_log_behind) {
+  BthreadRWLock::ReadGuard guard(rw_lock_);
+  if (slot_ids_.empty()) {
+    return false;
+  }
+
+  return last_save_log_behind > FLAGS_diskann_need_save_count;
+}
+
+}  // namespace dingodb
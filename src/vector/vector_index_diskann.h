@@ -0,0 +1,207 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_VECTOR_INDEX_DISKANN_H_  // NOLINT
+#define DINGODB_VECTOR_INDEX_DISKANN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "butil/status.h"
+#include "common/synchronization.h"
+#include "faiss/impl/ProductQuantizer.h"
+#include "proto/common.pb.h"
+#include "proto/error.pb.h"
+#include "vector/vector_index.h"
+
+namespace dingodb {
+
+// Full precision vectors on local disk, one fixed size record per slot.
+class DiskAnnVectorFile {
+ public:
+  DiskAnnVectorFile(std::string path, uint32_t dimension);
+  ~DiskAnnVectorFile();
+
+  DiskAnnVectorFile(const DiskAnnVectorFile& rhs) = delete;
+  DiskAnnVectorFile& operator=(const DiskAnnVectorFile& rhs) = delete;
+
+  butil::Status Open();
+
+  // write count vectors to the records from slot
+  butil::Status Write(uint32_t slot, const float* vectors, uint32_t count);
+
+  // Read the vectors of slots into vectors, in the order of slots.
+  // Records are sorted and adjacent records are merged into one read, readahead of the whole batch is issued first,
+  // so the device serves the batch in parallel.
+  butil::Status BatchRead(const std::vector<uint32_t>& slots, std::vector<float>& vectors) const;
+
+  const std::string& Path() const { return path_; }
+
+ private:
+  std::string path_;
+  uint32_t dimension_;
+  int fd_;
+};
+
+// Disk resident vector index, the vamana graph of DiskANN.
+// The graph and the PQ codes of vectors are kept in memory, the full precision vectors are kept on local disk.
+// Search walks the graph with PQ distance, and reads the full vectors of beam_width candidates in one batch
+// per round to rerank them with exact distance.
+// Vectors are inserted incrementally, before PQ is trained the walk use exact distance too.
+// Deleted vectors are only marked, they still route the search until the index is rebuilt.
+// Writers are serialized by write_mutex_, they read the index without rw_lock_ and hold rw_lock_ exclusively only
+// to modify the in-memory state. Searches hold rw_lock_ shared, so no disk read runs under the exclusive lock.
+class VectorIndexDiskAnn : public VectorIndex {
+ public:
+  explicit VectorIndexDiskAnn(int64_t id, const pb::common::VectorIndexParameter& vector_index_parameter,
+                              const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
+
+  ~VectorIndexDiskAnn() override;
+
+  VectorIndexDiskAnn(const VectorIndexDiskAnn& rhs) = delete;
+  VectorIndexDiskAnn& operator=(const VectorIndexDiskAnn& rhs) = delete;
+  VectorIndexDiskAnn(VectorIndexDiskAnn&& rhs) = delete;
+  VectorIndexDiskAnn& operator=(VectorIndexDiskAnn&& rhs) = delete;
+
+  butil::Status Init();
+
+  butil::Status Save(const std::string& path) override;
+  butil::Status Load(const std::string& path) override;
+
+  butil::Status Add(const std::vector<pb::common::VectorWithId>& vector_with_ids) override;
+
+  butil::Status Upsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) override;
+
+  butil::Status Delete(const std::vector<int64_t>& delete_ids) override;
+
+  butil::Status Search(std::vector<pb::common::VectorWithId> vector_with_ids, uint32_t topk,
+                       std::vector<std::shared_ptr<FilterFunctor>> filters, bool reconstruct,
+                       const pb::common::VectorSearchParameter& parameter,
+                       std::vector<pb::index::VectorWithDistanceResult>& results) override;
+
+  butil::Status RangeSearch(std::vector<pb::common::VectorWithId> vector_with_ids, float radius,
+                            std::vector<std::shared_ptr<VectorIndex::FilterFunctor>> filters, bool reconstruct,
+                            const pb::common::VectorSearchParameter& parameter,
+                            std::vector<pb::index::VectorWithDistanceResult>& results) override;
+
+  void LockWrite() override;
+  void UnlockWrite() override;
+  bool SupportSave() override;
+
+  int32_t GetDimension() override;
+  pb::common::MetricType GetMetricType() override;
+  butil::Status GetCount(int64_t& count) override;
+  butil::Status GetDeletedCount(int64_t& deleted_count) override;
+  butil::Status GetMemorySize(int64_t& memory_size) override;
+  bool IsExceedsMaxElements() override;
+
+  // PQ is trained by the index itself when enough vectors are inserted.
+  butil::Status Train([[maybe_unused]] const std::vector<float>& train_datas) override { return butil::Status::OK(); }
+  butil::Status Train([[maybe_unused]] const std::vector<pb::common::VectorWithId>& vectors) override {
+    return butil::Status::OK();
+  }
+
+  bool NeedToRebuild() override;
+  bool NeedToSave(int64_t last_save_log_behind) override;
+
+  bool IsPqTrained();
+
+ private:
+  // distance is smaller for closer vectors, -ip for inner product.
+  using Neighbor = std::pair<float, uint32_t>;
+
+  // query context of PQ distance
+  struct PqQuery {
+    std::vector<float> distance_table;
+  };
+
+  // vector with the same id is replaced, both in Add and Upsert
+  butil::Status AddOrUpsert(const std::vector<pb::common::VectorWithId>& vector_with_ids);
+
+  // remove vector id from index, the slot is kept as a routing node
+  bool DeleteUnlocked(int64_t vector_id);
+
+  butil::Status InsertUnlocked(int64_t vector_id, const float* vector);
+
+  // Walk the graph from entry point, expanded holds the expanded slots sorted by exact distance.
+  // If expanded_vectors is not null, it holds the full vectors of expanded slots.
+  butil::Status BeamSearchUnlocked(const float* query, uint32_t search_list_size, uint32_t beam_width,
+                                   std::vector<Neighbor>& expanded,
+                                   std::unordered_map<uint32_t, std::vector<float>>* expanded_vectors);
+
+  // distance of query to slots, by PQ codes when trained, otherwise by the full vectors from disk
+  butil::Status ApproxDistancesUnlocked(const float* query, const PqQuery& pq_query,
+                                        const std::vector<uint32_t>& slots, std::vector<float>& distances);
+
+  // keep at most max_degree_ diverse neighbors from candidates, candidates are sorted by distance to slot
+  void RobustPruneUnlocked(uint32_t slot, const std::vector<Neighbor>& candidates,
+                           const std::unordered_map<uint32_t, std::vector<float>>& vectors,
+                           std::vector<uint32_t>& neighbors);
+
+  // out neighbors of neighbor with the back edge to slot, pruned when out degree exceeds max_degree_
+  butil::Status BackEdgeNeighborsUnlocked(uint32_t neighbor, uint32_t slot, std::vector<uint32_t>& out_neighbors);
+
+  butil::Status TrainPqUnlocked();
+
+  float Distance(const float* x, const float* y) const;
+
+  // convert internal distance to faiss style, ip is larger for closer vectors
+  float ToFaissDistance(float distance) const;
+
+  butil::Status SearchUnlocked(const float* query, uint32_t topk, uint32_t search_list_size, uint32_t beam_width,
+                               const std::vector<std::shared_ptr<FilterFunctor>>& filters,
+                               std::vector<Neighbor>& results);
+
+  bool CheckFilters(uint32_t slot, const std::vector<std::shared_ptr<FilterFunctor>>& filters) const;
+
+  uint32_t dimension_;
+
+  // only support L2 and IP
+  pb::common::MetricType metric_type_;
+
+  // normalize vector
+  bool normalize_;
+
+  // max out degree of graph node
+  uint32_t max_degree_;
+
+  bthread_mutex_t write_mutex_;
+  // searches wait for the writer in bthread, so a search blocked behind the writer doesn't block the worker pthread
+  BthreadRWLock rw_lock_;
+
+  std::unique_ptr<DiskAnnVectorFile> vector_file_;
+
+  // slot -> vector id, -1 means deleted
+  std::vector<int64_t> slot_ids_;
+  std::unordered_map<int64_t, uint32_t> id_to_slot_;
+  // slot -> out neighbors
+  std::vector<std::vector<uint32_t>> graph_;
+  uint32_t entry_slot_;
+  int64_t deleted_count_;
+
+  std::unique_ptr<faiss::ProductQuantizer> pq_;
+  bool pq_trained_;
+  // slot -> pq code, pq_->code_size bytes each
+  std::vector<uint8_t> pq_codes_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_VECTOR_INDEX_DISKANN_H_  // NOLINT
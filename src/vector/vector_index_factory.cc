@@ -24,22 +24,40 @@
 
 #include "butil/status.h"
 #include "common/logging.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 #include "server/server.h"
 #include "vector/vector_index.h"
 #include "vector/vector_index_bruteforce.h"
+#include "vector/vector_index_diskann.h"
 #include "vector/vector_index_flat.h"
 #include "vector/vector_index_hnsw.h"
 #include "vector/vector_index_ivf_flat.h"
 #include "vector/vector_index_ivf_pq.h"
+#include "vector/vector_index_segment.h"
 
 namespace dingodb {
 
+DEFINE_bool(enable_segment_vector_index, false, "enable segmented vector index for hnsw and ivf_flat");
+
 std::shared_ptr<VectorIndex> VectorIndexFactory::New(int64_t id,
                                                      const pb::common::VectorIndexParameter& index_parameter,
                                                      const pb::common::RegionEpoch& epoch,
                                                      const pb::common::Range& range) {
+  if (FLAGS_enable_segment_vector_index &&
+      (index_parameter.vector_index_type() == pb::common::VECTOR_INDEX_TYPE_HNSW ||
+       index_parameter.vector_index_type() == pb::common::VECTOR_INDEX_TYPE_IVF_FLAT)) {
+    return NewSegment(id, index_parameter, epoch, range);
+  }
+
+  return NewBase(id, index_parameter, epoch, range);
+}
+
+std::shared_ptr<VectorIndex> VectorIndexFactory::NewBase(int64_t id,
+                                                         const pb::common::VectorIndexParameter& index_parameter,
+                                                         const pb::common::RegionEpoch& epoch,
+                                                         const pb::common::Range& range) {
   std::shared_ptr<VectorIndex> vector_index = nullptr;
 
   switch (index_parameter.vector_index_type()) {
@@ -64,8 +82,7 @@ std::shared_ptr<VectorIndex> VectorIndexFactory::New(int64_t id,
       break;
     }
     case pb::common::VECTOR_INDEX_TYPE_DISKANN: {
-      DINGO_LOG(ERROR) << "vector_index_parameter = diskann not implement, type=" << index_parameter.vector_index_type()
-                       << ", id=" << id << ", parameter=" << index_parameter.ShortDebugString();
+      vector_index = NewDiskAnn(id, index_parameter, epoch, range);
       break;
     }
     case pb::common::VectorIndexType_INT_MIN_SENTINEL_DO_NOT_USE_:
@@ -84,6 +101,47 @@ std::shared_ptr<VectorIndex> VectorIndexFactory::New(int64_t id,
   return vector_index;
 }
 
+std::shared_ptr<VectorIndex> VectorIndexFactory::NewSegment(int64_t id,
+                                                            const pb::common::VectorIndexParameter& index_parameter,
+                                                            const pb::common::RegionEpoch& epoch,
+                                                            const pb::common::Range& range) {
+  // Segments are built at seal and merge, only validate parameter here.
+  if (!CheckSegmentParameter(index_parameter)) {
+    DINGO_LOG(ERROR) << "vector_index_parameter is illegal, id=" << id
+                     << ", parameter=" << index_parameter.ShortDebugString();
+    return nullptr;
+  }
+
+  try {
+    auto new_segment_index = std::make_shared<VectorIndexSegment>(id, index_parameter, epoch, range);
+    DINGO_LOG(INFO) << "create segment index success, id=" << id
+                    << ", parameter=" << index_parameter.ShortDebugString();
+    return new_segment_index;
+  } catch (std::exception& e) {
+    DINGO_LOG(ERROR) << "create segment index failed of exception occured, " << e.what() << ", id=" << id
+                     << ", parameter=" << index_parameter.ShortDebugString();
+    return nullptr;
+  }
+}
+
+bool VectorIndexFactory::CheckSegmentParameter(const pb::common::VectorIndexParameter& index_parameter) {
+  switch (index_parameter.vector_index_type()) {
+    case pb::common::VECTOR_INDEX_TYPE_HNSW: {
+      const auto& hnsw_parameter = index_parameter.hnsw_parameter();
+      return hnsw_parameter.dimension() > 0 &&
+             hnsw_parameter.metric_type() != pb::common::MetricType::METRIC_TYPE_NONE &&
+             hnsw_parameter.efconstruction() > 0 && hnsw_parameter.max_elements() > 0 && hnsw_parameter.nlinks() > 0;
+    }
+    case pb::common::VECTOR_INDEX_TYPE_IVF_FLAT: {
+      const auto& ivf_flat_parameter = index_parameter.ivf_flat_parameter();
+      return ivf_flat_parameter.dimension() > 0 &&
+             ivf_flat_parameter.metric_type() != pb::common::MetricType::METRIC_TYPE_NONE;
+    }
+    default:
+      return false;
+  }
+}
+
 std::shared_ptr<VectorIndex> VectorIndexFactory::NewHnsw(int64_t id,
                                                          const pb::common::VectorIndexParameter& index_parameter,
                                                          const pb::common::RegionEpoch& epoch,
@@ -324,4 +382,43 @@ std::shared_ptr<VectorIndex> VectorIndexFactory::NewIvfPq(int64_t id,
   }
 }
 
+std::shared_ptr<VectorIndex> VectorIndexFactory::NewDiskAnn(int64_t id,
+                                                            const pb::common::VectorIndexParameter& index_parameter,
+                                                            const pb::common::RegionEpoch& epoch,
+                                                            const pb::common::Range& range) {
+  const auto& diskann_parameter = index_parameter.diskann_parameter();
+
+  if (diskann_parameter.dimension() == 0) {
+    DINGO_LOG(ERROR) << "vector_index_parameter is illegal, dimension is 0";
+    return nullptr;
+  }
+  if (diskann_parameter.metric_type() == pb::common::MetricType::METRIC_TYPE_NONE) {
+    DINGO_LOG(ERROR) << "vector_index_parameter is illegal, METRIC_TYPE_NONE";
+    return nullptr;
+  }
+  if (diskann_parameter.num_neighbors() <= 0) {
+    DINGO_LOG(ERROR) << "vector_index_parameter is illegal, num_neighbors <= 0";
+    return nullptr;
+  }
+
+  // create index may throw exeception, so we need to catch it
+  try {
+    auto new_diskann_index = std::make_shared<VectorIndexDiskAnn>(id, index_parameter, epoch, range);
+    auto status = new_diskann_index->Init();
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << "create diskann index failed of init fail, " << status.error_str() << ", id=" << id
+                       << ", parameter=" << index_parameter.ShortDebugString();
+      return nullptr;
+    }
+
+    DINGO_LOG(INFO) << "create diskann index success, id=" << id
+                    << ", parameter=" << index_parameter.ShortDebugString();
+    return new_diskann_index;
+  } catch (std::exception& e) {
+    DINGO_LOG(ERROR) << "create diskann index failed of exception occured, " << e.what() << ", id=" << id
+                     << ", parameter=" << index_parameter.ShortDebugString();
+    return nullptr;
+  }
+}
+
 }  // namespace dingodb
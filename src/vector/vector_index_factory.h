@@ -44,7 +44,17 @@ class VectorIndexFactory {
   static std::shared_ptr<VectorIndex> New(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
                                           const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
 
+  // New vector index of the parameter type, never segmented, used by segment vector index.
+  static std::shared_ptr<VectorIndex> NewBase(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
+                                              const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
+
  private:
+  // Check parameter of segment vector index without building index, only hnsw and ivf_flat.
+  static bool CheckSegmentParameter(const pb::common::VectorIndexParameter& index_parameter);
+
+  static std::shared_ptr<VectorIndex> NewSegment(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
+                                                 const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
+
   static std::shared_ptr<VectorIndex> NewHnsw(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
                                               const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
 
@@ -60,6 +70,9 @@ class VectorIndexFactory {
   static std::shared_ptr<VectorIndex> NewBruteForce(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
                                                     const pb::common::RegionEpoch& epoch,
                                                     const pb::common::Range& range);
+
+  static std::shared_ptr<VectorIndex> NewDiskAnn(int64_t id, const pb::common::VectorIndexParameter& index_parameter,
+                                                 const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
 };
 
 }  // namespace dingodb
@@ -208,17 +208,18 @@ VectorIndexHnsw::VectorIndexHnsw(int64_t id, const pb::common::VectorIndexParame
     // let user_max_elements_<actual_max_elements.
     max_element_limit_ = hnsw_parameter.max_elements();
 
+    // small index(e.g. segment of segment vector index) not preallocate FLAGS_hnsw_max_init_max_elements.
+    uint32_t init_max_elements = std::min(FLAGS_hnsw_max_init_max_elements, hnsw_parameter.max_elements());
+
     DINGO_LOG(INFO) << fmt::format(
         "[vector_index.hnsw][id({})] create index, init_max_elements={} max_element_limit={} nlinks={} "
         "efconstruction={} "
         "metric_type={} dimension={}",
-        Id(), FLAGS_hnsw_max_init_max_elements, max_element_limit_, hnsw_parameter.nlinks(),
-        hnsw_parameter.efconstruction(), pb::common::MetricType_Name(hnsw_parameter.metric_type()),
-        hnsw_parameter.dimension());
+        Id(), init_max_elements, max_element_limit_, hnsw_parameter.nlinks(), hnsw_parameter.efconstruction(),
+        pb::common::MetricType_Name(hnsw_parameter.metric_type()), hnsw_parameter.dimension());
 
-    hnsw_index_ =
-        new hnswlib::HierarchicalNSW<float>(hnsw_space_, FLAGS_hnsw_max_init_max_elements, hnsw_parameter.nlinks(),
-                                            hnsw_parameter.efconstruction(), 100, false);
+    hnsw_index_ = new hnswlib::HierarchicalNSW<float>(hnsw_space_, init_max_elements, hnsw_parameter.nlinks(),
+                                                      hnsw_parameter.efconstruction(), 100, false);
   }
 }
 
@@ -0,0 +1,824 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vector/vector_index_segment.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "butil/status.h"
+#include "common/helper.h"
+#include "common/logging.h"
+#include "common/synchronization.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "proto/common.pb.h"
+#include "proto/error.pb.h"
+#include "vector/vector_index_factory.h"
+
+namespace dingodb {
+
+DEFINE_int64(vector_segment_mutable_max_count, 10000, "max vector count of mutable segment, exceed will seal");
+DEFINE_int32(vector_segment_max_num, 8, "max sealed segment num, exceed will merge the smallest segments");
+DEFINE_double(vector_segment_merge_tombstone_ratio, 0.3, "merge segment when tombstone ratio exceed");
+DEFINE_int32(vector_segment_search_max_extra_topk, 1024, "max extra topk for skip tombstone when search segment");
+DEFINE_int64(vector_segment_need_save_count, 10000, "segment vector index need save count");
+
+static const uint32_t kSegmentFileMagic = 0x44534547;  // "DSEG"
+static const uint32_t kSegmentFileVersion = 1;
+
+static int32_t GetDimensionFromParameter(const pb::common::VectorIndexParameter& parameter) {
+  switch (parameter.vector_index_type()) {
+    case pb::common::VECTOR_INDEX_TYPE_HNSW:
+      return parameter.hnsw_parameter().dimension();
+    case pb::common::VECTOR_INDEX_TYPE_IVF_FLAT:
+      return parameter.ivf_flat_parameter().dimension();
+    case pb::common::VECTOR_INDEX_TYPE_FLAT:
+      return parameter.flat_parameter().dimension();
+    default:
+      return 0;
+  }
+}
+
+static pb::common::MetricType GetMetricTypeFromParameter(const pb::common::VectorIndexParameter& parameter) {
+  switch (parameter.vector_index_type()) {
+    case pb::common::VECTOR_INDEX_TYPE_HNSW:
+      return parameter.hnsw_parameter().metric_type();
+    case pb::common::VECTOR_INDEX_TYPE_IVF_FLAT:
+      return parameter.ivf_flat_parameter().metric_type();
+    case pb::common::VECTOR_INDEX_TYPE_FLAT:
+      return parameter.flat_parameter().metric_type();
+    default:
+      return pb::common::METRIC_TYPE_NONE;
+  }
+}
+
+VectorIndexSegment::VectorIndexSegment(int64_t id, const pb::common::VectorIndexParameter& vector_index_parameter,
+                                       const pb::common::RegionEpoch& epoch, const pb::common::Range& range)
+    : VectorIndex(id, vector_index_parameter, epoch, range) {
+  dimension_ = GetDimensionFromParameter(vector_index_parameter);
+  metric_type_ = GetMetricTypeFromParameter(vector_index_parameter);
+
+  flat_parameter_.set_vector_index_type(pb::common::VECTOR_INDEX_TYPE_FLAT);
+  flat_parameter_.mutable_flat_parameter()->set_dimension(dimension_);
+  flat_parameter_.mutable_flat_parameter()->set_metric_type(metric_type_);
+
+  mutable_seq_ = next_seq_.fetch_add(1);
+  mutable_index_ = NewMutableIndex();
+
+  bthread_mutex_init(&mutex_, nullptr);
+  bthread_mutex_init(&merge_mutex_, nullptr);
+}
+
+VectorIndexSegment::~VectorIndexSegment() {
+  bthread_mutex_destroy(&mutex_);
+  bthread_mutex_destroy(&merge_mutex_);
+}
+
+VectorIndexPtr VectorIndexSegment::NewMutableIndex() {
+  return VectorIndexFactory::NewBase(Id(), flat_parameter_, Epoch(), Range());
+}
+
+butil::Status VectorIndexSegment::Add(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  return AddOrUpsert(vector_with_ids);
+}
+
+butil::Status VectorIndexSegment::Upsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  return AddOrUpsert(vector_with_ids);
+}
+
+butil::Status VectorIndexSegment::AddOrUpsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) {
+  if (vector_with_ids.empty()) {
+    return butil::Status::OK();
+  }
+
+  for (const auto& vector_with_id : vector_with_ids) {
+    if (vector_with_id.vector().float_values_size() != dimension_) {
+      return butil::Status(pb::error::Errno::EVECTOR_INVALID, "vector dimension not match, %d/%d",
+                           vector_with_id.vector().float_values_size(), dimension_);
+    }
+  }
+
+  bool need_merge = false;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    auto status = mutable_index_->Upsert(vector_with_ids);
+    if (!status.ok()) {
+      return status;
+    }
+
+    for (const auto& vector_with_id : vector_with_ids) {
+      int64_t vector_id = vector_with_id.id();
+      auto it = locator_.find(vector_id);
+      if (it != locator_.end() && it->second != mutable_seq_) {
+        // Old version in sealed segment become tombstone.
+        auto seg_it = segments_.find(it->second);
+        if (seg_it != segments_.end()) {
+          ++seg_it->second->tombstone_count;
+        }
+      }
+      locator_[vector_id] = mutable_seq_;
+
+      const auto& float_values = vector_with_id.vector().float_values();
+      mutable_vectors_[vector_id].assign(float_values.begin(), float_values.end());
+    }
+
+    if (static_cast<int64_t>(mutable_vectors_.size()) >= FLAGS_vector_segment_mutable_max_count) {
+      DoSeal();
+    }
+
+    need_merge = NeedMerge();
+  }
+
+  if (need_merge) {
+    LaunchMerge();
+  }
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexSegment::Delete(const std::vector<int64_t>& delete_ids) {
+  if (delete_ids.empty()) {
+    return butil::Status::OK();
+  }
+
+  bool need_merge = false;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    std::vector<int64_t> mutable_delete_ids;
+    for (auto vector_id : delete_ids) {
+      auto it = locator_.find(vector_id);
+      if (it == locator_.end()) {
+        continue;
+      }
+
+      if (it->second == mutable_seq_) {
+        mutable_delete_ids.push_back(vector_id);
+        mutable_vectors_.erase(vector_id);
+      } else {
+        auto seg_it = segments_.find(it->second);
+        if (seg_it != segments_.end()) {
+          ++seg_it->second->tombstone_count;
+        }
+      }
+      locator_.erase(it);
+    }
+
+    if (!mutable_delete_ids.empty()) {
+      auto status = mutable_index_->Delete(mutable_delete_ids);
+      if (!status.ok()) {
+        DINGO_LOG(WARNING) << fmt::format("[vector_index.segment][id({})] delete mutable segment failed, error: {}",
+                                          Id(), status.error_str());
+      }
+    }
+
+    need_merge = NeedMerge();
+  }
+
+  if (need_merge) {
+    LaunchMerge();
+  }
+
+  return butil::Status::OK();
+}
+
+bool VectorIndexSegment::IsLive(int64_t seq, int64_t vector_id) {
+  auto it = locator_.find(vector_id);
+  return it != locator_.end() && it->second == seq;
+}
+
+template <typename SearchFunc>
+butil::Status VectorIndexSegment::SearchAllSegments(size_t query_count, uint32_t topk, SearchFunc search_func,
+                                                    std::vector<pb::index::VectorWithDistanceResult>& results) {
+  std::vector<std::vector<pb::common::VectorWithDistance>> candidates(query_count);
+
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  auto collect_func = [&](int64_t seq, VectorIndexPtr index, int64_t tombstone_count) -> butil::Status {
+    uint32_t extra_topk = std::min(tombstone_count, static_cast<int64_t>(FLAGS_vector_segment_search_max_extra_topk));
+
+    std::vector<pb::index::VectorWithDistanceResult> segment_results;
+    auto status = search_func(index, extra_topk, segment_results);
+    if (!status.ok()) {
+      return status;
+    }
+
+    for (size_t i = 0; i < segment_results.size() && i < query_count; ++i) {
+      for (auto& vector_with_distance : *segment_results[i].mutable_vector_with_distances()) {
+        if (IsLive(seq, vector_with_distance.vector_with_id().id())) {
+          candidates[i].push_back(std::move(vector_with_distance));
+        }
+      }
+    }
+
+    return butil::Status::OK();
+  };
+
+  auto status = collect_func(mutable_seq_, mutable_index_, 0);
+  if (!status.ok()) {
+    return status;
+  }
+  for (auto& [seq, segment] : segments_) {
+    status = collect_func(seq, segment->index, segment->tombstone_count);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  // Merge all segment result, distance smaller is better.
+  results.resize(query_count);
+  for (size_t i = 0; i < query_count; ++i) {
+    auto& query_candidates = candidates[i];
+    size_t count = std::min(static_cast<size_t>(topk), query_candidates.size());
+    std::partial_sort(query_candidates.begin(), query_candidates.begin() + count, query_candidates.end(),
+                      [](const pb::common::VectorWithDistance& lhs, const pb::common::VectorWithDistance& rhs) {
+                        return lhs.distance() < rhs.distance();
+                      });
+    for (size_t j = 0; j < count; ++j) {
+      results[i].add_vector_with_distances()->Swap(&query_candidates[j]);
+    }
+  }
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexSegment::Search(std::vector<pb::common::VectorWithId> vector_with_ids, uint32_t topk,
+                                         std::vector<std::shared_ptr<FilterFunctor>> filters, bool reconstruct,
+                                         const pb::common::VectorSearchParameter& parameter,
+                                         std::vector<pb::index::VectorWithDistanceResult>& results) {
+  if (vector_with_ids.empty() || topk == 0) {
+    return butil::Status::OK();
+  }
+
+  return SearchAllSegments(
+      vector_with_ids.size(), topk,
+      [&](VectorIndexPtr index, uint32_t extra_topk, std::vector<pb::index::VectorWithDistanceResult>& seg_results) {
+        return index->Search(vector_with_ids, topk + extra_topk, filters, reconstruct, parameter, seg_results);
+      },
+      results);
+}
+
+butil::Status VectorIndexSegment::RangeSearch(std::vector<pb::common::VectorWithId> vector_with_ids, float radius,
+                                              std::vector<std::shared_ptr<VectorIndex::FilterFunctor>> filters,
+                                              bool reconstruct, const pb::common::VectorSearchParameter& parameter,
+                                              std::vector<pb::index::VectorWithDistanceResult>& results) {
+  if (vector_with_ids.empty()) {
+    return butil::Status::OK();
+  }
+
+  return SearchAllSegments(
+      vector_with_ids.size(), UINT32_MAX,
+      [&](VectorIndexPtr index, uint32_t, std::vector<pb::index::VectorWithDistanceResult>& seg_results) {
+        return index->RangeSearch(vector_with_ids, radius, filters, reconstruct, parameter, seg_results);
+      },
+      results);
+}
+
+butil::Status VectorIndexSegment::Seal() {
+  bool need_merge = false;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+    DoSeal();
+    need_merge = NeedMerge();
+  }
+
+  if (need_merge) {
+    LaunchMerge();
+  }
+
+  return butil::Status::OK();
+}
+
+void VectorIndexSegment::DoSeal() {
+  if (mutable_vectors_.empty()) {
+    return;
+  }
+
+  // Mutable flat segment become a sealed segment directly, convert it to base index type at merge.
+  auto segment = std::make_shared<Segment>();
+  segment->seq = mutable_seq_;
+  segment->index = mutable_index_;
+  segment->is_flat = true;
+  segment->ids.reserve(mutable_vectors_.size());
+  segment->datas.reserve(mutable_vectors_.size() * dimension_);
+  for (auto& [vector_id, datas] : mutable_vectors_) {
+    segment->ids.push_back(vector_id);
+    segment->datas.insert(segment->datas.end(), datas.begin(), datas.end());
+  }
+
+  segments_[segment->seq] = segment;
+
+  DINGO_LOG(INFO) << fmt::format("[vector_index.segment][id({})] seal segment({}) count({}) segment num({})", Id(),
+                                 segment->seq, segment->ids.size(), segments_.size());
+
+  mutable_seq_ = next_seq_.fetch_add(1);
+  mutable_index_ = NewMutableIndex();
+  mutable_vectors_.clear();
+}
+
+bool VectorIndexSegment::NeedMerge() {
+  if (static_cast<int32_t>(segments_.size()) > FLAGS_vector_segment_max_num) {
+    return true;
+  }
+
+  for (auto& [_, segment] : segments_) {
+    if (segment->is_flat && !segment->build_failed) {
+      return true;
+    }
+    if (segment->tombstone_count > segment->ids.size() * FLAGS_vector_segment_merge_tombstone_ratio) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void VectorIndexSegment::LaunchMerge() {
+  if (is_merging_.exchange(true)) {
+    return;
+  }
+
+  std::weak_ptr<VectorIndexSegment> weak_self = weak_from_this();
+  Bthread bth(&BTHREAD_ATTR_NORMAL);
+  bth.Run([weak_self]() {
+    auto self = weak_self.lock();
+    if (self == nullptr) {
+      return;
+    }
+
+    while (self->Merge() > 0) {
+      BAIDU_SCOPED_LOCK(self->mutex_);
+      if (!self->NeedMerge()) {
+        break;
+      }
+    }
+
+    self->is_merging_.store(false);
+  });
+}
+
+std::vector<VectorIndexSegment::SegmentPtr> VectorIndexSegment::PickMergeSegments() {
+  std::vector<SegmentPtr> picked_segments;
+  std::vector<SegmentPtr> other_segments;
+  for (auto& [_, segment] : segments_) {
+    if ((segment->is_flat && !segment->build_failed) ||
+        segment->tombstone_count > segment->ids.size() * FLAGS_vector_segment_merge_tombstone_ratio) {
+      picked_segments.push_back(segment);
+    } else {
+      other_segments.push_back(segment);
+    }
+  }
+
+  // Too many segments, merge the smallest segments.
+  if (static_cast<int32_t>(segments_.size()) > FLAGS_vector_segment_max_num) {
+    std::sort(other_segments.begin(), other_segments.end(),
+              [](const SegmentPtr& lhs, const SegmentPtr& rhs) { return lhs->LiveCount() < rhs->LiveCount(); });
+    for (auto& segment : other_segments) {
+      if (static_cast<int32_t>(segments_.size() - picked_segments.size()) + 1 <= FLAGS_vector_segment_max_num &&
+          picked_segments.size() >= 2) {
+        break;
+      }
+      picked_segments.push_back(segment);
+    }
+  }
+
+  return picked_segments;
+}
+
+pb::common::VectorIndexParameter VectorIndexSegment::SegmentParameter(int64_t count) {
+  auto parameter = VectorIndexParameter();
+  // Sealed segment is immutable, avoid preallocate the max elements of the whole region.
+  if (parameter.vector_index_type() == pb::common::VECTOR_INDEX_TYPE_HNSW) {
+    parameter.mutable_hnsw_parameter()->set_max_elements(std::max(count, static_cast<int64_t>(1)));
+  }
+  return parameter;
+}
+
+std::vector<pb::common::VectorWithId> VectorIndexSegment::ToVectorWithIds(const std::vector<int64_t>& ids,
+                                                                          const std::vector<float>& datas) {
+  std::vector<pb::common::VectorWithId> vector_with_ids;
+  vector_with_ids.resize(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    auto& vector_with_id = vector_with_ids[i];
+    vector_with_id.set_id(ids[i]);
+    auto* vector = vector_with_id.mutable_vector();
+    vector->set_dimension(dimension_);
+    vector->set_value_type(pb::common::ValueType::FLOAT);
+    vector->mutable_float_values()->Add(datas.begin() + i * dimension_, datas.begin() + (i + 1) * dimension_);
+  }
+  return vector_with_ids;
+}
+
+VectorIndexSegment::SegmentPtr VectorIndexSegment::BuildSegment(int64_t seq, std::vector<int64_t>& ids,
+                                                                std::vector<float>& datas) {
+  auto segment = std::make_shared<Segment>();
+  segment->seq = seq;
+
+  auto vector_with_ids = ToVectorWithIds(ids, datas);
+
+  segment->index = VectorIndexFactory::NewBase(Id(), SegmentParameter(ids.size()), Epoch(), Range());
+  if (segment->index != nullptr && !vector_with_ids.empty()) {
+    auto status = segment->index->Add(vector_with_ids);
+    if (!status.ok()) {
+      DINGO_LOG(WARNING) << fmt::format(
+          "[vector_index.segment][id({})] build segment({}) failed, use flat instead, error: {}", Id(), seq,
+          status.error_str());
+      segment->index = nullptr;
+    }
+  }
+
+  // Fallback flat segment.
+  if (segment->index == nullptr) {
+    segment->index = VectorIndexFactory::NewBase(Id(), flat_parameter_, Epoch(), Range());
+    segment->is_flat = true;
+    segment->build_failed = true;
+    if (segment->index == nullptr || !segment->index->Add(vector_with_ids).ok()) {
+      return nullptr;
+    }
+  }
+
+  segment->ids.swap(ids);
+  segment->datas.swap(datas);
+
+  return segment;
+}
+
+int32_t VectorIndexSegment::Merge() {
+  // Only one merge at a time, avoid building the same segments repeatedly.
+  BAIDU_SCOPED_LOCK(merge_mutex_);
+
+  int64_t start_time = Helper::TimestampMs();
+
+  std::vector<SegmentPtr> picked_segments;
+  std::vector<int64_t> ids;
+  std::vector<float> datas;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+    picked_segments = PickMergeSegments();
+    if (picked_segments.empty()) {
+      return 0;
+    }
+
+    // Only collect live vectors, tombstones are dropped.
+    for (auto& segment : picked_segments) {
+      for (size_t i = 0; i < segment->ids.size(); ++i) {
+        if (IsLive(segment->seq, segment->ids[i])) {
+          ids.push_back(segment->ids[i]);
+          datas.insert(datas.end(), segment->datas.begin() + i * dimension_,
+                       segment->datas.begin() + (i + 1) * dimension_);
+        }
+      }
+    }
+  }
+
+  // All vectors are tombstone, just drop segments.
+  if (ids.empty()) {
+    BAIDU_SCOPED_LOCK(mutex_);
+    for (auto& segment : picked_segments) {
+      segments_.erase(segment->seq);
+    }
+    return picked_segments.size();
+  }
+
+  // Build new segment without lock.
+  int64_t new_seq = next_seq_.fetch_add(1);
+  auto new_segment = BuildSegment(new_seq, ids, datas);
+  if (new_segment == nullptr) {
+    DINGO_LOG(ERROR) << fmt::format("[vector_index.segment][id({})] build merge segment failed.", Id());
+    return 0;
+  }
+
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    std::set<int64_t> picked_seqs;
+    for (auto& segment : picked_segments) {
+      picked_seqs.insert(segment->seq);
+    }
+
+    // Vectors deleted or upserted during merge become tombstone of new segment.
+    for (auto vector_id : new_segment->ids) {
+      auto it = locator_.find(vector_id);
+      if (it != locator_.end() && picked_seqs.count(it->second) > 0) {
+        it->second = new_seq;
+      } else {
+        ++new_segment->tombstone_count;
+      }
+    }
+
+    for (auto seq : picked_seqs) {
+      segments_.erase(seq);
+    }
+    segments_[new_seq] = new_segment;
+  }
+
+  DINGO_LOG(INFO) << fmt::format(
+      "[vector_index.segment][id({})] merge {} segments to segment({}) count({}) elapsed time {}ms", Id(),
+      picked_segments.size(), new_seq, new_segment->ids.size(), Helper::TimestampMs() - start_time);
+
+  return picked_segments.size();
+}
+
+std::string VectorIndexSegment::SegmentIndexPath(const std::string& path, int64_t seq) {
+  return fmt::format("{}.segment_{}", path, seq);
+}
+
+bool VectorIndexSegment::NeedToSave(int64_t last_save_log_behind) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  if (locator_.empty() && segments_.empty()) {
+    return false;
+  }
+
+  return last_save_log_behind > FLAGS_vector_segment_need_save_count;
+}
+
+butil::Status VectorIndexSegment::Save(const std::string& path) {
+  // Save is executed in the fork child process, must not call DINGO_LOG.
+  // The outside has been locked by LockWrite(), segments are not changed.
+  if (BAIDU_UNLIKELY(path.empty())) {
+    return butil::Status(pb::error::Errno::EILLEGAL_PARAMTETERS, "path empty. not support");
+  }
+
+  std::ofstream ofile(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+  if (!ofile.is_open()) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "open file %s failed", path.c_str());
+  }
+
+  auto write_value = [&ofile](const auto& value) {
+    ofile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto write_array = [&ofile](const auto& values) {
+    int64_t size = values.size();
+    ofile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    ofile.write(reinterpret_cast<const char*>(values.data()), size * sizeof(values[0]));
+  };
+
+  write_value(kSegmentFileMagic);
+  write_value(kSegmentFileVersion);
+  write_value(dimension_);
+  write_value(next_seq_.load());
+
+  // Mutable segment, rebuild flat index at load.
+  std::vector<int64_t> mutable_ids;
+  std::vector<float> mutable_datas;
+  mutable_ids.reserve(mutable_vectors_.size());
+  mutable_datas.reserve(mutable_vectors_.size() * dimension_);
+  for (const auto& [vector_id, datas] : mutable_vectors_) {
+    mutable_ids.push_back(vector_id);
+    mutable_datas.insert(mutable_datas.end(), datas.begin(), datas.end());
+  }
+  write_value(mutable_seq_);
+  write_array(mutable_ids);
+  write_array(mutable_datas);
+
+  // Sealed segments, the index of base index type is saved, flat segment is rebuilt at load.
+  write_value(static_cast<int64_t>(segments_.size()));
+  for (const auto& [seq, segment] : segments_) {
+    bool has_index_file = !segment->is_flat && segment->index->SupportSave();
+    if (has_index_file) {
+      auto status = segment->index->Save(SegmentIndexPath(path, seq));
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
+    write_value(seq);
+    write_value(static_cast<uint8_t>(segment->is_flat));
+    write_value(static_cast<uint8_t>(has_index_file));
+    write_array(segment->ids);
+    write_array(segment->datas);
+  }
+
+  // Locator decide which segment own the live vector, tombstone count is recalculated at load.
+  std::vector<int64_t> locator_pairs;
+  locator_pairs.reserve(locator_.size() * 2);
+  for (const auto& [vector_id, seq] : locator_) {
+    locator_pairs.push_back(vector_id);
+    locator_pairs.push_back(seq);
+  }
+  write_array(locator_pairs);
+
+  ofile.close();
+  if (!ofile.good()) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "write file %s failed", path.c_str());
+  }
+
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexSegment::Load(const std::string& path) {
+  std::ifstream ifile(path, std::ifstream::in | std::ifstream::binary);
+  if (!ifile.is_open()) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "open file %s failed", path.c_str());
+  }
+
+  auto read_value = [&ifile](auto& value) {
+    ifile.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return ifile.good();
+  };
+  auto read_array = [&ifile](auto& values) {
+    int64_t size = 0;
+    ifile.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!ifile.good() || size < 0) {
+      return false;
+    }
+    values.resize(size);
+    ifile.read(reinterpret_cast<char*>(values.data()), size * sizeof(values[0]));
+    return ifile.good();
+  };
+
+  uint32_t magic = 0, version = 0;
+  int32_t dimension = 0;
+  int64_t next_seq = 0;
+  if (!read_value(magic) || !read_value(version) || !read_value(dimension) || !read_value(next_seq) ||
+      magic != kSegmentFileMagic || version != kSegmentFileVersion || dimension != dimension_) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "invalid segment vector index file %s", path.c_str());
+  }
+
+  int64_t mutable_seq = 0;
+  std::vector<int64_t> mutable_ids;
+  std::vector<float> mutable_datas;
+  if (!read_value(mutable_seq) || !read_array(mutable_ids) || !read_array(mutable_datas) ||
+      mutable_datas.size() != mutable_ids.size() * dimension_) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "read mutable segment failed, file %s", path.c_str());
+  }
+
+  auto mutable_index = NewMutableIndex();
+  if (mutable_index == nullptr) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "new mutable segment index failed");
+  }
+  if (!mutable_ids.empty()) {
+    auto status = mutable_index->Upsert(ToVectorWithIds(mutable_ids, mutable_datas));
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  int64_t segment_count = 0;
+  if (!read_value(segment_count)) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "read segment count failed, file %s", path.c_str());
+  }
+
+  std::map<int64_t, SegmentPtr> segments;
+  for (int64_t i = 0; i < segment_count; ++i) {
+    auto segment = std::make_shared<Segment>();
+    uint8_t is_flat = 0, has_index_file = 0;
+    if (!read_value(segment->seq) || !read_value(is_flat) || !read_value(has_index_file) ||
+        !read_array(segment->ids) || !read_array(segment->datas) ||
+        segment->datas.size() != segment->ids.size() * dimension_) {
+      return butil::Status(pb::error::Errno::EINTERNAL, "read segment failed, file %s", path.c_str());
+    }
+    segment->is_flat = is_flat != 0;
+
+    if (has_index_file != 0) {
+      segment->index = VectorIndexFactory::NewBase(Id(), SegmentParameter(segment->ids.size()), Epoch(), Range());
+      if (segment->index == nullptr) {
+        return butil::Status(pb::error::Errno::EINTERNAL, "new segment index failed");
+      }
+      auto status = segment->index->Load(SegmentIndexPath(path, segment->seq));
+      if (!status.ok()) {
+        return status;
+      }
+    } else {
+      segment->index = VectorIndexFactory::NewBase(Id(), flat_parameter_, Epoch(), Range());
+      if (segment->index == nullptr) {
+        return butil::Status(pb::error::Errno::EINTERNAL, "new flat segment index failed");
+      }
+      if (!segment->ids.empty()) {
+        auto status = segment->index->Add(ToVectorWithIds(segment->ids, segment->datas));
+        if (!status.ok()) {
+          return status;
+        }
+      }
+    }
+
+    segments[segment->seq] = segment;
+  }
+
+  std::vector<int64_t> locator_pairs;
+  if (!read_array(locator_pairs) || locator_pairs.size() % 2 != 0) {
+    return butil::Status(pb::error::Errno::EINTERNAL, "read locator failed, file %s", path.c_str());
+  }
+
+  std::unordered_map<int64_t, int64_t> locator;
+  locator.reserve(locator_pairs.size() / 2);
+  for (size_t i = 0; i < locator_pairs.size(); i += 2) {
+    locator[locator_pairs[i]] = locator_pairs[i + 1];
+  }
+
+  std::unordered_map<int64_t, std::vector<float>> mutable_vectors;
+  for (size_t i = 0; i < mutable_ids.size(); ++i) {
+    mutable_vectors[mutable_ids[i]].assign(mutable_datas.begin() + i * dimension_,
+                                           mutable_datas.begin() + (i + 1) * dimension_);
+  }
+
+  bool need_merge = false;
+  {
+    BAIDU_SCOPED_LOCK(mutex_);
+
+    mutable_seq_ = mutable_seq;
+    mutable_index_ = mutable_index;
+    mutable_vectors_.swap(mutable_vectors);
+    segments_.swap(segments);
+    locator_.swap(locator);
+    next_seq_.store(next_seq);
+
+    for (auto& [seq, segment] : segments_) {
+      segment->tombstone_count = 0;
+      for (auto vector_id : segment->ids) {
+        if (!IsLive(seq, vector_id)) {
+          ++segment->tombstone_count;
+        }
+      }
+    }
+
+    need_merge = NeedMerge();
+  }
+
+  DINGO_LOG(INFO) << fmt::format("[vector_index.segment][id({})] load segment index from {}, segment num({})", Id(),
+                                 path, segment_count);
+
+  if (need_merge) {
+    LaunchMerge();
+  }
+
+  return butil::Status::OK();
+}
+
+int32_t VectorIndexSegment::SegmentCount() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return segments_.size() + 1;
+}
+
+void VectorIndexSegment::LockWrite() { bthread_mutex_lock(&mutex_); }
+
+void VectorIndexSegment::UnlockWrite() { bthread_mutex_unlock(&mutex_); }
+
+int32_t VectorIndexSegment::GetDimension() { return dimension_; }
+
+pb::common::MetricType VectorIndexSegment::GetMetricType() { return metric_type_; }
+
+butil::Status VectorIndexSegment::GetCount(int64_t& count) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  count = locator_.size();
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexSegment::GetDeletedCount(int64_t& deleted_count) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  deleted_count = 0;
+  for (auto& [_, segment] : segments_) {
+    deleted_count += segment->tombstone_count;
+  }
+  return butil::Status::OK();
+}
+
+butil::Status VectorIndexSegment::GetMemorySize(int64_t& memory_size) {
+  BAIDU_SCOPED_LOCK(mutex_);
+
+  memory_size = 0;
+  int64_t index_memory_size = 0;
+  mutable_index_->GetMemorySize(index_memory_size);
+  memory_size += index_memory_size + mutable_vectors_.size() * (dimension_ * sizeof(float) + sizeof(int64_t));
+
+  for (auto& [_, segment] : segments_) {
+    index_memory_size = 0;
+    segment->index->GetMemorySize(index_memory_size);
+    memory_size += index_memory_size + segment->ids.size() * sizeof(int64_t) + segment->datas.size() * sizeof(float);
+  }
+
+  memory_size += locator_.size() * sizeof(int64_t) * 2;
+
+  return butil::Status::OK();
+}
+
+bool VectorIndexSegment::IsExceedsMaxElements() {
+  if (vector_index_parameter.vector_index_type() != pb::common::VECTOR_INDEX_TYPE_HNSW) {
+    return false;
+  }
+
+  BAIDU_SCOPED_LOCK(mutex_);
+  return static_cast<int64_t>(locator_.size()) >= vector_index_parameter.hnsw_parameter().max_elements();
+}
+
+}  // namespace dingodb
@@ -0,0 +1,168 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_VECTOR_INDEX_SEGMENT_H_  // NOLINT
+#define DINGODB_VECTOR_INDEX_SEGMENT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "butil/status.h"
+#include "proto/common.pb.h"
+#include "proto/index.pb.h"
+#include "vector/vector_index.h"
+
+namespace dingodb {
+
+// LSM-style vector index.
+// Writes go to a small mutable flat segment, when it is full it is sealed as an immutable segment.
+// Sealed segments are never modified, delete and upsert just leave a tombstone on the old segment.
+// Background merge rebuilds small/flat/dirty segments into one segment of the base index type(hnsw/ivf_flat),
+// and drops tombstones, so the whole region is rarely rebuilt from scratch.
+class VectorIndexSegment : public VectorIndex, public std::enable_shared_from_this<VectorIndexSegment> {
+ public:
+  VectorIndexSegment(int64_t id, const pb::common::VectorIndexParameter& vector_index_parameter,
+                     const pb::common::RegionEpoch& epoch, const pb::common::Range& range);
+  ~VectorIndexSegment() override;
+
+  VectorIndexSegment(const VectorIndexSegment& rhs) = delete;
+  VectorIndexSegment& operator=(const VectorIndexSegment& rhs) = delete;
+  VectorIndexSegment(VectorIndexSegment&& rhs) = delete;
+  VectorIndexSegment& operator=(VectorIndexSegment&& rhs) = delete;
+
+  // Immutable segment.
+  struct Segment {
+    int64_t seq{0};
+    VectorIndexPtr index;
+    // Raw vectors of segment, used by merge.
+    std::vector<int64_t> ids;
+    std::vector<float> datas;
+    // Vector count which deleted or upserted to newer segment.
+    int64_t tombstone_count{0};
+    // Segment is not the base index type, e.g. sealed from mutable flat segment.
+    bool is_flat{false};
+    // Base index build failed and fell back to flat, building it again would fail the same way, so it is only
+    // merged for tombstones or segment num. It is not persisted, retry after reload.
+    bool build_failed{false};
+
+    int64_t LiveCount() const { return static_cast<int64_t>(ids.size()) - tombstone_count; }
+  };
+  using SegmentPtr = std::shared_ptr<Segment>;
+
+  butil::Status Add(const std::vector<pb::common::VectorWithId>& vector_with_ids) override;
+  butil::Status Upsert(const std::vector<pb::common::VectorWithId>& vector_with_ids) override;
+  butil::Status Delete(const std::vector<int64_t>& delete_ids) override;
+
+  butil::Status Search(std::vector<pb::common::VectorWithId> vector_with_ids, uint32_t topk,
+                       std::vector<std::shared_ptr<FilterFunctor>> filters, bool reconstruct,
+                       const pb::common::VectorSearchParameter& parameter,
+                       std::vector<pb::index::VectorWithDistanceResult>& results) override;
+
+  butil::Status RangeSearch(std::vector<pb::common::VectorWithId> vector_with_ids, float radius,
+                            std::vector<std::shared_ptr<VectorIndex::FilterFunctor>> filters, bool reconstruct,
+                            const pb::common::VectorSearchParameter& parameter,
+                            std::vector<pb::index::VectorWithDistanceResult>& results) override;
+
+  void LockWrite() override;
+  void UnlockWrite() override;
+
+  int32_t GetDimension() override;
+  pb::common::MetricType GetMetricType() override;
+  butil::Status GetCount(int64_t& count) override;
+  butil::Status GetDeletedCount(int64_t& deleted_count) override;
+  butil::Status GetMemorySize(int64_t& memory_size) override;
+  bool IsExceedsMaxElements() override;
+
+  butil::Status Train([[maybe_unused]] const std::vector<float>& train_datas) override { return butil::Status::OK(); }
+  butil::Status Train([[maybe_unused]] const std::vector<pb::common::VectorWithId>& vectors) override {
+    return butil::Status::OK();
+  }
+
+  // Merge segments instead of rebuild whole vector index.
+  bool NeedToRebuild() override { return false; }
+  bool NeedToSave(int64_t last_save_log_behind) override;
+  bool SupportSave() override { return true; }
+
+  // Save raw vectors and locator to path, the index of non-flat segment is saved to SegmentIndexPath().
+  // Save need the caller to do LockWrite() and UnlockWrite().
+  butil::Status Save(const std::string& path) override;
+  butil::Status Load(const std::string& path) override;
+
+  // Seal mutable segment.
+  butil::Status Seal();
+  // Merge sealed segments, return merged segment count.
+  int32_t Merge();
+
+  int32_t SegmentCount();
+
+ private:
+  butil::Status AddOrUpsert(const std::vector<pb::common::VectorWithId>& vector_with_ids);
+
+  // Must hold write lock.
+  void DoSeal();
+  bool NeedMerge();
+  void LaunchMerge();
+
+  VectorIndexPtr NewMutableIndex();
+  // Parameter of base index type which capacity is just the vector count of segment.
+  pb::common::VectorIndexParameter SegmentParameter(int64_t count);
+  std::vector<pb::common::VectorWithId> ToVectorWithIds(const std::vector<int64_t>& ids,
+                                                        const std::vector<float>& datas);
+  SegmentPtr BuildSegment(int64_t seq, std::vector<int64_t>& ids, std::vector<float>& datas);
+  static std::string SegmentIndexPath(const std::string& path, int64_t seq);
+  std::vector<SegmentPtr> PickMergeSegments();
+
+  // Must hold read lock.
+  bool IsLive(int64_t seq, int64_t vector_id);
+
+  template <typename SearchFunc>
+  butil::Status SearchAllSegments(size_t query_count, uint32_t topk, SearchFunc search_func,
+                                  std::vector<pb::index::VectorWithDistanceResult>& results);
+
+  int32_t dimension_;
+  pb::common::MetricType metric_type_;
+
+  // Parameter of mutable flat segment.
+  pb::common::VectorIndexParameter flat_parameter_;
+
+  // Protect all segments and locator.
+  bthread_mutex_t mutex_;
+
+  std::atomic<int64_t> next_seq_{1};
+
+  // Mutable segment
+  int64_t mutable_seq_;
+  VectorIndexPtr mutable_index_;
+  std::unordered_map<int64_t, std::vector<float>> mutable_vectors_;
+
+  // Sealed segments, seq: segment
+  std::map<int64_t, SegmentPtr> segments_;
+
+  // Vector id locate segment seq which own the latest version.
+  std::unordered_map<int64_t, int64_t> locator_;
+
+  std::atomic<bool> is_merging_{false};
+  // Serialize background merge and manual merge.
+  bthread_mutex_t merge_mutex_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_VECTOR_INDEX_SEGMENT_H_  // NOLINT
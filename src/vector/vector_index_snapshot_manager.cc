@@ -37,11 +37,13 @@
 #include "butil/status.h"
 #include "common/failpoint.h"
 #include "common/file_reader.h"
+#include "common/file_transfer.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "common/service_access.h"
 #include "common/synchronization.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 #include "proto/file_service.pb.h"
@@ -54,6 +56,7 @@
 namespace dingodb {
 
 DEFINE_bool(vector_index_snapshot_use_fork, true, "Use fork to save vector index snapshot.");
+DEFINE_bool(enable_stream_file_transfer, true, "Use brpc stream to transfer vector index snapshot file.");
 
 // Get all snapshot path, except tmp dir.
 static std::vector<std::string> GetSnapshotPaths(std::string path) {
@@ -426,14 +429,68 @@ butil::Status VectorIndexSnapshotManager::DownloadSnapshotFile(const std::string
     Helper::CreateDirectory(tmp_snapshot_path);
   }
 
-  for (const auto& filename : meta.filenames()) {
+  std::vector<std::string> filenames(meta.filenames().begin(), meta.filenames().end());
+  auto status = FLAGS_enable_stream_file_transfer
+                    ? FileTransfer::DownloadFiles(endpoint, reader_id, filenames, tmp_snapshot_path)
+                    : DownloadFileByChunk(endpoint, reader_id, meta.vector_index_id(), filenames, tmp_snapshot_path);
+  if (status.error_code() == pb::error::ENOT_SUPPORT) {
+    // rolling upgrade, the peer is old version without GetFileStream
+    DINGO_LOG(WARNING) << fmt::format(
+        "[vector_index.snapshot][index({})] peer {} not support stream file transfer, fall back to GetFile, error: {}",
+        meta.vector_index_id(), Helper::EndPointToStr(endpoint), status.error_str());
+    status = DownloadFileByChunk(endpoint, reader_id, meta.vector_index_id(), filenames, tmp_snapshot_path);
+  }
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format(
+        "[vector_index.snapshot][index({})] download vector index snapshot failed, error: {}", meta.vector_index_id(),
+        status.error_str());
+    return status;
+  }
+
+  if (snapshot_set->IsExistSnapshot(meta.snapshot_log_index())) {
+    std::string msg =
+        fmt::format("[vector_index.snapshot][index({})] already exist vector index snapshot snapshot_log_index {}",
+                    meta.vector_index_id(), meta.snapshot_log_index());
+    DINGO_LOG(INFO) << msg;
+    return butil::Status(pb::error::EVECTOR_SNAPSHOT_EXIST, msg);
+  }
+
+  // Todo: lock rename
+  // Rename
+  std::string new_snapshot_path = GetSnapshotNewPath(meta.vector_index_id(), meta.snapshot_log_index());
+  status = Helper::Rename(tmp_snapshot_path, new_snapshot_path);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format(
+        "[vector_index.snapshot][index({})] rename vector index snapshot failed, {} -> {} error: {}",
+        meta.vector_index_id(), tmp_snapshot_path, new_snapshot_path, status.error_str());
+    return status;
+  }
+
+  auto new_snapshot = vector_index::SnapshotMeta::New(meta.vector_index_id(), new_snapshot_path);
+  if (!new_snapshot->Init()) {
+    return butil::Status(pb::error::EINTERNAL, "Init snapshot failed, path: %s", new_snapshot_path.c_str());
+  }
+
+  if (!snapshot_set->AddSnapshot(new_snapshot)) {
+    return butil::Status(pb::error::EVECTOR_SNAPSHOT_EXIST, "Already exist vector index snapshot, path: %s",
+                         new_snapshot_path.c_str());
+  }
+
+  return butil::Status();
+}
+
+butil::Status VectorIndexSnapshotManager::DownloadFileByChunk(const butil::EndPoint& endpoint, int64_t reader_id,
+                                                              int64_t vector_index_id,
+                                                              const std::vector<std::string>& filenames,
+                                                              const std::string& dirpath) {
+  for (const auto& filename : filenames) {
     int64_t offset = 0;
     std::ofstream ofile;
 
-    std::string filepath = fmt::format("{}/{}", tmp_snapshot_path, filename);
+    std::string filepath = fmt::format("{}/{}", dirpath, filename);
     ofile.open(filepath, std::ofstream::out | std::ofstream::binary);
     DINGO_LOG(INFO) << fmt::format("[vector_index.snapshot][index({})] get vector index snapshot file: {}",
-                                   meta.vector_index_id(), filepath);
+                                   vector_index_id, filepath);
 
     for (;;) {
       pb::fileservice::GetFileRequest request;
@@ -442,7 +499,7 @@ butil::Status VectorIndexSnapshotManager::DownloadSnapshotFile(const std::string
       request.set_offset(offset);
       request.set_size(Constant::kFileTransportChunkSize);
 
-      DINGO_LOG(DEBUG) << fmt::format("[vector_index.snapshot][index({})] GetFileRequest: {}", meta.vector_index_id(),
+      DINGO_LOG(DEBUG) << fmt::format("[vector_index.snapshot][index({})] GetFileRequest: {}", vector_index_id,
                                       request.ShortDebugString());
 
       butil::IOBuf buf;
@@ -451,7 +508,7 @@ butil::Status VectorIndexSnapshotManager::DownloadSnapshotFile(const std::string
         return butil::Status(pb::error::EINTERNAL, "Get file failed");
       }
 
-      DINGO_LOG(DEBUG) << fmt::format("[vector_index.snapshot][index({})] GetFileResponse: {}", meta.vector_index_id(),
+      DINGO_LOG(DEBUG) << fmt::format("[vector_index.snapshot][index({})] GetFileResponse: {}", vector_index_id,
                                       response->ShortDebugString());
 
       // Write local file.
@@ -467,35 +524,6 @@ butil::Status VectorIndexSnapshotManager::DownloadSnapshotFile(const std::string
     ofile.close();
   }
 
-  if (snapshot_set->IsExistSnapshot(meta.snapshot_log_index())) {
-    std::string msg =
-        fmt::format("[vector_index.snapshot][index({})] already exist vector index snapshot snapshot_log_index {}",
-                    meta.vector_index_id(), meta.snapshot_log_index());
-    DINGO_LOG(INFO) << msg;
-    return butil::Status(pb::error::EVECTOR_SNAPSHOT_EXIST, msg);
-  }
-
-  // Todo: lock rename
-  // Rename
-  std::string new_snapshot_path = GetSnapshotNewPath(meta.vector_index_id(), meta.snapshot_log_index());
-  auto status = Helper::Rename(tmp_snapshot_path, new_snapshot_path);
-  if (!status.ok()) {
-    DINGO_LOG(ERROR) << fmt::format(
-        "[vector_index.snapshot][index({})] rename vector index snapshot failed, {} -> {} error: {}",
-        meta.vector_index_id(), tmp_snapshot_path, new_snapshot_path, status.error_str());
-    return status;
-  }
-
-  auto new_snapshot = vector_index::SnapshotMeta::New(meta.vector_index_id(), new_snapshot_path);
-  if (!new_snapshot->Init()) {
-    return butil::Status(pb::error::EINTERNAL, "Init snapshot failed, path: %s", new_snapshot_path.c_str());
-  }
-
-  if (!snapshot_set->AddSnapshot(new_snapshot)) {
-    return butil::Status(pb::error::EVECTOR_SNAPSHOT_EXIST, "Already exist vector index snapshot, path: %s",
-                         new_snapshot_path.c_str());
-  }
-
   return butil::Status();
 }
 
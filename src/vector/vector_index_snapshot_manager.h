@@ -73,6 +73,9 @@ class VectorIndexSnapshotManager {
   static std::string GetSnapshotNewPath(int64_t vector_index_id, int64_t snapshot_log_id);
   static butil::Status DownloadSnapshotFile(const std::string& uri, const pb::node::VectorIndexSnapshotMeta& meta,
                                             vector_index::SnapshotMetaSetPtr snapshot_set);
+  // Download file by repeated GetFile request, used when stream file transfer disabled.
+  static butil::Status DownloadFileByChunk(const butil::EndPoint& endpoint, int64_t reader_id, int64_t vector_index_id,
+                                           const std::vector<std::string>& filenames, const std::string& dirpath);
 };
 
 }  // namespace dingodb
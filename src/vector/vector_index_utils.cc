@@ -14,6 +14,7 @@
 
 #include "vector/vector_index_utils.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdint>
@@ -559,6 +560,36 @@ butil::Status VectorIndexUtils::FillSearchResult(const std::vector<pb::common::V
   return butil::Status::OK();
 }
 
+void VectorIndexUtils::MergeSearchResult(
+    std::vector<std::vector<pb::index::VectorWithDistanceResult>>& region_results, uint32_t batch_size, uint32_t topk,
+    std::vector<pb::index::VectorWithDistanceResult>& results) {
+  results.resize(batch_size);
+  for (uint32_t row = 0; row < batch_size; ++row) {
+    std::vector<pb::common::VectorWithDistance*> candidates;
+    for (auto& region_result : region_results) {
+      if (row >= region_result.size()) {
+        continue;
+      }
+      for (auto& vector_with_distance : *region_result[row].mutable_vector_with_distances()) {
+        candidates.push_back(&vector_with_distance);
+      }
+    }
+
+    size_t count = std::min(candidates.size(), static_cast<size_t>(topk));
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const pb::common::VectorWithDistance* lhs, const pb::common::VectorWithDistance* rhs) {
+                        if (lhs->distance() != rhs->distance()) {
+                          return lhs->distance() < rhs->distance();
+                        }
+                        return lhs->vector_with_id().id() < rhs->vector_with_id().id();
+                      });
+
+    for (size_t i = 0; i < count; ++i) {
+      results[row].add_vector_with_distances()->Swap(candidates[i]);
+    }
+  }
+}
+
 butil::Status VectorIndexUtils::FillRangeSearchResult(
     const std::unique_ptr<faiss::RangeSearchResult>& range_search_result, pb::common::MetricType metric_type,
     faiss::idx_t dimension, std::vector<pb::index::VectorWithDistanceResult>& results) {
@@ -665,6 +696,20 @@ butil::Status VectorIndexUtils::CheckVectorIndexParameterCompatibility(const pb:
                            "source_ivf_pq_parameter.ncentroids() != target_ivf_pq_parameter.ncentroids()");
     }
     return butil::Status::OK();
+  } else if (source.vector_index_type() == pb::common::VectorIndexType::VECTOR_INDEX_TYPE_DISKANN) {
+    const auto& source_diskann_parameter = source.diskann_parameter();
+    const auto& target_diskann_parameter = target.diskann_parameter();
+    if (source_diskann_parameter.dimension() != target_diskann_parameter.dimension()) {
+      DINGO_LOG(INFO) << "source_diskann_parameter.dimension() != target_diskann_parameter.dimension()";
+      return butil::Status(pb::error::EMERGE_VECTOR_INDEX_PARAMETER_NOT_MATCH,
+                           "source_diskann_parameter.dimension() != target_diskann_parameter.dimension()");
+    }
+    if (source_diskann_parameter.metric_type() != target_diskann_parameter.metric_type()) {
+      DINGO_LOG(INFO) << "source_diskann_parameter.metric_type() != target_diskann_parameter.metric_type()";
+      return butil::Status(pb::error::EMERGE_VECTOR_INDEX_PARAMETER_NOT_MATCH,
+                           "source_diskann_parameter.metric_type() != target_diskann_parameter.metric_type()");
+    }
+    return butil::Status::OK();
   } else {
     DINGO_LOG(ERROR) << "source.vector_index_type() is not supported";
     return butil::Status(pb::error::EMERGE_VECTOR_INDEX_TYPE_NOT_MATCH, "source.vector_index_type() is not supported");
@@ -183,6 +183,12 @@ class VectorIndexUtils {
   static butil::Status FillRangeSearchResult(const std::unique_ptr<faiss::RangeSearchResult>& range_search_result,
                                              pb::common::MetricType metric_type, faiss::idx_t dimension,
                                              std::vector<pb::index::VectorWithDistanceResult>& results);
+  // Merge search results of multiple regions, every element of region_results is the batch result of one region.
+  // Keep global topk of every query by ascending distance, ties are broken by vector id.
+  static void MergeSearchResult(std::vector<std::vector<pb::index::VectorWithDistanceResult>>& region_results,
+                                uint32_t batch_size, uint32_t topk,
+                                std::vector<pb::index::VectorWithDistanceResult>& results);
+
   static butil::Status CheckVectorIndexParameterCompatibility(const pb::common::VectorIndexParameter& source,
                                                               const pb::common::VectorIndexParameter& target);
   static butil::Status ValidateVectorIndexParameter(const pb::common::VectorIndexParameter& vector_index_parameter);
@@ -1095,6 +1095,8 @@ butil::Status VectorReader::SetVectorIndexFilter(VectorIndexWrapperPtr vector_in
     } else {
       // do nothing
     }
+  } else if (vector_index->Type() == pb::common::VECTOR_INDEX_TYPE_DISKANN) {
+    filters.push_back(std::make_shared<VectorIndex::FlatListFilterFunctor>(vector_ids));
   }
   return butil::Status::OK();
 }
@@ -48,6 +48,11 @@ class MockCoordinatorProxy final : public CoordinatorProxy {
   MOCK_METHOD(Status, TsoService,
               (const pb::meta::TsoRequest& request, pb::meta::TsoResponse& response),
               (override));
+
+  MOCK_METHOD(Status, GenerateAutoIncrement,
+              (const pb::meta::GenerateAutoIncrementRequest& request,
+               pb::meta::GenerateAutoIncrementResponse& response),
+              (override));
 };
 
 }  // namespace sdk
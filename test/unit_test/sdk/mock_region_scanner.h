@@ -55,6 +55,11 @@ class MockRegionScannerFactory : public RegionScannerFactory {
   MOCK_METHOD(Status, NewRegionScanner,
               (const ClientStub& stub, std::shared_ptr<Region> region, std::unique_ptr<RegionScanner>& scanner),
               (override));
+
+  MOCK_METHOD(Status, NewRegionScannerWithRange,
+              (const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+               std::unique_ptr<RegionScanner>& scanner),
+              (override));
 };
 
 }  // namespace sdk
@@ -0,0 +1,143 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "auto_increment_manager.h"
+#include "gtest/gtest.h"
+#include "mock_coordinator_proxy.h"
+#include "param_config.h"
+
+namespace dingodb {
+namespace sdk {
+class AutoIncrementManagerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    coordinator_proxy = std::make_shared<MockCoordinatorProxy>();
+    manager = std::make_shared<AutoIncrementerManager>(coordinator_proxy);
+  }
+
+  void TearDown() override { manager.reset(); }
+
+  std::shared_ptr<MockCoordinatorProxy> coordinator_proxy;
+  std::shared_ptr<AutoIncrementerManager> manager;
+};
+
+TEST_F(AutoIncrementManagerTest, GetNextIdsFromCache) {
+  std::atomic<int64_t> next_start_id{100};
+  std::atomic<int> call_count{0};
+
+  EXPECT_CALL(*coordinator_proxy, GenerateAutoIncrement)
+      .WillRepeatedly([&](const pb::meta::GenerateAutoIncrementRequest& request,
+                          pb::meta::GenerateAutoIncrementResponse& response) {
+        EXPECT_EQ(request.table_id().entity_id(), 1);
+        EXPECT_EQ(request.auto_increment_increment(), 1);
+        EXPECT_EQ(request.auto_increment_offset(), 1);
+        int64_t start_id = next_start_id.fetch_add(request.count());
+        response.set_start_id(start_id);
+        response.set_end_id(start_id + request.count());
+        call_count++;
+        return Status::OK();
+      });
+
+  auto auto_incrementer = manager->GetOrCreate(1);
+  EXPECT_EQ(auto_incrementer, manager->GetOrCreate(1));
+
+  int64_t last_id = 0;
+  int64_t total_count = 0;
+  for (int i = 0; i < 100; ++i) {
+    std::vector<int64_t> ids;
+    Status ret = auto_incrementer->GetNextIds(37, ids);
+    EXPECT_TRUE(ret.IsOK());
+    EXPECT_EQ(ids.size(), 37);
+    for (auto id : ids) {
+      EXPECT_GT(id, last_id);
+      last_id = id;
+    }
+    total_count += ids.size();
+  }
+
+  // ids are fetched in batch, not one request per call
+  EXPECT_LE(call_count.load(), total_count / kAutoIncrementCacheCount + 2);
+}
+
+TEST_F(AutoIncrementManagerTest, GetNextIdsMoreThanCache) {
+  EXPECT_CALL(*coordinator_proxy, GenerateAutoIncrement)
+      .WillOnce([&](const pb::meta::GenerateAutoIncrementRequest& request,
+                    pb::meta::GenerateAutoIncrementResponse& response) {
+        EXPECT_EQ(request.count(), kAutoIncrementCacheCount * 2);
+        response.set_start_id(1);
+        response.set_end_id(1 + request.count());
+        return Status::OK();
+      })
+      .WillRepeatedly([&](const pb::meta::GenerateAutoIncrementRequest& request,
+                          pb::meta::GenerateAutoIncrementResponse& response) {
+        response.set_start_id(1000000);
+        response.set_end_id(1000000 + request.count());
+        return Status::OK();
+      });
+
+  std::vector<int64_t> ids;
+  Status ret = manager->GetOrCreate(1)->GetNextIds(kAutoIncrementCacheCount * 2, ids);
+  EXPECT_TRUE(ret.IsOK());
+  EXPECT_EQ(ids.size(), kAutoIncrementCacheCount * 2);
+  EXPECT_EQ(ids.front(), 1);
+  EXPECT_EQ(ids.back(), kAutoIncrementCacheCount * 2);
+}
+
+TEST_F(AutoIncrementManagerTest, DropStaleRange) {
+  std::atomic<int> call_count{0};
+
+  // the second range overlaps with the first one
+  EXPECT_CALL(*coordinator_proxy, GenerateAutoIncrement)
+      .WillRepeatedly([&](const pb::meta::GenerateAutoIncrementRequest& request,
+                          pb::meta::GenerateAutoIncrementResponse& response) {
+        int call = call_count++;
+        int64_t start_id = call == 1 ? 500 : call * 10000 + 1;
+        response.set_start_id(start_id);
+        response.set_end_id(start_id + request.count());
+        return Status::OK();
+      });
+
+  auto auto_incrementer = manager->GetOrCreate(1);
+  int64_t last_id = 0;
+  for (int i = 0; i < 3; ++i) {
+    std::vector<int64_t> ids;
+    Status ret = auto_incrementer->GetNextIds(kAutoIncrementCacheCount, ids);
+    EXPECT_TRUE(ret.IsOK());
+    for (auto id : ids) {
+      EXPECT_GT(id, last_id);
+      last_id = id;
+    }
+  }
+}
+
+TEST_F(AutoIncrementManagerTest, GenerateFail) {
+  EXPECT_CALL(*coordinator_proxy, GenerateAutoIncrement)
+      .WillOnce(testing::Return(Status::RemoteError("generate fail")));
+
+  std::vector<int64_t> ids;
+  Status ret = manager->GetOrCreate(1)->GetNextIds(10, ids);
+  EXPECT_TRUE(ret.IsRemoteError());
+  EXPECT_TRUE(ids.empty());
+
+  ret = manager->GetOrCreate(1)->GetNextIds(0, ids);
+  EXPECT_TRUE(ret.IsInvalidArgument());
+}
+
+}  // namespace sdk
+}  // namespace dingodb
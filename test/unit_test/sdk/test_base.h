@@ -18,6 +18,7 @@
 #include <memory>
 
 #include "admin_tool.h"
+#include "auto_increment_manager.h"
 #include "client.h"
 #include "client_internal_data.h"
 #include "glog/logging.h"
@@ -69,6 +70,10 @@ class TestBase : public ::testing::Test {
     ON_CALL(*stub, GetTxnLockResolver).WillByDefault(testing::Return(txn_lock_resolver));
     EXPECT_CALL(*stub, GetTxnLockResolver).Times(testing::AnyNumber());
 
+    auto_increment_manager = std::make_shared<AutoIncrementerManager>(coordinator_proxy);
+    ON_CALL(*stub, GetAutoIncrementerManager).WillByDefault(testing::Return(auto_increment_manager));
+    EXPECT_CALL(*stub, GetAutoIncrementerManager).Times(testing::AnyNumber());
+
     client = new Client();
     client->data_->stub = std::move(tmp);
   }
@@ -94,6 +99,7 @@ class TestBase : public ::testing::Test {
   std::shared_ptr<MockRegionScannerFactory> region_scanner_factory;
   std::shared_ptr<AdminTool> admin_tool;
   std::shared_ptr<MockTxnLockResolver> txn_lock_resolver;
+  std::shared_ptr<AutoIncrementerManager> auto_increment_manager;
 
   // client own stub
   MockClientStub* stub;
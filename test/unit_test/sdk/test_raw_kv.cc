@@ -11,6 +11,7 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
@@ -1371,5 +1372,173 @@ TEST_F(RawKVTest, ScanRegionDiscontinuousWithLimit) {
     EXPECT_EQ(kv.key, kv.value);
   }
 }
+static void MockRegionScannerWithDatas(const ClientStub& stub, std::shared_ptr<Region> region,
+                                       std::unique_ptr<RegionScanner>& scanner,
+                                       const std::vector<std::string>& fake_datas, int& iter) {
+  auto mock_scanner = std::make_unique<MockRegionScanner>(stub, std::move(region));
+
+  EXPECT_CALL(*mock_scanner, Open).WillOnce(testing::Return(Status::OK()));
+
+  EXPECT_CALL(*mock_scanner, HasMore).WillRepeatedly([&]() { return iter < fake_datas.size(); });
+
+  EXPECT_CALL(*mock_scanner, NextBatch).WillRepeatedly([&](std::vector<KVPair>& kvs) {
+    if (iter < fake_datas.size()) {
+      kvs.push_back({fake_datas[iter], fake_datas[iter]});
+      iter++;
+    }
+    return Status::OK();
+  });
+
+  scanner = std::move(mock_scanner);
+}
+
+TEST_F(RawKVTest, NewScannerInvalid) {
+  std::unique_ptr<RangeScanner> scanner;
+  ScanOptions options;
+  Status ret = raw_kv->NewScanner("a", "", options, scanner);
+  EXPECT_TRUE(ret.IsInvalidArgument());
+
+  ret = raw_kv->NewScanner("c", "a", options, scanner);
+  EXPECT_TRUE(ret.IsInvalidArgument());
+
+  options.concurrency = 0;
+  ret = raw_kv->NewScanner("a", "c", options, scanner);
+  EXPECT_TRUE(ret.IsInvalidArgument());
+
+  EXPECT_EQ(scanner.get(), nullptr);
+}
+
+TEST_F(RawKVTest, NewScannerNotFoundRegion) {
+  std::unique_ptr<RangeScanner> scanner;
+  Status ret = raw_kv->NewScanner("x", "z", ScanOptions(), scanner);
+  EXPECT_TRUE(ret.IsNotFound());
+}
+
+TEST_F(RawKVTest, ScannerOrderedThreeRegion) {
+  std::vector<std::string> a2c_fake_datas = {"a002", "a003", "b001"};
+  int a2c_iter = 0;
+
+  std::vector<std::string> c2e_fake_datas = {"c001", "c002", "c003"};
+  int c2e_iter = 0;
+
+  std::vector<std::string> e2g_fake_datas = {"e001", "f001"};
+  int e2g_iter = 0;
+
+  EXPECT_CALL(*region_scanner_factory, NewRegionScannerWithRange)
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        EXPECT_EQ(region->Range().start_key(), "a");
+        EXPECT_EQ(start_key, "a002");
+        EXPECT_EQ(end_key, "c");
+        MockRegionScannerWithDatas(stub, std::move(region), scanner, a2c_fake_datas, a2c_iter);
+        return Status::OK();
+      })
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        EXPECT_EQ(region->Range().start_key(), "c");
+        EXPECT_EQ(start_key, "c");
+        EXPECT_EQ(end_key, "e");
+        MockRegionScannerWithDatas(stub, std::move(region), scanner, c2e_fake_datas, c2e_iter);
+        return Status::OK();
+      })
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        EXPECT_EQ(region->Range().start_key(), "e");
+        EXPECT_EQ(start_key, "e");
+        EXPECT_EQ(end_key, "f002");
+        MockRegionScannerWithDatas(stub, std::move(region), scanner, e2g_fake_datas, e2g_iter);
+        return Status::OK();
+      });
+
+  ScanOptions options;
+  options.concurrency = 2;
+  options.prefetch_batch_count = 1;
+
+  // the first and last region only scan the part in [a002, f002)
+  std::unique_ptr<RangeScanner> scanner;
+  Status ret = raw_kv->NewScanner("a002", "f002", options, scanner);
+  EXPECT_TRUE(ret.IsOK());
+
+  std::vector<KVPair> result;
+  while (scanner->HasMore()) {
+    std::vector<KVPair> kvs;
+    ret = scanner->NextBatch(kvs);
+    EXPECT_TRUE(ret.IsOK());
+    result.insert(result.end(), kvs.begin(), kvs.end());
+  }
+
+  std::vector<std::string> expect_keys = {"a002", "a003", "b001", "c001", "c002", "c003", "e001", "f001"};
+  EXPECT_EQ(result.size(), expect_keys.size());
+  for (int i = 0; i < result.size() && i < expect_keys.size(); ++i) {
+    EXPECT_EQ(result[i].key, expect_keys[i]);
+    EXPECT_EQ(result[i].key, result[i].value);
+  }
+}
+
+TEST_F(RawKVTest, ScannerUnorderedTwoRegion) {
+  std::vector<std::string> a2c_fake_datas = {"a001", "a002", "a003"};
+  int a2c_iter = 0;
+
+  std::vector<std::string> c2e_fake_datas = {"c001", "c002", "c003"};
+  int c2e_iter = 0;
+
+  EXPECT_CALL(*region_scanner_factory, NewRegionScannerWithRange)
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        MockRegionScannerWithDatas(stub, std::move(region), scanner, a2c_fake_datas, a2c_iter);
+        return Status::OK();
+      })
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        MockRegionScannerWithDatas(stub, std::move(region), scanner, c2e_fake_datas, c2e_iter);
+        return Status::OK();
+      });
+
+  ScanOptions options;
+  options.ordered = false;
+
+  std::unique_ptr<RangeScanner> scanner;
+  Status ret = raw_kv->NewScanner("a", "e", options, scanner);
+  EXPECT_TRUE(ret.IsOK());
+
+  std::vector<std::string> result;
+  while (scanner->HasMore()) {
+    std::vector<KVPair> kvs;
+    ret = scanner->NextBatch(kvs);
+    EXPECT_TRUE(ret.IsOK());
+    for (const auto& kv : kvs) {
+      result.push_back(kv.key);
+    }
+  }
+
+  std::sort(result.begin(), result.end());
+  std::vector<std::string> expect_keys = {"a001", "a002", "a003", "c001", "c002", "c003"};
+  EXPECT_EQ(result, expect_keys);
+}
+
+TEST_F(RawKVTest, ScannerNextBatchFail) {
+  EXPECT_CALL(*region_scanner_factory, NewRegionScannerWithRange)
+      .WillOnce([&](const ClientStub& stub, std::shared_ptr<Region> region, std::string start_key, std::string end_key,
+                    std::unique_ptr<RegionScanner>& scanner) {
+        auto mock_scanner = std::make_unique<MockRegionScanner>(stub, std::move(region));
+
+        EXPECT_CALL(*mock_scanner, Open).WillOnce(testing::Return(Status::OK()));
+        EXPECT_CALL(*mock_scanner, HasMore).WillRepeatedly(testing::Return(true));
+        EXPECT_CALL(*mock_scanner, NextBatch).WillOnce(testing::Return(Status::Aborted("scan fail")));
+
+        scanner = std::move(mock_scanner);
+        return Status::OK();
+      });
+
+  std::unique_ptr<RangeScanner> scanner;
+  Status ret = raw_kv->NewScanner("a", "c", ScanOptions(), scanner);
+  EXPECT_TRUE(ret.IsOK());
+
+  std::vector<KVPair> kvs;
+  ret = scanner->NextBatch(kvs);
+  EXPECT_TRUE(ret.IsAborted());
+  EXPECT_FALSE(scanner->HasMore());
+  EXPECT_EQ(kvs.size(), 0);
+}
 }  // namespace sdk
 }  // namespace dingodb
\ No newline at end of file
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 
@@ -386,6 +387,186 @@ TEST_F(TxnImplTest, CommitWithData) {
   EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kCommitted);
 }
 
+TEST_F(TxnImplTest, OnePcCommit) {
+  options.try_one_pc = true;
+  auto txn = NewTransactionImpl(options);
+
+  {
+    txn->Put("a", "a");
+    txn->Put("b", "b");
+  }
+
+  const int64_t one_pc_commit_ts = txn->TEST_GetStartTs() + 1;
+  EXPECT_CALL(*store_rpc_interaction, SendRpc).WillOnce([&](Rpc& rpc, google::protobuf::Closure* done) {
+    (void)done;
+    TxnPrewriteRpc* txn_rpc = dynamic_cast<TxnPrewriteRpc*>(&rpc);
+    CHECK_NOTNULL(txn_rpc);
+    const auto* request = txn_rpc->Request();
+    EXPECT_EQ(request->start_ts(), txn->TEST_GetStartTs());
+    EXPECT_EQ(request->primary_lock(), txn->TEST_GetPrimaryKey());
+    EXPECT_TRUE(request->try_one_pc());
+    EXPECT_EQ(request->mutations_size(), 2);
+
+    txn_rpc->MutableResponse()->set_one_pc_commit_ts(one_pc_commit_ts);
+    return Status::OK();
+  });
+
+  Status s = txn->PreCommit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kPreCommitted);
+  EXPECT_TRUE(txn->TEST_IsOnePc());
+  EXPECT_EQ(txn->TEST_GetCommitTs(), one_pc_commit_ts);
+
+  s = txn->Commit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kCommitted);
+
+  s = txn->Rollback();
+  EXPECT_TRUE(s.IsIllegalState());
+}
+
+TEST_F(TxnImplTest, OnePcFallbackTo2PC) {
+  options.try_one_pc = true;
+  auto txn = NewTransactionImpl(options);
+
+  {
+    txn->Put("a", "a");
+    txn->Put("b", "b");
+  }
+
+  int prewrite_count = 0;
+  int commit_count = 0;
+  EXPECT_CALL(*store_rpc_interaction, SendRpc).WillRepeatedly([&](Rpc& rpc, google::protobuf::Closure* done) {
+    (void)done;
+    TxnPrewriteRpc* txn_rpc = dynamic_cast<TxnPrewriteRpc*>(&rpc);
+    if (nullptr == txn_rpc) {
+      TxnCommitRpc* txn_rpc = dynamic_cast<TxnCommitRpc*>(&rpc);
+      CHECK_NOTNULL(txn_rpc);
+      EXPECT_EQ(txn_rpc->Request()->commit_ts(), txn->TEST_GetCommitTs());
+      commit_count++;
+    } else {
+      // store falls back to 2PC, one_pc_commit_ts is 0
+      EXPECT_TRUE(txn_rpc->Request()->try_one_pc());
+      prewrite_count++;
+    }
+    return Status::OK();
+  });
+
+  Status s = txn->PreCommit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kPreCommitted);
+  EXPECT_FALSE(txn->TEST_IsOnePc());
+  EXPECT_EQ(prewrite_count, 1);
+
+  s = txn->Commit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kCommitted);
+  // primary key and secondary key
+  EXPECT_EQ(commit_count, 2);
+}
+
+TEST_F(TxnImplTest, AsyncCommit) {
+  options.use_async_commit = true;
+  auto txn = NewTransactionImpl(options);
+
+  {
+    txn->Put("a", "a");
+    txn->Put("d", "d");
+    txn->Put("f", "f");
+  }
+
+  const int64_t max_min_commit_ts = txn->TEST_GetStartTs() + 100;
+  std::atomic<int> prewrite_count{0};
+  std::atomic<int> commit_count{0};
+  EXPECT_CALL(*store_rpc_interaction, SendRpc).WillRepeatedly([&](Rpc& rpc, google::protobuf::Closure* done) {
+    (void)done;
+    TxnPrewriteRpc* txn_rpc = dynamic_cast<TxnPrewriteRpc*>(&rpc);
+    if (nullptr == txn_rpc) {
+      TxnCommitRpc* txn_rpc = dynamic_cast<TxnCommitRpc*>(&rpc);
+      CHECK_NOTNULL(txn_rpc);
+      EXPECT_EQ(txn_rpc->Request()->commit_ts(), max_min_commit_ts);
+      commit_count++;
+      return Status::OK();
+    }
+
+    const auto* request = txn_rpc->Request();
+    EXPECT_TRUE(request->use_async_commit());
+    EXPECT_FALSE(request->try_one_pc());
+    EXPECT_EQ(request->mutations_size(), 1);
+
+    const auto& key = request->mutations(0).key();
+    if (key == txn->TEST_GetPrimaryKey()) {
+      EXPECT_EQ(request->secondaries_size(), 2);
+      for (const auto& secondary : request->secondaries()) {
+        EXPECT_NE(secondary, key);
+      }
+      txn_rpc->MutableResponse()->set_min_commit_ts(max_min_commit_ts);
+    } else {
+      EXPECT_EQ(request->secondaries_size(), 0);
+      txn_rpc->MutableResponse()->set_min_commit_ts(txn->TEST_GetStartTs() + 1);
+    }
+
+    prewrite_count++;
+    return Status::OK();
+  });
+
+  Status s = txn->PreCommit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kPreCommitted);
+  EXPECT_TRUE(txn->TEST_IsAsyncCommit());
+  EXPECT_EQ(txn->TEST_GetCommitTs(), max_min_commit_ts);
+  EXPECT_EQ(prewrite_count.load(), 3);
+
+  s = txn->Commit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kCommitted);
+
+  txn->TEST_WaitAsyncCommit();
+  EXPECT_EQ(commit_count.load(), 3);
+}
+
+TEST_F(TxnImplTest, AsyncCommitFallbackTo2PC) {
+  options.use_async_commit = true;
+  auto txn = NewTransactionImpl(options);
+
+  {
+    txn->Put("a", "a");
+    txn->Put("d", "d");
+  }
+
+  // greater than the commit_ts from tso, commit_ts of 2PC must not less than it
+  const int64_t min_commit_ts = (CurrentFakeTso().physical() + 10000) << 18;
+  std::atomic<int> commit_count{0};
+  EXPECT_CALL(*store_rpc_interaction, SendRpc).WillRepeatedly([&](Rpc& rpc, google::protobuf::Closure* done) {
+    (void)done;
+    TxnPrewriteRpc* txn_rpc = dynamic_cast<TxnPrewriteRpc*>(&rpc);
+    if (nullptr == txn_rpc) {
+      TxnCommitRpc* txn_rpc = dynamic_cast<TxnCommitRpc*>(&rpc);
+      CHECK_NOTNULL(txn_rpc);
+      EXPECT_EQ(txn_rpc->Request()->commit_ts(), txn->TEST_GetCommitTs());
+      commit_count++;
+      return Status::OK();
+    }
+
+    // only the region of "a" prewrites with async commit
+    if (txn_rpc->Request()->mutations(0).key() == "a") {
+      txn_rpc->MutableResponse()->set_min_commit_ts(min_commit_ts);
+    }
+    return Status::OK();
+  });
+
+  Status s = txn->PreCommit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kPreCommitted);
+  EXPECT_FALSE(txn->TEST_IsAsyncCommit());
+
+  s = txn->Commit();
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(txn->TEST_GetTransactionState(), TransactionState::kCommitted);
+  EXPECT_EQ(txn->TEST_GetCommitTs(), min_commit_ts);
+  EXPECT_EQ(commit_count.load(), 2);
+}
+
 TEST_F(TxnImplTest, PrimaryKeyLockConflict) {
   auto txn = NewTransactionImpl(options);
 
@@ -0,0 +1,416 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "coordinator/balance_scheduler.h"
+#include "proto/common.pb.h"
+#include "proto/coordinator_internal.pb.h"
+
+namespace dingodb {
+
+// Replay synthetic cluster states, the scheduled operations are applied as finished before the next round.
+class BalanceSimulator {
+ public:
+  static constexpr int64_t kRoundIntervalMs = 60 * 1000;
+
+  void AddStore(int64_t store_id, int64_t total_capacity = 0, int64_t free_capacity = 0) {
+    BalanceStore store;
+    store.store_id = store_id;
+    store.total_capacity = total_capacity;
+    store.free_capacity = free_capacity;
+    stores[store_id] = store;
+  }
+
+  void AddRegion(int64_t region_id, std::vector<int64_t> store_ids, int64_t region_size = 0) {
+    BalanceRegion region;
+    region.region_id = region_id;
+    region.leader_store_id = store_ids[0];
+    region.store_ids = store_ids;
+    region.region_size = region_size;
+    regions[region_id] = region;
+    for (auto store_id : store_ids) {
+      stores[store_id].free_capacity -= region_size;
+    }
+  }
+
+  BalanceSnapshot GenSnapshot() {
+    BalanceSnapshot snapshot;
+    for (auto& [store_id, store] : stores) {
+      store.leader_count = 0;
+      store.region_count = 0;
+    }
+    for (const auto& [region_id, region] : regions) {
+      stores[region.leader_store_id].leader_count++;
+      for (auto store_id : region.store_ids) {
+        stores[store_id].region_count++;
+      }
+      snapshot.regions.push_back(region);
+    }
+    for (const auto& [store_id, store] : stores) {
+      snapshot.stores.push_back(store);
+    }
+    return snapshot;
+  }
+
+  void Apply(const BalanceOperation& operation) {
+    auto& region = regions[operation.region_id];
+    if (operation.type == BalanceOperation::kTransferLeader) {
+      ASSERT_EQ(operation.source_store_id, region.leader_store_id);
+      ASSERT_NE(region.store_ids.end(),
+                std::find(region.store_ids.begin(), region.store_ids.end(), operation.target_store_id));
+      region.leader_store_id = operation.target_store_id;
+    } else {
+      ASSERT_NE(operation.source_store_id, region.leader_store_id);
+      ASSERT_EQ(region.store_ids.size(), operation.new_store_ids.size());
+      ASSERT_EQ(region.store_ids.size(),
+                std::set<int64_t>(operation.new_store_ids.begin(), operation.new_store_ids.end()).size());
+      region.store_ids = operation.new_store_ids;
+      stores[operation.source_store_id].free_capacity += region.region_size;
+      stores[operation.target_store_id].free_capacity -= region.region_size;
+    }
+  }
+
+  // run rounds until no operation is scheduled, return the count of operations
+  int64_t Run(BalanceScheduler& scheduler, const BalanceOptions& options, int64_t max_rounds) {
+    int64_t operation_count = 0;
+    int64_t idle_rounds = 0;
+    for (int64_t round = 0; round < max_rounds; ++round) {
+      now_ms += kRoundIntervalMs;
+      auto operations = scheduler.Schedule(GenSnapshot(), options, now_ms);
+      EXPECT_LE(operations.size(), options.max_operations_per_round);
+
+      std::map<int64_t, int64_t> store_operation_counts;
+      for (const auto& operation : operations) {
+        store_operation_counts[operation.source_store_id]++;
+        store_operation_counts[operation.target_store_id]++;
+
+        auto it = region_schedule_times.find(operation.region_id);
+        if (it != region_schedule_times.end()) {
+          EXPECT_GE(now_ms - it->second, options.region_cooldown_ms) << operation.ToString();
+        }
+        region_schedule_times[operation.region_id] = now_ms;
+
+        if (operation.type == BalanceOperation::kChangePeer) {
+          for (auto store_id : {operation.source_store_id, operation.target_store_id}) {
+            auto store_it = store_schedule_times.find(store_id);
+            // in one round, store is limited by max_operations_per_store
+            if (store_it != store_schedule_times.end() && store_it->second != now_ms) {
+              EXPECT_GE(now_ms - store_it->second, options.store_cooldown_ms) << operation.ToString();
+            }
+            store_schedule_times[store_id] = now_ms;
+          }
+        }
+
+        Apply(operation);
+      }
+      for (const auto& [store_id, count] : store_operation_counts) {
+        EXPECT_LE(count, options.max_operations_per_store);
+      }
+
+      operation_count += operations.size();
+      // cooldown may hold back all candidates for some rounds
+      idle_rounds = operations.empty() ? idle_rounds + 1 : 0;
+      if (idle_rounds * kRoundIntervalMs > options.region_cooldown_ms) {
+        break;
+      }
+    }
+    return operation_count;
+  }
+
+  std::pair<int64_t, int64_t> LeaderCountRange() {
+    auto snapshot = GenSnapshot();
+    int64_t min_count = INT64_MAX;
+    int64_t max_count = 0;
+    for (const auto& store : snapshot.stores) {
+      if (store.is_normal) {
+        min_count = std::min(min_count, store.leader_count);
+        max_count = std::max(max_count, store.leader_count);
+      }
+    }
+    return {min_count, max_count};
+  }
+
+  std::pair<int64_t, int64_t> RegionCountRange() {
+    auto snapshot = GenSnapshot();
+    int64_t min_count = INT64_MAX;
+    int64_t max_count = 0;
+    for (const auto& store : snapshot.stores) {
+      if (store.is_normal) {
+        min_count = std::min(min_count, store.region_count);
+        max_count = std::max(max_count, store.region_count);
+      }
+    }
+    return {min_count, max_count};
+  }
+
+  int64_t now_ms{0};
+  std::map<int64_t, BalanceStore> stores;
+  std::map<int64_t, BalanceRegion> regions;
+
+  std::map<int64_t, int64_t> region_schedule_times;
+  std::map<int64_t, int64_t> store_schedule_times;
+};
+
+TEST(BalanceSchedulerTest, LeaderPileUp) {
+  BalanceSimulator simulator;
+  for (int64_t store_id = 1; store_id <= 3; ++store_id) {
+    simulator.AddStore(store_id);
+  }
+  // all leaders won election on store 1
+  for (int64_t region_id = 1; region_id <= 300; ++region_id) {
+    simulator.AddRegion(region_id, {1, 2, 3});
+  }
+
+  BalanceScheduler scheduler;
+  BalanceOptions options;
+  int64_t operation_count = simulator.Run(scheduler, options, 1000);
+
+  auto [min_count, max_count] = simulator.LeaderCountRange();
+  EXPECT_LE(max_count - min_count, 100 * options.tolerance + 1);
+  // only transfer leader, each region is moved at most once
+  EXPECT_LE(operation_count, 200);
+  EXPECT_EQ(0, simulator.store_schedule_times.size());
+}
+
+TEST(BalanceSchedulerTest, RateLimit) {
+  BalanceSimulator simulator;
+  for (int64_t store_id = 1; store_id <= 5; ++store_id) {
+    simulator.AddStore(store_id);
+  }
+  for (int64_t region_id = 1; region_id <= 100; ++region_id) {
+    simulator.AddRegion(region_id, {1, 2, 3, 4, 5});
+  }
+
+  BalanceScheduler scheduler;
+  BalanceOptions options;
+  options.max_operations_per_round = 10;
+  options.max_operations_per_store = 3;
+
+  auto operations = scheduler.Schedule(simulator.GenSnapshot(), options, BalanceSimulator::kRoundIntervalMs);
+  // store 1 is the source of every operation
+  EXPECT_EQ(3, operations.size());
+
+  // the scheduled regions are in cooldown
+  auto again = scheduler.Schedule(simulator.GenSnapshot(), options, BalanceSimulator::kRoundIntervalMs + 1);
+  for (const auto& operation : again) {
+    for (const auto& scheduled : operations) {
+      EXPECT_NE(scheduled.region_id, operation.region_id);
+    }
+  }
+
+  // canceled operation release the region
+  scheduler.CancelOperation(operations[0]);
+  bool rescheduled = false;
+  for (const auto& operation :
+       scheduler.Schedule(simulator.GenSnapshot(), options, BalanceSimulator::kRoundIntervalMs + 2)) {
+    rescheduled = rescheduled || operation.region_id == operations[0].region_id;
+  }
+  EXPECT_TRUE(rescheduled);
+}
+
+TEST(BalanceSchedulerTest, NewStore) {
+  const int64_t kCapacity = 1000L * 1024 * 1024 * 1024;
+  const int64_t kRegionSize = 1024L * 1024 * 1024;
+
+  BalanceSimulator simulator;
+  for (int64_t store_id = 1; store_id <= 3; ++store_id) {
+    simulator.AddStore(store_id, kCapacity, kCapacity);
+  }
+  for (int64_t region_id = 1; region_id <= 150; ++region_id) {
+    simulator.AddRegion(region_id, {region_id % 3 + 1, (region_id + 1) % 3 + 1, (region_id + 2) % 3 + 1},
+                        kRegionSize);
+  }
+  // scale out with an empty store
+  simulator.AddStore(4, kCapacity, kCapacity);
+
+  BalanceScheduler scheduler;
+  BalanceOptions options;
+  simulator.Run(scheduler, options, 3000);
+
+  auto [min_count, max_count] = simulator.RegionCountRange();
+  EXPECT_LE(max_count - min_count, 150 * 3 / 4 * options.tolerance + 2);
+  auto [min_leader_count, max_leader_count] = simulator.LeaderCountRange();
+  EXPECT_LE(max_leader_count - min_leader_count, 150 / 4 * options.tolerance + 2);
+}
+
+TEST(BalanceSchedulerTest, Filter) {
+  const int64_t kCapacity = 100L * 1024 * 1024 * 1024;
+  const int64_t kRegionSize = 1024L * 1024 * 1024;
+
+  BalanceSimulator simulator;
+  for (int64_t store_id = 1; store_id <= 3; ++store_id) {
+    simulator.AddStore(store_id, kCapacity, kCapacity);
+  }
+  // store 4 is offline, store 5 is almost full
+  simulator.AddStore(4, kCapacity, kCapacity);
+  simulator.stores[4].is_normal = false;
+  simulator.AddStore(5, kCapacity, kCapacity / 10);
+  for (int64_t region_id = 1; region_id <= 60; ++region_id) {
+    simulator.AddRegion(region_id, {1, 2, 3}, kRegionSize);
+  }
+  // half of the regions are not schedulable, e.g. splitting or task list running
+  for (int64_t region_id = 1; region_id <= 30; ++region_id) {
+    simulator.regions[region_id].is_schedulable = false;
+  }
+
+  BalanceScheduler scheduler;
+  BalanceOptions options;
+  simulator.Run(scheduler, options, 1000);
+
+  for (const auto& [region_id, region] : simulator.regions) {
+    for (auto store_id : region.store_ids) {
+      EXPECT_NE(4, store_id);
+      EXPECT_NE(5, store_id);
+    }
+    if (region_id <= 30) {
+      EXPECT_EQ(1, region.leader_store_id);
+    }
+  }
+
+  // the pinned leaders stay on store 1, the others are spread to store 2 and 3
+  auto snapshot = simulator.GenSnapshot();
+  EXPECT_EQ(30, snapshot.stores[0].leader_count);
+  EXPECT_EQ(15, snapshot.stores[1].leader_count);
+  EXPECT_EQ(15, snapshot.stores[2].leader_count);
+}
+
+TEST(BalanceSchedulerTest, Policy) {
+  class OnlyRegionPolicy : public BalancePolicy {
+   public:
+    std::string Name() override { return "only_region"; }
+    void Schedule(BalanceContext& ctx) override {
+      for (auto& region : ctx.Snapshot().regions) {
+        if (ctx.IsFull() || !ctx.AllowRegion(region) || !ctx.AllowStore(region.leader_store_id, false) ||
+            !ctx.AllowStore(region.store_ids[1], false)) {
+          continue;
+        }
+        BalanceOperation operation;
+        operation.region_id = region.region_id;
+        operation.source_store_id = region.leader_store_id;
+        operation.target_store_id = region.store_ids[1];
+        operation.policy = Name();
+        ctx.AddOperation(region, operation);
+      }
+    }
+  };
+
+  BalanceSimulator simulator;
+  simulator.AddStore(1);
+  simulator.AddStore(2);
+  simulator.AddRegion(1, {1, 2});
+  simulator.AddRegion(2, {2, 1});
+
+  BalanceScheduler scheduler;
+  scheduler.ClearPolicy();
+  scheduler.AddPolicy(std::make_shared<OnlyRegionPolicy>());
+  auto operations = scheduler.Schedule(simulator.GenSnapshot(), BalanceOptions(), 1);
+  ASSERT_EQ(2, operations.size());
+  EXPECT_EQ("only_region", operations[0].policy);
+}
+
+static pb::common::Store GenStore(int64_t store_id, pb::common::StoreType store_type) {
+  pb::common::Store store;
+  store.set_id(store_id);
+  store.set_store_type(store_type);
+  store.set_state(pb::common::StoreState::STORE_NORMAL);
+  store.set_in_state(pb::common::StoreInState::STORE_IN);
+  return store;
+}
+
+static pb::coordinator_internal::RegionInternal GenRegion(int64_t region_id, std::vector<int64_t> store_ids) {
+  pb::coordinator_internal::RegionInternal region;
+  region.set_id(region_id);
+  region.set_state(pb::common::RegionState::REGION_NORMAL);
+  for (auto store_id : store_ids) {
+    auto* peer = region.mutable_definition()->add_peers();
+    peer->set_store_id(store_id);
+    peer->set_role(pb::common::PeerRole::VOTER);
+  }
+  return region;
+}
+
+static pb::common::RegionMetrics GenRegionMetrics(int64_t leader_store_id) {
+  pb::common::RegionMetrics region_metrics;
+  region_metrics.set_leader_store_id(leader_store_id);
+  region_metrics.mutable_region_status()->set_heartbeat_status(pb::common::RegionHeartbeatState::REGION_ONLINE);
+  region_metrics.mutable_region_status()->set_raft_status(pb::common::RegionRaftStatus::REGION_RAFT_HEALTHY);
+  return region_metrics;
+}
+
+TEST(BalanceSchedulerTest, SnapshotBuilder) {
+  pb::common::StoreOwnMetrics store_own_metrics;
+  store_own_metrics.set_system_total_capacity(1000);
+  store_own_metrics.set_system_free_capacity(800);
+
+  BalanceSnapshotBuilder builder;
+  builder.AddStore(GenStore(1, pb::common::StoreType::NODE_TYPE_STORE), &store_own_metrics);
+  builder.AddStore(GenStore(2, pb::common::StoreType::NODE_TYPE_STORE), &store_own_metrics);
+  // no metrics yet
+  builder.AddStore(GenStore(3, pb::common::StoreType::NODE_TYPE_STORE), nullptr);
+  builder.AddStore(GenStore(4, pb::common::StoreType::NODE_TYPE_INDEX), &store_own_metrics);
+
+  auto leader_metrics = GenRegionMetrics(1);
+  for (int64_t region_id = 1; region_id <= 8; ++region_id) {
+    builder.AddRegion(GenRegion(region_id, {1, 2, 3}), &leader_metrics, false);
+  }
+  // not schedulable, but still the load of stores
+  builder.AddRegion(GenRegion(9, {1, 2, 3}), &leader_metrics, true);
+  // no metrics, only counted in region_count
+  builder.AddRegion(GenRegion(10, {1, 2, 3}), nullptr, false);
+  auto index_metrics = GenRegionMetrics(4);
+  builder.AddRegion(GenRegion(11, {4}), &index_metrics, false);
+
+  auto snapshots = builder.Build();
+  ASSERT_EQ(2, snapshots.size());
+
+  const auto& snapshot = snapshots[pb::common::StoreType::NODE_TYPE_STORE];
+  ASSERT_EQ(3, snapshot.stores.size());
+  EXPECT_EQ(9, snapshot.stores[0].leader_count);
+  EXPECT_EQ(0, snapshot.stores[1].leader_count);
+  EXPECT_EQ(0, snapshot.stores[2].leader_count);
+  for (const auto& store : snapshot.stores) {
+    EXPECT_EQ(10, store.region_count);
+  }
+  EXPECT_TRUE(snapshot.stores[1].is_normal);
+  EXPECT_FALSE(snapshot.stores[2].is_normal);
+  EXPECT_EQ(800, snapshot.stores[0].free_capacity);
+
+  ASSERT_EQ(9, snapshot.regions.size());
+  EXPECT_FALSE(snapshot.regions[8].is_schedulable);
+
+  const auto& index_snapshot = snapshots[pb::common::StoreType::NODE_TYPE_INDEX];
+  ASSERT_EQ(1, index_snapshot.stores.size());
+  EXPECT_EQ(1, index_snapshot.stores[0].leader_count);
+  EXPECT_EQ(1, index_snapshot.stores[0].region_count);
+
+  // leaders pile up on store 1, they are moved to the normal store 2
+  BalanceScheduler scheduler;
+  auto operations = scheduler.Schedule(snapshot, BalanceOptions(), 1);
+  ASSERT_FALSE(operations.empty());
+  for (const auto& operation : operations) {
+    EXPECT_EQ(BalanceOperation::kTransferLeader, operation.type);
+    EXPECT_EQ(1, operation.source_store_id);
+    EXPECT_EQ(2, operation.target_store_id);
+    EXPECT_NE(9, operation.region_id);
+  }
+}
+
+}  // namespace dingodb
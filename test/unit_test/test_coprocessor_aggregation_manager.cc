@@ -17,16 +17,21 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include "butil/status.h"
 #include "coprocessor/aggregation_manager.h"
 #include "coprocessor/utils.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/store.pb.h"
 
 namespace dingodb {  // NOLINT
 
+DECLARE_int64(coprocessor_aggregation_max_memory_size);
+
 class CoprocessorAggregationManagerTest : public testing::Test {
  protected:
   static void SetUpTestSuite() {}
@@ -2737,4 +2742,129 @@ TEST_F(CoprocessorAggregationManagerTest, CreateIterator) {
 
 TEST_F(CoprocessorAggregationManagerTest, Close) { aggregation_manager->Close(); }
 
+TEST_F(CoprocessorAggregationManagerTest, ManyGroups) {
+  google::protobuf::RepeatedPtrField<pb::store::Schema> pb_schemas;
+  pb::store::Schema schema1;
+  schema1.set_type(::dingodb::pb::store::Schema_Type::Schema_Type_LONG);
+  schema1.set_is_key(false);
+  schema1.set_is_nullable(true);
+  schema1.set_index(0);
+  pb_schemas.Add(std::move(schema1));
+
+  auto group_by_operator_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  butil::Status ok = Utils::TransToSerialSchema(pb_schemas, &group_by_operator_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // SUM(a), COUNT(a)
+  pb_schemas.Add()->CopyFrom(pb_schemas[0]);
+  pb_schemas[1].set_index(1);
+  auto result_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  ok = Utils::TransToSerialSchema(pb_schemas, &result_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators;
+  auto *sum_operator = aggregation_operators.Add();
+  sum_operator->set_index_of_column(0);
+  sum_operator->set_oper(::dingodb::pb::store::AggregationType::SUM);
+  auto *count_operator = aggregation_operators.Add();
+  count_operator->set_index_of_column(0);
+  count_operator->set_oper(::dingodb::pb::store::AggregationType::COUNT);
+
+  // group by key and operator record have the same column count as operators
+  group_by_operator_serial_schemas->push_back(group_by_operator_serial_schemas->at(0));
+
+  auto manager = std::make_shared<AggregationManager>();
+  ok = manager->Open(group_by_operator_serial_schemas, aggregation_operators, result_serial_schemas);
+  ASSERT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  const int64_t group_count = 10000;
+  for (int64_t i = 0; i < group_count * 3; ++i) {
+    std::vector<std::any> group_by_operator_record;
+    group_by_operator_record.emplace_back(std::optional<int64_t>(i));
+    group_by_operator_record.emplace_back(std::optional<int64_t>(i));
+    ok = manager->Execute(fmt::format("key{:08}", i % group_count), group_by_operator_record);
+    ASSERT_EQ(ok.error_code(), pb::error::Errno::OK);
+  }
+  EXPECT_EQ(group_count, manager->GroupCount());
+  EXPECT_GT(manager->MemoryUsage(), 0);
+
+  // groups are iterated in key order
+  int64_t i = 0;
+  std::string prev_key;
+  auto iter = manager->CreateIterator();
+  while (iter->HasNext()) {
+    const auto &key = iter->GetKey();
+    EXPECT_LT(prev_key, key);
+    prev_key = key;
+
+    const auto &value = iter->GetValue();
+    EXPECT_EQ(i * 3 + group_count * 3, std::any_cast<std::optional<int64_t>>((*value)[0]).value());
+    EXPECT_EQ(3, std::any_cast<std::optional<int64_t>>((*value)[1]).value());
+    iter->Next();
+    ++i;
+  }
+  EXPECT_EQ(group_count, i);
+
+  // iterator is still valid after clear
+  manager->Clear();
+  EXPECT_EQ(0, manager->GroupCount());
+  EXPECT_FALSE(iter->HasNext());
+
+  manager->Close();
+}
+
+TEST_F(CoprocessorAggregationManagerTest, ExceedMemoryLimit) {
+  google::protobuf::RepeatedPtrField<pb::store::Schema> pb_schemas;
+  pb::store::Schema schema1;
+  schema1.set_type(::dingodb::pb::store::Schema_Type::Schema_Type_STRING);
+  schema1.set_is_key(false);
+  schema1.set_is_nullable(true);
+  schema1.set_index(0);
+  pb_schemas.Add(std::move(schema1));
+
+  auto group_by_operator_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  butil::Status ok = Utils::TransToSerialSchema(pb_schemas, &group_by_operator_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  auto result_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  ok = Utils::TransToSerialSchema(pb_schemas, &result_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // MAX(a)
+  ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators;
+  auto *max_operator = aggregation_operators.Add();
+  max_operator->set_index_of_column(0);
+  max_operator->set_oper(::dingodb::pb::store::AggregationType::MAX);
+
+  auto manager = std::make_shared<AggregationManager>();
+  ok = manager->Open(group_by_operator_serial_schemas, aggregation_operators, result_serial_schemas);
+  ASSERT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  auto old_limit = FLAGS_coprocessor_aggregation_max_memory_size;
+  FLAGS_coprocessor_aggregation_max_memory_size = 1024 * 1024;
+
+  int64_t count = 0;
+  while (!manager->IsExceedMemoryLimit()) {
+    std::vector<std::any> group_by_operator_record;
+    group_by_operator_record.emplace_back(
+        std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>(fmt::format("value{}", count))));
+    ok = manager->Execute(fmt::format("key{}", count), group_by_operator_record);
+    ASSERT_EQ(ok.error_code(), pb::error::Errno::OK);
+    ++count;
+  }
+  EXPECT_EQ(count, manager->GroupCount());
+
+  auto iter = manager->CreateIterator();
+  ASSERT_TRUE(iter->HasNext());
+  EXPECT_EQ("key0", iter->GetKey());
+  EXPECT_EQ("value0", *std::any_cast<std::optional<std::shared_ptr<std::string>>>((*iter->GetValue())[0]).value());
+
+  // flush, start a new aggregation
+  manager->Clear();
+  EXPECT_FALSE(manager->IsExceedMemoryLimit());
+
+  FLAGS_coprocessor_aggregation_max_memory_size = old_limit;
+  manager->Close();
+}
+
 }  // namespace dingodb
@@ -0,0 +1,150 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <any>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "butil/status.h"
+#include "common/helper.h"
+#include "coprocessor/expression_filter.h"
+
+// Must be after proto, otherwise it will cause naming collision. such as TYPE_STRING
+#include "libexpr/src/runner.h"
+
+namespace dingodb {
+
+// libexpr byte code
+// VAR_I|TYPE_INT32 index, CONST|TYPE_INT32 varint, GT|LT TYPE_INT32, AND
+// col0 > 100
+static const std::string kSimpleExpression = "310011649301";
+// col0 > 100 AND col0 < 500
+static const std::string kCompoundExpression = "310011649301310011F403950152";
+// CONST|TYPE_BOOL means true, CONST_N|TYPE_BOOL means false
+static const std::string kTrueExpression = "13";
+static const std::string kFalseExpression = "23";
+
+static const int kRecordCount = 100000;
+
+class CoprocessorExpressionFilterTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    records.reserve(kRecordCount);
+    for (int i = 0; i < kRecordCount; ++i) {
+      std::vector<std::any> record;
+      record.emplace_back(std::optional<int32_t>(i % 1000));
+      records.push_back(std::move(record));
+    }
+  }
+
+  static void TearDownTestSuite() { records.clear(); }
+
+  static int64_t CountSelected(const std::vector<bool>& selected) {
+    int64_t count = 0;
+    for (auto is_selected : selected) {
+      count += is_selected ? 1 : 0;
+    }
+    return count;
+  }
+
+  // Decode expression for every record, this is the old way of coprocessor.
+  static std::vector<bool> FilterPerRecordDecode(const std::string& expression) {
+    std::vector<bool> selected;
+    selected.reserve(records.size());
+    for (const auto& record : records) {
+      expr::Runner runner;
+      runner.Decode(reinterpret_cast<const expr::Byte*>(expression.c_str()), expression.length());
+      runner.BindTuple(reinterpret_cast<const expr::Tuple*>(&record));
+      runner.Run();
+      expr::Wrap<bool> ok = runner.GetResult<bool>();
+      selected.push_back(ok.has_value() && ok.value());
+    }
+    return selected;
+  }
+
+  // The expression decoded once selects the same records as decoding it for every record.
+  static void CheckSameAsPerRecordDecode(const std::string& expression, int64_t expect_count) {
+    auto expect_selected = FilterPerRecordDecode(expression);
+    EXPECT_EQ(expect_count, CountSelected(expect_selected));
+
+    ExpressionFilter filter;
+    ASSERT_TRUE(filter.Open(expression).ok());
+    std::vector<bool> selected;
+    ASSERT_TRUE(filter.Filter(records, selected).ok());
+    EXPECT_EQ(expect_selected, selected);
+  }
+
+  static std::vector<std::vector<std::any>> records;
+};
+
+std::vector<std::vector<std::any>> CoprocessorExpressionFilterTest::records;
+
+TEST_F(CoprocessorExpressionFilterTest, EmptyExpression) {
+  ExpressionFilter filter;
+  ASSERT_TRUE(filter.Open("").ok());
+  EXPECT_TRUE(filter.IsAlwaysTrue());
+  EXPECT_FALSE(filter.IsAlwaysFalse());
+
+  bool is_reserve = false;
+  ASSERT_TRUE(filter.Filter(records[0], is_reserve).ok());
+  EXPECT_TRUE(is_reserve);
+}
+
+TEST_F(CoprocessorExpressionFilterTest, ConstantExpression) {
+  ExpressionFilter filter;
+  ASSERT_TRUE(filter.Open(Helper::HexToString(kTrueExpression)).ok());
+  EXPECT_TRUE(filter.IsAlwaysTrue());
+
+  ASSERT_TRUE(filter.Open(Helper::HexToString(kFalseExpression)).ok());
+  EXPECT_TRUE(filter.IsAlwaysFalse());
+
+  std::vector<bool> selected;
+  ASSERT_TRUE(filter.Filter(records, selected).ok());
+  ASSERT_EQ(records.size(), selected.size());
+  EXPECT_EQ(0, CountSelected(selected));
+}
+
+TEST_F(CoprocessorExpressionFilterTest, Predicate) {
+  ExpressionFilter filter;
+  ASSERT_TRUE(filter.Open(Helper::HexToString(kSimpleExpression)).ok());
+  EXPECT_FALSE(filter.IsAlwaysTrue());
+  EXPECT_FALSE(filter.IsAlwaysFalse());
+
+  bool is_reserve = true;
+  ASSERT_TRUE(filter.Filter(records[100], is_reserve).ok());
+  EXPECT_FALSE(is_reserve);
+  ASSERT_TRUE(filter.Filter(records[101], is_reserve).ok());
+  EXPECT_TRUE(is_reserve);
+
+  // The expression is reused for the following records.
+  std::vector<bool> selected;
+  ASSERT_TRUE(filter.Filter(records, selected).ok());
+  EXPECT_EQ(kRecordCount / 1000 * 899, CountSelected(selected));
+
+  ASSERT_TRUE(filter.Open(Helper::HexToString(kCompoundExpression)).ok());
+  ASSERT_TRUE(filter.Filter(records, selected).ok());
+  EXPECT_EQ(kRecordCount / 1000 * 399, CountSelected(selected));
+}
+
+TEST_F(CoprocessorExpressionFilterTest, SameAsPerRecordDecode) {
+  CheckSameAsPerRecordDecode(Helper::HexToString(kSimpleExpression), kRecordCount / 1000 * 899);
+  CheckSameAsPerRecordDecode(Helper::HexToString(kCompoundExpression), kRecordCount / 1000 * 399);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,160 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "butil/iobuf.h"
+#include "common/file_transfer.h"
+#include "proto/error.pb.h"
+
+static const std::string kFilePath = "./unit_test_file_transfer";
+
+class FileTransferTest : public testing::Test {
+ protected:
+  void SetUp() override { std::filesystem::remove(kFilePath); }
+  void TearDown() override { std::filesystem::remove(kFilePath); }
+
+  static butil::IOBuf BuildChunk(int64_t offset, const std::string& data, bool eof) {
+    butil::IOBuf payload;
+    payload.append(data);
+
+    dingodb::FileChunkHeader header;
+    header.offset = offset;
+    header.size = data.size();
+    header.checksum = dingodb::FileChunkHeader::Checksum(payload);
+    header.eof = eof;
+
+    butil::IOBuf message;
+    header.EncodeTo(message);
+    message.append(payload);
+    return message;
+  }
+
+  static std::string ReadFile() {
+    std::ifstream ifile(kFilePath, std::ios::binary);
+    std::stringstream ss;
+    ss << ifile.rdbuf();
+    return ss.str();
+  }
+};
+
+TEST_F(FileTransferTest, ChunkHeader) {
+  dingodb::FileChunkHeader header;
+  header.offset = 1024 * 1024 * 1024 * 5L;
+  header.size = 4096;
+  header.checksum = 0x12345678;
+  header.eof = true;
+
+  butil::IOBuf buf;
+  header.EncodeTo(buf);
+  buf.append("data");
+  EXPECT_EQ(dingodb::FileChunkHeader::kEncodeSize + 4, buf.size());
+
+  dingodb::FileChunkHeader decode_header;
+  EXPECT_TRUE(decode_header.DecodeFrom(buf));
+  EXPECT_EQ(header.offset, decode_header.offset);
+  EXPECT_EQ(header.size, decode_header.size);
+  EXPECT_EQ(header.checksum, decode_header.checksum);
+  EXPECT_EQ(header.eof, decode_header.eof);
+  EXPECT_EQ("data", buf.to_string());
+
+  butil::IOBuf short_buf;
+  short_buf.append("abc");
+  EXPECT_FALSE(decode_header.DecodeFrom(short_buf));
+}
+
+TEST_F(FileTransferTest, ReceiveChunks) {
+  int fd = ::open(kFilePath.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+
+  dingodb::FileStreamReceiver receiver(fd, 0);
+
+  butil::IOBuf chunk1 = BuildChunk(0, "hello ", false);
+  butil::IOBuf chunk2 = BuildChunk(6, "world", true);
+  butil::IOBuf* messages[] = {&chunk1, &chunk2};
+  receiver.on_received_messages(brpc::INVALID_STREAM_ID, messages, 2);
+
+  EXPECT_TRUE(receiver.Status().ok());
+  EXPECT_TRUE(receiver.IsEof());
+  EXPECT_EQ(11, receiver.VerifiedOffset());
+
+  ::close(fd);
+  EXPECT_EQ("hello world", ReadFile());
+}
+
+TEST_F(FileTransferTest, ResumeFromOffset) {
+  int fd = ::open(kFilePath.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(6, ::write(fd, "hello ", 6));
+
+  dingodb::FileStreamReceiver receiver(fd, 6);
+
+  butil::IOBuf chunk = BuildChunk(6, "world", true);
+  butil::IOBuf* messages[] = {&chunk};
+  receiver.on_received_messages(brpc::INVALID_STREAM_ID, messages, 1);
+
+  EXPECT_TRUE(receiver.Status().ok());
+  EXPECT_EQ(11, receiver.VerifiedOffset());
+
+  ::close(fd);
+  EXPECT_EQ("hello world", ReadFile());
+}
+
+TEST_F(FileTransferTest, ChecksumMismatch) {
+  int fd = ::open(kFilePath.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+
+  dingodb::FileStreamReceiver receiver(fd, 0);
+
+  butil::IOBuf chunk1 = BuildChunk(0, "hello ", false);
+  // Corrupt payload.
+  butil::IOBuf chunk2 = BuildChunk(6, "world", true);
+  std::string data = chunk2.to_string();
+  data.back() = 'x';
+  chunk2.clear();
+  chunk2.append(data);
+
+  butil::IOBuf* messages[] = {&chunk1, &chunk2};
+  receiver.on_received_messages(brpc::INVALID_STREAM_ID, messages, 2);
+
+  EXPECT_EQ(dingodb::pb::error::EFILE_CHECKSUM, receiver.Status().error_code());
+  EXPECT_FALSE(receiver.IsEof());
+  // Resume offset stay at the last verified chunk.
+  EXPECT_EQ(6, receiver.VerifiedOffset());
+
+  ::close(fd);
+}
+
+TEST_F(FileTransferTest, OffsetNotMatch) {
+  int fd = ::open(kFilePath.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+
+  dingodb::FileStreamReceiver receiver(fd, 0);
+
+  butil::IOBuf chunk = BuildChunk(100, "hello", false);
+  butil::IOBuf* messages[] = {&chunk};
+  receiver.on_received_messages(brpc::INVALID_STREAM_ID, messages, 1);
+
+  EXPECT_EQ(dingodb::pb::error::EFILE_STREAM, receiver.Status().error_code());
+  EXPECT_EQ(0, receiver.VerifiedOffset());
+
+  ::close(fd);
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "coordinator/kv_compaction_queue.h"
+
+class KvCompactionQueueTest : public testing::Test {};
+
+TEST_F(KvCompactionQueueTest, PopInRevisionOrder) {
+  dingodb::KvCompactionQueue queue(100);
+  queue.SetNeedFullScan(false);
+
+  queue.Add(30, "c");
+  queue.Add(10, "a");
+  queue.Add(20, "b");
+  EXPECT_EQ(3, queue.Size());
+
+  // Only the keys older than compact revision are popped.
+  std::vector<std::string> keys;
+  queue.Pop(25, 100, keys);
+  ASSERT_EQ(2, keys.size());
+  EXPECT_EQ("a", keys[0]);
+  EXPECT_EQ("b", keys[1]);
+  EXPECT_EQ(1, queue.Size());
+
+  keys.clear();
+  queue.Pop(25, 100, keys);
+  EXPECT_TRUE(keys.empty());
+
+  keys.clear();
+  queue.Pop(100, 100, keys);
+  ASSERT_EQ(1, keys.size());
+  EXPECT_EQ("c", keys[0]);
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST_F(KvCompactionQueueTest, PopWithLimit) {
+  dingodb::KvCompactionQueue queue(100);
+  for (int i = 0; i < 10; ++i) {
+    queue.Add(i, "key" + std::to_string(i));
+  }
+
+  std::vector<std::string> keys;
+  queue.Pop(100, 4, keys);
+  ASSERT_EQ(4, keys.size());
+  EXPECT_EQ("key0", keys[0]);
+  EXPECT_EQ("key3", keys[3]);
+  EXPECT_EQ(6, queue.Size());
+}
+
+TEST_F(KvCompactionQueueTest, KeyWithNewRevision) {
+  dingodb::KvCompactionQueue queue(100);
+
+  queue.Add(10, "a");
+  queue.Add(50, "a");
+  EXPECT_EQ(1, queue.Size());
+
+  // Compact the old garbage, key stays in queue for the new revision.
+  std::vector<std::string> keys;
+  queue.Pop(20, 100, keys);
+  ASSERT_EQ(1, keys.size());
+  EXPECT_EQ("a", keys[0]);
+  EXPECT_EQ(1, queue.Size());
+
+  keys.clear();
+  queue.Pop(40, 100, keys);
+  EXPECT_TRUE(keys.empty());
+
+  keys.clear();
+  queue.Pop(60, 100, keys);
+  ASSERT_EQ(1, keys.size());
+  EXPECT_EQ(0, queue.Size());
+}
+
+TEST_F(KvCompactionQueueTest, OverflowAndClear) {
+  dingodb::KvCompactionQueue queue(2);
+  EXPECT_TRUE(queue.NeedFullScan());
+  queue.SetNeedFullScan(false);
+
+  EXPECT_TRUE(queue.Add(1, "a"));
+  EXPECT_TRUE(queue.Add(2, "b"));
+  // Existing key is not counted.
+  EXPECT_TRUE(queue.Add(3, "a"));
+  EXPECT_FALSE(queue.NeedFullScan());
+
+  EXPECT_FALSE(queue.Add(4, "c"));
+  EXPECT_TRUE(queue.NeedFullScan());
+  EXPECT_EQ(2, queue.Size());
+
+  queue.SetNeedFullScan(false);
+  queue.Clear();
+  EXPECT_EQ(0, queue.Size());
+  EXPECT_TRUE(queue.NeedFullScan());
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "butil/status.h"
+#include "common/constant.h"
+#include "config/config.h"
+#include "config/yaml_config.h"
+#include "coordinator/kv_control.h"
+#include "coordinator/kv_event_ring.h"
+#include "engine/raw_rocks_engine.h"
+#include "meta/meta_reader.h"
+#include "meta/meta_writer.h"
+#include "proto/coordinator_internal.pb.h"
+#include "proto/error.pb.h"
+#include "proto/version.pb.h"
+
+namespace dingodb {
+
+const std::string kYamlConfigContent =
+    "cluster:\n"
+    "  name: dingodb\n"
+    "  instance_id: 12345\n"
+    "  coordinators: 127.0.0.1:19190,127.0.0.1:19191,127.0.0.1:19192\n"
+    "  keyring: TO_BE_CONTINUED\n"
+    "server:\n"
+    "  host: 127.0.0.1\n"
+    "  port: 23000\n"
+    "  heartbeat_interval: 10000 # ms\n"
+    "raft:\n"
+    "  host: 127.0.0.1\n"
+    "  port: 23100\n"
+    "  path: /tmp/dingo-store/data/kv_watch/raft\n"
+    "  election_timeout: 1000 # ms\n"
+    "  snapshot_interval: 3600 # s\n"
+    "log:\n"
+    "  path: /tmp/dingo-store/log\n"
+    "store:\n"
+    "  path: /tmp/dingo-store/data/kv_watch/db\n";
+
+static const std::vector<std::string> kAllCFs = {Constant::kStoreMetaCF};
+
+class KvControlWatchTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    std::shared_ptr<Config> config = std::make_shared<YamlConfig>();
+    if (config->Load(kYamlConfigContent) != 0) {
+      std::cout << "Load config failed" << std::endl;
+      return;
+    }
+
+    engine = std::make_shared<RawRocksEngine>();
+    if (!engine->Init(config, kAllCFs)) {
+      std::cout << "RawRocksEngine init failed" << std::endl;
+    }
+  }
+
+  static void TearDownTestSuite() {
+    engine->Close();
+    engine->Destroy();
+  }
+
+  void SetUp() override {
+    kv_control = std::make_shared<KvControl>(std::make_shared<MetaReader>(engine), std::make_shared<MetaWriter>(engine),
+                                             engine);
+  }
+
+  void TearDown() override { kv_control = nullptr; }
+
+  static KvStreamWatcherPtr NewWatcher(const std::string& key, const std::string& range_end, int64_t revision) {
+    auto watcher = std::make_shared<KvStreamWatcher>();
+    watcher->key = key;
+    watcher->range_end = range_end;
+    watcher->next_revision = KvEventRevision{revision, 0};
+    return watcher;
+  }
+
+  void Put(const std::string& key, int64_t revision) {
+    pb::coordinator_internal::RevisionInternal op_revision;
+    op_revision.set_main(revision);
+    op_revision.set_sub(0);
+    ASSERT_TRUE(kv_control->KvPutApply(key, op_revision, true, 0, false, "value" + std::to_string(revision)).ok());
+  }
+
+  butil::Status AddWatcher(KvStreamWatcherPtr watcher) { return kv_control->AddStreamWatcher(watcher, 0); }
+
+  int64_t RingSize() { return kv_control->watch_event_ring_.Size(); }
+  void ClearRing() { kv_control->ClearWatchEvent(); }
+
+  bool ReadRing(KvStreamWatcherPtr watcher, std::vector<pb::version::Event>& events, KvEventRevision& next_revision) {
+    auto filter = [&watcher](const pb::version::Event& event) -> bool { return watcher->IsMatch(event); };
+    return kv_control->watch_event_ring_.Read(watcher->next_revision, filter, 100, events, next_revision);
+  }
+
+  butil::Status ReadCatchUpEvents(KvStreamWatcherPtr watcher, std::vector<pb::version::Event>& events,
+                                  KvEventRevision& next_revision, int64_t& compact_revision) {
+    return kv_control->ReadCatchUpEvents(watcher, 100, events, next_revision, compact_revision);
+  }
+
+  butil::Status CheckRevision(int64_t revision, int64_t& compact_revision) {
+    return kv_control->CheckStreamWatchRevision(revision, compact_revision);
+  }
+
+  void SetCompactRevision(int64_t revision) {
+    pb::coordinator_internal::MetaIncrement meta_increment;
+    kv_control->UpdatePresentId(pb::coordinator_internal::IdEpochType::ID_KV_COMPACT_REVISION, revision,
+                                meta_increment);
+  }
+
+  static std::shared_ptr<RawRocksEngine> engine;
+  std::shared_ptr<KvControl> kv_control;
+};
+
+std::shared_ptr<RawRocksEngine> KvControlWatchTest::engine = nullptr;
+
+TEST_F(KvControlWatchTest, SkipEventWithoutWatcher) {
+  // no stream watcher, event is not kept
+  Put("skip_key", 100);
+  EXPECT_EQ(0, RingSize());
+
+  auto watcher = NewWatcher("skip_key", "", 100);
+  ASSERT_TRUE(AddWatcher(watcher).ok());
+  Put("skip_key", 101);
+  Put("skip_key", 102);
+  EXPECT_EQ(2, RingSize());
+
+  // the skipped event is caught up from storage, then continue from ring
+  std::vector<pb::version::Event> events;
+  KvEventRevision next_revision;
+  int64_t compact_revision = 0;
+  ASSERT_TRUE(ReadCatchUpEvents(watcher, events, next_revision, compact_revision).ok());
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(100, events[0].kv().mod_revision());
+  EXPECT_TRUE(next_revision == KvEventRevision({101, 0}));
+
+  watcher->next_revision = next_revision;
+  events.clear();
+  ASSERT_TRUE(ReadRing(watcher, events, next_revision));
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(101, events[0].kv().mod_revision());
+  EXPECT_EQ(102, events[1].kv().mod_revision());
+}
+
+TEST_F(KvControlWatchTest, CatchUpFromStorage) {
+  auto watcher = NewWatcher("range_a", "range_c", 200);
+  ASSERT_TRUE(AddWatcher(watcher).ok());
+
+  Put("range_a", 200);
+  Put("range_b", 201);
+  Put("range_z", 202);
+  Put("range_b", 203);
+
+  // ring is lost, e.g. install snapshot
+  ClearRing();
+  Put("range_a", 204);
+  Put("range_z", 205);
+
+  std::vector<pb::version::Event> events;
+  KvEventRevision next_revision;
+  int64_t compact_revision = 0;
+  ASSERT_FALSE(ReadRing(watcher, events, next_revision));
+
+  // storage events before the ring, out of range key is filtered
+  ASSERT_TRUE(ReadCatchUpEvents(watcher, events, next_revision, compact_revision).ok());
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ("range_a", events[0].kv().kv().key());
+  EXPECT_EQ(201, events[1].kv().mod_revision());
+  EXPECT_EQ(203, events[2].kv().mod_revision());
+  EXPECT_EQ(2, events[2].kv().version());
+  EXPECT_TRUE(next_revision == KvEventRevision({204, 0}));
+
+  // watcher reach the ring, no more events from storage
+  watcher->next_revision = next_revision;
+  events.clear();
+  ASSERT_TRUE(ReadCatchUpEvents(watcher, events, next_revision, compact_revision).ok());
+  EXPECT_TRUE(events.empty());
+  EXPECT_TRUE(next_revision == watcher->next_revision);
+
+  ASSERT_TRUE(ReadRing(watcher, events, next_revision));
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(204, events[0].kv().mod_revision());
+  EXPECT_TRUE(next_revision == KvEventRevision({205, 1}));
+}
+
+TEST_F(KvControlWatchTest, CompactedRevision) {
+  int64_t compact_revision = 0;
+  EXPECT_TRUE(CheckRevision(300, compact_revision).ok());
+
+  SetCompactRevision(310);
+  auto status = CheckRevision(300, compact_revision);
+  EXPECT_EQ(pb::error::Errno::EWATCH_REVISION_COMPACTED, status.error_code());
+  EXPECT_EQ(310, compact_revision);
+  EXPECT_TRUE(CheckRevision(310, compact_revision).ok());
+
+  // lagging watcher fell into compacted revisions
+  auto watcher = NewWatcher("compact_key", "", 305);
+  ASSERT_TRUE(AddWatcher(watcher).ok());
+  std::vector<pb::version::Event> events;
+  KvEventRevision next_revision;
+  status = ReadCatchUpEvents(watcher, events, next_revision, compact_revision);
+  EXPECT_EQ(pb::error::Errno::EWATCH_REVISION_COMPACTED, status.error_code());
+  EXPECT_EQ(310, compact_revision);
+  EXPECT_TRUE(events.empty());
+}
+
+}  // namespace dingodb
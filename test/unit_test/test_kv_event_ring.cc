@@ -0,0 +1,124 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "coordinator/kv_event_ring.h"
+#include "proto/version.pb.h"
+
+class KvEventRingTest : public testing::Test {
+ protected:
+  static dingodb::pb::version::Event GenEvent(const std::string& key, int64_t revision) {
+    dingodb::pb::version::Event event;
+    event.set_type(dingodb::pb::version::Event::EventType::Event_EventType_PUT);
+    event.mutable_kv()->mutable_kv()->set_key(key);
+    event.mutable_kv()->set_mod_revision(revision);
+    return event;
+  }
+};
+
+TEST_F(KvEventRingTest, ReadInOrder) {
+  dingodb::KvEventRing ring(100);
+  for (int64_t i = 1; i <= 10; ++i) {
+    ring.Append({i, 0}, GenEvent("key" + std::to_string(i % 2), i));
+  }
+  EXPECT_EQ(10, ring.Size());
+
+  std::vector<dingodb::pb::version::Event> events;
+  dingodb::KvEventRevision next_revision;
+  ASSERT_TRUE(ring.Read({3, 0}, nullptr, 100, events, next_revision));
+  ASSERT_EQ(8, events.size());
+  EXPECT_EQ(3, events[0].kv().mod_revision());
+  EXPECT_EQ(10, events.back().kv().mod_revision());
+  EXPECT_TRUE(next_revision == dingodb::KvEventRevision({10, 1}));
+
+  // Continue read from next revision, nothing new.
+  events.clear();
+  ASSERT_TRUE(ring.Read(next_revision, nullptr, 100, events, next_revision));
+  EXPECT_TRUE(events.empty());
+  EXPECT_TRUE(next_revision == dingodb::KvEventRevision({10, 1}));
+}
+
+TEST_F(KvEventRingTest, ReadWithFilterAndLimit) {
+  dingodb::KvEventRing ring(100);
+  for (int64_t i = 1; i <= 10; ++i) {
+    ring.Append({i, 0}, GenEvent("key" + std::to_string(i % 2), i));
+  }
+
+  auto filter = [](const dingodb::pb::version::Event& event) { return event.kv().kv().key() == "key0"; };
+
+  std::vector<dingodb::pb::version::Event> events;
+  dingodb::KvEventRevision next_revision;
+  ASSERT_TRUE(ring.Read({1, 0}, filter, 2, events, next_revision));
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(2, events[0].kv().mod_revision());
+  EXPECT_EQ(4, events[1].kv().mod_revision());
+  EXPECT_TRUE(next_revision == dingodb::KvEventRevision({4, 1}));
+
+  events.clear();
+  ASSERT_TRUE(ring.Read(next_revision, filter, 100, events, next_revision));
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(6, events[0].kv().mod_revision());
+}
+
+TEST_F(KvEventRingTest, SubRevision) {
+  dingodb::KvEventRing ring(100);
+  ring.Append({5, 0}, GenEvent("a", 5));
+  ring.Append({5, 1}, GenEvent("b", 5));
+  ring.Append({5, 2}, GenEvent("c", 5));
+
+  // Stale or duplicated event is ignored.
+  ring.Append({5, 1}, GenEvent("b", 5));
+  EXPECT_EQ(3, ring.Size());
+
+  std::vector<dingodb::pb::version::Event> events;
+  dingodb::KvEventRevision next_revision;
+  ASSERT_TRUE(ring.Read({5, 1}, nullptr, 100, events, next_revision));
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ("b", events[0].kv().kv().key());
+  EXPECT_EQ("c", events[1].kv().kv().key());
+}
+
+TEST_F(KvEventRingTest, FallBehind) {
+  dingodb::KvEventRing ring(5);
+
+  std::vector<dingodb::pb::version::Event> events;
+  dingodb::KvEventRevision next_revision;
+  dingodb::KvEventRevision begin_revision;
+
+  // Empty ring, must read from storage.
+  EXPECT_FALSE(ring.Read({1, 0}, nullptr, 100, events, next_revision));
+  EXPECT_FALSE(ring.Begin(begin_revision));
+
+  for (int64_t i = 1; i <= 10; ++i) {
+    ring.Append({i, 0}, GenEvent("key", i));
+  }
+  EXPECT_EQ(5, ring.Size());
+  ASSERT_TRUE(ring.Begin(begin_revision));
+  EXPECT_TRUE(begin_revision == dingodb::KvEventRevision({6, 0}));
+
+  EXPECT_FALSE(ring.Read({3, 0}, nullptr, 100, events, next_revision));
+  EXPECT_TRUE(events.empty());
+
+  ASSERT_TRUE(ring.Read({6, 0}, nullptr, 100, events, next_revision));
+  EXPECT_EQ(5, events.size());
+
+  ring.Clear();
+  EXPECT_EQ(0, ring.Size());
+  EXPECT_FALSE(ring.Begin(begin_revision));
+}
@@ -27,6 +27,7 @@
 #include "braft/raft.pb.h"
 #include "braft/snapshot.h"
 #include "butil/status.h"
+#include "common/constant.h"
 #include "common/context.h"
 #include "common/helper.h"
 #include "config/config.h"
@@ -63,7 +64,7 @@ const std::string kYamlConfigContent =
 
 static const std::string kDefaultCf = "default";
 
-static const std::vector<std::string> kAllCFs = {kDefaultCf};
+static const std::vector<std::string> kAllCFs = {kDefaultCf, dingodb::Constant::kStoreMetaCF};
 
 const std::string kRaftSnapshotPath = "/data/dingo-store/data/store/raft/snapshot";
 
@@ -198,3 +199,119 @@ TEST_F(RaftSnapshotTest, RaftSnapshotByCheckoutpoint) {
   std::cout << fmt::format("Count used time: {} ms", dingodb::Helper::TimestampMs() - start_time) << std::endl;
   start_time = dingodb::Helper::TimestampMs();
 }
+
+TEST_F(RaftSnapshotTest, SplitSnapshotRange) {
+  dingodb::pb::common::Range range;
+  range.set_start_key("a");
+  range.set_end_key("z");
+
+  auto sub_ranges = dingodb::RaftSnapshot::SplitSnapshotRange(range, 1);
+  ASSERT_EQ(1, sub_ranges.size());
+  EXPECT_EQ("a", sub_ranges[0].start_key());
+  EXPECT_EQ("z", sub_ranges[0].end_key());
+
+  // every round bisects all sub ranges
+  for (int sub_range_num : {3, 4, 16}) {
+    sub_ranges = dingodb::RaftSnapshot::SplitSnapshotRange(range, sub_range_num);
+    ASSERT_EQ(sub_range_num == 3 ? 4 : sub_range_num, sub_ranges.size());
+
+    // sub ranges cover the range without overlap
+    EXPECT_EQ("a", sub_ranges.front().start_key());
+    EXPECT_EQ("z", sub_ranges.back().end_key());
+    for (int i = 0; i < sub_ranges.size(); ++i) {
+      EXPECT_LT(sub_ranges[i].start_key(), sub_ranges[i].end_key());
+      if (i > 0) {
+        EXPECT_EQ(sub_ranges[i - 1].end_key(), sub_ranges[i].start_key());
+      }
+    }
+  }
+
+  // can't split any more
+  range.set_end_key("a");
+  sub_ranges = dingodb::RaftSnapshot::SplitSnapshotRange(range, 4);
+  ASSERT_EQ(1, sub_ranges.size());
+}
+
+TEST_F(RaftSnapshotTest, LoadSnapshotByScan) {
+  const std::string snapshot_path = kRaftSnapshotPath + "/scan";
+  auto snapshot_storage = std::make_unique<braft::LocalSnapshotStorage>(snapshot_path);
+  ASSERT_EQ(0, snapshot_storage->init());
+  auto* snapshot_writer = snapshot_storage->create();
+  ASSERT_NE(nullptr, snapshot_writer);
+  snapshot_writer->add_file(dingodb::Constant::kRaftSnapshotRegionMetaFileName);
+
+  // two sub range sst files of default cf and one of meta cf, same as GenSnapshotFileByScan
+  struct SubRange {
+    std::string cf_name;
+    std::string start_key;
+    std::string end_key;
+    std::vector<std::string> keys;
+  };
+  std::vector<SubRange> sub_ranges = {
+      {kDefaultCf, "scan_a", "scan_m", {"scan_a1", "scan_b1"}},
+      {kDefaultCf, "scan_m", "scan_z", {"scan_m1", "scan_y1"}},
+      {dingodb::Constant::kStoreMetaCF, "scan_a", "scan_z", {"scan_c1"}},
+  };
+  for (int i = 0; i < sub_ranges.size(); ++i) {
+    const auto& sub_range = sub_ranges[i];
+    std::vector<dingodb::pb::common::KeyValue> kvs;
+    for (const auto& key : sub_range.keys) {
+      auto& kv = kvs.emplace_back();
+      kv.set_key(key);
+      kv.set_value(sub_range.cf_name + "_value");
+    }
+
+    std::string sst_name = fmt::format("{}_{}.sst", sub_range.cf_name, i);
+    std::string sst_path = snapshot_writer->get_path() + "/" + sst_name;
+    ASSERT_TRUE(dingodb::RawRocksEngine::NewSstFileWriter()->SaveFile(kvs, sst_path).ok());
+
+    dingodb::pb::store_internal::SstFileInfo sst_file;
+    sst_file.set_level(0);
+    sst_file.set_name(sst_name);
+    sst_file.set_path(sst_path);
+    sst_file.set_start_key(sub_range.start_key);
+    sst_file.set_end_key(sub_range.end_key);
+    sst_file.set_cf_name(sub_range.cf_name);
+
+    braft::LocalFileMeta file_meta;
+    file_meta.set_user_meta(sst_file.SerializeAsString());
+    file_meta.set_source(braft::FileSource::FILE_SOURCE_LOCAL);
+    ASSERT_EQ(0, snapshot_writer->add_file(sst_name, &file_meta));
+  }
+
+  braft::SnapshotMeta meta;
+  meta.set_last_included_index(dingodb::Helper::TimestampMs());
+  meta.set_last_included_term(1);
+  snapshot_writer->save_meta(meta);
+  snapshot_storage->close(snapshot_writer);
+
+  dingodb::pb::common::RegionDefinition definition;
+  definition.set_id(112);
+  definition.set_name("test-snapshot-scan");
+  definition.mutable_range()->set_start_key("scan_a");
+  definition.mutable_range()->set_end_key("scan_z");
+  auto region = dingodb::store::Region::New(definition);
+
+  auto* snapshot_reader = snapshot_storage->open();
+  ASSERT_NE(nullptr, snapshot_reader);
+  std::vector<std::string> files;
+  snapshot_reader->list_files(&files);
+  ASSERT_EQ(4, files.size());
+
+  auto raft_snapshot = std::make_unique<dingodb::RaftSnapshot>(RaftSnapshotTest::engine);
+  EXPECT_TRUE(raft_snapshot->LoadSnapshotByScan(snapshot_reader, region, files));
+  snapshot_storage->close(snapshot_reader);
+
+  // every sst file is ingested to its column family
+  auto reader = RaftSnapshotTest::engine->Reader();
+  for (const auto& sub_range : sub_ranges) {
+    for (const auto& key : sub_range.keys) {
+      std::string value;
+      ASSERT_TRUE(reader->KvGet(sub_range.cf_name, key, value).ok()) << key;
+      EXPECT_EQ(sub_range.cf_name + "_value", value);
+    }
+  }
+
+  std::string value;
+  EXPECT_FALSE(reader->KvGet(dingodb::Constant::kStoreMetaCF, "scan_a1", value).ok());
+}
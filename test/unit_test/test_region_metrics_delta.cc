@@ -0,0 +1,192 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "fmt/core.h"
+#include "proto/common.pb.h"
+#include "store/heartbeat.h"
+
+namespace dingodb {
+
+static pb::common::StoreMetrics GenStoreMetrics(int64_t region_count, int64_t row_count) {
+  pb::common::StoreMetrics store_metrics;
+  store_metrics.set_id(1001);
+  for (int64_t region_id = 1; region_id <= region_count; ++region_id) {
+    pb::common::RegionMetrics region_metrics;
+    region_metrics.set_id(region_id);
+    region_metrics.set_leader_store_id(1001);
+    region_metrics.set_row_count(row_count);
+    region_metrics.mutable_region_definition()->set_id(region_id);
+    region_metrics.mutable_region_definition()->set_name(fmt::format("region_{}", region_id));
+    (*store_metrics.mutable_region_metrics_map())[region_id] = region_metrics;
+  }
+  return store_metrics;
+}
+
+TEST(RegionMetricsDeltaTrackerTest, FirstIsFull) {
+  RegionMetricsDeltaTracker tracker;
+
+  auto store_metrics = GenStoreMetrics(100, 10);
+  tracker.Prepare(false, {}, store_metrics);
+  EXPECT_FALSE(store_metrics.is_delta_region_metrics());
+  EXPECT_EQ(100, store_metrics.region_metrics_map_size());
+  EXPECT_GT(store_metrics.region_metrics_version(), 0);
+
+  // not acknowledged, still full
+  auto store_metrics2 = GenStoreMetrics(100, 10);
+  tracker.Prepare(false, {}, store_metrics2);
+  EXPECT_FALSE(store_metrics2.is_delta_region_metrics());
+  EXPECT_EQ(0, tracker.AckedVersion());
+}
+
+TEST(RegionMetricsDeltaTrackerTest, OnlyChanged) {
+  RegionMetricsDeltaTracker tracker;
+
+  auto store_metrics = GenStoreMetrics(100, 10);
+  tracker.Prepare(false, {}, store_metrics);
+  tracker.Acknowledge(store_metrics.region_metrics_version(), false);
+  EXPECT_EQ(store_metrics.region_metrics_version(), tracker.AckedVersion());
+
+  // nothing changed
+  auto unchanged = GenStoreMetrics(100, 10);
+  tracker.Prepare(false, {}, unchanged);
+  EXPECT_TRUE(unchanged.is_delta_region_metrics());
+  EXPECT_EQ(store_metrics.region_metrics_version(), unchanged.base_region_metrics_version());
+  EXPECT_EQ(0, unchanged.region_metrics_map_size());
+  EXPECT_EQ(0, unchanged.deleted_region_ids_size());
+  tracker.Acknowledge(unchanged.region_metrics_version(), false);
+
+  // change region 3 and 7, delete region 100, region 99 is skipped
+  auto changed = GenStoreMetrics(99, 10);
+  (*changed.mutable_region_metrics_map())[3].set_row_count(11);
+  (*changed.mutable_region_metrics_map())[7].mutable_region_definition()->mutable_epoch()->set_version(2);
+  changed.mutable_region_metrics_map()->erase(99);
+  tracker.Prepare(false, {99}, changed);
+  EXPECT_TRUE(changed.is_delta_region_metrics());
+  EXPECT_EQ(unchanged.region_metrics_version(), changed.base_region_metrics_version());
+  ASSERT_EQ(2, changed.region_metrics_map_size());
+  EXPECT_EQ(1, changed.region_metrics_map().count(3));
+  EXPECT_EQ(1, changed.region_metrics_map().count(7));
+  ASSERT_EQ(1, changed.deleted_region_ids_size());
+  EXPECT_EQ(100, changed.deleted_region_ids(0));
+}
+
+static void SetBraftStatus(pb::common::StoreMetrics& store_metrics, int64_t index, int64_t timestamp) {
+  for (auto& [region_id, region_metrics] : *store_metrics.mutable_region_metrics_map()) {
+    auto* braft_status = region_metrics.mutable_braft_status();
+    braft_status->set_raft_state(pb::common::RaftNodeState::STATE_LEADER);
+    braft_status->set_peer_id("127.0.0.1:20101:0");
+    braft_status->set_leader_peer_id("127.0.0.1:20101:0");
+    braft_status->set_term(3);
+    braft_status->set_committed_index(index);
+    braft_status->set_known_applied_index(index);
+    braft_status->set_last_index(index);
+    braft_status->set_disk_index(index);
+    for (const auto* peer_id : {"127.0.0.1:20102:0", "127.0.0.1:20103:0"}) {
+      auto& peer_status = (*braft_status->mutable_stable_followers())[peer_id];
+      peer_status.set_valid(true);
+      peer_status.set_next_index(index + 1);
+      peer_status.set_last_rpc_send_timestamp(timestamp);
+    }
+  }
+}
+
+TEST(RegionMetricsDeltaTrackerTest, IgnoreVolatileFields) {
+  RegionMetricsDeltaTracker tracker;
+
+  auto store_metrics = GenStoreMetrics(10, 1000);
+  SetBraftStatus(store_metrics, 100, 1700000000000);
+  tracker.Prepare(false, {}, store_metrics);
+  tracker.Acknowledge(store_metrics.region_metrics_version(), false);
+
+  // raft indexes and rpc timestamp move, row count changes in the same bucket
+  auto moved = GenStoreMetrics(10, 1010);
+  SetBraftStatus(moved, 200, 1700000001000);
+  tracker.Prepare(false, {}, moved);
+  EXPECT_TRUE(moved.is_delta_region_metrics());
+  EXPECT_EQ(0, moved.region_metrics_map_size());
+  tracker.Acknowledge(moved.region_metrics_version(), false);
+
+  // leader changed, a follower is removed, row count grows
+  auto changed = GenStoreMetrics(10, 1010);
+  SetBraftStatus(changed, 300, 1700000002000);
+  auto& region_metrics_2 = (*changed.mutable_region_metrics_map())[2];
+  region_metrics_2.mutable_braft_status()->set_raft_state(pb::common::RaftNodeState::STATE_FOLLOWER);
+  region_metrics_2.mutable_braft_status()->set_leader_peer_id("127.0.0.1:20102:0");
+  (*changed.mutable_region_metrics_map())[5].mutable_braft_status()->mutable_stable_followers()->erase(
+      "127.0.0.1:20103:0");
+  (*changed.mutable_region_metrics_map())[8].set_row_count(2000);
+  tracker.Prepare(false, {}, changed);
+  EXPECT_TRUE(changed.is_delta_region_metrics());
+  ASSERT_EQ(3, changed.region_metrics_map_size());
+  EXPECT_EQ(1, changed.region_metrics_map().count(2));
+  EXPECT_EQ(1, changed.region_metrics_map().count(5));
+  EXPECT_EQ(1, changed.region_metrics_map().count(8));
+  // the reported region metrics is complete
+  EXPECT_EQ(300, changed.region_metrics_map().at(2).braft_status().committed_index());
+}
+
+TEST(RegionMetricsDeltaTrackerTest, NotAcknowledged) {
+  RegionMetricsDeltaTracker tracker;
+
+  auto store_metrics = GenStoreMetrics(10, 10);
+  tracker.Prepare(false, {}, store_metrics);
+  tracker.Acknowledge(store_metrics.region_metrics_version(), false);
+
+  // the delta is lost, the next delta still based on the acknowledged version
+  auto lost = GenStoreMetrics(10, 20);
+  tracker.Prepare(false, {}, lost);
+  EXPECT_EQ(10, lost.region_metrics_map_size());
+
+  auto retry = GenStoreMetrics(10, 20);
+  tracker.Prepare(false, {}, retry);
+  EXPECT_TRUE(retry.is_delta_region_metrics());
+  EXPECT_EQ(store_metrics.region_metrics_version(), retry.base_region_metrics_version());
+  EXPECT_EQ(10, retry.region_metrics_map_size());
+
+  // the response of old version is ignored
+  tracker.Acknowledge(lost.region_metrics_version(), false);
+  EXPECT_EQ(store_metrics.region_metrics_version(), tracker.AckedVersion());
+}
+
+TEST(RegionMetricsDeltaTrackerTest, ForceFull) {
+  RegionMetricsDeltaTracker tracker;
+
+  auto store_metrics = GenStoreMetrics(10, 10);
+  tracker.Prepare(false, {}, store_metrics);
+  tracker.Acknowledge(store_metrics.region_metrics_version(), false);
+
+  auto resync = GenStoreMetrics(10, 10);
+  tracker.Prepare(true, {}, resync);
+  EXPECT_FALSE(resync.is_delta_region_metrics());
+  EXPECT_EQ(10, resync.region_metrics_map_size());
+  tracker.Acknowledge(resync.region_metrics_version(), false);
+
+  // coordinator reject the delta, e.g. coordinator leader changed
+  auto rejected = GenStoreMetrics(10, 10);
+  tracker.Prepare(false, {}, rejected);
+  EXPECT_TRUE(rejected.is_delta_region_metrics());
+  tracker.Acknowledge(0, true);
+
+  auto full = GenStoreMetrics(10, 10);
+  tracker.Prepare(false, {}, full);
+  EXPECT_FALSE(full.is_delta_region_metrics());
+  EXPECT_EQ(10, full.region_metrics_map_size());
+}
+
+}  // namespace dingodb
@@ -37,12 +37,15 @@
 #include "config/config.h"
 #include "config/yaml_config.h"
 #include "engine/raw_rocks_engine.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/store_internal.pb.h"
 #include "server/server.h"
 
 namespace dingodb {  // NOLINT
 
+DECLARE_int64(rocks_range_gc_delay_s);
+
 static const std::string kDefaultCf = "default";
 // static const std::string &kDefaultCf = "meta";
 
@@ -1616,6 +1619,113 @@ TEST_F(RawRocksEngineTest, Iterator) {
   EXPECT_GE(count, 1);
 }
 
+TEST_F(RawRocksEngineTest, RangeGc) {
+  FLAGS_rocks_range_gc_delay_s = 0;
+
+  auto writer = RawRocksEngineTest::engine->Writer();
+  auto reader = RawRocksEngineTest::engine->Reader();
+  auto range_gc = RawRocksEngineTest::engine->GetRangeGc();
+  ASSERT_NE(nullptr, range_gc);
+  int64_t finish_count = range_gc->FinishCount();
+  int64_t drop_files_count = range_gc->DropFilesCount();
+
+  // write GC_A0 -> GC_A99 and GC_B0 -> GC_B99 into sst
+  {
+    std::vector<pb::common::KeyValue> kvs;
+    for (int i = 0; i < 100; i++) {
+      pb::common::KeyValue kv;
+      kv.set_key("GC_A" + std::to_string(i));
+      kv.set_value(GenRandomString(256));
+      kvs.push_back(kv);
+      kv.set_key("GC_B" + std::to_string(i));
+      kvs.push_back(kv);
+    }
+
+    butil::Status ok = writer->KvBatchPutAndDelete(kDefaultCf, kvs, {});
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    RawRocksEngineTest::engine->Flush(kDefaultCf);
+  }
+
+  // destroyed region, the adjacent ranges are merged
+  {
+    pb::common::Range range;
+    range.set_start_key("GC_A");
+    range.set_end_key("GC_B");
+    EXPECT_TRUE(RawRocksEngineTest::engine->DeleteFilesInRange(kAllCFs, range).ok());
+    EXPECT_TRUE(writer->KvDeleteRange(kDefaultCf, range).ok());
+    RawRocksEngineTest::engine->GcRange(kAllCFs, range);
+
+    range.set_start_key("GC_B");
+    range.set_end_key("GC_C");
+    EXPECT_TRUE(RawRocksEngineTest::engine->DeleteFilesInRange(kAllCFs, range).ok());
+    EXPECT_TRUE(writer->KvDeleteRange(kDefaultCf, range).ok());
+    RawRocksEngineTest::engine->GcRange(kAllCFs, range);
+    EXPECT_EQ(1, range_gc->PendingCount());
+    EXPECT_EQ(drop_files_count + 2, range_gc->DropFilesCount());
+
+    RawRocksEngineTest::engine->RunRangeGc();
+    EXPECT_EQ(0, range_gc->PendingCount());
+    EXPECT_EQ(finish_count + 1, range_gc->FinishCount());
+
+    int64_t count = 0;
+    reader->KvCount(kDefaultCf, "GC_A", "GC_C", count);
+    EXPECT_EQ(0, count);
+  }
+
+  // the files of multi level partly overlap the range, no key comes back after the tombstone is flushed and gc
+  {
+    // lower level file GC_D0 -> GC_D99 and GC_F0, which is partly inside range [GC_D, GC_E)
+    std::vector<pb::common::KeyValue> kvs;
+    for (int i = 0; i < 100; i++) {
+      pb::common::KeyValue kv;
+      kv.set_key("GC_D" + std::to_string(i));
+      kv.set_value(GenRandomString(256));
+      kvs.push_back(kv);
+    }
+    pb::common::KeyValue outside_kv;
+    outside_kv.set_key("GC_F0");
+    outside_kv.set_value("VALUE");
+    kvs.push_back(outside_kv);
+    EXPECT_TRUE(writer->KvBatchPutAndDelete(kDefaultCf, kvs, {}).ok());
+    RawRocksEngineTest::engine->Flush(kDefaultCf);
+    EXPECT_TRUE(RawRocksEngineTest::engine->Compact(kDefaultCf).ok());
+
+    // level 0 file inside the range
+    kvs.clear();
+    for (int i = 0; i < 100; i += 2) {
+      pb::common::KeyValue kv;
+      kv.set_key("GC_D" + std::to_string(i));
+      kv.set_value(GenRandomString(256));
+      kvs.push_back(kv);
+    }
+    EXPECT_TRUE(writer->KvBatchPutAndDelete(kDefaultCf, kvs, {}).ok());
+    RawRocksEngineTest::engine->Flush(kDefaultCf);
+
+    pb::common::Range range;
+    range.set_start_key("GC_D");
+    range.set_end_key("GC_E");
+    EXPECT_TRUE(RawRocksEngineTest::engine->DeleteFilesInRange(kAllCFs, range).ok());
+    EXPECT_TRUE(writer->KvDeleteRange(kDefaultCf, range).ok());
+    // the file holding the tombstone is inside the range
+    RawRocksEngineTest::engine->Flush(kDefaultCf);
+    RawRocksEngineTest::engine->GcRange(kAllCFs, range);
+
+    int64_t count = 0;
+    reader->KvCount(kDefaultCf, "GC_D", "GC_E", count);
+    EXPECT_EQ(0, count);
+
+    RawRocksEngineTest::engine->RunRangeGc();
+    EXPECT_EQ(finish_count + 2, range_gc->FinishCount());
+
+    reader->KvCount(kDefaultCf, "GC_D", "GC_E", count);
+    EXPECT_EQ(0, count);
+    std::string value;
+    EXPECT_FALSE(reader->KvGet(kDefaultCf, "GC_D1", value).ok());
+    EXPECT_TRUE(reader->KvGet(kDefaultCf, "GC_F0", value).ok());
+    EXPECT_EQ("VALUE", value);
+  }
+}
+
 // TEST_F(RawRocksEngineTest, Checkpoint) {
 //   auto writer = RawRocksEngineTest::engine->Writer();
 
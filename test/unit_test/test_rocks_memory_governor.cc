@@ -0,0 +1,67 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "engine/rocks_memory_governor.h"
+#include "metrics/store_bvar_metrics.h"
+
+namespace dingodb {
+
+static const size_t kCapacity = 64 * 1024 * 1024;
+
+TEST(RocksMemoryGovernorTest, SharedBlockCache) {
+  auto memory_governor = rocks::MemoryGovernor::New(kCapacity, 0.25);
+  EXPECT_EQ(kCapacity, memory_governor->GetCapacity());
+
+  auto data_cache = memory_governor->GetBlockCache("governor_data");
+  auto meta_cache = memory_governor->GetBlockCache("governor_meta");
+  ASSERT_NE(nullptr, data_cache);
+  ASSERT_NE(nullptr, meta_cache);
+  EXPECT_EQ(data_cache, memory_governor->GetBlockCache("governor_data"));
+  EXPECT_NE(data_cache, meta_cache);
+
+  // column families share the capacity instead of owning one each
+  EXPECT_EQ(kCapacity, data_cache->GetCapacity());
+  EXPECT_EQ(kCapacity, meta_cache->GetCapacity());
+}
+
+TEST(RocksMemoryGovernorTest, WriteBufferManager) {
+  auto memory_governor = rocks::MemoryGovernor::New(kCapacity, 0.25);
+  auto write_buffer_manager = memory_governor->GetWriteBufferManager();
+  ASSERT_NE(nullptr, write_buffer_manager);
+  EXPECT_TRUE(write_buffer_manager->enabled());
+  EXPECT_TRUE(write_buffer_manager->cost_to_cache());
+  EXPECT_EQ(kCapacity / 4, write_buffer_manager->buffer_size());
+  EXPECT_EQ(0, memory_governor->GetMemTableUsage());
+}
+
+TEST(RocksMemoryGovernorTest, HitRateMetrics) {
+  auto memory_governor = rocks::MemoryGovernor::New(kCapacity, 0.25);
+  auto cache = memory_governor->GetBlockCache("governor_metrics");
+
+  auto* miss_counter = StoreBvarMetrics::GetInstance().GetBlockCacheMissCounter("governor_metrics");
+  ASSERT_NE(nullptr, miss_counter);
+  int64_t miss_count = miss_counter->get_value();
+
+  EXPECT_EQ(nullptr, cache->Lookup("not_exist_key"));
+  EXPECT_EQ(miss_count + 1, miss_counter->get_value());
+}
+
+}  // namespace dingodb
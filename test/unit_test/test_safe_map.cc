@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 #include <sys/types.h>
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
@@ -26,6 +27,7 @@
 #include "butil/string_printf.h"
 #include "common/helper.h"
 #include "common/safe_map.h"
+#include "proto/common.pb.h"
 
 class DingoSafeMapTest : public testing::Test {
  protected:
@@ -355,3 +357,178 @@ TEST(DingoSafeStdMapTest, DingoSafeStdMapMultiGet) {
   EXPECT_EQ(values.size(), 4);
   EXPECT_EQ(exists.size(), 4);
 }
+
+TEST(DingoSafeShardedMapTest, DingoSafeShardedMap) {
+  dingodb::DingoSafeShardedMap<int64_t, dingodb::pb::common::RegionMetrics> safe_map;
+  safe_map.Init(1000);
+
+  dingodb::pb::common::RegionMetrics region_metrics;
+  region_metrics.set_id(1);
+  region_metrics.set_leader_store_id(1001);
+  EXPECT_EQ(safe_map.Put(1, region_metrics), 1);
+
+  auto value_ptr = safe_map.GetPtr(1);
+  ASSERT_NE(value_ptr, nullptr);
+  EXPECT_EQ(value_ptr->leader_store_id(), 1001);
+  EXPECT_EQ(safe_map.GetPtr(2), nullptr);
+
+  // the value referenced by reader is not changed by put
+  region_metrics.set_leader_store_id(1002);
+  EXPECT_EQ(safe_map.PutIfExists(1, region_metrics), 1);
+  EXPECT_EQ(value_ptr->leader_store_id(), 1001);
+  EXPECT_EQ(safe_map.GetPtr(1)->leader_store_id(), 1002);
+
+  EXPECT_EQ(safe_map.PutIfExists(2, region_metrics), -1);
+  EXPECT_EQ(safe_map.PutIfAbsent(1, region_metrics), -1);
+
+  dingodb::pb::common::RegionMetrics value;
+  EXPECT_EQ(safe_map.Get(2, value), -1);
+  EXPECT_EQ(safe_map.Get(1, value), 1);
+  EXPECT_EQ(value.leader_store_id(), 1002);
+
+  std::vector<int64_t> key_list;
+  std::vector<dingodb::pb::common::RegionMetrics> value_list;
+  for (int64_t i = 2; i <= 1000; ++i) {
+    region_metrics.set_id(i);
+    key_list.push_back(i);
+    value_list.push_back(region_metrics);
+  }
+  EXPECT_EQ(safe_map.MultiPut(key_list, value_list), 1);
+  EXPECT_EQ(safe_map.Size(), 1000);
+
+  std::vector<int64_t> keys;
+  safe_map.GetAllKeys(keys);
+  EXPECT_EQ(keys.size(), 1000);
+
+  butil::FlatMap<int64_t, dingodb::pb::common::RegionMetrics> raw_map;
+  raw_map.init(1000);
+  safe_map.GetRawMapCopy(raw_map);
+  EXPECT_EQ(raw_map.size(), 1000);
+  EXPECT_EQ(raw_map.seek(500)->id(), 500);
+
+  EXPECT_EQ(safe_map.MultiErase(key_list), 1);
+  EXPECT_EQ(safe_map.Size(), 1);
+  EXPECT_EQ(safe_map.Erase(1), 1);
+  EXPECT_FALSE(safe_map.Exists(1));
+}
+
+TEST(DingoSafeShardedMapTest, MultiPutPublishOnce) {
+  dingodb::DingoSafeShardedMap<int64_t, int64_t> safe_map;
+
+  const int64_t key_count = 1000;
+  std::atomic<bool> stop = false;
+  std::atomic<int64_t> torn_count = 0;
+
+  // reader must see the whole batch or nothing
+  std::thread reader([&]() {
+    while (!stop.load()) {
+      auto first = safe_map.GetPtr(0);
+      auto last = safe_map.GetPtr(key_count - 1);
+      if (first != nullptr && last != nullptr && *last < *first) {
+        torn_count.fetch_add(1);
+      }
+    }
+  });
+
+  for (int64_t round = 0; round < 100; ++round) {
+    std::vector<int64_t> key_list;
+    std::vector<int64_t> value_list;
+    for (int64_t i = 0; i < key_count; ++i) {
+      key_list.push_back(i);
+      value_list.push_back(round);
+    }
+    safe_map.MultiPut(key_list, value_list);
+  }
+
+  stop.store(true);
+  reader.join();
+
+  EXPECT_EQ(torn_count.load(), 0);
+  EXPECT_EQ(*safe_map.GetPtr(0), 99);
+}
+
+TEST(DingoSafeShardedMapTest, GetRawMapCopy) {
+  dingodb::DingoSafeShardedMap<int64_t, int64_t> safe_map;
+  safe_map.MultiPut({1, 2, 3}, {10, 20, 30});
+
+  // uninitialized out_map
+  butil::FlatMap<int64_t, int64_t> raw_map;
+  EXPECT_EQ(safe_map.GetRawMapCopy(raw_map), 1);
+  EXPECT_EQ(raw_map.size(), 3);
+  EXPECT_EQ(*raw_map.seek(2), 20);
+
+  // old contents are replaced
+  safe_map.Erase(1);
+  raw_map.insert(100, 1000);
+  EXPECT_EQ(safe_map.GetRawMapCopy(raw_map), 1);
+  EXPECT_EQ(raw_map.size(), 2);
+  EXPECT_EQ(raw_map.seek(1), nullptr);
+  EXPECT_EQ(raw_map.seek(100), nullptr);
+}
+
+// Heartbeat storm: stores report region metrics concurrently, and schedulers read them at the same time.
+TEST(DingoSafeShardedMapTest, HeartbeatStorm) {
+  const int64_t region_count = 10000;
+  const int store_count = 10;
+  const int reader_count = 4;
+
+  dingodb::DingoSafeShardedMap<int64_t, dingodb::pb::common::RegionMetrics> safe_map;
+  safe_map.Init(region_count);
+
+  std::vector<int64_t> key_list;
+  std::vector<dingodb::pb::common::RegionMetrics> value_list;
+  for (int64_t i = 0; i < region_count; ++i) {
+    dingodb::pb::common::RegionMetrics region_metrics;
+    region_metrics.set_id(i);
+    region_metrics.set_leader_store_id(i % store_count);
+    region_metrics.mutable_region_definition()->set_name("region_" + std::to_string(i));
+    key_list.push_back(i);
+    value_list.push_back(region_metrics);
+  }
+  safe_map.MultiPut(key_list, value_list);
+
+  std::atomic<bool> stop = false;
+  std::atomic<int64_t> miss_count = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < reader_count; ++i) {
+    readers.emplace_back([&, i]() {
+      int64_t region_id = i;
+      while (!stop.load(std::memory_order_relaxed)) {
+        dingodb::pb::common::RegionMetrics region_metrics;
+        if (safe_map.Get(region_id, region_metrics) < 0 || region_metrics.id() != region_id) {
+          miss_count.fetch_add(1);
+        }
+        region_id = (region_id + 7919) % region_count;
+      }
+    });
+  }
+
+  // every store reports its regions with a new leader store id
+  std::vector<std::thread> stores;
+  for (int store_id = 0; store_id < store_count; ++store_id) {
+    stores.emplace_back([&, store_id]() {
+      std::vector<int64_t> heartbeat_keys;
+      std::vector<dingodb::pb::common::RegionMetrics> heartbeat_values;
+      for (int64_t i = store_id; i < region_count; i += store_count) {
+        heartbeat_keys.push_back(i);
+        heartbeat_values.push_back(value_list[i]);
+        heartbeat_values.back().set_leader_store_id(store_id + store_count);
+      }
+      safe_map.MultiPut(heartbeat_keys, heartbeat_values);
+    });
+  }
+  for (auto& store : stores) {
+    store.join();
+  }
+
+  stop.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(miss_count.load(), 0);
+  EXPECT_EQ(safe_map.Size(), region_count);
+  for (int64_t i = 0; i < region_count; ++i) {
+    EXPECT_EQ(safe_map.Get(i).leader_store_id(), i % store_count + store_count);
+  }
+}
@@ -14,6 +14,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <iostream>
@@ -21,10 +22,12 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "braft/log_entry.h"
 #include "common/logging.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "log/segment_log_storage.h"
 #include "proto/raft.pb.h"
 
@@ -130,4 +133,138 @@ TEST_F(SegmentLogStorageTest, GetEntrys) {
   DINGO_LOG(INFO) << fmt::format("log entrys count {}", log_entrys.size());
 
   EXPECT_EQ(end_index - begin_index + 1, log_entrys.size());
-}
\ No newline at end of file
+}
+namespace dingodb {
+DECLARE_string(raft_log_compression);
+}  // namespace dingodb
+
+// Entry data of repeated rows, it is compressible like the real write requests.
+braft::LogEntry* GenCompressibleLogEntry(int64_t log_index, int row_count) {
+  auto* log_entry = new braft::LogEntry();
+  log_entry->AddRef();
+
+  log_entry->type = braft::ENTRY_TYPE_DATA;
+  log_entry->id.term = 1;
+  log_entry->id.index = log_index;
+
+  for (int i = 0; i < row_count; ++i) {
+    log_entry->data.append(fmt::format("key_{:08}:value_{:08}_{}", log_index, i, std::string(64, 'v')));
+  }
+
+  return log_entry;
+}
+
+static void AppendAndCheckEntries(const std::string& compression, int entry_count, int row_count) {
+  const std::string log_path = fmt::format("{}/segment_log_{}", kRootPath, compression);
+  dingodb::Helper::CreateDirectories(log_path);
+
+  std::string old_compression = dingodb::FLAGS_raft_log_compression;
+  dingodb::FLAGS_raft_log_compression = compression;
+
+  {
+    auto log_storage = std::make_shared<dingodb::SegmentLogStorage>(log_path, 101, 8 * 1024 * 1024);
+    braft::ConfigurationManager configuration_manager;
+    ASSERT_EQ(0, log_storage->Init(&configuration_manager));
+
+    int64_t start_index = log_storage->LastLogIndex() + 1;
+    std::vector<std::string> datas;
+    int64_t start_time = dingodb::Helper::TimestampNs();
+    for (int i = 0; i < entry_count; ++i) {
+      auto* log_entry = GenCompressibleLogEntry(start_index + i, row_count);
+      datas.push_back(log_entry->data.to_string());
+      ASSERT_EQ(0, log_storage->AppendEntry(log_entry));
+      log_entry->Release();
+    }
+    int64_t elapsed_us = std::max((dingodb::Helper::TimestampNs() - start_time) / 1000, static_cast<int64_t>(1));
+
+    int64_t bytes = 0;
+    for (const auto& filename : dingodb::Helper::TraverseDirectory(log_path, true)) {
+      bytes += std::filesystem::file_size(fmt::format("{}/{}", log_path, filename));
+    }
+    DINGO_LOG(INFO) << fmt::format("compression: {} entry count: {} append throughput: {} entries/s bytes: {}",
+                                   compression, entry_count, entry_count * 1000000L / elapsed_us, bytes);
+
+    for (int i = 0; i < entry_count; ++i) {
+      auto* log_entry = log_storage->GetEntry(start_index + i);
+      ASSERT_NE(nullptr, log_entry);
+      EXPECT_EQ(braft::ENTRY_TYPE_DATA, log_entry->type);
+      EXPECT_EQ(datas[i], log_entry->data.to_string());
+      log_entry->Release();
+    }
+
+    // entries written with the other compression type are still readable
+    dingodb::FLAGS_raft_log_compression = "none";
+    auto* log_entry = log_storage->GetEntry(start_index);
+    ASSERT_NE(nullptr, log_entry);
+    EXPECT_EQ(datas[0], log_entry->data.to_string());
+    log_entry->Release();
+
+    log_storage->Reset(log_storage->LastLogIndex() + 1);
+    log_storage->GcInstance(log_path);
+  }
+
+  dingodb::FLAGS_raft_log_compression = old_compression;
+  dingodb::Helper::RemoveAllFileOrDirectory(log_path);
+}
+
+TEST_F(SegmentLogStorageTest, CompressNone) { AppendAndCheckEntries("none", 1000, 64); }
+
+TEST_F(SegmentLogStorageTest, CompressLz4) { AppendAndCheckEntries("lz4", 1000, 64); }
+
+TEST_F(SegmentLogStorageTest, CompressZstd) { AppendAndCheckEntries("zstd", 1000, 64); }
+
+TEST_F(SegmentLogStorageTest, CompressSmallEntry) {
+  // smaller than raft_log_compression_min_size, stored uncompressed
+  AppendAndCheckEntries("lz4", 100, 1);
+}
+
+TEST_F(SegmentLogStorageTest, LoadSegmentIndex) {
+  const std::string log_path = fmt::format("{}/segment_log_index", kRootPath);
+  dingodb::Helper::CreateDirectories(log_path);
+
+  // small segment size, make many closed segments
+  auto log_storage = std::make_shared<dingodb::SegmentLogStorage>(log_path, 102, 16 * 1024);
+  braft::ConfigurationManager configuration_manager;
+  ASSERT_EQ(0, log_storage->Init(&configuration_manager));
+
+  const int k_log_entry_count = 200;
+  int64_t start_index = log_storage->LastLogIndex() + 1;
+  std::vector<std::string> datas;
+  for (int i = 0; i < k_log_entry_count; ++i) {
+    auto* log_entry = GenCompressibleLogEntry(start_index + i, 16);
+    datas.push_back(log_entry->data.to_string());
+    ASSERT_EQ(0, log_storage->AppendEntry(log_entry));
+    log_entry->Release();
+  }
+
+  auto index_files = dingodb::Helper::TraverseDirectory(log_path, "log_index_", true);
+  ASSERT_FALSE(index_files.empty());
+
+  // log storage remove its directory when destructed, so keep reloaded log storages until the end
+  std::vector<std::shared_ptr<dingodb::SegmentLogStorage>> reload_log_storages;
+  auto check_reload = [&]() {
+    auto reload_log_storage = std::make_shared<dingodb::SegmentLogStorage>(log_path, 102, 16 * 1024);
+    reload_log_storages.push_back(reload_log_storage);
+    braft::ConfigurationManager reload_configuration_manager;
+    ASSERT_EQ(0, reload_log_storage->Init(&reload_configuration_manager));
+    EXPECT_EQ(log_storage->FirstLogIndex(), reload_log_storage->FirstLogIndex());
+    EXPECT_EQ(log_storage->LastLogIndex(), reload_log_storage->LastLogIndex());
+    for (int i = 0; i < k_log_entry_count; ++i) {
+      auto* log_entry = reload_log_storage->GetEntry(start_index + i);
+      ASSERT_NE(nullptr, log_entry);
+      EXPECT_EQ(datas[i], log_entry->data.to_string());
+      log_entry->Release();
+    }
+  };
+
+  // load closed segments from index files
+  check_reload();
+
+  // broken index file, load closed segment by scan
+  std::filesystem::resize_file(fmt::format("{}/{}", log_path, index_files[0]), 8);
+  check_reload();
+
+  log_storage->Reset(log_storage->LastLogIndex() + 1);
+  log_storage->GcInstance(log_path);
+  dingodb::Helper::RemoveAllFileOrDirectory(log_path);
+}
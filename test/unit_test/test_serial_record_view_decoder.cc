@@ -0,0 +1,288 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <serial/record_decoder.h>
+#include <serial/record_encoder.h>
+#include <serial/record_view_decoder.h>
+#include <serial/utils.h>
+
+#include <any>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "serial/schema/base_schema.h"
+
+namespace dingodb {
+
+template <typename T>
+static std::shared_ptr<DingoSchema<std::optional<T>>> NewSchema(int index, bool is_key, bool allow_null) {
+  auto schema = std::make_shared<DingoSchema<std::optional<T>>>();
+  schema->SetIndex(index);
+  schema->SetIsKey(is_key);
+  schema->SetAllowNull(allow_null);
+  return schema;
+}
+
+template <typename T>
+static void ExpectSameValue(const std::any& expect, const std::any& actual) {
+  EXPECT_EQ(std::any_cast<std::optional<T>>(expect), std::any_cast<std::optional<T>>(actual));
+}
+
+template <typename T>
+static void ExpectSamePointer(const std::any& expect, const std::any& actual) {
+  auto expect_value = std::any_cast<std::optional<std::shared_ptr<T>>>(expect);
+  auto actual_value = std::any_cast<std::optional<std::shared_ptr<T>>>(actual);
+  ASSERT_EQ(expect_value.has_value(), actual_value.has_value());
+  if (expect_value.has_value()) {
+    EXPECT_EQ(*expect_value.value(), *actual_value.value());
+  }
+}
+
+static void ExpectSameRecord(const std::vector<std::any>& expect, const std::vector<std::any>& actual) {
+  ASSERT_EQ(expect.size(), actual.size());
+  for (size_t i = 0; i < expect.size(); ++i) {
+    ASSERT_EQ(expect[i].type(), actual[i].type()) << "column: " << i;
+    const auto& type = expect[i].type();
+    if (type == typeid(std::optional<bool>)) {
+      ExpectSameValue<bool>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<int32_t>)) {
+      ExpectSameValue<int32_t>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<int64_t>)) {
+      ExpectSameValue<int64_t>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<float>)) {
+      ExpectSameValue<float>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<double>)) {
+      ExpectSameValue<double>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<std::shared_ptr<std::string>>)) {
+      ExpectSamePointer<std::string>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<std::shared_ptr<std::vector<float>>>)) {
+      ExpectSamePointer<std::vector<float>>(expect[i], actual[i]);
+    } else if (type == typeid(std::optional<std::shared_ptr<std::vector<std::string>>>)) {
+      ExpectSamePointer<std::vector<std::string>>(expect[i], actual[i]);
+    } else {
+      FAIL() << "unexpected type of column: " << i;
+    }
+  }
+}
+
+class RecordViewDecoderTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+    schemas->push_back(NewSchema<int32_t>(0, true, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::string>>(1, true, false));
+    schemas->push_back(NewSchema<int64_t>(2, true, true));
+    schemas->push_back(NewSchema<double>(3, true, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::string>>(4, true, true));
+    schemas->push_back(NewSchema<float>(5, true, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::string>>(6, false, true));
+    schemas->push_back(NewSchema<bool>(7, false, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::string>>(8, false, true));
+    schemas->push_back(NewSchema<int32_t>(9, false, true));
+    schemas->push_back(NewSchema<int32_t>(10, false, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::vector<float>>>(11, false, true));
+    schemas->push_back(NewSchema<int64_t>(12, false, false));
+    schemas->push_back(NewSchema<std::shared_ptr<std::vector<std::string>>>(13, false, true));
+    schemas->push_back(NewSchema<double>(14, false, true));
+    schemas->push_back(NewSchema<float>(15, false, false));
+
+    record.emplace_back(std::optional<int32_t>(-20));
+    record.emplace_back(std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>("key string 1234")));
+    record.emplace_back(std::optional<int64_t>());
+    record.emplace_back(std::optional<double>(-873485.4234));
+    record.emplace_back(std::optional<std::shared_ptr<std::string>>());
+    record.emplace_back(std::optional<float>(3.25));
+    record.emplace_back(std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>("test address")));
+    record.emplace_back(std::optional<bool>(true));
+    record.emplace_back(std::optional<std::shared_ptr<std::string>>());
+    record.emplace_back(std::optional<int32_t>());
+    record.emplace_back(std::optional<int32_t>(-123456));
+    record.emplace_back(std::optional<std::shared_ptr<std::vector<float>>>(
+        std::make_shared<std::vector<float>>(std::vector<float>{1.5, -2.5, 3.0})));
+    record.emplace_back(std::optional<int64_t>(214748364700L));
+    record.emplace_back(std::optional<std::shared_ptr<std::vector<std::string>>>(
+        std::make_shared<std::vector<std::string>>(std::vector<std::string>{"a", "", "bcd"})));
+    record.emplace_back(std::optional<double>(0.125));
+    record.emplace_back(std::optional<float>(-7.75));
+
+    RecordEncoder encoder(1, schemas, kCommonId);
+    ASSERT_EQ(0, encoder.Encode(record, kv));
+  }
+
+  void CheckProjection(const std::vector<int>& column_indexes) {
+    RecordDecoder decoder(1, schemas, kCommonId);
+    std::vector<std::any> expect;
+    ASSERT_EQ(0, decoder.Decode(kv, column_indexes, expect));
+
+    RecordViewDecoder view_decoder(1, schemas, kCommonId, column_indexes);
+    std::vector<std::any> actual;
+    ASSERT_EQ(0, view_decoder.Decode(kv, actual));
+    ExpectSameRecord(expect, actual);
+  }
+
+  static constexpr long kCommonId = 100;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> schemas;
+  std::vector<std::any> record;
+  pb::common::KeyValue kv;
+};
+
+TEST_F(RecordViewDecoderTest, SameAsRecordDecoder) {
+  std::vector<int> all_columns;
+  for (int i = 0; i < schemas->size(); ++i) {
+    all_columns.push_back(i);
+  }
+  CheckProjection(all_columns);
+
+  CheckProjection({0});
+  CheckProjection({15});
+  CheckProjection({1, 3, 5});
+  CheckProjection({7, 10, 12});
+  CheckProjection({11, 13, 14});
+  CheckProjection({4, 6, 8, 9});
+}
+
+TEST_F(RecordViewDecoderTest, ProjectionOrder) {
+  std::vector<int> column_indexes = {14, 1, 10, 10, 0};
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, column_indexes);
+  std::vector<std::any> actual;
+  ASSERT_EQ(0, view_decoder.Decode(kv, actual));
+  ASSERT_EQ(column_indexes.size(), actual.size());
+  for (int i = 0; i < column_indexes.size(); ++i) {
+    ExpectSameRecord({record[column_indexes[i]]}, {actual[i]});
+  }
+}
+
+TEST_F(RecordViewDecoderTest, ViewWithoutCopy) {
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, {6, 12, 1, 9});
+  std::vector<RecordViewDecoder::ColumnView> views;
+  ASSERT_EQ(0, view_decoder.Decode(kv.key(), kv.value(), views));
+  ASSERT_EQ(4, views.size());
+
+  EXPECT_FALSE(views[0].is_null);
+  EXPECT_EQ("test address", views[0].string_value);
+  // value string points into value
+  EXPECT_GE(views[0].string_value.data(), kv.value().data());
+  EXPECT_LE(views[0].string_value.data() + views[0].string_value.size(), kv.value().data() + kv.value().size());
+
+  EXPECT_FALSE(views[1].is_null);
+  EXPECT_EQ(214748364700L, views[1].long_value);
+
+  EXPECT_FALSE(views[2].is_null);
+  EXPECT_EQ("key string 1234", views[2].string_value);
+
+  EXPECT_TRUE(views[3].is_null);
+}
+
+TEST_F(RecordViewDecoderTest, BatchViewsAndReusedRecord) {
+  record[1] = std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>("another key"));
+  pb::common::KeyValue other_kv;
+  RecordEncoder encoder(1, schemas, kCommonId);
+  ASSERT_EQ(0, encoder.Encode(record, other_kv));
+
+  // key strings of each record are kept by caller, the views of the batch are valid at the same time
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, {1, 6});
+  std::vector<std::vector<RecordViewDecoder::ColumnView>> views(2);
+  std::vector<std::vector<std::string>> key_strings(2);
+  ASSERT_EQ(0, view_decoder.Decode(kv.key(), kv.value(), views[0], key_strings[0]));
+  ASSERT_EQ(0, view_decoder.Decode(other_kv.key(), other_kv.value(), views[1], key_strings[1]));
+  EXPECT_EQ("key string 1234", views[0][0].string_value);
+  EXPECT_EQ("another key", views[1][0].string_value);
+
+  // the unshared string is overwritten in place
+  std::any value;
+  view_decoder.AssignAny(views[0][1], 6, value);
+  const auto* str = std::any_cast<std::optional<std::shared_ptr<std::string>>>(&value)->value().get();
+  view_decoder.AssignAny(views[1][0], 1, value);
+  auto assigned = std::any_cast<std::optional<std::shared_ptr<std::string>>>(value);
+  EXPECT_EQ(str, assigned.value().get());
+  EXPECT_EQ("another key", *assigned.value());
+
+  // the shared string is not touched
+  view_decoder.AssignAny(views[0][0], 1, value);
+  EXPECT_EQ("another key", *assigned.value());
+  EXPECT_EQ("key string 1234", *std::any_cast<std::optional<std::shared_ptr<std::string>>>(value).value());
+
+  // null and fixed length columns are same as ToAny
+  RecordViewDecoder fixed_decoder(1, schemas, kCommonId, {2, 12});
+  std::vector<RecordViewDecoder::ColumnView> fixed_views;
+  ASSERT_EQ(0, fixed_decoder.Decode(kv.key(), kv.value(), fixed_views));
+  fixed_decoder.AssignAny(fixed_views[0], 2, value);
+  ExpectSameRecord({record[2]}, {value});
+  fixed_decoder.AssignAny(fixed_views[1], 12, value);
+  ExpectSameRecord({record[12]}, {value});
+}
+
+TEST_F(RecordViewDecoderTest, AddedColumn) {
+  // the record is written before column 16 is added
+  schemas->push_back(NewSchema<std::shared_ptr<std::string>>(16, false, true));
+  schemas->push_back(NewSchema<int32_t>(17, false, true));
+
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, {17, 16, 15});
+  std::vector<RecordViewDecoder::ColumnView> views;
+  ASSERT_EQ(0, view_decoder.Decode(kv.key(), kv.value(), views));
+  EXPECT_TRUE(views[0].is_null);
+  EXPECT_TRUE(views[1].is_null);
+  EXPECT_FALSE(views[2].is_null);
+  EXPECT_EQ(-7.75, views[2].float_value);
+}
+
+TEST_F(RecordViewDecoderTest, WrongRecord) {
+  std::vector<std::any> actual;
+
+  RecordViewDecoder other_table_decoder(1, schemas, kCommonId + 1, {0});
+  EXPECT_EQ(-1, other_table_decoder.Decode(kv, actual));
+
+  RecordViewDecoder old_schema_decoder(0, schemas, kCommonId, {0});
+  EXPECT_EQ(-1, old_schema_decoder.Decode(kv, actual));
+
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, {13});
+  std::string value = kv.value();
+  value.resize(value.size() - 20);
+  EXPECT_EQ(-1, view_decoder.Decode(kv.key(), value, actual));
+  EXPECT_EQ(-1, view_decoder.Decode(kv.key().substr(0, 8), kv.value(), actual));
+}
+
+TEST_F(RecordViewDecoderTest, Benchmark) {
+  const int count = 100000;
+  std::vector<int> column_indexes = {7, 10, 14};
+
+  RecordDecoder decoder(1, schemas, kCommonId);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) {
+    std::vector<std::any> decoded;
+    decoder.Decode(kv, column_indexes, decoded);
+  }
+  auto record_decoder_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  RecordViewDecoder view_decoder(1, schemas, kCommonId, column_indexes);
+  std::vector<RecordViewDecoder::ColumnView> views;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) {
+    view_decoder.Decode(kv.key(), kv.value(), views);
+  }
+  auto view_decoder_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "rows: " << count << " record_decoder: " << record_decoder_us
+            << " us view_decoder: " << view_decoder_us << " us" << '\n';
+}
+
+}  // namespace dingodb
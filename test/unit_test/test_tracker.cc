@@ -0,0 +1,91 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "common/tracker.h"
+#include "gflags/gflags.h"
+#include "proto/common.pb.h"
+
+namespace dingodb {
+
+DECLARE_int32(tracker_sample_interval);
+
+class TrackerTest : public testing::Test {
+ protected:
+  void SetUp() override { FLAGS_tracker_sample_interval = 100; }
+  void TearDown() override { FLAGS_tracker_sample_interval = 100; }
+};
+
+TEST_F(TrackerTest, Sample) {
+  FLAGS_tracker_sample_interval = 0;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(Tracker::New("KvPut", Tracker::NowNs()), nullptr);
+  }
+
+  FLAGS_tracker_sample_interval = 10;
+  int sample_count = 0;
+  for (int i = 0; i < 1000; ++i) {
+    if (Tracker::New("KvPut", Tracker::NowNs()) != nullptr) {
+      ++sample_count;
+    }
+  }
+  EXPECT_EQ(sample_count, 100);
+
+  FLAGS_tracker_sample_interval = 1;
+  EXPECT_NE(Tracker::New("KvPut", Tracker::NowNs()), nullptr);
+}
+
+TEST_F(TrackerTest, WithoutRaft) {
+  Tracker tracker("KvGet", Tracker::NowNs());
+  tracker.SetRunTime();
+  tracker.Finish();
+
+  pb::common::TimeInfo time_info;
+  tracker.FillTimeInfo(time_info);
+  EXPECT_GE(time_info.queue_wait_time_ns(), 0);
+  EXPECT_GE(time_info.prepare_time_ns(), 0);
+  EXPECT_EQ(time_info.raft_commit_time_ns(), 0);
+  EXPECT_EQ(time_info.raft_apply_time_ns(), 0);
+}
+
+TEST_F(TrackerTest, WithRaft) {
+  int64_t receive_time_ns = Tracker::NowNs() - 1000;
+  Tracker tracker("KvPut", receive_time_ns);
+  tracker.SetRunTime();
+  tracker.SetRaftProposeTime();
+  tracker.SetRaftCommitTime(Tracker::NowNs());
+  tracker.SetRaftApplyStartTime();
+  tracker.SetRaftApplyEndTime();
+  // apply start time is the first request of the proposal
+  tracker.SetRaftApplyStartTime();
+  tracker.SetRaftApplyEndTime();
+  tracker.Finish();
+
+  pb::common::TimeInfo time_info;
+  tracker.FillTimeInfo(time_info);
+  EXPECT_GE(time_info.queue_wait_time_ns(), 1000);
+  EXPECT_GE(time_info.prepare_time_ns(), 0);
+  EXPECT_GE(time_info.raft_commit_time_ns(), 0);
+  EXPECT_GE(time_info.raft_apply_wait_time_ns(), 0);
+  EXPECT_GE(time_info.raft_apply_time_ns(), 0);
+  EXPECT_LE(time_info.queue_wait_time_ns() + time_info.prepare_time_ns() + time_info.raft_commit_time_ns() +
+                time_info.raft_apply_wait_time_ns() + time_info.raft_apply_time_ns(),
+            Tracker::NowNs() - receive_time_ns);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,206 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "engine/txn_concurrency_manager.h"
+#include "proto/store.pb.h"
+
+namespace dingodb {
+
+static pb::store::LockInfo GenLockInfo(const std::string& key, int64_t lock_ts) {
+  pb::store::LockInfo lock_info;
+  lock_info.set_key(key);
+  lock_info.set_primary_lock(key);
+  lock_info.set_lock_ts(lock_ts);
+  return lock_info;
+}
+
+class TxnConcurrencyManagerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    timeout_ms_ = FLAGS_txn_memory_lock_wait_timeout_ms;
+    FLAGS_txn_memory_lock_wait_timeout_ms = 20;
+  }
+
+  void TearDown() override {
+    FLAGS_txn_memory_lock_wait_timeout_ms = timeout_ms_;
+    EXPECT_EQ(TxnConcurrencyManager::GetInstance().MemoryLockCount(), 0);
+  }
+
+ private:
+  int64_t timeout_ms_;
+};
+
+TEST_F(TxnConcurrencyManagerTest, MaxTs) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+
+  manager.UpdateMaxTs(100);
+  EXPECT_GE(manager.MaxTs(), 100);
+
+  int64_t max_ts = manager.MaxTs();
+  manager.UpdateMaxTs(max_ts - 1);
+  EXPECT_EQ(manager.MaxTs(), max_ts);
+
+  manager.UpdateMaxTs(max_ts + 1);
+  EXPECT_EQ(manager.MaxTs(), max_ts + 1);
+}
+
+TEST_F(TxnConcurrencyManagerTest, MaxTsSync) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+  const int64_t region_id = 1001;
+
+  // not leader
+  EXPECT_FALSE(manager.IsMaxTsSynced(region_id));
+  EXPECT_FALSE(manager.SyncMaxTs(region_id, 1, 1000));
+
+  manager.OnLeaderStart(region_id, 2);
+  EXPECT_FALSE(manager.IsMaxTsSynced(region_id));
+  EXPECT_TRUE(manager.IsMaxTsSyncing(region_id, 2));
+
+  // tso of the stale term is ignored
+  EXPECT_FALSE(manager.SyncMaxTs(region_id, 1, 1000));
+  EXPECT_FALSE(manager.IsMaxTsSynced(region_id));
+
+  EXPECT_TRUE(manager.SyncMaxTs(region_id, 2, 2000));
+  EXPECT_TRUE(manager.IsMaxTsSynced(region_id));
+  EXPECT_FALSE(manager.IsMaxTsSyncing(region_id, 2));
+  EXPECT_GE(manager.MaxTs(), 2000);
+
+  // leader transfer out and back, sync again
+  manager.OnLeaderStop(region_id);
+  EXPECT_FALSE(manager.IsMaxTsSynced(region_id));
+  manager.OnLeaderStart(region_id, 4);
+  EXPECT_FALSE(manager.IsMaxTsSynced(region_id));
+  EXPECT_FALSE(manager.IsMaxTsSyncing(region_id, 2));
+  EXPECT_TRUE(manager.SyncMaxTs(region_id, 4, 3000));
+  EXPECT_TRUE(manager.IsMaxTsSynced(region_id));
+
+  manager.OnLeaderStop(region_id);
+}
+
+TEST_F(TxnConcurrencyManagerTest, LockKeys) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+
+  std::vector<pb::store::LockInfo> lock_infos = {GenLockInfo("key_a", 10), GenLockInfo("key_c", 10)};
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+  // repeated prewrite of the same transaction
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  // other transaction can't lock the key
+  std::vector<pb::store::LockInfo> other_lock_infos = {GenLockInfo("key_b", 11), GenLockInfo("key_c", 11)};
+  EXPECT_FALSE(manager.LockKeys(other_lock_infos));
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  // unlock by other transaction is ignored
+  manager.UnlockKeys(other_lock_infos);
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  manager.UnlockKeys(lock_infos);
+  EXPECT_EQ(manager.MemoryLockCount(), 0);
+}
+
+TEST_F(TxnConcurrencyManagerTest, DeferUnlockKeys) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+  const int64_t region_id = 1002;
+
+  // not leader, unlock now
+  std::vector<pb::store::LockInfo> lock_infos = {GenLockInfo("key_a", 10), GenLockInfo("key_c", 10)};
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+  manager.DeferUnlockKeys(region_id, 10, lock_infos);
+  EXPECT_EQ(manager.MemoryLockCount(), 0);
+  EXPECT_FALSE(manager.HasDeferredLocks());
+
+  // kept until the transaction is applied
+  manager.OnLeaderStart(region_id, 3);
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+  manager.DeferUnlockKeys(region_id, 10, lock_infos);
+  EXPECT_TRUE(manager.HasDeferredLocks());
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  pb::store::LockInfo lock_info;
+  EXPECT_FALSE(manager.WaitKeysUnlocked({"key_a"}, 20, lock_info));
+  EXPECT_EQ(lock_info.lock_ts(), 10);
+
+  manager.OnTxnApplied(region_id, 11);
+  manager.OnTxnApplied(region_id + 1, 10);
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  manager.OnTxnApplied(region_id, 10);
+  EXPECT_EQ(manager.MemoryLockCount(), 0);
+  EXPECT_FALSE(manager.HasDeferredLocks());
+
+  // kept until the leader changes
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+  manager.DeferUnlockKeys(region_id, 10, lock_infos);
+  EXPECT_EQ(manager.MemoryLockCount(), 2);
+
+  manager.OnLeaderStop(region_id);
+  EXPECT_EQ(manager.MemoryLockCount(), 0);
+  EXPECT_FALSE(manager.HasDeferredLocks());
+}
+
+TEST_F(TxnConcurrencyManagerTest, WaitUnlockedTimeout) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+
+  std::vector<pb::store::LockInfo> lock_infos = {GenLockInfo("key_a", 10), GenLockInfo("key_c", 10)};
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+
+  pb::store::LockInfo lock_info;
+  // the read before the transaction is not blocked
+  EXPECT_TRUE(manager.WaitKeysUnlocked({"key_a", "key_c"}, 9, lock_info));
+  EXPECT_TRUE(manager.WaitRangeUnlocked("key_a", "key_d", 9, lock_info));
+
+  // the read of other keys is not blocked
+  EXPECT_TRUE(manager.WaitKeysUnlocked({"key_b"}, 20, lock_info));
+  EXPECT_TRUE(manager.WaitRangeUnlocked("key_d", "key_z", 20, lock_info));
+  EXPECT_TRUE(manager.WaitRangeUnlocked("key_b", "key_c", 20, lock_info));
+
+  EXPECT_FALSE(manager.WaitKeysUnlocked({"key_b", "key_c"}, 10, lock_info));
+  EXPECT_EQ(lock_info.key(), "key_c");
+  EXPECT_EQ(lock_info.lock_ts(), 10);
+
+  EXPECT_FALSE(manager.WaitRangeUnlocked("key_b", "key_d", 20, lock_info));
+  EXPECT_EQ(lock_info.key(), "key_c");
+
+  manager.UnlockKeys(lock_infos);
+}
+
+TEST_F(TxnConcurrencyManagerTest, WaitUnlocked) {
+  auto& manager = TxnConcurrencyManager::GetInstance();
+  FLAGS_txn_memory_lock_wait_timeout_ms = 10 * 1000;
+
+  std::vector<pb::store::LockInfo> lock_infos = {GenLockInfo("key_a", 10)};
+  EXPECT_TRUE(manager.LockKeys(lock_infos));
+
+  std::thread unlock_thread([&]() {
+    bthread_usleep(20 * 1000);
+    manager.UnlockKeys(lock_infos);
+  });
+
+  pb::store::LockInfo lock_info;
+  EXPECT_TRUE(manager.WaitRangeUnlocked("", "key_z", 20, lock_info));
+  EXPECT_EQ(manager.MemoryLockCount(), 0);
+
+  unlock_thread.join();
+}
+
+}  // namespace dingodb
@@ -0,0 +1,131 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/helper.h"
+#include "engine/txn_gc_compaction_filter.h"
+#include "proto/store.pb.h"
+
+class TxnGcCompactionFilterTest : public testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+static dingodb::pb::store::WriteInfo GenWriteInfo(dingodb::pb::store::Op op, int64_t start_ts,
+                                                  const std::string& short_value = "") {
+  dingodb::pb::store::WriteInfo write_info;
+  write_info.set_op(op);
+  write_info.set_start_ts(start_ts);
+  if (!short_value.empty()) {
+    write_info.set_short_value(short_value);
+  }
+  return write_info;
+}
+
+TEST_F(TxnGcCompactionFilterTest, SafePoint) {
+  auto& safe_point = dingodb::TxnGcSafePoint::GetInstance();
+
+  safe_point.Update(100);
+  EXPECT_EQ(100, safe_point.Get());
+
+  // safe point never moves backward
+  safe_point.Update(50);
+  EXPECT_EQ(100, safe_point.Get());
+
+  safe_point.Update(200);
+  EXPECT_EQ(200, safe_point.Get());
+
+  safe_point.SetGcStop(true);
+  EXPECT_EQ(0, safe_point.Get());
+
+  safe_point.SetGcStop(false);
+  EXPECT_EQ(200, safe_point.Get());
+}
+
+TEST_F(TxnGcCompactionFilterTest, KeepLatestPut) {
+  dingodb::TxnGcVersionChecker checker(100, false);
+
+  // records of one key are checked from the newest to the oldest
+  EXPECT_FALSE(checker.IsGarbage("key1", 120, GenWriteInfo(dingodb::pb::store::Op::Put, 110)));
+  EXPECT_FALSE(checker.IsGarbage("key1", 90, GenWriteInfo(dingodb::pb::store::Op::Put, 80)));
+  EXPECT_TRUE(checker.IsGarbage("key1", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 60)));
+  EXPECT_TRUE(checker.IsGarbage("key1", 50, GenWriteInfo(dingodb::pb::store::Op::Delete, 40)));
+
+  // the state is reset for a new key
+  EXPECT_FALSE(checker.IsGarbage("key2", 70, GenWriteInfo(dingodb::pb::store::Op::PutIfAbsent, 60)));
+  EXPECT_TRUE(checker.IsGarbage("key2", 50, GenWriteInfo(dingodb::pb::store::Op::Put, 40)));
+}
+
+TEST_F(TxnGcCompactionFilterTest, RollbackAndLock) {
+  dingodb::TxnGcVersionChecker checker(100, false);
+
+  EXPECT_FALSE(checker.IsGarbage("key1", 110, GenWriteInfo(dingodb::pb::store::Op::Rollback, 110)));
+  EXPECT_TRUE(checker.IsGarbage("key1", 95, GenWriteInfo(dingodb::pb::store::Op::Rollback, 95)));
+  EXPECT_TRUE(checker.IsGarbage("key1", 90, GenWriteInfo(dingodb::pb::store::Op::Lock, 85)));
+  EXPECT_FALSE(checker.IsGarbage("key1", 80, GenWriteInfo(dingodb::pb::store::Op::Put, 75)));
+  EXPECT_TRUE(checker.IsGarbage("key1", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 65)));
+}
+
+TEST_F(TxnGcCompactionFilterTest, LatestDelete) {
+  // compaction filter keeps the newest Delete
+  dingodb::TxnGcVersionChecker keep_checker(100, false);
+  EXPECT_FALSE(keep_checker.IsGarbage("key1", 90, GenWriteInfo(dingodb::pb::store::Op::Delete, 80)));
+  EXPECT_TRUE(keep_checker.IsGarbage("key1", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 60)));
+
+  // foreground gc sees all records of the key, it drops the newest Delete too
+  dingodb::TxnGcVersionChecker drop_checker(100, true);
+  EXPECT_TRUE(drop_checker.IsGarbage("key1", 90, GenWriteInfo(dingodb::pb::store::Op::Delete, 80)));
+  EXPECT_TRUE(drop_checker.IsGarbage("key1", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 60)));
+}
+
+TEST_F(TxnGcCompactionFilterTest, Filter) {
+  dingodb::rocks::TxnWriteCompactionFilter filter(100, nullptr, nullptr);
+
+  struct Record {
+    std::string key;
+    int64_t commit_ts;
+    dingodb::pb::store::WriteInfo write_info;
+    bool expect_filtered;
+  };
+
+  std::vector<Record> records = {
+      {"key1", 120, GenWriteInfo(dingodb::pb::store::Op::Put, 110), false},
+      {"key1", 90, GenWriteInfo(dingodb::pb::store::Op::Put, 80, "value"), false},
+      {"key1", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 60), true},
+      {"key1", 50, GenWriteInfo(dingodb::pb::store::Op::Put, 40, "value"), true},
+      {"key2", 90, GenWriteInfo(dingodb::pb::store::Op::Delete, 80), false},
+      {"key2", 70, GenWriteInfo(dingodb::pb::store::Op::Put, 60), true},
+  };
+
+  for (const auto& record : records) {
+    std::string key = dingodb::Helper::EncodeTxnKey(record.key, record.commit_ts);
+    std::string value = record.write_info.SerializeAsString();
+    std::string new_value;
+    bool value_changed = false;
+    EXPECT_EQ(record.expect_filtered, filter.Filter(0, key, value, &new_value, &value_changed));
+  }
+
+  EXPECT_EQ(3, filter.FilteredCount());
+
+  // the record which is not a txn key is kept
+  std::string new_value;
+  bool value_changed = false;
+  EXPECT_FALSE(filter.Filter(0, "k", "v", &new_value, &value_changed));
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "engine/txn_lock_wait_manager.h"
+
+namespace dingodb {
+
+static const int64_t kRegionId = 1001;
+static const int64_t kLongTimeoutMs = 60 * 1000;
+
+class TxnLockWaitManagerTest : public testing::Test {
+ protected:
+  void TearDown() override { EXPECT_EQ(TxnLockWaitManager::GetInstance().WaiterCount(), 0); }
+};
+
+TEST_F(TxnLockWaitManagerTest, WakeUpInOrder) {
+  auto& manager = TxnLockWaitManager::GetInstance();
+
+  std::mutex mutex;
+  std::vector<int64_t> wake_orders;
+  std::vector<int64_t> wait_chain;
+  for (int64_t start_ts = 11; start_ts <= 13; ++start_ts) {
+    auto result = manager.Wait(
+        kRegionId, "key_order", start_ts, 10, manager.GetReleaseSeq(kRegionId, "key_order"), kLongTimeoutMs,
+        [&, start_ts](bool is_timeout) {
+          EXPECT_FALSE(is_timeout);
+          std::lock_guard<std::mutex> guard(mutex);
+          wake_orders.push_back(start_ts);
+        },
+        wait_chain);
+    EXPECT_EQ(result, TxnLockWaitManager::WaitResult::kWaiting);
+  }
+  EXPECT_EQ(manager.WaiterCount(), 3);
+
+  // other key and region not wake up the waiters
+  manager.WakeUp(kRegionId, "key_other");
+  manager.WakeUp(kRegionId + 1, "key_order");
+  EXPECT_EQ(manager.WaiterCount(), 3);
+
+  // one waiter is woken for every lock release
+  for (int i = 0; i < 3; ++i) {
+    manager.WakeUp(kRegionId, "key_order");
+    EXPECT_EQ(manager.WaiterCount(), 2 - i);
+  }
+  EXPECT_EQ(wake_orders, std::vector<int64_t>({11, 12, 13}));
+}
+
+TEST_F(TxnLockWaitManagerTest, Timeout) {
+  auto& manager = TxnLockWaitManager::GetInstance();
+
+  std::atomic<int> timeout_count{0};
+  std::vector<int64_t> wait_chain;
+  auto result = manager.Wait(
+      kRegionId, "key_timeout", 21, 20, manager.GetReleaseSeq(kRegionId, "key_timeout"), 10,
+      [&](bool is_timeout) { timeout_count.fetch_add(is_timeout ? 1 : 100); }, wait_chain);
+  EXPECT_EQ(result, TxnLockWaitManager::WaitResult::kWaiting);
+
+  for (int i = 0; i < 200 && timeout_count.load() == 0; ++i) {
+    bthread_usleep(10 * 1000);
+  }
+  EXPECT_EQ(timeout_count.load(), 1);
+
+  // waiter is removed after timeout
+  manager.WakeUp(kRegionId, "key_timeout");
+  EXPECT_EQ(timeout_count.load(), 1);
+}
+
+TEST_F(TxnLockWaitManagerTest, Deadlock) {
+  auto& manager = TxnLockWaitManager::GetInstance();
+
+  std::atomic<int> wake_count{0};
+  auto wake_func = [&](bool is_timeout) {
+    EXPECT_FALSE(is_timeout);
+    wake_count.fetch_add(1);
+  };
+
+  // 31 -> 32 -> 33
+  std::vector<int64_t> wait_chain;
+  EXPECT_EQ(manager.Wait(kRegionId, "key_32", 31, 32, manager.GetReleaseSeq(kRegionId, "key_32"), kLongTimeoutMs,
+                         wake_func, wait_chain),
+            TxnLockWaitManager::WaitResult::kWaiting);
+  EXPECT_EQ(manager.Wait(kRegionId + 1, "key_33", 32, 33, manager.GetReleaseSeq(kRegionId + 1, "key_33"),
+                         kLongTimeoutMs, wake_func, wait_chain),
+            TxnLockWaitManager::WaitResult::kWaiting);
+
+  // 33 -> 31 makes cycle
+  EXPECT_EQ(manager.Wait(kRegionId, "key_31", 33, 31, manager.GetReleaseSeq(kRegionId, "key_31"), kLongTimeoutMs,
+                         wake_func, wait_chain),
+            TxnLockWaitManager::WaitResult::kDeadlock);
+  EXPECT_EQ(wait_chain, std::vector<int64_t>({33, 31, 32}));
+  EXPECT_EQ(manager.WaiterCount(), 2);
+
+  // 32 releases the lock, 31 -> 33 is not deadlock any more
+  manager.WakeUp(kRegionId, "key_32");
+  EXPECT_EQ(wake_count.load(), 1);
+  EXPECT_EQ(manager.Wait(kRegionId, "key_33", 31, 33, manager.GetReleaseSeq(kRegionId, "key_33"), kLongTimeoutMs,
+                         wake_func, wait_chain),
+            TxnLockWaitManager::WaitResult::kWaiting);
+
+  manager.WakeUp(kRegionId + 1, "key_33");
+  manager.WakeUp(kRegionId, "key_33");
+  EXPECT_EQ(wake_count.load(), 3);
+}
+
+TEST_F(TxnLockWaitManagerTest, ReleasedBeforeWait) {
+  auto& manager = TxnLockWaitManager::GetInstance();
+
+  // the lock is released between reading the lock and waiting
+  int64_t release_seq = manager.GetReleaseSeq(kRegionId, "key_released");
+  manager.WakeUp(kRegionId, "key_released");
+
+  std::atomic<int> wake_count{0};
+  std::vector<int64_t> wait_chain;
+  auto result = manager.Wait(
+      kRegionId, "key_released", 41, 40, release_seq, kLongTimeoutMs, [&](bool) { wake_count.fetch_add(1); },
+      wait_chain);
+  EXPECT_EQ(result, TxnLockWaitManager::WaitResult::kReleased);
+  EXPECT_EQ(manager.WaiterCount(), 0);
+  EXPECT_EQ(wake_count.load(), 0);
+
+  // the sequence not moved, wait for the next release
+  result = manager.Wait(
+      kRegionId, "key_released", 41, 40, manager.GetReleaseSeq(kRegionId, "key_released"), kLongTimeoutMs,
+      [&](bool) { wake_count.fetch_add(1); }, wait_chain);
+  EXPECT_EQ(result, TxnLockWaitManager::WaitResult::kWaiting);
+  manager.WakeUp(kRegionId, "key_released");
+  EXPECT_EQ(wake_count.load(), 1);
+}
+
+}  // namespace dingodb
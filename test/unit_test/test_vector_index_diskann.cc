@@ -0,0 +1,308 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "butil/status.h"
+#include "gflags/gflags.h"
+#include "proto/common.pb.h"
+#include "proto/error.pb.h"
+#include "proto/index.pb.h"
+#include "vector/vector_index_diskann.h"
+#include "vector/vector_index_factory.h"
+
+namespace dingodb {
+
+DECLARE_string(diskann_data_path);
+DECLARE_int64(diskann_pq_train_count);
+
+static const std::string kDiskAnnTestPath = "./unit_test_diskann";
+static const std::string kStaleVectorFile = kDiskAnnTestPath + "/1_0_0.vec";
+
+class VectorIndexDiskAnnTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    FLAGS_diskann_data_path = kDiskAnnTestPath;
+    // train pq in the middle of inserting
+    FLAGS_diskann_pq_train_count = 500;
+
+    // left by the last process
+    std::filesystem::create_directories(kDiskAnnTestPath);
+    std::ofstream(kStaleVectorFile) << "stale";
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> distrib(0.0, 1.0);
+    data_base.resize(dimension * data_base_size);
+    for (auto& value : data_base) {
+      value = distrib(rng);
+    }
+  }
+
+  static void TearDownTestSuite() {
+    vector_index_diskann.reset();
+    std::filesystem::remove_all(kDiskAnnTestPath);
+  }
+
+  static std::shared_ptr<VectorIndex> New(pb::common::MetricType metric_type) {
+    static const pb::common::Range kRange;
+    static pb::common::RegionEpoch kEpoch;  // NOLINT
+    kEpoch.set_conf_version(1);
+    kEpoch.set_version(10);
+
+    pb::common::VectorIndexParameter index_parameter;
+    index_parameter.set_vector_index_type(::dingodb::pb::common::VectorIndexType::VECTOR_INDEX_TYPE_DISKANN);
+    index_parameter.mutable_diskann_parameter()->set_dimension(dimension);
+    index_parameter.mutable_diskann_parameter()->set_metric_type(metric_type);
+    index_parameter.mutable_diskann_parameter()->set_num_neighbors(32);
+    index_parameter.mutable_diskann_parameter()->set_num_trees(1);
+    index_parameter.mutable_diskann_parameter()->set_num_threads(1);
+    return VectorIndexFactory::New(1, index_parameter, kEpoch, kRange);
+  }
+
+  static std::vector<pb::common::VectorWithId> MakeVectors(int64_t start, int64_t end) {
+    std::vector<pb::common::VectorWithId> vector_with_ids;
+    for (int64_t id = start; id < end; ++id) {
+      pb::common::VectorWithId vector_with_id;
+      vector_with_id.set_id(id);
+      vector_with_id.mutable_vector()->set_dimension(dimension);
+      vector_with_id.mutable_vector()->set_value_type(::dingodb::pb::common::ValueType::FLOAT);
+      for (int i = 0; i < dimension; ++i) {
+        vector_with_id.mutable_vector()->add_float_values(data_base[id * dimension + i]);
+      }
+      vector_with_ids.push_back(vector_with_id);
+    }
+    return vector_with_ids;
+  }
+
+  // search every vector, return how many find itself at top 1
+  static int64_t SelfHitCount(std::shared_ptr<VectorIndex> vector_index, int64_t start, int64_t end) {
+    int64_t hit_count = 0;
+    for (const auto& vector_with_id : MakeVectors(start, end)) {
+      std::vector<pb::index::VectorWithDistanceResult> results;
+      auto ok = vector_index->Search({vector_with_id}, 10, {}, false, {}, results);
+      EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+      if (results.size() == 1 && results[0].vector_with_distances_size() > 0 &&
+          results[0].vector_with_distances(0).vector_with_id().id() == vector_with_id.id()) {
+        ++hit_count;
+      }
+    }
+    return hit_count;
+  }
+
+  inline static std::shared_ptr<VectorIndex> vector_index_diskann;
+  inline static int dimension = 16;
+  inline static int64_t data_base_size = 2000;
+  inline static std::vector<float> data_base;
+};
+
+TEST_F(VectorIndexDiskAnnTest, Create) {
+  static const pb::common::Range kRange;
+  static pb::common::RegionEpoch kEpoch;  // NOLINT
+
+  // invalid param
+  {
+    pb::common::VectorIndexParameter index_parameter;
+    index_parameter.set_vector_index_type(::dingodb::pb::common::VectorIndexType::VECTOR_INDEX_TYPE_DISKANN);
+    EXPECT_EQ(VectorIndexFactory::New(1, index_parameter, kEpoch, kRange), nullptr);
+
+    index_parameter.mutable_diskann_parameter()->set_dimension(dimension);
+    index_parameter.mutable_diskann_parameter()->set_metric_type(::dingodb::pb::common::MetricType::METRIC_TYPE_L2);
+    EXPECT_EQ(VectorIndexFactory::New(1, index_parameter, kEpoch, kRange), nullptr);
+  }
+
+  // valid param
+  {
+    vector_index_diskann = New(::dingodb::pb::common::MetricType::METRIC_TYPE_L2);
+    ASSERT_NE(vector_index_diskann, nullptr);
+    EXPECT_TRUE(vector_index_diskann->SupportSave());
+    EXPECT_EQ(vector_index_diskann->GetDimension(), dimension);
+  }
+}
+
+TEST_F(VectorIndexDiskAnnTest, Add) {
+  ASSERT_NE(vector_index_diskann, nullptr);
+
+  for (int64_t start = 0; start < data_base_size; start += 100) {
+    auto ok = vector_index_diskann->Add(MakeVectors(start, start + 100));
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  }
+
+  int64_t count = 0;
+  vector_index_diskann->GetCount(count);
+  EXPECT_EQ(count, data_base_size);
+  EXPECT_TRUE(std::dynamic_pointer_cast<VectorIndexDiskAnn>(vector_index_diskann)->IsPqTrained());
+}
+
+TEST_F(VectorIndexDiskAnnTest, Search) {
+  ASSERT_NE(vector_index_diskann, nullptr);
+
+  EXPECT_GE(SelfHitCount(vector_index_diskann, 0, data_base_size), data_base_size * 95 / 100);
+
+  // search with filter
+  {
+    auto vector_with_ids = MakeVectors(10, 11);
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    auto filter = std::make_shared<VectorIndex::RangeFilterFunctor>(100, 200);
+    auto ok = vector_index_diskann->Search(vector_with_ids, 5, {filter}, false, {}, results);
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].vector_with_distances_size(), 5);
+    for (const auto& vector_with_distance : results[0].vector_with_distances()) {
+      EXPECT_GE(vector_with_distance.vector_with_id().id(), 100);
+      EXPECT_LT(vector_with_distance.vector_with_id().id(), 200);
+    }
+  }
+
+  // range search
+  {
+    auto vector_with_ids = MakeVectors(10, 11);
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    auto ok = vector_index_diskann->RangeSearch(vector_with_ids, 0.5, {}, false, {}, results);
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_GE(results[0].vector_with_distances_size(), 1);
+    for (const auto& vector_with_distance : results[0].vector_with_distances()) {
+      EXPECT_LT(vector_with_distance.distance(), 0.5);
+    }
+  }
+}
+
+TEST_F(VectorIndexDiskAnnTest, Delete) {
+  ASSERT_NE(vector_index_diskann, nullptr);
+
+  std::vector<int64_t> delete_ids;
+  for (int64_t id = 0; id < 100; ++id) {
+    delete_ids.push_back(id);
+  }
+  auto ok = vector_index_diskann->Delete(delete_ids);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  int64_t count = 0;
+  int64_t deleted_count = 0;
+  vector_index_diskann->GetCount(count);
+  vector_index_diskann->GetDeletedCount(deleted_count);
+  EXPECT_EQ(count, data_base_size - 100);
+  EXPECT_EQ(deleted_count, 100);
+  EXPECT_FALSE(vector_index_diskann->NeedToRebuild());
+
+  // deleted vectors are never returned
+  EXPECT_EQ(SelfHitCount(vector_index_diskann, 0, 100), 0);
+  EXPECT_GE(SelfHitCount(vector_index_diskann, 100, 200), 95);
+
+  // upsert brings them back
+  ok = vector_index_diskann->Upsert(MakeVectors(0, 100));
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  vector_index_diskann->GetCount(count);
+  EXPECT_EQ(count, data_base_size);
+  EXPECT_GE(SelfHitCount(vector_index_diskann, 0, 100), 95);
+}
+
+TEST_F(VectorIndexDiskAnnTest, SaveAndLoad) {
+  ASSERT_NE(vector_index_diskann, nullptr);
+
+  std::string path = kDiskAnnTestPath + "/snapshot";
+  auto ok = vector_index_diskann->Save(path);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  auto new_vector_index = New(::dingodb::pb::common::MetricType::METRIC_TYPE_L2);
+  ASSERT_NE(new_vector_index, nullptr);
+  ok = new_vector_index->Load(path);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  int64_t count = 0;
+  new_vector_index->GetCount(count);
+  EXPECT_EQ(count, data_base_size);
+  EXPECT_GE(SelfHitCount(new_vector_index, 0, data_base_size), data_base_size * 95 / 100);
+
+  // metric type mismatch
+  auto ip_vector_index = New(::dingodb::pb::common::MetricType::METRIC_TYPE_INNER_PRODUCT);
+  ASSERT_NE(ip_vector_index, nullptr);
+  ok = ip_vector_index->Load(path);
+  EXPECT_NE(ok.error_code(), pb::error::Errno::OK);
+}
+
+TEST_F(VectorIndexDiskAnnTest, Cosine) {
+  auto vector_index = New(::dingodb::pb::common::MetricType::METRIC_TYPE_COSINE);
+  ASSERT_NE(vector_index, nullptr);
+
+  auto ok = vector_index->Add(MakeVectors(0, 300));
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  auto vector_with_ids = MakeVectors(10, 11);
+  std::vector<pb::index::VectorWithDistanceResult> results;
+  ok = vector_index->Search(vector_with_ids, 10, {}, false, {}, results);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  ASSERT_EQ(results.size(), 1);
+  ASSERT_EQ(results[0].vector_with_distances_size(), 10);
+  EXPECT_EQ(results[0].vector_with_distances(0).vector_with_id().id(), 10);
+  EXPECT_NEAR(results[0].vector_with_distances(0).distance(), 0.0, 1e-5);
+}
+
+TEST_F(VectorIndexDiskAnnTest, CleanStaleVectorFile) {
+  auto vector_index = New(::dingodb::pb::common::MetricType::METRIC_TYPE_L2);
+  ASSERT_NE(vector_index, nullptr);
+  EXPECT_FALSE(std::filesystem::exists(kStaleVectorFile));
+}
+
+TEST_F(VectorIndexDiskAnnTest, ConcurrentSearchAndUpsert) {
+  auto vector_index = New(::dingodb::pb::common::MetricType::METRIC_TYPE_L2);
+  ASSERT_NE(vector_index, nullptr);
+  auto ok = vector_index->Add(MakeVectors(0, 1000));
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // searches run while the writer inserts and trains pq
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    for (int64_t start = 1000; start < data_base_size; start += 100) {
+      EXPECT_EQ(vector_index->Upsert(MakeVectors(start, start + 100)).error_code(), pb::error::Errno::OK);
+    }
+    stop = true;
+  });
+
+  std::vector<std::thread> readers;
+  std::atomic<int64_t> search_count{0};
+  std::atomic<int64_t> hit_count{0};
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&, i]() {
+      while (!stop) {
+        hit_count += SelfHitCount(vector_index, i * 100, i * 100 + 10);
+        search_count += 10;
+      }
+    });
+  }
+
+  writer.join();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_GE(hit_count, search_count * 95 / 100);
+  int64_t count = 0;
+  vector_index->GetCount(count);
+  EXPECT_EQ(count, data_base_size);
+  EXPECT_GE(SelfHitCount(vector_index, 1000, data_base_size), (data_base_size - 1000) * 95 / 100);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,283 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "butil/status.h"
+#include "gflags/gflags.h"
+#include "proto/common.pb.h"
+#include "proto/index.pb.h"
+#include "vector/vector_index_segment.h"
+
+namespace dingodb {
+
+DECLARE_int64(vector_segment_mutable_max_count);
+DECLARE_int32(vector_segment_max_num);
+
+class VectorIndexSegmentTest : public testing::Test {
+ protected:
+  static constexpr int kDimension = 16;
+
+  void SetUp() override {
+    FLAGS_vector_segment_mutable_max_count = 100;
+    FLAGS_vector_segment_max_num = 4;
+
+    pb::common::RegionEpoch epoch;
+    epoch.set_conf_version(1);
+    epoch.set_version(1);
+    pb::common::Range range;
+
+    pb::common::VectorIndexParameter index_parameter;
+    index_parameter.set_vector_index_type(pb::common::VECTOR_INDEX_TYPE_HNSW);
+    auto* hnsw_parameter = index_parameter.mutable_hnsw_parameter();
+    hnsw_parameter->set_dimension(kDimension);
+    hnsw_parameter->set_metric_type(pb::common::METRIC_TYPE_L2);
+    hnsw_parameter->set_efconstruction(200);
+    hnsw_parameter->set_max_elements(100000);
+    hnsw_parameter->set_nlinks(16);
+
+    segment_index = std::make_shared<VectorIndexSegment>(1, index_parameter, epoch, range);
+  }
+
+  static std::shared_ptr<VectorIndexSegment> NewSegmentIndex(const pb::common::VectorIndexParameter& parameter) {
+    return std::make_shared<VectorIndexSegment>(1, parameter, pb::common::RegionEpoch(), pb::common::Range());
+  }
+
+  void TearDown() override {
+    segment_index.reset();
+    FLAGS_vector_segment_mutable_max_count = 10000;
+    FLAGS_vector_segment_max_num = 8;
+  }
+
+  static pb::common::VectorWithId GenVector(int64_t id, float base) {
+    pb::common::VectorWithId vector_with_id;
+    vector_with_id.set_id(id);
+    vector_with_id.mutable_vector()->set_dimension(kDimension);
+    vector_with_id.mutable_vector()->set_value_type(pb::common::ValueType::FLOAT);
+    for (int i = 0; i < kDimension; ++i) {
+      vector_with_id.mutable_vector()->add_float_values(base + i * 0.001);
+    }
+    return vector_with_id;
+  }
+
+  std::vector<int64_t> SearchIds(float base, uint32_t topk) {
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    pb::common::VectorSearchParameter parameter;
+    auto status = segment_index->Search({GenVector(0, base)}, topk, {}, false, parameter, results);
+    EXPECT_TRUE(status.ok());
+
+    std::vector<int64_t> ids;
+    if (!results.empty()) {
+      for (const auto& vector_with_distance : results[0].vector_with_distances()) {
+        ids.push_back(vector_with_distance.vector_with_id().id());
+      }
+    }
+    return ids;
+  }
+
+  void AddRange(int64_t start_id, int64_t end_id) {
+    std::vector<pb::common::VectorWithId> vector_with_ids;
+    for (int64_t id = start_id; id < end_id; ++id) {
+      vector_with_ids.push_back(GenVector(id, static_cast<float>(id)));
+    }
+    ASSERT_TRUE(segment_index->Add(vector_with_ids).ok());
+  }
+
+  std::shared_ptr<VectorIndexSegment> segment_index;
+};
+
+TEST_F(VectorIndexSegmentTest, AddAndSearch) {
+  AddRange(1, 51);
+
+  int64_t count = 0;
+  EXPECT_TRUE(segment_index->GetCount(count).ok());
+  EXPECT_EQ(50, count);
+
+  auto ids = SearchIds(10.0, 3);
+  ASSERT_EQ(3, ids.size());
+  EXPECT_EQ(10, ids[0]);
+}
+
+TEST_F(VectorIndexSegmentTest, SealAndMerge) {
+  // Every 100 vectors seal one segment.
+  for (int64_t i = 0; i < 6; ++i) {
+    AddRange(i * 100 + 1, (i + 1) * 100 + 1);
+  }
+
+  // Wait background merge.
+  for (int i = 0; i < 100 && segment_index->SegmentCount() > FLAGS_vector_segment_max_num + 1; ++i) {
+    bthread_usleep(100 * 1000);
+  }
+  segment_index->Merge();
+  EXPECT_LE(segment_index->SegmentCount(), FLAGS_vector_segment_max_num + 1);
+
+  int64_t count = 0;
+  EXPECT_TRUE(segment_index->GetCount(count).ok());
+  EXPECT_EQ(600, count);
+
+  auto ids = SearchIds(250.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(250, ids[0]);
+}
+
+TEST_F(VectorIndexSegmentTest, DeleteAndUpsertTombstone) {
+  AddRange(1, 101);
+  ASSERT_TRUE(segment_index->Seal().ok());
+
+  // Delete from sealed segment, exceed tombstone ratio.
+  std::vector<int64_t> delete_ids;
+  for (int64_t id = 1; id <= 40; ++id) {
+    delete_ids.push_back(id);
+  }
+  ASSERT_TRUE(segment_index->Delete(delete_ids).ok());
+  auto ids = SearchIds(20.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(41, ids[0]);
+
+  // Merge drop tombstones, finish the merge launched by delete.
+  segment_index->Merge();
+  int64_t deleted_count = 0;
+  EXPECT_TRUE(segment_index->GetDeletedCount(deleted_count).ok());
+  EXPECT_EQ(0, deleted_count);
+
+  // Upsert move vector to mutable segment, old version become tombstone.
+  ASSERT_TRUE(segment_index->Upsert({GenVector(60, 1000.0)}).ok());
+  ids = SearchIds(1000.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(60, ids[0]);
+
+  ids = SearchIds(60.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_NE(60, ids[0]);
+
+  int64_t count = 0;
+  EXPECT_TRUE(segment_index->GetCount(count).ok());
+  EXPECT_EQ(60, count);
+
+  // Tombstone below ratio is kept by merge.
+  segment_index->Merge();
+  EXPECT_TRUE(segment_index->GetDeletedCount(deleted_count).ok());
+  EXPECT_EQ(1, deleted_count);
+
+  EXPECT_TRUE(segment_index->GetCount(count).ok());
+  EXPECT_EQ(60, count);
+
+  ids = SearchIds(60.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_NE(60, ids[0]);
+}
+
+TEST_F(VectorIndexSegmentTest, BuildFailedNotMergeAgain) {
+  // Untrained ivf flat can't add vectors, every segment build falls back to flat.
+  pb::common::VectorIndexParameter index_parameter;
+  index_parameter.set_vector_index_type(pb::common::VECTOR_INDEX_TYPE_IVF_FLAT);
+  auto* ivf_flat_parameter = index_parameter.mutable_ivf_flat_parameter();
+  ivf_flat_parameter->set_dimension(kDimension);
+  ivf_flat_parameter->set_metric_type(pb::common::METRIC_TYPE_L2);
+  ivf_flat_parameter->set_ncentroids(4);
+  segment_index = NewSegmentIndex(index_parameter);
+
+  AddRange(1, 101);
+  ASSERT_TRUE(segment_index->Seal().ok());
+
+  // The sealed flat segment is merged once, the fallback segment is not merged again.
+  for (int i = 0; i < 100 && segment_index->Merge() > 0; ++i) {
+  }
+  EXPECT_EQ(0, segment_index->Merge());
+  EXPECT_EQ(2, segment_index->SegmentCount());
+
+  // The background merge holds the index until it exits.
+  for (int i = 0; i < 100 && segment_index.use_count() > 1; ++i) {
+    bthread_usleep(10 * 1000);
+  }
+  EXPECT_EQ(1, segment_index.use_count());
+
+  auto ids = SearchIds(50.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(50, ids[0]);
+}
+
+TEST_F(VectorIndexSegmentTest, SaveAndLoad) {
+  const std::string kSnapshotPath = "./unit_test_vector_index_segment";
+  std::filesystem::remove_all(kSnapshotPath);
+  std::filesystem::create_directories(kSnapshotPath);
+
+  EXPECT_FALSE(segment_index->NeedToSave(100000));
+
+  // One merged segment, one flat sealed segment and mutable segment.
+  AddRange(1, 251);
+  ASSERT_TRUE(segment_index->Seal().ok());
+  segment_index->Merge();
+  AddRange(251, 351);
+  AddRange(351, 381);
+  ASSERT_TRUE(segment_index->Delete({10, 20, 260}).ok());
+  ASSERT_TRUE(segment_index->Upsert({GenVector(30, 1000.0)}).ok());
+
+  EXPECT_TRUE(segment_index->SupportSave());
+  EXPECT_TRUE(segment_index->NeedToSave(100000));
+  EXPECT_FALSE(segment_index->NeedToSave(1));
+
+  std::string index_path = kSnapshotPath + "/index_1_100.idx";
+  segment_index->LockWrite();
+  auto status = segment_index->Save(index_path);
+  segment_index->UnlockWrite();
+  ASSERT_TRUE(status.ok()) << status.error_str();
+
+  auto load_index = NewSegmentIndex(segment_index->VectorIndexParameter());
+  status = load_index->Load(index_path);
+  ASSERT_TRUE(status.ok()) << status.error_str();
+
+  int64_t count = 0, load_count = 0;
+  EXPECT_TRUE(segment_index->GetCount(count).ok());
+  EXPECT_TRUE(load_index->GetCount(load_count).ok());
+  EXPECT_EQ(377, load_count);
+  EXPECT_EQ(count, load_count);
+
+  segment_index = load_index;
+  auto ids = SearchIds(100.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(100, ids[0]);
+
+  ids = SearchIds(1000.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(30, ids[0]);
+
+  ids = SearchIds(280.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(280, ids[0]);
+
+  ids = SearchIds(370.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_EQ(370, ids[0]);
+
+  // Deleted vector is not found after load.
+  ids = SearchIds(20.0, 1);
+  ASSERT_EQ(1, ids.size());
+  EXPECT_NE(20, ids[0]);
+
+  // Corrupted file fail to load.
+  auto invalid_index = NewSegmentIndex(segment_index->VectorIndexParameter());
+  EXPECT_FALSE(invalid_index->Load(kSnapshotPath + "/not_exist.idx").ok());
+
+  std::filesystem::remove_all(kSnapshotPath);
+}
+
+}  // namespace dingodb
@@ -4107,4 +4107,86 @@ TEST_F(VectorIndexUtilsTest, NormalizeVectorForHnsw) {
   }
 }
 
+static void AddVectorWithDistance(pb::index::VectorWithDistanceResult& result, int64_t id, float distance) {
+  auto* vector_with_distance = result.add_vector_with_distances();
+  vector_with_distance->mutable_vector_with_id()->set_id(id);
+  vector_with_distance->set_distance(distance);
+}
+
+static std::vector<int64_t> GetVectorIds(const pb::index::VectorWithDistanceResult& result) {
+  std::vector<int64_t> ids;
+  for (const auto& vector_with_distance : result.vector_with_distances()) {
+    ids.push_back(vector_with_distance.vector_with_id().id());
+  }
+  return ids;
+}
+
+TEST_F(VectorIndexUtilsTest, MergeSearchResult) {
+  // merge two query of three regions, keep global topk
+  {
+    std::vector<std::vector<pb::index::VectorWithDistanceResult>> region_results(3);
+    for (auto& region_result : region_results) {
+      region_result.resize(2);
+    }
+
+    AddVectorWithDistance(region_results[0][0], 1, 0.1F);
+    AddVectorWithDistance(region_results[0][0], 2, 0.5F);
+    AddVectorWithDistance(region_results[0][0], 3, 0.9F);
+    AddVectorWithDistance(region_results[1][0], 11, 0.2F);
+    AddVectorWithDistance(region_results[1][0], 12, 0.3F);
+    AddVectorWithDistance(region_results[2][0], 21, 0.05F);
+
+    AddVectorWithDistance(region_results[0][1], 4, 1.0F);
+    AddVectorWithDistance(region_results[2][1], 22, 0.4F);
+
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    VectorIndexUtils::MergeSearchResult(region_results, 2, 3, results);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(std::vector<int64_t>({21, 1, 11}), GetVectorIds(results[0]));
+    EXPECT_EQ(std::vector<int64_t>({22, 4}), GetVectorIds(results[1]));
+    EXPECT_FLOAT_EQ(0.05F, results[0].vector_with_distances(0).distance());
+  }
+
+  // same distance sort by vector id, topk bigger than total
+  {
+    std::vector<std::vector<pb::index::VectorWithDistanceResult>> region_results(2);
+    region_results[0].resize(1);
+    region_results[1].resize(1);
+    AddVectorWithDistance(region_results[0][0], 8, 0.5F);
+    AddVectorWithDistance(region_results[1][0], 3, 0.5F);
+    AddVectorWithDistance(region_results[1][0], 5, 0.1F);
+
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    VectorIndexUtils::MergeSearchResult(region_results, 1, 10, results);
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(std::vector<int64_t>({5, 3, 8}), GetVectorIds(results[0]));
+  }
+
+  // region result missing some query, topk zero and empty regions
+  {
+    std::vector<std::vector<pb::index::VectorWithDistanceResult>> region_results(2);
+    region_results[0].resize(1);
+    region_results[1].resize(2);
+    AddVectorWithDistance(region_results[0][0], 1, 0.1F);
+    AddVectorWithDistance(region_results[1][1], 2, 0.2F);
+
+    std::vector<pb::index::VectorWithDistanceResult> results;
+    VectorIndexUtils::MergeSearchResult(region_results, 2, 2, results);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(std::vector<int64_t>({1}), GetVectorIds(results[0]));
+    EXPECT_EQ(std::vector<int64_t>({2}), GetVectorIds(results[1]));
+
+    results.clear();
+    VectorIndexUtils::MergeSearchResult(region_results, 2, 0, results);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(0, results[0].vector_with_distances_size());
+
+    std::vector<std::vector<pb::index::VectorWithDistanceResult>> empty_results;
+    results.clear();
+    VectorIndexUtils::MergeSearchResult(empty_results, 3, 5, results);
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ(0, results[2].vector_with_distances_size());
+  }
+}
+
 }  // namespace dingodb
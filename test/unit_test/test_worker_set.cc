@@ -0,0 +1,151 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "common/runnable.h"
+
+namespace dingodb {
+
+class TestTask : public TaskRunnable {
+ public:
+  using Handler = std::function<void(void)>;
+  TestTask(Handler handle) : handle_(handle) {}
+  ~TestTask() override = default;
+
+  std::string Type() override { return "TEST_TASK"; }
+
+  void Run() override { handle_(); }
+
+ private:
+  Handler handle_;
+};
+
+class WorkerSetTest : public testing::Test {
+ protected:
+  static void WaitFinish(WorkerSetPtr worker_set) {
+    for (int i = 0; i < 1000 && worker_set->PendingTaskCount() > 0; ++i) {
+      bthread_usleep(10 * 1000);
+    }
+    EXPECT_EQ(worker_set->PendingTaskCount(), 0);
+  }
+};
+
+TEST_F(WorkerSetTest, ExecuteRR) {
+  for (bool use_work_stealing : {false, true}) {
+    auto worker_set = WorkerSet::New("UnitTestWorkerSet", 4, 0, use_work_stealing);
+    ASSERT_TRUE(worker_set->Init());
+    EXPECT_EQ(worker_set->UseWorkStealing(), use_work_stealing);
+
+    std::atomic<int> run_count{0};
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_TRUE(worker_set->ExecuteRR(std::make_shared<TestTask>([&]() { run_count.fetch_add(1); })));
+    }
+
+    WaitFinish(worker_set);
+    EXPECT_EQ(run_count.load(), 1000);
+    EXPECT_EQ(worker_set->TotalTaskCount(), 1000);
+    worker_set->Destroy();
+  }
+}
+
+TEST_F(WorkerSetTest, SlowTaskNotBlock) {
+  auto worker_set = WorkerSet::New("UnitTestWorkerSet", 4, 0, true);
+  ASSERT_TRUE(worker_set->Init());
+
+  // slow task is on worker 0, the tasks round-robin to worker 0 are stolen by the other workers
+  std::atomic<bool> slow_task_finish{false};
+  std::atomic<int> run_count{0};
+  EXPECT_TRUE(worker_set->ExecuteRR(std::make_shared<TestTask>([&]() {
+    while (run_count.load() < 100) {
+      bthread_usleep(1000);
+    }
+    slow_task_finish.store(true);
+  })));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(worker_set->ExecuteRR(std::make_shared<TestTask>([&]() { run_count.fetch_add(1); })));
+  }
+
+  WaitFinish(worker_set);
+  EXPECT_TRUE(slow_task_finish.load());
+  EXPECT_EQ(run_count.load(), 100);
+  worker_set->Destroy();
+}
+
+TEST_F(WorkerSetTest, ExecuteHashByRegionIdInOrder) {
+  auto worker_set = WorkerSet::New("UnitTestWorkerSet", 4, 0, true);
+  ASSERT_TRUE(worker_set->Init());
+
+  const int kRegionNum = 8;
+  const int kTaskNum = 200;
+  std::mutex mutex;
+  std::vector<std::vector<int>> run_orders(kRegionNum);
+  std::vector<std::atomic<int>> running(kRegionNum);
+  std::atomic<int> concurrent_error{0};
+  for (int i = 0; i < kTaskNum; ++i) {
+    for (int region_id = 0; region_id < kRegionNum; ++region_id) {
+      EXPECT_TRUE(worker_set->ExecuteHashByRegionId(region_id, std::make_shared<TestTask>([&, i, region_id]() {
+        if (running[region_id].fetch_add(1) != 0) {
+          concurrent_error.fetch_add(1);
+        }
+        {
+          std::lock_guard<std::mutex> guard(mutex);
+          run_orders[region_id].push_back(i);
+        }
+        running[region_id].fetch_sub(1);
+      })));
+    }
+  }
+
+  WaitFinish(worker_set);
+  EXPECT_EQ(concurrent_error.load(), 0);
+  for (const auto& run_order : run_orders) {
+    ASSERT_EQ(run_order.size(), kTaskNum);
+    for (int i = 0; i < kTaskNum; ++i) {
+      EXPECT_EQ(run_order[i], i);
+    }
+  }
+  worker_set->Destroy();
+}
+
+TEST_F(WorkerSetTest, MaxPendingTaskCount) {
+  auto worker_set = WorkerSet::New("UnitTestWorkerSet", 1, 1, true);
+  ASSERT_TRUE(worker_set->Init());
+
+  std::atomic<bool> release{false};
+  auto block_task = std::make_shared<TestTask>([&]() {
+    while (!release.load()) {
+      bthread_usleep(1000);
+    }
+  });
+  EXPECT_TRUE(worker_set->ExecuteRR(block_task));
+  EXPECT_TRUE(worker_set->ExecuteRR(block_task));
+  EXPECT_FALSE(worker_set->ExecuteRR(block_task));
+  EXPECT_FALSE(worker_set->ExecuteHashByRegionId(1, block_task));
+
+  release.store(true);
+  WaitFinish(worker_set);
+  worker_set->Destroy();
+}
+
+}  // namespace dingodb